@@ -15,8 +15,12 @@
 #include "SampleUtils.h"
 
 #include "common/Platform.h"
+#include "common/Trace.h"
+#include "profiling/ProfilingProcs.h"
 #include "utils/BackendBinding.h"
+#include "wire/RingCommandBuffer.h"
 #include "wire/TerribleCommandBuffer.h"
+#include "wire/WireTrace.h"
 
 #include <nxt/nxt.h>
 #include <nxt/nxtcpp.h>
@@ -37,6 +41,7 @@ void PrintGLFWError(int code, const char* message) {
 enum class CmdBufType {
     None,
     Terrible,
+    Threaded,
     //TODO(cwallez@chromium.org) double terrible cmdbuf
 };
 
@@ -63,6 +68,31 @@ static nxt::wire::CommandHandler* wireServer = nullptr;
 static nxt::wire::CommandHandler* wireClient = nullptr;
 static nxt::wire::TerribleCommandBuffer* c2sBuf = nullptr;
 static nxt::wire::TerribleCommandBuffer* s2cBuf = nullptr;
+static nxt::wire::ThreadedServer* threadedServer = nullptr;
+
+// The serializer used by the wire client, a TracingCommandSerializer when --trace-wire is used.
+static nxt::wire::CommandSerializer* clientSerializer = nullptr;
+static const char* wireTracePath = nullptr;
+
+// With --profile-procs the procs are wrapped in the profiling layer and its data is printed when
+// the sample quits.
+static bool profileProcs = false;
+
+// With --trace-events tracing is enabled for the whole run and the events are written on quit.
+static const char* traceEventsPath = nullptr;
+
+static nxt::wire::CommandSerializer* MaybeTraceClientSerializer(
+    nxt::wire::CommandSerializer* serializer) {
+    if (wireTracePath == nullptr) {
+        return serializer;
+    }
+
+    auto* tracingSerializer = new nxt::wire::TracingCommandSerializer(serializer, wireTracePath);
+    if (tracingSerializer->HasError()) {
+        std::cerr << "Failed to open the wire trace " << wireTracePath << std::endl;
+    }
+    return tracingSerializer;
+}
 
 nxt::Device CreateCppNXTDevice() {
     binding = utils::CreateBinding(backendType);
@@ -103,15 +133,42 @@ nxt::Device CreateCppNXTDevice() {
                 wireServer = nxt::wire::NewServerCommandHandler(backendDevice, backendProcs, s2cBuf);
                 c2sBuf->SetHandler(wireServer);
 
+                clientSerializer = MaybeTraceClientSerializer(c2sBuf);
+
                 nxtDevice clientDevice;
                 nxtProcTable clientProcs;
-                wireClient = nxt::wire::NewClientDevice(&clientProcs, &clientDevice, c2sBuf);
+                wireClient = nxt::wire::NewClientDevice(&clientProcs, &clientDevice, clientSerializer);
                 s2cBuf->SetHandler(wireClient);
 
                 procs = clientProcs;
                 cDevice = clientDevice;
             }
             break;
+
+        case CmdBufType::Threaded:
+            {
+                // The OpenGL context is only current on this thread so the server can't use it.
+                if (backendType == utils::BackendType::OpenGL) {
+                    std::cerr << "The threaded command buffer doesn't support OpenGL" << std::endl;
+                    return nxt::Device();
+                }
+
+                threadedServer = new nxt::wire::ThreadedServer(backendDevice, backendProcs);
+
+                clientSerializer = MaybeTraceClientSerializer(threadedServer->GetClientSerializer());
+
+                nxtDevice clientDevice;
+                nxtProcTable clientProcs;
+                wireClient = nxt::wire::NewClientDevice(&clientProcs, &clientDevice, clientSerializer);
+
+                procs = clientProcs;
+                cDevice = clientDevice;
+            }
+            break;
+    }
+
+    if (profileProcs) {
+        procs = nxt::profiling::GetProfilingProcs(procs);
     }
 
     nxtSetProcs(&procs);
@@ -213,13 +270,43 @@ bool InitSample(int argc, const char** argv) {
                 cmdBufType = CmdBufType::Terrible;
                 continue;
             }
-            fprintf(stderr, "--command-buffer expects a command buffer name (none, terrible)\n");
+            if (i < argc && std::string("threaded") == argv[i]) {
+                cmdBufType = CmdBufType::Threaded;
+                continue;
+            }
+            fprintf(stderr, "--command-buffer expects a command buffer name (none, terrible, threaded)\n");
+            return false;
+        }
+        if (std::string("--trace-wire") == argv[i]) {
+            i++;
+            if (i < argc) {
+                wireTracePath = argv[i];
+                continue;
+            }
+            fprintf(stderr, "--trace-wire expects a path\n");
             return false;
         }
+        if (std::string("--trace-events") == argv[i]) {
+            i++;
+            if (i < argc) {
+                traceEventsPath = argv[i];
+                SetTracingEnabled(true);
+                continue;
+            }
+            fprintf(stderr, "--trace-events expects a path\n");
+            return false;
+        }
+        if (std::string("--profile-procs") == argv[i]) {
+            profileProcs = true;
+            continue;
+        }
         if (std::string("-h") == argv[i] || std::string("--help") == argv[i]) {
-            printf("Usage: %s [-b BACKEND] [-c COMMAND_BUFFER]\n", argv[0]);
+            printf("Usage: %s [-b BACKEND] [-c COMMAND_BUFFER] [--trace-wire TRACE_PATH] [--trace-events JSON_PATH] [--profile-procs]\n", argv[0]);
             printf("  BACKEND is one of: d3d12, metal, null, opengl, vulkan\n");
-            printf("  COMMAND_BUFFER is one of: none, terrible\n");
+            printf("  COMMAND_BUFFER is one of: none, terrible, threaded\n");
+            printf("  --trace-wire captures the wire commands for nxt_replay\n");
+            printf("  --trace-events writes a timeline of NXT's work for chrome://tracing\n");
+            printf("  --profile-procs prints the latency of NXT calls when quitting\n");
             return false;
         }
     }
@@ -228,14 +315,30 @@ bool InitSample(int argc, const char** argv) {
 
 void DoFlush() {
     if (cmdBufType == CmdBufType::Terrible) {
-        c2sBuf->Flush();
+        nxt::wire::ClientFlush(wireClient);
         s2cBuf->Flush();
     }
+    if (cmdBufType == CmdBufType::Threaded) {
+        nxt::wire::ClientFlush(wireClient);
+        threadedServer->HandleReturnCommands(wireClient);
+    }
     glfwPollEvents();
 }
 
 bool ShouldQuit() {
-    return glfwWindowShouldClose(window);
+    bool shouldQuit = glfwWindowShouldClose(window);
+    if (shouldQuit && profileProcs) {
+        std::cout << nxt::profiling::DumpProfilingDataText();
+        profileProcs = false;
+    }
+    if (shouldQuit && traceEventsPath != nullptr) {
+        SetTracingEnabled(false);
+        if (!WriteTraceEventsJSON(traceEventsPath)) {
+            std::cerr << "Failed to write the trace events to " << traceEventsPath << std::endl;
+        }
+        traceEventsPath = nullptr;
+    }
+    return shouldQuit;
 }
 
 GLFWwindow* GetGLFWWindow() {
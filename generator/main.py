@@ -84,22 +84,32 @@ class MethodArgument:
         self.type = typ
         self.annotation = annotation
         self.length = None
+        self.is_bulk = False
 
 Method = namedtuple('Method', ['name', 'return_type', 'arguments'])
+
+CommandMember = namedtuple('CommandMember', ['name', 'type', 'is_ref'])
+CommandTrailingData = namedtuple('CommandTrailingData', ['name', 'type', 'is_ref', 'length'])
+CommandStructure = namedtuple('CommandStructure', ['name', 'members'])
+Command = namedtuple('Command', ['name', 'members', 'trailing_data', 'has_ref_trailing_data'])
 class ObjectType(Type):
     def __init__(self, name, record):
         Type.__init__(self, name, record)
         self.methods = []
         self.native_methods = []
         self.built_type = None
+        self.is_recorded = record.get('recorded', False)
 
 ############################################################
 # PARSE
 ############################################################
 import json
 
+# Methods returning values can't be forwarded asynchronously on the wire, so like the ones with
+# natively defined types they are implemented by hand.
 def is_native_method(method):
     return method.return_type.category == "natively defined" or \
+        (method.return_type.category == "native" and method.return_type.name.canonical_case() != "void") or \
         any([arg.type.category == "natively defined" for arg in method.arguments])
 
 def link_object(obj, types):
@@ -119,6 +129,12 @@ def link_object(obj, types):
                 else:
                     arg.length = arguments_by_name[a['length']]
 
+            # Bulk arguments can be sent out of band, only arrays of values support it.
+            if a.get('bulk', False):
+                assert(arg.annotation != 'value' and arg.length != 'strlen')
+                assert(arg.type.category != 'object')
+                arg.is_bulk = True
+
         return Method(Name(record['name']), types[record.get('returns', 'void')], arguments)
 
     methods = [make_method(m) for m in obj.record.get('methods', [])]
@@ -167,6 +183,50 @@ def parse_json(json):
         'by_category': by_category
     }
 
+def parse_commands_json(json, types):
+    structure_names = set([record['name'] for record in json['structures']])
+
+    ref_types = set()
+
+    def member_type(record):
+        if record.get('ref', False):
+            assert(types[record['type']].category == 'object')
+            ref_types.add(record['type'])
+            return 'Ref<' + Name(record['type']).CamelCase() + 'Base>'
+        if record['type'] in structure_names:
+            return Name(record['type']).CamelCase()
+
+        typ = types[record['type']]
+        if typ.category in ['enum', 'bitmask']:
+            return 'nxt::' + as_cppType(typ.name)
+        assert(typ.category == 'native')
+        return as_cppType(typ.name)
+
+    def make_members(records):
+        return [CommandMember(Name(m['name']), member_type(m), m.get('ref', False)) for m in records]
+
+    structures = [CommandStructure(Name(s['name']), make_members(s['members'])) for s in json['structures']]
+
+    commands = []
+    for record in json['commands']:
+        members = make_members(record.get('members', []))
+        members_by_name = dict([(member.name.canonical_case(), member) for member in members])
+
+        trailing_data = []
+        for d in record.get('trailing data', []):
+            length = members_by_name[d['length']]
+            assert(length.type == 'uint32_t')
+            trailing_data.append(CommandTrailingData(Name(d['name']), member_type(d), d.get('ref', False), length))
+
+        has_ref_trailing_data = any([data.is_ref for data in trailing_data])
+        commands.append(Command(Name(record['name']), members, trailing_data, has_ref_trailing_data))
+
+    return {
+        'command_structures': structures,
+        'commands': commands,
+        'command_ref_types': [Name(name) for name in sorted(ref_types)],
+    }
+
 #############################################################
 # OUTPUT
 #############################################################
@@ -350,7 +410,9 @@ def debug(text):
     print(text)
 
 def main():
-    targets = ['nxt', 'nxtcpp', 'mock_nxt', 'opengl', 'metal', 'd3d12', 'null', 'wire', 'blink']
+    backends = ['d3d12', 'metal', 'null', 'opengl', 'vulkan']
+    targets = ['nxt', 'nxtcpp', 'mock_nxt', 'opengl', 'metal', 'd3d12', 'null', 'wire', 'profiling', 'dispatch', 'backend_commands', 'blink']
+    targets += [backend + '_static_dispatch' for backend in backends]
 
     parser = argparse.ArgumentParser(
         description = 'Generates code for various target for NXT.',
@@ -360,6 +422,7 @@ def main():
     parser.add_argument('-t', '--template-dir', default='templates', type=str, help='Directory with template files.')
     parser.add_argument('-o', '--output-dir', default=None, type=str, help='Output directory for the generated source files.')
     parser.add_argument('-T', '--targets', default=None, type=str, help='Comma-separated subset of targets to output. Available targets: ' + ', '.join(targets))
+    parser.add_argument('--commands-json', default=None, type=str, help='The JSON definition of the backend commands, needed by the backend_commands target.')
     parser.add_argument('--print-dependencies', action='store_true', help='Prints a space separated list of file dependencies, used for CMake integration')
     parser.add_argument('--print-outputs', action='store_true', help='Prints a space separated list of file outputs, used for CMake integration')
     parser.add_argument('--gn', action='store_true', help='Make the printing of dependencies by GN friendly')
@@ -423,18 +486,25 @@ def main():
         }
     ]
 
-    for backend in ['d3d12', 'metal', 'null', 'opengl', 'vulkan']:
-        if not backend in targets:
-            continue
-
+    for backend in backends:
         extension = 'cpp'
         if backend == 'metal':
             extension = 'mm'
 
-        backend_params = {
-            'namespace': backend,
-        }
-        renders.append(FileRender('BackendProcTable.cpp', backend + '/ProcTable.' + extension, base_backend_params + [backend_params]))
+        if backend in targets:
+            backend_params = {
+                'namespace': backend,
+                'static_dispatch': False,
+            }
+            renders.append(FileRender('BackendProcTable.cpp', backend + '/ProcTable.' + extension, base_backend_params + [backend_params]))
+
+        # The C API with direct calls to the backend's entry points, replacing the one of api.c
+        if backend + '_static_dispatch' in targets:
+            backend_params = {
+                'namespace': backend,
+                'static_dispatch': True,
+            }
+            renders.append(FileRender('BackendProcTable.cpp', backend + '/StaticDispatch.' + extension, base_backend_params + [backend_params]))
 
     if 'wire' in targets:
         renders.append(FileRender('wire/WireCmd.h', 'wire/WireCmd_autogen.h', base_backend_params))
@@ -442,6 +512,19 @@ def main():
         renders.append(FileRender('wire/WireClient.cpp', 'wire/WireClient.cpp', base_backend_params))
         renders.append(FileRender('wire/WireServer.cpp', 'wire/WireServer.cpp', base_backend_params))
 
+    if 'profiling' in targets:
+        renders.append(FileRender('ProfilingProcTable.cpp', 'profiling/ProfilingProcTable_autogen.cpp', [base_params, api_params, c_params]))
+
+    if 'backend_commands' in targets:
+        assert(args.commands_json != None)
+        with open(args.commands_json) as f:
+            commands_params = parse_commands_json(json.loads(f.read()), api_params['types'])
+        renders.append(FileRender('backend/Commands.h', 'backend/Commands_autogen.h', [base_params, commands_params]))
+        renders.append(FileRender('backend/Commands.cpp', 'backend/Commands_autogen.cpp', [base_params, commands_params]))
+
+    if 'dispatch' in targets:
+        renders.append(FileRender('DispatchProcTable.cpp', 'dispatch/DispatchProcTable_autogen.cpp', [base_params, api_params, c_params]))
+
     if 'blink' in targets:
         js_params = {'native_methods': lambda typ: js_native_methods(api_params['types'], typ)}
         renders.append(FileRender('autogen.gni', 'autogen.gni', [base_params, api_params, js_params]))
@@ -460,6 +543,7 @@ def main():
         dependencies = set(
             [os.path.abspath(args.template_dir + os.path.sep + render.template) for render in renders] +
             [os.path.abspath(args.json[0])] +
+            ([os.path.abspath(args.commands_json)] if args.commands_json != None else []) +
             [os.path.realpath(__file__)]
         )
         dependencies = [dependency.replace('\\', '/') for dependency in dependencies]
@@ -16,6 +16,7 @@
 #include "nxt/nxtcpp.h"
 
 #include "common/Assert.h"
+#include "common/Trace.h"
 
 #include "backend/{{namespace}}/GeneratedCodeIncludes.h"
 
@@ -54,6 +55,7 @@ namespace {{namespace}} {
         {% for type in by_category["object"] %}
             {% for method in native_methods(type) %}
                 {% set suffix = as_MethodSuffix(type.name, method.name) %}
+                {% set isGetResult = type.is_builder and method.name.canonical_case() == "get result" %}
 
                 //* Entry point without validation, forwards the arguments to the method directly
                 {{as_backendType(method.return_type)}} NonValidating{{suffix}}(
@@ -62,6 +64,9 @@ namespace {{namespace}} {
                         , {{as_annotated_backendType(arg)}}
                     {%- endfor -%}
                 ) {
+                    {% if isGetResult %}
+                        NXT_TRACE_EVENT("builder", "{{suffix}}");
+                    {% endif %}
                     {% if method.return_type.name.canonical_case() != "void" %}
                         auto result =
                     {%- endif %}
@@ -126,6 +131,10 @@ namespace {{namespace}} {
                         , {{as_annotated_backendType(arg)}}
                     {%- endfor -%}
                 ) {
+                    {% if isGetResult %}
+                        NXT_TRACE_EVENT("builder", "{{suffix}}");
+                    {% endif %}
+
                     //* Do the autogenerated checks
                     bool valid = ValidateBase{{suffix}}(self
                         {%- for arg in method.arguments -%}
@@ -182,24 +191,64 @@ namespace {{namespace}} {
         {% endfor %}
     }
 
-    nxtProcTable GetNonValidatingProcs() {
-        nxtProcTable table;
-        {% for type in by_category["object"] %}
-            {% for method in native_methods(type) %}
-                table.{{as_varName(type.name, method.name)}} = reinterpret_cast<{{as_cProc(type.name, method.name)}}>(NonValidating{{as_MethodSuffix(type.name, method.name)}});
+    {% if not static_dispatch %}
+        nxtProcTable GetNonValidatingProcs() {
+            nxtProcTable table;
+            {% for type in by_category["object"] %}
+                {% for method in native_methods(type) %}
+                    table.{{as_varName(type.name, method.name)}} = reinterpret_cast<{{as_cProc(type.name, method.name)}}>(NonValidating{{as_MethodSuffix(type.name, method.name)}});
+                {% endfor %}
             {% endfor %}
-        {% endfor %}
-        return table;
-    }
+            return table;
+        }
+
+        nxtProcTable GetValidatingProcs() {
+            nxtProcTable table;
+            {% for type in by_category["object"] %}
+                {% for method in native_methods(type) %}
+                    table.{{as_varName(type.name, method.name)}} = reinterpret_cast<{{as_cProc(type.name, method.name)}}>(Validating{{as_MethodSuffix(type.name, method.name)}});
+                {% endfor %}
+            {% endfor %}
+            return table;
+        }
+    {% endif %}
+
+    {% if static_dispatch %}
+        //* The C API for builds with static dispatch, instead of the one in api.c. Calls go directly to
+        //* the validating entry points above so that they are inlined in this file, and nxtSetProcs
+        //* does nothing since this backend is the only one the C API can call. Functions with C
+        //* linkage are the same in all namespaces so these are the ones declared in nxt.h.
+        extern "C" {
+
+        void nxtSetProcs(const nxtProcTable*) {
+        }
 
-    nxtProcTable GetValidatingProcs() {
-        nxtProcTable table;
         {% for type in by_category["object"] %}
             {% for method in native_methods(type) %}
-                table.{{as_varName(type.name, method.name)}} = reinterpret_cast<{{as_cProc(type.name, method.name)}}>(Validating{{as_MethodSuffix(type.name, method.name)}});
+                {{as_cType(method.return_type.name)}} {{as_cMethod(type.name, method.name)}}(
+                    {{-as_cType(type.name)}} {{as_varName(type.name)}}
+                    {%- for arg in method.arguments -%}
+                        , {{as_annotated_cType(arg)}}
+                    {%- endfor -%}
+                ) {
+                    {{"auto result =" if method.return_type.category == "object" else "return"}} Validating{{as_MethodSuffix(type.name, method.name)}}(
+                        reinterpret_cast<{{as_backendType(type)}}>({{as_varName(type.name)}})
+                        {%- for arg in method.arguments -%}
+                            , {% if arg.type.category == "object" -%}
+                                reinterpret_cast<{{decorate("", as_backendType(arg.type), arg)}}>({{as_varName(arg.name)}})
+                            {%- else -%}
+                                {{as_varName(arg.name)}}
+                            {%- endif -%}
+                        {%- endfor -%}
+                    );
+                    {% if method.return_type.category == "object" %}
+                        return reinterpret_cast<{{as_cType(method.return_type.name)}}>(result);
+                    {% endif %}
+                }
             {% endfor %}
         {% endfor %}
-        return table;
-    }
+
+        }  // extern "C"
+    {% endif %}
 }
 }
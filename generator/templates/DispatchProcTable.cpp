@@ -0,0 +1,165 @@
+//* Copyright 2017 The NXT Authors
+//*
+//* Licensed under the Apache License, Version 2.0 (the "License");
+//* you may not use this file except in compliance with the License.
+//* You may obtain a copy of the License at
+//*
+//*     http://www.apache.org/licenses/LICENSE-2.0
+//*
+//* Unless required by applicable law or agreed to in writing, software
+//* distributed under the License is distributed on an "AS IS" BASIS,
+//* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//* See the License for the specific language governing permissions and
+//* limitations under the License.
+
+#include "dispatch/DispatchProcs.h"
+
+#include "common/Assert.h"
+
+#include <vector>
+
+namespace nxt {
+namespace dispatch {
+
+    namespace {
+
+        constexpr uint32_t kInlineArraySize = 16;
+
+        //* The procs of a wrapped device, kept alive by the device and all its objects.
+        struct DispatchDevice {
+            nxtProcTable procs;
+            uint32_t refcount;
+        };
+
+        //* What the handles given to the application point to. Like the objects of backends,
+        //* wrappers must only be used by one thread at a time so the refcounts aren't atomic.
+        struct DispatchObject {
+            DispatchDevice* device;
+            void* object;
+            uint32_t refcount;
+        };
+
+        void ReleaseDevice(DispatchDevice* device) {
+            ASSERT(device->refcount > 0);
+            device->refcount--;
+            if (device->refcount == 0) {
+                delete device;
+            }
+        }
+
+        DispatchObject* FromHandle(void* handle) {
+            return reinterpret_cast<DispatchObject*>(handle);
+        }
+
+        template <typename T>
+        T Wrap(DispatchDevice* device, T object) {
+            if (object == nullptr) {
+                return nullptr;
+            }
+            device->refcount++;
+            return reinterpret_cast<T>(new DispatchObject{device, object, 1});
+        }
+
+        template <typename T>
+        T Unwrap(T handle) {
+            if (handle == nullptr) {
+                return nullptr;
+            }
+            return static_cast<T>(FromHandle(handle)->object);
+        }
+
+        //* Unwraps arrays of objects, without allocating for the common small arrays.
+        template <typename T>
+        class UnwrappedArray {
+          public:
+            UnwrappedArray(const T* handles, uint32_t count) {
+                mData = mInlineStorage;
+                if (count > kInlineArraySize) {
+                    mHeapStorage.resize(count);
+                    mData = mHeapStorage.data();
+                }
+                for (uint32_t i = 0; i < count; ++i) {
+                    mData[i] = Unwrap(handles[i]);
+                }
+            }
+
+            const T* Get() const {
+                return mData;
+            }
+
+          private:
+            T mInlineStorage[kInlineArraySize];
+            std::vector<T> mHeapStorage;
+            T* mData;
+        };
+
+        {% for type in by_category["object"] %}
+            {% for method in native_methods(type) %}
+                {% set suffix = as_MethodSuffix(type.name, method.name) %}
+                {% set isReference = method.name.canonical_case() == "reference" %}
+                {% set isRelease = method.name.canonical_case() == "release" %}
+                {% set returnsObject = method.return_type.category == "object" %}
+                {% set returnsValue = not returnsObject and method.return_type.name.canonical_case() != "void" %}
+                {{as_cType(method.return_type.name)}} Dispatch{{suffix}}(
+                    {{-as_cType(type.name)}} {{as_varName(type.name)}}
+                    {%- for arg in method.arguments -%}
+                        , {{as_annotated_cType(arg)}}
+                    {%- endfor -%}
+                ) {
+                    //* Locals are prefixed so that they don't shadow the arguments.
+                    DispatchObject* dispatchSelf = FromHandle({{as_varName(type.name)}});
+                    DispatchDevice* dispatchDevice = dispatchSelf->device;
+                    {% for arg in method.arguments if arg.type.category == "object" and arg.annotation != "value" %}
+                        UnwrappedArray<{{as_cType(arg.type.name)}}> dispatch{{arg.name.CamelCase()}}(
+                            {{-as_varName(arg.name)}}, {{as_varName(arg.length.name)}});
+                    {% endfor %}
+
+                    {{"auto dispatchResult = " if returnsObject}}{{"return " if returnsValue}}dispatchDevice->procs.{{as_varName(type.name, method.name)}}(
+                        {{-'static_cast<' + as_cType(type.name) + '>'}}(dispatchSelf->object)
+                        {%- for arg in method.arguments -%}
+                            , {% if arg.type.category == "object" and arg.annotation != "value" -%}
+                                dispatch{{arg.name.CamelCase()}}.Get()
+                            {%- elif arg.type.category == "object" -%}
+                                Unwrap({{as_varName(arg.name)}})
+                            {%- else -%}
+                                {{as_varName(arg.name)}}
+                            {%- endif -%}
+                        {%- endfor -%}
+                    );
+
+                    {% if isReference %}
+                        dispatchSelf->refcount++;
+                    {% elif isRelease %}
+                        ASSERT(dispatchSelf->refcount > 0);
+                        dispatchSelf->refcount--;
+                        if (dispatchSelf->refcount == 0) {
+                            delete dispatchSelf;
+                            ReleaseDevice(dispatchDevice);
+                        }
+                    {% endif %}
+                    {% if returnsObject %}
+                        return Wrap(dispatchDevice, dispatchResult);
+                    {% endif %}
+                }
+            {% endfor %}
+        {% endfor %}
+    }
+
+    nxtProcTable GetDispatchProcs() {
+        nxtProcTable table;
+        {% for type in by_category["object"] %}
+            {% for method in native_methods(type) %}
+                table.{{as_varName(type.name, method.name)}} = Dispatch{{as_MethodSuffix(type.name, method.name)}};
+            {% endfor %}
+        {% endfor %}
+        return table;
+    }
+
+    nxtDevice WrapDevice(nxtDevice device, const nxtProcTable& procs) {
+        ASSERT(device != nullptr);
+        DispatchDevice* dispatchDevice = new DispatchDevice{procs, 0};
+        return Wrap(dispatchDevice, device);
+    }
+
+}
+}
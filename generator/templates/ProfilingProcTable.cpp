@@ -0,0 +1,109 @@
+//* Copyright 2017 The NXT Authors
+//*
+//* Licensed under the Apache License, Version 2.0 (the "License");
+//* you may not use this file except in compliance with the License.
+//* You may obtain a copy of the License at
+//*
+//*     http://www.apache.org/licenses/LICENSE-2.0
+//*
+//* Unless required by applicable law or agreed to in writing, software
+//* distributed under the License is distributed on an "AS IS" BASIS,
+//* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//* See the License for the specific language governing permissions and
+//* limitations under the License.
+
+#include "profiling/ProfilingProcs.h"
+
+#include "common/Assert.h"
+
+#include <chrono>
+
+namespace nxt {
+namespace profiling {
+
+    namespace {
+
+        //* Index of each entry point in the histograms.
+        enum EntryPoint {
+            {% for type in by_category["object"] %}
+                {% for method in native_methods(type) %}
+                    EntryPoint_{{as_MethodSuffix(type.name, method.name)}},
+                {% endfor %}
+            {% endfor %}
+            EntryPointCount,
+        };
+
+        const char* const kEntryPointNames[EntryPointCount] = {
+            {% for type in by_category["object"] %}
+                {% for method in native_methods(type) %}
+                    "{{as_cMethod(type.name, method.name)}}",
+                {% endfor %}
+            {% endfor %}
+        };
+
+        //* The procs the profiling entry points forward to.
+        nxtProcTable sProcs;
+        LatencyHistogram sHistograms[EntryPointCount];
+
+        uint64_t NanosecondsSince(std::chrono::steady_clock::time_point start) {
+            auto end = std::chrono::steady_clock::now();
+            return static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+
+        {% for type in by_category["object"] %}
+            {% for method in native_methods(type) %}
+                {% set suffix = as_MethodSuffix(type.name, method.name) %}
+                {{as_cType(method.return_type.name)}} Profiling{{suffix}}(
+                    {{-as_cType(type.name)}} {{as_varName(type.name)}}
+                    {%- for arg in method.arguments -%}
+                        , {{as_annotated_cType(arg)}}
+                    {%- endfor -%}
+                ) {
+                    //* Locals are prefixed so that they don't shadow the arguments.
+                    auto profilingStart = std::chrono::steady_clock::now();
+                    {% if method.return_type.name.canonical_case() != "void" %}
+                        auto profilingResult =
+                    {%- endif %}
+                    sProcs.{{as_varName(type.name, method.name)}}({{as_varName(type.name)}}
+                        {%- for arg in method.arguments -%}
+                            , {{as_varName(arg.name)}}
+                        {%- endfor -%}
+                    );
+                    sHistograms[EntryPoint_{{suffix}}].Record(NanosecondsSince(profilingStart));
+                    {% if method.return_type.name.canonical_case() != "void" %}
+                        return profilingResult;
+                    {% endif %}
+                }
+            {% endfor %}
+        {% endfor %}
+    }
+
+    nxtProcTable GetProfilingProcs(const nxtProcTable& procs) {
+        sProcs = procs;
+
+        nxtProcTable table;
+        {% for type in by_category["object"] %}
+            {% for method in native_methods(type) %}
+                table.{{as_varName(type.name, method.name)}} = Profiling{{as_MethodSuffix(type.name, method.name)}};
+            {% endfor %}
+        {% endfor %}
+        return table;
+    }
+
+    size_t GetEntryPointCount() {
+        return EntryPointCount;
+    }
+
+    const char* GetEntryPointName(size_t entryPoint) {
+        ASSERT(entryPoint < EntryPointCount);
+        return kEntryPointNames[entryPoint];
+    }
+
+    LatencyHistogram* GetEntryPointHistogram(size_t entryPoint) {
+        ASSERT(entryPoint < EntryPointCount);
+        return &sHistograms[entryPoint];
+    }
+
+}
+}
@@ -14,6 +14,10 @@
 
 #include "nxt/nxt.h"
 
+//* With static dispatch the C API is defined by the StaticDispatch file generated for the
+//* compiled-in backend instead.
+#if !defined(NXT_STATIC_DISPATCH)
+
 static nxtProcTable procs;
 
 static nxtProcTable nullProcs;
@@ -44,3 +48,5 @@ void nxtSetProcs(const nxtProcTable* procs_) {
     {% endfor %}
 
 {% endfor %}
+
+#endif  // !defined(NXT_STATIC_DISPATCH)
@@ -38,6 +38,7 @@ typedef uint64_t nxtCallbackUserdata;
 typedef void (*nxtDeviceErrorCallback)(const char* message, nxtCallbackUserdata userdata);
 typedef void (*nxtBuilderErrorCallback)(nxtBuilderErrorStatus status, const char* message, nxtCallbackUserdata userdata1, nxtCallbackUserdata userdata2);
 typedef void (*nxtBufferMapReadCallback)(nxtBufferMapReadStatus status, const void* data, nxtCallbackUserdata userdata);
+typedef void (*nxtFenceOnCompletionCallback)(nxtFenceCompletionStatus status, nxtCallbackUserdata userdata);
 
 #ifdef __cplusplus
 extern "C" {
@@ -0,0 +1,91 @@
+//* Copyright 2017 The NXT Authors
+//*
+//* Licensed under the Apache License, Version 2.0 (the "License");
+//* you may not use this file except in compliance with the License.
+//* You may obtain a copy of the License at
+//*
+//*     http://www.apache.org/licenses/LICENSE-2.0
+//*
+//* Unless required by applicable law or agreed to in writing, software
+//* distributed under the License is distributed on an "AS IS" BASIS,
+//* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//* See the License for the specific language governing permissions and
+//* limitations under the License.
+
+#include "backend/Commands.h"
+//* Freeing the commands destroys their Refs which needs the objects to be complete types.
+{% for type in command_ref_types %}
+    #include "backend/{{type.CamelCase()}}.h"
+{% endfor %}
+#include "common/Assert.h"
+
+namespace backend {
+
+    namespace {
+
+        using CommandFunction = void (*)(CommandIterator* commands);
+
+        {% for command in commands %}
+            {% set Cmd = command.name.CamelCase() + "Cmd" %}
+            void Skip{{command.name.CamelCase()}}(CommandIterator* commands) {
+                {% if len(command.trailing_data) == 0 %}
+                    commands->NextCommand<{{Cmd}}>();
+                {% else %}
+                    {{Cmd}}* cmd = commands->NextCommand<{{Cmd}}>();
+                    {% for data in command.trailing_data %}
+                        commands->NextData<{{data.type}}>(cmd->{{as_varName(data.length.name)}});
+                    {% endfor %}
+                {% endif %}
+            }
+
+            void Free{{command.name.CamelCase()}}(CommandIterator* commands) {
+                {{Cmd}}* cmd = commands->NextCommand<{{Cmd}}>();
+                {% for data in command.trailing_data %}
+                    {% if data.is_ref %}
+                        {{data.type}}* {{as_varName(data.name)}} =
+                            commands->NextData<{{data.type}}>(cmd->{{as_varName(data.length.name)}});
+                        for (uint32_t i = 0; i < cmd->{{as_varName(data.length.name)}}; ++i) {
+                            {{as_varName(data.name)}}[i].~{{data.type}}();
+                        }
+                    {% else %}
+                        commands->NextData<{{data.type}}>(cmd->{{as_varName(data.length.name)}});
+                    {% endif %}
+                {% endfor %}
+                cmd->~{{Cmd}}();
+            }
+
+        {% endfor %}
+        //* Indexed by Command, switches over all the commands would compile to the same jump
+        //* tables but these make it explicit and keep the code for each command out of line.
+        constexpr CommandFunction kSkipFunctions[kCommandCount] = {
+            {% for command in commands %}
+                Skip{{command.name.CamelCase()}},
+            {% endfor %}
+        };
+
+        constexpr CommandFunction kFreeFunctions[kCommandCount] = {
+            {% for command in commands %}
+                Free{{command.name.CamelCase()}},
+            {% endfor %}
+        };
+
+    }  // anonymous namespace
+
+    void FreeCommands(CommandIterator* commands) {
+        // Command buffers with only trivially destructible commands don't need to be iterated.
+        if (commands->NeedsDestruction()) {
+            Command type;
+            while (commands->NextCommandId(&type)) {
+                ASSERT(static_cast<size_t>(type) < kCommandCount);
+                kFreeFunctions[static_cast<size_t>(type)](commands);
+            }
+        }
+        commands->DataWasDestroyed();
+    }
+
+    void SkipCommand(CommandIterator* commands, Command type) {
+        ASSERT(static_cast<size_t>(type) < kCommandCount);
+        kSkipFunctions[static_cast<size_t>(type)](commands);
+    }
+
+}  // namespace backend
@@ -0,0 +1,129 @@
+//* Copyright 2017 The NXT Authors
+//*
+//* Licensed under the Apache License, Version 2.0 (the "License");
+//* you may not use this file except in compliance with the License.
+//* You may obtain a copy of the License at
+//*
+//*     http://www.apache.org/licenses/LICENSE-2.0
+//*
+//* Unless required by applicable law or agreed to in writing, software
+//* distributed under the License is distributed on an "AS IS" BASIS,
+//* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//* See the License for the specific language governing permissions and
+//* limitations under the License.
+
+#ifndef BACKEND_COMMANDS_AUTOGEN_H_
+#define BACKEND_COMMANDS_AUTOGEN_H_
+
+//* Only included by backend/Commands.h, after the definition of the objects that commands
+//* reference.
+
+#include "backend/CommandAllocator.h"
+
+#include <type_traits>
+
+namespace backend {
+
+    enum class Command {
+        {% for command in commands %}
+            {{command.name.CamelCase()}},
+        {% endfor %}
+    };
+
+    static constexpr size_t kCommandCount = {{len(commands)}};
+
+    {% for structure in command_structures %}
+        struct {{structure.name.CamelCase()}} {
+            {% for member in structure.members %}
+                {{member.type}} {{as_varName(member.name)}};
+            {% endfor %}
+        };
+
+    {% endfor %}
+    {% for command in commands %}
+        {% set Cmd = command.name.CamelCase() + "Cmd" %}
+        {% if len(command.members) == 0 %}
+            struct {{Cmd}} {};
+        {% else %}
+            struct {{Cmd}} {
+                {% for member in command.members %}
+                    {{member.type}} {{as_varName(member.name)}};
+                {% endfor %}
+            };
+        {% endif %}
+        {% for data in command.trailing_data %}
+            //* Trailing data isn't part of the struct so document it next to it.
+            // Followed by {{data.type}} {{as_varName(data.name)}}[{{as_varName(data.length.name)}}]
+        {% endfor %}
+
+    {% endfor %}
+    // The layout of each command, indexed by Command. Commands are trivially destructible when
+    // neither they nor their trailing data contain Ref<>.
+    struct CommandInfo {
+        size_t size;
+        size_t alignment;
+        bool triviallyDestructible;
+        bool hasTrailingData;
+    };
+
+    static constexpr CommandInfo kCommandInfos[kCommandCount] = {
+        {% for command in commands %}
+            {% set Cmd = command.name.CamelCase() + "Cmd" %}
+            {sizeof({{Cmd}}), alignof({{Cmd}}),
+             {{"false" if command.has_ref_trailing_data else "std::is_trivially_destructible<" + Cmd + ">::value"}},
+             {{"true" if len(command.trailing_data) > 0 else "false"}}},
+        {% endfor %}
+    };
+
+    // This needs to be called before the CommandIterator is freed so that the Ref<> present in
+    // the commands have a chance to run their destructor and remove internal references.
+    void FreeCommands(CommandIterator* commands);
+    void SkipCommand(CommandIterator* commands, Command type);
+
+    // Calls the visitor's On<Command> method for each of the remaining commands, with pointers to
+    // the command and its trailing data. Visitors derive from CommandVisitor and hide the methods
+    // of the commands they handle, the others are skipped.
+    //
+    //     struct Executor : CommandVisitor {
+    //         void OnDrawArrays(DrawArraysCmd* draw) { ... }
+    //     };
+    //     Executor executor;
+    //     VisitCommands(&commands, &executor);
+    struct CommandVisitor {
+        {% for command in commands %}
+            void On{{command.name.CamelCase()}}({{command.name.CamelCase()}}Cmd*
+                {%- for data in command.trailing_data -%}
+                    , {{data.type}}*
+                {%- endfor -%}
+            ) {
+            }
+        {% endfor %}
+    };
+
+    template <typename Visitor>
+    void VisitCommands(CommandIterator* commands, Visitor* visitor) {
+        Command type;
+        while (commands->NextCommandId(&type)) {
+            switch (type) {
+                {% for command in commands %}
+                    {% set Cmd = command.name.CamelCase() + "Cmd" %}
+                    case Command::{{command.name.CamelCase()}}: {
+                        {{Cmd}}* cmd = commands->NextCommand<{{Cmd}}>();
+                        {% for data in command.trailing_data %}
+                            {{data.type}}* {{as_varName(data.name)}} =
+                                commands->NextData<{{data.type}}>(cmd->{{as_varName(data.length.name)}});
+                        {% endfor %}
+                        visitor->On{{command.name.CamelCase()}}(cmd
+                            {%- for data in command.trailing_data -%}
+                                , {{as_varName(data.name)}}
+                            {%- endfor -%}
+                        );
+                    } break;
+                {% endfor %}
+            }
+        }
+    }
+
+}  // namespace backend
+
+#endif  // BACKEND_COMMANDS_AUTOGEN_H_
@@ -64,6 +64,14 @@ void ProcTableAsClass::BufferMapReadAsync(nxtBuffer self, uint32_t start, uint32
     OnBufferMapReadAsyncCallback(self, start, size, callback, userdata);
 }
 
+void ProcTableAsClass::FenceOnCompletion(nxtFence self, uint64_t value, nxtFenceOnCompletionCallback callback, nxtCallbackUserdata userdata) {
+    auto object = reinterpret_cast<ProcTableAsClass::Object*>(self);
+    object->fenceOnCompletionCallback = callback;
+    object->userdata1 = userdata;
+
+    OnFenceOnCompletionCallback(self, value, callback, userdata);
+}
+
 void ProcTableAsClass::CallDeviceErrorCallback(nxtDevice device, const char* message) {
     auto object = reinterpret_cast<ProcTableAsClass::Object*>(device);
     object->deviceErrorCallback(message, object->userdata1);
@@ -76,6 +84,10 @@ void ProcTableAsClass::CallMapReadCallback(nxtBuffer buffer, nxtBufferMapReadSta
     auto object = reinterpret_cast<ProcTableAsClass::Object*>(buffer);
     object->mapReadCallback(status, data, object->userdata1);
 }
+void ProcTableAsClass::CallFenceOnCompletionCallback(nxtFence fence, nxtFenceCompletionStatus status) {
+    auto object = reinterpret_cast<ProcTableAsClass::Object*>(fence);
+    object->fenceOnCompletionCallback(status, object->userdata1);
+}
 
 {% for type in by_category["object"] if type.is_builder %}
     void ProcTableAsClass::{{as_MethodSuffix(type.name, Name("set error callback"))}}({{as_cType(type.name)}} self, nxtBuilderErrorCallback callback, nxtCallbackUserdata userdata1, nxtCallbackUserdata userdata2) {
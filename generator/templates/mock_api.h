@@ -58,22 +58,29 @@ class ProcTableAsClass {
         // Stores callback and userdata and calls the On* methods
         void DeviceSetErrorCallback(nxtDevice self, nxtDeviceErrorCallback callback, nxtCallbackUserdata userdata);
         void BufferMapReadAsync(nxtBuffer self, uint32_t start, uint32_t size, nxtBufferMapReadCallback callback, nxtCallbackUserdata userdata);
+        void FenceOnCompletion(nxtFence self, uint64_t value, nxtFenceOnCompletionCallback callback, nxtCallbackUserdata userdata);
+
+        // Methods returning values, mocked directly
+        virtual uint64_t FenceGetCompletedValue(nxtFence self) = 0;
 
         // Special cased mockable methods
         virtual void OnDeviceSetErrorCallback(nxtDevice device, nxtDeviceErrorCallback callback, nxtCallbackUserdata userdata) = 0;
         virtual void OnBuilderSetErrorCallback(nxtBufferBuilder builder, nxtBuilderErrorCallback callback, nxtCallbackUserdata userdata1, nxtCallbackUserdata userdata2) = 0;
         virtual void OnBufferMapReadAsyncCallback(nxtBuffer buffer, uint32_t start, uint32_t size, nxtBufferMapReadCallback callback, nxtCallbackUserdata userdata) = 0;
+        virtual void OnFenceOnCompletionCallback(nxtFence fence, uint64_t value, nxtFenceOnCompletionCallback callback, nxtCallbackUserdata userdata) = 0;
 
         // Calls the stored callbacks
         void CallDeviceErrorCallback(nxtDevice device, const char* message);
         void CallBuilderErrorCallback(void* builder , nxtBuilderErrorStatus status, const char* message);
         void CallMapReadCallback(nxtBuffer buffer, nxtBufferMapReadStatus status, const void* data);
+        void CallFenceOnCompletionCallback(nxtFence fence, nxtFenceCompletionStatus status);
 
         struct Object {
             ProcTableAsClass* procs = nullptr;
             nxtDeviceErrorCallback deviceErrorCallback = nullptr;
             nxtBuilderErrorCallback builderErrorCallback = nullptr;
             nxtBufferMapReadCallback mapReadCallback = nullptr;
+            nxtFenceOnCompletionCallback fenceOnCompletionCallback = nullptr;
             nxtCallbackUserdata userdata1 = 0;
             nxtCallbackUserdata userdata2 = 0;
         };
@@ -104,6 +111,8 @@ class MockProcTable : public ProcTableAsClass {
         MOCK_METHOD3(OnDeviceSetErrorCallback, void(nxtDevice device, nxtDeviceErrorCallback callback, nxtCallbackUserdata userdata));
         MOCK_METHOD4(OnBuilderSetErrorCallback, void(nxtBufferBuilder builder, nxtBuilderErrorCallback callback, nxtCallbackUserdata userdata1, nxtCallbackUserdata userdata2));
         MOCK_METHOD5(OnBufferMapReadAsyncCallback, void(nxtBuffer buffer, uint32_t start, uint32_t size, nxtBufferMapReadCallback callback, nxtCallbackUserdata userdata));
+        MOCK_METHOD4(OnFenceOnCompletionCallback, void(nxtFence fence, uint64_t value, nxtFenceOnCompletionCallback callback, nxtCallbackUserdata userdata));
+        MOCK_METHOD1(FenceGetCompletedValue, uint64_t(nxtFence fence));
 };
 
 #endif // MOCK_NXT_H
@@ -12,16 +12,22 @@
 //* See the License for the specific language governing permissions and
 //* limitations under the License.
 
+#include "wire/SharedMemory.h"
 #include "wire/Wire.h"
 #include "wire/WireCmd.h"
 
 #include "common/Assert.h"
+#include "common/Trace.h"
 
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>
+#include <limits>
 #include <map>
 #include <memory>
+#include <new>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace nxt {
@@ -32,6 +38,33 @@ namespace wire {
 
         class Device;
 
+        //* Smaller bulk arrays aren't worth a round trip to reclaim their shared memory.
+        static constexpr size_t kMinBulkDataSize = 4096;
+
+        //* Recordings are sent in pieces of at most this size.
+        static constexpr size_t kMaxRecordingSize = 1 << 20;
+
+        //* Number of objects in each slab of an ObjectAllocator.
+        static constexpr uint32_t kObjectSlabSize = 256;
+
+        //* Handles of objects have the ID of the object in the low 32 bits and the generation of
+        //* the ID in the high 32 bits. The generation is incremented each time the ID is freed and
+        //* is what the server sends back as the serial of the object, so the handle rebuilt from
+        //* a return command only matches the object it was sent for.
+        using ObjectHandle = uint64_t;
+
+        ObjectHandle MakeObjectHandle(uint32_t id, uint32_t generation) {
+            return (uint64_t(generation) << uint64_t(32)) | id;
+        }
+
+        uint32_t GetObjectHandleId(ObjectHandle handle) {
+            return static_cast<uint32_t>(handle);
+        }
+
+        uint32_t GetObjectHandleGeneration(ObjectHandle handle) {
+            return static_cast<uint32_t>(handle >> uint64_t(32));
+        }
+
         struct BuilderCallbackData {
             bool Call(nxtBuilderErrorStatus status, const char* message) {
                 if (canCall && callback != nullptr) {
@@ -53,15 +86,19 @@ namespace wire {
         //* All non-Device objects of the client side have:
         //*  - A pointer to the device to get where to serialize commands
         //*  - The external reference count
-        //*  - An ID that is used to refer to this object when talking with the server side
+        //*  - A handle containing the ID that is used to refer to this object when talking with the server side
         struct ObjectBase {
-            ObjectBase(Device* device, uint32_t refcount, uint32_t id)
-                :device(device), refcount(refcount), id(id) {
+            ObjectBase(Device* device, uint32_t refcount, ObjectHandle handle)
+                :device(device), refcount(refcount), handle(handle) {
+            }
+
+            uint32_t GetId() const {
+                return GetObjectHandleId(handle);
             }
 
             Device* device;
             uint32_t refcount;
-            uint32_t id;
+            ObjectHandle handle;
 
             BuilderCallbackData builderCallback;
         };
@@ -69,6 +106,7 @@ namespace wire {
         {% set special_objects = [
             "device",
             "buffer",
+            "fence",
         ] %}
         {% for type in by_category["object"] if not type.name.canonical_case() in special_objects %}
             struct {{type.name.CamelCase()}} : ObjectBase {
@@ -79,15 +117,9 @@ namespace wire {
         struct Buffer : ObjectBase {
             using ObjectBase::ObjectBase;
 
-            ~Buffer() {
-                //* Callbacks need to be fired in all cases, as they can handle freeing resources
-                //* so we call them with "Unknown" status.
-                ClearMapRequests(NXT_BUFFER_MAP_READ_STATUS_UNKNOWN);
-
-                if (mappedData) {
-                    free(mappedData);
-                }
-            }
+            //* Defined after Device because they need to access the shared memory allocator.
+            ~Buffer();
+            void FreeMappedData();
 
             void ClearMapRequests(nxtBufferMapReadStatus status) {
                 for (auto& it : readRequests) {
@@ -103,72 +135,127 @@ namespace wire {
                 nxtBufferMapReadCallback callback = nullptr;
                 nxtCallbackUserdata userdata = 0;
                 uint32_t size = 0;
+                uint32_t sharedMemoryOffset = kNoSharedMemoryOffset;
             };
             std::map<uint32_t, MapReadRequestData> readRequests;
             uint32_t readRequestSerial = 0;
 
             //* Only one mapped pointer can be active at a time because Unmap clears all the in-flight requests.
+            //* It points either to malloced memory or to the shared memory.
             void* mappedData = nullptr;
+            uint32_t mappedSharedMemoryOffset = kNoSharedMemoryOffset;
+        };
+
+        struct Fence : ObjectBase {
+            using ObjectBase::ObjectBase;
+
+            ~Fence() {
+                //* Callbacks need to be fired in all cases, as they can handle freeing resources
+                //* so we call them with "Unknown" status.
+                for (auto& it : requests) {
+                    it.second.callback(NXT_FENCE_COMPLETION_STATUS_UNKNOWN, it.second.userdata);
+                }
+                requests.clear();
+            }
+
+            void CallCompletedRequests() {
+                //* Requests are removed before their callback is called as it can add new ones.
+                while (!requests.empty() && requests.begin()->first <= completedValue) {
+                    OnCompletionData request = requests.begin()->second;
+                    requests.erase(requests.begin());
+                    request.callback(NXT_FENCE_COMPLETION_STATUS_SUCCESS, request.userdata);
+                }
+            }
+
+            //* The values are tracked on the client so that GetCompletedValue doesn't need a
+            //* round trip. The server sends the completed value each time the fence reaches a
+            //* value it was signaled with.
+            struct OnCompletionData {
+                nxtFenceOnCompletionCallback callback = nullptr;
+                nxtCallbackUserdata userdata = 0;
+            };
+            std::multimap<uint64_t, OnCompletionData> requests;
+            uint64_t signaledValue = 0;
+            uint64_t completedValue = 0;
         };
 
         //* TODO(cwallez@chromium.org): Do something with objects before they are destroyed ?
         //*  - Call still uncalled builder callbacks
+        //* Objects are constructed in place in slabs that never move, so pointers given to the
+        //* application stay valid when slabs are added, and the slots of freed objects are reused
+        //* so creating objects doesn't allocate once enough slabs exist.
         template<typename T>
         class ObjectAllocator {
             public:
-                struct ObjectAndSerial {
-                    ObjectAndSerial(std::unique_ptr<T> object, uint32_t serial)
-                        : object(std::move(object)), serial(serial) {
-                    }
-                    std::unique_ptr<T> object;
-                    uint32_t serial;
-                };
-
                 ObjectAllocator(Device* device) : mDevice(device) {
-                    // ID 0 is nullptr
-                    mObjects.emplace_back(nullptr, 0);
                 }
 
-                ObjectAndSerial* New() {
-                    uint32_t id = GetNewId();
-                    T* result = new T(mDevice, 1, id);
-                    auto object = std::unique_ptr<T>(result);
+                ~ObjectAllocator() {
+                    for (uint32_t id = 1; id < mIdCount; id++) {
+                        Slot* slot = GetSlot(id);
+                        if (slot->handle != 0) {
+                            GetSlotObject(slot)->~T();
+                        }
+                    }
+                }
 
-                    if (id >= mObjects.size()) {
-                        ASSERT(id == mObjects.size());
-                        mObjects.emplace_back(std::move(object), 0);
-                    } else {
-                        ASSERT(mObjects[id].object == nullptr);
-                        //* TODO(cwallez@chromium.org): investigate if overflows could cause bad things to happen
-                        mObjects[id].serial++;
-                        mObjects[id].object = std::move(object);
+                T* New() {
+                    uint32_t id = GetNewId();
+                    if (id / kObjectSlabSize >= mSlabs.size()) {
+                        mSlabs.emplace_back(new Slot[kObjectSlabSize]);
                     }
 
-                    return &mObjects[id];
+                    Slot* slot = GetSlot(id);
+                    ASSERT(slot->handle == 0);
+                    slot->handle = MakeObjectHandle(id, slot->generation);
+                    return new (&slot->storage) T(mDevice, 1, slot->handle);
                 }
                 void Free(T* obj) {
-                    FreeId(obj->id);
-                    mObjects[obj->id].object = nullptr;
+                    uint32_t id = obj->GetId();
+                    Slot* slot = GetSlot(id);
+                    ASSERT(slot->handle == obj->handle);
+
+                    //* The generation wraps after 2^32 objects used the ID, a return command would
+                    //* need to be that late to be given to the wrong object.
+                    slot->handle = 0;
+                    slot->generation++;
+                    obj->~T();
+                    FreeId(id);
                 }
 
-                T* GetObject(uint32_t id) {
-                    if (id >= mObjects.size()) {
+                //* Returns nullptr if the object of the handle was freed, with a single compare
+                //* since freed slots have a null handle and reused slots a newer generation.
+                T* GetObject(ObjectHandle handle) {
+                    uint32_t id = GetObjectHandleId(handle);
+                    if (id == 0 || id >= mIdCount) {
                         return nullptr;
                     }
-                    return mObjects[id].object.get();
-                }
 
-                uint32_t GetSerial(uint32_t id) {
-                    if (id >= mObjects.size()) {
-                        return 0;
+                    Slot* slot = GetSlot(id);
+                    if (slot->handle != handle) {
+                        return nullptr;
                     }
-                    return mObjects[id].serial;
+                    return GetSlotObject(slot);
                 }
 
             private:
+                struct Slot {
+                    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+                    //* The handle of the object in the slot, 0 if the slot is free.
+                    ObjectHandle handle = 0;
+                    uint32_t generation = 0;
+                };
+
+                Slot* GetSlot(uint32_t id) {
+                    return &mSlabs[id / kObjectSlabSize][id % kObjectSlabSize];
+                }
+                static T* GetSlotObject(Slot* slot) {
+                    return reinterpret_cast<T*>(&slot->storage);
+                }
+
                 uint32_t GetNewId() {
                     if (mFreeIds.empty()) {
-                        return mCurrentId ++;
+                        return mIdCount ++;
                     }
                     uint32_t id = mFreeIds.back();
                     mFreeIds.pop_back();
@@ -179,9 +266,9 @@ namespace wire {
                 }
 
                 // 0 is an ID reserved to represent nullptr
-                uint32_t mCurrentId = 1;
+                uint32_t mIdCount = 1;
                 std::vector<uint32_t> mFreeIds;
-                std::vector<ObjectAndSerial> mObjects;
+                std::vector<std::unique_ptr<Slot[]>> mSlabs;
                 Device* mDevice;
         };
 
@@ -189,8 +276,9 @@ namespace wire {
         //* and the object id allocators.
         class Device : public ObjectBase {
             public:
-                Device(CommandSerializer* serializer)
-                    : ObjectBase(this, 1, 1),
+                Device(CommandSerializer* serializer, SharedMemory* sharedMemory)
+                    : ObjectBase(this, 1, MakeObjectHandle(1, 0)),
+                    sharedMemory(sharedMemory),
                     {% for type in by_category["object"] if not type.name.canonical_case() == "device" %}
                         {{type.name.camelCase()}}(this),
                     {% endfor %}
@@ -198,9 +286,66 @@ namespace wire {
                 }
 
                 void* GetCmdSpace(size_t size) {
+                    //* The recorded commands go before this one to keep the order of the calls.
+                    FlushRecording();
                     return mSerializer->GetCmdSpace(size);
                 }
 
+                //* Calls to recorded objects are gathered here instead of being serialized, and
+                //* sent in a single command when another command is serialized, which is usually
+                //* GetResult. Only one object is recorded at a time.
+                void* GetRecordingSpace(WireCmd encodedCmdId, uint32_t objectId, size_t size) {
+                    if (!mRecording.empty() &&
+                        (encodedCmdId != mRecordingCmdId || objectId != mRecordingObjectId ||
+                         mRecording.size() + size > kMaxRecordingSize)) {
+                        FlushRecording();
+                    }
+                    mRecordingCmdId = encodedCmdId;
+                    mRecordingObjectId = objectId;
+
+                    size_t offset = mRecording.size();
+                    mRecording.resize(offset + size);
+                    return &mRecording[offset];
+                }
+
+                //* Sends the calls being recorded along with the other commands.
+                void Flush() {
+                    FlushRecording();
+                    mSerializer->Flush();
+                }
+
+                void FlushRecording() {
+                    if (mRecording.empty()) {
+                        return;
+                    }
+
+                    switch (mRecordingCmdId) {
+                        {% for type in by_category["object"] if type.is_recorded %}
+                            case WireCmd::{{type.name.CamelCase()}}Encoded:
+                                SerializeRecording<{{type.name.CamelCase()}}EncodedCmd>();
+                                break;
+                        {% endfor %}
+                        default:
+                            UNREACHABLE();
+                    }
+                    mRecording.clear();
+                }
+
+                //* Returns where to put bulk data in the shared memory, or kNoSharedMemoryOffset if
+                //* it should be sent in the command stream. The space is freed when the server tells
+                //* us it consumed the data.
+                uint32_t AllocateBulkData(size_t size) {
+                    if (sharedMemoryAllocator == nullptr || size < kMinBulkDataSize ||
+                        size > std::numeric_limits<uint32_t>::max()) {
+                        return kNoSharedMemoryOffset;
+                    }
+                    return sharedMemoryAllocator->Allocate(static_cast<uint32_t>(size));
+                }
+
+                //* Declared before the object allocators so that it outlives the buffers.
+                SharedMemory* sharedMemory = nullptr;
+                std::unique_ptr<SharedMemoryAllocator> sharedMemoryAllocator;
+
                 {% for type in by_category["object"] if not type.name.canonical_case() == "device" %}
                     ObjectAllocator<{{type.name.CamelCase()}}> {{type.name.camelCase()}};
                 {% endfor %}
@@ -215,9 +360,41 @@ namespace wire {
                 nxtCallbackUserdata errorUserdata;
 
             private:
-               CommandSerializer* mSerializer = nullptr;
+                template <typename T>
+                void SerializeRecording() {
+                    T cmd;
+                    cmd.self = mRecordingObjectId;
+                    cmd.commandsSize = static_cast<uint32_t>(mRecording.size());
+
+                    auto allocCmd = reinterpret_cast<T*>(mSerializer->GetCmdSpace(cmd.GetRequiredSize()));
+                    *allocCmd = cmd;
+                    memcpy(allocCmd + 1, mRecording.data(), mRecording.size());
+                }
+
+                CommandSerializer* mSerializer = nullptr;
+
+                WireCmd mRecordingCmdId;
+                uint32_t mRecordingObjectId = 0;
+                std::vector<uint8_t> mRecording;
         };
 
+        Buffer::~Buffer() {
+            //* Callbacks need to be fired in all cases, as they can handle freeing resources
+            //* so we call them with "Unknown" status.
+            ClearMapRequests(NXT_BUFFER_MAP_READ_STATUS_UNKNOWN);
+            FreeMappedData();
+        }
+
+        void Buffer::FreeMappedData() {
+            if (mappedSharedMemoryOffset != kNoSharedMemoryOffset) {
+                device->sharedMemoryAllocator->Free(mappedSharedMemoryOffset);
+                mappedSharedMemoryOffset = kNoSharedMemoryOffset;
+            } else if (mappedData) {
+                free(mappedData);
+            }
+            mappedData = nullptr;
+        }
+
         //* Implementation of the client API functions.
         {% for type in by_category["object"] %}
             {% set Type = type.name.CamelCase() %}
@@ -240,23 +417,34 @@ namespace wire {
                         //* Value objects are stored as IDs
                         {% for arg in method.arguments if arg.annotation == "value" %}
                             {% if arg.type.category == "object" %}
-                                cmd.{{as_varName(arg.name)}} = {{as_varName(arg.name)}}->id;
+                                cmd.{{as_varName(arg.name)}} = {{as_varName(arg.name)}}->GetId();
                             {% else %}
                                 cmd.{{as_varName(arg.name)}} = {{as_varName(arg.name)}};
                             {% endif %}
                         {% endfor %}
 
-                        cmd.self = self->id;
+                        cmd.self = self->GetId();
 
                         //* The length of const char* is considered a value argument.
                         {% for arg in method.arguments if arg.length == "strlen" %}
                             cmd.{{as_varName(arg.name)}}Strlen = strlen({{as_varName(arg.name)}});
                         {% endfor %}
+
+                        //* Where bulk data goes changes the size of the command.
+                        {% for arg in method.arguments if arg.is_bulk %}
+                            cmd.{{as_varName(arg.name)}}SharedMemoryOffset = device->AllocateBulkData({{as_varName(arg.length.name)}} * sizeof(*{{as_varName(arg.name)}}));
+                        {% endfor %}
                     }
 
-                    //* Allocate space to send the command and copy the value args over.
+                    //* Allocate space to send the command and copy the value args over. Calls to
+                    //* recorded objects that don't create objects are recorded instead.
                     size_t requiredSize = cmd.GetRequiredSize();
-                    auto allocCmd = reinterpret_cast<decltype(cmd)*>(device->GetCmdSpace(requiredSize));
+                    {% if type.is_recorded and method.return_type.category != "object" %}
+                        void* cmdSpace = device->GetRecordingSpace(WireCmd::{{type.name.CamelCase()}}Encoded, self->GetId(), requiredSize);
+                    {% else %}
+                        void* cmdSpace = device->GetCmdSpace(requiredSize);
+                    {% endif %}
+                    auto allocCmd = reinterpret_cast<decltype(cmd)*>(cmdSpace);
                     *allocCmd = cmd;
 
                     //* In the allocated space, write the non-value arguments.
@@ -267,7 +455,14 @@ namespace wire {
                         {% elif arg.type.category == "object" %}
                             auto {{argName}}Storage = reinterpret_cast<uint32_t*>(allocCmd->GetPtr_{{argName}}());
                             for (size_t i = 0; i < {{as_varName(arg.length.name)}}; i++) {
-                                {{argName}}Storage[i] = {{argName}}[i]->id;
+                                {{argName}}Storage[i] = {{argName}}[i]->GetId();
+                            }
+                        {% elif arg.is_bulk %}
+                            if (allocCmd->{{argName}}SharedMemoryOffset != kNoSharedMemoryOffset) {
+                                uint8_t* {{argName}}Storage = device->sharedMemory->GetData() + allocCmd->{{argName}}SharedMemoryOffset;
+                                memcpy({{argName}}Storage, {{argName}}, {{as_varName(arg.length.name)}} * sizeof(*{{argName}}));
+                            } else {
+                                memcpy(allocCmd->GetPtr_{{argName}}(), {{argName}}, {{as_varName(arg.length.name)}} * sizeof(*{{argName}}));
                             }
                         {% else %}
                             memcpy(allocCmd->GetPtr_{{argName}}(), {{argName}}, {{as_varName(arg.length.name)}} * sizeof(*{{argName}}));
@@ -282,13 +477,13 @@ namespace wire {
                             //* We are in GetResult, so the callback that should be called is the
                             //* currently set one. Copy it over to the created object and prevent the
                             //* builder from calling the callback on destruction.
-                            allocation->object->builderCallback = self->builderCallback;
+                            allocation->builderCallback = self->builderCallback;
                             self->builderCallback.canCall = false;
                         {% endif %}
 
-                        allocCmd->resultId = allocation->object->id;
-                        allocCmd->resultSerial = allocation->serial;
-                        return allocation->object.get();
+                        allocCmd->resultId = allocation->GetId();
+                        allocCmd->resultSerial = GetObjectHandleGeneration(allocation->handle);
+                        return allocation;
                     {% endif %}
                 }
             {% endfor %}
@@ -316,7 +511,7 @@ namespace wire {
                     obj->builderCallback.Call(NXT_BUILDER_ERROR_STATUS_UNKNOWN, "Unknown");
 
                     wire::{{as_MethodSuffix(type.name, Name("destroy"))}}Cmd cmd;
-                    cmd.objectId = obj->id;
+                    cmd.objectId = obj->GetId();
 
                     size_t requiredSize = cmd.GetRequiredSize();
                     auto allocCmd = reinterpret_cast<decltype(cmd)*>(obj->device->GetCmdSpace(requiredSize));
@@ -339,13 +534,20 @@ namespace wire {
             request.callback = callback;
             request.userdata = userdata;
             request.size = size;
+
+            //* Reserve space for the server to write the data in, the allocation is freed when the
+            //* result of the request comes back or, on success, when the buffer gets unmapped.
+            if (buffer->device->sharedMemoryAllocator != nullptr) {
+                request.sharedMemoryOffset = buffer->device->sharedMemoryAllocator->Allocate(size);
+            }
             buffer->readRequests[serial] = request;
 
             wire::BufferMapReadAsyncCmd cmd;
-            cmd.bufferId = buffer->id;
+            cmd.bufferId = buffer->GetId();
             cmd.requestSerial = serial;
             cmd.start = start;
             cmd.size = size;
+            cmd.sharedMemoryOffset = request.sharedMemoryOffset;
 
             size_t requiredSize = cmd.GetRequiredSize();
             auto allocCmd = reinterpret_cast<decltype(cmd)*>(buffer->device->GetCmdSpace(requiredSize));
@@ -360,15 +562,53 @@ namespace wire {
             //*  - Server -> Client: Result of MapRequest1
             //*  - Unmap locally on the client
             //*  - Server -> Client: Result of MapRequest2
-            if (buffer->mappedData) {
-                free(buffer->mappedData);
-                buffer->mappedData = nullptr;
-            }
+            buffer->FreeMappedData();
             buffer->ClearMapRequests(NXT_BUFFER_MAP_READ_STATUS_UNKNOWN);
 
             ClientBufferUnmap(buffer);
         }
 
+        uint64_t ClientFenceGetCompletedValue(Fence* fence) {
+            return fence->completedValue;
+        }
+
+        void ClientFenceOnCompletion(Fence* fence, uint64_t value, nxtFenceOnCompletionCallback callback, nxtCallbackUserdata userdata) {
+            if (value > fence->signaledValue) {
+                fence->device->HandleError("Value greater than fence signaled value");
+                callback(NXT_FENCE_COMPLETION_STATUS_ERROR, userdata);
+                return;
+            }
+
+            if (value <= fence->completedValue) {
+                callback(NXT_FENCE_COMPLETION_STATUS_SUCCESS, userdata);
+                return;
+            }
+
+            Fence::OnCompletionData request;
+            request.callback = callback;
+            request.userdata = userdata;
+            fence->requests.emplace(value, request);
+        }
+
+        void ProxyClientQueueSignal(Queue* queue, Fence* fence, uint64_t value) {
+            ClientQueueSignal(queue, fence, value);
+
+            //* Invalid signals are reported by the server, they don't change the fence.
+            if (value <= fence->signaledValue) {
+                return;
+            }
+            fence->signaledValue = value;
+
+            //* Ask the server to tell us when the fence reaches the value.
+            wire::FenceOnCompletionCmd cmd;
+            cmd.fenceId = fence->GetId();
+            cmd.value = value;
+
+            size_t requiredSize = cmd.GetRequiredSize();
+            auto allocCmd = reinterpret_cast<decltype(cmd)*>(fence->device->GetCmdSpace(requiredSize));
+            *allocCmd = cmd;
+        }
+
         void ClientDeviceReference(Device*) {
         }
 
@@ -385,7 +625,7 @@ namespace wire {
         //  - An autogenerated Client{{suffix}} method that sends the command on the wire
         //  - A manual ProxyClient{{suffix}} method that will be inserted in the proctable instead of
         //    the autogenerated one, and that will have to call Client{{suffix}}
-        {% set proxied_commands = ["BufferUnmap"] %}
+        {% set proxied_commands = ["BufferUnmap", "QueueSignal"] %}
 
         nxtProcTable GetProcs() {
             nxtProcTable table;
@@ -408,6 +648,7 @@ namespace wire {
                 }
 
                 const uint8_t* HandleCommands(const uint8_t* commands, size_t size) override {
+                    NXT_TRACE_EVENT("wire", "Client::HandleCommands");
                     while (size > sizeof(ReturnWireCmd)) {
                         ReturnWireCmd cmdId = *reinterpret_cast<const ReturnWireCmd*>(commands);
 
@@ -424,6 +665,12 @@ namespace wire {
                             case ReturnWireCmd::BufferMapReadAsyncCallback:
                                 success = HandleBufferMapReadAsyncCallback(&commands, &size);
                                 break;
+                            case ReturnWireCmd::BulkDataConsumed:
+                                success = HandleBulkDataConsumed(&commands, &size);
+                                break;
+                            case ReturnWireCmd::FenceUpdateCompletedValue:
+                                success = HandleFenceUpdateCompletedValue(&commands, &size);
+                                break;
                             default:
                                 success = false;
                         }
@@ -440,6 +687,10 @@ namespace wire {
                     return commands;
                 }
 
+                Device* GetDevice() const {
+                    return mDevice;
+                }
+
             private:
                 Device* mDevice = nullptr;
 
@@ -492,11 +743,10 @@ namespace wire {
                             return false;
                         }
 
-                        auto* builtObject = mDevice->{{type.built_type.name.camelCase()}}.GetObject(cmd->builtObjectId);
-                        uint32_t objectSerial = mDevice->{{type.built_type.name.camelCase()}}.GetSerial(cmd->builtObjectId);
-
                         //* The object might have been deleted or a new object created with the same ID.
-                        if (builtObject == nullptr || objectSerial != cmd->builtObjectSerial) {
+                        ObjectHandle handle = MakeObjectHandle(cmd->builtObjectId, cmd->builtObjectSerial);
+                        auto* builtObject = mDevice->{{type.built_type.name.camelCase()}}.GetObject(handle);
+                        if (builtObject == nullptr) {
                             return true;
                         }
 
@@ -517,11 +767,65 @@ namespace wire {
                         return false;
                     }
 
-                    auto* buffer = mDevice->buffer.GetObject(cmd->bufferId);
-                    uint32_t bufferSerial = mDevice->buffer.GetSerial(cmd->bufferId);
+                    //* Each request gets exactly one answer so the shared memory space of the request
+                    //* can be reclaimed now, unless it became the mapped data of the buffer.
+                    uint32_t sharedMemoryOffset = cmd->sharedMemoryOffset;
+                    if (sharedMemoryOffset != kNoSharedMemoryOffset &&
+                        (mDevice->sharedMemoryAllocator == nullptr ||
+                         !mDevice->sharedMemoryAllocator->IsAllocated(sharedMemoryOffset))) {
+                        return false;
+                    }
 
+                    bool isSharedMemoryMapped = false;
+                    bool success = CompleteMapReadRequest(cmd, &isSharedMemoryMapped);
+
+                    if (sharedMemoryOffset != kNoSharedMemoryOffset && !isSharedMemoryMapped) {
+                        mDevice->sharedMemoryAllocator->Free(sharedMemoryOffset);
+                    }
+                    return success;
+                }
+
+                bool HandleBulkDataConsumed(const uint8_t** commands, size_t* size) {
+                    const auto* cmd = GetCommand<ReturnBulkDataConsumedCmd>(commands, size);
+                    if (cmd == nullptr) {
+                        return false;
+                    }
+
+                    if (mDevice->sharedMemoryAllocator == nullptr ||
+                        !mDevice->sharedMemoryAllocator->IsAllocated(cmd->sharedMemoryOffset)) {
+                        return false;
+                    }
+
+                    mDevice->sharedMemoryAllocator->Free(cmd->sharedMemoryOffset);
+                    return true;
+                }
+
+                bool HandleFenceUpdateCompletedValue(const uint8_t** commands, size_t* size) {
+                    const auto* cmd = GetCommand<ReturnFenceUpdateCompletedValueCmd>(commands, size);
+                    if (cmd == nullptr) {
+                        return false;
+                    }
+
+                    //* The fence might have been deleted or recreated so this isn't an error.
+                    auto* fence = mDevice->fence.GetObject(MakeObjectHandle(cmd->fenceId, cmd->fenceSerial));
+                    if (fence == nullptr) {
+                        return true;
+                    }
+
+                    //* The server only sends values the client signaled the fence with.
+                    if (cmd->value > fence->signaledValue) {
+                        return false;
+                    }
+
+                    fence->completedValue = std::max(fence->completedValue, cmd->value);
+                    fence->CallCompletedRequests();
+                    return true;
+                }
+
+                bool CompleteMapReadRequest(const ReturnBufferMapReadAsyncCallbackCmd* cmd, bool* isSharedMemoryMapped) {
                     //* The buffer might have been deleted or recreated so this isn't an error.
-                    if (buffer == nullptr || bufferSerial != cmd->bufferSerial) {
+                    auto* buffer = mDevice->buffer.GetObject(MakeObjectHandle(cmd->bufferId, cmd->bufferSerial));
+                    if (buffer == nullptr) {
                         return true;
                     }
 
@@ -533,20 +837,33 @@ namespace wire {
 
                     auto request = requestIt->second;
 
-                    //* On success, we copy the data locally because the IPC buffer isn't valid outside of this function
+                    //* On success, the data is either in the shared memory where it can be used
+                    //* directly, or we copy it locally because the IPC buffer isn't valid outside of this function
                     if (cmd->status == NXT_BUFFER_MAP_READ_STATUS_SUCCESS) {
-
-                        //* The server didn't send the right amount of data, this is an error and could cause
-                        //* the application to crash if we did call the callback.
-                        if (request.size != cmd->dataLength) {
+                        if (buffer->mappedData != nullptr) {
                             return false;
                         }
 
-                        if (buffer->mappedData != nullptr) {
-                            return false;
+                        if (cmd->isDataInSharedMemory) {
+                            //* The server must have written where this request asked it to.
+                            if (cmd->sharedMemoryOffset == kNoSharedMemoryOffset ||
+                                cmd->sharedMemoryOffset != request.sharedMemoryOffset) {
+                                return false;
+                            }
+
+                            buffer->mappedData = mDevice->sharedMemory->GetData() + cmd->sharedMemoryOffset;
+                            buffer->mappedSharedMemoryOffset = cmd->sharedMemoryOffset;
+                            *isSharedMemoryMapped = true;
+                        } else {
+                            //* The server didn't send the right amount of data, this is an error and could cause
+                            //* the application to crash if we did call the callback.
+                            if (request.size != cmd->dataLength) {
+                                return false;
+                            }
+
+                            buffer->mappedData = malloc(request.size);
+                            memcpy(buffer->mappedData, cmd->GetData(), request.size);
                         }
-                        buffer->mappedData = malloc(request.size);
-                        memcpy(buffer->mappedData, cmd->GetData(), request.size);
 
                         request.callback(static_cast<nxtBufferMapReadStatus>(cmd->status), buffer->mappedData, request.userdata);
                     } else {
@@ -560,8 +877,11 @@ namespace wire {
 
     }
 
-    CommandHandler* NewClientDevice(nxtProcTable* procs, nxtDevice* device, CommandSerializer* serializer) {
-        auto clientDevice = new client::Device(serializer);
+    CommandHandler* NewClientDevice(nxtProcTable* procs, nxtDevice* device, CommandSerializer* serializer, SharedMemory* sharedMemory) {
+        auto clientDevice = new client::Device(serializer, sharedMemory);
+        if (sharedMemory != nullptr) {
+            clientDevice->sharedMemoryAllocator.reset(new SharedMemoryAllocator(sharedMemory->GetSize()));
+        }
 
         *device = reinterpret_cast<nxtDeviceImpl*>(clientDevice);
         *procs = client::GetProcs();
@@ -569,5 +889,9 @@ namespace wire {
         return new client::Client(clientDevice);
     }
 
+    void ClientFlush(CommandHandler* client) {
+        static_cast<client::Client*>(client)->GetDevice()->Flush();
+    }
+
 }
 }
@@ -12,11 +12,45 @@
 //* See the License for the specific language governing permissions and
 //* limitations under the License.
 
-#include "wire/WireCmd_autogen.h"
+#include "wire/CompactEncoding.h"
+#include "wire/WireCmd.h"
+
+#include <limits>
 
 namespace nxt {
 namespace wire {
 
+    //* Helpers to generate the compact encoding of a member with the right CompactWriter or
+    //* CompactReader method.
+    {% macro compact_member(operation, member) %}
+        {% if operation == "Encode" %}
+            writer->Write({{member}});
+        {% else %}
+            reader->Read(&{{member}});
+        {% endif %}
+    {% endmacro %}
+    {% macro compact_enum(operation, member) %}
+        {% if operation == "Encode" %}
+            writer->WriteEnum({{member}});
+        {% else %}
+            reader->ReadEnum(&{{member}});
+        {% endif %}
+    {% endmacro %}
+    {% macro compact_size(operation, member) %}
+        {% if operation == "Encode" %}
+            writer->WriteSize({{member}});
+        {% else %}
+            reader->ReadSize(&{{member}});
+        {% endif %}
+    {% endmacro %}
+    {% macro compact_id(operation, member) %}
+        {% if operation == "Encode" %}
+            writer->WriteId({{member}});
+        {% else %}
+            reader->ReadId(&{{member}});
+        {% endif %}
+    {% endmacro %}
+
     {% for type in by_category["object"] %}
         {% for method in type.methods %}
             {% set Suffix = as_MethodSuffix(type.name, method.name) %}
@@ -25,7 +59,11 @@ namespace wire {
                 size_t result = sizeof(*this);
 
                 {% for arg in method.arguments if arg.annotation != "value" %}
-                    {% if arg.length == "strlen" %}
+                    {% if arg.is_bulk %}
+                        if ({{as_varName(arg.name)}}SharedMemoryOffset == kNoSharedMemoryOffset) {
+                            result += {{as_varName(arg.length.name)}} * sizeof({{as_cType(arg.type.name)}});
+                        }
+                    {% elif arg.length == "strlen" %}
                         result += {{as_varName(arg.name)}}Strlen + 1;
                     {% elif arg.type.category == "object" %}
                         result += {{as_varName(arg.length.name)}} * sizeof(uint32_t);
@@ -51,7 +89,11 @@ namespace wire {
                             {% if get_arg == arg %}
                                 return ptr;
                             {% endif %}
-                            {% if arg.length == "strlen" %}
+                            {% if arg.is_bulk %}
+                                if ({{as_varName(arg.name)}}SharedMemoryOffset == kNoSharedMemoryOffset) {
+                                    ptr += {{as_varName(arg.length.name)}} * sizeof({{as_cType(arg.type.name)}});
+                                }
+                            {% elif arg.length == "strlen" %}
                                 ptr += {{as_varName(arg.name)}}Strlen + 1;
                             {% elif arg.type.category == "object" %}
                                 ptr += {{as_varName(arg.length.name)}} * sizeof(uint32_t);
@@ -63,14 +105,294 @@ namespace wire {
 
                 {% endfor %}
             {% endfor %}
+
+            {% for operation in ["Encode", "Decode"] %}
+                {% if operation == "Encode" %}
+                    void {{Suffix}}Cmd::Encode(CompactWriter* writer) const {
+                {% else %}
+                    void {{Suffix}}Cmd::Decode(CompactReader* reader) {
+                {% endif %}
+                    {{compact_id(operation, "self")}}
+                    {% if method.return_type.category == "object" %}
+                        {{compact_id(operation, "resultId")}}
+                        {{compact_member(operation, "resultSerial")}}
+                    {% endif %}
+                    {% for arg in method.arguments if arg.annotation == "value" %}
+                        {% set member = as_varName(arg.name) %}
+                        {% if arg.type.category == "object" %}
+                            {{compact_id(operation, member)}}
+                        {% elif arg.type.category in ["enum", "bitmask"] %}
+                            {{compact_enum(operation, member)}}
+                        {% else %}
+                            {{compact_member(operation, member)}}
+                        {% endif %}
+                    {% endfor %}
+                    {% for arg in method.arguments if arg.length == "strlen" %}
+                        {{compact_size(operation, as_varName(arg.name) + "Strlen")}}
+                    {% endfor %}
+                    {% for arg in method.arguments if arg.is_bulk %}
+                        {{compact_member(operation, as_varName(arg.name) + "SharedMemoryOffset")}}
+                    {% endfor %}
+                }
+            {% endfor %}
         {% endfor %}
 
         {% set Suffix = as_MethodSuffix(type.name, Name("destroy")) %}
         size_t {{Suffix}}Cmd::GetRequiredSize() const {
             return sizeof(*this);
         }
+
+        void {{Suffix}}Cmd::Encode(CompactWriter* writer) const {
+            {{compact_id("Encode", "objectId")}}
+        }
+
+        void {{Suffix}}Cmd::Decode(CompactReader* reader) {
+            {{compact_id("Decode", "objectId")}}
+        }
     {% endfor %}
 
+    {% for type in by_category["object"] if type.is_recorded %}
+        {% set Type = type.name.CamelCase() %}
+        size_t {{Type}}EncodedCmd::GetRequiredSize() const {
+            return sizeof(*this) + commandsSize;
+        }
+
+        const uint8_t* {{Type}}EncodedCmd::GetCommands() const {
+            return reinterpret_cast<const uint8_t*>(this + 1);
+        }
+    {% endfor %}
+
+    namespace {
+
+        bool IsRecordingCmd(WireCmd cmdId) {
+            switch (cmdId) {
+                {% for type in by_category["object"] if type.is_recorded %}
+                    case WireCmd::{{type.name.CamelCase()}}Encoded:
+                {% endfor %}
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        bool DecodeCompactCommandWithId(WireCmd cmdId, CompactReader* reader, std::vector<uint8_t>* commands);
+
+        //* The recorded commands are encoded one by one like the other commands, after the ID of
+        //* the recorded object and their number, so that they get the varint and delta-encoded
+        //* IDs too. Recordings can't be nested.
+        template <typename T>
+        bool EncodeCompactRecordingCmd(const uint8_t** commands, size_t* size, CompactWriter* writer) {
+            if (*size < sizeof(T)) {
+                return false;
+            }
+
+            const T* cmd = reinterpret_cast<const T*>(*commands);
+            size_t cmdSize = cmd->GetRequiredSize();
+            if (*size < cmdSize) {
+                return false;
+            }
+
+            //* Validate the recorded commands before writing anything, so that encoding them below
+            //* can't fail.
+            uint32_t recordedCount = 0;
+            const uint8_t* recorded = cmd->GetCommands();
+            size_t recordedSize = cmd->commandsSize;
+            while (recordedSize > 0) {
+                size_t recordedCmdSize = GetWireCmdSize(recorded, recordedSize);
+                if (recordedCmdSize == 0 || IsRecordingCmd(*reinterpret_cast<const WireCmd*>(recorded))) {
+                    return false;
+                }
+                recorded += recordedCmdSize;
+                recordedSize -= recordedCmdSize;
+                recordedCount++;
+            }
+
+            writer->WriteEnum(cmd->commandId);
+            writer->WriteId(cmd->self);
+            writer->Write(recordedCount);
+
+            recorded = cmd->GetCommands();
+            recordedSize = cmd->commandsSize;
+            while (recordedSize > 0) {
+                if (!EncodeCompactCommand(&recorded, &recordedSize, writer)) {
+                    return false;
+                }
+            }
+
+            *commands += cmdSize;
+            *size -= cmdSize;
+            return true;
+        }
+
+        template <typename T>
+        bool DecodeCompactRecordingCmd(CompactReader* reader, std::vector<uint8_t>* commands) {
+            T cmd;
+            uint32_t recordedCount = 0;
+            reader->ReadId(&cmd.self);
+            reader->Read(&recordedCount);
+            if (!reader->IsValid()) {
+                return false;
+            }
+
+            //* The recorded commands are decoded after the structure, which is written once their
+            //* size is known.
+            size_t offset = commands->size();
+            commands->resize(offset + sizeof(T));
+            for (uint32_t i = 0; i < recordedCount; ++i) {
+                WireCmd cmdId;
+                reader->ReadEnum(&cmdId);
+                if (!reader->IsValid() || IsRecordingCmd(cmdId) ||
+                    !DecodeCompactCommandWithId(cmdId, reader, commands)) {
+                    return false;
+                }
+            }
+
+            size_t recordedSize = commands->size() - offset - sizeof(T);
+            if (recordedSize > std::numeric_limits<uint32_t>::max()) {
+                return false;
+            }
+            cmd.commandsSize = static_cast<uint32_t>(recordedSize);
+            memcpy(&(*commands)[offset], &cmd, sizeof(T));
+            return true;
+        }
+
+    }
+
+    bool EncodeCompactCommand(const uint8_t** commands, size_t* size, CompactWriter* writer) {
+        if (*size < sizeof(WireCmd)) {
+            return false;
+        }
+
+        WireCmd cmdId = *reinterpret_cast<const WireCmd*>(*commands);
+        switch (cmdId) {
+            {% for type in by_category["object"] %}
+                {% for method in type.methods %}
+                    {% set Suffix = as_MethodSuffix(type.name, method.name) %}
+                    case WireCmd::{{Suffix}}:
+                        return EncodeCompactCmd<{{Suffix}}Cmd>(commands, size, writer);
+                {% endfor %}
+                {% set Suffix = as_MethodSuffix(type.name, Name("destroy")) %}
+                case WireCmd::{{Suffix}}:
+                    return EncodeCompactCmd<{{Suffix}}Cmd>(commands, size, writer);
+            {% endfor %}
+            case WireCmd::BufferMapReadAsync:
+                return EncodeCompactCmd<BufferMapReadAsyncCmd>(commands, size, writer);
+            case WireCmd::FenceOnCompletion:
+                return EncodeCompactCmd<FenceOnCompletionCmd>(commands, size, writer);
+            {% for type in by_category["object"] if type.is_recorded %}
+                case WireCmd::{{type.name.CamelCase()}}Encoded:
+                    return EncodeCompactRecordingCmd<{{type.name.CamelCase()}}EncodedCmd>(commands, size, writer);
+            {% endfor %}
+            default:
+                return false;
+        }
+    }
+
+    namespace {
+        bool DecodeCompactCommandWithId(WireCmd cmdId, CompactReader* reader, std::vector<uint8_t>* commands) {
+            switch (cmdId) {
+                {% for type in by_category["object"] %}
+                    {% for method in type.methods %}
+                        {% set Suffix = as_MethodSuffix(type.name, method.name) %}
+                        case WireCmd::{{Suffix}}:
+                            return DecodeCompactCmd<{{Suffix}}Cmd>(reader, commands);
+                    {% endfor %}
+                    {% set Suffix = as_MethodSuffix(type.name, Name("destroy")) %}
+                    case WireCmd::{{Suffix}}:
+                        return DecodeCompactCmd<{{Suffix}}Cmd>(reader, commands);
+                {% endfor %}
+                case WireCmd::BufferMapReadAsync:
+                    return DecodeCompactCmd<BufferMapReadAsyncCmd>(reader, commands);
+                case WireCmd::FenceOnCompletion:
+                    return DecodeCompactCmd<FenceOnCompletionCmd>(reader, commands);
+                {% for type in by_category["object"] if type.is_recorded %}
+                    case WireCmd::{{type.name.CamelCase()}}Encoded:
+                        return DecodeCompactRecordingCmd<{{type.name.CamelCase()}}EncodedCmd>(reader, commands);
+                {% endfor %}
+                default:
+                    return false;
+            }
+        }
+    }
+
+    bool DecodeCompactCommand(CompactReader* reader, std::vector<uint8_t>* commands) {
+        WireCmd cmdId;
+        reader->ReadEnum(&cmdId);
+        if (!reader->IsValid()) {
+            return false;
+        }
+        return DecodeCompactCommandWithId(cmdId, reader, commands);
+    }
+
+    namespace {
+        template <typename T>
+        size_t GetCmdSize(const uint8_t* commands, size_t size) {
+            if (size < sizeof(T)) {
+                return 0;
+            }
+            size_t cmdSize = reinterpret_cast<const T*>(commands)->GetRequiredSize();
+            if (size < cmdSize) {
+                return 0;
+            }
+            return cmdSize;
+        }
+    }
+
+    const char* GetWireCmdName(WireCmd cmdId) {
+        switch (cmdId) {
+            {% for type in by_category["object"] %}
+                {% for method in type.methods %}
+                    {% set Suffix = as_MethodSuffix(type.name, method.name) %}
+                    case WireCmd::{{Suffix}}:
+                        return "{{Suffix}}";
+                {% endfor %}
+                {% set Suffix = as_MethodSuffix(type.name, Name("destroy")) %}
+                case WireCmd::{{Suffix}}:
+                    return "{{Suffix}}";
+            {% endfor %}
+            case WireCmd::BufferMapReadAsync:
+                return "BufferMapReadAsync";
+            case WireCmd::FenceOnCompletion:
+                return "FenceOnCompletion";
+            {% for type in by_category["object"] if type.is_recorded %}
+                case WireCmd::{{type.name.CamelCase()}}Encoded:
+                    return "{{type.name.CamelCase()}}Encoded";
+            {% endfor %}
+            default:
+                return "Unknown";
+        }
+    }
+
+    size_t GetWireCmdSize(const uint8_t* commands, size_t size) {
+        if (size < sizeof(WireCmd)) {
+            return 0;
+        }
+
+        WireCmd cmdId = *reinterpret_cast<const WireCmd*>(commands);
+        switch (cmdId) {
+            {% for type in by_category["object"] %}
+                {% for method in type.methods %}
+                    {% set Suffix = as_MethodSuffix(type.name, method.name) %}
+                    case WireCmd::{{Suffix}}:
+                        return GetCmdSize<{{Suffix}}Cmd>(commands, size);
+                {% endfor %}
+                {% set Suffix = as_MethodSuffix(type.name, Name("destroy")) %}
+                case WireCmd::{{Suffix}}:
+                    return GetCmdSize<{{Suffix}}Cmd>(commands, size);
+            {% endfor %}
+            case WireCmd::BufferMapReadAsync:
+                return GetCmdSize<BufferMapReadAsyncCmd>(commands, size);
+            case WireCmd::FenceOnCompletion:
+                return GetCmdSize<FenceOnCompletionCmd>(commands, size);
+            {% for type in by_category["object"] if type.is_recorded %}
+                case WireCmd::{{type.name.CamelCase()}}Encoded:
+                    return GetCmdSize<{{type.name.CamelCase()}}EncodedCmd>(commands, size);
+            {% endfor %}
+            default:
+                return 0;
+        }
+    }
+
     {% for type in by_category["object"] if type.is_builder %}
         {% set Type = type.name.CamelCase() %}
         size_t Return{{Type}}ErrorCallbackCmd::GetRequiredSize() const {
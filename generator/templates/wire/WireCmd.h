@@ -20,6 +20,9 @@
 namespace nxt {
 namespace wire {
 
+    class CompactReader;
+    class CompactWriter;
+
     //* Enum used as a prefix to each command on the wire format.
     enum class WireCmd : uint32_t {
         {% for type in by_category["object"] %}
@@ -29,6 +32,10 @@ namespace wire {
             {{as_MethodSuffix(type.name, Name("destroy"))}},
         {% endfor %}
         BufferMapReadAsync,
+        FenceOnCompletion,
+        {% for type in by_category["object"] if type.is_recorded %}
+            {{type.name.CamelCase()}}Encoded,
+        {% endfor %}
     };
 
     {% for type in by_category["object"] %}
@@ -67,6 +74,12 @@ namespace wire {
                     size_t {{as_varName(arg.name)}}Strlen;
                 {% endfor %}
 
+                //* Bulk arrays are either in the shared memory at this offset, or after the structure
+                //* like other non-value parameters when it is kNoSharedMemoryOffset.
+                {% for arg in method.arguments if arg.is_bulk %}
+                    uint32_t {{as_varName(arg.name)}}SharedMemoryOffset;
+                {% endfor %}
+
                 //* The following commands do computation, provided the members for value parameters
                 //* have been initialized.
 
@@ -79,6 +92,11 @@ namespace wire {
                     uint8_t* GetPtr_{{ArgName}}();
                     const uint8_t* GetPtr_{{ArgName}}() const;
                 {% endfor %}
+
+                //* Write or read the members of the structure in the compact encoding, see
+                //* wire/CompactEncoding.h
+                void Encode(CompactWriter* writer) const;
+                void Decode(CompactReader* reader);
             };
         {% endfor %}
 
@@ -89,10 +107,32 @@ namespace wire {
             uint32_t objectId;
 
             size_t GetRequiredSize() const;
+            void Encode(CompactWriter* writer) const;
+            void Decode(CompactReader* reader);
         };
 
     {% endfor %}
 
+    {% for type in by_category["object"] if type.is_recorded %}
+        //* The calls to a recorded object that were gathered on the client side. They are the
+        //* usual commands, minus the ones creating objects, stored after the structure.
+        struct {{type.name.CamelCase()}}EncodedCmd {
+            WireCmd commandId = WireCmd::{{type.name.CamelCase()}}Encoded;
+            uint32_t self;
+            uint32_t commandsSize;
+
+            size_t GetRequiredSize() const;
+            const uint8_t* GetCommands() const;
+        };
+    {% endfor %}
+
+    //* Returns the name of the command, for tools looking at command streams.
+    const char* GetWireCmdName(WireCmd cmdId);
+
+    //* Returns the size of the command at the start of commands, or 0 if it isn't a valid command
+    //* or doesn't fit in size.
+    size_t GetWireCmdSize(const uint8_t* commands, size_t size);
+
     //* Enum used as a prefix to each command on the return wire format.
     enum class ReturnWireCmd : uint32_t {
         DeviceErrorCallback,
@@ -100,6 +140,8 @@ namespace wire {
                 {{type.name.CamelCase()}}ErrorCallback,
         {% endfor %}
         BufferMapReadAsyncCallback,
+        BulkDataConsumed,
+        FenceUpdateCompletedValue,
     };
 
     {% for type in by_category["object"] if type.is_builder %}
@@ -16,8 +16,11 @@
 #include "wire/WireCmd.h"
 
 #include "common/Assert.h"
+#include "common/Trace.h"
 
+#include <algorithm>
 #include <cstring>
+#include <memory>
 #include <vector>
 
 namespace nxt {
@@ -32,94 +35,208 @@ namespace wire {
             uint32_t bufferSerial;
             uint32_t requestSerial;
             uint32_t size;
+            uint32_t sharedMemoryOffset;
+
+            //* Userdatas are reused by the server, they are pending until the callback is called.
+            bool isPending;
         };
 
-        //* Stores what the backend knows about the type.
-        template<typename T>
-        struct ObjectDataBase {
-            //* The backend-provided handle and serial to this object.
-            T handle;
-            uint32_t serial = 0;
-
-            //* Built object ID and serial, needed to send to the client along with builder error callbacks
-            //* TODO(cwallez@chromium.org) only have this for builder T
-            uint32_t builtObjectId = 0;
-            uint32_t builtObjectSerial = 0;
-
-            //* Used by the error-propagation mechanism to know if this object is an error.
-            //* TODO(cwallez@chromium.org): this is doubling the memory usage of
-            //* std::vector<ObjectDataBase> consider making it a special marker value in handle instead.
-            bool valid;
-            //* Whether this object has been allocated, used by the KnownObjects queries
-            //* TODO(cwallez@chromium.org): make this an internal bit vector in KnownObjects.
-            bool allocated;
+        struct FenceCompletionUserdata {
+            Server* server;
+            uint32_t fenceId;
+            uint32_t fenceSerial;
+            uint64_t value;
+
+            bool isPending;
         };
 
-        //* Keeps track of the mapping between client IDs and backend objects.
+        //* Keeps track of the mapping between client IDs and backend objects. The handles and
+        //* serials are in flat arrays indexed by ID, and whether IDs are allocated and objects are
+        //* valid (not errors) are bit vectors. Clients reuse the IDs they free, so that in steady
+        //* state no allocation is made.
         template<typename T>
         class KnownObjects {
             public:
-                using Data = ObjectDataBase<T>;
+                //* Built object ID and serial, needed to send to the client along with builder error callbacks
+                struct BuiltObject {
+                    uint32_t id = 0;
+                    uint32_t serial = 0;
+                };
 
                 KnownObjects() {
                     //* Pre-allocate ID 0 to refer to the null handle.
-                    Data nullObject;
-                    nullObject.handle = nullptr;
-                    nullObject.valid = true;
-                    nullObject.allocated = true;
-                    mKnown.push_back(nullObject);
+                    Allocate(0);
+                    SetHandle(0, nullptr, true);
                 }
 
-                //* Get a backend objects for a given client ID.
-                //* Returns nullptr if the ID hasn't previously been allocated.
-                Data* Get(uint32_t id) {
-                    if (id >= mKnown.size()) {
-                        return nullptr;
-                    }
+                //* Whether the ID has previously been allocated, the other queries are only valid
+                //* for allocated IDs.
+                bool IsAllocated(uint32_t id) const {
+                    return id < mHandles.size() && GetBit(mAllocated, id);
+                }
 
-                    Data* data = &mKnown[id];
+                T GetHandle(uint32_t id) const {
+                    ASSERT(IsAllocated(id));
+                    return mHandles[id];
+                }
 
-                    if (!data->allocated) {
-                        return nullptr;
-                    }
+                //* Used by the error-propagation mechanism to know if this object is an error.
+                bool IsValid(uint32_t id) const {
+                    ASSERT(IsAllocated(id));
+                    return GetBit(mValid, id);
+                }
 
-                    return data;
+                uint32_t GetSerial(uint32_t id) const {
+                    ASSERT(IsAllocated(id));
+                    return mSerials[id];
                 }
 
-                //* Allocates the data for a given ID and returns it.
-                //* Returns nullptr if the ID is already allocated, or too far ahead.
-                //* Invalidates all the Data*
-                Data* Allocate(uint32_t id) {
-                    if (id > mKnown.size()) {
-                        return nullptr;
+                void SetHandle(uint32_t id, T handle, bool valid) {
+                    ASSERT(IsAllocated(id));
+                    mHandles[id] = handle;
+                    SetBit(&mValid, id, valid);
+                }
+
+                void SetSerial(uint32_t id, uint32_t serial) {
+                    ASSERT(IsAllocated(id));
+                    mSerials[id] = serial;
+                }
+
+                void SetInvalid(uint32_t id) {
+                    ASSERT(IsAllocated(id));
+                    SetBit(&mValid, id, false);
+                }
+
+                //* Only builders have built objects so the storage is only created for them.
+                BuiltObject GetBuiltObject(uint32_t id) const {
+                    ASSERT(IsAllocated(id));
+                    if (id >= mBuiltObjects.size()) {
+                        return {};
                     }
+                    return mBuiltObjects[id];
+                }
 
-                    Data data;
-                    data.allocated = true;
-                    data.valid = false;
-                    data.handle = nullptr;
+                void SetBuiltObject(uint32_t id, uint32_t builtObjectId, uint32_t builtObjectSerial) {
+                    ASSERT(IsAllocated(id));
+                    if (id >= mBuiltObjects.size()) {
+                        mBuiltObjects.resize(mHandles.size());
+                    }
+                    mBuiltObjects[id].id = builtObjectId;
+                    mBuiltObjects[id].serial = builtObjectSerial;
+                }
 
-                    if (id >= mKnown.size()) {
-                        mKnown.push_back(data);
-                        return &mKnown.back();
+                //* Allocates the ID with a null handle that is an error until SetHandle.
+                //* Returns false if the ID is already allocated, or too far ahead.
+                bool Allocate(uint32_t id) {
+                    if (id > mHandles.size()) {
+                        return false;
                     }
 
-                    if (mKnown[id].allocated) {
-                        return nullptr;
+                    if (id == mHandles.size()) {
+                        mHandles.push_back(nullptr);
+                        mSerials.push_back(0);
+                        if (id % 64 == 0) {
+                            mAllocated.push_back(0);
+                            mValid.push_back(0);
+                        }
+                    } else if (GetBit(mAllocated, id)) {
+                        return false;
                     }
 
-                    mKnown[id] = data;
-                    return &mKnown[id];
+                    SetBit(&mAllocated, id, true);
+                    SetBit(&mValid, id, false);
+                    mHandles[id] = nullptr;
+                    mSerials[id] = 0;
+                    if (id < mBuiltObjects.size()) {
+                        mBuiltObjects[id] = {};
+                    }
+                    return true;
                 }
 
                 //* Marks an ID as deallocated
                 void Free(uint32_t id) {
-                    ASSERT(id < mKnown.size());
-                    mKnown[id].allocated = false;
+                    ASSERT(IsAllocated(id));
+                    SetBit(&mAllocated, id, false);
+                }
+
+                //* Returns the handles of all the objects that have one, ID 0 excepted. This
+                //* includes objects made invalid by errors, like builders, as the server still
+                //* owns their reference.
+                std::vector<T> GetAllHandles() const {
+                    std::vector<T> handles;
+                    for (uint32_t id = 1; id < mHandles.size(); id++) {
+                        if (GetBit(mAllocated, id) && mHandles[id] != nullptr) {
+                            handles.push_back(mHandles[id]);
+                        }
+                    }
+                    return handles;
+                }
+
+            private:
+                static bool GetBit(const std::vector<uint64_t>& bits, uint32_t id) {
+                    return (bits[id / 64] >> (id % 64) & 1) != 0;
+                }
+
+                static void SetBit(std::vector<uint64_t>* bits, uint32_t id, bool value) {
+                    uint64_t mask = uint64_t(1) << (id % 64);
+                    if (value) {
+                        (*bits)[id / 64] |= mask;
+                    } else {
+                        (*bits)[id / 64] &= ~mask;
+                    }
+                }
+
+                std::vector<T> mHandles;
+                std::vector<uint32_t> mSerials;
+                std::vector<uint64_t> mAllocated;
+                std::vector<uint64_t> mValid;
+                std::vector<BuiltObject> mBuiltObjects;
+        };
+
+        //* Temporary storage for the arrays unpacked from a batch of commands, for example arrays
+        //* of objects. Memory is bump-allocated in blocks that are kept between batches, so after
+        //* the first batches no allocation is made.
+        constexpr size_t kArenaAlignment = sizeof(uint64_t);
+        constexpr size_t kArenaMinBlockSize = 4096;
+
+        class TemporaryArena {
+            public:
+                template<typename T>
+                T* Allocate(size_t count) {
+                    static_assert(alignof(T) <= kArenaAlignment, "arena alignment is too small");
+                    size_t size = (count * sizeof(T) + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+
+                    while (mCurrentBlock < mBlocks.size() && mBlocks[mCurrentBlock].size - mCurrentOffset < size) {
+                        mCurrentBlock++;
+                        mCurrentOffset = 0;
+                    }
+                    if (mCurrentBlock == mBlocks.size()) {
+                        Block block;
+                        block.size = std::max(size, kArenaMinBlockSize);
+                        block.data.reset(new uint64_t[block.size / sizeof(uint64_t)]);
+                        mBlocks.push_back(std::move(block));
+                        mCurrentOffset = 0;
+                    }
+
+                    uint8_t* result = reinterpret_cast<uint8_t*>(mBlocks[mCurrentBlock].data.get()) + mCurrentOffset;
+                    mCurrentOffset += size;
+                    return reinterpret_cast<T*>(result);
+                }
+
+                //* Frees all the allocations at once.
+                void Reset() {
+                    mCurrentBlock = 0;
+                    mCurrentOffset = 0;
                 }
 
             private:
-                std::vector<Data> mKnown;
+                struct Block {
+                    std::unique_ptr<uint64_t[]> data;
+                    size_t size;
+                };
+                std::vector<Block> mBlocks;
+                size_t mCurrentBlock = 0;
+                size_t mCurrentOffset = 0;
         };
 
         void ForwardDeviceErrorToServer(const char* message, nxtCallbackUserdata userdata);
@@ -129,21 +246,63 @@ namespace wire {
         {% endfor %}
 
         void ForwardBufferMapReadAsync(nxtBufferMapReadStatus status, const void* ptr, nxtCallbackUserdata userdata);
+        void ForwardFenceCompletedValue(nxtFenceCompletionStatus status, nxtCallbackUserdata userdata);
 
-        class Server : public CommandHandler {
+        class Server : public SharedDeviceServer {
             public:
-                Server(nxtDevice device, const nxtProcTable& procs, CommandSerializer* serializer)
-                    : mProcs(procs), mSerializer(serializer) {
+                Server(nxtDevice device, const nxtProcTable& procs, CommandSerializer* serializer, SharedMemory* sharedMemory, bool isSharedDevice)
+                    : mProcs(procs), mSerializer(serializer), mSharedMemory(sharedMemory), mIsSharedDevice(isSharedDevice) {
                     //* The client-server knowledge is bootstrapped with device 1.
-                    auto* deviceData = mKnownDevice.Allocate(1);
-                    deviceData->handle = device;
-                    deviceData->valid = true;
+                    mKnownDevice.Allocate(1);
+                    mKnownDevice.SetHandle(1, device, true);
+
+                    if (isSharedDevice) {
+                        //* The client owns a reference to the shared device, like to its other objects.
+                        procs.deviceReference(device);
+                    } else {
+                        auto userdata = static_cast<nxtCallbackUserdata>(reinterpret_cast<intptr_t>(this));
+                        procs.deviceSetErrorCallback(device, ForwardDeviceErrorToServer, userdata);
+                    }
+                }
+
+                ~Server() {
+                    //* MapReadAsync callbacks can still be called after the server is gone, for
+                    //* example if the buffer is kept alive by other objects. They are ignored and
+                    //* free their userdata.
+                    for (MapReadUserdata* data : mMapReadUserdatas) {
+                        if (data->isPending) {
+                            data->server = nullptr;
+                        } else {
+                            delete data;
+                        }
+                    }
+                    for (FenceCompletionUserdata* data : mFenceCompletionUserdatas) {
+                        if (data->isPending) {
+                            data->server = nullptr;
+                        } else {
+                            delete data;
+                        }
+                    }
+
+                    if (!mIsSharedDevice) {
+                        return;
+                    }
 
-                    auto userdata = static_cast<nxtCallbackUserdata>(reinterpret_cast<intptr_t>(this));
-                    procs.deviceSetErrorCallback(device, ForwardDeviceErrorToServer, userdata);
+                    //* Objects of the client are released when it goes away, the device last as
+                    //* the other objects might need it. The client coalesces its Reference and
+                    //* Release calls into a single Destroy, so the server owns exactly one
+                    //* reference to each handle and releasing it once drops all of the client's.
+                    {% for type in by_category["object"] if type.name.canonical_case() != "device" %}
+                        for ({{as_cType(type.name)}} handle : mKnown{{type.name.CamelCase()}}.GetAllHandles()) {
+                            mProcs.{{as_varName(type.name, Name("release"))}}(handle);
+                        }
+                    {% endfor %}
+                    for (nxtDevice handle : mKnownDevice.GetAllHandles()) {
+                        mProcs.deviceRelease(handle);
+                    }
                 }
 
-                void OnDeviceError(const char* message) {
+                void OnDeviceError(const char* message) override {
                     ReturnDeviceErrorCallbackCmd cmd;
                     cmd.messageStrlen = std::strlen(message);
 
@@ -155,24 +314,23 @@ namespace wire {
                 {% for type in by_category["object"] if type.is_builder%}
                     {% set Type = type.name.CamelCase() %}
                     void On{{Type}}Error(nxtBuilderErrorStatus status, const char* message, uint32_t id, uint32_t serial) {
-                        auto* builder = mKnown{{Type}}.Get(id);
-
-                        if (builder == nullptr || builder->serial != serial) {
+                        if (!mKnown{{Type}}.IsAllocated(id) || mKnown{{Type}}.GetSerial(id) != serial) {
                             return;
                         }
 
                         if (status != NXT_BUILDER_ERROR_STATUS_SUCCESS) {
-                            builder->valid = false;
+                            mKnown{{Type}}.SetInvalid(id);
                         }
 
                         if (status != NXT_BUILDER_ERROR_STATUS_UNKNOWN) {
                             //* Unknown is the only status that can be returned without a call to GetResult
                             //* so we are guaranteed to have created an object.
-                            ASSERT(builder->builtObjectId != 0);
+                            auto builtObject = mKnown{{Type}}.GetBuiltObject(id);
+                            ASSERT(builtObject.id != 0);
 
                             Return{{Type}}ErrorCallbackCmd cmd;
-                            cmd.builtObjectId = builder->builtObjectId;
-                            cmd.builtObjectSerial = builder->builtObjectSerial;
+                            cmd.builtObjectId = builtObject.id;
+                            cmd.builtObjectSerial = builtObject.serial;
                             cmd.status = status;
                             cmd.messageStrlen = std::strlen(message);
 
@@ -190,23 +348,61 @@ namespace wire {
                     cmd.requestSerial = data->requestSerial;
                     cmd.status = status;
 
+                    cmd.sharedMemoryOffset = data->sharedMemoryOffset;
+                    cmd.isDataInSharedMemory = false;
+
+                    //* Write the data directly where the client asked for it if we can, otherwise it
+                    //* is sent after the command.
+                    bool useSharedMemory = status == NXT_BUFFER_MAP_READ_STATUS_SUCCESS &&
+                        data->sharedMemoryOffset != kNoSharedMemoryOffset &&
+                        IsInSharedMemory(data->sharedMemoryOffset, data->size);
+
                     cmd.dataLength = 0;
-                    if (status == NXT_BUFFER_MAP_READ_STATUS_SUCCESS) {
+                    if (useSharedMemory) {
+                        memcpy(mSharedMemory->GetData() + data->sharedMemoryOffset, ptr, data->size);
+                        cmd.isDataInSharedMemory = true;
+                    } else if (status == NXT_BUFFER_MAP_READ_STATUS_SUCCESS) {
                         cmd.dataLength = data->size;
                     }
 
                     auto allocCmd = reinterpret_cast<ReturnBufferMapReadAsyncCallbackCmd*>(GetCmdSpace(cmd.GetRequiredSize()));
                     *allocCmd = cmd;
 
-                    if (status == NXT_BUFFER_MAP_READ_STATUS_SUCCESS) {
+                    if (cmd.dataLength != 0) {
                         memcpy(allocCmd->GetData(), ptr, data->size);
                     }
 
-                    delete data;
+                    data->isPending = false;
+                    mFreeMapReadUserdatas.push_back(data);
+                }
+
+                void OnFenceCompletedValue(nxtFenceCompletionStatus status, FenceCompletionUserdata* data) {
+                    //* Only successes change the completed value, errors were reported to the
+                    //* device and the fence is gone if the status is unknown.
+                    if (status == NXT_FENCE_COMPLETION_STATUS_SUCCESS) {
+                        ReturnFenceUpdateCompletedValueCmd cmd;
+                        cmd.fenceId = data->fenceId;
+                        cmd.fenceSerial = data->fenceSerial;
+                        cmd.value = data->value;
+
+                        auto allocCmd = reinterpret_cast<ReturnFenceUpdateCompletedValueCmd*>(GetCmdSpace(cmd.GetRequiredSize()));
+                        *allocCmd = cmd;
+                    }
+
+                    data->isPending = false;
+                    mFreeFenceCompletionUserdatas.push_back(data);
                 }
 
                 const uint8_t* HandleCommands(const uint8_t* commands, size_t size) override {
-                    mProcs.deviceTick(mKnownDevice.Get(1)->handle);
+                    mProcs.deviceTick(mKnownDevice.GetHandle(1));
+                    return HandleCommandsWithoutTick(commands, size);
+                }
+
+                const uint8_t* HandleCommandsWithoutTick(const uint8_t* commands, size_t size) {
+                    NXT_TRACE_EVENT("wire", "Server::HandleCommands");
+
+                    //* Arrays unpacked from the previous batch aren't needed anymore.
+                    mArena.Reset();
 
                     while (size > sizeof(WireCmd)) {
                         WireCmd cmdId = *reinterpret_cast<const WireCmd*>(commands);
@@ -228,6 +424,14 @@ namespace wire {
                             case WireCmd::BufferMapReadAsync:
                                 success = HandleBufferMapReadAsync(&commands, &size);
                                 break;
+                            case WireCmd::FenceOnCompletion:
+                                success = HandleFenceOnCompletion(&commands, &size);
+                                break;
+                            {% for type in by_category["object"] if type.is_recorded %}
+                                case WireCmd::{{type.name.CamelCase()}}Encoded:
+                                    success = Handle{{type.name.CamelCase()}}Encoded(&commands, &size);
+                                    break;
+                            {% endfor %}
 
                             default:
                                 success = false;
@@ -248,11 +452,64 @@ namespace wire {
             private:
                 nxtProcTable mProcs;
                 CommandSerializer* mSerializer = nullptr;
+                SharedMemory* mSharedMemory = nullptr;
+                bool mIsSharedDevice = false;
+                TemporaryArena mArena;
+
+                //* All the MapReadAsync userdatas that were created, and the ones that can be reused.
+                std::vector<MapReadUserdata*> mMapReadUserdatas;
+                std::vector<MapReadUserdata*> mFreeMapReadUserdatas;
+
+                MapReadUserdata* AcquireMapReadUserdata() {
+                    if (mFreeMapReadUserdatas.empty()) {
+                        mMapReadUserdatas.push_back(new MapReadUserdata);
+                        mFreeMapReadUserdatas.push_back(mMapReadUserdatas.back());
+                    }
+
+                    MapReadUserdata* data = mFreeMapReadUserdatas.back();
+                    mFreeMapReadUserdatas.pop_back();
+                    data->isPending = true;
+                    return data;
+                }
+
+                //* Same for the fence completion userdatas.
+                std::vector<FenceCompletionUserdata*> mFenceCompletionUserdatas;
+                std::vector<FenceCompletionUserdata*> mFreeFenceCompletionUserdatas;
+
+                FenceCompletionUserdata* AcquireFenceCompletionUserdata() {
+                    if (mFreeFenceCompletionUserdatas.empty()) {
+                        mFenceCompletionUserdatas.push_back(new FenceCompletionUserdata);
+                        mFreeFenceCompletionUserdatas.push_back(mFenceCompletionUserdatas.back());
+                    }
+
+                    FenceCompletionUserdata* data = mFreeFenceCompletionUserdatas.back();
+                    mFreeFenceCompletionUserdatas.pop_back();
+                    data->isPending = true;
+                    return data;
+                }
 
                 void* GetCmdSpace(size_t size) {
                     return mSerializer->GetCmdSpace(size);
                 }
 
+                bool IsInSharedMemory(uint32_t offset, size_t size) const {
+                    return mSharedMemory != nullptr && offset <= mSharedMemory->GetSize() &&
+                           size <= mSharedMemory->GetSize() - offset;
+                }
+
+                //* Tells the client it can reuse the shared memory of bulk data we are done with.
+                void ReleaseBulkData(uint32_t sharedMemoryOffset) {
+                    if (sharedMemoryOffset == kNoSharedMemoryOffset) {
+                        return;
+                    }
+
+                    ReturnBulkDataConsumedCmd cmd;
+                    cmd.sharedMemoryOffset = sharedMemoryOffset;
+
+                    auto allocCmd = reinterpret_cast<ReturnBulkDataConsumedCmd*>(GetCmdSpace(cmd.GetRequiredSize()));
+                    *allocCmd = cmd;
+                }
+
                 //* The list of known IDs for each object type.
                 {% for type in by_category["object"] %}
                     KnownObjects<{{as_cType(type.name)}}> mKnown{{type.name.CamelCase()}};
@@ -294,32 +551,32 @@ namespace wire {
                                 return false;
                             }
 
-                            //* While unpacking arguments, if any of them is an error, valid will be set to false.
-                            bool valid = true;
-
-                            //* Unpack 'self'
-                            {% set Type = type.name.CamelCase() %}
-                            {{as_cType(type.name)}} self;
-                            auto* selfData = mKnown{{Type}}.Get(cmd->self);
-                            {
-                                if (selfData == nullptr) {
-                                    return false;
-                                }
-                                valid = valid && selfData->valid;
-                                self = selfData->handle;
+                            if (!mKnown{{type.name.CamelCase()}}.IsAllocated(cmd->self)) {
+                                return false;
                             }
 
+                            return Do{{Suffix}}(cmd);
+                        }
+
+                        //* Does the command once 'self' is known to be allocated, recorded commands skip the check.
+                        bool Do{{Suffix}}(const {{Suffix}}Cmd* cmd) {
+                            auto& knownSelf = mKnown{{type.name.CamelCase()}};
+
+                            //* While unpacking arguments, if any of them is an error, valid will be set to false.
+                            bool valid = knownSelf.IsValid(cmd->self);
+                            {{as_cType(type.name)}} self = knownSelf.GetHandle(cmd->self);
+
                             //* Unpack value objects from IDs.
                             {% for arg in method.arguments if arg.annotation == "value" and arg.type.category == "object" %}
                                 {% set Type = arg.type.name.CamelCase() %}
                                 {{as_cType(arg.type.name)}} arg_{{as_varName(arg.name)}};
                                 {
-                                    auto* data = mKnown{{Type}}.Get(cmd->{{as_varName(arg.name)}});
-                                    if (data == nullptr) {
+                                    uint32_t id = cmd->{{as_varName(arg.name)}};
+                                    if (!mKnown{{Type}}.IsAllocated(id)) {
                                         return false;
                                     }
-                                    valid = valid && data->valid;
-                                    arg_{{as_varName(arg.name)}} = data->handle;
+                                    valid = valid && mKnown{{Type}}.IsValid(id);
+                                    arg_{{as_varName(arg.name)}} = mKnown{{Type}}.GetHandle(id);
                                 }
                             {% endfor %}
 
@@ -334,20 +591,30 @@ namespace wire {
                                         return false;
                                     }
                                 {% elif arg.type.category == "object" %}
-                                    //* Unpack arrays of objects.
-                                    //* TODO(cwallez@chromium.org) do not allocate when there are few objects.
-                                    std::vector<{{as_cType(arg.type.name)}}> {{argName}}Storage(cmd->{{as_varName(arg.length.name)}});
+                                    //* Unpack arrays of objects in the arena, which is reset for each batch.
+                                    auto {{argName}}Storage = mArena.Allocate<{{as_cType(arg.type.name)}}>(cmd->{{as_varName(arg.length.name)}});
                                     auto {{argName}}Ids = reinterpret_cast<const uint32_t*>(cmd->GetPtr_{{argName}}());
                                     for (size_t i = 0; i < cmd->{{as_varName(arg.length.name)}}; i++) {
                                         {% set Type = arg.type.name.CamelCase() %}
-                                        auto* data = mKnown{{Type}}.Get({{argName}}Ids[i]);
-                                        if (data == nullptr) {
+                                        uint32_t id = {{argName}}Ids[i];
+                                        if (!mKnown{{Type}}.IsAllocated(id)) {
+                                            return false;
+                                        }
+                                        {{argName}}Storage[i] = mKnown{{Type}}.GetHandle(id);
+                                        valid = valid && mKnown{{Type}}.IsValid(id);
+                                    }
+                                    arg_{{argName}} = {{argName}}Storage;
+                                {% elif arg.is_bulk %}
+                                    //* Bulk arrays are either in the shared memory or after the command.
+                                    if (cmd->{{argName}}SharedMemoryOffset != kNoSharedMemoryOffset) {
+                                        size_t {{argName}}Size = cmd->{{as_varName(arg.length.name)}} * sizeof({{as_cType(arg.type.name)}});
+                                        if (!IsInSharedMemory(cmd->{{argName}}SharedMemoryOffset, {{argName}}Size)) {
                                             return false;
                                         }
-                                        {{argName}}Storage[i] = data->handle;
-                                        valid = valid && data->valid;
+                                        arg_{{argName}} = reinterpret_cast<const {{as_cType(arg.type.name)}}*>(mSharedMemory->GetData() + cmd->{{argName}}SharedMemoryOffset);
+                                    } else {
+                                        arg_{{argName}} = reinterpret_cast<const {{as_cType(arg.type.name)}}*>(cmd->GetPtr_{{argName}}());
                                     }
-                                    arg_{{argName}} = {{argName}}Storage.data();
                                 {% else %}
                                     //* For anything else, just get the pointer.
                                     arg_{{argName}} = reinterpret_cast<const {{as_cType(arg.type.name)}}*>(cmd->GetPtr_{{argName}}());
@@ -361,27 +628,28 @@ namespace wire {
                             {% set returns = return_type.name.canonical_case() != "void" %}
                             {% if returns %}
                                 {% set Type = method.return_type.name.CamelCase() %}
-                                auto* resultData = mKnown{{Type}}.Allocate(cmd->resultId);
-                                if (resultData == nullptr) {
+                                if (!mKnown{{Type}}.Allocate(cmd->resultId)) {
                                     return false;
                                 }
-                                resultData->serial = cmd->resultSerial;
+                                mKnown{{Type}}.SetSerial(cmd->resultId, cmd->resultSerial);
 
                                 {% if type.is_builder %}
-                                    selfData->builtObjectId = cmd->resultId;
-                                    selfData->builtObjectSerial = cmd->resultSerial;
+                                    knownSelf.SetBuiltObject(cmd->self, cmd->resultId, cmd->resultSerial);
                                 {% endif %}
                             {% endif %}
 
                             //* After the data is allocated, apply the argument error propagation mechanism
                             if (!valid) {
                                 {% if type.is_builder %}
-                                    selfData->valid = false;
+                                    knownSelf.SetInvalid(cmd->self);
                                     //* If we are in GetResult, fake an error callback
                                     {% if returns %}
-                                        On{{type.name.CamelCase()}}Error(NXT_BUILDER_ERROR_STATUS_ERROR, "Maybe monad", cmd->self, selfData->serial);
+                                        On{{type.name.CamelCase()}}Error(NXT_BUILDER_ERROR_STATUS_ERROR, "Maybe monad", cmd->self, knownSelf.GetSerial(cmd->self));
                                     {% endif %}
                                 {% endif %}
+                                {% for arg in method.arguments if arg.is_bulk %}
+                                    ReleaseBulkData(cmd->{{as_varName(arg.name)}}SharedMemoryOffset);
+                                {% endfor %}
                                 return true;
                             }
 
@@ -398,16 +666,20 @@ namespace wire {
                                 {%- endfor -%}
                             );
 
+                            //* The backend copied the bulk data in the call so the client can reuse the space.
+                            {% for arg in method.arguments if arg.is_bulk %}
+                                ReleaseBulkData(cmd->{{as_varName(arg.name)}}SharedMemoryOffset);
+                            {% endfor %}
+
                             {% if returns %}
-                                resultData->handle = result;
-                                resultData->valid = result != nullptr;
+                                mKnown{{Type}}.SetHandle(cmd->resultId, result, result != nullptr);
 
                                 //* builders remember the ID of the object they built so that they can send it
                                 //* in the callback to the client.
                                 {% if return_type.is_builder %}
                                     if (result != nullptr) {
                                         uint64_t userdata1 = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(this));
-                                        uint64_t userdata2 = (uint64_t(resultData->serial) << uint64_t(32)) + cmd->resultId;
+                                        uint64_t userdata2 = (uint64_t(cmd->resultSerial) << uint64_t(32)) + cmd->resultId;
                                         mProcs.{{as_varName(return_type.name, Name("set error callback"))}}(result, Forward{{return_type.name.CamelCase()}}ToClient, userdata1, userdata2);
                                     }
                                 {% endif %}
@@ -431,13 +703,14 @@ namespace wire {
                             return false;
                         }
 
-                        auto* data = mKnown{{type.name.CamelCase()}}.Get(cmd->objectId);
-                        if (data == nullptr) {
+                        auto& known = mKnown{{type.name.CamelCase()}};
+                        if (!known.IsAllocated(cmd->objectId)) {
                             return false;
                         }
 
-                        if (data->valid) {
-                            mProcs.{{as_varName(type.name, Name("release"))}}(data->handle);
+                        //* Builders made invalid by an error still have a handle to release.
+                        if (known.GetHandle(cmd->objectId) != nullptr) {
+                            mProcs.{{as_varName(type.name, Name("release"))}}(known.GetHandle(cmd->objectId));
                         }
 
                         mKnown{{type.name.CamelCase()}}.Free(cmd->objectId);
@@ -445,6 +718,54 @@ namespace wire {
                     }
                 {% endfor %}
 
+                {% for type in by_category["object"] if type.is_recorded %}
+                    {% set Type = type.name.CamelCase() %}
+                    //* Replays the recorded commands on the object, looking it up only once.
+                    bool Handle{{Type}}Encoded(const uint8_t** commands, size_t* size) {
+                        const auto* cmd = GetCommand<{{Type}}EncodedCmd>(commands, size);
+                        if (cmd == nullptr) {
+                            return false;
+                        }
+
+                        if (!mKnown{{Type}}.IsAllocated(cmd->self)) {
+                            return false;
+                        }
+
+                        //* Commands recorded on an error object have no effect.
+                        if (!mKnown{{Type}}.IsValid(cmd->self)) {
+                            return true;
+                        }
+
+                        const uint8_t* recorded = cmd->GetCommands();
+                        size_t recordedSize = cmd->commandsSize;
+                        while (recordedSize > 0) {
+                            if (recordedSize < sizeof(WireCmd)) {
+                                return false;
+                            }
+
+                            WireCmd cmdId = *reinterpret_cast<const WireCmd*>(recorded);
+                            bool success = false;
+                            switch (cmdId) {
+                                {% for method in type.methods if method.return_type.category != "object" %}
+                                    {% set Suffix = as_MethodSuffix(type.name, method.name) %}
+                                    case WireCmd::{{Suffix}}: {
+                                        const auto* recordedCmd = GetCommand<{{Suffix}}Cmd>(&recorded, &recordedSize);
+                                        success = recordedCmd != nullptr && recordedCmd->self == cmd->self && Do{{Suffix}}(recordedCmd);
+                                    } break;
+                                {% endfor %}
+                                default:
+                                    success = false;
+                            }
+
+                            if (!success) {
+                                return false;
+                            }
+                        }
+
+                        return true;
+                    }
+                {% endfor %}
+
                 bool HandleBufferMapReadAsync(const uint8_t** commands, size_t* size) {
                     //* These requests are just forwarded to the buffer, with userdata containing what the client
                     //* will require in the return command.
@@ -453,27 +774,54 @@ namespace wire {
                         return false;
                     }
 
-                    auto* buffer = mKnownBuffer.Get(cmd->bufferId);
-                    if (buffer == nullptr) {
+                    if (!mKnownBuffer.IsAllocated(cmd->bufferId)) {
                         return false;
                     }
 
-                    auto* data = new MapReadUserdata;
+                    auto* data = AcquireMapReadUserdata();
                     data->server = this;
                     data->bufferId = cmd->bufferId;
-                    data->bufferSerial = buffer->serial;
+                    data->bufferSerial = mKnownBuffer.GetSerial(cmd->bufferId);
                     data->requestSerial = cmd->requestSerial;
                     data->size = cmd->size;
+                    data->sharedMemoryOffset = cmd->sharedMemoryOffset;
 
                     auto userdata = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(data));
 
-                    if (!buffer->valid) {
-                        //* Fake the buffer returning a failure, data will be freed in this call.
+                    if (!mKnownBuffer.IsValid(cmd->bufferId)) {
+                        //* Fake the buffer returning a failure, data will be released in this call.
                         ForwardBufferMapReadAsync(NXT_BUFFER_MAP_READ_STATUS_ERROR, nullptr, userdata);
                         return true;
                     }
 
-                    mProcs.bufferMapReadAsync(buffer->handle, cmd->start, cmd->size, ForwardBufferMapReadAsync, userdata);
+                    mProcs.bufferMapReadAsync(mKnownBuffer.GetHandle(cmd->bufferId), cmd->start, cmd->size, ForwardBufferMapReadAsync, userdata);
+
+                    return true;
+                }
+
+                bool HandleFenceOnCompletion(const uint8_t** commands, size_t* size) {
+                    const auto* cmd = GetCommand<FenceOnCompletionCmd>(commands, size);
+                    if (cmd == nullptr) {
+                        return false;
+                    }
+
+                    if (!mKnownFence.IsAllocated(cmd->fenceId)) {
+                        return false;
+                    }
+
+                    //* Error fences never complete, like the ones signaled with invalid values.
+                    if (!mKnownFence.IsValid(cmd->fenceId)) {
+                        return true;
+                    }
+
+                    auto* data = AcquireFenceCompletionUserdata();
+                    data->server = this;
+                    data->fenceId = cmd->fenceId;
+                    data->fenceSerial = mKnownFence.GetSerial(cmd->fenceId);
+                    data->value = cmd->value;
+
+                    auto userdata = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(data));
+                    mProcs.fenceOnCompletion(mKnownFence.GetHandle(cmd->fenceId), cmd->value, ForwardFenceCompletedValue, userdata);
 
                     return true;
                 }
@@ -495,12 +843,33 @@ namespace wire {
 
         void ForwardBufferMapReadAsync(nxtBufferMapReadStatus status, const void* ptr, nxtCallbackUserdata userdata) {
             auto data = reinterpret_cast<MapReadUserdata*>(static_cast<uintptr_t>(userdata));
+            if (data->server == nullptr) {
+                delete data;
+                return;
+            }
             data->server->OnMapReadAsyncCallback(status, ptr, data);
         }
+
+        void ForwardFenceCompletedValue(nxtFenceCompletionStatus status, nxtCallbackUserdata userdata) {
+            auto data = reinterpret_cast<FenceCompletionUserdata*>(static_cast<uintptr_t>(userdata));
+            if (data->server == nullptr) {
+                delete data;
+                return;
+            }
+            data->server->OnFenceCompletedValue(status, data);
+        }
+    }
+
+    CommandHandler* NewServerCommandHandler(nxtDevice device, const nxtProcTable& procs, CommandSerializer* serializer, SharedMemory* sharedMemory) {
+        return new server::Server(device, procs, serializer, sharedMemory, false);
+    }
+
+    SharedDeviceServer* NewSharedDeviceServer(nxtDevice device, const nxtProcTable& procs, CommandSerializer* serializer, SharedMemory* sharedMemory) {
+        return new server::Server(device, procs, serializer, sharedMemory, true);
     }
 
-    CommandHandler* NewServerCommandHandler(nxtDevice device, const nxtProcTable& procs, CommandSerializer* serializer) {
-        return new server::Server(device, procs, serializer);
+    const uint8_t* ServerHandleCommandsWithoutTick(CommandHandler* server, const uint8_t* commands, size_t size) {
+        return static_cast<server::Server*>(server)->HandleCommandsWithoutTick(commands, size);
     }
 
 }
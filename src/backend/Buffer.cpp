@@ -67,6 +67,9 @@ namespace backend {
     }
 
     void BufferBase::SetSubData(uint32_t start, uint32_t count, const uint32_t* data) {
+        // The usage and content of the buffer depend on the command buffers submitted before.
+        mDevice->FlushPendingSubmits();
+
         if ((start + count) * sizeof(uint32_t) > GetSize()) {
             mDevice->HandleError("Buffer subdata out of range");
             return;
@@ -84,6 +87,8 @@ namespace backend {
                                   uint32_t size,
                                   nxtBufferMapReadCallback callback,
                                   nxtCallbackUserdata userdata) {
+        mDevice->FlushPendingSubmits();
+
         if (start + size > GetSize()) {
             mDevice->HandleError("Buffer map read out of range");
             callback(NXT_BUFFER_MAP_READ_STATUS_ERROR, nullptr, userdata);
@@ -153,7 +158,17 @@ namespace backend {
         mCurrentUsage = usage;
     }
 
+    const QueueOwnership& BufferBase::GetQueueOwnership() const {
+        return mQueueOwnership;
+    }
+
+    void BufferBase::SetQueueOwnership(const QueueOwnership& ownership) {
+        mQueueOwnership = ownership;
+    }
+
     void BufferBase::TransitionUsage(nxt::BufferUsageBit usage) {
+        mDevice->FlushPendingSubmits();
+
         if (!IsTransitionPossible(usage)) {
             mDevice->HandleError("Buffer frozen or usage not allowed");
             return;
@@ -163,6 +178,8 @@ namespace backend {
     }
 
     void BufferBase::FreezeUsage(nxt::BufferUsageBit usage) {
+        mDevice->FlushPendingSubmits();
+
         if (!IsTransitionPossible(usage)) {
             mDevice->HandleError("Buffer frozen or usage not allowed");
             return;
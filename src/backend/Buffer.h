@@ -17,6 +17,7 @@
 
 #include "backend/Builder.h"
 #include "backend/Forward.h"
+#include "backend/Queue.h"
 #include "backend/RefCounted.h"
 
 #include "nxt/nxtcpp.h"
@@ -36,6 +37,8 @@ namespace backend {
         bool IsFrozen() const;
         bool HasFrozenUsage(nxt::BufferUsageBit usage) const;
         void UpdateUsageInternal(nxt::BufferUsageBit usage);
+        const QueueOwnership& GetQueueOwnership() const;
+        void SetQueueOwnership(const QueueOwnership& ownership);
 
         DeviceBase* GetDevice() const;
 
@@ -73,6 +76,7 @@ namespace backend {
 
         bool mIsFrozen = false;
         bool mIsMapped = false;
+        QueueOwnership mQueueOwnership;
     };
 
     class BufferBuilder : public Builder<BufferBase> {
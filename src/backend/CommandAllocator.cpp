@@ -47,6 +47,8 @@ namespace backend {
             mBlocks = std::move(other.mBlocks);
             other.Reset();
         }
+        mNeedsDestruction = other.mNeedsDestruction;
+        other.mNeedsDestruction = false;
         other.DataWasDestroyed();
         Reset();
     }
@@ -58,18 +60,23 @@ namespace backend {
         } else {
             mBlocks.clear();
         }
+        mNeedsDestruction = other.mNeedsDestruction;
+        other.mNeedsDestruction = false;
         other.DataWasDestroyed();
         Reset();
         return *this;
     }
 
     CommandIterator::CommandIterator(CommandAllocator&& allocator)
-        : mBlocks(allocator.AcquireBlocks()), mEndOfBlock(EndOfBlock) {
+        : mBlocks(allocator.AcquireBlocks()),
+          mEndOfBlock(EndOfBlock),
+          mNeedsDestruction(allocator.mNeedsDestruction) {
         Reset();
     }
 
     CommandIterator& CommandIterator::operator=(CommandAllocator&& allocator) {
         mBlocks = allocator.AcquireBlocks();
+        mNeedsDestruction = allocator.mNeedsDestruction;
         Reset();
         return *this;
     }
@@ -89,6 +96,10 @@ namespace backend {
         }
     }
 
+    bool CommandIterator::NeedsDestruction() const {
+        return mNeedsDestruction;
+    }
+
     void CommandIterator::DataWasDestroyed() {
         mDataWasDestroyed = true;
     }
@@ -17,6 +17,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <type_traits>
 #include <vector>
 
 namespace backend {
@@ -87,6 +88,9 @@ namespace backend {
         // Needs to be called if iteration was stopped early.
         void Reset();
 
+        // Whether some of the commands or data aren't trivially destructible. When false the
+        // commands can be freed without iterating over them.
+        bool NeedsDestruction() const;
         void DataWasDestroyed();
 
       private:
@@ -102,6 +106,7 @@ namespace backend {
         // Used to avoid a special case for empty iterators.
         uint32_t mEndOfBlock;
         bool mDataWasDestroyed = false;
+        bool mNeedsDestruction = false;
     };
 
     class CommandAllocator {
@@ -113,12 +118,14 @@ namespace backend {
         T* Allocate(E commandId) {
             static_assert(sizeof(E) == sizeof(uint32_t), "");
             static_assert(alignof(E) == alignof(uint32_t), "");
+            mNeedsDestruction |= !std::is_trivially_destructible<T>::value;
             return reinterpret_cast<T*>(
                 Allocate(static_cast<uint32_t>(commandId), sizeof(T), alignof(T)));
         }
 
         template <typename T>
         T* AllocateData(size_t count) {
+            mNeedsDestruction |= !std::is_trivially_destructible<T>::value;
             return reinterpret_cast<T*>(AllocateData(sizeof(T) * count, alignof(T)));
         }
 
@@ -132,6 +139,7 @@ namespace backend {
 
         CommandBlocks mBlocks;
         size_t mLastAllocationSize = 2048;
+        bool mNeedsDestruction = false;
 
         // Pointers to the current range of allocation in the block. Guaranteed to allow for at
         // least one uint32_t is not nullptr, so that the special EndOfBlock command id can always
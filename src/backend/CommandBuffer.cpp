@@ -22,8 +22,10 @@
 #include "backend/Device.h"
 #include "backend/InputState.h"
 #include "backend/PipelineLayout.h"
+#include "backend/QuerySet.h"
 #include "backend/RenderPipeline.h"
 #include "backend/Texture.h"
+#include "common/Trace.h"
 
 #include <cstring>
 #include <map>
@@ -77,6 +79,24 @@ namespace backend {
             return true;
         }
 
+        bool ValidateQueryResolve(CommandBufferBuilder* builder, const ResolveQuerySetCmd* cmd) {
+            if (cmd->destination.offset % kQueryResultSize != 0) {
+                builder->HandleError("Query resolve offset must be a multiple of 8");
+                return false;
+            }
+
+            uint64_t resultsSize = static_cast<uint64_t>(cmd->queryCount) *
+                                   cmd->querySet->GetResultsPerQuery() * kQueryResultSize;
+            uint64_t bufferSize = cmd->destination.buffer->GetSize();
+            if (cmd->destination.offset > bufferSize ||
+                resultsSize > bufferSize - cmd->destination.offset) {
+                builder->HandleError("Query resolve would overflow the buffer");
+                return false;
+            }
+
+            return true;
+        }
+
         bool ValidateTexelBufferOffset(CommandBufferBuilder* builder,
                                        TextureBase* texture,
                                        const BufferCopyLocation& location) {
@@ -127,7 +147,10 @@ namespace backend {
     CommandBufferBase::CommandBufferBase(CommandBufferBuilder* builder)
         : mDevice(builder->mDevice),
           mBuffersTransitioned(std::move(builder->mState->mBuffersTransitioned)),
-          mTexturesTransitioned(std::move(builder->mState->mTexturesTransitioned)) {
+          mTexturesTransitioned(std::move(builder->mState->mTexturesTransitioned)),
+          mHasRenderPasses(builder->mHasRenderPasses),
+          mHasComputePasses(builder->mHasComputePasses),
+          mHasPipelineStatisticsQueries(builder->mHasPipelineStatisticsQueries) {
     }
 
     bool CommandBufferBase::ValidateResourceUsagesImmediate() {
@@ -150,204 +173,24 @@ namespace backend {
         return mDevice;
     }
 
-    void FreeCommands(CommandIterator* commands) {
-        Command type;
-        while (commands->NextCommandId(&type)) {
-            switch (type) {
-                case Command::BeginComputePass: {
-                    BeginComputePassCmd* begin = commands->NextCommand<BeginComputePassCmd>();
-                    begin->~BeginComputePassCmd();
-                } break;
-                case Command::BeginRenderPass: {
-                    BeginRenderPassCmd* begin = commands->NextCommand<BeginRenderPassCmd>();
-                    begin->~BeginRenderPassCmd();
-                } break;
-                case Command::BeginRenderSubpass: {
-                    BeginRenderSubpassCmd* begin = commands->NextCommand<BeginRenderSubpassCmd>();
-                    begin->~BeginRenderSubpassCmd();
-                } break;
-                case Command::CopyBufferToBuffer: {
-                    CopyBufferToBufferCmd* copy = commands->NextCommand<CopyBufferToBufferCmd>();
-                    copy->~CopyBufferToBufferCmd();
-                } break;
-                case Command::CopyBufferToTexture: {
-                    CopyBufferToTextureCmd* copy = commands->NextCommand<CopyBufferToTextureCmd>();
-                    copy->~CopyBufferToTextureCmd();
-                } break;
-                case Command::CopyTextureToBuffer: {
-                    CopyTextureToBufferCmd* copy = commands->NextCommand<CopyTextureToBufferCmd>();
-                    copy->~CopyTextureToBufferCmd();
-                } break;
-                case Command::Dispatch: {
-                    DispatchCmd* dispatch = commands->NextCommand<DispatchCmd>();
-                    dispatch->~DispatchCmd();
-                } break;
-                case Command::DrawArrays: {
-                    DrawArraysCmd* draw = commands->NextCommand<DrawArraysCmd>();
-                    draw->~DrawArraysCmd();
-                } break;
-                case Command::DrawElements: {
-                    DrawElementsCmd* draw = commands->NextCommand<DrawElementsCmd>();
-                    draw->~DrawElementsCmd();
-                } break;
-                case Command::EndComputePass: {
-                    EndComputePassCmd* cmd = commands->NextCommand<EndComputePassCmd>();
-                    cmd->~EndComputePassCmd();
-                } break;
-                case Command::EndRenderPass: {
-                    EndRenderPassCmd* cmd = commands->NextCommand<EndRenderPassCmd>();
-                    cmd->~EndRenderPassCmd();
-                } break;
-                case Command::EndRenderSubpass: {
-                    EndRenderSubpassCmd* cmd = commands->NextCommand<EndRenderSubpassCmd>();
-                    cmd->~EndRenderSubpassCmd();
-                } break;
-                case Command::SetComputePipeline: {
-                    SetComputePipelineCmd* cmd = commands->NextCommand<SetComputePipelineCmd>();
-                    cmd->~SetComputePipelineCmd();
-                } break;
-                case Command::SetRenderPipeline: {
-                    SetRenderPipelineCmd* cmd = commands->NextCommand<SetRenderPipelineCmd>();
-                    cmd->~SetRenderPipelineCmd();
-                } break;
-                case Command::SetPushConstants: {
-                    SetPushConstantsCmd* cmd = commands->NextCommand<SetPushConstantsCmd>();
-                    commands->NextData<uint32_t>(cmd->count);
-                    cmd->~SetPushConstantsCmd();
-                } break;
-                case Command::SetStencilReference: {
-                    SetStencilReferenceCmd* cmd = commands->NextCommand<SetStencilReferenceCmd>();
-                    cmd->~SetStencilReferenceCmd();
-                } break;
-                case Command::SetBlendColor: {
-                    SetBlendColorCmd* cmd = commands->NextCommand<SetBlendColorCmd>();
-                    cmd->~SetBlendColorCmd();
-                } break;
-                case Command::SetBindGroup: {
-                    SetBindGroupCmd* cmd = commands->NextCommand<SetBindGroupCmd>();
-                    cmd->~SetBindGroupCmd();
-                } break;
-                case Command::SetIndexBuffer: {
-                    SetIndexBufferCmd* cmd = commands->NextCommand<SetIndexBufferCmd>();
-                    cmd->~SetIndexBufferCmd();
-                } break;
-                case Command::SetVertexBuffers: {
-                    SetVertexBuffersCmd* cmd = commands->NextCommand<SetVertexBuffersCmd>();
-                    auto buffers = commands->NextData<Ref<BufferBase>>(cmd->count);
-                    for (size_t i = 0; i < cmd->count; ++i) {
-                        (&buffers[i])->~Ref<BufferBase>();
-                    }
-                    commands->NextData<uint32_t>(cmd->count);
-                    cmd->~SetVertexBuffersCmd();
-                } break;
-                case Command::TransitionBufferUsage: {
-                    TransitionBufferUsageCmd* cmd =
-                        commands->NextCommand<TransitionBufferUsageCmd>();
-                    cmd->~TransitionBufferUsageCmd();
-                } break;
-                case Command::TransitionTextureUsage: {
-                    TransitionTextureUsageCmd* cmd =
-                        commands->NextCommand<TransitionTextureUsageCmd>();
-                    cmd->~TransitionTextureUsageCmd();
-                } break;
-            }
-        }
-        commands->DataWasDestroyed();
+    bool CommandBufferBase::HasRenderPasses() const {
+        return mHasRenderPasses;
     }
 
-    void SkipCommand(CommandIterator* commands, Command type) {
-        switch (type) {
-            case Command::BeginComputePass:
-                commands->NextCommand<BeginComputePassCmd>();
-                break;
-
-            case Command::BeginRenderPass:
-                commands->NextCommand<BeginRenderPassCmd>();
-                break;
-
-            case Command::BeginRenderSubpass:
-                commands->NextCommand<BeginRenderSubpassCmd>();
-                break;
-
-            case Command::CopyBufferToBuffer:
-                commands->NextCommand<CopyBufferToBufferCmd>();
-                break;
-
-            case Command::CopyBufferToTexture:
-                commands->NextCommand<CopyBufferToTextureCmd>();
-                break;
-
-            case Command::CopyTextureToBuffer:
-                commands->NextCommand<CopyTextureToBufferCmd>();
-                break;
-
-            case Command::Dispatch:
-                commands->NextCommand<DispatchCmd>();
-                break;
-
-            case Command::DrawArrays:
-                commands->NextCommand<DrawArraysCmd>();
-                break;
-
-            case Command::DrawElements:
-                commands->NextCommand<DrawElementsCmd>();
-                break;
-
-            case Command::EndComputePass:
-                commands->NextCommand<EndComputePassCmd>();
-                break;
-
-            case Command::EndRenderPass:
-                commands->NextCommand<EndRenderPassCmd>();
-                break;
-
-            case Command::EndRenderSubpass:
-                commands->NextCommand<EndRenderSubpassCmd>();
-                break;
-
-            case Command::SetComputePipeline:
-                commands->NextCommand<SetComputePipelineCmd>();
-                break;
-
-            case Command::SetRenderPipeline:
-                commands->NextCommand<SetRenderPipelineCmd>();
-                break;
-
-            case Command::SetPushConstants: {
-                auto* cmd = commands->NextCommand<SetPushConstantsCmd>();
-                commands->NextData<uint32_t>(cmd->count);
-            } break;
-
-            case Command::SetStencilReference:
-                commands->NextCommand<SetStencilReferenceCmd>();
-                break;
-
-            case Command::SetBlendColor:
-                commands->NextCommand<SetBlendColorCmd>();
-                break;
-
-            case Command::SetBindGroup:
-                commands->NextCommand<SetBindGroupCmd>();
-                break;
-
-            case Command::SetIndexBuffer:
-                commands->NextCommand<SetIndexBufferCmd>();
-                break;
+    bool CommandBufferBase::HasComputePasses() const {
+        return mHasComputePasses;
+    }
 
-            case Command::SetVertexBuffers: {
-                auto* cmd = commands->NextCommand<SetVertexBuffersCmd>();
-                commands->NextData<Ref<BufferBase>>(cmd->count);
-                commands->NextData<uint32_t>(cmd->count);
-            } break;
+    bool CommandBufferBase::HasPipelineStatisticsQueries() const {
+        return mHasPipelineStatisticsQueries;
+    }
 
-            case Command::TransitionBufferUsage:
-                commands->NextCommand<TransitionBufferUsageCmd>();
-                break;
+    const std::set<BufferBase*>& CommandBufferBase::GetBuffersTransitioned() const {
+        return mBuffersTransitioned;
+    }
 
-            case Command::TransitionTextureUsage:
-                commands->NextCommand<TransitionTextureUsageCmd>();
-                break;
-        }
+    const std::set<TextureBase*>& CommandBufferBase::GetTexturesTransitioned() const {
+        return mTexturesTransitioned;
     }
 
     CommandBufferBuilder::CommandBufferBuilder(DeviceBase* device)
@@ -362,6 +205,7 @@ namespace backend {
     }
 
     bool CommandBufferBuilder::ValidateGetResult() {
+        NXT_TRACE_EVENT("backend", "CommandBufferBuilder::ValidateGetResult");
         MoveToIterator();
 
         Command type;
@@ -372,6 +216,17 @@ namespace backend {
                     if (!mState->BeginComputePass()) {
                         return false;
                     }
+                    mHasComputePasses = true;
+                } break;
+
+                case Command::BeginPipelineStatisticsQuery: {
+                    BeginPipelineStatisticsQueryCmd* cmd =
+                        mIterator.NextCommand<BeginPipelineStatisticsQueryCmd>();
+                    if (!mState->BeginPipelineStatisticsQuery(cmd->querySet.Get(),
+                                                              cmd->queryIndex)) {
+                        return false;
+                    }
+                    mHasPipelineStatisticsQueries = true;
                 } break;
 
                 case Command::BeginRenderPass: {
@@ -390,6 +245,7 @@ namespace backend {
                     if (!mState->BeginRenderPass(renderPass, framebuffer)) {
                         return false;
                     }
+                    mHasRenderPasses = true;
                 } break;
 
                 case Command::BeginRenderSubpass: {
@@ -480,6 +336,13 @@ namespace backend {
                     }
                 } break;
 
+                case Command::EndPipelineStatisticsQuery: {
+                    mIterator.NextCommand<EndPipelineStatisticsQueryCmd>();
+                    if (!mState->EndPipelineStatisticsQuery()) {
+                        return false;
+                    }
+                } break;
+
                 case Command::EndRenderPass: {
                     mIterator.NextCommand<EndRenderPassCmd>();
                     if (!mState->EndRenderPass()) {
@@ -494,6 +357,17 @@ namespace backend {
                     }
                 } break;
 
+                case Command::ResolveQuerySet: {
+                    ResolveQuerySetCmd* cmd = mIterator.NextCommand<ResolveQuerySetCmd>();
+                    if (!mState->ValidateCanResolveQuerySet(cmd->querySet.Get(), cmd->firstQuery,
+                                                            cmd->queryCount) ||
+                        !ValidateQueryResolve(this, cmd) ||
+                        !mState->ValidateCanUseBufferAs(cmd->destination.buffer.Get(),
+                                                        nxt::BufferUsageBit::TransferDst)) {
+                        return false;
+                    }
+                } break;
+
                 case Command::SetComputePipeline: {
                     SetComputePipelineCmd* cmd = mIterator.NextCommand<SetComputePipelineCmd>();
                     ComputePipelineBase* pipeline = cmd->pipeline.Get();
@@ -577,6 +451,13 @@ namespace backend {
                     }
 
                 } break;
+
+                case Command::WriteTimestamp: {
+                    WriteTimestampCmd* cmd = mIterator.NextCommand<WriteTimestampCmd>();
+                    if (!mState->WriteTimestamp(cmd->querySet.Get(), cmd->queryIndex)) {
+                        return false;
+                    }
+                } break;
             }
         }
 
@@ -602,6 +483,15 @@ namespace backend {
         mAllocator.Allocate<BeginComputePassCmd>(Command::BeginComputePass);
     }
 
+    void CommandBufferBuilder::BeginPipelineStatisticsQuery(QuerySetBase* querySet,
+                                                            uint32_t queryIndex) {
+        BeginPipelineStatisticsQueryCmd* cmd = mAllocator.Allocate<BeginPipelineStatisticsQueryCmd>(
+            Command::BeginPipelineStatisticsQuery);
+        new (cmd) BeginPipelineStatisticsQueryCmd;
+        cmd->querySet = querySet;
+        cmd->queryIndex = queryIndex;
+    }
+
     void CommandBufferBuilder::BeginRenderPass(RenderPassBase* renderPass,
                                                FramebufferBase* framebuffer) {
         BeginRenderPassCmd* cmd = mAllocator.Allocate<BeginRenderPassCmd>(Command::BeginRenderPass);
@@ -725,6 +615,10 @@ namespace backend {
         mAllocator.Allocate<EndComputePassCmd>(Command::EndComputePass);
     }
 
+    void CommandBufferBuilder::EndPipelineStatisticsQuery() {
+        mAllocator.Allocate<EndPipelineStatisticsQueryCmd>(Command::EndPipelineStatisticsQuery);
+    }
+
     void CommandBufferBuilder::EndRenderPass() {
         mAllocator.Allocate<EndRenderPassCmd>(Command::EndRenderPass);
     }
@@ -733,6 +627,21 @@ namespace backend {
         mAllocator.Allocate<EndRenderSubpassCmd>(Command::EndRenderSubpass);
     }
 
+    void CommandBufferBuilder::ResolveQuerySet(QuerySetBase* querySet,
+                                               uint32_t firstQuery,
+                                               uint32_t queryCount,
+                                               BufferBase* destination,
+                                               uint32_t destinationOffset) {
+        ResolveQuerySetCmd* cmd =
+            mAllocator.Allocate<ResolveQuerySetCmd>(Command::ResolveQuerySet);
+        new (cmd) ResolveQuerySetCmd;
+        cmd->querySet = querySet;
+        cmd->firstQuery = firstQuery;
+        cmd->queryCount = queryCount;
+        cmd->destination.buffer = destination;
+        cmd->destination.offset = destinationOffset;
+    }
+
     void CommandBufferBuilder::SetComputePipeline(ComputePipelineBase* pipeline) {
         SetComputePipelineCmd* cmd =
             mAllocator.Allocate<SetComputePipelineCmd>(Command::SetComputePipeline);
@@ -844,6 +753,13 @@ namespace backend {
         cmd->usage = usage;
     }
 
+    void CommandBufferBuilder::WriteTimestamp(QuerySetBase* querySet, uint32_t queryIndex) {
+        WriteTimestampCmd* cmd = mAllocator.Allocate<WriteTimestampCmd>(Command::WriteTimestamp);
+        new (cmd) WriteTimestampCmd;
+        cmd->querySet = querySet;
+        cmd->queryIndex = queryIndex;
+    }
+
     void CommandBufferBuilder::MoveToIterator() {
         if (!mWasMovedToIterator) {
             mIterator = std::move(mAllocator);
@@ -45,10 +45,20 @@ namespace backend {
 
         DeviceBase* GetDevice();
 
+        // Used to validate the command buffer can be submitted to a queue type.
+        bool HasRenderPasses() const;
+        bool HasComputePasses() const;
+        bool HasPipelineStatisticsQueries() const;
+        const std::set<BufferBase*>& GetBuffersTransitioned() const;
+        const std::set<TextureBase*>& GetTexturesTransitioned() const;
+
       private:
         DeviceBase* mDevice;
         std::set<BufferBase*> mBuffersTransitioned;
         std::set<TextureBase*> mTexturesTransitioned;
+        bool mHasRenderPasses;
+        bool mHasComputePasses;
+        bool mHasPipelineStatisticsQueries;
     };
 
     class CommandBufferBuilder : public Builder<CommandBufferBase> {
@@ -62,6 +72,7 @@ namespace backend {
 
         // NXT API
         void BeginComputePass();
+        void BeginPipelineStatisticsQuery(QuerySetBase* querySet, uint32_t queryIndex);
         void BeginRenderPass(RenderPassBase* renderPass, FramebufferBase* framebuffer);
         void BeginRenderSubpass();
         void CopyBufferToBuffer(BufferBase* source,
@@ -101,8 +112,14 @@ namespace backend {
                           uint32_t firstIndex,
                           uint32_t firstInstance);
         void EndComputePass();
+        void EndPipelineStatisticsQuery();
         void EndRenderPass();
         void EndRenderSubpass();
+        void ResolveQuerySet(QuerySetBase* querySet,
+                             uint32_t firstQuery,
+                             uint32_t queryCount,
+                             BufferBase* destination,
+                             uint32_t destinationOffset);
         void SetPushConstants(nxt::ShaderStageBit stages,
                               uint32_t offset,
                               uint32_t count,
@@ -130,6 +147,7 @@ namespace backend {
 
         void TransitionBufferUsage(BufferBase* buffer, nxt::BufferUsageBit usage);
         void TransitionTextureUsage(TextureBase* texture, nxt::TextureUsageBit usage);
+        void WriteTimestamp(QuerySetBase* querySet, uint32_t queryIndex);
 
       private:
         friend class CommandBufferBase;
@@ -142,6 +160,9 @@ namespace backend {
         CommandIterator mIterator;
         bool mWasMovedToIterator = false;
         bool mWereCommandsAcquired = false;
+        bool mHasRenderPasses = false;
+        bool mHasComputePasses = false;
+        bool mHasPipelineStatisticsQueries = false;
     };
 
 }  // namespace backend
@@ -22,6 +22,7 @@
 #include "backend/Framebuffer.h"
 #include "backend/InputState.h"
 #include "backend/PipelineLayout.h"
+#include "backend/QuerySet.h"
 #include "backend/RenderPass.h"
 #include "backend/RenderPipeline.h"
 #include "backend/Texture.h"
@@ -127,6 +128,11 @@ namespace backend {
             mBuilder->HandleError("Can't end command buffer with an active compute pass");
             return false;
         }
+        if (mCurrentStatisticsQuerySet != nullptr) {
+            mBuilder->HandleError(
+                "Can't end command buffer with an active pipeline statistics query");
+            return false;
+        }
         return true;
     }
 
@@ -151,6 +157,31 @@ namespace backend {
         return true;
     }
 
+    bool CommandBufferStateTracker::ValidateCanResolveQuerySet(QuerySetBase* querySet,
+                                                               uint32_t firstQuery,
+                                                               uint32_t queryCount) const {
+        if (!ValidateQueryOutsideOfPasses()) {
+            return false;
+        }
+        if (firstQuery > querySet->GetCount() || queryCount > querySet->GetCount() - firstQuery) {
+            mBuilder->HandleError("Resolved queries out of range");
+            return false;
+        }
+
+        auto written = mQueriesWritten.find(querySet);
+        for (uint32_t i = firstQuery; i < firstQuery + queryCount; ++i) {
+            if (written == mQueriesWritten.end() || !written->second[i]) {
+                mBuilder->HandleError("Resolved query not written in the command buffer");
+                return false;
+            }
+        }
+        if (querySet == mCurrentStatisticsQuerySet) {
+            mBuilder->HandleError("Can't resolve the queries of an active query set");
+            return false;
+        }
+        return true;
+    }
+
     bool CommandBufferStateTracker::BeginComputePass() {
         if (mCurrentRenderPass != nullptr) {
             mBuilder->HandleError("Cannot begin a compute pass while a render pass is active");
@@ -268,6 +299,49 @@ namespace backend {
         return true;
     }
 
+    bool CommandBufferStateTracker::WriteTimestamp(QuerySetBase* querySet, uint32_t queryIndex) {
+        if (!ValidateQueryOutsideOfPasses() ||
+            !ValidateQuery(querySet, nxt::QueryType::Timestamp, queryIndex)) {
+            return false;
+        }
+
+        std::vector<bool>& written = mQueriesWritten[querySet];
+        written.resize(querySet->GetCount());
+        written[queryIndex] = true;
+        return true;
+    }
+
+    bool CommandBufferStateTracker::BeginPipelineStatisticsQuery(QuerySetBase* querySet,
+                                                                 uint32_t queryIndex) {
+        if (!ValidateQueryOutsideOfPasses() ||
+            !ValidateQuery(querySet, nxt::QueryType::PipelineStatistics, queryIndex)) {
+            return false;
+        }
+        if (mCurrentStatisticsQuerySet != nullptr) {
+            mBuilder->HandleError("A pipeline statistics query is already active");
+            return false;
+        }
+
+        std::vector<bool>& written = mQueriesWritten[querySet];
+        written.resize(querySet->GetCount());
+        written[queryIndex] = true;
+        mCurrentStatisticsQuerySet = querySet;
+        return true;
+    }
+
+    bool CommandBufferStateTracker::EndPipelineStatisticsQuery() {
+        if (!ValidateQueryOutsideOfPasses()) {
+            return false;
+        }
+        if (mCurrentStatisticsQuerySet == nullptr) {
+            mBuilder->HandleError("Can't end a pipeline statistics query without beginning one");
+            return false;
+        }
+
+        mCurrentStatisticsQuerySet = nullptr;
+        return true;
+    }
+
     bool CommandBufferStateTracker::SetComputePipeline(ComputePipelineBase* pipeline) {
         if (!mAspects[VALIDATION_ASPECT_COMPUTE_PASS]) {
             mBuilder->HandleError("A compute pass must be active when a compute pipeline is set");
@@ -434,6 +508,28 @@ namespace backend {
         return IsInternalTextureTransitionPossible(texture, usage);
     }
 
+    bool CommandBufferStateTracker::ValidateQueryOutsideOfPasses() const {
+        if (mCurrentRenderPass != nullptr || mAspects[VALIDATION_ASPECT_COMPUTE_PASS]) {
+            mBuilder->HandleError("Query commands can't be used inside a pass");
+            return false;
+        }
+        return true;
+    }
+
+    bool CommandBufferStateTracker::ValidateQuery(QuerySetBase* querySet,
+                                                  nxt::QueryType type,
+                                                  uint32_t queryIndex) const {
+        if (querySet->GetType() != type) {
+            mBuilder->HandleError("Query set has the wrong type for this command");
+            return false;
+        }
+        if (queryIndex >= querySet->GetCount()) {
+            mBuilder->HandleError("Query index out of range");
+            return false;
+        }
+        return true;
+    }
+
     bool CommandBufferStateTracker::RecomputeHaveAspectBindGroups() {
         if (mAspects[VALIDATION_ASPECT_BIND_GROUPS]) {
             return true;
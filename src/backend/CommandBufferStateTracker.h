@@ -22,6 +22,7 @@
 #include <bitset>
 #include <map>
 #include <set>
+#include <vector>
 
 namespace backend {
     class CommandBufferStateTracker {
@@ -39,6 +40,9 @@ namespace backend {
         bool ValidateCanDrawElements();
         bool ValidateEndCommandBuffer() const;
         bool ValidateSetPushConstants(nxt::ShaderStageBit stages);
+        bool ValidateCanResolveQuerySet(QuerySetBase* querySet,
+                                        uint32_t firstQuery,
+                                        uint32_t queryCount) const;
 
         // State-modifying methods
         bool BeginComputePass();
@@ -55,6 +59,9 @@ namespace backend {
         bool TransitionBufferUsage(BufferBase* buffer, nxt::BufferUsageBit usage);
         bool TransitionTextureUsage(TextureBase* texture, nxt::TextureUsageBit usage);
         bool EnsureTextureUsage(TextureBase* texture, nxt::TextureUsageBit usage);
+        bool WriteTimestamp(QuerySetBase* querySet, uint32_t queryIndex);
+        bool BeginPipelineStatisticsQuery(QuerySetBase* querySet, uint32_t queryIndex);
+        bool EndPipelineStatisticsQuery();
 
         // These collections are copied to the CommandBuffer at build time. These pointers will
         // remain valid since they are referenced by the bind groups which are referenced by this
@@ -85,6 +92,10 @@ namespace backend {
         bool IsExplicitTextureTransitionPossible(TextureBase* texture,
                                                  nxt::TextureUsageBit usage) const;
 
+        // Query helper functions
+        bool ValidateQueryOutsideOfPasses() const;
+        bool ValidateQuery(QuerySetBase* querySet, nxt::QueryType type, uint32_t queryIndex) const;
+
         // Queries for lazily evaluated aspects
         bool RecomputeHaveAspectBindGroups();
         bool RecomputeHaveAspectVertexBuffers();
@@ -112,6 +123,11 @@ namespace backend {
         RenderPassBase* mCurrentRenderPass = nullptr;
         FramebufferBase* mCurrentFramebuffer = nullptr;
         uint32_t mCurrentSubpass = 0;
+
+        // The queries written in the command buffer, that are the only ones it can resolve so
+        // that backends never read queries that have no result.
+        std::map<QuerySetBase*, std::vector<bool>> mQueriesWritten;
+        QuerySetBase* mCurrentStatisticsQuerySet = nullptr;
     };
 }  // namespace backend
 
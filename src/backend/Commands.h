@@ -21,157 +21,11 @@
 
 #include "nxt/nxtcpp.h"
 
-namespace backend {
-
-    // Definition of the commands that are present in the CommandIterator given by the
-    // CommandBufferBuilder. There are not defined in CommandBuffer.h to break some header
-    // dependencies: Ref<Object> needs Object to be defined.
-
-    enum class Command {
-        BeginComputePass,
-        BeginRenderPass,
-        BeginRenderSubpass,
-        CopyBufferToBuffer,
-        CopyBufferToTexture,
-        CopyTextureToBuffer,
-        Dispatch,
-        DrawArrays,
-        DrawElements,
-        EndComputePass,
-        EndRenderPass,
-        EndRenderSubpass,
-        SetComputePipeline,
-        SetRenderPipeline,
-        SetPushConstants,
-        SetStencilReference,
-        SetBlendColor,
-        SetBindGroup,
-        SetIndexBuffer,
-        SetVertexBuffers,
-        TransitionBufferUsage,
-        TransitionTextureUsage,
-    };
-
-    struct BeginComputePassCmd {};
-
-    struct BeginRenderPassCmd {
-        Ref<RenderPassBase> renderPass;
-        Ref<FramebufferBase> framebuffer;
-    };
-
-    struct BeginRenderSubpassCmd {};
-
-    struct BufferCopyLocation {
-        Ref<BufferBase> buffer;
-        uint32_t offset;
-    };
-
-    struct TextureCopyLocation {
-        Ref<TextureBase> texture;
-        uint32_t x, y, z;
-        uint32_t width, height, depth;
-        uint32_t level;
-    };
-
-    struct CopyBufferToBufferCmd {
-        BufferCopyLocation source;
-        BufferCopyLocation destination;
-        uint32_t size;
-    };
-
-    struct CopyBufferToTextureCmd {
-        BufferCopyLocation source;
-        TextureCopyLocation destination;
-        uint32_t rowPitch;
-    };
-
-    struct CopyTextureToBufferCmd {
-        TextureCopyLocation source;
-        BufferCopyLocation destination;
-        uint32_t rowPitch;
-    };
-
-    struct DispatchCmd {
-        uint32_t x;
-        uint32_t y;
-        uint32_t z;
-    };
-
-    struct DrawArraysCmd {
-        uint32_t vertexCount;
-        uint32_t instanceCount;
-        uint32_t firstVertex;
-        uint32_t firstInstance;
-    };
-
-    struct DrawElementsCmd {
-        uint32_t indexCount;
-        uint32_t instanceCount;
-        uint32_t firstIndex;
-        uint32_t firstInstance;
-    };
-
-    struct EndComputePassCmd {};
-
-    struct EndRenderPassCmd {};
-
-    struct EndRenderSubpassCmd {};
-
-    struct SetComputePipelineCmd {
-        Ref<ComputePipelineBase> pipeline;
-    };
-
-    struct SetRenderPipelineCmd {
-        Ref<RenderPipelineBase> pipeline;
-    };
-
-    struct SetPushConstantsCmd {
-        nxt::ShaderStageBit stages;
-        uint32_t offset;
-        uint32_t count;
-    };
-
-    struct SetStencilReferenceCmd {
-        uint32_t reference;
-    };
-
-    struct SetBlendColorCmd {
-        float r, g, b, a;
-    };
-
-    struct SetBindGroupCmd {
-        uint32_t index;
-        Ref<BindGroupBase> group;
-    };
-
-    struct SetIndexBufferCmd {
-        Ref<BufferBase> buffer;
-        uint32_t offset;
-    };
-
-    struct SetVertexBuffersCmd {
-        uint32_t startSlot;
-        uint32_t count;
-    };
-
-    struct TransitionBufferUsageCmd {
-        Ref<BufferBase> buffer;
-        nxt::BufferUsageBit usage;
-    };
-
-    struct TransitionTextureUsageCmd {
-        Ref<TextureBase> texture;
-        uint32_t startLevel;
-        uint32_t levelCount;
-        nxt::TextureUsageBit usage;
-    };
-
-    // This needs to be called before the CommandIterator is freed so that the Ref<> present in
-    // the commands have a chance to run their destructor and remove internal references.
-    class CommandIterator;
-    void FreeCommands(CommandIterator* commands);
-    void SkipCommand(CommandIterator* commands, Command type);
-
-}  // namespace backend
+// Definition of the commands that are present in the CommandIterator given by the
+// CommandBufferBuilder. There are not defined in CommandBuffer.h to break some header
+// dependencies: Ref<Object> needs Object to be defined.
+//
+// The commands, FreeCommands, SkipCommand and VisitCommands are generated from commands.json.
+#include "backend/Commands_autogen.h"
 
 #endif  // BACKEND_COMMANDS_H_
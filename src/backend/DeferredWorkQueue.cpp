@@ -0,0 +1,101 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "backend/DeferredWorkQueue.h"
+
+#include "common/Math.h"
+
+namespace backend {
+
+    namespace {
+        static constexpr size_t kInitialLaneSize = 16;
+    }  // namespace
+
+    DeferredWorkQueue::DeferredWorkQueue(uint32_t laneCount) : mLanes(laneCount) {
+        ASSERT(laneCount > 0);
+    }
+
+    DeferredWorkQueue::~DeferredWorkQueue() {
+        for (Lane& lane : mLanes) {
+            size_t mask = lane.slots.size() - 1;
+            for (size_t i = 0; i < lane.count; ++i) {
+                Slot& slot = lane.slots[(lane.head + i) & mask];
+                slot.manager(Operation::Destroy, &slot.storage, nullptr);
+            }
+        }
+    }
+
+    void DeferredWorkQueue::Tick(Serial completedSerial) {
+        for (uint32_t laneIndex = 0; laneIndex < mLanes.size(); ++laneIndex) {
+            // The lane is looked up on each iteration because the callbacks can grow it.
+            while (mLanes[laneIndex].count > 0) {
+                Lane& lane = mLanes[laneIndex];
+                Slot& front = lane.slots[lane.head];
+                if (front.serial > completedSerial) {
+                    break;
+                }
+
+                // The slot is removed before the callback runs so that the queue is consistent
+                // if the callback uses it.
+                lane.head = (lane.head + 1) & (lane.slots.size() - 1);
+                lane.count--;
+                mPendingCount--;
+                front.manager(Operation::Run, &front.storage, nullptr);
+            }
+        }
+    }
+
+    bool DeferredWorkQueue::Empty() const {
+        return mPendingCount == 0;
+    }
+
+    size_t DeferredWorkQueue::GetPendingCount() const {
+        return mPendingCount;
+    }
+
+    DeferredWorkQueue::Slot* DeferredWorkQueue::AllocateSlot(Serial serial, uint32_t laneIndex) {
+        ASSERT(laneIndex < mLanes.size());
+        Lane& lane = mLanes[laneIndex];
+        size_t mask = lane.slots.size() - 1;
+        ASSERT(lane.count == 0 || lane.slots[(lane.head + lane.count - 1) & mask].serial <= serial);
+
+        if (lane.count == lane.slots.size()) {
+            Grow(&lane);
+            mask = lane.slots.size() - 1;
+        }
+
+        Slot* slot = &lane.slots[(lane.head + lane.count) & mask];
+        slot->serial = serial;
+        lane.count++;
+        mPendingCount++;
+        return slot;
+    }
+
+    void DeferredWorkQueue::Grow(Lane* lane) {
+        size_t size = lane->slots.size();
+        std::vector<Slot> slots(size == 0 ? kInitialLaneSize : 2 * size);
+        ASSERT(IsPowerOfTwo(slots.size()));
+
+        for (size_t i = 0; i < lane->count; ++i) {
+            Slot& slot = lane->slots[(lane->head + i) & (size - 1)];
+            slots[i].serial = slot.serial;
+            slots[i].manager = slot.manager;
+            slot.manager(Operation::MoveTo, &slot.storage, &slots[i].storage);
+        }
+
+        lane->slots = std::move(slots);
+        lane->head = 0;
+    }
+
+}  // namespace backend
@@ -0,0 +1,127 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_DEFERREDWORKQUEUE_H_
+#define BACKEND_DEFERREDWORKQUEUE_H_
+
+#include "common/Assert.h"
+#include "common/Serial.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace backend {
+
+    // Work that must wait until the GPU completes a serial, like destroying objects it may still
+    // use or calling the callbacks of map requests. Each piece of work is a callback stored with
+    // its captures inside a slot of a ring, so that enqueuing is O(1) and doesn't allocate once
+    // the ring is large enough for the pending work.
+    //
+    // The work is split in lanes that are retired in order: Tick runs the completed work of the
+    // first lane before the work of the second lane, etc. This is used by backends that must
+    // destroy objects before the objects they depend on. In a lane the work runs in the order
+    // it is enqueued, and it must be enqueued in (not strictly) increasing serial order.
+    class DeferredWorkQueue {
+      public:
+        // The maximum size of a callback, its captures included.
+        static constexpr size_t kMaxCallbackSize = 4 * sizeof(void*);
+
+        explicit DeferredWorkQueue(uint32_t laneCount = 1);
+        // The work still pending is destroyed without running.
+        ~DeferredWorkQueue();
+
+        DeferredWorkQueue(const DeferredWorkQueue& other) = delete;
+        DeferredWorkQueue& operator=(const DeferredWorkQueue& other) = delete;
+
+        template <typename F>
+        void Enqueue(Serial serial, F&& callback, uint32_t lane = 0);
+
+        // Runs the work of the serials smaller or equal to completedSerial. The callbacks can
+        // enqueue more work, it runs in this Tick if its serial is completed.
+        void Tick(Serial completedSerial);
+
+        bool Empty() const;
+        size_t GetPendingCount() const;
+
+      private:
+        enum class Operation {
+            // Moves the callback out of the storage before running it so that the storage can be
+            // reused by the work the callback enqueues.
+            Run,
+            MoveTo,
+            Destroy,
+        };
+        using Manager = void (*)(Operation operation, void* storage, void* destination);
+
+        struct Slot {
+            Serial serial;
+            Manager manager;
+            typename std::aligned_storage<kMaxCallbackSize, alignof(void*)>::type storage;
+        };
+
+        // A ring of slots with a power of two size.
+        struct Lane {
+            std::vector<Slot> slots;
+            size_t head = 0;
+            size_t count = 0;
+        };
+
+        template <typename F>
+        static void Manage(Operation operation, void* storage, void* destination);
+
+        Slot* AllocateSlot(Serial serial, uint32_t lane);
+        void Grow(Lane* lane);
+
+        std::vector<Lane> mLanes;
+        size_t mPendingCount = 0;
+    };
+
+    template <typename F>
+    void DeferredWorkQueue::Enqueue(Serial serial, F&& callback, uint32_t lane) {
+        using Callback = typename std::decay<F>::type;
+        static_assert(sizeof(Callback) <= kMaxCallbackSize,
+                      "The callback is too large to be stored inline");
+        static_assert(alignof(Callback) <= alignof(void*), "The callback is overaligned");
+
+        Slot* slot = AllocateSlot(serial, lane);
+        new (&slot->storage) Callback(std::forward<F>(callback));
+        slot->manager = &Manage<Callback>;
+    }
+
+    template <typename F>
+    void DeferredWorkQueue::Manage(Operation operation, void* storage, void* destination) {
+        F* callback = static_cast<F*>(storage);
+        switch (operation) {
+            case Operation::Run: {
+                F movedCallback(std::move(*callback));
+                callback->~F();
+                movedCallback();
+            } break;
+            case Operation::MoveTo:
+                new (destination) F(std::move(*callback));
+                callback->~F();
+                break;
+            case Operation::Destroy:
+                callback->~F();
+                break;
+        }
+    }
+
+}  // namespace backend
+
+#endif  // BACKEND_DEFERREDWORKQUEUE_H_
@@ -21,9 +21,11 @@
 #include "backend/CommandBuffer.h"
 #include "backend/ComputePipeline.h"
 #include "backend/DepthStencilState.h"
+#include "backend/Fence.h"
 #include "backend/Framebuffer.h"
 #include "backend/InputState.h"
 #include "backend/PipelineLayout.h"
+#include "backend/QuerySet.h"
 #include "backend/Queue.h"
 #include "backend/RenderPass.h"
 #include "backend/RenderPipeline.h"
@@ -31,6 +33,7 @@
 #include "backend/ShaderModule.h"
 #include "backend/SwapChain.h"
 #include "backend/Texture.h"
+#include "common/Trace.h"
 
 #include <unordered_set>
 
@@ -51,9 +54,13 @@ namespace backend {
 
     DeviceBase::DeviceBase() {
         mCaches = new DeviceBase::Caches();
+        mFenceSignalTracker = new FenceSignalTracker(this);
+        mQueueSubmitTracker = new QueueSubmitTracker();
     }
 
     DeviceBase::~DeviceBase() {
+        delete mFenceSignalTracker;
+        delete mQueueSubmitTracker;
         delete mCaches;
     }
 
@@ -115,6 +122,9 @@ namespace backend {
     DepthStencilStateBuilder* DeviceBase::CreateDepthStencilStateBuilder() {
         return new DepthStencilStateBuilder(this);
     }
+    FenceBuilder* DeviceBase::CreateFenceBuilder() {
+        return new FenceBuilder(this);
+    }
     FramebufferBuilder* DeviceBase::CreateFramebufferBuilder() {
         return new FramebufferBuilder(this);
     }
@@ -124,6 +134,9 @@ namespace backend {
     PipelineLayoutBuilder* DeviceBase::CreatePipelineLayoutBuilder() {
         return new PipelineLayoutBuilder(this);
     }
+    QuerySetBuilder* DeviceBase::CreateQuerySetBuilder() {
+        return new QuerySetBuilder(this);
+    }
     QueueBuilder* DeviceBase::CreateQueueBuilder() {
         return new QueueBuilder(this);
     }
@@ -146,8 +159,33 @@ namespace backend {
         return new TextureBuilder(this);
     }
 
+    FenceSignalTracker* DeviceBase::GetFenceSignalTracker() {
+        return mFenceSignalTracker;
+    }
+
+    QueueSubmitTracker* DeviceBase::GetQueueSubmitTracker() {
+        return mQueueSubmitTracker;
+    }
+
+    void DeviceBase::FlushPendingSubmits() {
+        if (mQueueWithPendingSubmits != nullptr) {
+            mQueueWithPendingSubmits->Flush();
+        }
+    }
+
+    QueueBase* DeviceBase::GetQueueWithPendingSubmits() const {
+        return mQueueWithPendingSubmits;
+    }
+
+    void DeviceBase::SetQueueWithPendingSubmits(QueueBase* queue) {
+        mQueueWithPendingSubmits = queue;
+    }
+
     void DeviceBase::Tick() {
+        NXT_TRACE_EVENT("backend", "DeviceBase::Tick");
+        FlushPendingSubmits();
         TickImpl();
+        mFenceSignalTracker->Tick(GetCompletedCommandSerial());
     }
 
     void DeviceBase::Reference() {
@@ -159,6 +197,8 @@ namespace backend {
         ASSERT(mRefCount != 0);
         mRefCount--;
         if (mRefCount == 0) {
+            // The batched command buffers are submitted while the backend still exists.
+            FlushPendingSubmits();
             delete this;
         }
     }
@@ -17,6 +17,7 @@
 
 #include "backend/Forward.h"
 #include "backend/RefCounted.h"
+#include "common/Serial.h"
 
 #include "nxt/nxtcpp.h"
 
@@ -46,6 +47,7 @@ namespace backend {
         virtual FramebufferBase* CreateFramebuffer(FramebufferBuilder* builder) = 0;
         virtual InputStateBase* CreateInputState(InputStateBuilder* builder) = 0;
         virtual PipelineLayoutBase* CreatePipelineLayout(PipelineLayoutBuilder* builder) = 0;
+        virtual QuerySetBase* CreateQuerySet(QuerySetBuilder* builder) = 0;
         virtual QueueBase* CreateQueue(QueueBuilder* builder) = 0;
         virtual RenderPassBase* CreateRenderPass(RenderPassBuilder* builder) = 0;
         virtual RenderPipelineBase* CreateRenderPipeline(RenderPipelineBuilder* builder) = 0;
@@ -57,6 +59,20 @@ namespace backend {
 
         virtual void TickImpl() = 0;
 
+        // The serial of the last commands submitted to the GPU and of the last ones it finished,
+        // used to complete the fences when the commands submitted before their signal are done.
+        virtual Serial GetLastSubmittedCommandSerial() const = 0;
+        virtual Serial GetCompletedCommandSerial() const = 0;
+        FenceSignalTracker* GetFenceSignalTracker();
+        QueueSubmitTracker* GetQueueSubmitTracker();
+
+        // Flushes the command buffers batched by the queues, before operations that need them
+        // to be submitted to the backend.
+        void FlushPendingSubmits();
+        // The queue that has batched command buffers, only one can at a time.
+        QueueBase* GetQueueWithPendingSubmits() const;
+        void SetQueueWithPendingSubmits(QueueBase* queue);
+
         // Many NXT objects are completely immutable once created which means that if two
         // builders are given the same arguments, they can return the same object. Reusing
         // objects will help make comparisons between objects by a single pointer comparison.
@@ -83,9 +99,11 @@ namespace backend {
         CommandBufferBuilder* CreateCommandBufferBuilder();
         ComputePipelineBuilder* CreateComputePipelineBuilder();
         DepthStencilStateBuilder* CreateDepthStencilStateBuilder();
+        FenceBuilder* CreateFenceBuilder();
         FramebufferBuilder* CreateFramebufferBuilder();
         InputStateBuilder* CreateInputStateBuilder();
         PipelineLayoutBuilder* CreatePipelineLayoutBuilder();
+        QuerySetBuilder* CreateQuerySetBuilder();
         QueueBuilder* CreateQueueBuilder();
         RenderPassBuilder* CreateRenderPassBuilder();
         RenderPipelineBuilder* CreateRenderPipelineBuilder();
@@ -104,6 +122,9 @@ namespace backend {
         // additional includes.
         struct Caches;
         Caches* mCaches = nullptr;
+        FenceSignalTracker* mFenceSignalTracker = nullptr;
+        QueueSubmitTracker* mQueueSubmitTracker = nullptr;
+        QueueBase* mQueueWithPendingSubmits = nullptr;
 
         nxt::DeviceErrorCallback mErrorCallback = nullptr;
         nxt::CallbackUserdata mErrorUserdata = 0;
@@ -0,0 +1,140 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "backend/Fence.h"
+
+#include "backend/Device.h"
+#include "common/Assert.h"
+
+#include <vector>
+
+namespace backend {
+
+    // FenceBase
+
+    FenceBase::FenceBase(FenceBuilder* builder) : mDevice(builder->mDevice) {
+    }
+
+    FenceBase::~FenceBase() {
+        // Callbacks need to be fired in all cases, as they can handle freeing resources so we
+        // call them with "Unknown" status.
+        for (auto& it : mRequests) {
+            it.second.callback(NXT_FENCE_COMPLETION_STATUS_UNKNOWN, it.second.userdata);
+        }
+        mRequests.clear();
+    }
+
+    DeviceBase* FenceBase::GetDevice() {
+        return mDevice;
+    }
+
+    uint64_t FenceBase::GetCompletedValue() const {
+        return mCompletedValue;
+    }
+
+    void FenceBase::OnCompletion(uint64_t value,
+                                 nxtFenceOnCompletionCallback callback,
+                                 nxtCallbackUserdata userdata) {
+        if (value > mSignaledValue) {
+            mDevice->HandleError("Value greater than fence signaled value");
+            callback(NXT_FENCE_COMPLETION_STATUS_ERROR, userdata);
+            return;
+        }
+
+        if (value <= mCompletedValue) {
+            callback(NXT_FENCE_COMPLETION_STATUS_SUCCESS, userdata);
+            return;
+        }
+
+        OnCompletionData request;
+        request.callback = callback;
+        request.userdata = userdata;
+        mRequests.emplace(value, request);
+    }
+
+    uint64_t FenceBase::GetSignaledValue() const {
+        return mSignaledValue;
+    }
+
+    void FenceBase::SetSignaledValue(uint64_t value, const Signal& signal) {
+        ASSERT(value > mSignaledValue);
+        mSignaledValue = value;
+        mSignals[value] = signal;
+    }
+
+    void FenceBase::SetCompletedValue(uint64_t value) {
+        ASSERT(value <= mSignaledValue);
+        ASSERT(value > mCompletedValue);
+        mCompletedValue = value;
+
+        // Waiting on a completed value is the same as waiting on the last completed signal
+        // since the GPU already finished the commands before it.
+        mSignals.erase(mSignals.begin(), mSignals.find(value));
+
+        // Requests are removed before their callback is called as it can add new ones.
+        while (!mRequests.empty() && mRequests.begin()->first <= mCompletedValue) {
+            OnCompletionData request = mRequests.begin()->second;
+            mRequests.erase(mRequests.begin());
+            request.callback(NXT_FENCE_COMPLETION_STATUS_SUCCESS, request.userdata);
+        }
+    }
+
+    const FenceBase::Signal* FenceBase::GetSignal(uint64_t value) const {
+        auto it = mSignals.lower_bound(value);
+        if (it == mSignals.end()) {
+            return nullptr;
+        }
+        return &it->second;
+    }
+
+    // FenceBuilder
+
+    FenceBuilder::FenceBuilder(DeviceBase* device) : Builder(device) {
+    }
+
+    FenceBase* FenceBuilder::GetResultImpl() {
+        // Fences don't have backend-specific state, see FenceSignalTracker.
+        return new FenceBase(this);
+    }
+
+    // FenceSignalTracker
+
+    FenceSignalTracker::FenceSignalTracker(DeviceBase* device) : mDevice(device) {
+    }
+
+    FenceSignalTracker::~FenceSignalTracker() {
+    }
+
+    void FenceSignalTracker::UpdateFenceOnComplete(FenceBase* fence, uint64_t value) {
+        FenceInFlight fenceInFlight;
+        fenceInFlight.fence = fence;
+        fenceInFlight.value = value;
+        mFencesInFlight.Enqueue(std::move(fenceInFlight), mDevice->GetLastSubmittedCommandSerial());
+    }
+
+    void FenceSignalTracker::Tick(Serial finishedSerial) {
+        // The fences are removed from the queue before they are completed because the callbacks
+        // can signal fences again.
+        std::vector<FenceInFlight> completed;
+        for (FenceInFlight& fenceInFlight : mFencesInFlight.IterateUpTo(finishedSerial)) {
+            completed.push_back(std::move(fenceInFlight));
+        }
+        mFencesInFlight.ClearUpTo(finishedSerial);
+
+        for (FenceInFlight& fenceInFlight : completed) {
+            fenceInFlight.fence->SetCompletedValue(fenceInFlight.value);
+        }
+    }
+
+}  // namespace backend
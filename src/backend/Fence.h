@@ -0,0 +1,109 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_FENCE_H_
+#define BACKEND_FENCE_H_
+
+#include "backend/Builder.h"
+#include "backend/Forward.h"
+#include "backend/Queue.h"
+#include "backend/RefCounted.h"
+#include "common/SerialQueue.h"
+
+#include "nxt/nxtcpp.h"
+
+#include <map>
+
+namespace backend {
+
+    // Fences are signaled with increasing values on a queue, and reach each value when the GPU
+    // finishes the commands submitted before it was signaled. They are implemented the same way
+    // for all backends on top of the serials of their submits, see FenceSignalTracker.
+    class FenceBase : public RefCounted {
+      public:
+        FenceBase(FenceBuilder* builder);
+        ~FenceBase();
+
+        DeviceBase* GetDevice();
+
+        // NXT API
+        uint64_t GetCompletedValue() const;
+        void OnCompletion(uint64_t value,
+                          nxtFenceOnCompletionCallback callback,
+                          nxtCallbackUserdata userdata);
+
+      private:
+        friend class FenceSignalTracker;
+        friend class QueueBase;
+
+        // What the queues waiting on the fence wait for: the submits of each queue type before
+        // the signal and the serial of the last one.
+        struct Signal {
+            QueueSubmitClock clock;
+            Serial serial;
+        };
+
+        uint64_t GetSignaledValue() const;
+        void SetSignaledValue(uint64_t value, const Signal& signal);
+        void SetCompletedValue(uint64_t value);
+        // Returns the first signal with a value greater than or equal to value, nullptr if the
+        // fence was never signaled.
+        const Signal* GetSignal(uint64_t value) const;
+
+        struct OnCompletionData {
+            nxtFenceOnCompletionCallback callback = nullptr;
+            nxtCallbackUserdata userdata = 0;
+        };
+
+        DeviceBase* mDevice;
+        uint64_t mSignaledValue = 0;
+        uint64_t mCompletedValue = 0;
+        std::multimap<uint64_t, OnCompletionData> mRequests;
+        // The signals that are not completed yet, and the last completed one.
+        std::map<uint64_t, Signal> mSignals;
+    };
+
+    class FenceBuilder : public Builder<FenceBase> {
+      public:
+        FenceBuilder(DeviceBase* device);
+
+      private:
+        friend class FenceBase;
+
+        FenceBase* GetResultImpl() override;
+    };
+
+    // Owned by the device, it remembers the serial of the last submit when fences are signaled
+    // and completes the signals when the device is ticked after the GPU finished that submit.
+    class FenceSignalTracker {
+      public:
+        FenceSignalTracker(DeviceBase* device);
+        ~FenceSignalTracker();
+
+        void UpdateFenceOnComplete(FenceBase* fence, uint64_t value);
+        void Tick(Serial finishedSerial);
+
+      private:
+        struct FenceInFlight {
+            Ref<FenceBase> fence;
+            uint64_t value;
+        };
+
+        DeviceBase* mDevice;
+        SerialQueue<FenceInFlight> mFencesInFlight;
+    };
+
+}  // namespace backend
+
+#endif  // BACKEND_FENCE_H_
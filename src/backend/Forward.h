@@ -35,14 +35,20 @@ namespace backend {
     class CommandBufferBuilder;
     class DepthStencilStateBase;
     class DepthStencilStateBuilder;
+    class FenceBase;
+    class FenceBuilder;
+    class FenceSignalTracker;
     class FramebufferBase;
     class FramebufferBuilder;
     class InputStateBase;
     class InputStateBuilder;
     class PipelineLayoutBase;
     class PipelineLayoutBuilder;
+    class QuerySetBase;
+    class QuerySetBuilder;
     class QueueBase;
     class QueueBuilder;
+    class QueueSubmitTracker;
     class RenderPassBase;
     class RenderPassBuilder;
     class RenderPipelineBase;
@@ -0,0 +1,123 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "backend/QuerySet.h"
+
+#include "backend/Device.h"
+
+#include <bitset>
+
+namespace backend {
+
+    // QuerySetBase
+
+    QuerySetBase::QuerySetBase(QuerySetBuilder* builder)
+        : mDevice(builder->mDevice),
+          mType(builder->mType),
+          mCount(builder->mCount),
+          mPipelineStatistics(builder->mPipelineStatistics) {
+    }
+
+    DeviceBase* QuerySetBase::GetDevice() const {
+        return mDevice;
+    }
+
+    nxt::QueryType QuerySetBase::GetType() const {
+        return mType;
+    }
+
+    uint32_t QuerySetBase::GetCount() const {
+        return mCount;
+    }
+
+    nxt::PipelineStatisticBit QuerySetBase::GetPipelineStatistics() const {
+        return mPipelineStatistics;
+    }
+
+    uint32_t QuerySetBase::GetResultsPerQuery() const {
+        if (mType == nxt::QueryType::Timestamp) {
+            return 1;
+        }
+        return static_cast<uint32_t>(
+            std::bitset<32>(static_cast<uint32_t>(mPipelineStatistics)).count());
+    }
+
+    // QuerySetBuilder
+
+    enum QuerySetSetProperties {
+        QUERY_SET_PROPERTY_TYPE = 0x1,
+        QUERY_SET_PROPERTY_COUNT = 0x2,
+        QUERY_SET_PROPERTY_PIPELINE_STATISTICS = 0x4,
+    };
+
+    QuerySetBuilder::QuerySetBuilder(DeviceBase* device) : Builder(device) {
+    }
+
+    QuerySetBase* QuerySetBuilder::GetResultImpl() {
+        constexpr int requiredProperties = QUERY_SET_PROPERTY_TYPE | QUERY_SET_PROPERTY_COUNT;
+        if ((mPropertiesSet & requiredProperties) != requiredProperties) {
+            HandleError("Query set missing properties");
+            return nullptr;
+        }
+
+        if (mCount == 0) {
+            HandleError("Query set count must be greater than 0");
+            return nullptr;
+        }
+
+        if (mType == nxt::QueryType::PipelineStatistics &&
+            mPipelineStatistics == nxt::PipelineStatisticBit::None) {
+            HandleError("Pipeline statistics query set without statistics");
+            return nullptr;
+        }
+        if (mType != nxt::QueryType::PipelineStatistics &&
+            mPipelineStatistics != nxt::PipelineStatisticBit::None) {
+            HandleError("Pipeline statistics set on a query set of another type");
+            return nullptr;
+        }
+
+        return mDevice->CreateQuerySet(this);
+    }
+
+    void QuerySetBuilder::SetType(nxt::QueryType type) {
+        if ((mPropertiesSet & QUERY_SET_PROPERTY_TYPE) != 0) {
+            HandleError("Query set type property set multiple times");
+            return;
+        }
+
+        mType = type;
+        mPropertiesSet |= QUERY_SET_PROPERTY_TYPE;
+    }
+
+    void QuerySetBuilder::SetCount(uint32_t count) {
+        if ((mPropertiesSet & QUERY_SET_PROPERTY_COUNT) != 0) {
+            HandleError("Query set count property set multiple times");
+            return;
+        }
+
+        mCount = count;
+        mPropertiesSet |= QUERY_SET_PROPERTY_COUNT;
+    }
+
+    void QuerySetBuilder::SetPipelineStatistics(nxt::PipelineStatisticBit statistics) {
+        if ((mPropertiesSet & QUERY_SET_PROPERTY_PIPELINE_STATISTICS) != 0) {
+            HandleError("Query set pipeline statistics property set multiple times");
+            return;
+        }
+
+        mPipelineStatistics = statistics;
+        mPropertiesSet |= QUERY_SET_PROPERTY_PIPELINE_STATISTICS;
+    }
+
+}  // namespace backend
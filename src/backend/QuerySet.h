@@ -0,0 +1,71 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_QUERYSET_H_
+#define BACKEND_QUERYSET_H_
+
+#include "backend/Builder.h"
+#include "backend/Forward.h"
+#include "backend/RefCounted.h"
+
+#include "nxt/nxtcpp.h"
+
+namespace backend {
+
+    // Each result is resolved as a uint64_t. Timestamps are in ticks of the GPU timestamp
+    // counter, which are nanoseconds for the OpenGL and null backends.
+    static constexpr uint32_t kQueryResultSize = sizeof(uint64_t);
+
+    class QuerySetBase : public RefCounted {
+      public:
+        QuerySetBase(QuerySetBuilder* builder);
+
+        DeviceBase* GetDevice() const;
+        nxt::QueryType GetType() const;
+        uint32_t GetCount() const;
+        nxt::PipelineStatisticBit GetPipelineStatistics() const;
+        // 1 for timestamps and the number of statistics for pipeline statistics.
+        uint32_t GetResultsPerQuery() const;
+
+      private:
+        DeviceBase* mDevice;
+        nxt::QueryType mType;
+        uint32_t mCount;
+        nxt::PipelineStatisticBit mPipelineStatistics;
+    };
+
+    class QuerySetBuilder : public Builder<QuerySetBase> {
+      public:
+        QuerySetBuilder(DeviceBase* device);
+
+        // NXT API
+        void SetType(nxt::QueryType type);
+        void SetCount(uint32_t count);
+        void SetPipelineStatistics(nxt::PipelineStatisticBit statistics);
+
+      private:
+        friend class QuerySetBase;
+
+        QuerySetBase* GetResultImpl() override;
+
+        int mPropertiesSet = 0;
+
+        nxt::QueryType mType = nxt::QueryType::Timestamp;
+        uint32_t mCount = 0;
+        nxt::PipelineStatisticBit mPipelineStatistics = nxt::PipelineStatisticBit::None;
+    };
+
+}  // namespace backend
+
+#endif  // BACKEND_QUERYSET_H_
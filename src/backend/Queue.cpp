@@ -14,22 +14,159 @@
 
 #include "backend/Queue.h"
 
+#include "backend/Buffer.h"
 #include "backend/CommandBuffer.h"
 #include "backend/Device.h"
+#include "backend/Fence.h"
+#include "backend/Texture.h"
+#include "common/Trace.h"
+
+#include <algorithm>
 
 namespace backend {
 
     // QueueBase
 
-    QueueBase::QueueBase(QueueBuilder* builder) : mDevice(builder->mDevice) {
+    QueueBase::QueueBase(QueueBuilder* builder)
+        : mDevice(builder->mDevice), mType(builder->mType) {
     }
 
     DeviceBase* QueueBase::GetDevice() {
         return mDevice;
     }
 
+    nxt::QueueType QueueBase::GetType() const {
+        return mType;
+    }
+
+    void QueueBase::Flush() {
+        // Empty submits are batched too so that they still make a backend submit.
+        if (mDevice->GetQueueWithPendingSubmits() != this) {
+            return;
+        }
+
+        NXT_TRACE_EVENT("backend", "QueueBase::Flush");
+
+        // Backends can tick the device while submitting, which mustn't flush the queue again.
+        mDevice->SetQueueWithPendingSubmits(nullptr);
+        SubmitImpl(static_cast<uint32_t>(mPendingCommands.size()), mPendingCommands.data());
+
+        for (CommandBufferBase* command : mPendingCommands) {
+            command->ReleaseInternal();
+        }
+        mPendingCommands.clear();
+
+        // Last as it can delete the queue.
+        ReleaseInternal();
+    }
+
+    void QueueBase::Signal(FenceBase* fence, uint64_t value) {
+        if (value <= fence->GetSignaledValue()) {
+            mDevice->HandleError("Fence value less than or equal to signaled value");
+            return;
+        }
+
+        // The fence is signaled after the command buffers batched so far.
+        Flush();
+
+        FenceBase::Signal signal;
+        signal.clock = mDevice->GetQueueSubmitTracker()->GetClock(mType);
+        signal.serial = mDevice->GetLastSubmittedCommandSerial();
+        fence->SetSignaledValue(value, signal);
+        mDevice->GetFenceSignalTracker()->UpdateFenceOnComplete(fence, value);
+    }
+
+    void QueueBase::Wait(FenceBase* fence, uint64_t value) {
+        if (value > fence->GetSignaledValue()) {
+            mDevice->HandleError("Value greater than fence signaled value");
+            return;
+        }
+
+        const FenceBase::Signal* signal = fence->GetSignal(value);
+        if (signal == nullptr) {
+            return;
+        }
+
+        // The command buffers batched before the wait don't need to wait.
+        Flush();
+
+        mDevice->GetQueueSubmitTracker()->Synchronize(mType, signal->clock);
+        WaitImpl(signal->serial);
+    }
+
+    void QueueBase::WaitImpl(Serial) {
+    }
+
     bool QueueBase::ValidateSubmitCommand(CommandBufferBase* command) {
-        return command->ValidateResourceUsagesImmediate();
+        if (!command->ValidateResourceUsagesImmediate()) {
+            return false;
+        }
+
+        if (mType != nxt::QueueType::Graphics && command->HasRenderPasses()) {
+            mDevice->HandleError("Render passes can only be submitted to graphics queues");
+            return false;
+        }
+        if (mType == nxt::QueueType::Transfer && command->HasComputePasses()) {
+            mDevice->HandleError("Compute passes cannot be submitted to transfer queues");
+            return false;
+        }
+        if (mType == nxt::QueueType::Transfer && command->HasPipelineStatisticsQueries()) {
+            mDevice->HandleError(
+                "Pipeline statistics queries cannot be submitted to transfer queues");
+            return false;
+        }
+
+        // Another queue type can use a resource only once it waited on the submits of the
+        // owner, which makes ownership transfers explicit like in Vulkan.
+        const QueueSubmitClock& clock = mDevice->GetQueueSubmitTracker()->GetClock(mType);
+        auto IsOwnedByOtherQueue = [&](const QueueOwnership& ownership) -> bool {
+            return ownership.queueType != mType &&
+                   ownership.submit > clock[static_cast<uint32_t>(ownership.queueType)];
+        };
+        for (BufferBase* buffer : command->GetBuffersTransitioned()) {
+            if (IsOwnedByOtherQueue(buffer->GetQueueOwnership())) {
+                mDevice->HandleError("Buffer used by another queue type without waiting on it");
+                return false;
+            }
+        }
+        for (TextureBase* texture : command->GetTexturesTransitioned()) {
+            if (IsOwnedByOtherQueue(texture->GetQueueOwnership())) {
+                mDevice->HandleError("Texture used by another queue type without waiting on it");
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    uint64_t QueueBase::StartSubmit() {
+        return mDevice->GetQueueSubmitTracker()->Submit(mType);
+    }
+
+    void QueueBase::TakeOwnership(CommandBufferBase* command, uint64_t submit) {
+        QueueOwnership ownership;
+        ownership.queueType = mType;
+        ownership.submit = submit;
+
+        for (BufferBase* buffer : command->GetBuffersTransitioned()) {
+            buffer->SetQueueOwnership(ownership);
+        }
+        for (TextureBase* texture : command->GetTexturesTransitioned()) {
+            texture->SetQueueOwnership(ownership);
+        }
+    }
+
+    void QueueBase::OnCommandsBatched() {
+        if (mDevice->GetQueueWithPendingSubmits() != this) {
+            // The command buffers batched by another queue were submitted before these ones.
+            mDevice->FlushPendingSubmits();
+            mDevice->SetQueueWithPendingSubmits(this);
+            ReferenceInternal();
+        }
+
+        if (mPendingCommands.size() >= kMaxBatchedCommandBuffers) {
+            Flush();
+        }
     }
 
     // QueueBuilder
@@ -41,4 +178,26 @@ namespace backend {
         return mDevice->CreateQueue(this);
     }
 
+    void QueueBuilder::SetType(nxt::QueueType type) {
+        mType = type;
+    }
+
+    // QueueSubmitTracker
+
+    const QueueSubmitClock& QueueSubmitTracker::GetClock(nxt::QueueType type) const {
+        return mClocks[static_cast<uint32_t>(type)];
+    }
+
+    uint64_t QueueSubmitTracker::Submit(nxt::QueueType type) {
+        uint32_t index = static_cast<uint32_t>(type);
+        return ++mClocks[index][index];
+    }
+
+    void QueueSubmitTracker::Synchronize(nxt::QueueType type, const QueueSubmitClock& clock) {
+        QueueSubmitClock& ownClock = mClocks[static_cast<uint32_t>(type)];
+        for (uint32_t i = 0; i < kNumQueueTypes; ++i) {
+            ownClock[i] = std::max(ownClock[i], clock[i]);
+        }
+    }
+
 }  // namespace backend
@@ -18,17 +18,39 @@
 #include "backend/Builder.h"
 #include "backend/Forward.h"
 #include "backend/RefCounted.h"
+#include "common/Constants.h"
+#include "common/Serial.h"
 
 #include "nxt/nxtcpp.h"
 
+#include <array>
+#include <vector>
+
 namespace backend {
 
+    // The number of command buffers a queue batches before flushing them to the backend.
+    static constexpr uint32_t kMaxBatchedCommandBuffers = 64;
+
+    // For each queue type, the number of its submits that are known to be ordered before some
+    // point, like a vector clock.
+    using QueueSubmitClock = std::array<uint64_t, kNumQueueTypes>;
+
+    // The queue type that last used a resource in a submit. Submits are numbered from 1 for each
+    // queue type so that 0 means the resource was never used.
+    struct QueueOwnership {
+        nxt::QueueType queueType = nxt::QueueType::Graphics;
+        uint64_t submit = 0;
+    };
+
     class QueueBase : public RefCounted {
       public:
         QueueBase(QueueBuilder* builder);
 
         DeviceBase* GetDevice();
+        nxt::QueueType GetType() const;
 
+        // Also makes the queue type the owner of the resources used by the command buffers when
+        // they are valid.
         template <typename T>
         bool ValidateSubmit(uint32_t numCommands, T* const* commands) {
             static_assert(std::is_base_of<CommandBufferBase, T>::value,
@@ -39,22 +61,87 @@ namespace backend {
                     return false;
                 }
             }
+
+            uint64_t submit = StartSubmit();
+            for (uint32_t i = 0; i < numCommands; ++i) {
+                TakeOwnership(commands[i], submit);
+            }
             return true;
         }
 
+        // Submits are batched and reach the backend as a single submit when the queue is
+        // flushed. This happens explicitly with Flush, when too many command buffers are
+        // batched, and before the operations that depend on the commands being executed like
+        // presenting, mapping buffers and fences. Only one queue batches at a time so that the
+        // command buffers of all the queues reach the backend in the order of their submits.
+        template <typename T>
+        void Submit(uint32_t numCommands, T* const* commands) {
+            static_assert(std::is_base_of<CommandBufferBase, T>::value,
+                          "invalid command buffer type");
+
+            for (uint32_t i = 0; i < numCommands; ++i) {
+                commands[i]->ReferenceInternal();
+                mPendingCommands.push_back(commands[i]);
+            }
+            OnCommandsBatched();
+        }
+
+        // NXT API
+        void Flush();
+        void Signal(FenceBase* fence, uint64_t value);
+        void Wait(FenceBase* fence, uint64_t value);
+
       private:
+        // Submits the command buffers of one or more Submit calls, in order.
+        virtual void SubmitImpl(uint32_t numCommands, CommandBufferBase* const* commands) = 0;
+
+        // Makes the next submits of the queue wait for the GPU to finish the commands up to
+        // signalSerial. Backends that execute all the queue types in order don't need to do
+        // anything.
+        virtual void WaitImpl(Serial signalSerial);
+
         bool ValidateSubmitCommand(CommandBufferBase* command);
+        uint64_t StartSubmit();
+        void TakeOwnership(CommandBufferBase* command, uint64_t submit);
+        void OnCommandsBatched();
 
         DeviceBase* mDevice;
+        nxt::QueueType mType;
+
+        // The command buffers submitted since the last flush, with an internal reference. The
+        // queue also references itself while it has some so that they are flushed even if the
+        // application releases it.
+        std::vector<CommandBufferBase*> mPendingCommands;
     };
 
     class QueueBuilder : public Builder<QueueBase> {
       public:
         QueueBuilder(DeviceBase* device);
 
+        // NXT API
+        void SetType(nxt::QueueType type);
+
       private:
         friend class QueueBase;
         QueueBase* GetResultImpl() override;
+
+        nxt::QueueType mType = nxt::QueueType::Graphics;
+    };
+
+    // Owned by the device, it tracks the order between the submits of the queue types that
+    // fences establish, to check that resources are used by another queue type only after the
+    // submits of their owner.
+    class QueueSubmitTracker {
+      public:
+        // The submits ordered before the next submit of the queue type, including its own.
+        const QueueSubmitClock& GetClock(nxt::QueueType type) const;
+        // Returns the number of the new submit.
+        uint64_t Submit(nxt::QueueType type);
+        // Orders the submits of the clock before the next submits of the queue type.
+        void Synchronize(nxt::QueueType type, const QueueSubmitClock& clock);
+
+      private:
+        std::array<QueueSubmitClock, kNumQueueTypes> mClocks = {};
     };
 
 }  // namespace backend
@@ -72,6 +72,9 @@ namespace backend {
     }
 
     void SwapChainBase::Present(TextureBase* texture) {
+        // The texture is transitioned to the present usage by a submitted command buffer.
+        mDevice->FlushPendingSubmits();
+
         if (texture != mLastNextTexture) {
             mDevice->HandleError("Tried to present something other than the last NextTexture");
             return;
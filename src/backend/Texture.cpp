@@ -148,7 +148,18 @@ namespace backend {
         mCurrentUsage = usage;
     }
 
+    const QueueOwnership& TextureBase::GetQueueOwnership() const {
+        return mQueueOwnership;
+    }
+
+    void TextureBase::SetQueueOwnership(const QueueOwnership& ownership) {
+        mQueueOwnership = ownership;
+    }
+
     void TextureBase::TransitionUsage(nxt::TextureUsageBit usage) {
+        // The usage of the texture depends on the command buffers submitted before.
+        mDevice->FlushPendingSubmits();
+
         if (!IsTransitionPossible(usage)) {
             mDevice->HandleError("Texture frozen or usage not allowed");
             return;
@@ -158,6 +169,8 @@ namespace backend {
     }
 
     void TextureBase::FreezeUsage(nxt::TextureUsageBit usage) {
+        mDevice->FlushPendingSubmits();
+
         if (!IsTransitionPossible(usage)) {
             mDevice->HandleError("Texture frozen or usage not allowed");
             return;
@@ -17,6 +17,7 @@
 
 #include "backend/Builder.h"
 #include "backend/Forward.h"
+#include "backend/Queue.h"
 #include "backend/RefCounted.h"
 
 #include "nxt/nxtcpp.h"
@@ -45,6 +46,8 @@ namespace backend {
         static bool IsUsagePossible(nxt::TextureUsageBit allowedUsage, nxt::TextureUsageBit usage);
         bool IsTransitionPossible(nxt::TextureUsageBit usage) const;
         void UpdateUsageInternal(nxt::TextureUsageBit usage);
+        const QueueOwnership& GetQueueOwnership() const;
+        void SetQueueOwnership(const QueueOwnership& ownership);
 
         DeviceBase* GetDevice() const;
 
@@ -66,6 +69,7 @@ namespace backend {
         nxt::TextureUsageBit mAllowedUsage = nxt::TextureUsageBit::None;
         nxt::TextureUsageBit mCurrentUsage = nxt::TextureUsageBit::None;
         bool mIsFrozen = false;
+        QueueOwnership mQueueOwnership;
     };
 
     class TextureBuilder : public Builder<TextureBase> {
@@ -78,11 +78,21 @@ namespace backend {
         using BackendType = typename BackendTraits::InputStateType;
     };
 
+    template <typename BackendTraits>
+    struct ToBackendTraits<FenceBase, BackendTraits> {
+        using BackendType = typename BackendTraits::FenceType;
+    };
+
     template <typename BackendTraits>
     struct ToBackendTraits<PipelineLayoutBase, BackendTraits> {
         using BackendType = typename BackendTraits::PipelineLayoutType;
     };
 
+    template <typename BackendTraits>
+    struct ToBackendTraits<QuerySetBase, BackendTraits> {
+        using BackendType = typename BackendTraits::QuerySetType;
+    };
+
     template <typename BackendTraits>
     struct ToBackendTraits<QueueBase, BackendTraits> {
         using BackendType = typename BackendTraits::QueueType;
@@ -212,19 +212,14 @@ namespace backend { namespace d3d12 {
     }
 
     void MapReadRequestTracker::Track(Buffer* buffer, uint32_t mapSerial, const void* data) {
-        Request request;
-        request.buffer = buffer;
-        request.mapSerial = mapSerial;
-        request.data = data;
-
-        mInflightRequests.Enqueue(std::move(request), mDevice->GetSerial());
+        Ref<Buffer> bufferRef = buffer;
+        mInflightRequests.Enqueue(mDevice->GetSerial(), [bufferRef, mapSerial, data]() mutable {
+            bufferRef->OnMapReadCommandSerialFinished(mapSerial, data);
+        });
     }
 
     void MapReadRequestTracker::Tick(Serial finishedSerial) {
-        for (auto& request : mInflightRequests.IterateUpTo(finishedSerial)) {
-            request.buffer->OnMapReadCommandSerialFinished(request.mapSerial, request.data);
-        }
-        mInflightRequests.ClearUpTo(finishedSerial);
+        mInflightRequests.Tick(finishedSerial);
     }
 
 }}  // namespace backend::d3d12
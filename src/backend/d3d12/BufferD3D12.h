@@ -16,7 +16,7 @@
 #define BACKEND_D3D12_BUFFERD3D12_H_
 
 #include "backend/Buffer.h"
-#include "common/SerialQueue.h"
+#include "backend/DeferredWorkQueue.h"
 
 #include "backend/d3d12/d3d12_platform.h"
 
@@ -73,12 +73,7 @@ namespace backend { namespace d3d12 {
       private:
         Device* mDevice;
 
-        struct Request {
-            Ref<Buffer> buffer;
-            uint32_t mapSerial;
-            const void* data;
-        };
-        SerialQueue<Request> mInflightRequests;
+        DeferredWorkQueue mInflightRequests;
     };
 
 }}  // namespace backend::d3d12
@@ -24,6 +24,7 @@
 #include "backend/d3d12/FramebufferD3D12.h"
 #include "backend/d3d12/InputStateD3D12.h"
 #include "backend/d3d12/PipelineLayoutD3D12.h"
+#include "backend/d3d12/QuerySetD3D12.h"
 #include "backend/d3d12/RenderPipelineD3D12.h"
 #include "backend/d3d12/ResourceAllocator.h"
 #include "backend/d3d12/SamplerD3D12.h"
@@ -45,6 +46,19 @@ namespace backend { namespace d3d12 {
             }
         }
 
+        D3D12_RESOURCE_BARRIER TransitionBarrier(ID3D12Resource* resource,
+                                                 D3D12_RESOURCE_STATES stateBefore,
+                                                 D3D12_RESOURCE_STATES stateAfter) {
+            D3D12_RESOURCE_BARRIER barrier;
+            barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+            barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            barrier.Transition.pResource = resource;
+            barrier.Transition.StateBefore = stateBefore;
+            barrier.Transition.StateAfter = stateAfter;
+            barrier.Transition.Subresource = 0;
+            return barrier;
+        }
+
         struct BindGroupStateTracker {
             uint32_t cbvSrvUavDescriptorIndex = 0;
             uint32_t samplerDescriptorIndex = 0;
@@ -259,6 +273,9 @@ namespace backend { namespace d3d12 {
         Framebuffer* currentFramebuffer = nullptr;
         uint32_t currentSubpass = 0;
 
+        QuerySet* statisticsQuerySet = nullptr;
+        uint32_t statisticsQuery = 0;
+
         while (mCommands.NextCommandId(&type)) {
             switch (type) {
                 case Command::BeginComputePass: {
@@ -266,6 +283,17 @@ namespace backend { namespace d3d12 {
                     bindingTracker.SetInComputePass(true);
                 } break;
 
+                case Command::BeginPipelineStatisticsQuery: {
+                    BeginPipelineStatisticsQueryCmd* cmd =
+                        mCommands.NextCommand<BeginPipelineStatisticsQueryCmd>();
+                    QuerySet* querySet = ToBackend(cmd->querySet.Get());
+                    commandList->BeginQuery(querySet->GetQueryHeap().Get(),
+                                            D3D12_QUERY_TYPE_PIPELINE_STATISTICS,
+                                            cmd->queryIndex);
+                    statisticsQuerySet = querySet;
+                    statisticsQuery = cmd->queryIndex;
+                } break;
+
                 case Command::BeginRenderPass: {
                     BeginRenderPassCmd* beginRenderPassCmd =
                         mCommands.NextCommand<BeginRenderPassCmd>();
@@ -481,6 +509,13 @@ namespace backend { namespace d3d12 {
                     bindingTracker.SetInComputePass(false);
                 } break;
 
+                case Command::EndPipelineStatisticsQuery: {
+                    mCommands.NextCommand<EndPipelineStatisticsQueryCmd>();
+                    commandList->EndQuery(statisticsQuerySet->GetQueryHeap().Get(),
+                                          D3D12_QUERY_TYPE_PIPELINE_STATISTICS, statisticsQuery);
+                    statisticsQuerySet = nullptr;
+                } break;
+
                 case Command::EndRenderPass: {
                     mCommands.NextCommand<EndRenderPassCmd>();
                 } break;
@@ -490,6 +525,50 @@ namespace backend { namespace d3d12 {
                     currentSubpass += 1;
                 } break;
 
+                case Command::ResolveQuerySet: {
+                    ResolveQuerySetCmd* cmd = mCommands.NextCommand<ResolveQuerySetCmd>();
+                    QuerySet* querySet = ToBackend(cmd->querySet.Get());
+                    auto dst = ToBackend(cmd->destination.buffer.Get())->GetD3D12Resource();
+
+                    if (querySet->GetType() == nxt::QueryType::Timestamp) {
+                        commandList->ResolveQueryData(
+                            querySet->GetQueryHeap().Get(), D3D12_QUERY_TYPE_TIMESTAMP,
+                            cmd->firstQuery, cmd->queryCount, dst.Get(), cmd->destination.offset);
+                        break;
+                    }
+
+                    // Pipeline statistics are resolved with all their counters so only the
+                    // enabled ones are copied to the destination.
+                    ID3D12Resource* statistics = querySet->GetStatisticsResource().Get();
+                    const uint64_t statisticsSize = sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS);
+                    commandList->ResolveQueryData(
+                        querySet->GetQueryHeap().Get(), D3D12_QUERY_TYPE_PIPELINE_STATISTICS,
+                        cmd->firstQuery, cmd->queryCount, statistics,
+                        cmd->firstQuery * statisticsSize);
+
+                    D3D12_RESOURCE_BARRIER barrier =
+                        TransitionBarrier(statistics, D3D12_RESOURCE_STATE_COPY_DEST,
+                                          D3D12_RESOURCE_STATE_COPY_SOURCE);
+                    commandList->ResourceBarrier(1, &barrier);
+
+                    const std::vector<uint32_t>& statisticOffsets =
+                        querySet->GetStatisticOffsets();
+                    uint64_t dstOffset = cmd->destination.offset;
+                    for (uint32_t i = 0; i < cmd->queryCount; ++i) {
+                        uint64_t srcOffset = (cmd->firstQuery + i) * statisticsSize;
+                        for (uint32_t statisticOffset : statisticOffsets) {
+                            commandList->CopyBufferRegion(dst.Get(), dstOffset, statistics,
+                                                          srcOffset + statisticOffset,
+                                                          kQueryResultSize);
+                            dstOffset += kQueryResultSize;
+                        }
+                    }
+
+                    barrier = TransitionBarrier(statistics, D3D12_RESOURCE_STATE_COPY_SOURCE,
+                                                D3D12_RESOURCE_STATE_COPY_DEST);
+                    commandList->ResourceBarrier(1, &barrier);
+                } break;
+
                 case Command::SetComputePipeline: {
                     SetComputePipelineCmd* cmd = mCommands.NextCommand<SetComputePipelineCmd>();
                     ComputePipeline* pipeline = ToBackend(cmd->pipeline).Get();
@@ -604,6 +683,13 @@ namespace backend { namespace d3d12 {
 
                     texture->UpdateUsageInternal(cmd->usage);
                 } break;
+
+                case Command::WriteTimestamp: {
+                    WriteTimestampCmd* cmd = mCommands.NextCommand<WriteTimestampCmd>();
+                    QuerySet* querySet = ToBackend(cmd->querySet.Get());
+                    commandList->EndQuery(querySet->GetQueryHeap().Get(),
+                                          D3D12_QUERY_TYPE_TIMESTAMP, cmd->queryIndex);
+                } break;
             }
         }
     }
@@ -27,6 +27,7 @@
 #include "backend/d3d12/InputStateD3D12.h"
 #include "backend/d3d12/NativeSwapChainImplD3D12.h"
 #include "backend/d3d12/PipelineLayoutD3D12.h"
+#include "backend/d3d12/QuerySetD3D12.h"
 #include "backend/d3d12/QueueD3D12.h"
 #include "backend/d3d12/RenderPipelineD3D12.h"
 #include "backend/d3d12/ResourceAllocator.h"
@@ -218,6 +219,15 @@ namespace backend { namespace d3d12 {
         NextSerial();
     }
 
+    Serial Device::GetLastSubmittedCommandSerial() const {
+        // NextSerial is called after each submit and signals the fence with the current serial.
+        return mSerial - 1;
+    }
+
+    Serial Device::GetCompletedCommandSerial() const {
+        return mFence->GetCompletedValue();
+    }
+
     uint64_t Device::GetSerial() const {
         return mSerial;
     }
@@ -284,6 +294,9 @@ namespace backend { namespace d3d12 {
     PipelineLayoutBase* Device::CreatePipelineLayout(PipelineLayoutBuilder* builder) {
         return new PipelineLayout(this, builder);
     }
+    QuerySetBase* Device::CreateQuerySet(QuerySetBuilder* builder) {
+        return new QuerySet(this, builder);
+    }
     QueueBase* Device::CreateQueue(QueueBuilder* builder) {
         return new Queue(this, builder);
     }
@@ -19,6 +19,7 @@
 
 #include "backend/DepthStencilState.h"
 #include "backend/Device.h"
+#include "backend/Fence.h"
 #include "backend/RenderPass.h"
 #include "backend/ToBackend.h"
 
@@ -35,9 +36,11 @@ namespace backend { namespace d3d12 {
     class ComputePipeline;
     class DepthStencilState;
     class Device;
+    using Fence = FenceBase;
     class Framebuffer;
     class InputState;
     class PipelineLayout;
+    class QuerySet;
     class Queue;
     class RenderPass;
     class RenderPipeline;
@@ -63,9 +66,11 @@ namespace backend { namespace d3d12 {
         using ComputePipelineType = ComputePipeline;
         using DepthStencilStateType = DepthStencilState;
         using DeviceType = Device;
+        using FenceType = Fence;
         using FramebufferType = Framebuffer;
         using InputStateType = InputState;
         using PipelineLayoutType = PipelineLayout;
+        using QuerySetType = QuerySet;
         using QueueType = Queue;
         using RenderPassType = RenderPass;
         using RenderPipelineType = RenderPipeline;
@@ -100,6 +105,7 @@ namespace backend { namespace d3d12 {
         FramebufferBase* CreateFramebuffer(FramebufferBuilder* builder) override;
         InputStateBase* CreateInputState(InputStateBuilder* builder) override;
         PipelineLayoutBase* CreatePipelineLayout(PipelineLayoutBuilder* builder) override;
+        QuerySetBase* CreateQuerySet(QuerySetBuilder* builder) override;
         QueueBase* CreateQueue(QueueBuilder* builder) override;
         RenderPassBase* CreateRenderPass(RenderPassBuilder* builder) override;
         RenderPipelineBase* CreateRenderPipeline(RenderPipelineBuilder* builder) override;
@@ -110,6 +116,8 @@ namespace backend { namespace d3d12 {
         TextureViewBase* CreateTextureView(TextureViewBuilder* builder) override;
 
         void TickImpl() override;
+        Serial GetLastSubmittedCommandSerial() const override;
+        Serial GetCompletedCommandSerial() const override;
 
         ComPtr<IDXGIFactory4> GetFactory();
         ComPtr<ID3D12Device> GetD3D12Device();
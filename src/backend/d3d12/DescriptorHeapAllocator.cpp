@@ -123,10 +123,11 @@ namespace backend { namespace d3d12 {
     }
 
     void DescriptorHeapAllocator::Tick(uint64_t lastCompletedSerial) {
-        mReleasedHandles.ClearUpTo(lastCompletedSerial);
+        mReleasedHandles.Tick(lastCompletedSerial);
     }
 
     void DescriptorHeapAllocator::Release(DescriptorHeapHandle handle) {
-        mReleasedHandles.Enqueue(handle, mDevice->GetSerial());
+        // The handle keeps its heap alive until the GPU is done with it.
+        mReleasedHandles.Enqueue(mDevice->GetSerial(), [handle]() {});
     }
 }}  // namespace backend::d3d12
@@ -19,7 +19,7 @@
 
 #include <array>
 #include <vector>
-#include "common/SerialQueue.h"
+#include "backend/DeferredWorkQueue.h"
 
 namespace backend { namespace d3d12 {
 
@@ -75,7 +75,7 @@ namespace backend { namespace d3d12 {
         std::array<uint32_t, kDescriptorHeapTypes> mSizeIncrements;
         std::array<DescriptorHeapInfo, kDescriptorHeapTypes> mCpuDescriptorHeapInfos;
         std::array<DescriptorHeapInfo, kDescriptorHeapTypes> mGpuDescriptorHeapInfos;
-        SerialQueue<DescriptorHeapHandle> mReleasedHandles;
+        DeferredWorkQueue mReleasedHandles;
     };
 
 }}  // namespace backend::d3d12
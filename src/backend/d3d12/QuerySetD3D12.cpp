@@ -0,0 +1,103 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "backend/d3d12/QuerySetD3D12.h"
+
+#include "backend/d3d12/D3D12Backend.h"
+#include "backend/d3d12/ResourceAllocator.h"
+
+#include <cstddef>
+
+namespace backend { namespace d3d12 {
+
+    QuerySet::QuerySet(Device* device, QuerySetBuilder* builder)
+        : QuerySetBase(builder), mDevice(device) {
+        D3D12_QUERY_HEAP_DESC queryHeapDesc;
+        queryHeapDesc.Count = GetCount();
+        queryHeapDesc.NodeMask = 0;
+
+        if (GetType() == nxt::QueryType::Timestamp) {
+            queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        } else {
+            queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_PIPELINE_STATISTICS;
+
+            nxt::PipelineStatisticBit statistics = GetPipelineStatistics();
+            if (statistics & nxt::PipelineStatisticBit::Vertices) {
+                mStatisticOffsets.push_back(
+                    offsetof(D3D12_QUERY_DATA_PIPELINE_STATISTICS, IAVertices));
+            }
+            if (statistics & nxt::PipelineStatisticBit::VertexShaderInvocations) {
+                mStatisticOffsets.push_back(
+                    offsetof(D3D12_QUERY_DATA_PIPELINE_STATISTICS, VSInvocations));
+            }
+            if (statistics & nxt::PipelineStatisticBit::ClipperPrimitives) {
+                mStatisticOffsets.push_back(
+                    offsetof(D3D12_QUERY_DATA_PIPELINE_STATISTICS, CPrimitives));
+            }
+            if (statistics & nxt::PipelineStatisticBit::FragmentShaderInvocations) {
+                mStatisticOffsets.push_back(
+                    offsetof(D3D12_QUERY_DATA_PIPELINE_STATISTICS, PSInvocations));
+            }
+            if (statistics & nxt::PipelineStatisticBit::ComputeShaderInvocations) {
+                mStatisticOffsets.push_back(
+                    offsetof(D3D12_QUERY_DATA_PIPELINE_STATISTICS, CSInvocations));
+            }
+
+            D3D12_RESOURCE_DESC resourceDescriptor;
+            resourceDescriptor.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+            resourceDescriptor.Alignment = 0;
+            resourceDescriptor.Width = GetCount() * sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS);
+            resourceDescriptor.Height = 1;
+            resourceDescriptor.DepthOrArraySize = 1;
+            resourceDescriptor.MipLevels = 1;
+            resourceDescriptor.Format = DXGI_FORMAT_UNKNOWN;
+            resourceDescriptor.SampleDesc.Count = 1;
+            resourceDescriptor.SampleDesc.Quality = 0;
+            resourceDescriptor.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+            resourceDescriptor.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+            mStatisticsResource = mDevice->GetResourceAllocator()->Allocate(
+                D3D12_HEAP_TYPE_DEFAULT, resourceDescriptor, D3D12_RESOURCE_STATE_COPY_DEST);
+        }
+
+        ASSERT_SUCCESS(mDevice->GetD3D12Device()->CreateQueryHeap(&queryHeapDesc,
+                                                                   IID_PPV_ARGS(&mQueryHeap)));
+    }
+
+    QuerySet::~QuerySet() {
+        if (mStatisticsResource != nullptr) {
+            mDevice->GetResourceAllocator()->Release(mStatisticsResource);
+        }
+    }
+
+    ComPtr<ID3D12QueryHeap> QuerySet::GetQueryHeap() {
+        return mQueryHeap;
+    }
+
+    D3D12_QUERY_TYPE QuerySet::GetD3D12QueryType() const {
+        if (GetType() == nxt::QueryType::Timestamp) {
+            return D3D12_QUERY_TYPE_TIMESTAMP;
+        }
+        return D3D12_QUERY_TYPE_PIPELINE_STATISTICS;
+    }
+
+    ComPtr<ID3D12Resource> QuerySet::GetStatisticsResource() {
+        return mStatisticsResource;
+    }
+
+    const std::vector<uint32_t>& QuerySet::GetStatisticOffsets() const {
+        return mStatisticOffsets;
+    }
+
+}}  // namespace backend::d3d12
@@ -0,0 +1,53 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_D3D12_QUERYSETD3D12_H_
+#define BACKEND_D3D12_QUERYSETD3D12_H_
+
+#include "backend/QuerySet.h"
+
+#include "backend/d3d12/d3d12_platform.h"
+
+#include <vector>
+
+namespace backend { namespace d3d12 {
+
+    class Device;
+
+    class QuerySet : public QuerySetBase {
+      public:
+        QuerySet(Device* device, QuerySetBuilder* builder);
+        ~QuerySet();
+
+        ComPtr<ID3D12QueryHeap> GetQueryHeap();
+        D3D12_QUERY_TYPE GetD3D12QueryType() const;
+
+        // D3D12 resolves all the pipeline statistics of a query, they are resolved to this
+        // buffer first then the enabled ones are copied to the destination. nullptr for
+        // timestamps which are resolved directly.
+        ComPtr<ID3D12Resource> GetStatisticsResource();
+        // The offsets of the enabled statistics in D3D12_QUERY_DATA_PIPELINE_STATISTICS, in the
+        // order of their bits.
+        const std::vector<uint32_t>& GetStatisticOffsets() const;
+
+      private:
+        Device* mDevice;
+        ComPtr<ID3D12QueryHeap> mQueryHeap;
+        ComPtr<ID3D12Resource> mStatisticsResource;
+        std::vector<uint32_t> mStatisticOffsets;
+    };
+
+}}  // namespace backend::d3d12
+
+#endif  // BACKEND_D3D12_QUERYSETD3D12_H_
@@ -16,18 +16,20 @@
 
 #include "backend/d3d12/CommandBufferD3D12.h"
 #include "backend/d3d12/D3D12Backend.h"
+#include "common/Trace.h"
 
 namespace backend { namespace d3d12 {
 
     Queue::Queue(Device* device, QueueBuilder* builder) : QueueBase(builder), mDevice(device) {
     }
 
-    void Queue::Submit(uint32_t numCommands, CommandBuffer* const* commands) {
+    void Queue::SubmitImpl(uint32_t numCommands, CommandBufferBase* const* commands) {
+        NXT_TRACE_EVENT("d3d12", "Queue::Submit");
         mDevice->Tick();
 
         mDevice->OpenCommandList(&mCommandList);
         for (uint32_t i = 0; i < numCommands; ++i) {
-            commands[i]->FillCommands(mCommandList);
+            ToBackend(commands[i])->FillCommands(mCommandList);
         }
         ASSERT_SUCCESS(mCommandList->Close());
 
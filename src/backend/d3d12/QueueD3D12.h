@@ -28,10 +28,9 @@ namespace backend { namespace d3d12 {
       public:
         Queue(Device* device, QueueBuilder* builder);
 
-        // NXT API
-        void Submit(uint32_t numCommands, CommandBuffer* const* commands);
-
       private:
+        void SubmitImpl(uint32_t numCommands, CommandBufferBase* const* commands) override;
+
         Device* mDevice;
 
         ComPtr<ID3D12GraphicsCommandList> mCommandList;
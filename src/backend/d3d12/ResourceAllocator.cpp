@@ -67,11 +67,11 @@ namespace backend { namespace d3d12 {
     void ResourceAllocator::Release(ComPtr<ID3D12Resource> resource) {
         // Resources may still be in use on the GPU. Enqueue them so that we hold onto them until
         // GPU execution has completed
-        mReleasedResources.Enqueue(resource, mDevice->GetSerial());
+        mReleasedResources.Enqueue(mDevice->GetSerial(), [resource]() {});
     }
 
     void ResourceAllocator::Tick(uint64_t lastCompletedSerial) {
-        mReleasedResources.ClearUpTo(lastCompletedSerial);
+        mReleasedResources.Tick(lastCompletedSerial);
     }
 
 }}  // namespace backend::d3d12
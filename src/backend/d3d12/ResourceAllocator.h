@@ -17,7 +17,7 @@
 
 #include "backend/d3d12/d3d12_platform.h"
 
-#include "common/SerialQueue.h"
+#include "backend/DeferredWorkQueue.h"
 
 namespace backend { namespace d3d12 {
 
@@ -36,7 +36,7 @@ namespace backend { namespace d3d12 {
       private:
         Device* mDevice;
 
-        SerialQueue<ComPtr<ID3D12Resource>> mReleasedResources;
+        DeferredWorkQueue mReleasedResources;
     };
 
 }}  // namespace backend::d3d12
@@ -16,6 +16,7 @@
 
 #include "backend/d3d12/D3D12Backend.h"
 #include "backend/d3d12/ResourceAllocator.h"
+#include "common/Trace.h"
 
 namespace backend { namespace d3d12 {
 
@@ -26,6 +27,8 @@ namespace backend { namespace d3d12 {
                                          uint32_t start,
                                          uint32_t count,
                                          const void* data) {
+        NXT_TRACE_EVENT("d3d12", "ResourceUploader::BufferSubData");
+
         // TODO(enga@google.com): Use a handle to a subset of a large ring buffer. On Release,
         // decrease reference count on the ring buffer and free when 0. Alternatively, the
         // SerialQueue could be used to track which last point of the ringbuffer is in use, and
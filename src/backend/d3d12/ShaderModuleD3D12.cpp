@@ -14,12 +14,15 @@
 
 #include "backend/d3d12/ShaderModuleD3D12.h"
 
+#include "common/Trace.h"
+
 #include <spirv-cross/spirv_hlsl.hpp>
 
 namespace backend { namespace d3d12 {
 
     ShaderModule::ShaderModule(Device* device, ShaderModuleBuilder* builder)
         : ShaderModuleBase(builder), mDevice(device) {
+        NXT_TRACE_EVENT("d3d12", "ShaderModule::ShaderModule");
         spirv_cross::CompilerHLSL compiler(builder->AcquireSpirv());
 
         spirv_cross::CompilerGLSL::Options options_glsl;
@@ -16,7 +16,7 @@
 #define BACKEND_METAL_BUFFERMTL_H_
 
 #include "backend/Buffer.h"
-#include "common/SerialQueue.h"
+#include "backend/DeferredWorkQueue.h"
 
 #import <Metal/Metal.h>
 
@@ -59,12 +59,7 @@ namespace backend { namespace metal {
       private:
         Device* mDevice;
 
-        struct Request {
-            Ref<Buffer> buffer;
-            uint32_t mapSerial;
-            uint32_t offset;
-        };
-        SerialQueue<Request> mInflightRequests;
+        DeferredWorkQueue mInflightRequests;
     };
 
 }}  // namespace backend::metal
@@ -74,19 +74,15 @@ namespace backend { namespace metal {
     }
 
     void MapReadRequestTracker::Track(Buffer* buffer, uint32_t mapSerial, uint32_t offset) {
-        Request request;
-        request.buffer = buffer;
-        request.mapSerial = mapSerial;
-        request.offset = offset;
-
-        mInflightRequests.Enqueue(std::move(request), mDevice->GetPendingCommandSerial());
+        Ref<Buffer> bufferRef = buffer;
+        Serial serial = mDevice->GetPendingCommandSerial();
+        mInflightRequests.Enqueue(serial, [bufferRef, mapSerial, offset]() mutable {
+            bufferRef->OnMapReadCommandSerialFinished(mapSerial, offset);
+        });
     }
 
     void MapReadRequestTracker::Tick(Serial finishedSerial) {
-        for (auto& request : mInflightRequests.IterateUpTo(finishedSerial)) {
-            request.buffer->OnMapReadCommandSerialFinished(request.mapSerial, request.offset);
-        }
-        mInflightRequests.ClearUpTo(finishedSerial);
+        mInflightRequests.Tick(finishedSerial);
     }
 
 }}  // namespace backend::metal
@@ -187,6 +187,12 @@ namespace backend { namespace metal {
                                        atIndex:0];
                 } break;
 
+                case Command::BeginPipelineStatisticsQuery: {
+                    // The Metal SDK targeted doesn't expose GPU counters so queries aren't
+                    // recorded and resolve to zeros.
+                    mCommands.NextCommand<BeginPipelineStatisticsQueryCmd>();
+                } break;
+
                 case Command::BeginRenderPass: {
                     BeginRenderPassCmd* beginRenderPassCmd =
                         mCommands.NextCommand<BeginRenderPassCmd>();
@@ -322,6 +328,10 @@ namespace backend { namespace metal {
                     encoders.EndCompute();
                 } break;
 
+                case Command::EndPipelineStatisticsQuery: {
+                    mCommands.NextCommand<EndPipelineStatisticsQueryCmd>();
+                } break;
+
                 case Command::EndRenderPass: {
                     mCommands.NextCommand<EndRenderPassCmd>();
                 } break;
@@ -332,6 +342,19 @@ namespace backend { namespace metal {
                     currentSubpass += 1;
                 } break;
 
+                case Command::ResolveQuerySet: {
+                    ResolveQuerySetCmd* cmd = mCommands.NextCommand<ResolveQuerySetCmd>();
+                    QuerySetBase* querySet = cmd->querySet.Get();
+                    auto& dst = cmd->destination;
+                    NSUInteger size =
+                        cmd->queryCount * querySet->GetResultsPerQuery() * kQueryResultSize;
+
+                    encoders.EnsureBlit(commandBuffer);
+                    [encoders.blit fillBuffer:ToBackend(dst.buffer)->GetMTLBuffer()
+                                        range:NSMakeRange(dst.offset, size)
+                                        value:0];
+                } break;
+
                 case Command::SetComputePipeline: {
                     SetComputePipelineCmd* cmd = mCommands.NextCommand<SetComputePipelineCmd>();
                     lastComputePipeline = ToBackend(cmd->pipeline).Get();
@@ -556,6 +579,10 @@ namespace backend { namespace metal {
 
                     cmd->texture->UpdateUsageInternal(cmd->usage);
                 } break;
+
+                case Command::WriteTimestamp: {
+                    mCommands.NextCommand<WriteTimestampCmd>();
+                } break;
             }
         }
 
@@ -20,7 +20,9 @@
 #include "backend/BindGroup.h"
 #include "backend/BindGroupLayout.h"
 #include "backend/Device.h"
+#include "backend/Fence.h"
 #include "backend/Framebuffer.h"
+#include "backend/QuerySet.h"
 #include "backend/Queue.h"
 #include "backend/RenderPass.h"
 #include "backend/ToBackend.h"
@@ -41,9 +43,11 @@ namespace backend { namespace metal {
     class ComputePipeline;
     class DepthStencilState;
     class Device;
+    using Fence = FenceBase;
     class Framebuffer;
     class InputState;
     class PipelineLayout;
+    using QuerySet = QuerySetBase;
     class Queue;
     class RenderPass;
     class RenderPipeline;
@@ -63,9 +67,11 @@ namespace backend { namespace metal {
         using ComputePipelineType = ComputePipeline;
         using DepthStencilStateType = DepthStencilState;
         using DeviceType = Device;
+        using FenceType = Fence;
         using FramebufferType = Framebuffer;
         using InputStateType = InputState;
         using PipelineLayoutType = PipelineLayout;
+        using QuerySetType = QuerySet;
         using QueueType = Queue;
         using RenderPassType = RenderPass;
         using RenderPipelineType = RenderPipeline;
@@ -100,6 +106,7 @@ namespace backend { namespace metal {
         InputStateBase* CreateInputState(InputStateBuilder* builder) override;
         FramebufferBase* CreateFramebuffer(FramebufferBuilder* builder) override;
         PipelineLayoutBase* CreatePipelineLayout(PipelineLayoutBuilder* builder) override;
+        QuerySetBase* CreateQuerySet(QuerySetBuilder* builder) override;
         QueueBase* CreateQueue(QueueBuilder* builder) override;
         RenderPassBase* CreateRenderPass(RenderPassBuilder* builder) override;
         RenderPipelineBase* CreateRenderPipeline(RenderPipelineBuilder* builder) override;
@@ -110,6 +117,8 @@ namespace backend { namespace metal {
         TextureViewBase* CreateTextureView(TextureViewBuilder* builder) override;
 
         void TickImpl() override;
+        Serial GetLastSubmittedCommandSerial() const override;
+        Serial GetCompletedCommandSerial() const override;
 
         id<MTLDevice> GetMTLDevice();
 
@@ -156,10 +165,9 @@ namespace backend { namespace metal {
 
         id<MTLCommandQueue> GetMTLCommandQueue();
 
-        // NXT API
-        void Submit(uint32_t numCommands, CommandBuffer* const* commands);
-
       private:
+        void SubmitImpl(uint32_t numCommands, CommandBufferBase* const* commands) override;
+
         id<MTLCommandQueue> mCommandQueue = nil;
     };
 
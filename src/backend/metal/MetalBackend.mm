@@ -27,6 +27,7 @@
 #include "backend/metal/ShaderModuleMTL.h"
 #include "backend/metal/SwapChainMTL.h"
 #include "backend/metal/TextureMTL.h"
+#include "common/Trace.h"
 
 #include <unistd.h>
 
@@ -111,6 +112,9 @@ namespace backend { namespace metal {
     PipelineLayoutBase* Device::CreatePipelineLayout(PipelineLayoutBuilder* builder) {
         return new PipelineLayout(builder);
     }
+    QuerySetBase* Device::CreateQuerySet(QuerySetBuilder* builder) {
+        return new QuerySet(builder);
+    }
     QueueBase* Device::CreateQueue(QueueBuilder* builder) {
         return new Queue(builder);
     }
@@ -177,6 +181,14 @@ namespace backend { namespace metal {
         mPendingCommandSerial++;
     }
 
+    Serial Device::GetLastSubmittedCommandSerial() const {
+        return mPendingCommandSerial - 1;
+    }
+
+    Serial Device::GetCompletedCommandSerial() const {
+        return mFinishedCommandSerial;
+    }
+
     uint64_t Device::GetPendingCommandSerial() {
         // If this is called, then it means some piece of code somewhere will wait for this serial
         // to complete. Make sure the pending command buffer is created so that it is on the worst
@@ -229,12 +241,13 @@ namespace backend { namespace metal {
         return mCommandQueue;
     }
 
-    void Queue::Submit(uint32_t numCommands, CommandBuffer* const* commands) {
+    void Queue::SubmitImpl(uint32_t numCommands, CommandBufferBase* const* commands) {
+        NXT_TRACE_EVENT("metal", "Queue::Submit");
         Device* device = ToBackend(GetDevice());
         id<MTLCommandBuffer> commandBuffer = device->GetPendingCommandBuffer();
 
         for (uint32_t i = 0; i < numCommands; ++i) {
-            commands[i]->FillCommands(commandBuffer);
+            ToBackend(commands[i])->FillCommands(commandBuffer);
         }
 
         device->SubmitPendingCommandBuffer();
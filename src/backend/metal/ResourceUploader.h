@@ -15,8 +15,8 @@
 #ifndef BACKEND_METAL_RESOURCEUPLOADER_H_
 #define BACKEND_METAL_RESOURCEUPLOADER_H_
 
+#include "backend/DeferredWorkQueue.h"
 #include "common/Serial.h"
-#include "common/SerialQueue.h"
 
 #import <Metal/Metal.h>
 
@@ -34,7 +34,7 @@ namespace backend { namespace metal {
 
       private:
         Device* mDevice;
-        SerialQueue<id<MTLBuffer>> mInflightUploadBuffers;
+        DeferredWorkQueue mInflightUploadBuffers;
     };
 
 }}  // namespace backend::metal
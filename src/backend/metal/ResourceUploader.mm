@@ -15,6 +15,7 @@
 #include "backend/metal/ResourceUploader.h"
 
 #include "backend/metal/MetalBackend.h"
+#include "common/Trace.h"
 
 namespace backend { namespace metal {
 
@@ -29,6 +30,7 @@ namespace backend { namespace metal {
                                          uint32_t start,
                                          uint32_t size,
                                          const void* data) {
+        NXT_TRACE_EVENT("metal", "ResourceUploader::BufferSubData");
         // TODO(cwallez@chromium.org) use a ringbuffer instead of creating a small buffer for each
         // update
         id<MTLBuffer> uploadBuffer =
@@ -44,14 +46,12 @@ namespace backend { namespace metal {
                            size:size];
         [encoder endEncoding];
 
-        mInflightUploadBuffers.Enqueue(uploadBuffer, mDevice->GetPendingCommandSerial());
+        mInflightUploadBuffers.Enqueue(mDevice->GetPendingCommandSerial(),
+                                       [uploadBuffer]() { [uploadBuffer release]; });
     }
 
     void ResourceUploader::Tick(Serial finishedSerial) {
-        for (id<MTLBuffer> buffer : mInflightUploadBuffers.IterateUpTo(finishedSerial)) {
-            [buffer release];
-        }
-        mInflightUploadBuffers.ClearUpTo(finishedSerial);
+        mInflightUploadBuffers.Tick(finishedSerial);
     }
 
 }}  // namespace backend::metal
@@ -16,6 +16,7 @@
 
 #include "backend/metal/MetalBackend.h"
 #include "backend/metal/PipelineLayoutMTL.h"
+#include "common/Trace.h"
 
 #include <spirv-cross/spirv_msl.hpp>
 
@@ -47,6 +48,7 @@ namespace backend { namespace metal {
 
     ShaderModule::MetalFunctionData ShaderModule::GetFunction(const char* functionName,
                                                               const PipelineLayout* layout) const {
+        NXT_TRACE_EVENT("metal", "ShaderModule::GetFunction");
         spirv_cross::CompilerMSL compiler(mSpirv);
 
         // By default SPIRV-Cross will give MSL resources indices in increasing order.
@@ -0,0 +1,190 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "backend/null/DeviceTimeline.h"
+
+#include "common/Assert.h"
+
+#include <algorithm>
+
+namespace backend { namespace null {
+
+    DeviceTimeline::DeviceTimeline(const TimelineDescriptor& descriptor)
+        : mClock(descriptor.clock),
+          mCosts(descriptor.costs),
+          mJitter(descriptor.jitter),
+          mRandom(descriptor.seed),
+          mCompletedSerial(0),
+          mStart(Clock::now()) {
+        ASSERT(mJitter >= 0.0f && mJitter <= 1.0f);
+        mNextScale = DrawScale();
+        if (mClock == TimelineClock::RealTime) {
+            mThread = std::thread([this]() { ThreadLoop(); });
+        }
+    }
+
+    DeviceTimeline::~DeviceTimeline() {
+        if (mThread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStopping = true;
+            }
+            mCondition.notify_one();
+            mThread.join();
+        }
+    }
+
+    Serial DeviceTimeline::Submit(const SubmitWorkload& workload, nxt::QueueType queueType) {
+        uint64_t duration = ComputeDuration(workload);
+        mNextScale = DrawScale();
+        return Enqueue(duration, &mEngineCompletionTimes[static_cast<uint32_t>(queueType)]);
+    }
+
+    void DeviceTimeline::Wait(nxt::QueueType queueType, Serial serial) {
+        if (mClock == TimelineClock::Immediate) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        uint64_t& engineCompletionTime = mEngineCompletionTimes[static_cast<uint32_t>(queueType)];
+        for (const auto& inFlight : mInFlight) {
+            if (inFlight.first > serial) {
+                break;
+            }
+            engineCompletionTime = std::max(engineCompletionTime, inFlight.second);
+        }
+    }
+
+    Serial DeviceTimeline::Signal() {
+        return Enqueue(0, nullptr);
+    }
+
+    uint64_t DeviceTimeline::GetCommandTime(const SubmitWorkload& workloadSoFar,
+                                            nxt::QueueType queueType) {
+        // The submit cost isn't spent on the commands so it is removed from their duration.
+        uint64_t commandsDuration =
+            ComputeDuration(workloadSoFar) - ComputeDuration(SubmitWorkload());
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        uint64_t start = GetTime();
+        if (mClock != TimelineClock::Immediate) {
+            start = std::max(start, mEngineCompletionTimes[static_cast<uint32_t>(queueType)]);
+        }
+        return start + commandsDuration;
+    }
+
+    Serial DeviceTimeline::GetLastSubmittedSerial() const {
+        return mLastSubmittedSerial;
+    }
+
+    Serial DeviceTimeline::GetCompletedSerial() const {
+        return mCompletedSerial.load(std::memory_order_acquire);
+    }
+
+    void DeviceTimeline::AdvanceTime(uint64_t nanoseconds) {
+        ASSERT(mClock == TimelineClock::Manual);
+        std::lock_guard<std::mutex> lock(mMutex);
+        mManualTime += nanoseconds;
+        CompleteUpTo(mManualTime);
+    }
+
+    void DeviceTimeline::CompleteAll() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mInFlight.clear();
+        mCompletedSerial.store(mLastSubmittedSerial, std::memory_order_release);
+    }
+
+    uint64_t DeviceTimeline::ComputeDuration(const SubmitWorkload& workload) const {
+        uint64_t duration = mCosts.submit + mCosts.renderPass * workload.renderPasses +
+                            mCosts.draw * workload.draws + mCosts.dispatch * workload.dispatches +
+                            mCosts.workgroup * workload.workgroups +
+                            mCosts.copy * workload.copies +
+                            mCosts.copiedKilobyte * workload.copiedBytes / 1024;
+
+        if (mJitter > 0.0f) {
+            duration = static_cast<uint64_t>(static_cast<double>(duration) * mNextScale);
+        }
+        return duration;
+    }
+
+    float DeviceTimeline::DrawScale() {
+        // The generator is only used when there is jitter so that the durations are exact
+        // otherwise.
+        if (mJitter == 0.0f) {
+            return 1.0f;
+        }
+        std::uniform_real_distribution<float> distribution(-mJitter, mJitter);
+        return 1.0f + distribution(mRandom);
+    }
+
+    Serial DeviceTimeline::Enqueue(uint64_t duration, uint64_t* engineCompletionTime) {
+        Serial serial = ++mLastSubmittedSerial;
+
+        if (mClock == TimelineClock::Immediate) {
+            mCompletedSerial.store(serial, std::memory_order_release);
+            return serial;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            uint64_t now = GetTime();
+            // The engine starts the submit when it is done with the previous ones.
+            uint64_t completionTime = now;
+            if (engineCompletionTime != nullptr) {
+                *engineCompletionTime = std::max(*engineCompletionTime, now) + duration;
+                completionTime = *engineCompletionTime;
+            }
+            mInFlight.emplace_back(serial, completionTime);
+            if (mClock == TimelineClock::Manual) {
+                CompleteUpTo(now);
+            }
+        }
+        mCondition.notify_one();
+        return serial;
+    }
+
+    uint64_t DeviceTimeline::GetTime() const {
+        if (mClock == TimelineClock::Manual) {
+            return mManualTime;
+        }
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - mStart).count());
+    }
+
+    void DeviceTimeline::CompleteUpTo(uint64_t time) {
+        // Submits of different engines can finish out of order but the completed serial only
+        // moves past a submit once it is finished.
+        while (!mInFlight.empty() && mInFlight.front().second <= time) {
+            mCompletedSerial.store(mInFlight.front().first, std::memory_order_release);
+            mInFlight.pop_front();
+        }
+    }
+
+    void DeviceTimeline::ThreadLoop() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (!mStopping) {
+            if (mInFlight.empty()) {
+                mCondition.wait(lock);
+                continue;
+            }
+
+            // Wake up when the first submit completes, or earlier when notified. The completed
+            // serial can't move before it.
+            uint64_t completion = mInFlight.front().second;
+            mCondition.wait_until(lock, mStart + std::chrono::nanoseconds(completion));
+            CompleteUpTo(GetTime());
+        }
+    }
+
+}}  // namespace backend::null
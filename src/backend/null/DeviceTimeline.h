@@ -0,0 +1,147 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_NULL_DEVICETIMELINE_H_
+#define BACKEND_NULL_DEVICETIMELINE_H_
+
+#include "common/Constants.h"
+#include "common/Serial.h"
+
+#include "nxt/nxtcpp.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace backend { namespace null {
+
+    // The commands of a submit, counted while they are executed.
+    struct SubmitWorkload {
+        uint32_t renderPasses = 0;
+        uint32_t draws = 0;
+        uint32_t dispatches = 0;
+        uint64_t workgroups = 0;
+        uint32_t copies = 0;
+        uint64_t copiedBytes = 0;
+    };
+
+    // The time in nanoseconds the simulated GPU takes for each part of a submit.
+    struct CommandCosts {
+        uint64_t submit = 0;
+        uint64_t renderPass = 0;
+        uint64_t draw = 0;
+        uint64_t dispatch = 0;
+        uint64_t workgroup = 0;
+        uint64_t copy = 0;
+        uint64_t copiedKilobyte = 0;
+    };
+
+    enum class TimelineClock {
+        // Submits complete as soon as they are made, without a thread.
+        Immediate,
+        // Submits complete after their duration in real time, on a background thread.
+        RealTime,
+        // Time only passes with DeviceTimeline::AdvanceTime so tests control when submits
+        // complete.
+        Manual,
+    };
+
+    struct TimelineDescriptor {
+        TimelineClock clock = TimelineClock::Immediate;
+        CommandCosts costs;
+        // The duration of each submit is scaled by a random factor in [1 - jitter, 1 + jitter]
+        // drawn from a generator seeded with seed.
+        float jitter = 0.0f;
+        uint32_t seed = 0;
+    };
+
+    // Simulates when the work submitted to a GPU completes. The commands of the null backend are
+    // executed on the CPU during Queue::Submit, the timeline gives each submit a serial and a
+    // duration computed from its workload, and completes the serials in order. Each queue type
+    // is an engine that runs concurrently with the others, its submits starting when its
+    // previous one is finished.
+    class DeviceTimeline {
+      public:
+        explicit DeviceTimeline(const TimelineDescriptor& descriptor);
+        ~DeviceTimeline();
+
+        // Returns the serial of the submit.
+        Serial Submit(const SubmitWorkload& workload,
+                      nxt::QueueType queueType = nxt::QueueType::Graphics);
+        // The next submits of the queue type start after the submits up to serial are finished.
+        void Wait(nxt::QueueType queueType, Serial serial);
+        // Returns a serial that completes when all the previous submits are finished, used to
+        // let operations waiting on the GPU complete when it is idle.
+        Serial Signal();
+
+        // The time in nanoseconds at which the engine of the queue type would reach a command of
+        // the next submit, workloadSoFar being the commands before it. Used for the timestamps
+        // written while executing the commands, they match the duration of the submit.
+        uint64_t GetCommandTime(const SubmitWorkload& workloadSoFar, nxt::QueueType queueType);
+
+        Serial GetLastSubmittedSerial() const;
+        // Can be called from any thread.
+        Serial GetCompletedSerial() const;
+
+        // Only for the Manual clock.
+        void AdvanceTime(uint64_t nanoseconds);
+        // Completes all the submits without waiting, used when the device is destroyed.
+        void CompleteAll();
+
+      private:
+        using Clock = std::chrono::steady_clock;
+
+        // The duration of the workload scaled by the jitter of the next submit.
+        uint64_t ComputeDuration(const SubmitWorkload& workload) const;
+        float DrawScale();
+        // Enqueues a submit that runs on the engine after its previous submits, or completes
+        // right away when engineCompletionTime is nullptr. Serials still complete in order.
+        Serial Enqueue(uint64_t duration, uint64_t* engineCompletionTime);
+        uint64_t GetTime() const;
+        // Must be called with mMutex locked.
+        void CompleteUpTo(uint64_t time);
+        void ThreadLoop();
+
+        TimelineClock mClock;
+        CommandCosts mCosts;
+        float mJitter;
+        std::mt19937 mRandom;
+        // Drawn ahead so that the timestamps of a submit use the same scale as its duration.
+        float mNextScale = 1.0f;
+
+        Serial mLastSubmittedSerial = 0;
+        std::atomic<Serial> mCompletedSerial;
+
+        Clock::time_point mStart;
+        uint64_t mManualTime = 0;
+        // When each engine finishes its last submit, in nanoseconds since the start.
+        std::array<uint64_t, kNumQueueTypes> mEngineCompletionTimes = {};
+
+        // The submits in flight with their completion time, guarded by mMutex.
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::deque<std::pair<Serial, uint64_t>> mInFlight;
+        bool mStopping = false;
+        std::thread mThread;
+    };
+
+}}  // namespace backend::null
+
+#endif  // BACKEND_NULL_DEVICETIMELINE_H_
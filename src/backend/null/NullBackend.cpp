@@ -15,9 +15,15 @@
 #include "backend/null/NullBackend.h"
 
 #include "backend/Commands.h"
+#include "backend/PerStage.h"
+#include "backend/null/ShaderProgram.h"
+#include "common/Trace.h"
 
 #include <spirv-cross/spirv_cross.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 namespace backend { namespace null {
 
     nxtProcTable GetNonValidatingProcs();
@@ -28,12 +34,22 @@ namespace backend { namespace null {
         *device = reinterpret_cast<nxtDevice>(new Device);
     }
 
+    void Init(nxtProcTable* procs, nxtDevice* device, const TimelineDescriptor& timeline) {
+        *procs = GetValidatingProcs();
+        *device = reinterpret_cast<nxtDevice>(new Device(timeline));
+    }
+
     // Device
 
-    Device::Device() {
+    Device::Device(const TimelineDescriptor& timeline) : mTimeline(timeline) {
     }
 
     Device::~Device() {
+        // Like other backends wait for the GPU to be idle, complete the submits in flight so
+        // that the map read callbacks are called and the command buffers in flight are released.
+        mTimeline.CompleteAll();
+        ProcessCompletedWork();
+        ASSERT(mDeferredWork.Empty());
     }
 
     BindGroupBase* Device::CreateBindGroup(BindGroupBuilder* builder) {
@@ -69,6 +85,9 @@ namespace backend { namespace null {
     PipelineLayoutBase* Device::CreatePipelineLayout(PipelineLayoutBuilder* builder) {
         return new PipelineLayout(builder);
     }
+    QuerySetBase* Device::CreateQuerySet(QuerySetBuilder* builder) {
+        return new QuerySet(builder);
+    }
     QueueBase* Device::CreateQueue(QueueBuilder* builder) {
         return new Queue(builder);
     }
@@ -82,12 +101,7 @@ namespace backend { namespace null {
         return new Sampler(builder);
     }
     ShaderModuleBase* Device::CreateShaderModule(ShaderModuleBuilder* builder) {
-        auto module = new ShaderModule(builder);
-
-        spirv_cross::Compiler compiler(builder->AcquireSpirv());
-        module->ExtractSpirvInfo(compiler);
-
-        return module;
+        return new ShaderModule(builder);
     }
     SwapChainBase* Device::CreateSwapChain(SwapChainBuilder* builder) {
         return new SwapChain(builder);
@@ -100,32 +114,83 @@ namespace backend { namespace null {
     }
 
     void Device::TickImpl() {
+        ProcessCompletedWork();
+
+        // If there's no GPU work in flight we still need to artificially signal a serial so that
+        // operations waiting on GPU completion don't wait for a submit that might never come.
+        // The work left is after the completed serial, waiting for the pending submit.
+        if (mTimeline.GetCompletedSerial() == mTimeline.GetLastSubmittedSerial() &&
+            !mDeferredWork.Empty()) {
+            mTimeline.Signal();
+            ProcessCompletedWork();
+        }
     }
 
-    void Device::AddPendingOperation(std::unique_ptr<PendingOperation> operation) {
-        mPendingOperations.emplace_back(std::move(operation));
+    DeviceTimeline* Device::GetTimeline() {
+        return &mTimeline;
     }
-    std::vector<std::unique_ptr<PendingOperation>> Device::AcquirePendingOperations() {
-        return std::move(mPendingOperations);
+
+    Serial Device::GetLastSubmittedCommandSerial() const {
+        return mTimeline.GetLastSubmittedSerial();
     }
 
-    // Buffer
+    Serial Device::GetCompletedCommandSerial() const {
+        return mTimeline.GetCompletedSerial();
+    }
+
+    Serial Device::GetPendingSerial() const {
+        return mTimeline.GetLastSubmittedSerial() + 1;
+    }
+
+    void Device::Submit(const SubmitWorkload& workload,
+                        nxt::QueueType queueType,
+                        uint32_t numCommands,
+                        CommandBufferBase* const* commands) {
+        Serial serial = mTimeline.Submit(workload, queueType);
 
-    struct BufferMapReadOperation : PendingOperation {
-        virtual void Execute() {
-            buffer->MapReadOperationCompleted(serial, ptr);
+        // Submits that complete right away don't need to keep anything alive, which avoids
+        // allocating on each submit.
+        if (serial > mTimeline.GetCompletedSerial()) {
+            for (uint32_t i = 0; i < numCommands; ++i) {
+                Ref<CommandBuffer> commandBuffer = ToBackend(commands[i]);
+                mDeferredWork.Enqueue(serial, [commandBuffer]() {});
+            }
         }
 
-        Ref<Buffer> buffer;
-        const void* ptr;
-        uint32_t serial;
-    };
+        ProcessCompletedWork();
+    }
 
-    Buffer::Buffer(BufferBuilder* builder) : BufferBase(builder) {
-        if (GetAllowedUsage() & (nxt::BufferUsageBit::TransferDst | nxt::BufferUsageBit::MapRead |
-                                 nxt::BufferUsageBit::MapWrite)) {
-            mBackingData = std::unique_ptr<char[]>(new char[GetSize()]);
+    void Device::AddMapReadRequest(Buffer* buffer, const void* ptr, uint32_t mapSerial) {
+        Ref<Buffer> bufferRef = buffer;
+        mDeferredWork.Enqueue(GetPendingSerial(), [bufferRef, ptr, mapSerial]() mutable {
+            bufferRef->MapReadOperationCompleted(mapSerial, ptr);
+        });
+    }
+
+    void Device::ProcessCompletedWork() {
+        mDeferredWork.Tick(mTimeline.GetCompletedSerial());
+    }
+
+    ThreadPool* Device::GetThreadPool() {
+        if (mThreadPool == nullptr) {
+            mThreadPool = std::unique_ptr<ThreadPool>(new ThreadPool);
         }
+        return mThreadPool.get();
+    }
+
+    Rasterizer* Device::GetRasterizer() {
+        if (mRasterizer == nullptr) {
+            mRasterizer = std::unique_ptr<Rasterizer>(new Rasterizer(GetThreadPool()));
+        }
+        return mRasterizer.get();
+    }
+
+    // Buffer
+
+    Buffer::Buffer(BufferBuilder* builder) : BufferBase(builder) {
+        // All buffers can be the source or destination of copies so they all have storage. It is
+        // zero-initialized like the resources of the other backends.
+        mBackingData = std::unique_ptr<uint8_t[]>(new uint8_t[GetSize()]());
     }
 
     Buffer::~Buffer() {
@@ -135,22 +200,19 @@ namespace backend { namespace null {
         CallMapReadCallback(serial, NXT_BUFFER_MAP_READ_STATUS_SUCCESS, ptr);
     }
 
+    uint8_t* Buffer::GetBackingData() {
+        return mBackingData.get();
+    }
+
     void Buffer::SetSubDataImpl(uint32_t start, uint32_t count, const uint32_t* data) {
-        ASSERT(start + count <= GetSize());
-        ASSERT(mBackingData);
-        memcpy(mBackingData.get() + start, data, count);
+        ASSERT((start + count) * sizeof(uint32_t) <= GetSize());
+        memcpy(mBackingData.get() + start * sizeof(uint32_t), data, count * sizeof(uint32_t));
     }
 
     void Buffer::MapReadAsyncImpl(uint32_t serial, uint32_t start, uint32_t count) {
         ASSERT(start + count <= GetSize());
-        ASSERT(mBackingData);
 
-        auto operation = new BufferMapReadOperation;
-        operation->buffer = this;
-        operation->ptr = mBackingData.get() + start;
-        operation->serial = serial;
-
-        ToBackend(GetDevice())->AddPendingOperation(std::unique_ptr<PendingOperation>(operation));
+        ToBackend(GetDevice())->AddMapReadRequest(this, mBackingData.get() + start, serial);
     }
 
     void Buffer::UnmapImpl() {
@@ -169,25 +231,424 @@ namespace backend { namespace null {
         FreeCommands(&mCommands);
     }
 
-    void CommandBuffer::Execute() {
-        Command type;
-        while (mCommands.NextCommandId(&type)) {
-            switch (type) {
-                case Command::TransitionBufferUsage: {
-                    TransitionBufferUsageCmd* cmd =
-                        mCommands.NextCommand<TransitionBufferUsageCmd>();
-                    cmd->buffer->UpdateUsageInternal(cmd->usage);
-                } break;
-                case Command::TransitionTextureUsage: {
-                    TransitionTextureUsageCmd* cmd =
-                        mCommands.NextCommand<TransitionTextureUsageCmd>();
-                    cmd->texture->UpdateUsageInternal(cmd->usage);
-                } break;
-                default:
-                    SkipCommand(&mCommands, type);
-                    break;
+    namespace {
+
+        // Copies rowCount rows of rowSize bytes between strided ranges. memcpy is vectorized so
+        // there is no need for a hand-written loop, and tightly packed rows are copied at once.
+        void CopyRows(uint8_t* dst,
+                      size_t dstPitch,
+                      const uint8_t* src,
+                      size_t srcPitch,
+                      size_t rowSize,
+                      uint32_t rowCount) {
+            if (dstPitch == rowSize && srcPitch == rowSize) {
+                memcpy(dst, src, rowSize * rowCount);
+                return;
+            }
+            for (uint32_t row = 0; row < rowCount; ++row) {
+                memcpy(dst + row * dstPitch, src + row * srcPitch, rowSize);
             }
         }
+
+        uint8_t* GetBufferPointer(BufferCopyLocation& location) {
+            return ToBackend(location.buffer)->GetBackingData() + location.offset;
+        }
+
+        // Returns the address of the first texel of the location, and the pitch of its rows and
+        // slices.
+        uint8_t* GetTexturePointer(TextureCopyLocation& location,
+                                   size_t* rowPitch,
+                                   size_t* slicePitch) {
+            Texture* texture = ToBackend(location.texture.Get());
+            uint32_t texelSize = TextureFormatPixelSize(texture->GetFormat());
+            *rowPitch = texture->GetMipLevelRowPitch(location.level);
+            *slicePitch = *rowPitch * texture->GetMipLevelHeight(location.level);
+            return texture->GetMipLevelData(location.level) + location.z * *slicePitch +
+                   location.y * *rowPitch + location.x * texelSize;
+        }
+
+        uint8_t* GetAttachmentPointer(FramebufferBase* framebuffer, uint32_t attachmentSlot) {
+            TextureBase* texture = framebuffer->GetTextureView(attachmentSlot)->GetTexture();
+            return ToBackend(texture)->GetMipLevelData(0);
+        }
+
+        struct CommandExecutor : CommandVisitor {
+            // The pipeline statistics counted during the active query, in the order of
+            // nxt::PipelineStatisticBit.
+            enum Statistic {
+                Vertices,
+                VertexShaderInvocations,
+                ClipperPrimitives,
+                FragmentShaderInvocations,
+                ComputeShaderInvocations,
+                StatisticCount,
+            };
+
+            CommandExecutor(Device* device, SubmitWorkload* workload, nxt::QueueType queueType)
+                : device(device), workload(workload), queueType(queueType) {
+            }
+
+            // The resources of the bind groups, with the push constants of a stage.
+            ShaderBindings GetShaderBindings(nxt::ShaderStage stage) {
+                ShaderBindings bindings;
+                for (uint32_t index = 0; index < kMaxBindGroups; ++index) {
+                    BindGroup* group = bindGroups[index];
+                    if (group == nullptr) {
+                        continue;
+                    }
+                    const auto& layout = group->GetLayout()->GetBindingInfo();
+                    for (uint32_t binding = 0; binding < kMaxBindingsPerGroup; ++binding) {
+                        if (!layout.mask[binding] ||
+                            (layout.types[binding] != nxt::BindingType::UniformBuffer &&
+                             layout.types[binding] != nxt::BindingType::StorageBuffer)) {
+                            continue;
+                        }
+                        BufferView* view = ToBackend(group->GetBindingAsBufferView(binding));
+                        bindings.buffers[index][binding].data =
+                            ToBackend(view->GetBuffer())->GetBackingData() + view->GetOffset();
+                        bindings.buffers[index][binding].size = view->GetSize();
+                    }
+                }
+                bindings.pushConstants = pushConstants[stage].data();
+                return bindings;
+            }
+
+            void OnBeginComputePass(BeginComputePassCmd*) {
+                pushConstants[nxt::ShaderStage::Compute].fill(0);
+            }
+            void OnSetComputePipeline(SetComputePipelineCmd* cmd) {
+                computePipeline = ToBackend(cmd->pipeline.Get());
+            }
+            void OnSetBindGroup(SetBindGroupCmd* cmd) {
+                bindGroups[cmd->index] = ToBackend(cmd->group.Get());
+            }
+            void OnSetPushConstants(SetPushConstantsCmd* cmd, uint32_t* values) {
+                for (auto stage : IterateStages(cmd->stages)) {
+                    memcpy(&pushConstants[stage][cmd->offset], values,
+                           cmd->count * sizeof(uint32_t));
+                }
+            }
+            void OnDispatch(DispatchCmd* dispatch) {
+                workload->dispatches++;
+                uint64_t workgroups =
+                    static_cast<uint64_t>(dispatch->x) * dispatch->y * dispatch->z;
+                workload->workgroups += workgroups;
+
+                const ShaderProgram* program = computePipeline->GetProgram();
+                if (program == nullptr) {
+                    return;
+                }
+
+                const auto& localSize = program->GetLocalSize();
+                statistics[ComputeShaderInvocations] +=
+                    workgroups * localSize[0] * localSize[1] * localSize[2];
+
+                ShaderBindings bindings = GetShaderBindings(nxt::ShaderStage::Compute);
+                program->Dispatch(bindings, dispatch->x, dispatch->y, dispatch->z,
+                                  device->GetThreadPool());
+            }
+
+            void OnBeginRenderPass(BeginRenderPassCmd* cmd) {
+                workload->renderPasses++;
+                renderPass = cmd->renderPass.Get();
+                framebuffer = cmd->framebuffer.Get();
+                currentSubpass = 0;
+            }
+            void OnBeginRenderSubpass(BeginRenderSubpassCmd*) {
+                const auto& subpass = renderPass->GetSubpassInfo(currentSubpass);
+                Rasterizer* rasterizer = device->GetRasterizer();
+
+                RenderTargets targets;
+                targets.width = framebuffer->GetWidth();
+                targets.height = framebuffer->GetHeight();
+                for (uint32_t location : IterateBitSet(subpass.colorAttachmentsSet)) {
+                    uint32_t slot = subpass.colorAttachments[location];
+                    RenderAttachment& attachment = targets.colors[location];
+                    attachment.data = GetAttachmentPointer(framebuffer, slot);
+                    attachment.format = renderPass->GetAttachmentInfo(slot).format;
+                    attachment.rowPitch = targets.width * TextureFormatPixelSize(attachment.format);
+                }
+                if (subpass.depthStencilAttachmentSet) {
+                    uint32_t slot = subpass.depthStencilAttachment;
+                    RenderAttachment& attachment = targets.depthStencil;
+                    attachment.data = GetAttachmentPointer(framebuffer, slot);
+                    attachment.format = renderPass->GetAttachmentInfo(slot).format;
+                    attachment.rowPitch = targets.width * TextureFormatPixelSize(attachment.format);
+                }
+                rasterizer->SetRenderTargets(targets);
+
+                // Load ops are only done for the first subpass using an attachment.
+                for (uint32_t location : IterateBitSet(subpass.colorAttachmentsSet)) {
+                    uint32_t slot = subpass.colorAttachments[location];
+                    const auto& attachmentInfo = renderPass->GetAttachmentInfo(slot);
+                    if (attachmentInfo.firstSubpass == currentSubpass &&
+                        attachmentInfo.colorLoadOp == nxt::LoadOp::Clear) {
+                        const auto& clear = framebuffer->GetClearColor(slot);
+                        rasterizer->ClearColor(location, {{clear.color[0], clear.color[1],
+                                                           clear.color[2], clear.color[3]}});
+                    }
+                }
+                if (subpass.depthStencilAttachmentSet) {
+                    uint32_t slot = subpass.depthStencilAttachment;
+                    const auto& attachmentInfo = renderPass->GetAttachmentInfo(slot);
+                    if (attachmentInfo.firstSubpass == currentSubpass) {
+                        const auto& clear = framebuffer->GetClearDepthStencil(slot);
+                        bool clearDepth = TextureFormatHasDepth(attachmentInfo.format) &&
+                                          attachmentInfo.depthLoadOp == nxt::LoadOp::Clear;
+                        bool clearStencil = TextureFormatHasStencil(attachmentInfo.format) &&
+                                            attachmentInfo.stencilLoadOp == nxt::LoadOp::Clear;
+                        rasterizer->ClearDepthStencil(clearDepth, clear.depth, clearStencil,
+                                                      clear.stencil);
+                    }
+                }
+
+                pushConstants[nxt::ShaderStage::Vertex].fill(0);
+                pushConstants[nxt::ShaderStage::Fragment].fill(0);
+                drawBindings = DrawBindings();
+            }
+            void OnEndRenderSubpass(EndRenderSubpassCmd*) {
+                currentSubpass++;
+            }
+            void OnSetRenderPipeline(SetRenderPipelineCmd* cmd) {
+                renderPipeline = ToBackend(cmd->pipeline.Get());
+            }
+            void OnSetVertexBuffers(SetVertexBuffersCmd* cmd,
+                                    Ref<BufferBase>* buffers,
+                                    uint32_t* offsets) {
+                for (uint32_t i = 0; i < cmd->count; ++i) {
+                    Buffer* buffer = ToBackend(buffers[i].Get());
+                    auto& vertexBuffer = drawBindings.vertexBuffers[cmd->startSlot + i];
+                    vertexBuffer.data = buffer->GetBackingData() + offsets[i];
+                    vertexBuffer.size = buffer->GetSize() - offsets[i];
+                }
+            }
+            void OnSetIndexBuffer(SetIndexBufferCmd* cmd) {
+                Buffer* buffer = ToBackend(cmd->buffer.Get());
+                drawBindings.indexBuffer.data = buffer->GetBackingData() + cmd->offset;
+                drawBindings.indexBuffer.size = buffer->GetSize() - cmd->offset;
+            }
+            void OnSetBlendColor(SetBlendColorCmd* cmd) {
+                drawBindings.blendColor = {{cmd->r, cmd->g, cmd->b, cmd->a}};
+            }
+            void OnSetStencilReference(SetStencilReferenceCmd* cmd) {
+                drawBindings.stencilReference = cmd->reference;
+            }
+            void OnDrawArrays(DrawArraysCmd* cmd) {
+                DrawCall draw;
+                draw.count = cmd->vertexCount;
+                draw.instanceCount = cmd->instanceCount;
+                draw.first = cmd->firstVertex;
+                draw.firstInstance = cmd->firstInstance;
+                Draw(draw);
+            }
+            void OnDrawElements(DrawElementsCmd* cmd) {
+                DrawCall draw;
+                draw.indexed = true;
+                draw.count = cmd->indexCount;
+                draw.instanceCount = cmd->instanceCount;
+                draw.first = cmd->firstIndex;
+                draw.firstInstance = cmd->firstInstance;
+                Draw(draw);
+            }
+            void Draw(const DrawCall& draw) {
+                workload->draws++;
+                uint64_t vertices = static_cast<uint64_t>(draw.count) * draw.instanceCount;
+                statistics[Vertices] += vertices;
+                statistics[VertexShaderInvocations] += vertices;
+
+                const RasterizerPipeline* pipeline = renderPipeline->GetRasterizerPipeline();
+                if (pipeline == nullptr) {
+                    return;
+                }
+
+                ShaderBindings vertexBindings = GetShaderBindings(nxt::ShaderStage::Vertex);
+                ShaderBindings fragmentBindings = GetShaderBindings(nxt::ShaderStage::Fragment);
+                drawBindings.vertex = &vertexBindings;
+                drawBindings.fragment = &fragmentBindings;
+                DrawStatistics drawStatistics =
+                    device->GetRasterizer()->Draw(*pipeline, drawBindings, draw);
+                statistics[ClipperPrimitives] += drawStatistics.primitives;
+                statistics[FragmentShaderInvocations] += drawStatistics.fragmentInvocations;
+            }
+
+            void OnCopyBufferToBuffer(CopyBufferToBufferCmd* copy) {
+                AddCopy(copy->size);
+                memmove(GetBufferPointer(copy->destination), GetBufferPointer(copy->source),
+                        copy->size);
+            }
+            void OnCopyBufferToTexture(CopyBufferToTextureCmd* copy) {
+                TextureCopyLocation& dst = copy->destination;
+                size_t rowSize = dst.width * TextureFormatPixelSize(dst.texture->GetFormat());
+                size_t bufferSlicePitch = static_cast<size_t>(copy->rowPitch) * dst.height;
+                size_t textureRowPitch;
+                size_t textureSlicePitch;
+                uint8_t* texels = GetTexturePointer(dst, &textureRowPitch, &textureSlicePitch);
+                const uint8_t* data = GetBufferPointer(copy->source);
+                AddCopy(static_cast<uint64_t>(rowSize) * dst.height * dst.depth);
+
+                for (uint32_t z = 0; z < dst.depth; ++z) {
+                    CopyRows(texels + z * textureSlicePitch, textureRowPitch,
+                             data + z * bufferSlicePitch, copy->rowPitch, rowSize, dst.height);
+                }
+            }
+            void OnCopyTextureToBuffer(CopyTextureToBufferCmd* copy) {
+                TextureCopyLocation& src = copy->source;
+                size_t rowSize = src.width * TextureFormatPixelSize(src.texture->GetFormat());
+                size_t bufferSlicePitch = static_cast<size_t>(copy->rowPitch) * src.height;
+                size_t textureRowPitch;
+                size_t textureSlicePitch;
+                const uint8_t* texels =
+                    GetTexturePointer(src, &textureRowPitch, &textureSlicePitch);
+                uint8_t* data = GetBufferPointer(copy->destination);
+                AddCopy(static_cast<uint64_t>(rowSize) * src.height * src.depth);
+
+                for (uint32_t z = 0; z < src.depth; ++z) {
+                    CopyRows(data + z * bufferSlicePitch, copy->rowPitch,
+                             texels + z * textureSlicePitch, textureRowPitch, rowSize, src.height);
+                }
+            }
+
+            void AddCopy(uint64_t size) {
+                workload->copies++;
+                workload->copiedBytes += size;
+            }
+
+            void OnWriteTimestamp(WriteTimestampCmd* cmd) {
+                QuerySet* querySet = ToBackend(cmd->querySet.Get());
+                *querySet->GetResults(cmd->queryIndex) =
+                    device->GetTimeline()->GetCommandTime(*workload, queueType);
+            }
+            void OnBeginPipelineStatisticsQuery(BeginPipelineStatisticsQueryCmd* cmd) {
+                statisticsQuerySet = ToBackend(cmd->querySet.Get());
+                statisticsQuery = cmd->queryIndex;
+                statistics.fill(0);
+            }
+            void OnEndPipelineStatisticsQuery(EndPipelineStatisticsQueryCmd*) {
+                uint64_t* results = statisticsQuerySet->GetResults(statisticsQuery);
+                std::bitset<StatisticCount> enabled(
+                    static_cast<uint32_t>(statisticsQuerySet->GetPipelineStatistics()));
+                for (uint32_t statistic : IterateBitSet(enabled)) {
+                    *results++ = statistics[statistic];
+                }
+                statisticsQuerySet = nullptr;
+            }
+            void OnResolveQuerySet(ResolveQuerySetCmd* cmd) {
+                QuerySet* querySet = ToBackend(cmd->querySet.Get());
+                size_t size = static_cast<size_t>(cmd->queryCount) *
+                              querySet->GetResultsPerQuery() * kQueryResultSize;
+                AddCopy(size);
+                memcpy(GetBufferPointer(cmd->destination), querySet->GetResults(cmd->firstQuery),
+                       size);
+            }
+
+            void OnTransitionBufferUsage(TransitionBufferUsageCmd* cmd) {
+                cmd->buffer->UpdateUsageInternal(cmd->usage);
+            }
+            void OnTransitionTextureUsage(TransitionTextureUsageCmd* cmd) {
+                cmd->texture->UpdateUsageInternal(cmd->usage);
+            }
+
+            Device* device;
+            SubmitWorkload* workload;
+            nxt::QueueType queueType;
+            ComputePipeline* computePipeline = nullptr;
+            RenderPipeline* renderPipeline = nullptr;
+            RenderPassBase* renderPass = nullptr;
+            FramebufferBase* framebuffer = nullptr;
+            uint32_t currentSubpass = 0;
+            DrawBindings drawBindings;
+            std::array<BindGroup*, kMaxBindGroups> bindGroups = {};
+            PerStage<std::array<uint32_t, kMaxPushConstants>> pushConstants;
+            QuerySet* statisticsQuerySet = nullptr;
+            uint32_t statisticsQuery = 0;
+            std::array<uint64_t, StatisticCount> statistics = {};
+        };
+
+    }  // anonymous namespace
+
+    void CommandBuffer::Execute(SubmitWorkload* workload, nxt::QueueType queueType) {
+        CommandExecutor executor(ToBackend(GetDevice()), workload, queueType);
+        VisitCommands(&mCommands, &executor);
+    }
+
+    // ComputePipeline
+
+    ComputePipeline::ComputePipeline(ComputePipelineBuilder* builder)
+        : ComputePipelineBase(builder) {
+        const auto& stage = builder->GetStageInfo(nxt::ShaderStage::Compute);
+
+        // Shaders using SPIR-V the CPU path doesn't support are valid for the other backends so
+        // they aren't errors, their dispatches are skipped instead.
+        std::string error;
+        mProgram = ShaderProgram::Create(ToBackend(stage.module)->GetSpirv(),
+                                         nxt::ShaderStage::Compute, stage.entryPoint, &error);
+    }
+
+    ComputePipeline::~ComputePipeline() {
+    }
+
+    const ShaderProgram* ComputePipeline::GetProgram() const {
+        return mProgram.get();
+    }
+
+    // RenderPipeline
+
+    RenderPipeline::RenderPipeline(RenderPipelineBuilder* builder)
+        : RenderPipelineBase(builder) {
+        // Like for compute pipelines, draws with shaders the CPU path doesn't support are skipped.
+        std::string error;
+        const auto& vertexStage = builder->GetStageInfo(nxt::ShaderStage::Vertex);
+        mVertexProgram = ShaderProgram::Create(ToBackend(vertexStage.module)->GetSpirv(),
+                                               nxt::ShaderStage::Vertex, vertexStage.entryPoint,
+                                               &error);
+        const auto& fragmentStage = builder->GetStageInfo(nxt::ShaderStage::Fragment);
+        mFragmentProgram = ShaderProgram::Create(ToBackend(fragmentStage.module)->GetSpirv(),
+                                                 nxt::ShaderStage::Fragment,
+                                                 fragmentStage.entryPoint, &error);
+
+        mRasterizerPipeline.vertex = mVertexProgram.get();
+        mRasterizerPipeline.fragment = mFragmentProgram.get();
+        mRasterizerPipeline.topology = GetPrimitiveTopology();
+        mRasterizerPipeline.indexFormat = GetIndexFormat();
+
+        InputStateBase* inputState = GetInputState();
+        mRasterizerPipeline.attributesSet = inputState->GetAttributesSetMask();
+        for (uint32_t location : IterateBitSet(inputState->GetAttributesSetMask())) {
+            mRasterizerPipeline.attributes[location] = inputState->GetAttribute(location);
+        }
+        for (uint32_t slot : IterateBitSet(inputState->GetInputsSetMask())) {
+            mRasterizerPipeline.inputs[slot] = inputState->GetInput(slot);
+        }
+
+        const auto& subpass = GetRenderPass()->GetSubpassInfo(GetSubPass());
+        for (uint32_t location : IterateBitSet(subpass.colorAttachmentsSet)) {
+            mRasterizerPipeline.blends[location] = GetBlendState(location)->GetBlendInfo();
+        }
+        mRasterizerPipeline.depth = GetDepthStencilState()->GetDepth();
+        mRasterizerPipeline.stencil = GetDepthStencilState()->GetStencil();
+    }
+
+    RenderPipeline::~RenderPipeline() {
+    }
+
+    const RasterizerPipeline* RenderPipeline::GetRasterizerPipeline() const {
+        if (mVertexProgram == nullptr || mFragmentProgram == nullptr) {
+            return nullptr;
+        }
+        return &mRasterizerPipeline;
+    }
+
+    // QuerySet
+
+    QuerySet::QuerySet(QuerySetBuilder* builder) : QuerySetBase(builder) {
+        mResults.resize(static_cast<size_t>(GetCount()) * GetResultsPerQuery());
+    }
+
+    QuerySet::~QuerySet() {
+    }
+
+    uint64_t* QuerySet::GetResults(uint32_t query) {
+        return &mResults[static_cast<size_t>(query) * GetResultsPerQuery()];
     }
 
     // Queue
@@ -198,18 +659,21 @@ namespace backend { namespace null {
     Queue::~Queue() {
     }
 
-    void Queue::Submit(uint32_t numCommands, CommandBuffer* const* commands) {
-        auto operations = ToBackend(GetDevice())->AcquirePendingOperations();
-
-        for (auto& operation : operations) {
-            operation->Execute();
-        }
+    void Queue::SubmitImpl(uint32_t numCommands, CommandBufferBase* const* commands) {
+        NXT_TRACE_EVENT("null", "Queue::Submit");
+        Device* device = ToBackend(GetDevice());
 
+        // The commands are executed right away, only their completion is simulated.
+        SubmitWorkload workload;
         for (uint32_t i = 0; i < numCommands; ++i) {
-            commands[i]->Execute();
+            ToBackend(commands[i])->Execute(&workload, GetType());
         }
 
-        operations.clear();
+        device->Submit(workload, GetType(), numCommands, commands);
+    }
+
+    void Queue::WaitImpl(Serial signalSerial) {
+        ToBackend(GetDevice())->GetTimeline()->Wait(GetType(), signalSerial);
     }
 
     // Texture
@@ -223,6 +687,40 @@ namespace backend { namespace null {
     void Texture::TransitionUsageImpl(nxt::TextureUsageBit, nxt::TextureUsageBit) {
     }
 
+    uint8_t* Texture::GetMipLevelData(uint32_t level) {
+        ASSERT(level < GetNumMipLevels());
+        if (mBackingData == nullptr) {
+            size_t size = 0;
+            for (uint32_t i = 0; i < GetNumMipLevels(); ++i) {
+                mMipLevelOffsets.push_back(size);
+                size += static_cast<size_t>(GetMipLevelRowPitch(i)) * GetMipLevelHeight(i) * GetDepth();
+            }
+            mBackingData = std::unique_ptr<uint8_t[]>(new uint8_t[size]());
+        }
+        return mBackingData.get() + mMipLevelOffsets[level];
+    }
+
+    uint32_t Texture::GetMipLevelRowPitch(uint32_t level) const {
+        uint32_t width = std::max(GetWidth() >> level, 1u);
+        return width * TextureFormatPixelSize(GetFormat());
+    }
+
+    uint32_t Texture::GetMipLevelHeight(uint32_t level) const {
+        return std::max(GetHeight() >> level, 1u);
+    }
+
+    // ShaderModule
+
+    ShaderModule::ShaderModule(ShaderModuleBuilder* builder)
+        : ShaderModuleBase(builder), mSpirv(builder->AcquireSpirv()) {
+        spirv_cross::Compiler compiler(mSpirv);
+        ExtractSpirvInfo(compiler);
+    }
+
+    const std::vector<uint32_t>& ShaderModule::GetSpirv() const {
+        return mSpirv;
+    }
+
     // SwapChain
 
     SwapChain::SwapChain(SwapChainBuilder* builder) : SwapChainBase(builder) {
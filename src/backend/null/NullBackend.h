@@ -23,11 +23,14 @@
 #include "backend/Buffer.h"
 #include "backend/CommandBuffer.h"
 #include "backend/ComputePipeline.h"
+#include "backend/DeferredWorkQueue.h"
 #include "backend/DepthStencilState.h"
 #include "backend/Device.h"
+#include "backend/Fence.h"
 #include "backend/Framebuffer.h"
 #include "backend/InputState.h"
 #include "backend/PipelineLayout.h"
+#include "backend/QuerySet.h"
 #include "backend/Queue.h"
 #include "backend/RenderPass.h"
 #include "backend/RenderPipeline.h"
@@ -36,6 +39,12 @@
 #include "backend/SwapChain.h"
 #include "backend/Texture.h"
 #include "backend/ToBackend.h"
+#include "backend/null/DeviceTimeline.h"
+#include "backend/null/Rasterizer.h"
+#include "common/ThreadPool.h"
+
+#include <memory>
+#include <vector>
 
 namespace backend { namespace null {
 
@@ -45,17 +54,19 @@ namespace backend { namespace null {
     class Buffer;
     using BufferView = BufferViewBase;
     class CommandBuffer;
-    using ComputePipeline = ComputePipelineBase;
+    class ComputePipeline;
     using DepthStencilState = DepthStencilStateBase;
     class Device;
+    using Fence = FenceBase;
     using Framebuffer = FramebufferBase;
     using InputState = InputStateBase;
     using PipelineLayout = PipelineLayoutBase;
+    class QuerySet;
     class Queue;
     using RenderPass = RenderPassBase;
-    using RenderPipeline = RenderPipelineBase;
+    class RenderPipeline;
     using Sampler = SamplerBase;
-    using ShaderModule = ShaderModuleBase;
+    class ShaderModule;
     class SwapChain;
     class Texture;
     using TextureView = TextureViewBase;
@@ -70,9 +81,11 @@ namespace backend { namespace null {
         using ComputePipelineType = ComputePipeline;
         using DepthStencilStateType = DepthStencilState;
         using DeviceType = Device;
+        using FenceType = Fence;
         using FramebufferType = Framebuffer;
         using InputStateType = InputState;
         using PipelineLayoutType = PipelineLayout;
+        using QuerySetType = QuerySet;
         using QueueType = Queue;
         using RenderPassType = RenderPass;
         using RenderPipelineType = RenderPipeline;
@@ -88,14 +101,13 @@ namespace backend { namespace null {
         return ToBackendBase<NullBackendTraits>(common);
     }
 
-    struct PendingOperation {
-        virtual ~PendingOperation() = default;
-        virtual void Execute() = 0;
-    };
+    void Init(nxtProcTable* procs, nxtDevice* device);
+    // Creates a device whose submits complete on a simulated timeline instead of immediately.
+    void Init(nxtProcTable* procs, nxtDevice* device, const TimelineDescriptor& timeline);
 
     class Device : public DeviceBase {
       public:
-        Device();
+        explicit Device(const TimelineDescriptor& timeline = TimelineDescriptor());
         ~Device();
 
         BindGroupBase* CreateBindGroup(BindGroupBuilder* builder) override;
@@ -109,6 +121,7 @@ namespace backend { namespace null {
         FramebufferBase* CreateFramebuffer(FramebufferBuilder* builder) override;
         InputStateBase* CreateInputState(InputStateBuilder* builder) override;
         PipelineLayoutBase* CreatePipelineLayout(PipelineLayoutBuilder* builder) override;
+        QuerySetBase* CreateQuerySet(QuerySetBuilder* builder) override;
         QueueBase* CreateQueue(QueueBuilder* builder) override;
         RenderPassBase* CreateRenderPass(RenderPassBuilder* builder) override;
         RenderPipelineBase* CreateRenderPipeline(RenderPipelineBuilder* builder) override;
@@ -119,12 +132,34 @@ namespace backend { namespace null {
         TextureViewBase* CreateTextureView(TextureViewBuilder* builder) override;
 
         void TickImpl() override;
+        Serial GetLastSubmittedCommandSerial() const override;
+        Serial GetCompletedCommandSerial() const override;
+
+        DeviceTimeline* GetTimeline();
+        // The serial of the next submit, that operations waiting on the GPU wait for.
+        Serial GetPendingSerial() const;
+        // Submits the workload of command buffers that have been executed, keeping them and the
+        // objects they reference alive until the submit completes, like on a GPU.
+        void Submit(const SubmitWorkload& workload,
+                    nxt::QueueType queueType,
+                    uint32_t numCommands,
+                    CommandBufferBase* const* commands);
 
-        void AddPendingOperation(std::unique_ptr<PendingOperation> operation);
-        std::vector<std::unique_ptr<PendingOperation>> AcquirePendingOperations();
+        void AddMapReadRequest(Buffer* buffer, const void* ptr, uint32_t mapSerial);
+
+        // The threads running the workgroups of dispatches and the tiles of draws, created on
+        // the first dispatch or render pass.
+        ThreadPool* GetThreadPool();
+        Rasterizer* GetRasterizer();
 
       private:
-        std::vector<std::unique_ptr<PendingOperation>> mPendingOperations;
+        // Runs the map read callbacks and releases the command buffers of the completed serials.
+        void ProcessCompletedWork();
+
+        DeviceTimeline mTimeline;
+        DeferredWorkQueue mDeferredWork;
+        std::unique_ptr<ThreadPool> mThreadPool;
+        std::unique_ptr<Rasterizer> mRasterizer;
     };
 
     class Buffer : public BufferBase {
@@ -133,6 +168,7 @@ namespace backend { namespace null {
         ~Buffer();
 
         void MapReadOperationCompleted(uint32_t serial, const void* ptr);
+        uint8_t* GetBackingData();
 
       private:
         void SetSubDataImpl(uint32_t start, uint32_t count, const uint32_t* data) override;
@@ -141,7 +177,7 @@ namespace backend { namespace null {
         void TransitionUsageImpl(nxt::BufferUsageBit currentUsage,
                                  nxt::BufferUsageBit targetUsage) override;
 
-        std::unique_ptr<char[]> mBackingData;
+        std::unique_ptr<uint8_t[]> mBackingData;
     };
 
     class CommandBuffer : public CommandBufferBase {
@@ -149,19 +185,64 @@ namespace backend { namespace null {
         CommandBuffer(CommandBufferBuilder* builder);
         ~CommandBuffer();
 
-        void Execute();
+        // Adds the commands to the workload, the queue type giving the timeline of the
+        // timestamps.
+        void Execute(SubmitWorkload* workload, nxt::QueueType queueType);
 
       private:
         CommandIterator mCommands;
     };
 
+    class ShaderProgram;
+
+    class ComputePipeline : public ComputePipelineBase {
+      public:
+        ComputePipeline(ComputePipelineBuilder* builder);
+        ~ComputePipeline();
+
+        // nullptr when the shader uses SPIR-V that can't be run on the CPU, in which case
+        // dispatches do nothing.
+        const ShaderProgram* GetProgram() const;
+
+      private:
+        std::unique_ptr<ShaderProgram> mProgram;
+    };
+
+    class RenderPipeline : public RenderPipelineBase {
+      public:
+        RenderPipeline(RenderPipelineBuilder* builder);
+        ~RenderPipeline();
+
+        // nullptr when a shader uses SPIR-V that can't be run on the CPU, in which case draws do
+        // nothing.
+        const RasterizerPipeline* GetRasterizerPipeline() const;
+
+      private:
+        std::unique_ptr<ShaderProgram> mVertexProgram;
+        std::unique_ptr<ShaderProgram> mFragmentProgram;
+        RasterizerPipeline mRasterizerPipeline;
+    };
+
+    class QuerySet : public QuerySetBase {
+      public:
+        QuerySet(QuerySetBuilder* builder);
+        ~QuerySet();
+
+        // The GetResultsPerQuery() results of the query.
+        uint64_t* GetResults(uint32_t query);
+
+      private:
+        std::vector<uint64_t> mResults;
+    };
+
     class Queue : public QueueBase {
       public:
         Queue(QueueBuilder* builder);
         ~Queue();
 
-        // NXT API
-        void Submit(uint32_t numCommands, CommandBuffer* const* commands);
+      private:
+        void SubmitImpl(uint32_t numCommands, CommandBufferBase* const* commands) override;
+        void WaitImpl(Serial signalSerial) override;
     };
 
     class Texture : public TextureBase {
@@ -171,6 +252,28 @@ namespace backend { namespace null {
 
         void TransitionUsageImpl(nxt::TextureUsageBit currentUsage,
                                  nxt::TextureUsageBit targetUsage) override;
+
+        // The mip levels are stored one after the other, each with tightly packed rows and
+        // GetDepth() slices of GetMipLevelHeight() rows.
+        uint8_t* GetMipLevelData(uint32_t level);
+        uint32_t GetMipLevelRowPitch(uint32_t level) const;
+        uint32_t GetMipLevelHeight(uint32_t level) const;
+
+      private:
+        // Allocated on the first access so that textures that are never copied from or to, like
+        // render targets, don't use memory.
+        std::unique_ptr<uint8_t[]> mBackingData;
+        std::vector<size_t> mMipLevelOffsets;
+    };
+
+    class ShaderModule : public ShaderModuleBase {
+      public:
+        ShaderModule(ShaderModuleBuilder* builder);
+
+        const std::vector<uint32_t>& GetSpirv() const;
+
+      private:
+        std::vector<uint32_t> mSpirv;
     };
 
     class SwapChain : public SwapChainBase {
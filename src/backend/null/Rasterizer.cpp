@@ -0,0 +1,981 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "backend/null/Rasterizer.h"
+
+#include "backend/Texture.h"
+#include "common/Assert.h"
+#include "common/BitSetIterator.h"
+#include "common/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace backend { namespace null {
+
+    namespace {
+
+        constexpr uint32_t kTileSize = 64;
+        constexpr uint32_t kVertexBatchSize = 64;
+        constexpr int64_t kSubpixelBits = 8;
+        constexpr int64_t kSubpixelOne = 1 << kSubpixelBits;
+        constexpr uint32_t kPositionSize = 4;
+
+        // The inputs attribute components default to when the vertex format has fewer.
+        constexpr float kDefaultAttribute[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+
+        // The clip volume planes, as the distance of a clip space position to each of them.
+        constexpr uint32_t kClipPlaneCount = 6;
+        float ClipDistance(const float* position, uint32_t plane) {
+            float w = position[3];
+            switch (plane) {
+                case 0:
+                    return w + position[0];
+                case 1:
+                    return w - position[0];
+                case 2:
+                    return w + position[1];
+                case 3:
+                    return w - position[1];
+                case 4:
+                    return position[2];
+                case 5:
+                    return w - position[2];
+                default:
+                    UNREACHABLE();
+            }
+        }
+
+        uint32_t ClipOutcode(const float* position) {
+            uint32_t outcode = 0;
+            for (uint32_t plane = 0; plane < kClipPlaneCount; ++plane) {
+                if (ClipDistance(position, plane) < 0.0f) {
+                    outcode |= 1 << plane;
+                }
+            }
+            return outcode;
+        }
+
+        int64_t FloorDiv(int64_t value, int64_t divisor) {
+            return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+        }
+
+        template <typename T>
+        bool Compare(nxt::CompareFunction function, T reference, T value) {
+            switch (function) {
+                case nxt::CompareFunction::Never:
+                    return false;
+                case nxt::CompareFunction::Less:
+                    return reference < value;
+                case nxt::CompareFunction::LessEqual:
+                    return reference <= value;
+                case nxt::CompareFunction::Greater:
+                    return reference > value;
+                case nxt::CompareFunction::GreaterEqual:
+                    return reference >= value;
+                case nxt::CompareFunction::Equal:
+                    return reference == value;
+                case nxt::CompareFunction::NotEqual:
+                    return reference != value;
+                case nxt::CompareFunction::Always:
+                    return true;
+                default:
+                    UNREACHABLE();
+            }
+        }
+
+        void ApplyStencilOperation(nxt::StencilOperation operation,
+                                   uint32_t reference,
+                                   uint32_t writeMask,
+                                   uint8_t* stencil) {
+            uint32_t value = *stencil;
+            uint32_t result;
+            switch (operation) {
+                case nxt::StencilOperation::Keep:
+                    return;
+                case nxt::StencilOperation::Zero:
+                    result = 0;
+                    break;
+                case nxt::StencilOperation::Replace:
+                    result = reference;
+                    break;
+                case nxt::StencilOperation::Invert:
+                    result = ~value;
+                    break;
+                case nxt::StencilOperation::IncrementClamp:
+                    result = std::min(value + 1, 255u);
+                    break;
+                case nxt::StencilOperation::DecrementClamp:
+                    result = value == 0 ? 0 : value - 1;
+                    break;
+                case nxt::StencilOperation::IncrementWrap:
+                    result = value + 1;
+                    break;
+                case nxt::StencilOperation::DecrementWrap:
+                    result = value - 1;
+                    break;
+                default:
+                    UNREACHABLE();
+            }
+            *stencil = static_cast<uint8_t>((value & ~writeMask) | (result & writeMask));
+        }
+
+        float BlendFactor(nxt::BlendFactor factor,
+                          uint32_t component,
+                          const float src[4],
+                          const float dst[4],
+                          const std::array<float, 4>& blendColor) {
+            switch (factor) {
+                case nxt::BlendFactor::Zero:
+                    return 0.0f;
+                case nxt::BlendFactor::One:
+                    return 1.0f;
+                case nxt::BlendFactor::SrcColor:
+                    return src[component];
+                case nxt::BlendFactor::OneMinusSrcColor:
+                    return 1.0f - src[component];
+                case nxt::BlendFactor::SrcAlpha:
+                    return src[3];
+                case nxt::BlendFactor::OneMinusSrcAlpha:
+                    return 1.0f - src[3];
+                case nxt::BlendFactor::DstColor:
+                    return dst[component];
+                case nxt::BlendFactor::OneMinusDstColor:
+                    return 1.0f - dst[component];
+                case nxt::BlendFactor::DstAlpha:
+                    return dst[3];
+                case nxt::BlendFactor::OneMinusDstAlpha:
+                    return 1.0f - dst[3];
+                case nxt::BlendFactor::SrcAlphaSaturated:
+                    return component == 3 ? 1.0f : std::min(src[3], 1.0f - dst[3]);
+                case nxt::BlendFactor::BlendColor:
+                    return blendColor[component];
+                case nxt::BlendFactor::OneMinusBlendColor:
+                    return 1.0f - blendColor[component];
+                default:
+                    UNREACHABLE();
+            }
+        }
+
+        float BlendComponent(const BlendStateBase::BlendInfo::BlendOpFactor& blend,
+                             uint32_t component,
+                             const float src[4],
+                             const float dst[4],
+                             const std::array<float, 4>& blendColor) {
+            float s = src[component];
+            float d = dst[component];
+            float srcFactor = BlendFactor(blend.srcFactor, component, src, dst, blendColor);
+            float dstFactor = BlendFactor(blend.dstFactor, component, src, dst, blendColor);
+            switch (blend.operation) {
+                case nxt::BlendOperation::Add:
+                    return s * srcFactor + d * dstFactor;
+                case nxt::BlendOperation::Subtract:
+                    return s * srcFactor - d * dstFactor;
+                case nxt::BlendOperation::ReverseSubtract:
+                    return d * dstFactor - s * srcFactor;
+                case nxt::BlendOperation::Min:
+                    return std::min(s, d);
+                case nxt::BlendOperation::Max:
+                    return std::max(s, d);
+                default:
+                    UNREACHABLE();
+            }
+        }
+
+        float Saturate(float value) {
+            // Also turns NaNs into 0.
+            return value > 0.0f ? std::min(value, 1.0f) : 0.0f;
+        }
+
+        // The index of the byte holding each RGBA component in a texel of a color format.
+        const uint32_t* ComponentBytes(nxt::TextureFormat format) {
+            static constexpr uint32_t kRGBA[4] = {0, 1, 2, 3};
+            static constexpr uint32_t kBGRA[4] = {2, 1, 0, 3};
+            return format == nxt::TextureFormat::B8G8R8A8Unorm ? kBGRA : kRGBA;
+        }
+
+        void EncodeUnorm(nxt::TextureFormat format,
+                         const float color[4],
+                         nxt::ColorWriteMask writeMask,
+                         uint8_t* texel) {
+            const uint32_t* bytes = ComponentBytes(format);
+            for (uint32_t i = 0; i < 4; ++i) {
+                if (static_cast<uint32_t>(writeMask) & (1 << i)) {
+                    texel[bytes[i]] = static_cast<uint8_t>(Saturate(color[i]) * 255.0f + 0.5f);
+                }
+            }
+        }
+
+        // Writes the raw value of a fragment shader output to a color attachment texel.
+        void WriteColor(nxt::TextureFormat format,
+                        const BlendStateBase::BlendInfo& blend,
+                        const std::array<float, 4>& blendColor,
+                        const uint32_t output[4],
+                        uint8_t* texel) {
+            if (format == nxt::TextureFormat::R8G8B8A8Uint) {
+                // Integer formats aren't blended.
+                for (uint32_t i = 0; i < 4; ++i) {
+                    if (static_cast<uint32_t>(blend.colorWriteMask) & (1 << i)) {
+                        texel[i] = static_cast<uint8_t>(std::min(output[i], 255u));
+                    }
+                }
+                return;
+            }
+
+            float src[4];
+            memcpy(src, output, sizeof(src));
+            for (uint32_t i = 0; i < 4; ++i) {
+                src[i] = Saturate(src[i]);
+            }
+
+            if (blend.blendEnabled) {
+                const uint32_t* bytes = ComponentBytes(format);
+                float dst[4];
+                for (uint32_t i = 0; i < 4; ++i) {
+                    dst[i] = texel[bytes[i]] / 255.0f;
+                }
+
+                float result[4];
+                for (uint32_t i = 0; i < 3; ++i) {
+                    result[i] = BlendComponent(blend.colorBlend, i, src, dst, blendColor);
+                }
+                result[3] = BlendComponent(blend.alphaBlend, 3, src, dst, blendColor);
+                EncodeUnorm(format, result, blend.colorWriteMask, texel);
+            } else {
+                EncodeUnorm(format, src, blend.colorWriteMask, texel);
+            }
+        }
+
+        uint8_t* TexelPointer(const RenderAttachment& attachment, uint32_t x, uint32_t y) {
+            return attachment.data + static_cast<size_t>(y) * attachment.rowPitch +
+                   x * TextureFormatPixelSize(attachment.format);
+        }
+
+    }  // anonymous namespace
+
+    // The per-thread state of the rasterization of the tiles.
+    struct Rasterizer::FragmentContext {
+        uint8_t* frame;
+        const DrawBindings* bindings;
+        uint64_t fragmentInvocations;
+    };
+
+    Rasterizer::Rasterizer(ThreadPool* pool) : mPool(pool) {
+        mVertexFrames.resize(pool->GetThreadCount());
+        mFragmentFrames.resize(pool->GetThreadCount());
+    }
+
+    Rasterizer::~Rasterizer() {
+    }
+
+    void Rasterizer::SetRenderTargets(const RenderTargets& targets) {
+        mTargets = targets;
+        mTilesX = (targets.width + kTileSize - 1) / kTileSize;
+        mTilesY = (targets.height + kTileSize - 1) / kTileSize;
+        mBins.resize(mTilesX * mTilesY);
+    }
+
+    void Rasterizer::ClearColor(uint32_t location, const std::array<float, 4>& color) {
+        const RenderAttachment& attachment = mTargets.colors[location];
+        if (attachment.data == nullptr) {
+            return;
+        }
+
+        uint8_t clearTexel[4];
+        if (attachment.format == nxt::TextureFormat::R8G8B8A8Uint) {
+            for (uint32_t i = 0; i < 4; ++i) {
+                clearTexel[i] = static_cast<uint8_t>(std::min(std::max(color[i], 0.0f), 255.0f));
+            }
+        } else {
+            EncodeUnorm(attachment.format, color.data(), nxt::ColorWriteMask::All, clearTexel);
+        }
+
+        for (uint32_t y = 0; y < mTargets.height; ++y) {
+            for (uint32_t x = 0; x < mTargets.width; ++x) {
+                memcpy(TexelPointer(attachment, x, y), clearTexel, sizeof(clearTexel));
+            }
+        }
+    }
+
+    void Rasterizer::ClearDepthStencil(bool clearDepth,
+                                       float depth,
+                                       bool clearStencil,
+                                       uint32_t stencil) {
+        const RenderAttachment& attachment = mTargets.depthStencil;
+        if (attachment.data == nullptr) {
+            return;
+        }
+
+        for (uint32_t y = 0; y < mTargets.height; ++y) {
+            for (uint32_t x = 0; x < mTargets.width; ++x) {
+                uint8_t* texel = TexelPointer(attachment, x, y);
+                if (clearDepth) {
+                    memcpy(texel, &depth, sizeof(depth));
+                }
+                if (clearStencil) {
+                    texel[4] = static_cast<uint8_t>(stencil);
+                }
+            }
+        }
+    }
+
+    DrawStatistics Rasterizer::Draw(const RasterizerPipeline& pipeline,
+                                    const DrawBindings& bindings,
+                                    const DrawCall& draw) {
+        DrawStatistics statistics;
+        if (draw.count == 0 || mTargets.width == 0 || mTargets.height == 0) {
+            return statistics;
+        }
+
+        // The vertex records hold the outputs of the vertex shader for the inputs of the fragment
+        // shader, packed by location.
+        const ShaderInterface& vertexInterface = pipeline.vertex->GetInterface();
+        const ShaderInterface& fragmentInterface = pipeline.fragment->GetInterface();
+        mVertexStride = kPositionSize;
+        for (uint32_t location = 0; location < kMaxInterfaceLocations; ++location) {
+            uint32_t size = 0;
+            if (fragmentInterface.inputs[location].size != 0) {
+                size = std::min(vertexInterface.outputs[location].size / 4, 4u);
+            }
+            mVaryingOffsets[location] = mVertexStride;
+            mVaryingSizes[location] = size;
+            mVertexStride += size;
+        }
+
+        for (uint32_t thread = 0; thread < mPool->GetThreadCount(); ++thread) {
+            mVertexFrames[thread].resize(pipeline.vertex->GetFrameSize());
+            pipeline.vertex->InitializeFrame(*bindings.vertex, mVertexFrames[thread].data());
+            mFragmentFrames[thread].resize(pipeline.fragment->GetFrameSize());
+            pipeline.fragment->InitializeFrame(*bindings.fragment,
+                                               mFragmentFrames[thread].data());
+        }
+
+        std::atomic<uint64_t> fragmentInvocations(0);
+        for (uint32_t instance = 0; instance < draw.instanceCount; ++instance) {
+            ShadeVertices(pipeline, bindings, draw, draw.firstInstance + instance);
+            AssemblePrimitives(pipeline, draw.count);
+            ComputeScreenVertices();
+            BinPrimitives();
+            statistics.primitives += mPrimitives.size();
+
+            mPool->ParallelFor(static_cast<uint32_t>(mNonEmptyTiles.size()),
+                               [&](uint32_t index, uint32_t threadIndex) {
+                                   FragmentContext context;
+                                   context.frame = mFragmentFrames[threadIndex].data();
+                                   context.bindings = &bindings;
+                                   context.fragmentInvocations = 0;
+                                   RasterizeTile(pipeline, mNonEmptyTiles[index], &context);
+                                   fragmentInvocations.fetch_add(context.fragmentInvocations,
+                                                                 std::memory_order_relaxed);
+                               });
+        }
+
+        statistics.fragmentInvocations = fragmentInvocations.load();
+        return statistics;
+    }
+
+    void Rasterizer::ShadeVertices(const RasterizerPipeline& pipeline,
+                                   const DrawBindings& bindings,
+                                   const DrawCall& draw,
+                                   uint32_t instanceIndex) {
+        mVertices.resize(static_cast<size_t>(draw.count) * mVertexStride);
+
+        const ShaderProgram* program = pipeline.vertex;
+        const ShaderInterface& interface = program->GetInterface();
+        uint32_t indexSize = static_cast<uint32_t>(IndexFormatSize(pipeline.indexFormat));
+
+        uint32_t batchCount = (draw.count + kVertexBatchSize - 1) / kVertexBatchSize;
+        mPool->ParallelFor(batchCount, [&](uint32_t batch, uint32_t threadIndex) {
+            uint8_t* frame = mVertexFrames[threadIndex].data();
+            uint32_t begin = batch * kVertexBatchSize;
+            uint32_t end = std::min(begin + kVertexBatchSize, draw.count);
+
+            for (uint32_t i = begin; i < end; ++i) {
+                uint32_t vertexIndex = draw.first + i;
+                if (draw.indexed) {
+                    // Indices outside of the index buffer are 0.
+                    uint64_t offset = static_cast<uint64_t>(vertexIndex) * indexSize;
+                    vertexIndex = 0;
+                    if (offset + indexSize <= bindings.indexBuffer.size) {
+                        if (indexSize == sizeof(uint16_t)) {
+                            uint16_t index16;
+                            memcpy(&index16, bindings.indexBuffer.data + offset, indexSize);
+                            vertexIndex = index16;
+                        } else {
+                            memcpy(&vertexIndex, bindings.indexBuffer.data + offset, indexSize);
+                        }
+                    }
+                }
+
+                for (uint32_t location : IterateBitSet(pipeline.attributesSet)) {
+                    const InterfaceVariable& input = interface.inputs[location];
+                    if (input.size == 0) {
+                        continue;
+                    }
+
+                    const InputStateBase::AttributeInfo& attribute =
+                        pipeline.attributes[location];
+                    const InputStateBase::InputInfo& vertexInput =
+                        pipeline.inputs[attribute.bindingSlot];
+                    const DrawBindings::BufferData& buffer =
+                        bindings.vertexBuffers[attribute.bindingSlot];
+                    uint32_t element = vertexInput.stepMode == nxt::InputStepMode::Vertex
+                                           ? vertexIndex
+                                           : instanceIndex;
+
+                    // Fetches outside of the vertex buffer return the default values.
+                    float value[4];
+                    memcpy(value, kDefaultAttribute, sizeof(value));
+                    uint32_t componentCount = VertexFormatNumComponents(attribute.format);
+                    uint64_t offset = attribute.offset +
+                                      static_cast<uint64_t>(element) * vertexInput.stride;
+                    if (offset + componentCount * sizeof(float) <= buffer.size) {
+                        memcpy(value, buffer.data + offset, componentCount * sizeof(float));
+                    }
+                    memcpy(frame + input.offset, value, std::min<size_t>(input.size, 16));
+                }
+                if (interface.vertexIndex.size != 0) {
+                    memcpy(frame + interface.vertexIndex.offset, &vertexIndex, sizeof(uint32_t));
+                }
+                if (interface.instanceIndex.size != 0) {
+                    memcpy(frame + interface.instanceIndex.offset, &instanceIndex,
+                           sizeof(uint32_t));
+                }
+
+                program->RunInvocation(frame);
+
+                float* record = &mVertices[static_cast<size_t>(i) * mVertexStride];
+                if (interface.position.size != 0) {
+                    memcpy(record, frame + interface.position.offset,
+                           kPositionSize * sizeof(float));
+                } else {
+                    std::fill(record, record + kPositionSize, 0.0f);
+                }
+                for (uint32_t location = 0; location < kMaxInterfaceLocations; ++location) {
+                    if (mVaryingSizes[location] != 0) {
+                        memcpy(record + mVaryingOffsets[location],
+                               frame + interface.outputs[location].offset,
+                               mVaryingSizes[location] * sizeof(float));
+                    }
+                }
+            }
+        });
+    }
+
+    void Rasterizer::AssemblePrimitives(const RasterizerPipeline& pipeline,
+                                        uint32_t vertexCount) {
+        mPrimitives.clear();
+        switch (pipeline.topology) {
+            case nxt::PrimitiveTopology::PointList:
+                for (uint32_t i = 0; i < vertexCount; ++i) {
+                    AddPoint(i);
+                }
+                break;
+            case nxt::PrimitiveTopology::LineList:
+                for (uint32_t i = 0; i + 1 < vertexCount; i += 2) {
+                    AddLine(i, i + 1);
+                }
+                break;
+            case nxt::PrimitiveTopology::LineStrip:
+                for (uint32_t i = 0; i + 1 < vertexCount; ++i) {
+                    AddLine(i, i + 1);
+                }
+                break;
+            case nxt::PrimitiveTopology::TriangleList:
+                for (uint32_t i = 0; i + 2 < vertexCount; i += 3) {
+                    AddTriangle(i, i + 1, i + 2);
+                }
+                break;
+            case nxt::PrimitiveTopology::TriangleStrip:
+                // Every other triangle is swapped to keep the winding of the strip.
+                for (uint32_t i = 0; i + 2 < vertexCount; ++i) {
+                    if (i % 2 == 0) {
+                        AddTriangle(i, i + 1, i + 2);
+                    } else {
+                        AddTriangle(i + 1, i, i + 2);
+                    }
+                }
+                break;
+            default:
+                UNREACHABLE();
+        }
+    }
+
+    void Rasterizer::AddTriangle(uint32_t a, uint32_t b, uint32_t c) {
+        uint32_t outcodes[3] = {ClipOutcode(&mVertices[a * mVertexStride]),
+                                ClipOutcode(&mVertices[b * mVertexStride]),
+                                ClipOutcode(&mVertices[c * mVertexStride])};
+        if ((outcodes[0] & outcodes[1] & outcodes[2]) != 0) {
+            return;
+        }
+
+        Primitive primitive;
+        primitive.vertexCount = 3;
+        primitive.provokingVertex = a;
+
+        if ((outcodes[0] | outcodes[1] | outcodes[2]) == 0) {
+            primitive.vertices = {{a, b, c}};
+            mPrimitives.push_back(primitive);
+            return;
+        }
+
+        // Clip the polygon against each plane it crosses, then triangulate it as a fan. Each
+        // plane adds at most one vertex to the polygon.
+        std::array<uint32_t, 3 + kClipPlaneCount> polygon = {{a, b, c}};
+        std::array<uint32_t, 3 + kClipPlaneCount> clipped;
+        uint32_t polygonSize = 3;
+        for (uint32_t plane = 0; plane < kClipPlaneCount && polygonSize != 0; ++plane) {
+            if (((outcodes[0] | outcodes[1] | outcodes[2]) & (1 << plane)) == 0) {
+                continue;
+            }
+
+            uint32_t clippedSize = 0;
+            for (uint32_t i = 0; i < polygonSize; ++i) {
+                uint32_t current = polygon[i];
+                uint32_t next = polygon[(i + 1) % polygonSize];
+                float currentDistance = ClipDistance(&mVertices[current * mVertexStride], plane);
+                float nextDistance = ClipDistance(&mVertices[next * mVertexStride], plane);
+
+                if (currentDistance >= 0.0f) {
+                    clipped[clippedSize++] = current;
+                }
+                if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+                    float t = currentDistance / (currentDistance - nextDistance);
+                    clipped[clippedSize++] = AddIntersection(current, next, t);
+                }
+            }
+            polygon = clipped;
+            polygonSize = clippedSize;
+        }
+
+        for (uint32_t i = 1; i + 1 < polygonSize; ++i) {
+            primitive.vertices = {{polygon[0], polygon[i], polygon[i + 1]}};
+            mPrimitives.push_back(primitive);
+        }
+    }
+
+    void Rasterizer::AddLine(uint32_t a, uint32_t b) {
+        float t0 = 0.0f;
+        float t1 = 1.0f;
+        for (uint32_t plane = 0; plane < kClipPlaneCount; ++plane) {
+            float distanceA = ClipDistance(&mVertices[a * mVertexStride], plane);
+            float distanceB = ClipDistance(&mVertices[b * mVertexStride], plane);
+            if (distanceA < 0.0f && distanceB < 0.0f) {
+                return;
+            }
+            if (distanceA < 0.0f) {
+                t0 = std::max(t0, distanceA / (distanceA - distanceB));
+            } else if (distanceB < 0.0f) {
+                t1 = std::min(t1, distanceA / (distanceA - distanceB));
+            }
+        }
+        if (t0 >= t1) {
+            return;
+        }
+
+        Primitive primitive;
+        primitive.vertexCount = 2;
+        primitive.provokingVertex = a;
+        primitive.vertices[0] = t0 > 0.0f ? AddIntersection(a, b, t0) : a;
+        primitive.vertices[1] = t1 < 1.0f ? AddIntersection(a, b, t1) : b;
+        mPrimitives.push_back(primitive);
+    }
+
+    void Rasterizer::AddPoint(uint32_t a) {
+        if (ClipOutcode(&mVertices[a * mVertexStride]) != 0) {
+            return;
+        }
+
+        Primitive primitive;
+        primitive.vertexCount = 1;
+        primitive.provokingVertex = a;
+        primitive.vertices[0] = a;
+        mPrimitives.push_back(primitive);
+    }
+
+    uint32_t Rasterizer::AddIntersection(uint32_t a, uint32_t b, float t) {
+        uint32_t index = static_cast<uint32_t>(mVertices.size() / mVertexStride);
+        mVertices.resize(mVertices.size() + mVertexStride);
+        const float* recordA = &mVertices[a * mVertexStride];
+        const float* recordB = &mVertices[b * mVertexStride];
+        float* record = &mVertices[index * mVertexStride];
+        for (uint32_t i = 0; i < mVertexStride; ++i) {
+            record[i] = recordA[i] + t * (recordB[i] - recordA[i]);
+        }
+        return index;
+    }
+
+    void Rasterizer::ComputeScreenVertices() {
+        uint32_t vertexCount = static_cast<uint32_t>(mVertices.size() / mVertexStride);
+        mScreenVertices.resize(vertexCount);
+
+        float width = static_cast<float>(mTargets.width);
+        float height = static_cast<float>(mTargets.height);
+        for (uint32_t i = 0; i < vertexCount; ++i) {
+            const float* position = &mVertices[i * mVertexStride];
+            ScreenVertex& vertex = mScreenVertices[i];
+
+            // Vertices outside of the clip volume aren't used by primitives, but keep them finite.
+            float w = position[3];
+            vertex.invW = w > 0.0f ? 1.0f / w : 0.0f;
+            vertex.x = (position[0] * vertex.invW + 1.0f) * 0.5f * width;
+            vertex.y = (position[1] * vertex.invW + 1.0f) * 0.5f * height;
+            vertex.z = position[2] * vertex.invW;
+            if (!(std::abs(vertex.x) <= 2.0f * width && std::abs(vertex.y) <= 2.0f * height)) {
+                vertex.x = 0.0f;
+                vertex.y = 0.0f;
+            }
+            vertex.fixedX = static_cast<int64_t>(std::floor(vertex.x * kSubpixelOne + 0.5f));
+            vertex.fixedY = static_cast<int64_t>(std::floor(vertex.y * kSubpixelOne + 0.5f));
+        }
+    }
+
+    void Rasterizer::BinPrimitives() {
+        int32_t maxX = static_cast<int32_t>(mTargets.width) - 1;
+        int32_t maxY = static_cast<int32_t>(mTargets.height) - 1;
+
+        for (std::vector<uint32_t>& bin : mBins) {
+            bin.clear();
+        }
+
+        for (uint32_t i = 0; i < mPrimitives.size(); ++i) {
+            Primitive& primitive = mPrimitives[i];
+
+            if (primitive.vertexCount == 3) {
+                const ScreenVertex* v[3] = {&mScreenVertices[primitive.vertices[0]],
+                                            &mScreenVertices[primitive.vertices[1]],
+                                            &mScreenVertices[primitive.vertices[2]]};
+                int64_t area = (v[1]->fixedX - v[0]->fixedX) * (v[2]->fixedY - v[0]->fixedY) -
+                               (v[1]->fixedY - v[0]->fixedY) * (v[2]->fixedX - v[0]->fixedX);
+                if (area == 0) {
+                    continue;
+                }
+                primitive.frontFacing = area > 0;
+                if (area < 0) {
+                    std::swap(primitive.vertices[1], primitive.vertices[2]);
+                }
+
+                int64_t minFixedX = std::min({v[0]->fixedX, v[1]->fixedX, v[2]->fixedX});
+                int64_t minFixedY = std::min({v[0]->fixedY, v[1]->fixedY, v[2]->fixedY});
+                int64_t maxFixedX = std::max({v[0]->fixedX, v[1]->fixedX, v[2]->fixedX});
+                int64_t maxFixedY = std::max({v[0]->fixedY, v[1]->fixedY, v[2]->fixedY});
+                primitive.minX = static_cast<int32_t>(FloorDiv(minFixedX, kSubpixelOne));
+                primitive.minY = static_cast<int32_t>(FloorDiv(minFixedY, kSubpixelOne));
+                primitive.maxX = static_cast<int32_t>(FloorDiv(maxFixedX, kSubpixelOne));
+                primitive.maxY = static_cast<int32_t>(FloorDiv(maxFixedY, kSubpixelOne));
+            } else {
+                primitive.frontFacing = true;
+                float minScreenX = mScreenVertices[primitive.vertices[0]].x;
+                float minScreenY = mScreenVertices[primitive.vertices[0]].y;
+                float maxScreenX = minScreenX;
+                float maxScreenY = minScreenY;
+                if (primitive.vertexCount == 2) {
+                    const ScreenVertex& end = mScreenVertices[primitive.vertices[1]];
+                    minScreenX = std::min(minScreenX, end.x);
+                    minScreenY = std::min(minScreenY, end.y);
+                    maxScreenX = std::max(maxScreenX, end.x);
+                    maxScreenY = std::max(maxScreenY, end.y);
+                }
+                primitive.minX = static_cast<int32_t>(std::floor(minScreenX));
+                primitive.minY = static_cast<int32_t>(std::floor(minScreenY));
+                primitive.maxX = static_cast<int32_t>(std::floor(maxScreenX));
+                primitive.maxY = static_cast<int32_t>(std::floor(maxScreenY));
+            }
+
+            primitive.minX = std::max(primitive.minX, 0);
+            primitive.minY = std::max(primitive.minY, 0);
+            primitive.maxX = std::min(primitive.maxX, maxX);
+            primitive.maxY = std::min(primitive.maxY, maxY);
+            if (primitive.minX > primitive.maxX || primitive.minY > primitive.maxY) {
+                continue;
+            }
+
+            for (uint32_t tileY = primitive.minY / kTileSize; tileY <= primitive.maxY / kTileSize;
+                 ++tileY) {
+                for (uint32_t tileX = primitive.minX / kTileSize;
+                     tileX <= primitive.maxX / kTileSize; ++tileX) {
+                    mBins[tileY * mTilesX + tileX].push_back(i);
+                }
+            }
+        }
+
+        mNonEmptyTiles.clear();
+        for (uint32_t tile = 0; tile < mBins.size(); ++tile) {
+            if (!mBins[tile].empty()) {
+                mNonEmptyTiles.push_back(tile);
+            }
+        }
+    }
+
+    void Rasterizer::RasterizeTile(const RasterizerPipeline& pipeline,
+                                   uint32_t tile,
+                                   FragmentContext* context) const {
+        int32_t tileMinX = static_cast<int32_t>((tile % mTilesX) * kTileSize);
+        int32_t tileMinY = static_cast<int32_t>((tile / mTilesX) * kTileSize);
+        int32_t tileMaxX = tileMinX + static_cast<int32_t>(kTileSize) - 1;
+        int32_t tileMaxY = tileMinY + static_cast<int32_t>(kTileSize) - 1;
+
+        for (uint32_t primitiveIndex : mBins[tile]) {
+            const Primitive& primitive = mPrimitives[primitiveIndex];
+            int32_t minX = std::max(primitive.minX, tileMinX);
+            int32_t minY = std::max(primitive.minY, tileMinY);
+            int32_t maxX = std::min(primitive.maxX, tileMaxX);
+            int32_t maxY = std::min(primitive.maxY, tileMaxY);
+
+            if (primitive.vertexCount == 1) {
+                const ScreenVertex& v = mScreenVertices[primitive.vertices[0]];
+                float weights[3] = {1.0f, 0.0f, 0.0f};
+                float fragCoord[4] = {minX + 0.5f, minY + 0.5f, v.z, v.invW};
+                ShadeFragment(pipeline, primitive, weights, fragCoord, context);
+                continue;
+            }
+
+            if (primitive.vertexCount == 2) {
+                const ScreenVertex& v0 = mScreenVertices[primitive.vertices[0]];
+                const ScreenVertex& v1 = mScreenVertices[primitive.vertices[1]];
+                float dx = v1.x - v0.x;
+                float dy = v1.y - v0.y;
+                bool xMajor = std::abs(dx) >= std::abs(dy);
+                float majorStart = xMajor ? v0.x : v0.y;
+                float majorDelta = xMajor ? dx : dy;
+                float minorStart = xMajor ? v0.y : v0.x;
+                float minorDelta = xMajor ? dy : dx;
+                if (majorDelta == 0.0f) {
+                    continue;
+                }
+
+                // The pixels whose centers are in [start, end) along the major axis.
+                float majorEnd = majorStart + majorDelta;
+                int32_t first =
+                    static_cast<int32_t>(std::ceil(std::min(majorStart, majorEnd) - 0.5f));
+                int32_t last =
+                    static_cast<int32_t>(std::ceil(std::max(majorStart, majorEnd) - 0.5f)) - 1;
+                first = std::max(first, xMajor ? minX : minY);
+                last = std::min(last, xMajor ? maxX : maxY);
+
+                for (int32_t major = first; major <= last; ++major) {
+                    float t = (major + 0.5f - majorStart) / majorDelta;
+                    int32_t minor =
+                        static_cast<int32_t>(std::floor(minorStart + t * minorDelta));
+                    int32_t x = xMajor ? major : minor;
+                    int32_t y = xMajor ? minor : major;
+                    if (x < minX || x > maxX || y < minY || y > maxY) {
+                        continue;
+                    }
+
+                    float invW = (1.0f - t) * v0.invW + t * v1.invW;
+                    float weights[3] = {(1.0f - t) * v0.invW / invW, t * v1.invW / invW, 0.0f};
+                    float fragCoord[4] = {x + 0.5f, y + 0.5f, (1.0f - t) * v0.z + t * v1.z,
+                                          invW};
+                    ShadeFragment(pipeline, primitive, weights, fragCoord, context);
+                }
+                continue;
+            }
+
+            const ScreenVertex* v[3] = {&mScreenVertices[primitive.vertices[0]],
+                                        &mScreenVertices[primitive.vertices[1]],
+                                        &mScreenVertices[primitive.vertices[2]]};
+
+            // The edge function of the edge i is positive on the side of the vertex i. Pixels on
+            // an edge are only covered by one of the two triangles sharing the edge: the one for
+            // which it is a top or left edge.
+            int64_t edgeDx[3];
+            int64_t edgeDy[3];
+            int64_t edgeRowStart[3];
+            for (uint32_t i = 0; i < 3; ++i) {
+                const ScreenVertex* a = v[(i + 1) % 3];
+                const ScreenVertex* b = v[(i + 2) % 3];
+                edgeDx[i] = b->fixedX - a->fixedX;
+                edgeDy[i] = b->fixedY - a->fixedY;
+
+                int64_t pixelX = minX * kSubpixelOne + kSubpixelOne / 2;
+                int64_t pixelY = minY * kSubpixelOne + kSubpixelOne / 2;
+                edgeRowStart[i] = edgeDx[i] * (pixelY - a->fixedY) -
+                                  edgeDy[i] * (pixelX - a->fixedX);
+                bool topLeft = edgeDy[i] > 0 || (edgeDy[i] == 0 && edgeDx[i] < 0);
+                if (!topLeft) {
+                    edgeRowStart[i] -= 1;
+                }
+            }
+            // Twice the area of the triangle, which is positive since it is counter-clockwise.
+            int64_t area = edgeDx[0] * (v[0]->fixedY - v[1]->fixedY) -
+                           edgeDy[0] * (v[0]->fixedX - v[1]->fixedX);
+            float invArea = 1.0f / static_cast<float>(area);
+
+            for (int32_t y = minY; y <= maxY; ++y) {
+                int64_t edges[3] = {edgeRowStart[0], edgeRowStart[1], edgeRowStart[2]};
+                for (int32_t x = minX; x <= maxX; ++x) {
+                    if ((edges[0] | edges[1] | edges[2]) >= 0) {
+                        float barycentrics[3];
+                        for (uint32_t i = 0; i < 3; ++i) {
+                            barycentrics[i] = static_cast<float>(edges[i]) * invArea;
+                        }
+
+                        float invW = barycentrics[0] * v[0]->invW +
+                                     barycentrics[1] * v[1]->invW + barycentrics[2] * v[2]->invW;
+                        float weights[3];
+                        for (uint32_t i = 0; i < 3; ++i) {
+                            weights[i] = barycentrics[i] * v[i]->invW / invW;
+                        }
+                        float z = barycentrics[0] * v[0]->z + barycentrics[1] * v[1]->z +
+                                  barycentrics[2] * v[2]->z;
+                        float fragCoord[4] = {x + 0.5f, y + 0.5f, z, invW};
+                        ShadeFragment(pipeline, primitive, weights, fragCoord, context);
+                    }
+                    for (uint32_t i = 0; i < 3; ++i) {
+                        edges[i] -= edgeDy[i] * kSubpixelOne;
+                    }
+                }
+                for (uint32_t i = 0; i < 3; ++i) {
+                    edgeRowStart[i] += edgeDx[i] * kSubpixelOne;
+                }
+            }
+        }
+    }
+
+    void Rasterizer::ShadeFragment(const RasterizerPipeline& pipeline,
+                                   const Primitive& primitive,
+                                   const float weights[3],
+                                   const float fragCoord[4],
+                                   FragmentContext* context) const {
+        const ShaderProgram* program = pipeline.fragment;
+        const ShaderInterface& interface = program->GetInterface();
+        uint8_t* frame = context->frame;
+        const DrawBindings& bindings = *context->bindings;
+
+        uint32_t x = static_cast<uint32_t>(fragCoord[0]);
+        uint32_t y = static_cast<uint32_t>(fragCoord[1]);
+        uint8_t* depthStencilTexel = nullptr;
+        if (mTargets.depthStencil.data != nullptr) {
+            depthStencilTexel = TexelPointer(mTargets.depthStencil, x, y);
+        }
+        float depth = std::min(std::max(fragCoord[2], 0.0f), 1.0f);
+
+        // The tests can run before the shader when it can't discard the fragment or change its
+        // depth, which skips shading the occluded fragments.
+        bool earlyTests = !program->CanKill() && interface.fragDepth.size == 0;
+        if (earlyTests && depthStencilTexel != nullptr &&
+            !DepthStencilTest(pipeline, primitive.frontFacing, depth, depthStencilTexel,
+                              bindings.stencilReference)) {
+            return;
+        }
+
+        for (uint32_t location = 0; location < kMaxInterfaceLocations; ++location) {
+            const InterfaceVariable& input = interface.inputs[location];
+            if (input.size == 0) {
+                continue;
+            }
+
+            uint32_t varyingSize = mVaryingSizes[location];
+            uint32_t offset = mVaryingOffsets[location];
+            float value[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            if (input.flat) {
+                memcpy(value, &mVertices[primitive.provokingVertex * mVertexStride + offset],
+                       varyingSize * sizeof(float));
+            } else {
+                for (uint32_t i = 0; i < primitive.vertexCount; ++i) {
+                    const float* varying =
+                        &mVertices[primitive.vertices[i] * mVertexStride + offset];
+                    for (uint32_t component = 0; component < varyingSize; ++component) {
+                        value[component] += weights[i] * varying[component];
+                    }
+                }
+            }
+            memcpy(frame + input.offset, value, std::min<size_t>(input.size, sizeof(value)));
+        }
+        if (interface.fragCoord.size != 0) {
+            memcpy(frame + interface.fragCoord.offset, fragCoord, 4 * sizeof(float));
+        }
+        if (interface.frontFacing.size != 0) {
+            uint32_t frontFacing = primitive.frontFacing ? 1 : 0;
+            memcpy(frame + interface.frontFacing.offset, &frontFacing, sizeof(frontFacing));
+        }
+
+        context->fragmentInvocations++;
+        if (!program->RunInvocation(frame)) {
+            return;
+        }
+
+        if (!earlyTests && depthStencilTexel != nullptr) {
+            if (interface.fragDepth.size != 0) {
+                memcpy(&depth, frame + interface.fragDepth.offset, sizeof(depth));
+                depth = Saturate(depth);
+            }
+            if (!DepthStencilTest(pipeline, primitive.frontFacing, depth, depthStencilTexel,
+                                  bindings.stencilReference)) {
+                return;
+            }
+        }
+
+        for (uint32_t location = 0; location < kMaxColorAttachments; ++location) {
+            const RenderAttachment& attachment = mTargets.colors[location];
+            const InterfaceVariable& output = interface.outputs[location];
+            if (attachment.data == nullptr || output.size == 0) {
+                continue;
+            }
+
+            // Components the shader doesn't write are 0, with an alpha of 1.
+            uint32_t value[4] = {0, 0, 0, 0};
+            if (attachment.format != nxt::TextureFormat::R8G8B8A8Uint) {
+                float one = 1.0f;
+                memcpy(&value[3], &one, sizeof(one));
+            }
+            memcpy(value, frame + output.offset, std::min<size_t>(output.size, sizeof(value)));
+            WriteColor(attachment.format, pipeline.blends[location], bindings.blendColor, value,
+                       TexelPointer(attachment, x, y));
+        }
+    }
+
+    bool Rasterizer::DepthStencilTest(const RasterizerPipeline& pipeline,
+                                      bool frontFacing,
+                                      float depth,
+                                      uint8_t* texel,
+                                      uint32_t stencilReference) const {
+        bool hasStencil = TextureFormatHasStencil(mTargets.depthStencil.format);
+        const DepthStencilStateBase::StencilInfo& stencil = pipeline.stencil;
+        const DepthStencilStateBase::StencilFaceInfo& face =
+            frontFacing ? stencil.front : stencil.back;
+        uint8_t* stencilValue = texel + sizeof(float);
+
+        if (hasStencil &&
+            !Compare<uint32_t>(face.compareFunction, stencilReference & stencil.readMask,
+                               *stencilValue & stencil.readMask)) {
+            ApplyStencilOperation(face.stencilFail, stencilReference, stencil.writeMask,
+                                  stencilValue);
+            return false;
+        }
+
+        float storedDepth;
+        memcpy(&storedDepth, texel, sizeof(storedDepth));
+        if (!Compare(pipeline.depth.compareFunction, depth, storedDepth)) {
+            if (hasStencil) {
+                ApplyStencilOperation(face.depthFail, stencilReference, stencil.writeMask,
+                                      stencilValue);
+            }
+            return false;
+        }
+
+        if (hasStencil) {
+            ApplyStencilOperation(face.depthStencilPass, stencilReference, stencil.writeMask,
+                                  stencilValue);
+        }
+        if (pipeline.depth.depthWriteEnabled) {
+            memcpy(texel, &depth, sizeof(depth));
+        }
+        return true;
+    }
+
+}}  // namespace backend::null
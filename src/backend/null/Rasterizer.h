@@ -0,0 +1,202 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_NULL_RASTERIZER_H_
+#define BACKEND_NULL_RASTERIZER_H_
+
+#include "backend/BlendState.h"
+#include "backend/DepthStencilState.h"
+#include "backend/InputState.h"
+#include "backend/null/ShaderProgram.h"
+#include "common/Constants.h"
+
+#include "nxt/nxtcpp.h"
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+namespace backend { namespace null {
+
+    // The memory of a level of a texture used as a color or depth-stencil attachment. Texels are
+    // TextureFormatPixelSize(format) bytes, and D32FloatS8Uint texels hold the depth as a float
+    // followed by the stencil in the first byte of the next 4 bytes.
+    struct RenderAttachment {
+        uint8_t* data = nullptr;
+        uint32_t rowPitch = 0;
+        nxt::TextureFormat format = nxt::TextureFormat::R8G8B8A8Unorm;
+    };
+
+    struct RenderTargets {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        // The color attachments by output location, data is nullptr for unused locations.
+        std::array<RenderAttachment, kMaxColorAttachments> colors;
+        RenderAttachment depthStencil;
+    };
+
+    // The shaders and fixed-function state of a render pipeline, with the blend states by output
+    // location.
+    struct RasterizerPipeline {
+        const ShaderProgram* vertex = nullptr;
+        const ShaderProgram* fragment = nullptr;
+        nxt::PrimitiveTopology topology = nxt::PrimitiveTopology::TriangleList;
+        nxt::IndexFormat indexFormat = nxt::IndexFormat::Uint32;
+        std::bitset<kMaxVertexAttributes> attributesSet;
+        std::array<InputStateBase::AttributeInfo, kMaxVertexAttributes> attributes;
+        std::array<InputStateBase::InputInfo, kMaxVertexInputs> inputs;
+        std::array<BlendStateBase::BlendInfo, kMaxColorAttachments> blends;
+        DepthStencilStateBase::DepthInfo depth;
+        DepthStencilStateBase::StencilInfo stencil;
+    };
+
+    // The resources and dynamic state used by a draw.
+    struct DrawBindings {
+        struct BufferData {
+            const uint8_t* data = nullptr;
+            uint32_t size = 0;
+        };
+
+        // The vertex and fragment shaders have different push constants.
+        const ShaderBindings* vertex = nullptr;
+        const ShaderBindings* fragment = nullptr;
+        // Starting at the offsets given to SetVertexBuffers and SetIndexBuffer.
+        std::array<BufferData, kMaxVertexInputs> vertexBuffers;
+        BufferData indexBuffer;
+        std::array<float, 4> blendColor = {{0.0f, 0.0f, 0.0f, 0.0f}};
+        uint32_t stencilReference = 0;
+    };
+
+    struct DrawCall {
+        bool indexed = false;
+        // The number of indices for indexed draws, of vertices otherwise.
+        uint32_t count = 0;
+        uint32_t instanceCount = 1;
+        // The first index for indexed draws, the first vertex otherwise.
+        uint32_t first = 0;
+        uint32_t firstInstance = 0;
+    };
+
+    // What a draw did, for the pipeline statistics queries. Fragments that fail the early depth
+    // and stencil tests are not shaded and not counted.
+    struct DrawStatistics {
+        uint64_t primitives = 0;
+        uint64_t fragmentInvocations = 0;
+    };
+
+    // Renders draws on the CPU. For each instance the vertices are shaded in parallel, then the
+    // primitives are assembled, clipped and binned into screen tiles, and the tiles are
+    // rasterized and shaded in parallel. Each tile renders its primitives in order so blending,
+    // depth and stencil see the primitives in the order of the draw.
+    //
+    // Triangles are rasterized with exact fixed-point edge functions and a top-left fill rule so
+    // that pixels on edges shared by two triangles are only covered once. Lines use a DDA over
+    // the pixel centers of their major axis and points are always a single pixel.
+    class Rasterizer {
+      public:
+        explicit Rasterizer(ThreadPool* pool);
+        ~Rasterizer();
+
+        // The attachments of the following clears and draws.
+        void SetRenderTargets(const RenderTargets& targets);
+        void ClearColor(uint32_t location, const std::array<float, 4>& color);
+        void ClearDepthStencil(bool clearDepth, float depth, bool clearStencil, uint32_t stencil);
+
+        DrawStatistics Draw(const RasterizerPipeline& pipeline,
+                            const DrawBindings& bindings,
+                            const DrawCall& draw);
+
+      private:
+        // A vertex record after the viewport transform, with the position in pixels both as
+        // floats and in fixed point with kSubpixelBits.
+        struct ScreenVertex {
+            float x;
+            float y;
+            float z;
+            float invW;
+            int64_t fixedX;
+            int64_t fixedY;
+        };
+
+        struct Primitive {
+            // 1 for points, 2 for lines and 3 for triangles.
+            uint32_t vertexCount;
+            // Triangles are stored counter-clockwise in framebuffer coordinates.
+            std::array<uint32_t, 3> vertices;
+            // The vertex record flat inputs are taken from.
+            uint32_t provokingVertex;
+            bool frontFacing;
+            // Inclusive bounds of the pixels that can be covered, inside the render targets.
+            int32_t minX;
+            int32_t minY;
+            int32_t maxX;
+            int32_t maxY;
+        };
+
+        struct FragmentContext;
+
+        void ShadeVertices(const RasterizerPipeline& pipeline,
+                           const DrawBindings& bindings,
+                           const DrawCall& draw,
+                           uint32_t instance);
+        void AssemblePrimitives(const RasterizerPipeline& pipeline, uint32_t vertexCount);
+        void AddTriangle(uint32_t a, uint32_t b, uint32_t c);
+        void AddLine(uint32_t a, uint32_t b);
+        void AddPoint(uint32_t a);
+        // Appends a vertex interpolated between two vertex records and returns its index.
+        uint32_t AddIntersection(uint32_t a, uint32_t b, float t);
+        void ComputeScreenVertices();
+        void BinPrimitives();
+        void RasterizeTile(const RasterizerPipeline& pipeline,
+                           uint32_t tile,
+                           FragmentContext* context) const;
+        // The weights are the perspective-correct weights of the vertices of the primitive.
+        void ShadeFragment(const RasterizerPipeline& pipeline,
+                           const Primitive& primitive,
+                           const float weights[3],
+                           const float fragCoord[4],
+                           FragmentContext* context) const;
+        bool DepthStencilTest(const RasterizerPipeline& pipeline,
+                              bool frontFacing,
+                              float depth,
+                              uint8_t* texel,
+                              uint32_t stencilReference) const;
+
+        ThreadPool* mPool;
+        RenderTargets mTargets;
+        uint32_t mTilesX = 0;
+        uint32_t mTilesY = 0;
+
+        // Per draw scratch data, kept to reuse the allocations.
+        // The vertex records: the clip space position followed by the outputs by location.
+        std::vector<float> mVertices;
+        uint32_t mVertexStride = 0;
+        std::array<uint32_t, kMaxInterfaceLocations> mVaryingOffsets;
+        std::array<uint32_t, kMaxInterfaceLocations> mVaryingSizes;
+        std::vector<ScreenVertex> mScreenVertices;
+        std::vector<Primitive> mPrimitives;
+        // The indices of the primitives overlapping each tile, in order.
+        std::vector<std::vector<uint32_t>> mBins;
+        std::vector<uint32_t> mNonEmptyTiles;
+        // The shader frames of each thread of the pool.
+        std::vector<std::vector<uint8_t>> mVertexFrames;
+        std::vector<std::vector<uint8_t>> mFragmentFrames;
+    };
+
+}}  // namespace backend::null
+
+#endif  // BACKEND_NULL_RASTERIZER_H_
@@ -0,0 +1,3239 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "backend/null/ShaderProgram.h"
+
+#include "common/Assert.h"
+#include "common/Math.h"
+#include "common/ThreadPool.h"
+
+#include <spirv-cross/GLSL.std.450.h>
+#include <spirv-cross/spirv.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace backend { namespace null {
+
+    enum class IrOp : uint16_t {
+        // Control flow, targets are instruction indices.
+        Jump,         // a: target
+        JumpIf,       // a: condition, b: target if true, c: target if false
+        Switch,       // a: selector, b: index in mOperands of the default target followed by c
+                      // (value, target) pairs
+        Call,         // a: target, result: where the returned value is written
+        Return,       //
+        ReturnValue,  // a: returned value, c: size
+        Barrier,      //
+        Kill,         // ends the invocation and marks it killed
+
+        // Memory, pointers are Pointer registers.
+        Move,         // result <- a, c bytes
+        Load,         // result <- *a, c bytes
+        Store,        // *a <- b, c bytes
+        LoadRuns,     // result <- *a, with c (explicit offset, packed offset, size) runs at b in
+                      // mOperands converting the explicit layout to the packed layout
+        StoreRuns,    // *a <- b, with runs like LoadRuns
+        AccessChain,  // result <- a + offset, with at b in mOperands the constant offset followed
+                      // by c (index, stride, signed) of the dynamic indices
+        ArrayLength,  // result <- number of elements of stride c at offset b of *a
+        DynamicExtract,  // result <- a[b]
+        DynamicInsert,   // result[b] <- a
+
+        // Component-wise operations on lanes components.
+        FAdd,
+        FSub,
+        FMul,
+        FDiv,
+        FRem,
+        FMod,
+        FNegate,
+        IAdd,
+        ISub,
+        IMul,
+        UDiv,
+        SDiv,
+        UMod,
+        SRem,
+        SMod,
+        SNegate,
+        ShiftLeftLogical,
+        ShiftRightLogical,
+        ShiftRightArithmetic,
+        BitwiseAnd,
+        BitwiseOr,
+        BitwiseXor,
+        Not,
+        LogicalAnd,
+        LogicalOr,
+        LogicalNot,
+        LogicalEqual,
+        LogicalNotEqual,
+        IEqual,
+        INotEqual,
+        UGreaterThan,
+        UGreaterThanEqual,
+        ULessThan,
+        ULessThanEqual,
+        SGreaterThan,
+        SGreaterThanEqual,
+        SLessThan,
+        SLessThanEqual,
+        FOrdEqual,
+        FOrdNotEqual,
+        FOrdLessThan,
+        FOrdLessThanEqual,
+        FOrdGreaterThan,
+        FOrdGreaterThanEqual,
+        FUnordEqual,
+        FUnordNotEqual,
+        FUnordLessThan,
+        FUnordLessThanEqual,
+        FUnordGreaterThan,
+        FUnordGreaterThanEqual,
+        IsNan,
+        IsInf,
+        ConvertFToU,
+        ConvertFToS,
+        ConvertSToF,
+        ConvertUToF,
+        Select,  // result <- a ? b : c, flags: whether a has a condition per component
+
+        // Linear algebra, matrices are arrays of packed columns.
+        VectorTimesScalar,  // result <- a * b[0]
+        MatrixTimesVector,  // lanes: rows, flags: columns
+        VectorTimesMatrix,  // lanes: columns, flags: rows
+        MatrixTimesMatrix,  // lanes: rows of a, flags: columns of a, c: columns of b
+        Dot,
+        Any,
+        All,
+
+        // GLSL.std.450 extended instructions.
+        Round,
+        RoundEven,
+        Trunc,
+        FAbs,
+        SAbs,
+        FSign,
+        SSign,
+        Floor,
+        Ceil,
+        Fract,
+        Radians,
+        Degrees,
+        Sin,
+        Cos,
+        Tan,
+        Asin,
+        Acos,
+        Atan,
+        Sinh,
+        Cosh,
+        Tanh,
+        Atan2,
+        Pow,
+        Exp,
+        Log,
+        Exp2,
+        Log2,
+        Sqrt,
+        InverseSqrt,
+        FMin,
+        UMin,
+        SMin,
+        FMax,
+        UMax,
+        SMax,
+        FClamp,
+        UClamp,
+        SClamp,
+        FMix,
+        Step,
+        SmoothStep,
+        Fma,
+        Length,
+        Distance,
+        Cross,
+        Normalize,
+        Reflect,
+
+        // Atomics on the 32-bit integer pointed to by a.
+        AtomicLoad,
+        AtomicStore,
+        AtomicExchange,
+        AtomicCompareExchange,  // b: value, c: comparator
+        AtomicIAdd,
+        AtomicISub,
+        AtomicSMin,
+        AtomicUMin,
+        AtomicSMax,
+        AtomicUMax,
+        AtomicAnd,
+        AtomicOr,
+        AtomicXor,
+    };
+
+    struct ShaderProgram::InvocationState {
+        uint8_t* frame;
+        uint32_t pc;
+        uint32_t callDepth;
+        bool done;
+        bool killed;
+    };
+
+    namespace {
+
+        // Pointers know the range they can access so that loads and stores are bounds-checked.
+        struct Pointer {
+            uintptr_t address;
+            uintptr_t begin;
+            uintptr_t end;
+        };
+        constexpr uint32_t kPointerSize = sizeof(Pointer);
+        constexpr uint32_t kPointerAlignment = alignof(Pointer);
+
+        // Not in the version of spirv.hpp used, from SPV_KHR_storage_buffer_storage_class.
+        constexpr uint32_t kStorageClassStorageBuffer = 12;
+
+        constexpr uint32_t kNone = 0xFFFFFFFF;
+        // Caps the size of arrays used to track ids and members to fail on corrupt modules.
+        constexpr uint32_t kMaxIdBound = 1 << 22;
+        constexpr uint32_t kMaxMembers = 1 << 14;
+        constexpr uint32_t kMaxInvocationsPerWorkgroup = 1024;
+
+        Pointer MakePointer(uint8_t* data, size_t size) {
+            uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+            return {begin, begin, begin + size};
+        }
+
+        bool InBounds(const Pointer& pointer, uint32_t size) {
+            return pointer.address >= pointer.begin && pointer.address <= pointer.end &&
+                   pointer.end - pointer.address >= size;
+        }
+
+        template <typename T>
+        T* Reg(uint8_t* frame, uint32_t offset) {
+            return reinterpret_cast<T*>(frame + offset);
+        }
+
+        template <typename R, typename A, typename Instruction, typename F>
+        void UnaryOp(uint8_t* frame, const Instruction& inst, F f) {
+            R* result = Reg<R>(frame, inst.result);
+            const A* a = Reg<A>(frame, inst.a);
+            for (uint32_t i = 0; i < inst.lanes; ++i) {
+                result[i] = f(a[i]);
+            }
+        }
+
+        template <typename R, typename A, typename Instruction, typename F>
+        void BinaryOp(uint8_t* frame, const Instruction& inst, F f) {
+            R* result = Reg<R>(frame, inst.result);
+            const A* a = Reg<A>(frame, inst.a);
+            const A* b = Reg<A>(frame, inst.b);
+            for (uint32_t i = 0; i < inst.lanes; ++i) {
+                result[i] = f(a[i], b[i]);
+            }
+        }
+
+        template <typename R, typename A, typename Instruction, typename F>
+        void TernaryOp(uint8_t* frame, const Instruction& inst, F f) {
+            R* result = Reg<R>(frame, inst.result);
+            const A* a = Reg<A>(frame, inst.a);
+            const A* b = Reg<A>(frame, inst.b);
+            const A* c = Reg<A>(frame, inst.c);
+            for (uint32_t i = 0; i < inst.lanes; ++i) {
+                result[i] = f(a[i], b[i], c[i]);
+            }
+        }
+
+        uint32_t Bool(bool value) {
+            return value ? 1u : 0u;
+        }
+
+        // Conversions of out-of-range floats are undefined in C++ so they are clamped.
+        int32_t FloatToInt(float value) {
+            if (std::isnan(value)) {
+                return 0;
+            }
+            if (value <= -2147483648.0f) {
+                return std::numeric_limits<int32_t>::min();
+            }
+            if (value >= 2147483648.0f) {
+                return std::numeric_limits<int32_t>::max();
+            }
+            return static_cast<int32_t>(value);
+        }
+
+        uint32_t FloatToUint(float value) {
+            if (!(value > 0.0f)) {
+                return 0;
+            }
+            if (value >= 4294967296.0f) {
+                return std::numeric_limits<uint32_t>::max();
+            }
+            return static_cast<uint32_t>(value);
+        }
+
+        // Division by zero and INT_MIN / -1 trap on some CPUs, their result is undefined in
+        // SPIR-V so any value will do.
+        int32_t SignedDivide(int32_t a, int32_t b) {
+            if (b == 0) {
+                return 0;
+            }
+            if (b == -1) {
+                return static_cast<int32_t>(0u - static_cast<uint32_t>(a));
+            }
+            return a / b;
+        }
+
+        int32_t SignedRemainder(int32_t a, int32_t b) {
+            if (b == 0 || b == -1) {
+                return 0;
+            }
+            return a % b;
+        }
+
+        // The sign of the result of SMod is the sign of b.
+        int32_t SignedModulo(int32_t a, int32_t b) {
+            int32_t remainder = SignedRemainder(a, b);
+            if (remainder != 0 && (remainder < 0) != (b < 0)) {
+                remainder += b;
+            }
+            return remainder;
+        }
+
+        float Length(const float* v, uint32_t count) {
+            float sum = 0.0f;
+            for (uint32_t i = 0; i < count; ++i) {
+                sum += v[i] * v[i];
+            }
+            return std::sqrt(sum);
+        }
+
+        float Dot(const float* a, const float* b, uint32_t count) {
+            float sum = 0.0f;
+            for (uint32_t i = 0; i < count; ++i) {
+                sum += a[i] * b[i];
+            }
+            return sum;
+        }
+
+        // Atomics are implemented with compare-exchange loops so that all operations can share
+        // the same code. Returns the original value.
+        template <typename F>
+        uint32_t AtomicRmw(uintptr_t address, F f) {
+            std::atomic<uint32_t>* atomic = reinterpret_cast<std::atomic<uint32_t>*>(address);
+            uint32_t original = atomic->load();
+            while (!atomic->compare_exchange_weak(original, f(original))) {
+            }
+            return original;
+        }
+
+        // Instructions that don't have a result type and result id, among those allowed in
+        // function bodies.
+        bool HasTypeAndResult(uint32_t opcode) {
+            switch (opcode) {
+                case spv::OpNop:
+                case spv::OpLine:
+                case spv::OpNoLine:
+                case spv::OpStore:
+                case spv::OpCopyMemory:
+                case spv::OpCopyMemorySized:
+                case spv::OpLabel:
+                case spv::OpBranch:
+                case spv::OpBranchConditional:
+                case spv::OpSwitch:
+                case spv::OpReturn:
+                case spv::OpReturnValue:
+                case spv::OpKill:
+                case spv::OpUnreachable:
+                case spv::OpSelectionMerge:
+                case spv::OpLoopMerge:
+                case spv::OpControlBarrier:
+                case spv::OpMemoryBarrier:
+                case spv::OpAtomicStore:
+                case spv::OpFunctionEnd:
+                    return false;
+                default:
+                    return true;
+            }
+        }
+
+        struct GlslOp {
+            uint32_t glslOp;
+            IrOp op;
+            uint32_t operandCount;
+        };
+
+        const GlslOp kGlslOps[] = {
+            {GLSLstd450Round, IrOp::Round, 1},
+            {GLSLstd450RoundEven, IrOp::RoundEven, 1},
+            {GLSLstd450Trunc, IrOp::Trunc, 1},
+            {GLSLstd450FAbs, IrOp::FAbs, 1},
+            {GLSLstd450SAbs, IrOp::SAbs, 1},
+            {GLSLstd450FSign, IrOp::FSign, 1},
+            {GLSLstd450SSign, IrOp::SSign, 1},
+            {GLSLstd450Floor, IrOp::Floor, 1},
+            {GLSLstd450Ceil, IrOp::Ceil, 1},
+            {GLSLstd450Fract, IrOp::Fract, 1},
+            {GLSLstd450Radians, IrOp::Radians, 1},
+            {GLSLstd450Degrees, IrOp::Degrees, 1},
+            {GLSLstd450Sin, IrOp::Sin, 1},
+            {GLSLstd450Cos, IrOp::Cos, 1},
+            {GLSLstd450Tan, IrOp::Tan, 1},
+            {GLSLstd450Asin, IrOp::Asin, 1},
+            {GLSLstd450Acos, IrOp::Acos, 1},
+            {GLSLstd450Atan, IrOp::Atan, 1},
+            {GLSLstd450Sinh, IrOp::Sinh, 1},
+            {GLSLstd450Cosh, IrOp::Cosh, 1},
+            {GLSLstd450Tanh, IrOp::Tanh, 1},
+            {GLSLstd450Atan2, IrOp::Atan2, 2},
+            {GLSLstd450Pow, IrOp::Pow, 2},
+            {GLSLstd450Exp, IrOp::Exp, 1},
+            {GLSLstd450Log, IrOp::Log, 1},
+            {GLSLstd450Exp2, IrOp::Exp2, 1},
+            {GLSLstd450Log2, IrOp::Log2, 1},
+            {GLSLstd450Sqrt, IrOp::Sqrt, 1},
+            {GLSLstd450InverseSqrt, IrOp::InverseSqrt, 1},
+            {GLSLstd450FMin, IrOp::FMin, 2},
+            {GLSLstd450UMin, IrOp::UMin, 2},
+            {GLSLstd450SMin, IrOp::SMin, 2},
+            {GLSLstd450FMax, IrOp::FMax, 2},
+            {GLSLstd450UMax, IrOp::UMax, 2},
+            {GLSLstd450SMax, IrOp::SMax, 2},
+            {GLSLstd450FClamp, IrOp::FClamp, 3},
+            {GLSLstd450UClamp, IrOp::UClamp, 3},
+            {GLSLstd450SClamp, IrOp::SClamp, 3},
+            {GLSLstd450FMix, IrOp::FMix, 3},
+            {GLSLstd450Step, IrOp::Step, 2},
+            {GLSLstd450SmoothStep, IrOp::SmoothStep, 3},
+            {GLSLstd450Fma, IrOp::Fma, 3},
+            {GLSLstd450Length, IrOp::Length, 1},
+            {GLSLstd450Distance, IrOp::Distance, 2},
+            {GLSLstd450Cross, IrOp::Cross, 2},
+            {GLSLstd450Normalize, IrOp::Normalize, 1},
+            {GLSLstd450Reflect, IrOp::Reflect, 2},
+        };
+
+    }  // anonymous namespace
+
+    // Translates the SPIR-V to the IR in a single pass over the functions. Each SPIR-V id gets a
+    // register in the frame, phis are turned into moves on the edges leading to their block and
+    // branch targets are patched once all the labels are known.
+    class SpirvTranslator {
+      public:
+        SpirvTranslator(const std::vector<uint32_t>& spirv,
+                        uint32_t executionModel,
+                        ShaderProgram* program)
+            : mSpirv(spirv), mExecutionModel(executionModel), mProgram(program) {
+        }
+
+        bool Translate(const std::string& entryPoint);
+
+        const std::string& GetError() const {
+            return mError;
+        }
+
+      private:
+        struct SpirvInstruction {
+            uint32_t opcode;
+            const uint32_t* words;
+            uint32_t wordCount;
+        };
+
+        struct Type {
+            uint32_t opcode = 0;
+            // The component, column, element or pointee type.
+            uint32_t element = 0;
+            // The number of components, columns or elements.
+            uint32_t count = 0;
+            uint32_t storageClass = 0;
+            uint32_t width = 0;
+            bool isSigned = false;
+            std::vector<uint32_t> members;
+        };
+
+        struct Decorations {
+            bool hasSet = false;
+            uint32_t set = 0;
+            bool hasBinding = false;
+            uint32_t binding = 0;
+            uint32_t builtIn = kNone;
+            uint32_t arrayStride = 0;
+            bool hasLocation = false;
+            uint32_t location = 0;
+            bool flat = false;
+        };
+
+        struct MemberDecorations {
+            uint32_t offset = kNone;
+            uint32_t matrixStride = 0;
+            uint32_t builtIn = kNone;
+        };
+
+        struct Function {
+            uint32_t id;
+            size_t begin;
+            size_t end;
+            std::vector<uint32_t> parameters;
+        };
+
+        // A reference to a label or function in an instruction or in mOperands.
+        struct Fixup {
+            bool inOperands;
+            uint32_t index;
+            uint32_t field;
+        };
+
+        // A block containing the phi moves of a conditional edge.
+        struct EdgeStub {
+            uint32_t from;
+            uint32_t to;
+            uint32_t label;
+        };
+
+        void Fail(const std::string& message);
+        uint32_t Word(const SpirvInstruction& inst, uint32_t index);
+
+        bool Parse(const std::string& entryPoint);
+        void ParseModuleInstruction(const SpirvInstruction& inst, const std::string& entryPoint);
+        void ParseType(const SpirvInstruction& inst);
+        void ParseConstant(const SpirvInstruction& inst);
+        void AddVariable(uint32_t id, uint32_t typeId, uint32_t storageClass, uint32_t initializer);
+        void AddInterfaceVariable(uint32_t id,
+                                  uint32_t typeId,
+                                  bool isInput,
+                                  uint32_t offset,
+                                  uint32_t size);
+        void AddBuiltIn(uint32_t builtIn, bool isInput, uint32_t offset, uint32_t size);
+
+        const Type& GetType(uint32_t typeId);
+        const Type& GetValueType(uint32_t id);
+        const Type& GetPointeeType(uint32_t pointerId);
+        bool IsExplicitLayout(uint32_t storageClass) const;
+        uint32_t PackedSize(uint32_t typeId);
+        uint32_t PackedMemberOffset(uint32_t structId, uint32_t member);
+        uint32_t ComponentCount(uint32_t typeId);
+        uint32_t ExplicitSize(uint32_t typeId, uint32_t matrixStride);
+        uint32_t ArrayStride(uint32_t arrayId);
+        const MemberDecorations& GetMemberDecorations(uint32_t structId, uint32_t member);
+        void BuildRuns(uint32_t typeId,
+                       uint32_t explicitOffset,
+                       uint32_t packedOffset,
+                       uint32_t matrixStride,
+                       std::vector<uint32_t>* runs);
+
+        uint32_t Slot(uint32_t id);
+        uint32_t AllocateRegister(uint32_t size, uint32_t alignment);
+        uint32_t ImmediateSlot(uint32_t value);
+        void SetConstant(uint32_t id, const void* data, uint32_t size);
+        bool IsConstant(uint32_t id) const;
+        uint32_t ConstantValue(uint32_t id);
+
+        uint32_t Emit(IrOp op,
+                      uint32_t result,
+                      uint32_t a = 0,
+                      uint32_t b = 0,
+                      uint32_t c = 0,
+                      uint32_t lanes = 0,
+                      uint32_t flags = 0);
+        void EmitMove(uint32_t destination, uint32_t source, uint32_t size);
+        void EmitLoad(uint32_t result, uint32_t pointer, uint32_t typeId);
+        void EmitStore(uint32_t pointer, uint32_t value, uint32_t typeId);
+        void EmitComponentWise(const SpirvInstruction& inst, IrOp op, uint32_t operandCount);
+        void ReferenceLabel(uint32_t instruction, uint32_t field, uint32_t label);
+        void ReferenceLabelInOperands(uint32_t index, uint32_t label);
+        uint32_t EdgeTarget(uint32_t from, uint32_t to);
+        void EmitPhiMoves(uint32_t from, uint32_t to);
+        void EmitJump(uint32_t from, uint32_t to);
+
+        void TranslateFunction(const Function& function);
+        void TranslateInstruction(const SpirvInstruction& inst);
+        void TranslateAccessChain(const SpirvInstruction& inst);
+        void TranslateCompositeExtract(const SpirvInstruction& inst);
+        void TranslateExtInst(const SpirvInstruction& inst);
+        void TranslateAtomic(const SpirvInstruction& inst);
+        uint32_t CompositeOffset(uint32_t typeId,
+                                 const SpirvInstruction& inst,
+                                 uint32_t firstIndex,
+                                 uint32_t* elementType);
+        void Finalize();
+
+        const std::vector<uint32_t>& mSpirv;
+        uint32_t mExecutionModel;
+        ShaderProgram* mProgram;
+        std::string mError;
+
+        uint32_t mBound = 0;
+        std::vector<SpirvInstruction> mInstructions;
+        std::vector<Type> mTypes;
+        std::vector<uint32_t> mValueTypes;
+        std::vector<uint32_t> mSlots;
+        std::vector<bool> mIsConstant;
+        std::vector<Decorations> mDecorations;
+        std::unordered_map<uint32_t, std::vector<MemberDecorations>> mMemberDecorations;
+        // The matrix stride of the matrices pointed to by pointers in explicit layouts.
+        std::vector<uint32_t> mMatrixStrides;
+
+        uint32_t mEntryFunction = 0;
+        uint32_t mGlslImport = 0;
+        std::vector<Function> mFunctions;
+        std::unordered_map<uint32_t, size_t> mFunctionIndices;
+        // The initializers of the global variables, stored in the prologue.
+        std::vector<std::pair<uint32_t, uint32_t>> mInitializers;
+
+        uint32_t mRegistersSize = 0;
+        uint32_t mFrameStorageSize = 0;
+        uint32_t mWorkgroupMemorySize = 0;
+
+        std::unordered_map<uint32_t, uint32_t> mLabelPcs;
+        std::vector<Fixup> mFixups;
+        uint32_t mNextStubLabel = 0;
+        uint32_t mCurrentLabel = 0;
+        std::unordered_map<uint32_t, std::vector<size_t>> mPhis;
+        std::unordered_map<uint32_t, uint32_t> mShadowSlots;
+        std::vector<EdgeStub> mEdgeStubs;
+    };
+
+    void SpirvTranslator::Fail(const std::string& message) {
+        if (mError.empty()) {
+            mError = message;
+        }
+    }
+
+    uint32_t SpirvTranslator::Word(const SpirvInstruction& inst, uint32_t index) {
+        if (index >= inst.wordCount) {
+            Fail("Truncated instruction with opcode " + std::to_string(inst.opcode));
+            return 0;
+        }
+        return inst.words[index];
+    }
+
+    bool SpirvTranslator::Translate(const std::string& entryPoint) {
+        if (!Parse(entryPoint)) {
+            return false;
+        }
+
+        // The prologue initializes the global variables and calls the entry point.
+        mProgram->mEntryPoint = static_cast<uint32_t>(mProgram->mInstructions.size());
+        for (const auto& initializer : mInitializers) {
+            EmitStore(Slot(initializer.first), Slot(initializer.second), initializer.first);
+        }
+        ReferenceLabel(Emit(IrOp::Call, 0), 0, mEntryFunction);
+        Emit(IrOp::Return, 0);
+
+        for (const Function& function : mFunctions) {
+            TranslateFunction(function);
+            if (!mError.empty()) {
+                return false;
+            }
+        }
+
+        Finalize();
+        return mError.empty();
+    }
+
+    bool SpirvTranslator::Parse(const std::string& entryPoint) {
+        if (mSpirv.size() < 5 || mSpirv[0] != spv::MagicNumber) {
+            Fail("Invalid SPIR-V header");
+            return false;
+        }
+        mBound = mSpirv[3];
+        if (mBound > kMaxIdBound) {
+            Fail("SPIR-V id bound too large");
+            return false;
+        }
+        mNextStubLabel = mBound;
+
+        mTypes.resize(mBound);
+        mValueTypes.resize(mBound, 0);
+        mSlots.resize(mBound, kNone);
+        mIsConstant.resize(mBound, false);
+        mDecorations.resize(mBound);
+        mMatrixStrides.resize(mBound, 0);
+
+        Function* function = nullptr;
+        for (size_t offset = 5; offset < mSpirv.size();) {
+            SpirvInstruction inst;
+            inst.opcode = mSpirv[offset] & spv::OpCodeMask;
+            inst.wordCount = mSpirv[offset] >> spv::WordCountShift;
+            inst.words = &mSpirv[offset];
+            if (inst.wordCount == 0 || offset + inst.wordCount > mSpirv.size()) {
+                Fail("Invalid SPIR-V instruction size");
+                return false;
+            }
+            size_t index = mInstructions.size();
+            mInstructions.push_back(inst);
+            offset += inst.wordCount;
+
+            // Record the functions and the types of the values defined in them so that registers
+            // can be allocated for values used before their definition, like in phis.
+            if (inst.opcode == spv::OpFunction) {
+                if (function != nullptr) {
+                    Fail("Nested functions");
+                    return false;
+                }
+                mFunctions.push_back({Word(inst, 2), index + 1, 0, {}});
+                function = &mFunctions.back();
+            } else if (inst.opcode == spv::OpFunctionEnd) {
+                if (function == nullptr) {
+                    Fail("OpFunctionEnd outside of a function");
+                    return false;
+                }
+                function->end = index;
+                function = nullptr;
+            } else if (function != nullptr) {
+                if (HasTypeAndResult(inst.opcode)) {
+                    uint32_t id = Word(inst, 2);
+                    if (id >= mBound) {
+                        Fail("Invalid id");
+                        return false;
+                    }
+                    mValueTypes[id] = Word(inst, 1);
+                }
+                if (inst.opcode == spv::OpFunctionParameter) {
+                    function->parameters.push_back(Word(inst, 2));
+                }
+            } else {
+                ParseModuleInstruction(inst, entryPoint);
+            }
+
+            if (!mError.empty()) {
+                return false;
+            }
+        }
+
+        if (function != nullptr) {
+            Fail("Missing OpFunctionEnd");
+            return false;
+        }
+        if (mEntryFunction == 0) {
+            Fail("Entry point \"" + entryPoint + "\" not found for the shader stage");
+            return false;
+        }
+        for (size_t i = 0; i < mFunctions.size(); ++i) {
+            mFunctionIndices[mFunctions[i].id] = i;
+        }
+        if (mFunctionIndices.count(mEntryFunction) == 0) {
+            Fail("Entry point function not found");
+            return false;
+        }
+
+        const std::array<uint32_t, 3>& localSize = mProgram->mLocalSize;
+        uint64_t invocationCount =
+            static_cast<uint64_t>(localSize[0]) * localSize[1] * localSize[2];
+        if (invocationCount == 0 || invocationCount > kMaxInvocationsPerWorkgroup) {
+            Fail("Invalid workgroup size");
+            return false;
+        }
+
+        return mError.empty();
+    }
+
+    void SpirvTranslator::ParseModuleInstruction(const SpirvInstruction& inst,
+                                                 const std::string& entryPoint) {
+        switch (inst.opcode) {
+            case spv::OpEntryPoint: {
+                if (Word(inst, 1) != mExecutionModel || inst.wordCount < 4) {
+                    break;
+                }
+                const char* name = reinterpret_cast<const char*>(&inst.words[3]);
+                size_t maxLength = (inst.wordCount - 3) * sizeof(uint32_t);
+                if (std::string(name, strnlen(name, maxLength)) == entryPoint) {
+                    mEntryFunction = Word(inst, 2);
+                }
+            } break;
+
+            case spv::OpExecutionMode: {
+                if (Word(inst, 1) == mEntryFunction &&
+                    Word(inst, 2) == spv::ExecutionModeLocalSize) {
+                    mProgram->mLocalSize = {{Word(inst, 3), Word(inst, 4), Word(inst, 5)}};
+                }
+            } break;
+
+            case spv::OpExtInstImport: {
+                const char* name = reinterpret_cast<const char*>(&inst.words[2]);
+                size_t maxLength = (inst.wordCount - 2) * sizeof(uint32_t);
+                if (std::string(name, strnlen(name, maxLength)) == "GLSL.std.450") {
+                    mGlslImport = Word(inst, 1);
+                }
+            } break;
+
+            case spv::OpDecorate: {
+                uint32_t target = Word(inst, 1);
+                if (target >= mBound) {
+                    Fail("Invalid decoration target");
+                    break;
+                }
+                Decorations& decorations = mDecorations[target];
+                switch (Word(inst, 2)) {
+                    case spv::DecorationDescriptorSet:
+                        decorations.hasSet = true;
+                        decorations.set = Word(inst, 3);
+                        break;
+                    case spv::DecorationBinding:
+                        decorations.hasBinding = true;
+                        decorations.binding = Word(inst, 3);
+                        break;
+                    case spv::DecorationBuiltIn:
+                        decorations.builtIn = Word(inst, 3);
+                        break;
+                    case spv::DecorationArrayStride:
+                        decorations.arrayStride = Word(inst, 3);
+                        break;
+                    case spv::DecorationLocation:
+                        decorations.hasLocation = true;
+                        decorations.location = Word(inst, 3);
+                        break;
+                    case spv::DecorationFlat:
+                        decorations.flat = true;
+                        break;
+                    default:
+                        break;
+                }
+            } break;
+
+            case spv::OpMemberDecorate: {
+                uint32_t member = Word(inst, 2);
+                if (member >= kMaxMembers) {
+                    Fail("Invalid member decoration");
+                    break;
+                }
+                std::vector<MemberDecorations>& members = mMemberDecorations[Word(inst, 1)];
+                if (members.size() <= member) {
+                    members.resize(member + 1);
+                }
+                switch (Word(inst, 3)) {
+                    case spv::DecorationOffset:
+                        members[member].offset = Word(inst, 4);
+                        break;
+                    case spv::DecorationMatrixStride:
+                        members[member].matrixStride = Word(inst, 4);
+                        break;
+                    case spv::DecorationBuiltIn:
+                        members[member].builtIn = Word(inst, 4);
+                        break;
+                    case spv::DecorationRowMajor:
+                        Fail("Row major matrices are not supported");
+                        break;
+                    default:
+                        break;
+                }
+            } break;
+
+            case spv::OpDecorationGroup:
+            case spv::OpGroupDecorate:
+            case spv::OpGroupMemberDecorate:
+                Fail("Decoration groups are not supported");
+                break;
+
+            case spv::OpTypeVoid:
+            case spv::OpTypeBool:
+            case spv::OpTypeInt:
+            case spv::OpTypeFloat:
+            case spv::OpTypeVector:
+            case spv::OpTypeMatrix:
+            case spv::OpTypeImage:
+            case spv::OpTypeSampler:
+            case spv::OpTypeSampledImage:
+            case spv::OpTypeArray:
+            case spv::OpTypeRuntimeArray:
+            case spv::OpTypeStruct:
+            case spv::OpTypeOpaque:
+            case spv::OpTypePointer:
+            case spv::OpTypeFunction:
+                ParseType(inst);
+                break;
+
+            case spv::OpConstantTrue:
+            case spv::OpConstantFalse:
+            case spv::OpConstant:
+            case spv::OpConstantComposite:
+            case spv::OpConstantNull:
+            case spv::OpSpecConstantTrue:
+            case spv::OpSpecConstantFalse:
+            case spv::OpSpecConstant:
+            case spv::OpSpecConstantComposite:
+            case spv::OpUndef:
+                ParseConstant(inst);
+                break;
+
+            case spv::OpConstantSampler:
+            case spv::OpSpecConstantOp:
+                Fail("Unsupported constant with opcode " + std::to_string(inst.opcode));
+                break;
+
+            case spv::OpVariable: {
+                uint32_t id = Word(inst, 2);
+                if (id >= mBound) {
+                    Fail("Invalid id");
+                    break;
+                }
+                mValueTypes[id] = Word(inst, 1);
+                uint32_t initializer = inst.wordCount > 4 ? inst.words[4] : 0;
+                AddVariable(id, Word(inst, 1), Word(inst, 3), initializer);
+                if (initializer != 0) {
+                    mInitializers.push_back({id, initializer});
+                }
+            } break;
+
+            default:
+                break;
+        }
+    }
+
+    void SpirvTranslator::ParseType(const SpirvInstruction& inst) {
+        uint32_t id = Word(inst, 1);
+        if (id >= mBound) {
+            Fail("Invalid type id");
+            return;
+        }
+        Type& type = mTypes[id];
+        type.opcode = inst.opcode;
+
+        switch (inst.opcode) {
+            case spv::OpTypeInt:
+                type.width = Word(inst, 2);
+                type.isSigned = Word(inst, 3) != 0;
+                break;
+            case spv::OpTypeFloat:
+                type.width = Word(inst, 2);
+                break;
+            case spv::OpTypeVector:
+            case spv::OpTypeMatrix:
+                type.element = Word(inst, 2);
+                type.count = Word(inst, 3);
+                break;
+            case spv::OpTypeArray:
+                type.element = Word(inst, 2);
+                type.count = ConstantValue(Word(inst, 3));
+                break;
+            case spv::OpTypeRuntimeArray:
+                type.element = Word(inst, 2);
+                break;
+            case spv::OpTypeStruct:
+                type.members.assign(inst.words + 2, inst.words + inst.wordCount);
+                break;
+            case spv::OpTypePointer:
+                type.storageClass = Word(inst, 2);
+                type.element = Word(inst, 3);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void SpirvTranslator::ParseConstant(const SpirvInstruction& inst) {
+        uint32_t id = Word(inst, 2);
+        if (id >= mBound) {
+            Fail("Invalid id");
+            return;
+        }
+        uint32_t typeId = Word(inst, 1);
+        mValueTypes[id] = typeId;
+        mIsConstant[id] = true;
+
+        switch (inst.opcode) {
+            case spv::OpConstantTrue:
+            case spv::OpSpecConstantTrue: {
+                uint32_t value = 1;
+                SetConstant(id, &value, sizeof(value));
+            } break;
+
+            case spv::OpConstant:
+            case spv::OpSpecConstant: {
+                if (PackedSize(typeId) != sizeof(uint32_t) || inst.wordCount != 4) {
+                    Fail("Only 32-bit constants are supported");
+                    return;
+                }
+                SetConstant(id, &inst.words[3], sizeof(uint32_t));
+            } break;
+
+            case spv::OpConstantComposite:
+            case spv::OpSpecConstantComposite: {
+                std::vector<uint8_t> data;
+                for (uint32_t i = 3; i < inst.wordCount; ++i) {
+                    uint32_t constituent = inst.words[i];
+                    if (!IsConstant(constituent)) {
+                        Fail("Invalid constant composite");
+                        return;
+                    }
+                    uint32_t size = PackedSize(mValueTypes[constituent]);
+                    const uint8_t* constituentData = &mProgram->mConstants[Slot(constituent)];
+                    data.insert(data.end(), constituentData, constituentData + size);
+                }
+                if (data.size() != PackedSize(typeId)) {
+                    Fail("Invalid constant composite");
+                    return;
+                }
+                SetConstant(id, data.data(), static_cast<uint32_t>(data.size()));
+            } break;
+
+            default:
+                // False, null and undefined values are zeros.
+                Slot(id);
+                break;
+        }
+    }
+
+    void SpirvTranslator::AddVariable(uint32_t id,
+                                      uint32_t typeId,
+                                      uint32_t storageClass,
+                                      uint32_t initializer) {
+        const Type& type = GetType(typeId);
+        if (type.opcode != spv::OpTypePointer) {
+            Fail("Variables must be pointers");
+            return;
+        }
+        if (initializer != 0 && mValueTypes[initializer] != type.element) {
+            Fail("Invalid variable initializer");
+            return;
+        }
+
+        ShaderProgram::Variable variable = {};
+        variable.pointer = Slot(id);
+        variable.builtIn = ShaderProgram::kNotBuiltIn;
+
+        const Decorations& decorations = mDecorations[id];
+        switch (storageClass) {
+            case spv::StorageClassUniform:
+            case kStorageClassStorageBuffer:
+                if (!decorations.hasSet || !decorations.hasBinding ||
+                    decorations.set >= kMaxBindGroups ||
+                    decorations.binding >= kMaxBindingsPerGroup) {
+                    Fail("Invalid buffer descriptor set or binding");
+                    return;
+                }
+                variable.kind = ShaderProgram::VariableKind::Buffer;
+                variable.group = decorations.set;
+                variable.binding = decorations.binding;
+                break;
+
+            case spv::StorageClassPushConstant:
+                variable.kind = ShaderProgram::VariableKind::PushConstant;
+                break;
+
+            case spv::StorageClassWorkgroup:
+                if (mExecutionModel != spv::ExecutionModelGLCompute) {
+                    Fail("Workgroup variables are only allowed in compute shaders");
+                    return;
+                }
+                variable.kind = ShaderProgram::VariableKind::Workgroup;
+                variable.size = PackedSize(type.element);
+                variable.offset = mWorkgroupMemorySize;
+                mWorkgroupMemorySize = Align(mWorkgroupMemorySize + variable.size, 4);
+                break;
+
+            case spv::StorageClassInput:
+            case spv::StorageClassOutput:
+            case spv::StorageClassPrivate:
+            case spv::StorageClassFunction: {
+                variable.kind = ShaderProgram::VariableKind::Frame;
+                variable.size = PackedSize(type.element);
+                variable.offset = mFrameStorageSize;
+                mFrameStorageSize = Align(mFrameStorageSize + variable.size, 4);
+
+                if (mExecutionModel != spv::ExecutionModelGLCompute &&
+                    (storageClass == spv::StorageClassInput ||
+                     storageClass == spv::StorageClassOutput)) {
+                    AddInterfaceVariable(id, type.element,
+                                         storageClass == spv::StorageClassInput, variable.offset,
+                                         variable.size);
+                    break;
+                }
+                if (storageClass != spv::StorageClassInput) {
+                    break;
+                }
+                uint32_t builtInSize = 0;
+                switch (decorations.builtIn) {
+                    case spv::BuiltInNumWorkgroups:
+                    case spv::BuiltInWorkgroupId:
+                    case spv::BuiltInLocalInvocationId:
+                    case spv::BuiltInGlobalInvocationId:
+                        builtInSize = 3 * sizeof(uint32_t);
+                        break;
+                    case spv::BuiltInLocalInvocationIndex:
+                        builtInSize = sizeof(uint32_t);
+                        break;
+                    default:
+                        Fail("Unsupported input variable");
+                        return;
+                }
+                if (variable.size != builtInSize) {
+                    Fail("Invalid built-in variable type");
+                    return;
+                }
+                variable.builtIn = decorations.builtIn;
+            } break;
+
+            case spv::StorageClassUniformConstant:
+                Fail("Images and samplers are not supported");
+                return;
+
+            default:
+                Fail("Unsupported storage class " + std::to_string(storageClass));
+                return;
+        }
+
+        mProgram->mVariables.push_back(variable);
+    }
+
+    void SpirvTranslator::AddInterfaceVariable(uint32_t id,
+                                               uint32_t typeId,
+                                               bool isInput,
+                                               uint32_t offset,
+                                               uint32_t size) {
+        const Decorations& decorations = mDecorations[id];
+        if (decorations.hasLocation) {
+            if (decorations.location >= kMaxInterfaceLocations) {
+                Fail("Invalid interface variable location");
+                return;
+            }
+            ShaderInterface& interface = mProgram->mInterface;
+            InterfaceVariable& variable = isInput ? interface.inputs[decorations.location]
+                                                  : interface.outputs[decorations.location];
+            variable.offset = offset;
+            variable.size = size;
+            variable.flat = decorations.flat;
+            return;
+        }
+
+        // Blocks of built-ins like gl_PerVertex have their members decorated instead.
+        const Type& type = GetType(typeId);
+        if (decorations.builtIn == kNone && type.opcode == spv::OpTypeStruct) {
+            for (uint32_t i = 0; i < type.members.size(); ++i) {
+                AddBuiltIn(GetMemberDecorations(typeId, i).builtIn, isInput,
+                           offset + PackedMemberOffset(typeId, i), PackedSize(type.members[i]));
+            }
+            return;
+        }
+        AddBuiltIn(decorations.builtIn, isInput, offset, size);
+    }
+
+    void SpirvTranslator::AddBuiltIn(uint32_t builtIn,
+                                     bool isInput,
+                                     uint32_t offset,
+                                     uint32_t size) {
+        struct BuiltInInfo {
+            uint32_t builtIn;
+            uint32_t executionModel;
+            bool isInput;
+            uint32_t size;
+            InterfaceVariable ShaderInterface::*variable;
+        };
+        static constexpr BuiltInInfo kBuiltIns[] = {
+            {spv::BuiltInVertexIndex, spv::ExecutionModelVertex, true, 4,
+             &ShaderInterface::vertexIndex},
+            {spv::BuiltInVertexId, spv::ExecutionModelVertex, true, 4,
+             &ShaderInterface::vertexIndex},
+            {spv::BuiltInInstanceIndex, spv::ExecutionModelVertex, true, 4,
+             &ShaderInterface::instanceIndex},
+            {spv::BuiltInInstanceId, spv::ExecutionModelVertex, true, 4,
+             &ShaderInterface::instanceIndex},
+            {spv::BuiltInPosition, spv::ExecutionModelVertex, false, 16,
+             &ShaderInterface::position},
+            {spv::BuiltInFragCoord, spv::ExecutionModelFragment, true, 16,
+             &ShaderInterface::fragCoord},
+            {spv::BuiltInFrontFacing, spv::ExecutionModelFragment, true, 4,
+             &ShaderInterface::frontFacing},
+            {spv::BuiltInFragDepth, spv::ExecutionModelFragment, false, 4,
+             &ShaderInterface::fragDepth},
+        };
+
+        for (const BuiltInInfo& info : kBuiltIns) {
+            if (info.builtIn != builtIn || info.executionModel != mExecutionModel ||
+                info.isInput != isInput) {
+                continue;
+            }
+            if (info.size != size) {
+                Fail("Invalid built-in variable type");
+                return;
+            }
+            InterfaceVariable& variable = mProgram->mInterface.*info.variable;
+            variable.offset = offset;
+            variable.size = size;
+            return;
+        }
+
+        // Other outputs, like gl_PointSize and gl_ClipDistance, are written but ignored.
+        if (isInput) {
+            Fail("Unsupported input variable");
+        }
+    }
+
+    const SpirvTranslator::Type& SpirvTranslator::GetType(uint32_t typeId) {
+        static const Type kInvalidType;
+        if (typeId >= mBound || mTypes[typeId].opcode == 0) {
+            Fail("Invalid type");
+            return kInvalidType;
+        }
+        return mTypes[typeId];
+    }
+
+    const SpirvTranslator::Type& SpirvTranslator::GetValueType(uint32_t id) {
+        if (id >= mBound) {
+            Fail("Invalid id");
+            return GetType(0);
+        }
+        return GetType(mValueTypes[id]);
+    }
+
+    const SpirvTranslator::Type& SpirvTranslator::GetPointeeType(uint32_t pointerId) {
+        const Type& type = GetValueType(pointerId);
+        if (type.opcode != spv::OpTypePointer) {
+            Fail("Expected a pointer");
+        }
+        return GetType(type.element);
+    }
+
+    bool SpirvTranslator::IsExplicitLayout(uint32_t storageClass) const {
+        return storageClass == spv::StorageClassUniform ||
+               storageClass == kStorageClassStorageBuffer ||
+               storageClass == spv::StorageClassPushConstant;
+    }
+
+    uint32_t SpirvTranslator::PackedSize(uint32_t typeId) {
+        const Type& type = GetType(typeId);
+        switch (type.opcode) {
+            case spv::OpTypeBool:
+                return sizeof(uint32_t);
+            case spv::OpTypeInt:
+            case spv::OpTypeFloat:
+                if (type.width != 32) {
+                    Fail("Only 32-bit scalars are supported");
+                    return 0;
+                }
+                return sizeof(uint32_t);
+            case spv::OpTypeVector:
+            case spv::OpTypeMatrix:
+            case spv::OpTypeArray: {
+                uint64_t size = static_cast<uint64_t>(type.count) * PackedSize(type.element);
+                if (size > std::numeric_limits<uint32_t>::max()) {
+                    Fail("Type too large");
+                    return 0;
+                }
+                return static_cast<uint32_t>(size);
+            }
+            case spv::OpTypeStruct: {
+                uint64_t size = 0;
+                for (uint32_t member : type.members) {
+                    size += PackedSize(member);
+                }
+                if (size > std::numeric_limits<uint32_t>::max()) {
+                    Fail("Type too large");
+                    return 0;
+                }
+                return static_cast<uint32_t>(size);
+            }
+            case spv::OpTypePointer:
+                return kPointerSize;
+            default:
+                Fail("Unsupported type with opcode " + std::to_string(type.opcode));
+                return 0;
+        }
+    }
+
+    uint32_t SpirvTranslator::PackedMemberOffset(uint32_t structId, uint32_t member) {
+        const Type& type = GetType(structId);
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < member && i < type.members.size(); ++i) {
+            offset += PackedSize(type.members[i]);
+        }
+        return offset;
+    }
+
+    uint32_t SpirvTranslator::ComponentCount(uint32_t typeId) {
+        const Type& type = GetType(typeId);
+        uint32_t count = 0;
+        switch (type.opcode) {
+            case spv::OpTypeBool:
+            case spv::OpTypeInt:
+            case spv::OpTypeFloat:
+                count = 1;
+                break;
+            case spv::OpTypeVector:
+                count = type.count;
+                break;
+            case spv::OpTypeMatrix:
+                count = type.count * ComponentCount(type.element);
+                break;
+            default:
+                Fail("Expected a scalar, vector or matrix");
+                return 0;
+        }
+        if (count == 0 || count > std::numeric_limits<uint8_t>::max()) {
+            Fail("Invalid component count");
+            return 0;
+        }
+        return count;
+    }
+
+    uint32_t SpirvTranslator::ExplicitSize(uint32_t typeId, uint32_t matrixStride) {
+        const Type& type = GetType(typeId);
+        switch (type.opcode) {
+            case spv::OpTypeMatrix: {
+                uint32_t columnSize = PackedSize(type.element);
+                uint32_t stride = matrixStride != 0 ? matrixStride : columnSize;
+                return (type.count - 1) * stride + columnSize;
+            }
+            case spv::OpTypeArray:
+                return type.count * ArrayStride(typeId);
+            case spv::OpTypeRuntimeArray:
+                return 0;
+            case spv::OpTypeStruct: {
+                uint32_t size = 0;
+                for (uint32_t i = 0; i < type.members.size(); ++i) {
+                    const MemberDecorations& member = GetMemberDecorations(typeId, i);
+                    size = std::max(size, member.offset +
+                                              ExplicitSize(type.members[i], member.matrixStride));
+                }
+                return size;
+            }
+            default:
+                return PackedSize(typeId);
+        }
+    }
+
+    uint32_t SpirvTranslator::ArrayStride(uint32_t arrayId) {
+        uint32_t stride = mDecorations[arrayId].arrayStride;
+        if (stride != 0) {
+            return stride;
+        }
+        // Arrays of blocks, like arrays of buffers, don't have an array stride.
+        return ExplicitSize(GetType(arrayId).element, 0);
+    }
+
+    const SpirvTranslator::MemberDecorations& SpirvTranslator::GetMemberDecorations(
+        uint32_t structId,
+        uint32_t member) {
+        static const MemberDecorations kNoDecorations;
+        auto it = mMemberDecorations.find(structId);
+        if (it == mMemberDecorations.end() || member >= it->second.size() ||
+            it->second[member].offset == kNone) {
+            Fail("Missing member offset in explicitly laid out struct");
+            return kNoDecorations;
+        }
+        return it->second[member];
+    }
+
+    void SpirvTranslator::BuildRuns(uint32_t typeId,
+                                    uint32_t explicitOffset,
+                                    uint32_t packedOffset,
+                                    uint32_t matrixStride,
+                                    std::vector<uint32_t>* runs) {
+        if (!mError.empty()) {
+            return;
+        }
+
+        const Type& type = GetType(typeId);
+        switch (type.opcode) {
+            case spv::OpTypeMatrix: {
+                uint32_t columnSize = PackedSize(type.element);
+                uint32_t stride = matrixStride != 0 ? matrixStride : columnSize;
+                for (uint32_t i = 0; i < type.count; ++i) {
+                    BuildRuns(type.element, explicitOffset + i * stride,
+                              packedOffset + i * columnSize, 0, runs);
+                }
+            } break;
+
+            case spv::OpTypeArray: {
+                uint32_t stride = ArrayStride(typeId);
+                uint32_t elementSize = PackedSize(type.element);
+                for (uint32_t i = 0; i < type.count; ++i) {
+                    BuildRuns(type.element, explicitOffset + i * stride,
+                              packedOffset + i * elementSize, matrixStride, runs);
+                }
+            } break;
+
+            case spv::OpTypeStruct: {
+                uint32_t memberPackedOffset = packedOffset;
+                for (uint32_t i = 0; i < type.members.size(); ++i) {
+                    const MemberDecorations& member = GetMemberDecorations(typeId, i);
+                    BuildRuns(type.members[i], explicitOffset + member.offset,
+                              memberPackedOffset, member.matrixStride, runs);
+                    memberPackedOffset += PackedSize(type.members[i]);
+                }
+            } break;
+
+            case spv::OpTypeRuntimeArray:
+                Fail("Runtime arrays can't be loaded or stored");
+                break;
+
+            default: {
+                // Merge with the previous run when both layouts are contiguous.
+                uint32_t size = PackedSize(typeId);
+                size_t count = runs->size();
+                if (count != 0 && (*runs)[count - 3] + (*runs)[count - 1] == explicitOffset &&
+                    (*runs)[count - 2] + (*runs)[count - 1] == packedOffset) {
+                    (*runs)[count - 1] += size;
+                } else {
+                    runs->push_back(explicitOffset);
+                    runs->push_back(packedOffset);
+                    runs->push_back(size);
+                }
+            } break;
+        }
+    }
+
+    uint32_t SpirvTranslator::Slot(uint32_t id) {
+        if (id >= mBound || mValueTypes[id] == 0) {
+            Fail("Use of an invalid id");
+            return 0;
+        }
+        if (mSlots[id] == kNone) {
+            const Type& type = GetType(mValueTypes[id]);
+            if (type.opcode == spv::OpTypePointer) {
+                mSlots[id] = AllocateRegister(kPointerSize, kPointerAlignment);
+            } else {
+                mSlots[id] = AllocateRegister(PackedSize(mValueTypes[id]), sizeof(uint32_t));
+            }
+        }
+        return mSlots[id];
+    }
+
+    uint32_t SpirvTranslator::AllocateRegister(uint32_t size, uint32_t alignment) {
+        uint32_t offset = Align(mRegistersSize, alignment);
+        mRegistersSize = offset + size;
+        return offset;
+    }
+
+    uint32_t SpirvTranslator::ImmediateSlot(uint32_t value) {
+        uint32_t slot = AllocateRegister(sizeof(uint32_t), sizeof(uint32_t));
+        mProgram->mConstants.resize(std::max<size_t>(mProgram->mConstants.size(), mRegistersSize));
+        memcpy(&mProgram->mConstants[slot], &value, sizeof(value));
+        return slot;
+    }
+
+    void SpirvTranslator::SetConstant(uint32_t id, const void* data, uint32_t size) {
+        uint32_t slot = Slot(id);
+        if (!mError.empty()) {
+            return;
+        }
+        mProgram->mConstants.resize(std::max<size_t>(mProgram->mConstants.size(), slot + size));
+        memcpy(&mProgram->mConstants[slot], data, size);
+    }
+
+    bool SpirvTranslator::IsConstant(uint32_t id) const {
+        return id < mBound && mIsConstant[id];
+    }
+
+    uint32_t SpirvTranslator::ConstantValue(uint32_t id) {
+        if (!IsConstant(id) || PackedSize(mValueTypes[id]) != sizeof(uint32_t)) {
+            Fail("Expected a scalar constant");
+            return 0;
+        }
+        uint32_t value;
+        memcpy(&value, &mProgram->mConstants[Slot(id)], sizeof(value));
+        return value;
+    }
+
+    uint32_t SpirvTranslator::Emit(IrOp op,
+                                   uint32_t result,
+                                   uint32_t a,
+                                   uint32_t b,
+                                   uint32_t c,
+                                   uint32_t lanes,
+                                   uint32_t flags) {
+        ASSERT(lanes <= std::numeric_limits<uint8_t>::max());
+        ASSERT(flags <= std::numeric_limits<uint8_t>::max());
+        ShaderProgram::Instruction inst;
+        inst.op = op;
+        inst.lanes = static_cast<uint8_t>(lanes);
+        inst.flags = static_cast<uint8_t>(flags);
+        inst.result = result;
+        inst.a = a;
+        inst.b = b;
+        inst.c = c;
+        mProgram->mInstructions.push_back(inst);
+        return static_cast<uint32_t>(mProgram->mInstructions.size() - 1);
+    }
+
+    void SpirvTranslator::EmitMove(uint32_t destination, uint32_t source, uint32_t size) {
+        if (size != 0 && destination != source) {
+            Emit(IrOp::Move, destination, source, 0, size);
+        }
+    }
+
+    void SpirvTranslator::EmitLoad(uint32_t result, uint32_t pointer, uint32_t pointerId) {
+        const Type& pointerType = GetValueType(pointerId);
+        uint32_t pointee = pointerType.element;
+        if (!IsExplicitLayout(pointerType.storageClass)) {
+            Emit(IrOp::Load, result, pointer, 0, PackedSize(pointee));
+            return;
+        }
+
+        std::vector<uint32_t> runs;
+        BuildRuns(pointee, 0, 0, mMatrixStrides[pointerId], &runs);
+        uint32_t index = static_cast<uint32_t>(mProgram->mOperands.size());
+        mProgram->mOperands.insert(mProgram->mOperands.end(), runs.begin(), runs.end());
+        Emit(IrOp::LoadRuns, result, pointer, index, static_cast<uint32_t>(runs.size() / 3));
+    }
+
+    void SpirvTranslator::EmitStore(uint32_t pointer, uint32_t value, uint32_t pointerId) {
+        const Type& pointerType = GetValueType(pointerId);
+        uint32_t pointee = pointerType.element;
+        if (!IsExplicitLayout(pointerType.storageClass)) {
+            Emit(IrOp::Store, 0, pointer, value, PackedSize(pointee));
+            return;
+        }
+
+        std::vector<uint32_t> runs;
+        BuildRuns(pointee, 0, 0, mMatrixStrides[pointerId], &runs);
+        uint32_t index = static_cast<uint32_t>(mProgram->mOperands.size());
+        mProgram->mOperands.insert(mProgram->mOperands.end(), runs.begin(), runs.end());
+        Emit(IrOp::StoreRuns, value, pointer, index, static_cast<uint32_t>(runs.size() / 3));
+    }
+
+    void SpirvTranslator::EmitComponentWise(const SpirvInstruction& inst,
+                                            IrOp op,
+                                            uint32_t operandCount) {
+        // Comparisons have a boolean result so the lanes are taken from the operands.
+        uint32_t lanes = ComponentCount(mValueTypes[Word(inst, 3)]);
+        uint32_t a = Slot(Word(inst, 3));
+        uint32_t b = operandCount > 1 ? Slot(Word(inst, 4)) : 0;
+        uint32_t c = operandCount > 2 ? Slot(Word(inst, 5)) : 0;
+        Emit(op, Slot(Word(inst, 2)), a, b, c, lanes);
+    }
+
+    void SpirvTranslator::ReferenceLabel(uint32_t instruction, uint32_t field, uint32_t label) {
+        ShaderProgram::Instruction& inst = mProgram->mInstructions[instruction];
+        uint32_t* fields[] = {&inst.a, &inst.b, &inst.c};
+        *fields[field] = label;
+        mFixups.push_back({false, instruction, field});
+    }
+
+    void SpirvTranslator::ReferenceLabelInOperands(uint32_t index, uint32_t label) {
+        mProgram->mOperands[index] = label;
+        mFixups.push_back({true, index, 0});
+    }
+
+    uint32_t SpirvTranslator::EdgeTarget(uint32_t from, uint32_t to) {
+        if (mPhis.count(to) == 0) {
+            return to;
+        }
+        uint32_t stub = mNextStubLabel++;
+        mEdgeStubs.push_back({from, to, stub});
+        return stub;
+    }
+
+    void SpirvTranslator::EmitPhiMoves(uint32_t from, uint32_t to) {
+        auto it = mPhis.find(to);
+        if (it == mPhis.end()) {
+            return;
+        }
+
+        std::vector<std::pair<uint32_t, uint32_t>> moves;
+        for (size_t index : it->second) {
+            const SpirvInstruction& phi = mInstructions[index];
+            uint32_t value = kNone;
+            for (uint32_t i = 3; i + 1 < phi.wordCount; i += 2) {
+                if (phi.words[i + 1] == from) {
+                    value = phi.words[i];
+                }
+            }
+            if (value == kNone) {
+                Fail("Phi without a value for a predecessor");
+                return;
+            }
+            moves.push_back({Word(phi, 2), value});
+        }
+
+        if (moves.size() == 1) {
+            uint32_t result = moves[0].first;
+            EmitMove(Slot(result), Slot(moves[0].second), PackedSize(mValueTypes[result]));
+            return;
+        }
+
+        // Phis are evaluated in parallel so they go through shadow registers when a block has
+        // several of them, in case one uses the value of another.
+        for (const auto& move : moves) {
+            uint32_t size = PackedSize(mValueTypes[move.first]);
+            if (mShadowSlots.count(move.first) == 0) {
+                mShadowSlots[move.first] = AllocateRegister(size, sizeof(uint32_t));
+            }
+            EmitMove(mShadowSlots[move.first], Slot(move.second), size);
+        }
+        for (const auto& move : moves) {
+            EmitMove(Slot(move.first), mShadowSlots[move.first],
+                     PackedSize(mValueTypes[move.first]));
+        }
+    }
+
+    void SpirvTranslator::EmitJump(uint32_t from, uint32_t to) {
+        EmitPhiMoves(from, to);
+        ReferenceLabel(Emit(IrOp::Jump, 0), 0, to);
+    }
+
+    void SpirvTranslator::TranslateFunction(const Function& function) {
+        mPhis.clear();
+        mEdgeStubs.clear();
+
+        uint32_t label = 0;
+        for (size_t i = function.begin; i < function.end; ++i) {
+            const SpirvInstruction& inst = mInstructions[i];
+            if (inst.opcode == spv::OpLabel) {
+                label = Word(inst, 1);
+            } else if (inst.opcode == spv::OpPhi) {
+                mPhis[label].push_back(i);
+            }
+        }
+
+        mLabelPcs[function.id] = static_cast<uint32_t>(mProgram->mInstructions.size());
+        for (size_t i = function.begin; i < function.end && mError.empty(); ++i) {
+            TranslateInstruction(mInstructions[i]);
+        }
+
+        for (const EdgeStub& stub : mEdgeStubs) {
+            mLabelPcs[stub.label] = static_cast<uint32_t>(mProgram->mInstructions.size());
+            EmitJump(stub.from, stub.to);
+        }
+    }
+
+    void SpirvTranslator::TranslateInstruction(const SpirvInstruction& inst) {
+        switch (inst.opcode) {
+            case spv::OpNop:
+            case spv::OpLine:
+            case spv::OpNoLine:
+            case spv::OpFunctionParameter:
+            case spv::OpSelectionMerge:
+            case spv::OpLoopMerge:
+            case spv::OpMemoryBarrier:
+                break;
+
+            case spv::OpUndef:
+                // Registers start zeroed.
+                Slot(Word(inst, 2));
+                break;
+
+            case spv::OpLabel:
+                mCurrentLabel = Word(inst, 1);
+                mLabelPcs[mCurrentLabel] = static_cast<uint32_t>(mProgram->mInstructions.size());
+                break;
+
+            case spv::OpPhi:
+                // The moves are on the edges leading to the block.
+                Slot(Word(inst, 2));
+                break;
+
+            case spv::OpBranch:
+                EmitJump(mCurrentLabel, Word(inst, 1));
+                break;
+
+            case spv::OpBranchConditional: {
+                uint32_t instruction = Emit(IrOp::JumpIf, 0, Slot(Word(inst, 1)));
+                ReferenceLabel(instruction, 1, EdgeTarget(mCurrentLabel, Word(inst, 2)));
+                ReferenceLabel(instruction, 2, EdgeTarget(mCurrentLabel, Word(inst, 3)));
+            } break;
+
+            case spv::OpSwitch: {
+                if (PackedSize(mValueTypes[Word(inst, 1)]) != sizeof(uint32_t) ||
+                    inst.wordCount % 2 != 1) {
+                    Fail("Only 32-bit switch selectors are supported");
+                    return;
+                }
+                uint32_t pairCount = (inst.wordCount - 3) / 2;
+                uint32_t index = static_cast<uint32_t>(mProgram->mOperands.size());
+                mProgram->mOperands.resize(index + 1 + 2 * pairCount);
+                ReferenceLabelInOperands(index, EdgeTarget(mCurrentLabel, Word(inst, 2)));
+                for (uint32_t i = 0; i < pairCount; ++i) {
+                    mProgram->mOperands[index + 1 + 2 * i] = inst.words[3 + 2 * i];
+                    ReferenceLabelInOperands(index + 2 + 2 * i,
+                                             EdgeTarget(mCurrentLabel, inst.words[4 + 2 * i]));
+                }
+                Emit(IrOp::Switch, 0, Slot(Word(inst, 1)), index, pairCount);
+            } break;
+
+            case spv::OpReturn:
+                Emit(IrOp::Return, 0);
+                break;
+
+            case spv::OpReturnValue: {
+                uint32_t value = Word(inst, 1);
+                Emit(IrOp::ReturnValue, 0, Slot(value), 0, PackedSize(mValueTypes[value]));
+            } break;
+
+            case spv::OpKill:
+                mProgram->mCanKill = true;
+                Emit(IrOp::Kill, 0);
+                break;
+
+            case spv::OpUnreachable:
+                Emit(IrOp::Kill, 0);
+                break;
+
+            case spv::OpFunctionCall: {
+                uint32_t functionId = Word(inst, 3);
+                auto it = mFunctionIndices.find(functionId);
+                if (it == mFunctionIndices.end()) {
+                    Fail("Call to an unknown function");
+                    return;
+                }
+                const std::vector<uint32_t>& parameters = mFunctions[it->second].parameters;
+                if (parameters.size() + 4 != inst.wordCount) {
+                    Fail("Invalid number of arguments");
+                    return;
+                }
+                for (uint32_t i = 0; i < parameters.size(); ++i) {
+                    uint32_t argument = inst.words[4 + i];
+                    uint32_t size = GetValueType(argument).opcode == spv::OpTypePointer
+                                        ? kPointerSize
+                                        : PackedSize(mValueTypes[argument]);
+                    EmitMove(Slot(parameters[i]), Slot(argument), size);
+                }
+                uint32_t result = 0;
+                if (GetType(Word(inst, 1)).opcode != spv::OpTypeVoid) {
+                    result = Slot(Word(inst, 2));
+                }
+                ReferenceLabel(Emit(IrOp::Call, result), 0, functionId);
+            } break;
+
+            case spv::OpControlBarrier:
+                Emit(IrOp::Barrier, 0);
+                break;
+
+            case spv::OpVariable: {
+                uint32_t id = Word(inst, 2);
+                if (Word(inst, 3) != spv::StorageClassFunction) {
+                    Fail("Invalid storage class for a function variable");
+                    return;
+                }
+                AddVariable(id, Word(inst, 1), spv::StorageClassFunction, 0);
+                if (inst.wordCount > 4) {
+                    EmitStore(Slot(id), Slot(inst.words[4]), id);
+                }
+            } break;
+
+            case spv::OpLoad: {
+                uint32_t pointer = Word(inst, 3);
+                EmitLoad(Slot(Word(inst, 2)), Slot(pointer), pointer);
+            } break;
+
+            case spv::OpStore: {
+                uint32_t pointer = Word(inst, 1);
+                EmitStore(Slot(pointer), Slot(Word(inst, 2)), pointer);
+            } break;
+
+            case spv::OpAccessChain:
+            case spv::OpInBoundsAccessChain:
+                TranslateAccessChain(inst);
+                break;
+
+            case spv::OpArrayLength: {
+                uint32_t structId = GetValueType(Word(inst, 3)).element;
+                const Type& structType = GetPointeeType(Word(inst, 3));
+                uint32_t member = Word(inst, 4);
+                if (structType.opcode != spv::OpTypeStruct || member >= structType.members.size() ||
+                    GetType(structType.members[member]).opcode != spv::OpTypeRuntimeArray) {
+                    Fail("Invalid OpArrayLength");
+                    return;
+                }
+                uint32_t stride = ArrayStride(structType.members[member]);
+                Emit(IrOp::ArrayLength, Slot(Word(inst, 2)), Slot(Word(inst, 3)),
+                     GetMemberDecorations(structId, member).offset, stride);
+            } break;
+
+            case spv::OpCompositeExtract:
+                TranslateCompositeExtract(inst);
+                break;
+
+            case spv::OpCompositeInsert: {
+                uint32_t typeId = Word(inst, 1);
+                uint32_t result = Slot(Word(inst, 2));
+                uint32_t object = Word(inst, 3);
+                uint32_t elementType = 0;
+                uint32_t offset = CompositeOffset(typeId, inst, 5, &elementType);
+                EmitMove(result, Slot(Word(inst, 4)), PackedSize(typeId));
+                EmitMove(result + offset, Slot(object), PackedSize(elementType));
+            } break;
+
+            case spv::OpCompositeConstruct: {
+                uint32_t result = Slot(Word(inst, 2));
+                uint32_t offset = 0;
+                for (uint32_t i = 3; i < inst.wordCount; ++i) {
+                    uint32_t size = PackedSize(mValueTypes[inst.words[i]]);
+                    EmitMove(result + offset, Slot(inst.words[i]), size);
+                    offset += size;
+                }
+                if (offset != PackedSize(Word(inst, 1))) {
+                    Fail("Invalid OpCompositeConstruct");
+                }
+            } break;
+
+            case spv::OpCopyObject:
+            case spv::OpBitcast:
+            case spv::OpUConvert:
+            case spv::OpSConvert:
+            case spv::OpFConvert: {
+                // Only 32-bit scalars are supported so these conversions are copies.
+                uint32_t size = PackedSize(Word(inst, 1));
+                if (size != PackedSize(mValueTypes[Word(inst, 3)])) {
+                    Fail("Invalid conversion");
+                    return;
+                }
+                EmitMove(Slot(Word(inst, 2)), Slot(Word(inst, 3)), size);
+            } break;
+
+            case spv::OpVectorShuffle: {
+                uint32_t result = Slot(Word(inst, 2));
+                uint32_t first = Word(inst, 3);
+                uint32_t second = Word(inst, 4);
+                uint32_t firstCount = ComponentCount(mValueTypes[first]);
+                uint32_t secondCount = ComponentCount(mValueTypes[second]);
+                for (uint32_t i = 5; i < inst.wordCount; ++i) {
+                    uint32_t component = inst.words[i];
+                    uint32_t destination = result + (i - 5) * sizeof(uint32_t);
+                    if (component < firstCount) {
+                        EmitMove(destination, Slot(first) + component * sizeof(uint32_t),
+                                 sizeof(uint32_t));
+                    } else if (component < firstCount + secondCount) {
+                        EmitMove(destination,
+                                 Slot(second) + (component - firstCount) * sizeof(uint32_t),
+                                 sizeof(uint32_t));
+                    }
+                }
+            } break;
+
+            case spv::OpVectorExtractDynamic: {
+                uint32_t vector = Word(inst, 3);
+                Emit(IrOp::DynamicExtract, Slot(Word(inst, 2)), Slot(vector), Slot(Word(inst, 4)),
+                     0, ComponentCount(mValueTypes[vector]));
+            } break;
+
+            case spv::OpVectorInsertDynamic: {
+                uint32_t result = Slot(Word(inst, 2));
+                uint32_t typeId = Word(inst, 1);
+                EmitMove(result, Slot(Word(inst, 3)), PackedSize(typeId));
+                Emit(IrOp::DynamicInsert, result, Slot(Word(inst, 4)), Slot(Word(inst, 5)), 0,
+                     ComponentCount(typeId));
+            } break;
+
+            case spv::OpFAdd:
+                EmitComponentWise(inst, IrOp::FAdd, 2);
+                break;
+            case spv::OpFSub:
+                EmitComponentWise(inst, IrOp::FSub, 2);
+                break;
+            case spv::OpFMul:
+                EmitComponentWise(inst, IrOp::FMul, 2);
+                break;
+            case spv::OpFDiv:
+                EmitComponentWise(inst, IrOp::FDiv, 2);
+                break;
+            case spv::OpFRem:
+                EmitComponentWise(inst, IrOp::FRem, 2);
+                break;
+            case spv::OpFMod:
+                EmitComponentWise(inst, IrOp::FMod, 2);
+                break;
+            case spv::OpFNegate:
+                EmitComponentWise(inst, IrOp::FNegate, 1);
+                break;
+            case spv::OpIAdd:
+                EmitComponentWise(inst, IrOp::IAdd, 2);
+                break;
+            case spv::OpISub:
+                EmitComponentWise(inst, IrOp::ISub, 2);
+                break;
+            case spv::OpIMul:
+                EmitComponentWise(inst, IrOp::IMul, 2);
+                break;
+            case spv::OpUDiv:
+                EmitComponentWise(inst, IrOp::UDiv, 2);
+                break;
+            case spv::OpSDiv:
+                EmitComponentWise(inst, IrOp::SDiv, 2);
+                break;
+            case spv::OpUMod:
+                EmitComponentWise(inst, IrOp::UMod, 2);
+                break;
+            case spv::OpSRem:
+                EmitComponentWise(inst, IrOp::SRem, 2);
+                break;
+            case spv::OpSMod:
+                EmitComponentWise(inst, IrOp::SMod, 2);
+                break;
+            case spv::OpSNegate:
+                EmitComponentWise(inst, IrOp::SNegate, 1);
+                break;
+            case spv::OpShiftLeftLogical:
+                EmitComponentWise(inst, IrOp::ShiftLeftLogical, 2);
+                break;
+            case spv::OpShiftRightLogical:
+                EmitComponentWise(inst, IrOp::ShiftRightLogical, 2);
+                break;
+            case spv::OpShiftRightArithmetic:
+                EmitComponentWise(inst, IrOp::ShiftRightArithmetic, 2);
+                break;
+            case spv::OpBitwiseAnd:
+                EmitComponentWise(inst, IrOp::BitwiseAnd, 2);
+                break;
+            case spv::OpBitwiseOr:
+                EmitComponentWise(inst, IrOp::BitwiseOr, 2);
+                break;
+            case spv::OpBitwiseXor:
+                EmitComponentWise(inst, IrOp::BitwiseXor, 2);
+                break;
+            case spv::OpNot:
+                EmitComponentWise(inst, IrOp::Not, 1);
+                break;
+            case spv::OpLogicalAnd:
+                EmitComponentWise(inst, IrOp::LogicalAnd, 2);
+                break;
+            case spv::OpLogicalOr:
+                EmitComponentWise(inst, IrOp::LogicalOr, 2);
+                break;
+            case spv::OpLogicalNot:
+                EmitComponentWise(inst, IrOp::LogicalNot, 1);
+                break;
+            case spv::OpLogicalEqual:
+                EmitComponentWise(inst, IrOp::LogicalEqual, 2);
+                break;
+            case spv::OpLogicalNotEqual:
+                EmitComponentWise(inst, IrOp::LogicalNotEqual, 2);
+                break;
+            case spv::OpIEqual:
+                EmitComponentWise(inst, IrOp::IEqual, 2);
+                break;
+            case spv::OpINotEqual:
+                EmitComponentWise(inst, IrOp::INotEqual, 2);
+                break;
+            case spv::OpUGreaterThan:
+                EmitComponentWise(inst, IrOp::UGreaterThan, 2);
+                break;
+            case spv::OpUGreaterThanEqual:
+                EmitComponentWise(inst, IrOp::UGreaterThanEqual, 2);
+                break;
+            case spv::OpULessThan:
+                EmitComponentWise(inst, IrOp::ULessThan, 2);
+                break;
+            case spv::OpULessThanEqual:
+                EmitComponentWise(inst, IrOp::ULessThanEqual, 2);
+                break;
+            case spv::OpSGreaterThan:
+                EmitComponentWise(inst, IrOp::SGreaterThan, 2);
+                break;
+            case spv::OpSGreaterThanEqual:
+                EmitComponentWise(inst, IrOp::SGreaterThanEqual, 2);
+                break;
+            case spv::OpSLessThan:
+                EmitComponentWise(inst, IrOp::SLessThan, 2);
+                break;
+            case spv::OpSLessThanEqual:
+                EmitComponentWise(inst, IrOp::SLessThanEqual, 2);
+                break;
+            case spv::OpFOrdEqual:
+                EmitComponentWise(inst, IrOp::FOrdEqual, 2);
+                break;
+            case spv::OpFOrdNotEqual:
+                EmitComponentWise(inst, IrOp::FOrdNotEqual, 2);
+                break;
+            case spv::OpFOrdLessThan:
+                EmitComponentWise(inst, IrOp::FOrdLessThan, 2);
+                break;
+            case spv::OpFOrdLessThanEqual:
+                EmitComponentWise(inst, IrOp::FOrdLessThanEqual, 2);
+                break;
+            case spv::OpFOrdGreaterThan:
+                EmitComponentWise(inst, IrOp::FOrdGreaterThan, 2);
+                break;
+            case spv::OpFOrdGreaterThanEqual:
+                EmitComponentWise(inst, IrOp::FOrdGreaterThanEqual, 2);
+                break;
+            case spv::OpFUnordEqual:
+                EmitComponentWise(inst, IrOp::FUnordEqual, 2);
+                break;
+            case spv::OpFUnordNotEqual:
+                EmitComponentWise(inst, IrOp::FUnordNotEqual, 2);
+                break;
+            case spv::OpFUnordLessThan:
+                EmitComponentWise(inst, IrOp::FUnordLessThan, 2);
+                break;
+            case spv::OpFUnordLessThanEqual:
+                EmitComponentWise(inst, IrOp::FUnordLessThanEqual, 2);
+                break;
+            case spv::OpFUnordGreaterThan:
+                EmitComponentWise(inst, IrOp::FUnordGreaterThan, 2);
+                break;
+            case spv::OpFUnordGreaterThanEqual:
+                EmitComponentWise(inst, IrOp::FUnordGreaterThanEqual, 2);
+                break;
+            case spv::OpIsNan:
+                EmitComponentWise(inst, IrOp::IsNan, 1);
+                break;
+            case spv::OpIsInf:
+                EmitComponentWise(inst, IrOp::IsInf, 1);
+                break;
+            case spv::OpConvertFToU:
+                EmitComponentWise(inst, IrOp::ConvertFToU, 1);
+                break;
+            case spv::OpConvertFToS:
+                EmitComponentWise(inst, IrOp::ConvertFToS, 1);
+                break;
+            case spv::OpConvertSToF:
+                EmitComponentWise(inst, IrOp::ConvertSToF, 1);
+                break;
+            case spv::OpConvertUToF:
+                EmitComponentWise(inst, IrOp::ConvertUToF, 1);
+                break;
+
+            case spv::OpSelect: {
+                uint32_t lanes = ComponentCount(Word(inst, 1));
+                uint32_t perComponent = ComponentCount(mValueTypes[Word(inst, 3)]) > 1 ? 1 : 0;
+                Emit(IrOp::Select, Slot(Word(inst, 2)), Slot(Word(inst, 3)), Slot(Word(inst, 4)),
+                     Slot(Word(inst, 5)), lanes, perComponent);
+            } break;
+
+            case spv::OpVectorTimesScalar:
+            case spv::OpMatrixTimesScalar:
+                Emit(IrOp::VectorTimesScalar, Slot(Word(inst, 2)), Slot(Word(inst, 3)),
+                     Slot(Word(inst, 4)), 0, ComponentCount(Word(inst, 1)));
+                break;
+
+            case spv::OpMatrixTimesVector: {
+                const Type& matrix = GetValueType(Word(inst, 3));
+                Emit(IrOp::MatrixTimesVector, Slot(Word(inst, 2)), Slot(Word(inst, 3)),
+                     Slot(Word(inst, 4)), 0, ComponentCount(matrix.element), matrix.count);
+            } break;
+
+            case spv::OpVectorTimesMatrix: {
+                const Type& matrix = GetValueType(Word(inst, 4));
+                Emit(IrOp::VectorTimesMatrix, Slot(Word(inst, 2)), Slot(Word(inst, 3)),
+                     Slot(Word(inst, 4)), 0, matrix.count, ComponentCount(matrix.element));
+            } break;
+
+            case spv::OpMatrixTimesMatrix: {
+                const Type& left = GetValueType(Word(inst, 3));
+                const Type& right = GetValueType(Word(inst, 4));
+                Emit(IrOp::MatrixTimesMatrix, Slot(Word(inst, 2)), Slot(Word(inst, 3)),
+                     Slot(Word(inst, 4)), right.count, ComponentCount(left.element), left.count);
+            } break;
+
+            case spv::OpDot:
+                EmitComponentWise(inst, IrOp::Dot, 2);
+                break;
+            case spv::OpAny:
+                EmitComponentWise(inst, IrOp::Any, 1);
+                break;
+            case spv::OpAll:
+                EmitComponentWise(inst, IrOp::All, 1);
+                break;
+
+            case spv::OpExtInst:
+                TranslateExtInst(inst);
+                break;
+
+            case spv::OpAtomicLoad:
+            case spv::OpAtomicStore:
+            case spv::OpAtomicExchange:
+            case spv::OpAtomicCompareExchange:
+            case spv::OpAtomicIIncrement:
+            case spv::OpAtomicIDecrement:
+            case spv::OpAtomicIAdd:
+            case spv::OpAtomicISub:
+            case spv::OpAtomicSMin:
+            case spv::OpAtomicUMin:
+            case spv::OpAtomicSMax:
+            case spv::OpAtomicUMax:
+            case spv::OpAtomicAnd:
+            case spv::OpAtomicOr:
+            case spv::OpAtomicXor:
+                TranslateAtomic(inst);
+                break;
+
+            default:
+                Fail("Unsupported SPIR-V instruction with opcode " + std::to_string(inst.opcode));
+                break;
+        }
+    }
+
+    void SpirvTranslator::TranslateAccessChain(const SpirvInstruction& inst) {
+        uint32_t result = Word(inst, 2);
+        uint32_t base = Word(inst, 3);
+        const Type& baseType = GetValueType(base);
+        if (baseType.opcode != spv::OpTypePointer) {
+            Fail("Invalid access chain base");
+            return;
+        }
+        bool explicitLayout = IsExplicitLayout(baseType.storageClass);
+
+        // The constant indices are folded in a single offset.
+        uint32_t typeId = baseType.element;
+        uint32_t matrixStride = mMatrixStrides[base];
+        int64_t constantOffset = 0;
+        std::vector<uint32_t> dynamicIndices;
+        for (uint32_t i = 4; i < inst.wordCount && mError.empty(); ++i) {
+            uint32_t index = inst.words[i];
+            const Type& type = GetType(typeId);
+
+            uint32_t stride = 0;
+            switch (type.opcode) {
+                case spv::OpTypeStruct: {
+                    uint32_t member = ConstantValue(index);
+                    if (member >= type.members.size()) {
+                        Fail("Invalid struct index");
+                        return;
+                    }
+                    if (explicitLayout) {
+                        const MemberDecorations& decorations = GetMemberDecorations(typeId, member);
+                        constantOffset += decorations.offset;
+                        matrixStride = decorations.matrixStride;
+                    } else {
+                        constantOffset += PackedMemberOffset(typeId, member);
+                    }
+                    typeId = type.members[member];
+                    continue;
+                }
+                case spv::OpTypeArray:
+                case spv::OpTypeRuntimeArray:
+                    stride = explicitLayout ? ArrayStride(typeId) : PackedSize(type.element);
+                    break;
+                case spv::OpTypeMatrix:
+                    stride = explicitLayout && matrixStride != 0 ? matrixStride
+                                                                 : PackedSize(type.element);
+                    break;
+                case spv::OpTypeVector:
+                    stride = sizeof(uint32_t);
+                    break;
+                default:
+                    Fail("Invalid access chain index");
+                    return;
+            }
+            typeId = type.element;
+
+            const Type& indexType = GetValueType(index);
+            bool isSigned = indexType.opcode == spv::OpTypeInt && indexType.isSigned;
+            if (IsConstant(index)) {
+                uint32_t value = ConstantValue(index);
+                int64_t signedValue = isSigned ? static_cast<int64_t>(static_cast<int32_t>(value))
+                                               : static_cast<int64_t>(value);
+                constantOffset += signedValue * stride;
+            } else {
+                dynamicIndices.push_back(Slot(index));
+                dynamicIndices.push_back(stride);
+                dynamicIndices.push_back(isSigned ? 1 : 0);
+            }
+        }
+
+        if (constantOffset < std::numeric_limits<int32_t>::min() ||
+            constantOffset > std::numeric_limits<int32_t>::max()) {
+            Fail("Access chain offset too large");
+            return;
+        }
+
+        uint32_t index = static_cast<uint32_t>(mProgram->mOperands.size());
+        mProgram->mOperands.push_back(
+            static_cast<uint32_t>(static_cast<int32_t>(constantOffset)));
+        mProgram->mOperands.insert(mProgram->mOperands.end(), dynamicIndices.begin(),
+                                   dynamicIndices.end());
+        Emit(IrOp::AccessChain, Slot(result), Slot(base), index,
+             static_cast<uint32_t>(dynamicIndices.size() / 3));
+        if (result < mBound) {
+            mMatrixStrides[result] = matrixStride;
+        }
+    }
+
+    uint32_t SpirvTranslator::CompositeOffset(uint32_t typeId,
+                                              const SpirvInstruction& inst,
+                                              uint32_t firstIndex,
+                                              uint32_t* elementType) {
+        uint32_t offset = 0;
+        for (uint32_t i = firstIndex; i < inst.wordCount && mError.empty(); ++i) {
+            uint32_t index = inst.words[i];
+            const Type& type = GetType(typeId);
+            switch (type.opcode) {
+                case spv::OpTypeStruct:
+                    if (index >= type.members.size()) {
+                        Fail("Invalid composite index");
+                        return 0;
+                    }
+                    offset += PackedMemberOffset(typeId, index);
+                    typeId = type.members[index];
+                    break;
+                case spv::OpTypeArray:
+                case spv::OpTypeMatrix:
+                case spv::OpTypeVector:
+                    if (index >= type.count) {
+                        Fail("Invalid composite index");
+                        return 0;
+                    }
+                    offset += index * PackedSize(type.element);
+                    typeId = type.element;
+                    break;
+                default:
+                    Fail("Invalid composite index");
+                    return 0;
+            }
+        }
+        *elementType = typeId;
+        return offset;
+    }
+
+    void SpirvTranslator::TranslateCompositeExtract(const SpirvInstruction& inst) {
+        uint32_t composite = Word(inst, 3);
+        uint32_t elementType = 0;
+        uint32_t offset = CompositeOffset(mValueTypes[composite], inst, 4, &elementType);
+        if (elementType != Word(inst, 1)) {
+            Fail("Invalid OpCompositeExtract");
+            return;
+        }
+        EmitMove(Slot(Word(inst, 2)), Slot(composite) + offset, PackedSize(elementType));
+    }
+
+    void SpirvTranslator::TranslateExtInst(const SpirvInstruction& inst) {
+        if (Word(inst, 3) != mGlslImport || mGlslImport == 0) {
+            Fail("Only GLSL.std.450 extended instructions are supported");
+            return;
+        }
+
+        uint32_t glslOp = Word(inst, 4);
+        for (const GlslOp& op : kGlslOps) {
+            if (op.glslOp != glslOp) {
+                continue;
+            }
+            if (inst.wordCount != 5 + op.operandCount) {
+                Fail("Invalid number of operands for GLSL.std.450 instruction");
+                return;
+            }
+            uint32_t lanes = ComponentCount(mValueTypes[Word(inst, 5)]);
+            if (op.op == IrOp::Cross && lanes != 3) {
+                Fail("Cross products are on 3-component vectors");
+                return;
+            }
+            uint32_t b = op.operandCount > 1 ? Slot(Word(inst, 6)) : 0;
+            uint32_t c = op.operandCount > 2 ? Slot(Word(inst, 7)) : 0;
+            Emit(op.op, Slot(Word(inst, 2)), Slot(Word(inst, 5)), b, c, lanes);
+            return;
+        }
+        Fail("Unsupported GLSL.std.450 instruction " + std::to_string(glslOp));
+    }
+
+    void SpirvTranslator::TranslateAtomic(const SpirvInstruction& inst) {
+        // The memory scope and semantics are ignored, all atomics are sequentially consistent.
+        if (inst.opcode == spv::OpAtomicStore) {
+            uint32_t pointer = Word(inst, 1);
+            if (PackedSize(GetValueType(pointer).element) != sizeof(uint32_t)) {
+                Fail("Atomics are on 32-bit integers");
+                return;
+            }
+            Emit(IrOp::AtomicStore, 0, Slot(pointer), Slot(Word(inst, 4)));
+            return;
+        }
+
+        uint32_t result = Slot(Word(inst, 2));
+        uint32_t pointer = Word(inst, 3);
+        if (PackedSize(GetValueType(pointer).element) != sizeof(uint32_t)) {
+            Fail("Atomics are on 32-bit integers");
+            return;
+        }
+
+        IrOp op;
+        uint32_t value = 0;
+        uint32_t comparator = 0;
+        switch (inst.opcode) {
+            case spv::OpAtomicLoad:
+                op = IrOp::AtomicLoad;
+                break;
+            case spv::OpAtomicCompareExchange:
+                op = IrOp::AtomicCompareExchange;
+                value = Slot(Word(inst, 7));
+                comparator = Slot(Word(inst, 8));
+                break;
+            case spv::OpAtomicIIncrement:
+                op = IrOp::AtomicIAdd;
+                value = ImmediateSlot(1);
+                break;
+            case spv::OpAtomicIDecrement:
+                op = IrOp::AtomicISub;
+                value = ImmediateSlot(1);
+                break;
+            default: {
+                static const std::pair<uint32_t, IrOp> kOps[] = {
+                    {spv::OpAtomicExchange, IrOp::AtomicExchange},
+                    {spv::OpAtomicIAdd, IrOp::AtomicIAdd},
+                    {spv::OpAtomicISub, IrOp::AtomicISub},
+                    {spv::OpAtomicSMin, IrOp::AtomicSMin},
+                    {spv::OpAtomicUMin, IrOp::AtomicUMin},
+                    {spv::OpAtomicSMax, IrOp::AtomicSMax},
+                    {spv::OpAtomicUMax, IrOp::AtomicUMax},
+                    {spv::OpAtomicAnd, IrOp::AtomicAnd},
+                    {spv::OpAtomicOr, IrOp::AtomicOr},
+                    {spv::OpAtomicXor, IrOp::AtomicXor},
+                };
+                op = IrOp::AtomicExchange;
+                for (const auto& pair : kOps) {
+                    if (pair.first == inst.opcode) {
+                        op = pair.second;
+                    }
+                }
+                value = Slot(Word(inst, 6));
+            } break;
+        }
+        Emit(op, result, Slot(pointer), value, comparator);
+    }
+
+    void SpirvTranslator::Finalize() {
+        for (const Fixup& fixup : mFixups) {
+            uint32_t* target;
+            if (fixup.inOperands) {
+                target = &mProgram->mOperands[fixup.index];
+            } else {
+                ShaderProgram::Instruction& inst = mProgram->mInstructions[fixup.index];
+                uint32_t* fields[] = {&inst.a, &inst.b, &inst.c};
+                target = fields[fixup.field];
+            }
+            auto it = mLabelPcs.find(*target);
+            if (it == mLabelPcs.end()) {
+                Fail("Branch to an unknown label");
+                return;
+            }
+            *target = it->second;
+        }
+
+        // The frame is the registers, followed by the storage of the variables and the call
+        // stack of (return instruction, result register) pairs.
+        uint32_t registersSize = Align(mRegistersSize, 16);
+        mProgram->mConstants.resize(registersSize, 0);
+        for (ShaderProgram::Variable& variable : mProgram->mVariables) {
+            if (variable.kind == ShaderProgram::VariableKind::Frame) {
+                variable.offset += registersSize;
+            }
+        }
+        mProgram->mCallStackOffset = Align(registersSize + mFrameStorageSize, 8);
+        mProgram->mMaxCallDepth = static_cast<uint32_t>(mFunctions.size());
+        mProgram->mFrameSize =
+            Align(mProgram->mCallStackOffset + mProgram->mMaxCallDepth * 2 * sizeof(uint32_t), 16);
+        mProgram->mWorkgroupMemorySize = Align(mWorkgroupMemorySize, 16);
+
+        ShaderInterface& interface = mProgram->mInterface;
+        InterfaceVariable* builtIns[] = {&interface.vertexIndex, &interface.instanceIndex,
+                                         &interface.position,    &interface.fragCoord,
+                                         &interface.frontFacing, &interface.fragDepth};
+        for (InterfaceVariable* variable : builtIns) {
+            variable->offset += registersSize;
+        }
+        for (uint32_t i = 0; i < kMaxInterfaceLocations; ++i) {
+            interface.inputs[i].offset += registersSize;
+            interface.outputs[i].offset += registersSize;
+        }
+    }
+
+    // ShaderProgram
+
+    std::unique_ptr<ShaderProgram> ShaderProgram::Create(const std::vector<uint32_t>& spirv,
+                                                         nxt::ShaderStage stage,
+                                                         const std::string& entryPoint,
+                                                         std::string* error) {
+        uint32_t executionModel = spv::ExecutionModelGLCompute;
+        switch (stage) {
+            case nxt::ShaderStage::Vertex:
+                executionModel = spv::ExecutionModelVertex;
+                break;
+            case nxt::ShaderStage::Fragment:
+                executionModel = spv::ExecutionModelFragment;
+                break;
+            case nxt::ShaderStage::Compute:
+                executionModel = spv::ExecutionModelGLCompute;
+                break;
+            default:
+                UNREACHABLE();
+        }
+
+        std::unique_ptr<ShaderProgram> program(new ShaderProgram);
+        SpirvTranslator translator(spirv, executionModel, program.get());
+        if (!translator.Translate(entryPoint)) {
+            *error = translator.GetError();
+            return nullptr;
+        }
+        return program;
+    }
+
+    ShaderProgram::ShaderProgram() {
+    }
+
+    ShaderProgram::~ShaderProgram() {
+    }
+
+    const std::array<uint32_t, 3>& ShaderProgram::GetLocalSize() const {
+        return mLocalSize;
+    }
+
+    void ShaderProgram::Dispatch(const ShaderBindings& bindings,
+                                  uint32_t x,
+                                  uint32_t y,
+                                  uint32_t z,
+                                  ThreadPool* pool) const {
+        uint64_t workgroupCount = static_cast<uint64_t>(x) * y * z;
+        // Dispatches with more than 2^32 workgroups would take days, they aren't supported.
+        if (workgroupCount == 0 || workgroupCount > std::numeric_limits<uint32_t>::max()) {
+            return;
+        }
+
+        std::vector<uint8_t> header = MakeHeader(bindings);
+
+        // Each thread of the pool gets scratch memory for the frames of a workgroup, allocated
+        // and initialized the first time it runs a workgroup.
+        std::vector<std::vector<uint8_t>> scratches(pool->GetThreadCount());
+        const std::array<uint32_t, 3> count = {{x, y, z}};
+        pool->ParallelFor(static_cast<uint32_t>(workgroupCount),
+                          [&](uint32_t index, uint32_t threadIndex) {
+                              std::vector<uint8_t>& scratch = scratches[threadIndex];
+                              if (scratch.empty()) {
+                                  scratch.resize(GetScratchSize());
+                                  InitializeScratch(header, scratch.data());
+                              }
+                              std::array<uint32_t, 3> workgroupId = {
+                                  {index % x, (index / x) % y, index / (x * y)}};
+                              RunWorkgroup(workgroupId, count, scratch.data());
+                          });
+    }
+
+    const ShaderInterface& ShaderProgram::GetInterface() const {
+        return mInterface;
+    }
+
+    size_t ShaderProgram::GetFrameSize() const {
+        return mFrameSize;
+    }
+
+    void ShaderProgram::InitializeFrame(const ShaderBindings& bindings, uint8_t* frame) const {
+        // Vertex and fragment shaders have a workgroup of a single invocation.
+        ASSERT(mLocalSize[0] * mLocalSize[1] * mLocalSize[2] == 1 && mWorkgroupMemorySize == 0);
+        InitializeScratch(MakeHeader(bindings), frame);
+    }
+
+    bool ShaderProgram::RunInvocation(uint8_t* frame) const {
+        InvocationState state;
+        state.frame = frame;
+        state.pc = mEntryPoint;
+        state.callDepth = 0;
+        state.done = false;
+        state.killed = false;
+
+        // Barriers don't do anything with a single invocation.
+        while (!Run(&state)) {
+        }
+        return !state.killed;
+    }
+
+    bool ShaderProgram::CanKill() const {
+        return mCanKill;
+    }
+
+    std::vector<uint8_t> ShaderProgram::MakeHeader(const ShaderBindings& bindings) const {
+        // The pointers to the resources are the same for all invocations.
+        std::vector<uint8_t> header = mConstants;
+        for (const Variable& variable : mVariables) {
+            Pointer pointer;
+            if (variable.kind == VariableKind::Buffer) {
+                const ShaderBindings::BufferBinding& binding =
+                    bindings.buffers[variable.group][variable.binding];
+                pointer = MakePointer(binding.data, binding.size);
+            } else if (variable.kind == VariableKind::PushConstant) {
+                pointer = MakePointer(
+                    reinterpret_cast<uint8_t*>(const_cast<uint32_t*>(bindings.pushConstants)),
+                    kMaxPushConstants * sizeof(uint32_t));
+            } else {
+                continue;
+            }
+            memcpy(&header[variable.pointer], &pointer, sizeof(pointer));
+        }
+        return header;
+    }
+
+    size_t ShaderProgram::GetScratchSize() const {
+        size_t invocationCount = mLocalSize[0] * mLocalSize[1] * mLocalSize[2];
+        return invocationCount * (mFrameSize + sizeof(InvocationState)) + mWorkgroupMemorySize;
+    }
+
+    void ShaderProgram::InitializeScratch(const std::vector<uint8_t>& header,
+                                           uint8_t* scratch) const {
+        uint32_t invocationCount = mLocalSize[0] * mLocalSize[1] * mLocalSize[2];
+        uint8_t* workgroupMemory = scratch + invocationCount * mFrameSize;
+
+        for (uint32_t i = 0; i < invocationCount; ++i) {
+            uint8_t* frame = scratch + i * mFrameSize;
+            memcpy(frame, header.data(), header.size());
+
+            for (const Variable& variable : mVariables) {
+                Pointer pointer;
+                if (variable.kind == VariableKind::Frame) {
+                    pointer = MakePointer(frame + variable.offset, variable.size);
+                } else if (variable.kind == VariableKind::Workgroup) {
+                    pointer = MakePointer(workgroupMemory + variable.offset, variable.size);
+                } else {
+                    continue;
+                }
+                memcpy(frame + variable.pointer, &pointer, sizeof(pointer));
+            }
+        }
+    }
+
+    void ShaderProgram::RunWorkgroup(const std::array<uint32_t, 3>& workgroupId,
+                                      const std::array<uint32_t, 3>& workgroupCount,
+                                      uint8_t* scratch) const {
+        uint32_t invocationCount = mLocalSize[0] * mLocalSize[1] * mLocalSize[2];
+        InvocationState* states = reinterpret_cast<InvocationState*>(
+            scratch + invocationCount * mFrameSize + mWorkgroupMemorySize);
+
+        for (uint32_t i = 0; i < invocationCount; ++i) {
+            InvocationState& state = states[i];
+            state.frame = scratch + i * mFrameSize;
+            state.pc = mEntryPoint;
+            state.callDepth = 0;
+            state.done = false;
+            state.killed = false;
+
+            std::array<uint32_t, 3> localId = {
+                {i % mLocalSize[0], (i / mLocalSize[0]) % mLocalSize[1],
+                 i / (mLocalSize[0] * mLocalSize[1])}};
+            for (const Variable& variable : mVariables) {
+                uint32_t* value = Reg<uint32_t>(state.frame, variable.offset);
+                switch (variable.builtIn) {
+                    case spv::BuiltInNumWorkgroups:
+                        memcpy(value, workgroupCount.data(), sizeof(workgroupCount));
+                        break;
+                    case spv::BuiltInWorkgroupId:
+                        memcpy(value, workgroupId.data(), sizeof(workgroupId));
+                        break;
+                    case spv::BuiltInLocalInvocationId:
+                        memcpy(value, localId.data(), sizeof(localId));
+                        break;
+                    case spv::BuiltInGlobalInvocationId:
+                        for (uint32_t j = 0; j < 3; ++j) {
+                            value[j] = workgroupId[j] * mLocalSize[j] + localId[j];
+                        }
+                        break;
+                    case spv::BuiltInLocalInvocationIndex:
+                        *value = i;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+
+        // Run the invocations one after the other up to their next barrier until they are all
+        // done.
+        uint32_t remaining = invocationCount;
+        while (remaining > 0) {
+            for (uint32_t i = 0; i < invocationCount; ++i) {
+                if (!states[i].done && Run(&states[i])) {
+                    states[i].done = true;
+                    remaining--;
+                }
+            }
+        }
+    }
+
+    bool ShaderProgram::Run(InvocationState* state) const {
+        uint8_t* frame = state->frame;
+        uint32_t* callStack = Reg<uint32_t>(frame, mCallStackOffset);
+        const Instruction* instructions = mInstructions.data();
+        const uint32_t* operands = mOperands.data();
+        uint32_t pc = state->pc;
+
+        while (true) {
+            const Instruction& inst = instructions[pc++];
+            switch (inst.op) {
+                case IrOp::Jump:
+                    pc = inst.a;
+                    break;
+                case IrOp::JumpIf:
+                    pc = *Reg<uint32_t>(frame, inst.a) != 0 ? inst.b : inst.c;
+                    break;
+                case IrOp::Switch: {
+                    uint32_t value = *Reg<uint32_t>(frame, inst.a);
+                    const uint32_t* cases = &operands[inst.b];
+                    pc = cases[0];
+                    for (uint32_t i = 0; i < inst.c; ++i) {
+                        if (cases[1 + 2 * i] == value) {
+                            pc = cases[2 + 2 * i];
+                            break;
+                        }
+                    }
+                } break;
+                case IrOp::Call:
+                    if (state->callDepth == mMaxCallDepth) {
+                        return true;
+                    }
+                    callStack[2 * state->callDepth] = pc;
+                    callStack[2 * state->callDepth + 1] = inst.result;
+                    state->callDepth++;
+                    pc = inst.a;
+                    break;
+                case IrOp::Return:
+                case IrOp::ReturnValue:
+                    if (state->callDepth == 0) {
+                        return true;
+                    }
+                    state->callDepth--;
+                    pc = callStack[2 * state->callDepth];
+                    if (inst.op == IrOp::ReturnValue) {
+                        memcpy(frame + callStack[2 * state->callDepth + 1], frame + inst.a,
+                               inst.c);
+                    }
+                    break;
+                case IrOp::Barrier:
+                    state->pc = pc;
+                    return false;
+                case IrOp::Kill:
+                    state->killed = true;
+                    return true;
+
+                case IrOp::Move:
+                    memcpy(frame + inst.result, frame + inst.a, inst.c);
+                    break;
+                case IrOp::Load: {
+                    const Pointer& pointer = *Reg<Pointer>(frame, inst.a);
+                    if (InBounds(pointer, inst.c)) {
+                        memcpy(frame + inst.result, reinterpret_cast<void*>(pointer.address),
+                               inst.c);
+                    } else {
+                        memset(frame + inst.result, 0, inst.c);
+                    }
+                } break;
+                case IrOp::Store: {
+                    const Pointer& pointer = *Reg<Pointer>(frame, inst.a);
+                    if (InBounds(pointer, inst.c)) {
+                        memcpy(reinterpret_cast<void*>(pointer.address), frame + inst.b, inst.c);
+                    }
+                } break;
+                case IrOp::LoadRuns:
+                case IrOp::StoreRuns: {
+                    Pointer pointer = *Reg<Pointer>(frame, inst.a);
+                    uintptr_t base = pointer.address;
+                    const uint32_t* runs = &operands[inst.b];
+                    for (uint32_t i = 0; i < inst.c; ++i, runs += 3) {
+                        pointer.address = base + runs[0];
+                        uint8_t* value = frame + inst.result + runs[1];
+                        bool inBounds = InBounds(pointer, runs[2]);
+                        if (inst.op == IrOp::StoreRuns) {
+                            if (inBounds) {
+                                memcpy(reinterpret_cast<void*>(pointer.address), value, runs[2]);
+                            }
+                        } else if (inBounds) {
+                            memcpy(value, reinterpret_cast<void*>(pointer.address), runs[2]);
+                        } else {
+                            memset(value, 0, runs[2]);
+                        }
+                    }
+                } break;
+                case IrOp::AccessChain: {
+                    Pointer pointer = *Reg<Pointer>(frame, inst.a);
+                    const uint32_t* chain = &operands[inst.b];
+                    int64_t offset = static_cast<int32_t>(chain[0]);
+                    for (uint32_t i = 0; i < inst.c; ++i) {
+                        const uint32_t* step = &chain[1 + 3 * i];
+                        uint32_t index = *Reg<uint32_t>(frame, step[0]);
+                        int64_t signedIndex = static_cast<int64_t>(index);
+                        if (step[2] != 0) {
+                            signedIndex = static_cast<int32_t>(index);
+                        }
+                        offset += signedIndex * step[1];
+                    }
+                    // Wraps around for negative offsets, the pointer is then out of bounds.
+                    pointer.address += static_cast<uintptr_t>(offset);
+                    *Reg<Pointer>(frame, inst.result) = pointer;
+                } break;
+                case IrOp::ArrayLength: {
+                    const Pointer& pointer = *Reg<Pointer>(frame, inst.a);
+                    uintptr_t start = pointer.address + inst.b;
+                    uint32_t length = 0;
+                    if (start >= pointer.begin && start <= pointer.end && inst.c != 0) {
+                        length = static_cast<uint32_t>((pointer.end - start) / inst.c);
+                    }
+                    *Reg<uint32_t>(frame, inst.result) = length;
+                } break;
+                case IrOp::DynamicExtract: {
+                    uint32_t index = *Reg<uint32_t>(frame, inst.b);
+                    *Reg<uint32_t>(frame, inst.result) =
+                        index < inst.lanes ? Reg<uint32_t>(frame, inst.a)[index] : 0;
+                } break;
+                case IrOp::DynamicInsert: {
+                    uint32_t index = *Reg<uint32_t>(frame, inst.b);
+                    if (index < inst.lanes) {
+                        Reg<uint32_t>(frame, inst.result)[index] = *Reg<uint32_t>(frame, inst.a);
+                    }
+                } break;
+
+                case IrOp::FAdd:
+                    BinaryOp<float, float>(frame, inst, [](float a, float b) { return a + b; });
+                    break;
+                case IrOp::FSub:
+                    BinaryOp<float, float>(frame, inst, [](float a, float b) { return a - b; });
+                    break;
+                case IrOp::FMul:
+                    BinaryOp<float, float>(frame, inst, [](float a, float b) { return a * b; });
+                    break;
+                case IrOp::FDiv:
+                    BinaryOp<float, float>(frame, inst, [](float a, float b) { return a / b; });
+                    break;
+                case IrOp::FRem:
+                    BinaryOp<float, float>(frame, inst,
+                                           [](float a, float b) { return std::fmod(a, b); });
+                    break;
+                case IrOp::FMod:
+                    BinaryOp<float, float>(
+                        frame, inst, [](float a, float b) { return a - b * std::floor(a / b); });
+                    break;
+                case IrOp::FNegate:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return -a; });
+                    break;
+                case IrOp::IAdd:
+                    BinaryOp<uint32_t, uint32_t>(frame, inst,
+                                                 [](uint32_t a, uint32_t b) { return a + b; });
+                    break;
+                case IrOp::ISub:
+                    BinaryOp<uint32_t, uint32_t>(frame, inst,
+                                                 [](uint32_t a, uint32_t b) { return a - b; });
+                    break;
+                case IrOp::IMul:
+                    BinaryOp<uint32_t, uint32_t>(frame, inst,
+                                                 [](uint32_t a, uint32_t b) { return a * b; });
+                    break;
+                case IrOp::UDiv:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return b != 0 ? a / b : 0; });
+                    break;
+                case IrOp::SDiv:
+                    BinaryOp<int32_t, int32_t>(frame, inst, SignedDivide);
+                    break;
+                case IrOp::UMod:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return b != 0 ? a % b : 0; });
+                    break;
+                case IrOp::SRem:
+                    BinaryOp<int32_t, int32_t>(frame, inst, SignedRemainder);
+                    break;
+                case IrOp::SMod:
+                    BinaryOp<int32_t, int32_t>(frame, inst, SignedModulo);
+                    break;
+                case IrOp::SNegate:
+                    UnaryOp<uint32_t, uint32_t>(frame, inst, [](uint32_t a) { return 0u - a; });
+                    break;
+                case IrOp::ShiftLeftLogical:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return a << (b & 31); });
+                    break;
+                case IrOp::ShiftRightLogical:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return a >> (b & 31); });
+                    break;
+                case IrOp::ShiftRightArithmetic:
+                    BinaryOp<int32_t, int32_t>(
+                        frame, inst, [](int32_t a, int32_t b) { return a >> (b & 31); });
+                    break;
+                case IrOp::BitwiseAnd:
+                    BinaryOp<uint32_t, uint32_t>(frame, inst,
+                                                 [](uint32_t a, uint32_t b) { return a & b; });
+                    break;
+                case IrOp::BitwiseOr:
+                    BinaryOp<uint32_t, uint32_t>(frame, inst,
+                                                 [](uint32_t a, uint32_t b) { return a | b; });
+                    break;
+                case IrOp::BitwiseXor:
+                    BinaryOp<uint32_t, uint32_t>(frame, inst,
+                                                 [](uint32_t a, uint32_t b) { return a ^ b; });
+                    break;
+                case IrOp::Not:
+                    UnaryOp<uint32_t, uint32_t>(frame, inst, [](uint32_t a) { return ~a; });
+                    break;
+                case IrOp::LogicalAnd:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return Bool(a != 0 && b != 0); });
+                    break;
+                case IrOp::LogicalOr:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return Bool(a != 0 || b != 0); });
+                    break;
+                case IrOp::LogicalNot:
+                    UnaryOp<uint32_t, uint32_t>(frame, inst,
+                                                [](uint32_t a) { return Bool(a == 0); });
+                    break;
+                case IrOp::LogicalEqual:
+                    BinaryOp<uint32_t, uint32_t>(frame, inst, [](uint32_t a, uint32_t b) {
+                        return Bool((a != 0) == (b != 0));
+                    });
+                    break;
+                case IrOp::LogicalNotEqual:
+                    BinaryOp<uint32_t, uint32_t>(frame, inst, [](uint32_t a, uint32_t b) {
+                        return Bool((a != 0) != (b != 0));
+                    });
+                    break;
+                case IrOp::IEqual:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return Bool(a == b); });
+                    break;
+                case IrOp::INotEqual:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return Bool(a != b); });
+                    break;
+                case IrOp::UGreaterThan:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return Bool(a > b); });
+                    break;
+                case IrOp::UGreaterThanEqual:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return Bool(a >= b); });
+                    break;
+                case IrOp::ULessThan:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return Bool(a < b); });
+                    break;
+                case IrOp::ULessThanEqual:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return Bool(a <= b); });
+                    break;
+                case IrOp::SGreaterThan:
+                    BinaryOp<uint32_t, int32_t>(frame, inst,
+                                                [](int32_t a, int32_t b) { return Bool(a > b); });
+                    break;
+                case IrOp::SGreaterThanEqual:
+                    BinaryOp<uint32_t, int32_t>(frame, inst,
+                                                [](int32_t a, int32_t b) { return Bool(a >= b); });
+                    break;
+                case IrOp::SLessThan:
+                    BinaryOp<uint32_t, int32_t>(frame, inst,
+                                                [](int32_t a, int32_t b) { return Bool(a < b); });
+                    break;
+                case IrOp::SLessThanEqual:
+                    BinaryOp<uint32_t, int32_t>(frame, inst,
+                                                [](int32_t a, int32_t b) { return Bool(a <= b); });
+                    break;
+                // C++ comparisons are ordered except !=.
+                case IrOp::FOrdEqual:
+                    BinaryOp<uint32_t, float>(frame, inst,
+                                              [](float a, float b) { return Bool(a == b); });
+                    break;
+                case IrOp::FOrdNotEqual:
+                    BinaryOp<uint32_t, float>(frame, inst, [](float a, float b) {
+                        return Bool(a < b || a > b);
+                    });
+                    break;
+                case IrOp::FOrdLessThan:
+                    BinaryOp<uint32_t, float>(frame, inst,
+                                              [](float a, float b) { return Bool(a < b); });
+                    break;
+                case IrOp::FOrdLessThanEqual:
+                    BinaryOp<uint32_t, float>(frame, inst,
+                                              [](float a, float b) { return Bool(a <= b); });
+                    break;
+                case IrOp::FOrdGreaterThan:
+                    BinaryOp<uint32_t, float>(frame, inst,
+                                              [](float a, float b) { return Bool(a > b); });
+                    break;
+                case IrOp::FOrdGreaterThanEqual:
+                    BinaryOp<uint32_t, float>(frame, inst,
+                                              [](float a, float b) { return Bool(a >= b); });
+                    break;
+                case IrOp::FUnordEqual:
+                    BinaryOp<uint32_t, float>(frame, inst, [](float a, float b) {
+                        return Bool(!(a < b || a > b));
+                    });
+                    break;
+                case IrOp::FUnordNotEqual:
+                    BinaryOp<uint32_t, float>(frame, inst,
+                                              [](float a, float b) { return Bool(a != b); });
+                    break;
+                case IrOp::FUnordLessThan:
+                    BinaryOp<uint32_t, float>(frame, inst,
+                                              [](float a, float b) { return Bool(!(a >= b)); });
+                    break;
+                case IrOp::FUnordLessThanEqual:
+                    BinaryOp<uint32_t, float>(frame, inst,
+                                              [](float a, float b) { return Bool(!(a > b)); });
+                    break;
+                case IrOp::FUnordGreaterThan:
+                    BinaryOp<uint32_t, float>(frame, inst,
+                                              [](float a, float b) { return Bool(!(a <= b)); });
+                    break;
+                case IrOp::FUnordGreaterThanEqual:
+                    BinaryOp<uint32_t, float>(frame, inst,
+                                              [](float a, float b) { return Bool(!(a < b)); });
+                    break;
+                case IrOp::IsNan:
+                    UnaryOp<uint32_t, float>(frame, inst,
+                                             [](float a) { return Bool(std::isnan(a)); });
+                    break;
+                case IrOp::IsInf:
+                    UnaryOp<uint32_t, float>(frame, inst,
+                                             [](float a) { return Bool(std::isinf(a)); });
+                    break;
+                case IrOp::ConvertFToU:
+                    UnaryOp<uint32_t, float>(frame, inst, FloatToUint);
+                    break;
+                case IrOp::ConvertFToS:
+                    UnaryOp<int32_t, float>(frame, inst, FloatToInt);
+                    break;
+                case IrOp::ConvertSToF:
+                    UnaryOp<float, int32_t>(frame, inst,
+                                            [](int32_t a) { return static_cast<float>(a); });
+                    break;
+                case IrOp::ConvertUToF:
+                    UnaryOp<float, uint32_t>(frame, inst,
+                                             [](uint32_t a) { return static_cast<float>(a); });
+                    break;
+                case IrOp::Select: {
+                    uint32_t* result = Reg<uint32_t>(frame, inst.result);
+                    const uint32_t* condition = Reg<uint32_t>(frame, inst.a);
+                    const uint32_t* a = Reg<uint32_t>(frame, inst.b);
+                    const uint32_t* b = Reg<uint32_t>(frame, inst.c);
+                    for (uint32_t i = 0; i < inst.lanes; ++i) {
+                        result[i] = condition[inst.flags != 0 ? i : 0] != 0 ? a[i] : b[i];
+                    }
+                } break;
+
+                case IrOp::VectorTimesScalar: {
+                    float scalar = *Reg<float>(frame, inst.b);
+                    UnaryOp<float, float>(frame, inst, [scalar](float a) { return a * scalar; });
+                } break;
+                case IrOp::MatrixTimesVector: {
+                    float* result = Reg<float>(frame, inst.result);
+                    const float* matrix = Reg<float>(frame, inst.a);
+                    const float* vector = Reg<float>(frame, inst.b);
+                    for (uint32_t row = 0; row < inst.lanes; ++row) {
+                        float sum = 0.0f;
+                        for (uint32_t column = 0; column < inst.flags; ++column) {
+                            sum += matrix[column * inst.lanes + row] * vector[column];
+                        }
+                        result[row] = sum;
+                    }
+                } break;
+                case IrOp::VectorTimesMatrix: {
+                    float* result = Reg<float>(frame, inst.result);
+                    const float* vector = Reg<float>(frame, inst.a);
+                    const float* matrix = Reg<float>(frame, inst.b);
+                    for (uint32_t column = 0; column < inst.lanes; ++column) {
+                        result[column] = Dot(vector, &matrix[column * inst.flags], inst.flags);
+                    }
+                } break;
+                case IrOp::MatrixTimesMatrix: {
+                    float* result = Reg<float>(frame, inst.result);
+                    const float* a = Reg<float>(frame, inst.a);
+                    const float* b = Reg<float>(frame, inst.b);
+                    uint32_t rows = inst.lanes;
+                    uint32_t inner = inst.flags;
+                    for (uint32_t column = 0; column < inst.c; ++column) {
+                        for (uint32_t row = 0; row < rows; ++row) {
+                            float sum = 0.0f;
+                            for (uint32_t k = 0; k < inner; ++k) {
+                                sum += a[k * rows + row] * b[column * inner + k];
+                            }
+                            result[column * rows + row] = sum;
+                        }
+                    }
+                } break;
+                case IrOp::Dot:
+                    *Reg<float>(frame, inst.result) =
+                        Dot(Reg<float>(frame, inst.a), Reg<float>(frame, inst.b), inst.lanes);
+                    break;
+                case IrOp::Any:
+                case IrOp::All: {
+                    const uint32_t* a = Reg<uint32_t>(frame, inst.a);
+                    uint32_t trueCount = 0;
+                    for (uint32_t i = 0; i < inst.lanes; ++i) {
+                        trueCount += Bool(a[i] != 0);
+                    }
+                    *Reg<uint32_t>(frame, inst.result) =
+                        inst.op == IrOp::Any ? Bool(trueCount != 0) : Bool(trueCount == inst.lanes);
+                } break;
+
+                case IrOp::Round:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::round(a); });
+                    break;
+                case IrOp::RoundEven:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::nearbyint(a); });
+                    break;
+                case IrOp::Trunc:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::trunc(a); });
+                    break;
+                case IrOp::FAbs:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::fabs(a); });
+                    break;
+                case IrOp::SAbs:
+                    UnaryOp<uint32_t, int32_t>(frame, inst, [](int32_t a) {
+                        return a < 0 ? 0u - static_cast<uint32_t>(a) : static_cast<uint32_t>(a);
+                    });
+                    break;
+                case IrOp::FSign:
+                    UnaryOp<float, float>(frame, inst, [](float a) {
+                        return a > 0.0f ? 1.0f : (a < 0.0f ? -1.0f : 0.0f);
+                    });
+                    break;
+                case IrOp::SSign:
+                    UnaryOp<int32_t, int32_t>(
+                        frame, inst, [](int32_t a) { return a > 0 ? 1 : (a < 0 ? -1 : 0); });
+                    break;
+                case IrOp::Floor:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::floor(a); });
+                    break;
+                case IrOp::Ceil:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::ceil(a); });
+                    break;
+                case IrOp::Fract:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return a - std::floor(a); });
+                    break;
+                case IrOp::Radians:
+                    UnaryOp<float, float>(frame, inst,
+                                          [](float a) { return a * 0.01745329251994329577f; });
+                    break;
+                case IrOp::Degrees:
+                    UnaryOp<float, float>(frame, inst,
+                                          [](float a) { return a * 57.2957795130823208768f; });
+                    break;
+                case IrOp::Sin:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::sin(a); });
+                    break;
+                case IrOp::Cos:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::cos(a); });
+                    break;
+                case IrOp::Tan:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::tan(a); });
+                    break;
+                case IrOp::Asin:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::asin(a); });
+                    break;
+                case IrOp::Acos:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::acos(a); });
+                    break;
+                case IrOp::Atan:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::atan(a); });
+                    break;
+                case IrOp::Sinh:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::sinh(a); });
+                    break;
+                case IrOp::Cosh:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::cosh(a); });
+                    break;
+                case IrOp::Tanh:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::tanh(a); });
+                    break;
+                case IrOp::Atan2:
+                    BinaryOp<float, float>(frame, inst,
+                                           [](float a, float b) { return std::atan2(a, b); });
+                    break;
+                case IrOp::Pow:
+                    BinaryOp<float, float>(frame, inst,
+                                           [](float a, float b) { return std::pow(a, b); });
+                    break;
+                case IrOp::Exp:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::exp(a); });
+                    break;
+                case IrOp::Log:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::log(a); });
+                    break;
+                case IrOp::Exp2:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::exp2(a); });
+                    break;
+                case IrOp::Log2:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::log2(a); });
+                    break;
+                case IrOp::Sqrt:
+                    UnaryOp<float, float>(frame, inst, [](float a) { return std::sqrt(a); });
+                    break;
+                case IrOp::InverseSqrt:
+                    UnaryOp<float, float>(frame, inst,
+                                          [](float a) { return 1.0f / std::sqrt(a); });
+                    break;
+                case IrOp::FMin:
+                    BinaryOp<float, float>(frame, inst,
+                                           [](float a, float b) { return std::fmin(a, b); });
+                    break;
+                case IrOp::UMin:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return std::min(a, b); });
+                    break;
+                case IrOp::SMin:
+                    BinaryOp<int32_t, int32_t>(frame, inst,
+                                               [](int32_t a, int32_t b) { return std::min(a, b); });
+                    break;
+                case IrOp::FMax:
+                    BinaryOp<float, float>(frame, inst,
+                                           [](float a, float b) { return std::fmax(a, b); });
+                    break;
+                case IrOp::UMax:
+                    BinaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t a, uint32_t b) { return std::max(a, b); });
+                    break;
+                case IrOp::SMax:
+                    BinaryOp<int32_t, int32_t>(frame, inst,
+                                               [](int32_t a, int32_t b) { return std::max(a, b); });
+                    break;
+                case IrOp::FClamp:
+                    TernaryOp<float, float>(frame, inst, [](float x, float low, float high) {
+                        return std::fmin(std::fmax(x, low), high);
+                    });
+                    break;
+                case IrOp::UClamp:
+                    TernaryOp<uint32_t, uint32_t>(
+                        frame, inst, [](uint32_t x, uint32_t low, uint32_t high) {
+                            return std::min(std::max(x, low), high);
+                        });
+                    break;
+                case IrOp::SClamp:
+                    TernaryOp<int32_t, int32_t>(frame, inst,
+                                                [](int32_t x, int32_t low, int32_t high) {
+                                                    return std::min(std::max(x, low), high);
+                                                });
+                    break;
+                case IrOp::FMix:
+                    TernaryOp<float, float>(frame, inst, [](float x, float y, float a) {
+                        return x * (1.0f - a) + y * a;
+                    });
+                    break;
+                case IrOp::Step:
+                    BinaryOp<float, float>(
+                        frame, inst, [](float edge, float x) { return x < edge ? 0.0f : 1.0f; });
+                    break;
+                case IrOp::SmoothStep:
+                    TernaryOp<float, float>(frame, inst, [](float edge0, float edge1, float x) {
+                        float t = std::fmin(std::fmax((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+                        return t * t * (3.0f - 2.0f * t);
+                    });
+                    break;
+                case IrOp::Fma:
+                    TernaryOp<float, float>(
+                        frame, inst, [](float a, float b, float c) { return std::fma(a, b, c); });
+                    break;
+                case IrOp::Length:
+                    *Reg<float>(frame, inst.result) =
+                        Length(Reg<float>(frame, inst.a), inst.lanes);
+                    break;
+                case IrOp::Distance: {
+                    const float* a = Reg<float>(frame, inst.a);
+                    const float* b = Reg<float>(frame, inst.b);
+                    float sum = 0.0f;
+                    for (uint32_t i = 0; i < inst.lanes; ++i) {
+                        sum += (a[i] - b[i]) * (a[i] - b[i]);
+                    }
+                    *Reg<float>(frame, inst.result) = std::sqrt(sum);
+                } break;
+                case IrOp::Cross: {
+                    const float* a = Reg<float>(frame, inst.a);
+                    const float* b = Reg<float>(frame, inst.b);
+                    float cross[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+                                      a[0] * b[1] - a[1] * b[0]};
+                    memcpy(frame + inst.result, cross, sizeof(cross));
+                } break;
+                case IrOp::Normalize: {
+                    float length = Length(Reg<float>(frame, inst.a), inst.lanes);
+                    UnaryOp<float, float>(frame, inst, [length](float a) { return a / length; });
+                } break;
+                case IrOp::Reflect: {
+                    float* result = Reg<float>(frame, inst.result);
+                    const float* incident = Reg<float>(frame, inst.a);
+                    const float* normal = Reg<float>(frame, inst.b);
+                    float dot = Dot(normal, incident, inst.lanes);
+                    for (uint32_t i = 0; i < inst.lanes; ++i) {
+                        result[i] = incident[i] - 2.0f * dot * normal[i];
+                    }
+                } break;
+
+                case IrOp::AtomicLoad:
+                case IrOp::AtomicStore:
+                case IrOp::AtomicExchange:
+                case IrOp::AtomicCompareExchange:
+                case IrOp::AtomicIAdd:
+                case IrOp::AtomicISub:
+                case IrOp::AtomicSMin:
+                case IrOp::AtomicUMin:
+                case IrOp::AtomicSMax:
+                case IrOp::AtomicUMax:
+                case IrOp::AtomicAnd:
+                case IrOp::AtomicOr:
+                case IrOp::AtomicXor: {
+                    const Pointer& pointer = *Reg<Pointer>(frame, inst.a);
+                    uint32_t value = *Reg<uint32_t>(frame, inst.b);
+                    uint32_t original = 0;
+                    if (!InBounds(pointer, sizeof(uint32_t)) ||
+                        pointer.address % sizeof(uint32_t) != 0) {
+                        if (inst.op != IrOp::AtomicStore) {
+                            *Reg<uint32_t>(frame, inst.result) = 0;
+                        }
+                        break;
+                    }
+                    uintptr_t address = pointer.address;
+                    switch (inst.op) {
+                        case IrOp::AtomicLoad:
+                            original = reinterpret_cast<std::atomic<uint32_t>*>(address)->load();
+                            break;
+                        case IrOp::AtomicStore:
+                        case IrOp::AtomicExchange:
+                            original = AtomicRmw(address, [value](uint32_t) { return value; });
+                            break;
+                        case IrOp::AtomicCompareExchange: {
+                            uint32_t comparator = *Reg<uint32_t>(frame, inst.c);
+                            original = AtomicRmw(address, [=](uint32_t v) {
+                                return v == comparator ? value : v;
+                            });
+                        } break;
+                        case IrOp::AtomicIAdd:
+                            original =
+                                AtomicRmw(address, [value](uint32_t v) { return v + value; });
+                            break;
+                        case IrOp::AtomicISub:
+                            original =
+                                AtomicRmw(address, [value](uint32_t v) { return v - value; });
+                            break;
+                        case IrOp::AtomicSMin:
+                            original = AtomicRmw(address, [value](uint32_t v) {
+                                return static_cast<uint32_t>(std::min(static_cast<int32_t>(v),
+                                                                      static_cast<int32_t>(value)));
+                            });
+                            break;
+                        case IrOp::AtomicUMin:
+                            original = AtomicRmw(
+                                address, [value](uint32_t v) { return std::min(v, value); });
+                            break;
+                        case IrOp::AtomicSMax:
+                            original = AtomicRmw(address, [value](uint32_t v) {
+                                return static_cast<uint32_t>(std::max(static_cast<int32_t>(v),
+                                                                      static_cast<int32_t>(value)));
+                            });
+                            break;
+                        case IrOp::AtomicUMax:
+                            original = AtomicRmw(
+                                address, [value](uint32_t v) { return std::max(v, value); });
+                            break;
+                        case IrOp::AtomicAnd:
+                            original =
+                                AtomicRmw(address, [value](uint32_t v) { return v & value; });
+                            break;
+                        case IrOp::AtomicOr:
+                            original =
+                                AtomicRmw(address, [value](uint32_t v) { return v | value; });
+                            break;
+                        case IrOp::AtomicXor:
+                            original =
+                                AtomicRmw(address, [value](uint32_t v) { return v ^ value; });
+                            break;
+                        default:
+                            UNREACHABLE();
+                    }
+                    if (inst.op != IrOp::AtomicStore) {
+                        *Reg<uint32_t>(frame, inst.result) = original;
+                    }
+                } break;
+
+                default:
+                    UNREACHABLE();
+            }
+        }
+    }
+
+}}  // namespace backend::null
@@ -0,0 +1,184 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_NULL_SHADERPROGRAM_H_
+#define BACKEND_NULL_SHADERPROGRAM_H_
+
+#include "common/Constants.h"
+
+#include "nxt/nxtcpp.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+namespace backend { namespace null {
+
+    // The opcodes of the IR, defined in ShaderProgram.cpp.
+    enum class IrOp : uint16_t;
+
+    // The memory given to the resources of a shader for a dispatch or a draw.
+    struct ShaderBindings {
+        struct BufferBinding {
+            uint8_t* data = nullptr;
+            uint32_t size = 0;
+        };
+        std::array<std::array<BufferBinding, kMaxBindingsPerGroup>, kMaxBindGroups> buffers;
+        // kMaxPushConstants values.
+        const uint32_t* pushConstants = nullptr;
+    };
+
+    static constexpr uint32_t kMaxInterfaceLocations = 16u;
+
+    // Where an input or output of a vertex or fragment shader is in the frame of an invocation.
+    // The size is 0 for the variables the shader doesn't have.
+    struct InterfaceVariable {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+        // Whether a fragment input is decorated Flat and must not be interpolated.
+        bool flat = false;
+    };
+
+    struct ShaderInterface {
+        // The user-defined inputs and outputs, by location.
+        std::array<InterfaceVariable, kMaxInterfaceLocations> inputs;
+        std::array<InterfaceVariable, kMaxInterfaceLocations> outputs;
+
+        InterfaceVariable vertexIndex;
+        InterfaceVariable instanceIndex;
+        InterfaceVariable position;
+        InterfaceVariable fragCoord;
+        InterfaceVariable frontFacing;
+        InterfaceVariable fragDepth;
+    };
+
+    // A shader translated from SPIR-V to a compact register-based IR that is interpreted on the
+    // CPU. The workgroups of compute shaders are run in parallel on a ThreadPool, and the
+    // invocations of a workgroup run one after the other on the same thread, switching at
+    // barriers. Vertex and fragment shaders are run one invocation at a time by the Rasterizer.
+    //
+    // Each invocation has a frame holding a register for each SPIR-V value (4 bytes per component
+    // of scalars, vectors and composites, and bounds-checked pointers), followed by the storage of
+    // its Function, Private and Input variables. Out-of-bounds loads return zeros and
+    // out-of-bounds stores are discarded, like with robust buffer access.
+    //
+    // Only the subset of SPIR-V emitted by glslang for shaders using 32-bit scalars, uniform,
+    // storage and push constant buffers, and workgroup variables is supported.
+    class ShaderProgram {
+      public:
+        // Returns nullptr and sets error when the module uses unsupported SPIR-V.
+        static std::unique_ptr<ShaderProgram> Create(const std::vector<uint32_t>& spirv,
+                                                     nxt::ShaderStage stage,
+                                                     const std::string& entryPoint,
+                                                     std::string* error);
+        ~ShaderProgram();
+
+        // Compute shaders
+        const std::array<uint32_t, 3>& GetLocalSize() const;
+
+        void Dispatch(const ShaderBindings& bindings,
+                      uint32_t x,
+                      uint32_t y,
+                      uint32_t z,
+                      ThreadPool* pool) const;
+
+        // Vertex and fragment shaders run in frames of GetFrameSize() bytes initialized once with
+        // InitializeFrame. Each invocation reads its inputs from and writes its outputs to the
+        // offsets of GetInterface() in the frame.
+        const ShaderInterface& GetInterface() const;
+        size_t GetFrameSize() const;
+        void InitializeFrame(const ShaderBindings& bindings, uint8_t* frame) const;
+        // Returns false when the invocation was killed by OpKill.
+        bool RunInvocation(uint8_t* frame) const;
+        // Whether the shader contains OpKill, in which case fragments can't be tested before
+        // running their shader.
+        bool CanKill() const;
+
+      private:
+        friend class SpirvTranslator;
+
+        // The operands are offsets of registers in the frame, instruction indices or immediates
+        // depending on the opcode. lanes is the number of components of component-wise operations.
+        struct Instruction {
+            IrOp op;
+            uint8_t lanes;
+            uint8_t flags;
+            uint32_t result;
+            uint32_t a;
+            uint32_t b;
+            uint32_t c;
+        };
+
+        enum class VariableKind {
+            Buffer,
+            PushConstant,
+            Workgroup,
+            // Variables stored in the frame: Function, Private and Input variables.
+            Frame,
+        };
+        static constexpr uint32_t kNotBuiltIn = 0xFFFFFFFF;
+
+        // Where the pointer to the variable in the frame points.
+        struct Variable {
+            VariableKind kind;
+            uint32_t pointer;
+            uint32_t group;
+            uint32_t binding;
+            // Offset and size of the storage of Workgroup and Frame variables.
+            uint32_t offset;
+            uint32_t size;
+            uint32_t builtIn;
+        };
+
+        struct InvocationState;
+
+        ShaderProgram();
+
+        // The values of the registers shared by all invocations, with the pointers to the
+        // resources.
+        std::vector<uint8_t> MakeHeader(const ShaderBindings& bindings) const;
+        size_t GetScratchSize() const;
+        // Initializes the frames of a thread's scratch memory, once per dispatch.
+        void InitializeScratch(const std::vector<uint8_t>& header, uint8_t* scratch) const;
+        void RunWorkgroup(const std::array<uint32_t, 3>& workgroupId,
+                          const std::array<uint32_t, 3>& workgroupCount,
+                          uint8_t* scratch) const;
+        // Runs the invocation until it returns or reaches a barrier, returns whether it returned.
+        bool Run(InvocationState* state) const;
+
+        std::array<uint32_t, 3> mLocalSize = {{1, 1, 1}};
+        ShaderInterface mInterface;
+        bool mCanKill = false;
+        std::vector<Instruction> mInstructions;
+        // Lists of operands of the instructions that have a variable number of them.
+        std::vector<uint32_t> mOperands;
+        std::vector<Variable> mVariables;
+
+        // The initial content of the registers, with the values of the constants.
+        std::vector<uint8_t> mConstants;
+        uint32_t mFrameSize = 0;
+        uint32_t mCallStackOffset = 0;
+        // Shaders can't be recursive so the call stack is never deeper than the function count.
+        uint32_t mMaxCallDepth = 0;
+        uint32_t mWorkgroupMemorySize = 0;
+        uint32_t mEntryPoint = 0;
+    };
+
+}}  // namespace backend::null
+
+#endif  // BACKEND_NULL_SHADERPROGRAM_H_
@@ -21,6 +21,7 @@
 #include "backend/opengl/OpenGLBackend.h"
 #include "backend/opengl/PersistentPipelineStateGL.h"
 #include "backend/opengl/PipelineLayoutGL.h"
+#include "backend/opengl/QuerySetGL.h"
 #include "backend/opengl/RenderPipelineGL.h"
 #include "backend/opengl/SamplerGL.h"
 #include "backend/opengl/TextureGL.h"
@@ -241,6 +242,11 @@ namespace backend { namespace opengl {
                     pushConstants.OnBeginPass();
                 } break;
 
+                case Command::BeginPipelineStatisticsQuery: {
+                    // Pipeline statistics aren't recorded, see QuerySet::HasQueries
+                    mCommands.NextCommand<BeginPipelineStatisticsQueryCmd>();
+                } break;
+
                 case Command::BeginRenderPass: {
                     auto* cmd = mCommands.NextCommand<BeginRenderPassCmd>();
                     currentRenderPass = ToBackend(cmd->renderPass.Get());
@@ -498,6 +504,10 @@ namespace backend { namespace opengl {
                     mCommands.NextCommand<EndComputePassCmd>();
                 } break;
 
+                case Command::EndPipelineStatisticsQuery: {
+                    mCommands.NextCommand<EndPipelineStatisticsQueryCmd>();
+                } break;
+
                 case Command::EndRenderPass: {
                     mCommands.NextCommand<EndRenderPassCmd>();
                 } break;
@@ -509,6 +519,34 @@ namespace backend { namespace opengl {
                     currentSubpass += 1;
                 } break;
 
+                case Command::ResolveQuerySet: {
+                    ResolveQuerySetCmd* cmd = mCommands.NextCommand<ResolveQuerySetCmd>();
+                    QuerySet* querySet = ToBackend(cmd->querySet.Get());
+                    GLuint buffer = ToBackend(cmd->destination.buffer)->GetHandle();
+                    uint32_t offset = cmd->destination.offset;
+
+                    if (!querySet->HasQueries()) {
+                        uint32_t size =
+                            cmd->queryCount * querySet->GetResultsPerQuery() * kQueryResultSize;
+                        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+                        glClearBufferSubData(GL_COPY_WRITE_BUFFER, GL_R32UI, offset, size,
+                                             GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+                        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+                        break;
+                    }
+
+                    // With a query buffer bound, the results are written in it at the offset
+                    // passed as the pointer instead of being read back to the CPU.
+                    glBindBuffer(GL_QUERY_BUFFER, buffer);
+                    for (uint32_t i = 0; i < cmd->queryCount; ++i) {
+                        glGetQueryObjectui64v(
+                            querySet->GetHandle(cmd->firstQuery + i), GL_QUERY_RESULT,
+                            reinterpret_cast<GLuint64*>(
+                                static_cast<uintptr_t>(offset + i * kQueryResultSize)));
+                    }
+                    glBindBuffer(GL_QUERY_BUFFER, 0);
+                } break;
+
                 case Command::SetComputePipeline: {
                     SetComputePipelineCmd* cmd = mCommands.NextCommand<SetComputePipelineCmd>();
                     ToBackend(cmd->pipeline)->ApplyNow();
@@ -630,6 +668,12 @@ namespace backend { namespace opengl {
 
                     cmd->texture->UpdateUsageInternal(cmd->usage);
                 } break;
+
+                case Command::WriteTimestamp: {
+                    WriteTimestampCmd* cmd = mCommands.NextCommand<WriteTimestampCmd>();
+                    QuerySet* querySet = ToBackend(cmd->querySet.Get());
+                    glQueryCounter(querySet->GetHandle(cmd->queryIndex), GL_TIMESTAMP);
+                } break;
             }
         }
 
@@ -21,11 +21,13 @@
 #include "backend/opengl/DepthStencilStateGL.h"
 #include "backend/opengl/InputStateGL.h"
 #include "backend/opengl/PipelineLayoutGL.h"
+#include "backend/opengl/QuerySetGL.h"
 #include "backend/opengl/RenderPipelineGL.h"
 #include "backend/opengl/SamplerGL.h"
 #include "backend/opengl/ShaderModuleGL.h"
 #include "backend/opengl/SwapChainGL.h"
 #include "backend/opengl/TextureGL.h"
+#include "common/Trace.h"
 
 namespace backend { namespace opengl {
     nxtProcTable GetNonValidatingProcs();
@@ -78,6 +80,9 @@ namespace backend { namespace opengl {
     PipelineLayoutBase* Device::CreatePipelineLayout(PipelineLayoutBuilder* builder) {
         return new PipelineLayout(builder);
     }
+    QuerySetBase* Device::CreateQuerySet(QuerySetBuilder* builder) {
+        return new QuerySet(builder);
+    }
     QueueBase* Device::CreateQueue(QueueBuilder* builder) {
         return new Queue(builder);
     }
@@ -106,6 +111,16 @@ namespace backend { namespace opengl {
     void Device::TickImpl() {
     }
 
+    // OpenGL commands are synchronized implicitly by the driver so from the point of view of the
+    // application they are finished as soon as they are submitted.
+    Serial Device::GetLastSubmittedCommandSerial() const {
+        return 0;
+    }
+
+    Serial Device::GetCompletedCommandSerial() const {
+        return 0;
+    }
+
     // Bind Group
 
     BindGroup::BindGroup(BindGroupBuilder* builder) : BindGroupBase(builder) {
@@ -127,9 +142,10 @@ namespace backend { namespace opengl {
     Queue::Queue(QueueBuilder* builder) : QueueBase(builder) {
     }
 
-    void Queue::Submit(uint32_t numCommands, CommandBuffer* const* commands) {
+    void Queue::SubmitImpl(uint32_t numCommands, CommandBufferBase* const* commands) {
+        NXT_TRACE_EVENT("opengl", "Queue::Submit");
         for (uint32_t i = 0; i < numCommands; ++i) {
-            commands[i]->Execute();
+            ToBackend(commands[i])->Execute();
         }
     }
 
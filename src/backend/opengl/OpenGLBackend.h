@@ -23,6 +23,7 @@
 #include "backend/Buffer.h"
 #include "backend/DepthStencilState.h"
 #include "backend/Device.h"
+#include "backend/Fence.h"
 #include "backend/Framebuffer.h"
 #include "backend/InputState.h"
 #include "backend/Queue.h"
@@ -42,10 +43,12 @@ namespace backend { namespace opengl {
     class ComputePipeline;
     class DepthStencilState;
     class Device;
+    using Fence = FenceBase;
     class Framebuffer;
     class InputState;
     class PersistentPipelineState;
     class PipelineLayout;
+    class QuerySet;
     class Queue;
     class RenderPass;
     class RenderPipeline;
@@ -65,9 +68,11 @@ namespace backend { namespace opengl {
         using ComputePipelineType = ComputePipeline;
         using DepthStencilStateType = DepthStencilState;
         using DeviceType = Device;
+        using FenceType = Fence;
         using FramebufferType = Framebuffer;
         using InputStateType = InputState;
         using PipelineLayoutType = PipelineLayout;
+        using QuerySetType = QuerySet;
         using QueueType = Queue;
         using RenderPassType = RenderPass;
         using RenderPipelineType = RenderPipeline;
@@ -97,6 +102,7 @@ namespace backend { namespace opengl {
         InputStateBase* CreateInputState(InputStateBuilder* builder) override;
         FramebufferBase* CreateFramebuffer(FramebufferBuilder* builder) override;
         PipelineLayoutBase* CreatePipelineLayout(PipelineLayoutBuilder* builder) override;
+        QuerySetBase* CreateQuerySet(QuerySetBuilder* builder) override;
         QueueBase* CreateQueue(QueueBuilder* builder) override;
         RenderPassBase* CreateRenderPass(RenderPassBuilder* builder) override;
         RenderPipelineBase* CreateRenderPipeline(RenderPipelineBuilder* builder) override;
@@ -107,6 +113,8 @@ namespace backend { namespace opengl {
         TextureViewBase* CreateTextureView(TextureViewBuilder* builder) override;
 
         void TickImpl() override;
+        Serial GetLastSubmittedCommandSerial() const override;
+        Serial GetCompletedCommandSerial() const override;
     };
 
     class BindGroup : public BindGroupBase {
@@ -128,8 +136,8 @@ namespace backend { namespace opengl {
       public:
         Queue(QueueBuilder* builder);
 
-        // NXT API
-        void Submit(uint32_t numCommands, CommandBuffer* const* commands);
+      private:
+        void SubmitImpl(uint32_t numCommands, CommandBufferBase* const* commands) override;
     };
 
     class RenderPass : public RenderPassBase {
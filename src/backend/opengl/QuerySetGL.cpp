@@ -0,0 +1,40 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "backend/opengl/QuerySetGL.h"
+
+namespace backend { namespace opengl {
+
+    QuerySet::QuerySet(QuerySetBuilder* builder) : QuerySetBase(builder) {
+        if (GetType() == nxt::QueryType::Timestamp) {
+            mHandles.resize(GetCount());
+            glGenQueries(static_cast<GLsizei>(mHandles.size()), mHandles.data());
+        }
+    }
+
+    QuerySet::~QuerySet() {
+        if (!mHandles.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(mHandles.size()), mHandles.data());
+        }
+    }
+
+    bool QuerySet::HasQueries() const {
+        return !mHandles.empty();
+    }
+
+    GLuint QuerySet::GetHandle(uint32_t query) const {
+        return mHandles[query];
+    }
+
+}}  // namespace backend::opengl
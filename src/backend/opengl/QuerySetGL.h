@@ -0,0 +1,44 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_OPENGL_QUERYSETGL_H_
+#define BACKEND_OPENGL_QUERYSETGL_H_
+
+#include "backend/QuerySet.h"
+
+#include "glad/glad.h"
+
+#include <vector>
+
+namespace backend { namespace opengl {
+
+    class Device;
+
+    class QuerySet : public QuerySetBase {
+      public:
+        QuerySet(QuerySetBuilder* builder);
+        ~QuerySet();
+
+        // Only timestamp sets have GL queries. The loaded GL version doesn't expose
+        // ARB_pipeline_statistics_query so pipeline statistics resolve to zeros.
+        bool HasQueries() const;
+        GLuint GetHandle(uint32_t query) const;
+
+      private:
+        std::vector<GLuint> mHandles;
+    };
+
+}}  // namespace backend::opengl
+
+#endif  // BACKEND_OPENGL_QUERYSETGL_H_
@@ -16,6 +16,7 @@
 
 #include "common/Assert.h"
 #include "common/Platform.h"
+#include "common/Trace.h"
 
 #include <spirv-cross/spirv_glsl.hpp>
 
@@ -47,6 +48,7 @@ namespace backend { namespace opengl {
     }
 
     ShaderModule::ShaderModule(ShaderModuleBuilder* builder) : ShaderModuleBase(builder) {
+        NXT_TRACE_EVENT("opengl", "ShaderModule::ShaderModule");
         spirv_cross::CompilerGLSL compiler(builder->AcquireSpirv());
         spirv_cross::CompilerGLSL::Options options;
 
@@ -17,6 +17,7 @@
 #include "backend/vulkan/FencedDeleter.h"
 #include "backend/vulkan/MemoryAllocator.h"
 #include "backend/vulkan/VulkanBackend.h"
+#include "common/Trace.h"
 
 #include <cstring>
 
@@ -32,6 +33,8 @@ namespace backend { namespace vulkan {
                                        VkDeviceSize offset,
                                        VkDeviceSize size,
                                        const void* data) {
+        NXT_TRACE_EVENT("vulkan", "BufferUploader::BufferSubData");
+
         // TODO(cwallez@chromium.org): this is soooooo bad. We should use some sort of ring buffer
         // for this.
 
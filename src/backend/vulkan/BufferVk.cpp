@@ -112,9 +112,18 @@ namespace backend { namespace vulkan {
         createInfo.flags = 0;
         createInfo.size = GetSize();
         createInfo.usage = VulkanBufferUsage(GetAllowedUsage());
-        createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        createInfo.queueFamilyIndexCount = 0;
-        createInfo.pQueueFamilyIndices = 0;
+        // Resources are used by the queues of all the families, the frontend validates the
+        // queues are synchronized so the concurrent sharing mode avoids ownership transfers.
+        const std::vector<uint32_t>& queueFamilies = device->GetQueueFamilies();
+        if (queueFamilies.size() > 1) {
+            createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            createInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+            createInfo.pQueueFamilyIndices = queueFamilies.data();
+        } else {
+            createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            createInfo.queueFamilyIndexCount = 0;
+            createInfo.pQueueFamilyIndices = 0;
+        }
 
         if (device->fn.CreateBuffer(device->GetVkDevice(), &createInfo, nullptr, &mHandle) !=
             VK_SUCCESS) {
@@ -169,8 +178,8 @@ namespace backend { namespace vulkan {
         barrier.pNext = nullptr;
         barrier.srcAccessMask = VulkanAccessFlags(currentUsage);
         barrier.dstAccessMask = VulkanAccessFlags(targetUsage);
-        barrier.srcQueueFamilyIndex = 0;
-        barrier.dstQueueFamilyIndex = 0;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         barrier.buffer = mHandle;
         barrier.offset = 0;
         barrier.size = GetSize();
@@ -211,19 +220,14 @@ namespace backend { namespace vulkan {
     }
 
     void MapReadRequestTracker::Track(Buffer* buffer, uint32_t mapSerial, const void* data) {
-        Request request;
-        request.buffer = buffer;
-        request.mapSerial = mapSerial;
-        request.data = data;
-
-        mInflightRequests.Enqueue(std::move(request), mDevice->GetSerial());
+        Ref<Buffer> bufferRef = buffer;
+        mInflightRequests.Enqueue(mDevice->GetSerial(), [bufferRef, mapSerial, data]() mutable {
+            bufferRef->OnMapReadCommandSerialFinished(mapSerial, data);
+        });
     }
 
     void MapReadRequestTracker::Tick(Serial finishedSerial) {
-        for (auto& request : mInflightRequests.IterateUpTo(finishedSerial)) {
-            request.buffer->OnMapReadCommandSerialFinished(request.mapSerial, request.data);
-        }
-        mInflightRequests.ClearUpTo(finishedSerial);
+        mInflightRequests.Tick(finishedSerial);
     }
 
 }}  // namespace backend::vulkan
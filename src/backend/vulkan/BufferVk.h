@@ -16,9 +16,9 @@
 #define BACKEND_VULKAN_BUFFERVK_H_
 
 #include "backend/Buffer.h"
+#include "backend/DeferredWorkQueue.h"
 
 #include "backend/vulkan/MemoryAllocator.h"
-#include "common/SerialQueue.h"
 #include "common/vulkan_platform.h"
 
 namespace backend { namespace vulkan {
@@ -60,12 +60,7 @@ namespace backend { namespace vulkan {
       private:
         Device* mDevice;
 
-        struct Request {
-            Ref<Buffer> buffer;
-            uint32_t mapSerial;
-            const void* data;
-        };
-        SerialQueue<Request> mInflightRequests;
+        DeferredWorkQueue mInflightRequests;
     };
 
 }}  // namespace backend::vulkan
@@ -18,146 +18,122 @@
 
 namespace backend { namespace vulkan {
 
-    FencedDeleter::FencedDeleter(Device* device) : mDevice(device) {
+    namespace {
+        // Objects are deleted before the objects they are created from: buffers and images
+        // before the memory bound to them, swapchains before their surface.
+        constexpr uint32_t kObjectsLane = 0;
+        constexpr uint32_t kMemoriesLane = 1;
+        constexpr uint32_t kSurfacesLane = 2;
+        constexpr uint32_t kLaneCount = 3;
+    }  // namespace
+
+    FencedDeleter::FencedDeleter(Device* device) : mDevice(device), mDeletions(kLaneCount) {
     }
 
     FencedDeleter::~FencedDeleter() {
-        ASSERT(mBuffersToDelete.Empty());
-        ASSERT(mDescriptorPoolsToDelete.Empty());
-        ASSERT(mFramebuffersToDelete.Empty());
-        ASSERT(mImagesToDelete.Empty());
-        ASSERT(mImageViewsToDelete.Empty());
-        ASSERT(mMemoriesToDelete.Empty());
-        ASSERT(mPipelinesToDelete.Empty());
-        ASSERT(mPipelineLayoutsToDelete.Empty());
-        ASSERT(mRenderPassesToDelete.Empty());
-        ASSERT(mSemaphoresToDelete.Empty());
-        ASSERT(mShaderModulesToDelete.Empty());
-        ASSERT(mSurfacesToDelete.Empty());
-        ASSERT(mSwapChainsToDelete.Empty());
+        ASSERT(mDeletions.Empty());
     }
 
     void FencedDeleter::DeleteWhenUnused(VkBuffer buffer) {
-        mBuffersToDelete.Enqueue(buffer, mDevice->GetSerial());
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, buffer]() {
+            device->fn.DestroyBuffer(device->GetVkDevice(), buffer, nullptr);
+        });
     }
 
     void FencedDeleter::DeleteWhenUnused(VkDescriptorPool pool) {
-        mDescriptorPoolsToDelete.Enqueue(pool, mDevice->GetSerial());
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, pool]() {
+            device->fn.DestroyDescriptorPool(device->GetVkDevice(), pool, nullptr);
+        });
     }
 
     void FencedDeleter::DeleteWhenUnused(VkDeviceMemory memory) {
-        mMemoriesToDelete.Enqueue(memory, mDevice->GetSerial());
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, memory]() {
+            device->fn.FreeMemory(device->GetVkDevice(), memory, nullptr);
+        }, kMemoriesLane);
     }
 
     void FencedDeleter::DeleteWhenUnused(VkFramebuffer framebuffer) {
-        mFramebuffersToDelete.Enqueue(framebuffer, mDevice->GetSerial());
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, framebuffer]() {
+            device->fn.DestroyFramebuffer(device->GetVkDevice(), framebuffer, nullptr);
+        });
     }
 
     void FencedDeleter::DeleteWhenUnused(VkImage image) {
-        mImagesToDelete.Enqueue(image, mDevice->GetSerial());
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, image]() {
+            device->fn.DestroyImage(device->GetVkDevice(), image, nullptr);
+        });
     }
 
     void FencedDeleter::DeleteWhenUnused(VkImageView view) {
-        mImageViewsToDelete.Enqueue(view, mDevice->GetSerial());
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, view]() {
+            device->fn.DestroyImageView(device->GetVkDevice(), view, nullptr);
+        });
     }
 
     void FencedDeleter::DeleteWhenUnused(VkPipeline pipeline) {
-        mPipelinesToDelete.Enqueue(pipeline, mDevice->GetSerial());
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, pipeline]() {
+            device->fn.DestroyPipeline(device->GetVkDevice(), pipeline, nullptr);
+        });
     }
 
     void FencedDeleter::DeleteWhenUnused(VkPipelineLayout layout) {
-        mPipelineLayoutsToDelete.Enqueue(layout, mDevice->GetSerial());
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, layout]() {
+            device->fn.DestroyPipelineLayout(device->GetVkDevice(), layout, nullptr);
+        });
+    }
+
+    void FencedDeleter::DeleteWhenUnused(VkQueryPool pool) {
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, pool]() {
+            device->fn.DestroyQueryPool(device->GetVkDevice(), pool, nullptr);
+        });
     }
 
     void FencedDeleter::DeleteWhenUnused(VkRenderPass renderPass) {
-        mRenderPassesToDelete.Enqueue(renderPass, mDevice->GetSerial());
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, renderPass]() {
+            device->fn.DestroyRenderPass(device->GetVkDevice(), renderPass, nullptr);
+        });
     }
 
     void FencedDeleter::DeleteWhenUnused(VkSemaphore semaphore) {
-        mSemaphoresToDelete.Enqueue(semaphore, mDevice->GetSerial());
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, semaphore]() {
+            device->fn.DestroySemaphore(device->GetVkDevice(), semaphore, nullptr);
+        });
     }
 
     void FencedDeleter::DeleteWhenUnused(VkShaderModule module) {
-        mShaderModulesToDelete.Enqueue(module, mDevice->GetSerial());
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, module]() {
+            device->fn.DestroyShaderModule(device->GetVkDevice(), module, nullptr);
+        });
     }
 
     void FencedDeleter::DeleteWhenUnused(VkSurfaceKHR surface) {
-        mSurfacesToDelete.Enqueue(surface, mDevice->GetSerial());
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, surface]() {
+            device->fn.DestroySurfaceKHR(device->GetInstance(), surface, nullptr);
+        }, kSurfacesLane);
     }
 
     void FencedDeleter::DeleteWhenUnused(VkSwapchainKHR swapChain) {
-        mSwapChainsToDelete.Enqueue(swapChain, mDevice->GetSerial());
+        Device* device = mDevice;
+        mDeletions.Enqueue(mDevice->GetSerial(), [device, swapChain]() {
+            device->fn.DestroySwapchainKHR(device->GetVkDevice(), swapChain, nullptr);
+        });
     }
 
     void FencedDeleter::Tick(Serial completedSerial) {
-        VkDevice vkDevice = mDevice->GetVkDevice();
-        VkInstance instance = mDevice->GetInstance();
-
-        // Buffers and images must be deleted before memories because it is invalid to free memory
-        // that still have resources bound to it.
-        for (VkBuffer buffer : mBuffersToDelete.IterateUpTo(completedSerial)) {
-            mDevice->fn.DestroyBuffer(vkDevice, buffer, nullptr);
-        }
-        mBuffersToDelete.ClearUpTo(completedSerial);
-        for (VkImage image : mImagesToDelete.IterateUpTo(completedSerial)) {
-            mDevice->fn.DestroyImage(vkDevice, image, nullptr);
-        }
-        mImagesToDelete.ClearUpTo(completedSerial);
-
-        for (VkDeviceMemory memory : mMemoriesToDelete.IterateUpTo(completedSerial)) {
-            mDevice->fn.FreeMemory(vkDevice, memory, nullptr);
-        }
-        mMemoriesToDelete.ClearUpTo(completedSerial);
-
-        for (VkPipelineLayout layout : mPipelineLayoutsToDelete.IterateUpTo(completedSerial)) {
-            mDevice->fn.DestroyPipelineLayout(vkDevice, layout, nullptr);
-        }
-        mPipelineLayoutsToDelete.ClearUpTo(completedSerial);
-
-        for (VkRenderPass renderPass : mRenderPassesToDelete.IterateUpTo(completedSerial)) {
-            mDevice->fn.DestroyRenderPass(vkDevice, renderPass, nullptr);
-        }
-        mRenderPassesToDelete.ClearUpTo(completedSerial);
-
-        for (VkFramebuffer framebuffer : mFramebuffersToDelete.IterateUpTo(completedSerial)) {
-            mDevice->fn.DestroyFramebuffer(vkDevice, framebuffer, nullptr);
-        }
-        mFramebuffersToDelete.ClearUpTo(completedSerial);
-
-        for (VkImageView view : mImageViewsToDelete.IterateUpTo(completedSerial)) {
-            mDevice->fn.DestroyImageView(vkDevice, view, nullptr);
-        }
-        mImageViewsToDelete.ClearUpTo(completedSerial);
-
-        for (VkShaderModule module : mShaderModulesToDelete.IterateUpTo(completedSerial)) {
-            mDevice->fn.DestroyShaderModule(vkDevice, module, nullptr);
-        }
-        mShaderModulesToDelete.ClearUpTo(completedSerial);
-
-        for (VkPipeline pipeline : mPipelinesToDelete.IterateUpTo(completedSerial)) {
-            mDevice->fn.DestroyPipeline(vkDevice, pipeline, nullptr);
-        }
-        mPipelinesToDelete.ClearUpTo(completedSerial);
-
-        // Vulkan swapchains must be destroyed before their corresponding VkSurface
-        for (VkSwapchainKHR swapChain : mSwapChainsToDelete.IterateUpTo(completedSerial)) {
-            mDevice->fn.DestroySwapchainKHR(vkDevice, swapChain, nullptr);
-        }
-        mSwapChainsToDelete.ClearUpTo(completedSerial);
-        for (VkSurfaceKHR surface : mSurfacesToDelete.IterateUpTo(completedSerial)) {
-            mDevice->fn.DestroySurfaceKHR(instance, surface, nullptr);
-        }
-        mSurfacesToDelete.ClearUpTo(completedSerial);
-
-        for (VkSemaphore semaphore : mSemaphoresToDelete.IterateUpTo(completedSerial)) {
-            mDevice->fn.DestroySemaphore(vkDevice, semaphore, nullptr);
-        }
-        mSemaphoresToDelete.ClearUpTo(completedSerial);
-
-        for (VkDescriptorPool pool : mDescriptorPoolsToDelete.IterateUpTo(completedSerial)) {
-            mDevice->fn.DestroyDescriptorPool(vkDevice, pool, nullptr);
-        }
-        mDescriptorPoolsToDelete.ClearUpTo(completedSerial);
+        mDeletions.Tick(completedSerial);
     }
 
 }}  // namespace backend::vulkan
@@ -15,7 +15,7 @@
 #ifndef BACKEND_VULKAN_FENCEDDELETER_H_
 #define BACKEND_VULKAN_FENCEDDELETER_H_
 
-#include "common/SerialQueue.h"
+#include "backend/DeferredWorkQueue.h"
 #include "common/vulkan_platform.h"
 
 namespace backend { namespace vulkan {
@@ -36,6 +36,7 @@ namespace backend { namespace vulkan {
         void DeleteWhenUnused(VkPipelineLayout layout);
         void DeleteWhenUnused(VkRenderPass renderPass);
         void DeleteWhenUnused(VkPipeline pipeline);
+        void DeleteWhenUnused(VkQueryPool pool);
         void DeleteWhenUnused(VkSemaphore semaphore);
         void DeleteWhenUnused(VkShaderModule module);
         void DeleteWhenUnused(VkSurfaceKHR surface);
@@ -45,19 +46,7 @@ namespace backend { namespace vulkan {
 
       private:
         Device* mDevice = nullptr;
-        SerialQueue<VkBuffer> mBuffersToDelete;
-        SerialQueue<VkDescriptorPool> mDescriptorPoolsToDelete;
-        SerialQueue<VkDeviceMemory> mMemoriesToDelete;
-        SerialQueue<VkFramebuffer> mFramebuffersToDelete;
-        SerialQueue<VkImage> mImagesToDelete;
-        SerialQueue<VkImageView> mImageViewsToDelete;
-        SerialQueue<VkPipeline> mPipelinesToDelete;
-        SerialQueue<VkPipelineLayout> mPipelineLayoutsToDelete;
-        SerialQueue<VkRenderPass> mRenderPassesToDelete;
-        SerialQueue<VkSemaphore> mSemaphoresToDelete;
-        SerialQueue<VkShaderModule> mShaderModulesToDelete;
-        SerialQueue<VkSurfaceKHR> mSurfacesToDelete;
-        SerialQueue<VkSwapchainKHR> mSwapChainsToDelete;
+        DeferredWorkQueue mDeletions;
     };
 
 }}  // namespace backend::vulkan
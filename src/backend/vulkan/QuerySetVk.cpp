@@ -0,0 +1,82 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "backend/vulkan/QuerySetVk.h"
+
+#include "backend/vulkan/FencedDeleter.h"
+#include "backend/vulkan/VulkanBackend.h"
+
+namespace backend { namespace vulkan {
+
+    namespace {
+        // The results are written in the order of the bits, which is the same in NXT and Vulkan.
+        VkQueryPipelineStatisticFlags VulkanPipelineStatistics(
+            nxt::PipelineStatisticBit statistics) {
+            VkQueryPipelineStatisticFlags flags = 0;
+            if (statistics & nxt::PipelineStatisticBit::Vertices) {
+                flags |= VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT;
+            }
+            if (statistics & nxt::PipelineStatisticBit::VertexShaderInvocations) {
+                flags |= VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT;
+            }
+            if (statistics & nxt::PipelineStatisticBit::ClipperPrimitives) {
+                flags |= VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT;
+            }
+            if (statistics & nxt::PipelineStatisticBit::FragmentShaderInvocations) {
+                flags |= VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+            }
+            if (statistics & nxt::PipelineStatisticBit::ComputeShaderInvocations) {
+                flags |= VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+            }
+            return flags;
+        }
+    }  // anonymous namespace
+
+    QuerySet::QuerySet(QuerySetBuilder* builder)
+        : QuerySetBase(builder), mDevice(ToBackend(builder->GetDevice())) {
+        VkQueryPoolCreateInfo createInfo;
+        createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        createInfo.pNext = nullptr;
+        createInfo.flags = 0;
+        createInfo.queryCount = GetCount();
+        createInfo.pipelineStatistics = 0;
+
+        if (GetType() == nxt::QueryType::Timestamp) {
+            createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        } else {
+            if (!mDevice->GetDeviceInfo().features.pipelineStatisticsQuery) {
+                return;
+            }
+            createInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            createInfo.pipelineStatistics = VulkanPipelineStatistics(GetPipelineStatistics());
+        }
+
+        if (mDevice->fn.CreateQueryPool(mDevice->GetVkDevice(), &createInfo, nullptr,
+                                        &mHandle) != VK_SUCCESS) {
+            ASSERT(false);
+        }
+    }
+
+    QuerySet::~QuerySet() {
+        if (mHandle != VK_NULL_HANDLE) {
+            mDevice->GetFencedDeleter()->DeleteWhenUnused(mHandle);
+            mHandle = VK_NULL_HANDLE;
+        }
+    }
+
+    VkQueryPool QuerySet::GetHandle() const {
+        return mHandle;
+    }
+
+}}  // namespace backend::vulkan
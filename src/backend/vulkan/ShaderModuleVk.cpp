@@ -16,12 +16,14 @@
 
 #include "backend/vulkan/FencedDeleter.h"
 #include "backend/vulkan/VulkanBackend.h"
+#include "common/Trace.h"
 
 #include <spirv-cross/spirv_cross.hpp>
 
 namespace backend { namespace vulkan {
 
     ShaderModule::ShaderModule(ShaderModuleBuilder* builder) : ShaderModuleBase(builder) {
+        NXT_TRACE_EVENT("vulkan", "ShaderModule::ShaderModule");
         std::vector<uint32_t> spirv = builder->AcquireSpirv();
 
         // Use SPIRV-Cross to extract info from the SPIRV even if Vulkan consumes SPIRV. We want to
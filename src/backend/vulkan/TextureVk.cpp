@@ -245,9 +245,18 @@ namespace backend { namespace vulkan {
         createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
         createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
         createInfo.usage = VulkanImageUsage(GetAllowedUsage(), GetFormat());
-        createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        createInfo.queueFamilyIndexCount = 0;
-        createInfo.pQueueFamilyIndices = nullptr;
+        // Resources are used by the queues of all the families, the frontend validates the
+        // queues are synchronized so the concurrent sharing mode avoids ownership transfers.
+        const std::vector<uint32_t>& queueFamilies = device->GetQueueFamilies();
+        if (queueFamilies.size() > 1) {
+            createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            createInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+            createInfo.pQueueFamilyIndices = queueFamilies.data();
+        } else {
+            createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            createInfo.queueFamilyIndexCount = 0;
+            createInfo.pQueueFamilyIndices = nullptr;
+        }
         createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
         if (device->fn.CreateImage(device->GetVkDevice(), &createInfo, nullptr, &mHandle) !=
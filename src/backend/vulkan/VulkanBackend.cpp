@@ -27,6 +27,7 @@
 #include "backend/vulkan/InputStateVk.h"
 #include "backend/vulkan/NativeSwapChainImplVk.h"
 #include "backend/vulkan/PipelineLayoutVk.h"
+#include "backend/vulkan/QuerySetVk.h"
 #include "backend/vulkan/RenderPassVk.h"
 #include "backend/vulkan/RenderPipelineVk.h"
 #include "backend/vulkan/ShaderModuleVk.h"
@@ -34,9 +35,11 @@
 #include "backend/vulkan/TextureVk.h"
 #include "common/Platform.h"
 #include "common/SwapChainUtils.h"
+#include "common/Trace.h"
 
 #include <spirv-cross/spirv_cross.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 #if NXT_PLATFORM_LINUX
@@ -148,10 +151,14 @@ namespace backend { namespace vulkan {
 
     Device::~Device() {
         // Immediately forget about all pending commands so we don't try to submit them in Tick
-        FreeCommands(&mPendingCommands);
+        for (QueueState& queue : mQueues) {
+            FreeCommands(&queue.pendingCommands);
+        }
 
-        if (fn.QueueWaitIdle(mQueue) != VK_SUCCESS) {
-            ASSERT(false);
+        for (QueueState& queue : mQueues) {
+            if (queue.queue != VK_NULL_HANDLE && fn.QueueWaitIdle(queue.queue) != VK_SUCCESS) {
+                ASSERT(false);
+            }
         }
         CheckPassedFences();
         ASSERT(mFencesInFlight.empty());
@@ -163,12 +170,19 @@ namespace backend { namespace vulkan {
         Tick();
 
         ASSERT(mCommandsInFlight.Empty());
-        for (auto& commands : mUnusedCommands) {
-            FreeCommands(&commands);
-        }
-        mUnusedCommands.clear();
+        for (QueueState& queue : mQueues) {
+            for (auto& commands : queue.unusedCommands) {
+                FreeCommands(&commands);
+            }
+            queue.unusedCommands.clear();
 
-        ASSERT(mWaitSemaphores.empty());
+            // Queues can have waited on other queues without submitting after, the semaphores
+            // are signaled since the GPU is idle.
+            for (VkSemaphore semaphore : queue.waitSemaphores) {
+                fn.DestroySemaphore(mVkDevice, semaphore, nullptr);
+            }
+            queue.waitSemaphores.clear();
+        }
 
         for (VkFence fence : mUnusedFences) {
             fn.DestroyFence(mVkDevice, fence, nullptr);
@@ -238,6 +252,9 @@ namespace backend { namespace vulkan {
     PipelineLayoutBase* Device::CreatePipelineLayout(PipelineLayoutBuilder* builder) {
         return new PipelineLayout(builder);
     }
+    QuerySetBase* Device::CreateQuerySet(QuerySetBuilder* builder) {
+        return new QuerySet(builder);
+    }
     QueueBase* Device::CreateQueue(QueueBuilder* builder) {
         return new Queue(builder);
     }
@@ -273,7 +290,8 @@ namespace backend { namespace vulkan {
 
         mDeleter->Tick(mCompletedSerial);
 
-        if (mPendingCommands.pool != VK_NULL_HANDLE) {
+        // Only the graphics queue has commands recorded outside of Queue::SubmitImpl.
+        if (GetQueueState(nxt::QueueType::Graphics)->pendingCommands.pool != VK_NULL_HANDLE) {
             SubmitPendingCommands();
         } else if (mCompletedSerial == mNextSerial - 1) {
             // If there's no GPU work in flight we still need to artificially increment the serial
@@ -300,11 +318,20 @@ namespace backend { namespace vulkan {
     }
 
     uint32_t Device::GetGraphicsQueueFamily() const {
-        return mQueueFamily;
+        return mQueues[static_cast<uint32_t>(nxt::QueueType::Graphics)].family;
     }
 
     VkQueue Device::GetQueue() const {
-        return mQueue;
+        return mQueues[static_cast<uint32_t>(nxt::QueueType::Graphics)].queue;
+    }
+
+    const std::vector<uint32_t>& Device::GetQueueFamilies() const {
+        return mQueueFamilies;
+    }
+
+    bool Device::HasDedicatedQueue(nxt::QueueType type) const {
+        return type != nxt::QueueType::Graphics &&
+               mQueues[static_cast<uint32_t>(type)].queue != VK_NULL_HANDLE;
     }
 
     MapReadRequestTracker* Device::GetMapReadRequestTracker() const {
@@ -323,13 +350,31 @@ namespace backend { namespace vulkan {
         return mDeleter;
     }
 
+    Serial Device::GetLastSubmittedCommandSerial() const {
+        return mNextSerial - 1;
+    }
+
+    Serial Device::GetCompletedCommandSerial() const {
+        return mCompletedSerial;
+    }
+
     Serial Device::GetSerial() const {
         return mNextSerial;
     }
 
-    VkCommandBuffer Device::GetPendingCommandBuffer() {
-        if (mPendingCommands.pool == VK_NULL_HANDLE) {
-            mPendingCommands = GetUnusedCommands();
+    Device::QueueState* Device::GetQueueState(nxt::QueueType type) {
+        QueueState* queue = &mQueues[static_cast<uint32_t>(type)];
+        if (queue->queue == VK_NULL_HANDLE) {
+            return &mQueues[static_cast<uint32_t>(nxt::QueueType::Graphics)];
+        }
+        return queue;
+    }
+
+    VkCommandBuffer Device::GetPendingCommandBuffer(nxt::QueueType type) {
+        QueueState* queue = GetQueueState(type);
+        CommandPoolAndBuffer& pendingCommands = queue->pendingCommands;
+        if (pendingCommands.pool == VK_NULL_HANDLE) {
+            pendingCommands = GetUnusedCommands(queue);
 
             VkCommandBufferBeginInfo beginInfo;
             beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -337,56 +382,111 @@ namespace backend { namespace vulkan {
             beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
             beginInfo.pInheritanceInfo = nullptr;
 
-            if (fn.BeginCommandBuffer(mPendingCommands.commandBuffer, &beginInfo) != VK_SUCCESS) {
+            if (fn.BeginCommandBuffer(pendingCommands.commandBuffer, &beginInfo) != VK_SUCCESS) {
                 ASSERT(false);
             }
         }
 
-        return mPendingCommands.commandBuffer;
+        return pendingCommands.commandBuffer;
     }
 
-    void Device::SubmitPendingCommands() {
-        if (mPendingCommands.pool == VK_NULL_HANDLE) {
-            return;
+    bool Device::SubmitPendingCommands(nxt::QueueType type) {
+        QueueState* queue = GetQueueState(type);
+        if (queue->pendingCommands.pool == VK_NULL_HANDLE) {
+            return false;
         }
 
-        if (fn.EndCommandBuffer(mPendingCommands.commandBuffer) != VK_SUCCESS) {
+        if (fn.EndCommandBuffer(queue->pendingCommands.commandBuffer) != VK_SUCCESS) {
             ASSERT(false);
         }
 
-        std::vector<VkPipelineStageFlags> dstStageMasks(mWaitSemaphores.size(),
+        std::vector<VkPipelineStageFlags> dstStageMasks(queue->waitSemaphores.size(),
                                                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 
         VkSubmitInfo submitInfo;
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         submitInfo.pNext = nullptr;
-        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(mWaitSemaphores.size());
-        submitInfo.pWaitSemaphores = mWaitSemaphores.data();
+        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(queue->waitSemaphores.size());
+        submitInfo.pWaitSemaphores = queue->waitSemaphores.data();
         submitInfo.pWaitDstStageMask = dstStageMasks.data();
         submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &mPendingCommands.commandBuffer;
+        submitInfo.pCommandBuffers = &queue->pendingCommands.commandBuffer;
         submitInfo.signalSemaphoreCount = 0;
         submitInfo.pSignalSemaphores = 0;
 
         VkFence fence = GetUnusedFence();
-        if (fn.QueueSubmit(mQueue, 1, &submitInfo, fence) != VK_SUCCESS) {
+        if (fn.QueueSubmit(queue->queue, 1, &submitInfo, fence) != VK_SUCCESS) {
             ASSERT(false);
         }
 
-        mCommandsInFlight.Enqueue(mPendingCommands, mNextSerial);
-        mPendingCommands = CommandPoolAndBuffer();
+        mCommandsInFlight.Enqueue(std::make_pair(queue, queue->pendingCommands), mNextSerial);
+        queue->pendingCommands = CommandPoolAndBuffer();
         mFencesInFlight.emplace(fence, mNextSerial);
 
-        for (VkSemaphore semaphore : mWaitSemaphores) {
+        for (VkSemaphore semaphore : queue->waitSemaphores) {
             mDeleter->DeleteWhenUnused(semaphore);
         }
-        mWaitSemaphores.clear();
+        queue->waitSemaphores.clear();
 
+        queue->lastSubmittedSerial = mNextSerial;
         mNextSerial++;
+        return true;
     }
 
     void Device::AddWaitSemaphore(VkSemaphore semaphore) {
-        mWaitSemaphores.push_back(semaphore);
+        GetQueueState(nxt::QueueType::Graphics)->waitSemaphores.push_back(semaphore);
+    }
+
+    void Device::WaitForOtherQueues(nxt::QueueType type, Serial serial) {
+        for (uint32_t i = 0; i < kNumQueueTypes; ++i) {
+            WaitForQueue(type, static_cast<nxt::QueueType>(i), serial);
+        }
+    }
+
+    void Device::WaitForQueue(nxt::QueueType type, nxt::QueueType otherType, Serial serial) {
+        QueueState* waitingQueue = GetQueueState(type);
+        uint32_t otherIndex = static_cast<uint32_t>(otherType);
+        QueueState* otherQueue = &mQueues[otherIndex];
+        if (otherQueue == waitingQueue || otherQueue->queue == VK_NULL_HANDLE) {
+            return;
+        }
+
+        // The binary semaphores can only be waited on once, so an empty submit on the other queue
+        // signals a new one after the commands submitted up to now, which can include more than
+        // the ones up to serial.
+        Serial lastSubmittedSerial = std::min(serial, otherQueue->lastSubmittedSerial);
+        if (lastSubmittedSerial <= mCompletedSerial ||
+            lastSubmittedSerial <= waitingQueue->waitedSerials[otherIndex]) {
+            return;
+        }
+
+        VkSemaphoreCreateInfo createInfo;
+        createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        createInfo.pNext = nullptr;
+        createInfo.flags = 0;
+
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        if (fn.CreateSemaphore(mVkDevice, &createInfo, nullptr, &semaphore) != VK_SUCCESS) {
+            ASSERT(false);
+        }
+
+        VkSubmitInfo submitInfo;
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = nullptr;
+        submitInfo.waitSemaphoreCount = 0;
+        submitInfo.pWaitSemaphores = nullptr;
+        submitInfo.pWaitDstStageMask = nullptr;
+        submitInfo.commandBufferCount = 0;
+        submitInfo.pCommandBuffers = nullptr;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &semaphore;
+
+        if (fn.QueueSubmit(otherQueue->queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            ASSERT(false);
+        }
+
+        waitingQueue->waitSemaphores.push_back(semaphore);
+        waitingQueue->waitedSerials[otherIndex] = otherQueue->lastSubmittedSerial;
     }
 
     bool Device::CreateInstance(VulkanGlobalKnobs* usedKnobs,
@@ -471,6 +571,11 @@ namespace backend { namespace vulkan {
             usedKnobs->swapchain = true;
         }
 
+        // Pipeline statistics query sets resolve to zeros when the feature isn't supported.
+        if (mDeviceInfo.features.pipelineStatisticsQuery == VK_TRUE) {
+            usedKnobs->features.pipelineStatisticsQuery = VK_TRUE;
+        }
+
         // Find a universal queue family
         {
             constexpr uint32_t kUniversalFlags =
@@ -487,16 +592,42 @@ namespace backend { namespace vulkan {
             if (universalQueueFamily == -1) {
                 return false;
             }
-            mQueueFamily = static_cast<uint32_t>(universalQueueFamily);
+            for (QueueState& queue : mQueues) {
+                queue.family = static_cast<uint32_t>(universalQueueFamily);
+            }
         }
 
-        // Choose to create a single universal queue
-        {
+        // Find families dedicated to compute and to transfers, the queues of these run
+        // concurrently with the universal queue (async compute and DMA engines).
+        for (unsigned int i = 0; i < mDeviceInfo.queueFamilies.size(); ++i) {
+            VkQueueFlags flags = mDeviceInfo.queueFamilies[i].queueFlags;
+            QueueState& compute = mQueues[static_cast<uint32_t>(nxt::QueueType::Compute)];
+            QueueState& transfer = mQueues[static_cast<uint32_t>(nxt::QueueType::Transfer)];
+
+            if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT) &&
+                compute.family == GetGraphicsQueueFamily()) {
+                compute.family = i;
+            }
+            if ((flags & VK_QUEUE_TRANSFER_BIT) &&
+                !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) &&
+                transfer.family == GetGraphicsQueueFamily()) {
+                transfer.family = i;
+            }
+        }
+
+        // Choose to create a single queue for each of the distinct families
+        for (const QueueState& queue : mQueues) {
+            if (std::find(mQueueFamilies.begin(), mQueueFamilies.end(), queue.family) !=
+                mQueueFamilies.end()) {
+                continue;
+            }
+            mQueueFamilies.push_back(queue.family);
+
             VkDeviceQueueCreateInfo queueCreateInfo;
             queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
             queueCreateInfo.pNext = nullptr;
             queueCreateInfo.flags = 0;
-            queueCreateInfo.queueFamilyIndex = static_cast<uint32_t>(mQueueFamily);
+            queueCreateInfo.queueFamilyIndex = queue.family;
             queueCreateInfo.queueCount = 1;
             queueCreateInfo.pQueuePriorities = &zero;
 
@@ -523,7 +654,13 @@ namespace backend { namespace vulkan {
     }
 
     void Device::GatherQueueFromDevice() {
-        fn.GetDeviceQueue(mVkDevice, mQueueFamily, 0, &mQueue);
+        // Queue types without a dedicated family keep a null queue and use the graphics one.
+        for (QueueState& queue : mQueues) {
+            if (&queue == &mQueues[static_cast<uint32_t>(nxt::QueueType::Graphics)] ||
+                queue.family != GetGraphicsQueueFamily()) {
+                fn.GetDeviceQueue(mVkDevice, queue.family, 0, &queue.queue);
+            }
+        }
     }
 
     bool Device::RegisterDebugReport() {
@@ -607,10 +744,10 @@ namespace backend { namespace vulkan {
         }
     }
 
-    Device::CommandPoolAndBuffer Device::GetUnusedCommands() {
-        if (!mUnusedCommands.empty()) {
-            CommandPoolAndBuffer commands = mUnusedCommands.back();
-            mUnusedCommands.pop_back();
+    Device::CommandPoolAndBuffer Device::GetUnusedCommands(QueueState* queue) {
+        if (!queue->unusedCommands.empty()) {
+            CommandPoolAndBuffer commands = queue->unusedCommands.back();
+            queue->unusedCommands.pop_back();
             return commands;
         }
 
@@ -620,7 +757,7 @@ namespace backend { namespace vulkan {
         createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         createInfo.pNext = nullptr;
         createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
-        createInfo.queueFamilyIndex = mQueueFamily;
+        createInfo.queueFamilyIndex = queue->family;
 
         if (fn.CreateCommandPool(mVkDevice, &createInfo, nullptr, &commands.pool) != VK_SUCCESS) {
             ASSERT(false);
@@ -642,11 +779,12 @@ namespace backend { namespace vulkan {
     }
 
     void Device::RecycleCompletedCommands() {
-        for (auto& commands : mCommandsInFlight.IterateUpTo(mCompletedSerial)) {
+        for (auto& queueAndCommands : mCommandsInFlight.IterateUpTo(mCompletedSerial)) {
+            CommandPoolAndBuffer& commands = queueAndCommands.second;
             if (fn.ResetCommandPool(mVkDevice, commands.pool, 0) != VK_SUCCESS) {
                 ASSERT(false);
             }
-            mUnusedCommands.push_back(commands);
+            queueAndCommands.first->unusedCommands.push_back(commands);
         }
         mCommandsInFlight.ClearUpTo(mCompletedSerial);
     }
@@ -669,15 +807,30 @@ namespace backend { namespace vulkan {
     Queue::~Queue() {
     }
 
-    void Queue::Submit(uint32_t numCommands, CommandBuffer* const* commands) {
+    void Queue::SubmitImpl(uint32_t numCommands, CommandBufferBase* const* commands) {
+        NXT_TRACE_EVENT("vulkan", "Queue::Submit");
         Device* device = ToBackend(GetDevice());
+        nxt::QueueType type = GetType();
 
-        VkCommandBuffer commandBuffer = device->GetPendingCommandBuffer();
+        // The uploads and other commands the device recorded are on the graphics queue, a
+        // dedicated queue must wait for them before using the resources. Any other ordering
+        // between queues is up to the application with Queue::Wait.
+        if (device->HasDedicatedQueue(type) &&
+            device->SubmitPendingCommands(nxt::QueueType::Graphics)) {
+            device->WaitForQueue(type, nxt::QueueType::Graphics,
+                                 device->GetLastSubmittedCommandSerial());
+        }
+
+        VkCommandBuffer commandBuffer = device->GetPendingCommandBuffer(type);
         for (uint32_t i = 0; i < numCommands; ++i) {
-            commands[i]->RecordCommands(commandBuffer);
+            ToBackend(commands[i])->RecordCommands(commandBuffer);
         }
 
-        device->SubmitPendingCommands();
+        device->SubmitPendingCommands(type);
+    }
+
+    void Queue::WaitImpl(Serial signalSerial) {
+        ToBackend(GetDevice())->WaitForOtherQueues(GetType(), signalSerial);
     }
 
 }}  // namespace backend::vulkan
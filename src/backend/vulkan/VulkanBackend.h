@@ -19,6 +19,7 @@
 
 #include "backend/ComputePipeline.h"
 #include "backend/Device.h"
+#include "backend/Fence.h"
 #include "backend/Queue.h"
 #include "backend/Sampler.h"
 #include "backend/ToBackend.h"
@@ -28,6 +29,7 @@
 #include "common/Serial.h"
 #include "common/SerialQueue.h"
 
+#include <array>
 #include <queue>
 
 namespace backend { namespace vulkan {
@@ -41,9 +43,11 @@ namespace backend { namespace vulkan {
     using ComputePipeline = ComputePipelineBase;
     class DepthStencilState;
     class Device;
+    using Fence = FenceBase;
     class Framebuffer;
     class InputState;
     class PipelineLayout;
+    class QuerySet;
     class Queue;
     class RenderPass;
     class RenderPipeline;
@@ -68,9 +72,11 @@ namespace backend { namespace vulkan {
         using ComputePipelineType = ComputePipeline;
         using DepthStencilStateType = DepthStencilState;
         using DeviceType = Device;
+        using FenceType = Fence;
         using FramebufferType = Framebuffer;
         using InputStateType = InputState;
         using PipelineLayoutType = PipelineLayout;
+        using QuerySetType = QuerySet;
         using QueueType = Queue;
         using RenderPassType = RenderPass;
         using RenderPipelineType = RenderPipeline;
@@ -100,6 +106,10 @@ namespace backend { namespace vulkan {
         VkDevice GetVkDevice() const;
         uint32_t GetGraphicsQueueFamily() const;
         VkQueue GetQueue() const;
+        // The distinct queue families of the queues, resources are shared between them.
+        const std::vector<uint32_t>& GetQueueFamilies() const;
+        // Whether the queue type has its own Vulkan queue instead of using the graphics one.
+        bool HasDedicatedQueue(nxt::QueueType type) const;
 
         BufferUploader* GetBufferUploader() const;
         FencedDeleter* GetFencedDeleter() const;
@@ -108,9 +118,17 @@ namespace backend { namespace vulkan {
 
         Serial GetSerial() const;
 
-        VkCommandBuffer GetPendingCommandBuffer();
-        void SubmitPendingCommands();
+        // Without a queue type, these are for the commands the device records on the graphics
+        // queue, like uploads and the acquisition of swapchain images.
+        VkCommandBuffer GetPendingCommandBuffer(nxt::QueueType type = nxt::QueueType::Graphics);
+        // Returns whether there were pending commands to submit.
+        bool SubmitPendingCommands(nxt::QueueType type = nxt::QueueType::Graphics);
         void AddWaitSemaphore(VkSemaphore semaphore);
+        // Makes the next submit of the queue type wait for the submits of the other Vulkan
+        // queues up to serial.
+        void WaitForOtherQueues(nxt::QueueType type, Serial serial);
+        // Same as WaitForOtherQueues but only for the Vulkan queue of otherType.
+        void WaitForQueue(nxt::QueueType type, nxt::QueueType otherType, Serial serial);
 
         // NXT API
         BindGroupBase* CreateBindGroup(BindGroupBuilder* builder) override;
@@ -124,6 +142,7 @@ namespace backend { namespace vulkan {
         FramebufferBase* CreateFramebuffer(FramebufferBuilder* builder) override;
         InputStateBase* CreateInputState(InputStateBuilder* builder) override;
         PipelineLayoutBase* CreatePipelineLayout(PipelineLayoutBuilder* builder) override;
+        QuerySetBase* CreateQuerySet(QuerySetBuilder* builder) override;
         QueueBase* CreateQueue(QueueBuilder* builder) override;
         RenderPassBase* CreateRenderPass(RenderPassBuilder* builder) override;
         RenderPipelineBase* CreateRenderPipeline(RenderPipelineBuilder* builder) override;
@@ -134,6 +153,8 @@ namespace backend { namespace vulkan {
         TextureViewBase* CreateTextureView(TextureViewBuilder* builder) override;
 
         void TickImpl() override;
+        Serial GetLastSubmittedCommandSerial() const override;
+        Serial GetCompletedCommandSerial() const override;
 
       private:
         bool CreateInstance(VulkanGlobalKnobs* usedKnobs,
@@ -164,8 +185,6 @@ namespace backend { namespace vulkan {
         VkInstance mInstance = VK_NULL_HANDLE;
         VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
         VkDevice mVkDevice = VK_NULL_HANDLE;
-        uint32_t mQueueFamily = 0;
-        VkQueue mQueue = VK_NULL_HANDLE;
         VkDebugReportCallbackEXT mDebugReportCallback = VK_NULL_HANDLE;
 
         BufferUploader* mBufferUploader = nullptr;
@@ -176,10 +195,11 @@ namespace backend { namespace vulkan {
         VkFence GetUnusedFence();
         void CheckPassedFences();
 
-        // We track which operations are in flight on the GPU with an increasing serial.
-        // This works only because we have a single queue. Each submit to a queue is associated
-        // to a serial and a fence, such that when the fence is "ready" we know the operations
-        // have finished.
+        // We track which operations are in flight on the GPU with an increasing serial. Each
+        // submit to a queue is associated to a serial and a fence, such that when the fence is
+        // "ready" we know the operations have finished. Submits to different queues can finish
+        // out of order, the fences are checked in order so a serial is only completed when all
+        // the previous ones are.
         std::queue<std::pair<VkFence, Serial>> mFencesInFlight;
         std::vector<VkFence> mUnusedFences;
         Serial mNextSerial = 1;
@@ -190,14 +210,32 @@ namespace backend { namespace vulkan {
             VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
         };
 
-        CommandPoolAndBuffer GetUnusedCommands();
+        // The compute and transfer queue types use queues of dedicated families when the device
+        // has some so that they run concurrently with graphics, and the graphics queue
+        // otherwise. The states are indexed by queue type and are only used for the types that
+        // have their own queue.
+        struct QueueState {
+            uint32_t family = 0;
+            VkQueue queue = VK_NULL_HANDLE;
+
+            std::vector<CommandPoolAndBuffer> unusedCommands;
+            CommandPoolAndBuffer pendingCommands;
+            std::vector<VkSemaphore> waitSemaphores;
+
+            Serial lastSubmittedSerial = 0;
+            // The serial of the other queues up to which the next submit already waits.
+            std::array<Serial, kNumQueueTypes> waitedSerials = {};
+        };
+
+        QueueState* GetQueueState(nxt::QueueType type);
+
+        CommandPoolAndBuffer GetUnusedCommands(QueueState* queue);
         void RecycleCompletedCommands();
         void FreeCommands(CommandPoolAndBuffer* commands);
 
-        SerialQueue<CommandPoolAndBuffer> mCommandsInFlight;
-        std::vector<CommandPoolAndBuffer> mUnusedCommands;
-        CommandPoolAndBuffer mPendingCommands;
-        std::vector<VkSemaphore> mWaitSemaphores;
+        std::array<QueueState, kNumQueueTypes> mQueues;
+        std::vector<uint32_t> mQueueFamilies;
+        SerialQueue<std::pair<QueueState*, CommandPoolAndBuffer>> mCommandsInFlight;
     };
 
     class Queue : public QueueBase {
@@ -205,8 +243,9 @@ namespace backend { namespace vulkan {
         Queue(QueueBuilder* builder);
         ~Queue();
 
-        // NXT API
-        void Submit(uint32_t numCommands, CommandBuffer* const* commands);
+      private:
+        void SubmitImpl(uint32_t numCommands, CommandBufferBase* const* commands) override;
+        void WaitImpl(Serial signalSerial) override;
     };
 
 }}  // namespace backend::vulkan
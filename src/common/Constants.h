@@ -24,6 +24,7 @@ static constexpr uint32_t kMaxBindingsPerGroup = 16u;
 static constexpr uint32_t kMaxVertexAttributes = 16u;
 static constexpr uint32_t kMaxVertexInputs = 16u;
 static constexpr uint32_t kNumStages = 3;
+static constexpr uint32_t kNumQueueTypes = 3;
 static constexpr uint32_t kMaxColorAttachments = 4u;
 static constexpr uint32_t kTextureRowPitchAlignment = 256u;
 
@@ -0,0 +1,175 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/ThreadPool.h"
+
+#include "common/Assert.h"
+
+#include <algorithm>
+
+namespace {
+
+    // The pool whose iterations the current thread is running, to catch nested ParallelFor.
+    thread_local const ThreadPool* tRunningPool = nullptr;
+
+    // The number of chunks each thread's range is split in. More chunks leave more iterations
+    // to steal at the end of a loop, fewer chunks lock the ranges less often.
+    constexpr uint32_t kChunksPerThread = 16;
+
+}  // anonymous namespace
+
+ThreadPool::ThreadPool(uint32_t threadCount) : mThreadCount(threadCount) {
+    if (mThreadCount == 0) {
+        mThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    mRanges = std::unique_ptr<Range[]>(new Range[mThreadCount]);
+
+    // The last thread index is the one of the thread calling ParallelFor.
+    for (uint32_t i = 0; i + 1 < mThreadCount; ++i) {
+        mWorkers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWorkAvailable.notify_all();
+    for (auto& worker : mWorkers) {
+        worker.join();
+    }
+}
+
+uint32_t ThreadPool::GetThreadCount() const {
+    return mThreadCount;
+}
+
+void ThreadPool::ParallelFor(uint32_t count, const Task& task) {
+    if (count == 0) {
+        return;
+    }
+
+    ASSERT(tRunningPool != this);
+    std::lock_guard<std::mutex> parallelForLock(mParallelForMutex);
+
+    mChunkSize = std::max(count / (mThreadCount * kChunksPerThread), 1u);
+
+    for (uint32_t i = 0; i < mThreadCount; ++i) {
+        std::lock_guard<std::mutex> lock(mRanges[i].mutex);
+        mRanges[i].begin = static_cast<uint32_t>(static_cast<uint64_t>(count) * i / mThreadCount);
+        mRanges[i].end =
+            static_cast<uint32_t>(static_cast<uint64_t>(count) * (i + 1) / mThreadCount);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTask = &task;
+        mBusyWorkers = static_cast<uint32_t>(mWorkers.size());
+        mGeneration++;
+    }
+    mWorkAvailable.notify_all();
+
+    RunIterations(mThreadCount - 1);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWorkDone.wait(lock, [this] { return mBusyWorkers == 0; });
+    mTask = nullptr;
+}
+
+void ThreadPool::WorkerLoop(uint32_t threadIndex) {
+    uint64_t lastGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkAvailable.wait(
+                lock, [&] { return mStopping || mGeneration != lastGeneration; });
+            if (mStopping) {
+                return;
+            }
+            lastGeneration = mGeneration;
+        }
+
+        RunIterations(threadIndex);
+
+        bool lastWorker = false;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            ASSERT(mBusyWorkers > 0);
+            mBusyWorkers--;
+            lastWorker = mBusyWorkers == 0;
+        }
+        if (lastWorker) {
+            mWorkDone.notify_one();
+        }
+    }
+}
+
+void ThreadPool::RunIterations(uint32_t threadIndex) {
+    const Task& task = *mTask;
+    tRunningPool = this;
+    while (true) {
+        uint32_t begin;
+        uint32_t end;
+        if (NextChunk(threadIndex, &begin, &end)) {
+            for (uint32_t index = begin; index < end; ++index) {
+                task(index, threadIndex);
+            }
+        } else if (!Steal(threadIndex)) {
+            // All the ranges are empty, the last chunks are run by the threads that took them.
+            break;
+        }
+    }
+    tRunningPool = nullptr;
+}
+
+bool ThreadPool::NextChunk(uint32_t threadIndex, uint32_t* begin, uint32_t* end) {
+    Range& range = mRanges[threadIndex];
+    std::lock_guard<std::mutex> lock(range.mutex);
+    if (range.begin == range.end) {
+        return false;
+    }
+    *begin = range.begin;
+    *end = range.begin + std::min(range.end - range.begin, mChunkSize);
+    range.begin = *end;
+    return true;
+}
+
+bool ThreadPool::Steal(uint32_t threadIndex) {
+    // Look at the other threads starting with the next one so that thieves spread over victims.
+    for (uint32_t i = 1; i < mThreadCount; ++i) {
+        Range& victim = mRanges[(threadIndex + i) % mThreadCount];
+
+        uint32_t begin;
+        uint32_t end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.begin == victim.end) {
+                continue;
+            }
+            end = victim.end;
+            begin = victim.begin + (victim.end - victim.begin) / 2;
+            victim.end = begin;
+        }
+
+        // Only this thread adds iterations to its own empty range, others can only look at it.
+        Range& range = mRanges[threadIndex];
+        std::lock_guard<std::mutex> lock(range.mutex);
+        ASSERT(range.begin == range.end);
+        range.begin = begin;
+        range.end = end;
+        return true;
+    }
+    return false;
+}
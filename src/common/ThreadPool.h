@@ -0,0 +1,80 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMMON_THREADPOOL_H_
+#define COMMON_THREADPOOL_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A pool of threads running the iterations of parallel loops. The thread calling ParallelFor is
+// one of the threads of the pool so a pool of N threads has N - 1 worker threads.
+//
+// Each thread starts with a contiguous part of the iterations and takes them from it in chunks, so
+// that its range is locked once per chunk rather than once per iteration. Threads that run out of
+// iterations steal the second half of the remaining iterations of another thread, which balances
+// the load when iterations take very different times.
+class ThreadPool {
+  public:
+    // The index of the iteration, and the index in [0, GetThreadCount()) of the thread running
+    // it, which can be used to index per-thread scratch data.
+    using Task = std::function<void(uint32_t index, uint32_t threadIndex)>;
+
+    // A threadCount of 0 uses one thread per hardware thread.
+    explicit ThreadPool(uint32_t threadCount = 0);
+    ~ThreadPool();
+
+    uint32_t GetThreadCount() const;
+
+    // Runs task for all indices in [0, count) and returns once they are all done. Calls to
+    // ParallelFor from several threads are run one after the other. The task must not call
+    // ParallelFor on the same pool as that would deadlock.
+    void ParallelFor(uint32_t count, const Task& task);
+
+  private:
+    // The iterations [begin, end) left to a thread.
+    struct Range {
+        std::mutex mutex;
+        uint32_t begin = 0;
+        uint32_t end = 0;
+    };
+
+    void WorkerLoop(uint32_t threadIndex);
+    void RunIterations(uint32_t threadIndex);
+    bool NextChunk(uint32_t threadIndex, uint32_t* begin, uint32_t* end);
+    bool Steal(uint32_t threadIndex);
+
+    uint32_t mThreadCount;
+    std::unique_ptr<Range[]> mRanges;
+    uint32_t mChunkSize = 1;
+    std::vector<std::thread> mWorkers;
+
+    std::mutex mParallelForMutex;
+
+    // Protects the members below, used to start the workers and to wait for them.
+    std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mWorkDone;
+    const Task* mTask = nullptr;
+    uint64_t mGeneration = 0;
+    uint32_t mBusyWorkers = 0;
+    bool mStopping = false;
+};
+
+#endif  // COMMON_THREADPOOL_H_
@@ -0,0 +1,183 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+std::atomic<bool> gTracingEnabled(false);
+
+namespace {
+
+    // One more slot than the number of events exported so that the thread can record an event
+    // while the oldest exported one is being read.
+    constexpr uint64_t kTraceSlotCount = kTraceRingBufferSize + 1;
+
+    // The events of a thread. Only the thread writes to it, readers use mWriteCount to know
+    // which events are complete and which ones might have been overwritten while reading them.
+    class TraceRingBuffer {
+      public:
+        TraceRingBuffer(uint32_t threadIndex) : mThreadIndex(threadIndex) {
+        }
+
+        void Record(const TraceEvent& event) {
+            uint64_t writeCount = mWriteCount.load(std::memory_order_relaxed);
+            mEvents[writeCount % kTraceSlotCount] = event;
+            mWriteCount.store(writeCount + 1, std::memory_order_release);
+        }
+
+        void Clear() {
+            mClearCount.store(mWriteCount.load(std::memory_order_acquire),
+                              std::memory_order_relaxed);
+        }
+
+        void AppendEvents(std::vector<TraceEvent>* events) const {
+            uint64_t end = mWriteCount.load(std::memory_order_acquire);
+            uint64_t begin = end > kTraceRingBufferSize ? end - kTraceRingBufferSize : 0;
+            begin = std::max(begin, mClearCount.load(std::memory_order_relaxed));
+
+            size_t firstEvent = events->size();
+            for (uint64_t i = begin; i < end; ++i) {
+                events->push_back(mEvents[i % kTraceSlotCount]);
+            }
+
+            // Drop the events that the thread could have started overwriting while they were
+            // copied, the slot of event i is written again when event i + kTraceSlotCount is
+            // recorded.
+            uint64_t newEnd = mWriteCount.load(std::memory_order_acquire);
+            if (newEnd >= begin + kTraceSlotCount) {
+                uint64_t overwrittenCount =
+                    std::min(end - begin, newEnd - kTraceSlotCount - begin + 1);
+                events->erase(events->begin() + firstEvent,
+                              events->begin() + firstEvent + overwrittenCount);
+            }
+        }
+
+        uint32_t GetThreadIndex() const {
+            return mThreadIndex;
+        }
+
+      private:
+        uint32_t mThreadIndex;
+        std::atomic<uint64_t> mWriteCount{0};
+        std::atomic<uint64_t> mClearCount{0};
+        TraceEvent mEvents[kTraceSlotCount];
+    };
+
+    // Buffers are never destroyed so that the events of threads that exited can be exported.
+    std::mutex sBuffersMutex;
+    std::vector<std::unique_ptr<TraceRingBuffer>> sBuffers;
+
+    // Buffers are only created for threads that record events.
+    TraceRingBuffer* GetThreadBuffer() {
+        thread_local TraceRingBuffer* threadBuffer = nullptr;
+        if (threadBuffer == nullptr) {
+            std::lock_guard<std::mutex> lock(sBuffersMutex);
+            sBuffers.emplace_back(new TraceRingBuffer(static_cast<uint32_t>(sBuffers.size())));
+            threadBuffer = sBuffers.back().get();
+        }
+        return threadBuffer;
+    }
+
+    void AppendJSONString(std::ostringstream* out, const char* str) {
+        *out << '"';
+        for (const char* c = str; *c != '\0'; ++c) {
+            if (*c == '"' || *c == '\\') {
+                *out << '\\' << *c;
+            } else if (static_cast<unsigned char>(*c) < 0x20) {
+                *out << ' ';
+            } else {
+                *out << *c;
+            }
+        }
+        *out << '"';
+    }
+
+}  // anonymous namespace
+
+void SetTracingEnabled(bool enabled) {
+    gTracingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void ClearTraceEvents() {
+    std::lock_guard<std::mutex> lock(sBuffersMutex);
+    for (auto& buffer : sBuffers) {
+        buffer->Clear();
+    }
+}
+
+std::string GetTraceEventsJSON() {
+    std::ostringstream out;
+    out << "{\"traceEvents\": [";
+
+    std::lock_guard<std::mutex> lock(sBuffersMutex);
+    bool first = true;
+    std::vector<TraceEvent> events;
+    for (auto& buffer : sBuffers) {
+        events.clear();
+        buffer->AppendEvents(&events);
+
+        for (const TraceEvent& event : events) {
+            out << (first ? "\n" : ",\n");
+            first = false;
+
+            // Complete events, with timestamps in microseconds.
+            out << "{\"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->GetThreadIndex()
+                << ", \"cat\": ";
+            AppendJSONString(&out, event.category);
+            out << ", \"name\": ";
+            AppendJSONString(&out, event.name);
+            out << ", \"ts\": " << static_cast<double>(event.startNs) / 1000.0
+                << ", \"dur\": " << static_cast<double>(event.durationNs) / 1000.0;
+            if (event.detail != nullptr) {
+                out << ", \"args\": {\"detail\": ";
+                AppendJSONString(&out, event.detail);
+                out << "}";
+            }
+            out << "}";
+        }
+    }
+
+    out << "\n]}\n";
+    return out.str();
+}
+
+bool WriteTraceEventsJSON(const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    std::string json = GetTraceEventsJSON();
+    bool success = fwrite(json.data(), 1, json.size(), file) == json.size();
+    success = fclose(file) == 0 && success;
+    return success;
+}
+
+uint64_t GetTraceTimestampNs() {
+    static const auto sStartTime = std::chrono::steady_clock::now();
+    auto now = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - sStartTime).count());
+}
+
+void RecordTraceEvent(const TraceEvent& event) {
+    GetThreadBuffer()->Record(event);
+}
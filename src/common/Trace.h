@@ -0,0 +1,101 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMMON_TRACE_H_
+#define COMMON_TRACE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Tracing records the time spent in scopes marked with NXT_TRACE_EVENT and exports them in the
+// JSON format of chrome://tracing. Tracing is off by default and can be toggled at any time, when
+// it is off a trace event costs a relaxed atomic load.
+//
+// Each thread records its events in its own ring buffer of kTraceRingBufferSize events, so the
+// oldest events of a thread are dropped when it records more. Buffers are kept after their thread
+// exits so that its events can still be exported.
+//
+// The category, name and detail of events must be strings that live as long as the process, like
+// string literals, since only their pointers are recorded.
+
+static constexpr size_t kTraceRingBufferSize = 8192;
+
+struct TraceEvent {
+    const char* category;
+    const char* name;
+    // Additional information shown in the arguments of the event, or nullptr.
+    const char* detail;
+    // Relative to the first trace timestamp of the process.
+    uint64_t startNs;
+    uint64_t durationNs;
+};
+
+extern std::atomic<bool> gTracingEnabled;
+
+inline bool IsTracingEnabled() {
+    return gTracingEnabled.load(std::memory_order_relaxed);
+}
+
+void SetTracingEnabled(bool enabled);
+
+// Removes the events of all threads.
+void ClearTraceEvents();
+
+// Returns the events recorded by all threads in the chrome://tracing JSON format. Events being
+// recorded while exporting might be missing.
+std::string GetTraceEventsJSON();
+bool WriteTraceEventsJSON(const char* path);
+
+uint64_t GetTraceTimestampNs();
+void RecordTraceEvent(const TraceEvent& event);
+
+class ScopedTraceEvent {
+  public:
+    ScopedTraceEvent(const char* category, const char* name, const char* detail = nullptr)
+        : mCategory(category), mName(name), mDetail(detail), mEnabled(IsTracingEnabled()) {
+        if (mEnabled) {
+            mStartNs = GetTraceTimestampNs();
+        }
+    }
+
+    ~ScopedTraceEvent() {
+        if (mEnabled) {
+            uint64_t endNs = GetTraceTimestampNs();
+            RecordTraceEvent({mCategory, mName, mDetail, mStartNs, endNs - mStartNs});
+        }
+    }
+
+    ScopedTraceEvent(const ScopedTraceEvent& other) = delete;
+    ScopedTraceEvent& operator=(const ScopedTraceEvent& other) = delete;
+
+  private:
+    const char* mCategory;
+    const char* mName;
+    const char* mDetail;
+    bool mEnabled;
+    uint64_t mStartNs = 0;
+};
+
+#define NXT_TRACE_CONCAT_HELPER(a, b) a##b
+#define NXT_TRACE_CONCAT(a, b) NXT_TRACE_CONCAT_HELPER(a, b)
+
+// Record the time from this statement to the end of the scope.
+#define NXT_TRACE_EVENT(category, name) \
+    ScopedTraceEvent NXT_TRACE_CONCAT(traceEvent, __LINE__)(category, name)
+#define NXT_TRACE_EVENT_DETAIL(category, name, detail) \
+    ScopedTraceEvent NXT_TRACE_CONCAT(traceEvent, __LINE__)(category, name, detail)
+
+#endif  // COMMON_TRACE_H_
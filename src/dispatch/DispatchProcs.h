@@ -0,0 +1,35 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DISPATCH_DISPATCHPROCS_H_
+#define DISPATCH_DISPATCHPROCS_H_
+
+#include "nxt/nxt.h"
+
+namespace nxt { namespace dispatch {
+
+    // Returns procs that forward each call to the procs of the device the object comes from.
+    // Given to nxtSetProcs they let the C and C++ APIs use devices of different backends, or
+    // several wire clients, in the same process. Each device and its objects can be used from a
+    // different thread, with the same restrictions as when calling their procs directly.
+    nxtProcTable GetDispatchProcs();
+
+    // Returns a handle for the device usable with the dispatch procs, whose calls and the calls of
+    // its objects go to the given procs. Takes over the reference to the device. The procs are
+    // copied and kept alive until the device and all its objects are released.
+    nxtDevice WrapDevice(nxtDevice device, const nxtProcTable& procs);
+
+}}  // namespace nxt::dispatch
+
+#endif  // DISPATCH_DISPATCHPROCS_H_
@@ -65,6 +65,11 @@ typedef struct {
 } nxtWSIContextMetal;
 #endif
 
+#ifdef NXT_ENABLE_BACKEND_NULL
+typedef struct {
+} nxtWSIContextNull;
+#endif
+
 #ifdef NXT_ENABLE_BACKEND_OPENGL
 typedef struct {
 } nxtWSIContextGL;
@@ -0,0 +1,107 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "profiling/LatencyHistogram.h"
+
+#include "common/Assert.h"
+#include "common/Math.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace nxt { namespace profiling {
+
+    LatencyHistogram::LatencyHistogram() {
+        Reset();
+    }
+
+    void LatencyHistogram::Record(uint64_t latencyNs) {
+        mCount.fetch_add(1, std::memory_order_relaxed);
+        mTotalNs.fetch_add(latencyNs, std::memory_order_relaxed);
+        mBuckets[GetBucket(latencyNs)].fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t maxNs = mMaxNs.load(std::memory_order_relaxed);
+        while (latencyNs > maxNs &&
+               !mMaxNs.compare_exchange_weak(maxNs, latencyNs, std::memory_order_relaxed)) {
+        }
+    }
+
+    void LatencyHistogram::Reset() {
+        mCount.store(0, std::memory_order_relaxed);
+        mTotalNs.store(0, std::memory_order_relaxed);
+        mMaxNs.store(0, std::memory_order_relaxed);
+        for (auto& bucket : mBuckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t LatencyHistogram::GetCount() const {
+        return mCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t LatencyHistogram::GetTotalNs() const {
+        return mTotalNs.load(std::memory_order_relaxed);
+    }
+
+    uint64_t LatencyHistogram::GetMaxNs() const {
+        return mMaxNs.load(std::memory_order_relaxed);
+    }
+
+    uint64_t LatencyHistogram::GetBucketCount(size_t bucket) const {
+        ASSERT(bucket < kLatencyBucketCount);
+        return mBuckets[bucket].load(std::memory_order_relaxed);
+    }
+
+    uint64_t LatencyHistogram::GetPercentileNs(double percentile) const {
+        ASSERT(percentile >= 0.0 && percentile <= 100.0);
+
+        uint64_t count = 0;
+        for (const auto& bucket : mBuckets) {
+            count += bucket.load(std::memory_order_relaxed);
+        }
+        if (count == 0) {
+            return 0;
+        }
+
+        // The rank of the percentile, starting at 1 so that the 0th percentile is the minimum.
+        uint64_t rank =
+            std::max(uint64_t(1), static_cast<uint64_t>(percentile / 100.0 * count + 0.5));
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kLatencyBucketCount; ++i) {
+            seen += mBuckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return std::min(GetBucketUpperBoundNs(i), GetMaxNs());
+            }
+        }
+        return GetMaxNs();
+    }
+
+    size_t LatencyHistogram::GetBucket(uint64_t latencyNs) {
+        if (latencyNs == 0) {
+            return 0;
+        }
+        uint64_t clamped = std::min(latencyNs, uint64_t(std::numeric_limits<uint32_t>::max()));
+        return Log2(static_cast<uint32_t>(clamped)) + 1;
+    }
+
+    uint64_t LatencyHistogram::GetBucketUpperBoundNs(size_t bucket) {
+        ASSERT(bucket < kLatencyBucketCount);
+        if (bucket == kLatencyBucketCount - 1) {
+            return std::numeric_limits<uint64_t>::max();
+        }
+        return (uint64_t(1) << bucket) - 1;
+    }
+
+}}  // namespace nxt::profiling
@@ -0,0 +1,59 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PROFILING_LATENCYHISTOGRAM_H_
+#define PROFILING_LATENCYHISTOGRAM_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace nxt { namespace profiling {
+
+    // Bucket 0 holds latencies of 0ns and bucket i latencies in [2^(i-1), 2^i) nanoseconds. The
+    // last bucket also holds all latencies above 2^31ns, about 2 seconds.
+    static constexpr size_t kLatencyBucketCount = 33;
+
+    // A histogram of latencies that can be recorded from several threads without locks. Each
+    // record is a few relaxed atomic additions, so reading the histogram while it is recorded to
+    // can give a slightly inconsistent view.
+    class LatencyHistogram {
+      public:
+        LatencyHistogram();
+
+        void Record(uint64_t latencyNs);
+        void Reset();
+
+        uint64_t GetCount() const;
+        uint64_t GetTotalNs() const;
+        uint64_t GetMaxNs() const;
+        uint64_t GetBucketCount(size_t bucket) const;
+
+        // Returns the upper bound of the bucket containing the percentile, in [0, 100], of the
+        // recorded latencies, capped to the max latency. Returns 0 if nothing was recorded.
+        uint64_t GetPercentileNs(double percentile) const;
+
+        static size_t GetBucket(uint64_t latencyNs);
+        static uint64_t GetBucketUpperBoundNs(size_t bucket);
+
+      private:
+        std::atomic<uint64_t> mCount;
+        std::atomic<uint64_t> mTotalNs;
+        std::atomic<uint64_t> mMaxNs;
+        std::atomic<uint64_t> mBuckets[kLatencyBucketCount];
+    };
+
+}}  // namespace nxt::profiling
+
+#endif  // PROFILING_LATENCYHISTOGRAM_H_
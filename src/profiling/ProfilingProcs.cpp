@@ -0,0 +1,104 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "profiling/ProfilingProcs.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+// GetProfilingProcs and the entry point accessors are in the generated
+// ProfilingProcTable_autogen.cpp
+
+namespace nxt { namespace profiling {
+
+    namespace {
+
+        // Returns the entry points that were called, the one with the most total time first.
+        std::vector<size_t> GetCalledEntryPoints() {
+            std::vector<size_t> entryPoints;
+            for (size_t i = 0; i < GetEntryPointCount(); ++i) {
+                if (GetEntryPointHistogram(i)->GetCount() != 0) {
+                    entryPoints.push_back(i);
+                }
+            }
+
+            std::stable_sort(entryPoints.begin(), entryPoints.end(), [](size_t a, size_t b) {
+                return GetEntryPointHistogram(a)->GetTotalNs() >
+                       GetEntryPointHistogram(b)->GetTotalNs();
+            });
+            return entryPoints;
+        }
+
+    }  // anonymous namespace
+
+    void ResetProfilingData() {
+        for (size_t i = 0; i < GetEntryPointCount(); ++i) {
+            GetEntryPointHistogram(i)->Reset();
+        }
+    }
+
+    std::string DumpProfilingDataText() {
+        std::ostringstream out;
+        out << std::left << std::setw(48) << "entry point" << std::right << std::setw(10)
+            << "calls" << std::setw(12) << "total ms" << std::setw(10) << "mean us"
+            << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(10)
+            << "max us" << "\n";
+
+        out << std::fixed << std::setprecision(3);
+        for (size_t entryPoint : GetCalledEntryPoints()) {
+            const LatencyHistogram* histogram = GetEntryPointHistogram(entryPoint);
+            uint64_t count = histogram->GetCount();
+            double totalNs = static_cast<double>(histogram->GetTotalNs());
+
+            out << std::left << std::setw(48) << GetEntryPointName(entryPoint) << std::right
+                << std::setw(10) << count << std::setw(12) << totalNs / 1000000.0
+                << std::setw(10) << totalNs / count / 1000.0 << std::setw(10)
+                << histogram->GetPercentileNs(50.0) / 1000.0 << std::setw(10)
+                << histogram->GetPercentileNs(99.0) / 1000.0 << std::setw(10)
+                << histogram->GetMaxNs() / 1000.0 << "\n";
+        }
+        return out.str();
+    }
+
+    std::string DumpProfilingDataJSON() {
+        std::ostringstream out;
+        out << "{\"entryPoints\": [";
+
+        bool first = true;
+        for (size_t entryPoint : GetCalledEntryPoints()) {
+            const LatencyHistogram* histogram = GetEntryPointHistogram(entryPoint);
+
+            out << (first ? "\n" : ",\n");
+            first = false;
+
+            // Entry point names are C identifiers so they don't need escaping.
+            out << "  {\"name\": \"" << GetEntryPointName(entryPoint) << "\""
+                << ", \"count\": " << histogram->GetCount()
+                << ", \"totalNs\": " << histogram->GetTotalNs()
+                << ", \"p50Ns\": " << histogram->GetPercentileNs(50.0)
+                << ", \"p99Ns\": " << histogram->GetPercentileNs(99.0)
+                << ", \"maxNs\": " << histogram->GetMaxNs() << ", \"buckets\": [";
+            for (size_t i = 0; i < kLatencyBucketCount; ++i) {
+                out << (i == 0 ? "" : ", ") << histogram->GetBucketCount(i);
+            }
+            out << "]}";
+        }
+
+        out << "\n]}\n";
+        return out.str();
+    }
+
+}}  // namespace nxt::profiling
@@ -0,0 +1,47 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PROFILING_PROFILINGPROCS_H_
+#define PROFILING_PROFILINGPROCS_H_
+
+#include "profiling/LatencyHistogram.h"
+
+#include "nxt/nxt.h"
+
+#include <string>
+
+namespace nxt { namespace profiling {
+
+    // Returns procs that forward to the given procs and record the latency of each call in a
+    // histogram per entry point. The result can be given to nxtSetProcs in front of a backend or
+    // the wire client. There is a single profiling layer per process: calling this again makes
+    // the profiling procs forward to the new procs, so it must not race with calls to them.
+    nxtProcTable GetProfilingProcs(const nxtProcTable& procs);
+
+    // Clears the histograms of all entry points.
+    void ResetProfilingData();
+
+    // Summaries of the entry points that were called, the one with the most total time first.
+    std::string DumpProfilingDataText();
+    // Also contains the buckets of the histograms, see LatencyHistogram for their bounds.
+    std::string DumpProfilingDataJSON();
+
+    // Entry points are indexed in the order of the proc table.
+    size_t GetEntryPointCount();
+    const char* GetEntryPointName(size_t entryPoint);
+    LatencyHistogram* GetEntryPointHistogram(size_t entryPoint);
+
+}}  // namespace nxt::profiling
+
+#endif  // PROFILING_PROFILINGPROCS_H_
@@ -12,9 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "tests/NXTTest.h"
+
 #include <gtest/gtest.h>
 
 int main(int argc, char** argv) {
+    if (!InitNXTEnd2EndTestEnvironment(argc, argv)) {
+        return 1;
+    }
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
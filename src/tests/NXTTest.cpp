@@ -21,6 +21,8 @@
 #include "utils/NXTHelpers.h"
 #include "utils/SystemUtils.h"
 
+#include <bitset>
+#include <cstring>
 #include <iostream>
 #include "GLFW/glfw3.h"
 namespace {
@@ -31,6 +33,8 @@ namespace {
                 return utils::BackendType::D3D12;
             case MetalBackend:
                 return utils::BackendType::Metal;
+            case NullBackend:
+                return utils::BackendType::Null;
             case OpenGLBackend:
                 return utils::BackendType::OpenGL;
             case VulkanBackend:
@@ -46,6 +50,8 @@ namespace {
                 return "D3D12";
             case MetalBackend:
                 return "Metal";
+            case NullBackend:
+                return "Null";
             case OpenGLBackend:
                 return "OpenGL";
             case VulkanBackend:
@@ -55,6 +61,9 @@ namespace {
         }
     }
 
+    // The backends selected with --backend, none means all of them.
+    std::bitset<NumBackendTypes> selectedBackends;
+
     // Windows don't usually like to be bound to one API than the other, for example switching
     // from Vulkan to OpenGL causes crashes on some drivers. Because of this, we lazily created
     // a window for each backing API.
@@ -114,6 +123,10 @@ bool NXTTest::IsMetal() const {
     return GetParam() == MetalBackend;
 }
 
+bool NXTTest::IsNull() const {
+    return GetParam() == NullBackend;
+}
+
 bool NXTTest::IsOpenGL() const {
     return GetParam() == OpenGLBackend;
 }
@@ -126,10 +139,13 @@ void NXTTest::SetUp() {
     mBinding = utils::CreateBinding(ParamToBackendType(GetParam()));
     NXT_ASSERT(mBinding != nullptr);
 
-    GLFWwindow* testWindow = GetWindowForBackend(mBinding, GetParam());
-    NXT_ASSERT(testWindow != nullptr);
+    // The null backend doesn't need a window so the tests can run headless.
+    if (!IsNull()) {
+        GLFWwindow* testWindow = GetWindowForBackend(mBinding, GetParam());
+        NXT_ASSERT(testWindow != nullptr);
 
-    mBinding->SetWindow(testWindow);
+        mBinding->SetWindow(testWindow);
+    }
 
     nxtDevice backendDevice;
     nxtProcTable backendProcs;
@@ -343,6 +359,40 @@ std::ostream &operator<<(std::ostream& stream, BackendType backend) {
     return stream << ParamName(backend);
 }
 
+bool InitNXTEnd2EndTestEnvironment(int argc, char** argv) {
+    const char kBackendFlag[] = "--backend=";
+    const size_t kBackendFlagLength = sizeof(kBackendFlag) - 1;
+
+    const struct {
+        const char* name;
+        BackendType type;
+    } kBackendNames[] = {
+        {"d3d12", D3D12Backend},   {"metal", MetalBackend},   {"null", NullBackend},
+        {"opengl", OpenGLBackend}, {"vulkan", VulkanBackend},
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], kBackendFlag, kBackendFlagLength) != 0) {
+            continue;
+        }
+
+        const char* name = argv[i] + kBackendFlagLength;
+        bool found = false;
+        for (const auto& backendName : kBackendNames) {
+            if (strcmp(name, backendName.name) == 0) {
+                selectedBackends.set(backendName.type);
+                found = true;
+            }
+        }
+        if (!found) {
+            std::cerr << "--backend expects a backend name (d3d12, metal, null, opengl, vulkan)"
+                      << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 namespace detail {
     bool IsBackendAvailable(BackendType type) {
         switch (type) {
@@ -352,6 +402,9 @@ namespace detail {
             #if defined(NXT_ENABLE_BACKEND_METAL)
                 case MetalBackend:
             #endif
+            #if defined(NXT_ENABLE_BACKEND_NULL)
+                case NullBackend:
+            #endif
             #if defined(NXT_ENABLE_BACKEND_OPENGL)
                 case OpenGLBackend:
             #endif
@@ -369,7 +422,8 @@ namespace detail {
         std::vector<BackendType> backends;
 
         for (size_t i = 0; i < numParams; ++i) {
-            if (IsBackendAvailable(types[i])) {
+            if (IsBackendAvailable(types[i]) &&
+                (selectedBackends.none() || selectedBackends[types[i]])) {
                 backends.push_back(types[i]);
             }
         }
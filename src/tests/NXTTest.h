@@ -48,12 +48,20 @@ std::ostream& operator<< (std::ostream& stream, const RGBA8& color);
 enum BackendType {
     D3D12Backend,
     MetalBackend,
+    NullBackend,
     OpenGLBackend,
     VulkanBackend,
     NumBackendTypes,
 };
 std::ostream &operator<<(std::ostream& stream, BackendType backend);
 
+// Parses the end2end specific command line arguments. --backend=NAME, that can be repeated,
+// restricts the tests to the given backends, for example --backend=null runs them on the CPU
+// without a GPU or a window. Must be called before testing::InitGoogleTest because the backends
+// of NXT_INSTANTIATE_TEST are filtered when the tests are registered. Returns false if the
+// arguments are invalid.
+bool InitNXTEnd2EndTestEnvironment(int argc, char** argv);
+
 namespace utils {
     class BackendBinding;
 }
@@ -71,6 +79,7 @@ class NXTTest : public ::testing::TestWithParam<BackendType> {
 
         bool IsD3D12() const;
         bool IsMetal() const;
+        bool IsNull() const;
         bool IsOpenGL() const;
         bool IsVulkan() const;
 
@@ -0,0 +1,205 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the cost per command of going over command streams of 1M commands, by executing them
+// with VisitCommands and with a switch like the backends, skipping them with SkipCommand, and
+// freeing them with FreeCommands. Streams with only plain data are measured separately from
+// streams with Ref<>, since only the latter need to be iterated to be freed.
+
+#include "backend/BindGroup.h"
+#include "backend/Buffer.h"
+#include "backend/Commands.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <new>
+
+using namespace backend;
+
+namespace {
+
+    constexpr unsigned int kDefaultIterations = 20;
+    // The streams repeat groups of kCommandsPerDraw commands ending with a draw.
+    constexpr uint32_t kDraws = 200000;
+    constexpr uint32_t kCommandsPerDraw = 5;
+    constexpr uint32_t kCommands = kDraws * kCommandsPerDraw;
+
+    // The sum of the command members keeps the work from being optimized out.
+    uint64_t sum = 0;
+
+    void AllocateDraws(CommandAllocator* allocator, bool withRefs) {
+        for (uint32_t i = 0; i < kDraws; ++i) {
+            if (withRefs) {
+                SetBindGroupCmd* bindGroup =
+                    allocator->Allocate<SetBindGroupCmd>(Command::SetBindGroup);
+                new (bindGroup) SetBindGroupCmd;
+                bindGroup->index = i % kMaxBindGroups;
+
+                SetVertexBuffersCmd* vertexBuffers =
+                    allocator->Allocate<SetVertexBuffersCmd>(Command::SetVertexBuffers);
+                new (vertexBuffers) SetVertexBuffersCmd;
+                vertexBuffers->startSlot = 0;
+                vertexBuffers->count = 2;
+                Ref<BufferBase>* buffers = allocator->AllocateData<Ref<BufferBase>>(2);
+                uint32_t* offsets = allocator->AllocateData<uint32_t>(2);
+                for (uint32_t j = 0; j < 2; ++j) {
+                    new (&buffers[j]) Ref<BufferBase>();
+                    offsets[j] = i;
+                }
+            } else {
+                SetBlendColorCmd* blendColor =
+                    allocator->Allocate<SetBlendColorCmd>(Command::SetBlendColor);
+                blendColor->r = blendColor->g = blendColor->b = blendColor->a = 1.0f;
+
+                DrawElementsCmd* drawElements =
+                    allocator->Allocate<DrawElementsCmd>(Command::DrawElements);
+                drawElements->indexCount = 3;
+                drawElements->instanceCount = 1;
+                drawElements->firstIndex = i;
+                drawElements->firstInstance = 0;
+            }
+
+            SetPushConstantsCmd* pushConstants =
+                allocator->Allocate<SetPushConstantsCmd>(Command::SetPushConstants);
+            pushConstants->stages = nxt::ShaderStageBit::Vertex;
+            pushConstants->offset = 0;
+            pushConstants->count = 4;
+            uint32_t* values = allocator->AllocateData<uint32_t>(4);
+            for (uint32_t j = 0; j < 4; ++j) {
+                values[j] = i + j;
+            }
+
+            SetStencilReferenceCmd* stencil =
+                allocator->Allocate<SetStencilReferenceCmd>(Command::SetStencilReference);
+            stencil->reference = i;
+
+            DrawArraysCmd* draw = allocator->Allocate<DrawArraysCmd>(Command::DrawArrays);
+            draw->vertexCount = 3;
+            draw->instanceCount = 1;
+            draw->firstVertex = i;
+            draw->firstInstance = 0;
+        }
+    }
+
+    struct SumVisitor : CommandVisitor {
+        void OnDrawArrays(DrawArraysCmd* draw) {
+            sum += draw->firstVertex;
+        }
+        void OnSetPushConstants(SetPushConstantsCmd* cmd, uint32_t* values) {
+            sum += values[cmd->count - 1];
+        }
+        void OnSetStencilReference(SetStencilReferenceCmd* cmd) {
+            sum += cmd->reference;
+        }
+    };
+
+    // The same work as SumVisitor written with a switch like most of the backends.
+    void SumWithSwitch(CommandIterator* commands) {
+        Command type;
+        while (commands->NextCommandId(&type)) {
+            switch (type) {
+                case Command::DrawArrays: {
+                    DrawArraysCmd* draw = commands->NextCommand<DrawArraysCmd>();
+                    sum += draw->firstVertex;
+                } break;
+
+                case Command::SetPushConstants: {
+                    SetPushConstantsCmd* cmd = commands->NextCommand<SetPushConstantsCmd>();
+                    uint32_t* values = commands->NextData<uint32_t>(cmd->count);
+                    sum += values[cmd->count - 1];
+                } break;
+
+                case Command::SetStencilReference: {
+                    SetStencilReferenceCmd* cmd = commands->NextCommand<SetStencilReferenceCmd>();
+                    sum += cmd->reference;
+                } break;
+
+                default:
+                    SkipCommand(commands, type);
+                    break;
+            }
+        }
+    }
+
+    void Skip(CommandIterator* commands) {
+        Command type;
+        while (commands->NextCommandId(&type)) {
+            SkipCommand(commands, type);
+        }
+    }
+
+    struct Timings {
+        double visitNs = 0;
+        double switchNs = 0;
+        double skipNs = 0;
+        double freeNs = 0;
+    };
+
+    template <typename F>
+    double MeasureNs(F f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        return static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+
+    // Recording isn't measured, each iteration goes over a new stream like a backend would for
+    // each new command buffer.
+    Timings Measure(unsigned int iterations, bool withRefs) {
+        Timings timings;
+        for (unsigned int i = 0; i < iterations; ++i) {
+            CommandAllocator allocator;
+            AllocateDraws(&allocator, withRefs);
+            CommandIterator commands(std::move(allocator));
+
+            SumVisitor visitor;
+            timings.visitNs += MeasureNs([&]() { VisitCommands(&commands, &visitor); });
+            commands.Reset();
+            timings.switchNs += MeasureNs([&]() { SumWithSwitch(&commands); });
+            commands.Reset();
+            timings.skipNs += MeasureNs([&]() { Skip(&commands); });
+            commands.Reset();
+            timings.freeNs += MeasureNs([&]() { FreeCommands(&commands); });
+        }
+
+        double count = static_cast<double>(iterations) * kCommands;
+        timings.visitNs /= count;
+        timings.switchNs /= count;
+        timings.skipNs /= count;
+        timings.freeNs /= count;
+        return timings;
+    }
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+    unsigned int iterations = kDefaultIterations;
+    if (argc > 1) {
+        iterations = static_cast<unsigned int>(std::strtoul(argv[1], nullptr, 10));
+    }
+
+    for (bool withRefs : {false, true}) {
+        Timings timings = Measure(iterations, withRefs);
+        printf("%u commands %s Ref<>:\n", kCommands, withRefs ? "with" : "without");
+        printf("    VisitCommands: %.2f ns/command\n", timings.visitNs);
+        printf("    switch: %.2f ns/command\n", timings.switchNs);
+        printf("    SkipCommand: %.2f ns/command\n", timings.skipNs);
+        printf("    FreeCommands: %.2f ns/command\n", timings.freeNs);
+    }
+    printf("(sum %llu)\n", static_cast<unsigned long long>(sum));
+    return 0;
+}
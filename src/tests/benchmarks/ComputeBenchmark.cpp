@@ -0,0 +1,203 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures how the compute shaders run on the CPU by the null backend scale with the number of
+// threads, using the particle update shader of the ComputeBoids sample.
+
+#include "backend/null/ShaderProgram.h"
+#include "common/ThreadPool.h"
+
+#include <shaderc/shaderc.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    constexpr unsigned int kDefaultIterations = 5;
+    constexpr uint32_t kParticleCount = 2048;
+    constexpr uint32_t kLocalSize = 64;
+
+    const char* kShader = R"(
+        #version 450
+
+        layout(local_size_x = 64) in;
+
+        struct Particle {
+            vec2 pos;
+            vec2 vel;
+        };
+
+        layout(std140, set = 0, binding = 0) uniform SimParams {
+            float deltaT;
+            float rule1Distance;
+            float rule2Distance;
+            float rule3Distance;
+            float rule1Scale;
+            float rule2Scale;
+            float rule3Scale;
+            int particleCount;
+        } params;
+
+        layout(std140, set = 0, binding = 1) buffer ParticlesA {
+            Particle particles[];
+        } particlesA;
+
+        layout(std140, set = 0, binding = 2) buffer ParticlesB {
+            Particle particles[];
+        } particlesB;
+
+        void main() {
+            uint index = gl_GlobalInvocationID.x;
+            if (index >= params.particleCount) { return; }
+
+            vec2 vPos = particlesA.particles[index].pos;
+            vec2 vVel = particlesA.particles[index].vel;
+
+            vec2 cMass = vec2(0.0, 0.0);
+            vec2 cVel = vec2(0.0, 0.0);
+            vec2 colVel = vec2(0.0, 0.0);
+            int cMassCount = 0;
+            int cVelCount = 0;
+
+            for (int i = 0; i < params.particleCount; ++i) {
+                if (i == index) { continue; }
+                vec2 pos = particlesA.particles[i].pos;
+                vec2 vel = particlesA.particles[i].vel;
+
+                if (distance(pos, vPos) < params.rule1Distance) {
+                    cMass += pos;
+                    cMassCount++;
+                }
+                if (distance(pos, vPos) < params.rule2Distance) {
+                    colVel -= (pos - vPos);
+                }
+                if (distance(pos, vPos) < params.rule3Distance) {
+                    cVel += vel;
+                    cVelCount++;
+                }
+            }
+            if (cMassCount > 0) {
+                cMass = cMass / cMassCount - vPos;
+            }
+            if (cVelCount > 0) {
+                cVel = cVel / cVelCount;
+            }
+
+            vVel += cMass * params.rule1Scale + colVel * params.rule2Scale +
+                    cVel * params.rule3Scale;
+            vVel = normalize(vVel) * clamp(length(vVel), 0.0, 0.1);
+            vPos += vVel * params.deltaT;
+
+            if (vPos.x < -1.0) vPos.x = 1.0;
+            if (vPos.x > 1.0) vPos.x = -1.0;
+            if (vPos.y < -1.0) vPos.y = 1.0;
+            if (vPos.y > 1.0) vPos.y = -1.0;
+
+            particlesB.particles[index].pos = vPos;
+            particlesB.particles[index].vel = vVel;
+        }
+    )";
+
+    struct SimParams {
+        float deltaT;
+        float rule1Distance;
+        float rule2Distance;
+        float rule3Distance;
+        float rule1Scale;
+        float rule2Scale;
+        float rule3Scale;
+        int particleCount;
+    };
+
+    struct Particle {
+        float pos[2];
+        float vel[2];
+    };
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+    unsigned int iterations = kDefaultIterations;
+    if (argc > 1) {
+        iterations = static_cast<unsigned int>(std::strtoul(argv[1], nullptr, 10));
+    }
+
+    shaderc::Compiler compiler;
+    auto result = compiler.CompileGlslToSpv(kShader, strlen(kShader), shaderc_glsl_compute_shader,
+                                            "ComputeBenchmark");
+    if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+        fprintf(stderr, "%s", result.GetErrorMessage().c_str());
+        return 1;
+    }
+
+    std::string error;
+    std::unique_ptr<backend::null::ShaderProgram> program = backend::null::ShaderProgram::Create(
+        std::vector<uint32_t>(result.cbegin(), result.cend()), nxt::ShaderStage::Compute, "main",
+        &error);
+    if (program == nullptr) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    SimParams params = {0.04f, 0.1f, 0.025f, 0.025f, 0.02f, 0.05f, 0.005f, kParticleCount};
+    std::vector<Particle> particlesA(kParticleCount);
+    std::vector<Particle> particlesB(kParticleCount);
+    for (Particle& particle : particlesA) {
+        particle.pos[0] = 2.0f * (std::rand() / static_cast<float>(RAND_MAX) - 0.5f);
+        particle.pos[1] = 2.0f * (std::rand() / static_cast<float>(RAND_MAX) - 0.5f);
+        particle.vel[0] = 0.1f * (std::rand() / static_cast<float>(RAND_MAX) - 0.5f);
+        particle.vel[1] = 0.1f * (std::rand() / static_cast<float>(RAND_MAX) - 0.5f);
+    }
+
+    std::array<uint32_t, kMaxPushConstants> pushConstants = {};
+    backend::null::ShaderBindings bindings;
+    bindings.buffers[0][0] = {reinterpret_cast<uint8_t*>(&params), sizeof(params)};
+    bindings.buffers[0][1] = {reinterpret_cast<uint8_t*>(particlesA.data()),
+                              static_cast<uint32_t>(kParticleCount * sizeof(Particle))};
+    bindings.buffers[0][2] = {reinterpret_cast<uint8_t*>(particlesB.data()),
+                              static_cast<uint32_t>(kParticleCount * sizeof(Particle))};
+    bindings.pushConstants = pushConstants.data();
+
+    uint32_t maxThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    double singleThreadMs = 0.0;
+    for (uint32_t threadCount = 1; threadCount <= maxThreadCount; ++threadCount) {
+        ThreadPool pool(threadCount);
+
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < iterations; ++i) {
+            program->Dispatch(bindings, kParticleCount / kLocalSize, 1, 1, &pool);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double us = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+        double ms = us / 1000.0 / iterations;
+        if (threadCount == 1) {
+            singleThreadMs = ms;
+        }
+        printf("%u threads: %.2f ms per dispatch, %.2fx speedup\n", threadCount, ms,
+               singleThreadMs / ms);
+    }
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the throughput of the copy commands executed by the null backend, for buffer to buffer
+// copies and for buffer to texture copies with tightly packed and with padded rows.
+
+#include <nxt/nxtcpp.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace backend { namespace null {
+    void Init(nxtProcTable* procs, nxtDevice* device);
+}}  // namespace backend::null
+
+namespace {
+
+    constexpr unsigned int kDefaultIterations = 200;
+    constexpr uint32_t kTextureSize = 1024;
+    constexpr uint32_t kTexelSize = 4;
+    constexpr uint32_t kBufferSize = kTextureSize * kTextureSize * kTexelSize;
+
+    template <typename F>
+    double MeasureGBPerSecond(unsigned int iterations, size_t bytesPerIteration, F f) {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < iterations; ++i) {
+            f();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double ns = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        return static_cast<double>(bytesPerIteration) * iterations / ns;
+    }
+
+    nxt::Buffer CreateBuffer(const nxt::Device& device) {
+        return device.CreateBufferBuilder()
+            .SetAllowedUsage(nxt::BufferUsageBit::TransferSrc | nxt::BufferUsageBit::TransferDst)
+            .SetInitialUsage(nxt::BufferUsageBit::TransferDst)
+            .SetSize(kBufferSize)
+            .GetResult();
+    }
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+    unsigned int iterations = kDefaultIterations;
+    if (argc > 1) {
+        iterations = static_cast<unsigned int>(std::strtoul(argv[1], nullptr, 10));
+    }
+
+    nxtProcTable procs;
+    nxtDevice cDevice;
+    backend::null::Init(&procs, &cDevice);
+    nxtSetProcs(&procs);
+
+    {
+        nxt::Device device = nxt::Device::Acquire(cDevice);
+        nxt::Queue queue = device.CreateQueueBuilder().GetResult();
+        nxt::Buffer source = CreateBuffer(device);
+        nxt::Buffer destination = CreateBuffer(device);
+        nxt::Texture texture =
+            device.CreateTextureBuilder()
+                .SetDimension(nxt::TextureDimension::e2D)
+                .SetExtent(kTextureSize, kTextureSize, 1)
+                .SetFormat(nxt::TextureFormat::R8G8B8A8Unorm)
+                .SetMipLevels(1)
+                .SetAllowedUsage(nxt::TextureUsageBit::TransferDst)
+                .GetResult();
+
+        auto Copy = [&](const nxt::CommandBuffer& commands) { queue.Submit(1, &commands); };
+
+        double bufferToBuffer = MeasureGBPerSecond(iterations, kBufferSize, [&]() {
+            Copy(device.CreateCommandBufferBuilder()
+                     .TransitionBufferUsage(source, nxt::BufferUsageBit::TransferSrc)
+                     .TransitionBufferUsage(destination, nxt::BufferUsageBit::TransferDst)
+                     .CopyBufferToBuffer(source, 0, destination, 0, kBufferSize)
+                     .GetResult());
+        });
+
+        // The rows of the whole texture are tightly packed in the buffer so they are copied at
+        // once.
+        double packedRows = MeasureGBPerSecond(iterations, kBufferSize, [&]() {
+            Copy(device.CreateCommandBufferBuilder()
+                     .TransitionBufferUsage(source, nxt::BufferUsageBit::TransferSrc)
+                     .TransitionTextureUsage(texture, nxt::TextureUsageBit::TransferDst)
+                     .CopyBufferToTexture(source, 0, 0, texture, 0, 0, 0, kTextureSize,
+                                          kTextureSize, 1, 0)
+                     .GetResult());
+        });
+
+        // Copying all the texture but its last column leaves padding at the end of the rows.
+        constexpr uint32_t kPaddedWidth = kTextureSize - 1;
+        double paddedRows =
+            MeasureGBPerSecond(iterations, kPaddedWidth * kTextureSize * kTexelSize, [&]() {
+                Copy(device.CreateCommandBufferBuilder()
+                         .TransitionBufferUsage(source, nxt::BufferUsageBit::TransferSrc)
+                         .TransitionTextureUsage(texture, nxt::TextureUsageBit::TransferDst)
+                         .CopyBufferToTexture(source, 0, kTextureSize * kTexelSize, texture, 0,
+                                              0, 0, kPaddedWidth, kTextureSize, 1, 0)
+                         .GetResult());
+            });
+
+        printf("Buffer to buffer: %.2f GB/s\n", bufferToBuffer);
+        printf("Buffer to texture, packed rows: %.2f GB/s\n", packedRows);
+        printf("Buffer to texture, padded rows: %.2f GB/s\n", paddedRows);
+    }
+
+    nxtSetProcs(nullptr);
+    return 0;
+}
@@ -0,0 +1,101 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the cost of deferring work until a serial completes with 100k items pending, for the
+// DeferredWorkQueue shared by the backends and for a SerialQueue retired with IterateUpTo and
+// ClearUpTo like the backends used to.
+
+#include "backend/DeferredWorkQueue.h"
+#include "common/SerialQueue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+
+namespace {
+
+    constexpr unsigned int kDefaultIterations = 20;
+    constexpr uint32_t kPendingItems = 100000;
+
+    // The sum of the items keeps the work from being optimized out.
+    uint64_t sum = 0;
+
+    template <typename F>
+    double MeasureNsPerItem(unsigned int iterations, F f) {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < iterations; ++i) {
+            f();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double ns = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        return ns / (static_cast<double>(iterations) * kPendingItems);
+    }
+
+    // Enqueues the items spread over serials, like the resources released during many frames,
+    // then retires them one serial at a time. The queues are kept between iterations so that
+    // their storage is already allocated, like the queues of a device in its steady state.
+    double MeasureSerialQueue(unsigned int iterations, uint32_t itemsPerSerial) {
+        SerialQueue<uint64_t> queue;
+        Serial lastSerial = 0;
+        return MeasureNsPerItem(iterations, [&]() {
+            Serial firstSerial = lastSerial + 1;
+            for (uint32_t i = 0; i < kPendingItems; ++i) {
+                queue.Enqueue(i, firstSerial + i / itemsPerSerial);
+            }
+            lastSerial += kPendingItems / itemsPerSerial;
+            for (Serial serial = firstSerial; serial <= lastSerial; ++serial) {
+                for (uint64_t value : queue.IterateUpTo(serial)) {
+                    sum += value;
+                }
+                queue.ClearUpTo(serial);
+            }
+        });
+    }
+
+    double MeasureDeferredWorkQueue(unsigned int iterations, uint32_t itemsPerSerial) {
+        backend::DeferredWorkQueue queue;
+        Serial lastSerial = 0;
+        return MeasureNsPerItem(iterations, [&]() {
+            Serial firstSerial = lastSerial + 1;
+            for (uint32_t i = 0; i < kPendingItems; ++i) {
+                uint64_t value = i;
+                queue.Enqueue(firstSerial + i / itemsPerSerial, [value]() { sum += value; });
+            }
+            lastSerial += kPendingItems / itemsPerSerial;
+            for (Serial serial = firstSerial; serial <= lastSerial; ++serial) {
+                queue.Tick(serial);
+            }
+        });
+    }
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+    unsigned int iterations = kDefaultIterations;
+    if (argc > 1) {
+        iterations = static_cast<unsigned int>(std::strtoul(argv[1], nullptr, 10));
+    }
+
+    for (uint32_t itemsPerSerial : {1000u, 100u, 10u}) {
+        printf("%u items per serial:\n", itemsPerSerial);
+        printf("    SerialQueue: %.2f ns/item\n", MeasureSerialQueue(iterations, itemsPerSerial));
+        printf("    DeferredWorkQueue: %.2f ns/item\n",
+               MeasureDeferredWorkQueue(iterations, itemsPerSerial));
+    }
+    printf("(sum %llu)\n", static_cast<unsigned long long>(sum));
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the cost of calling the null backend through the proc table and through the C API,
+// which are the same when the C API forwards to the procs given to nxtSetProcs, and the C API
+// being a direct call when building with NXT_STATIC_DISPATCH_BACKEND=null.
+
+#include <nxt/nxt.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace backend { namespace null {
+    void Init(nxtProcTable* procs, nxtDevice* device);
+}}  // namespace backend::null
+
+namespace {
+
+    constexpr unsigned int kDefaultIterations = 10000000;
+
+    template <typename F>
+    double MeasureNsPerCall(unsigned int iterations, unsigned int callsPerIteration, F f) {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < iterations; ++i) {
+            f();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double ns = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        return ns / iterations / callsPerIteration;
+    }
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+    unsigned int iterations = kDefaultIterations;
+    if (argc > 1) {
+        iterations = static_cast<unsigned int>(std::strtoul(argv[1], nullptr, 10));
+    }
+
+    nxtProcTable procs;
+    nxtDevice device;
+    backend::null::Init(&procs, &device);
+    nxtSetProcs(&procs);
+
+    nxtBufferBuilder builder = procs.deviceCreateBufferBuilder(device);
+
+    // Reference and Release only touch the refcount so the call overhead dominates.
+    double tableNs = MeasureNsPerCall(iterations, 2, [&]() {
+        procs.bufferBuilderReference(builder);
+        procs.bufferBuilderRelease(builder);
+    });
+    double cApiNs = MeasureNsPerCall(iterations, 2, [&]() {
+        nxtBufferBuilderReference(builder);
+        nxtBufferBuilderRelease(builder);
+    });
+
+#if defined(NXT_STATIC_DISPATCH)
+    const char* cApiKind = "static dispatch";
+#else
+    const char* cApiKind = "nxtSetProcs forwarding";
+#endif
+    printf("Proc table: %.2f ns/call\n", tableNs);
+    printf("C API (%s): %.2f ns/call\n", cApiKind, cApiNs);
+
+    procs.bufferBuilderRelease(builder);
+    procs.deviceRelease(device);
+    return 0;
+}
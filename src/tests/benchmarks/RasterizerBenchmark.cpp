@@ -0,0 +1,198 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the throughput of the CPU rasterizer of the null backend for each number of threads:
+// in triangles per second with a dense mesh of small triangles, and in pixels per second with
+// blended fullscreen quads.
+
+#include "backend/null/Rasterizer.h"
+#include "common/ThreadPool.h"
+
+#include <shaderc/shaderc.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    constexpr unsigned int kDefaultIterations = 5;
+    constexpr uint32_t kSize = 1024;
+    // The mesh has 2 * kGridSize * kGridSize triangles of about 8 pixels each.
+    constexpr uint32_t kGridSize = 256;
+    constexpr uint32_t kQuadCount = 8;
+
+    const char* kVertexShader = R"(
+        #version 450
+        layout(location = 0) in vec4 position;
+        layout(location = 1) in vec4 color;
+        layout(location = 0) out vec4 vColor;
+        void main() {
+            vColor = color;
+            gl_Position = position;
+        }
+    )";
+
+    const char* kFragmentShader = R"(
+        #version 450
+        layout(location = 0) in vec4 vColor;
+        layout(location = 0) out vec4 fragColor;
+        void main() {
+            fragColor = vColor;
+        }
+    )";
+
+    struct Vertex {
+        float position[4];
+        float color[4];
+    };
+
+    std::unique_ptr<backend::null::ShaderProgram> Compile(const char* source,
+                                                          shaderc_shader_kind kind,
+                                                          nxt::ShaderStage stage) {
+        shaderc::Compiler compiler;
+        auto result =
+            compiler.CompileGlslToSpv(source, strlen(source), kind, "RasterizerBenchmark");
+        if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+            fprintf(stderr, "%s", result.GetErrorMessage().c_str());
+            return nullptr;
+        }
+
+        std::string error;
+        std::unique_ptr<backend::null::ShaderProgram> program =
+            backend::null::ShaderProgram::Create(
+                std::vector<uint32_t>(result.cbegin(), result.cend()), stage, "main", &error);
+        if (program == nullptr) {
+            fprintf(stderr, "%s\n", error.c_str());
+        }
+        return program;
+    }
+
+    Vertex MakeVertex(float x, float y, float r) {
+        return {{x, y, 0.5f, 1.0f}, {r, 1.0f - r, 0.5f, 0.25f}};
+    }
+
+    // Returns the time in seconds of iterations draws.
+    double TimeDraws(backend::null::Rasterizer* rasterizer,
+                     const backend::null::RasterizerPipeline& pipeline,
+                     const std::vector<Vertex>& vertices,
+                     unsigned int iterations) {
+        std::array<uint32_t, kMaxPushConstants> pushConstants = {};
+        backend::null::ShaderBindings shaderBindings;
+        shaderBindings.pushConstants = pushConstants.data();
+
+        backend::null::DrawBindings bindings;
+        bindings.vertex = &shaderBindings;
+        bindings.fragment = &shaderBindings;
+        bindings.vertexBuffers[0].data = reinterpret_cast<const uint8_t*>(vertices.data());
+        bindings.vertexBuffers[0].size = static_cast<uint32_t>(vertices.size() * sizeof(Vertex));
+
+        backend::null::DrawCall draw;
+        draw.count = static_cast<uint32_t>(vertices.size());
+
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < iterations; ++i) {
+            rasterizer->Draw(pipeline, bindings, draw);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double us = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+        return us / 1e6;
+    }
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+    unsigned int iterations = kDefaultIterations;
+    if (argc > 1) {
+        iterations = static_cast<unsigned int>(std::strtoul(argv[1], nullptr, 10));
+    }
+
+    std::unique_ptr<backend::null::ShaderProgram> vertexShader =
+        Compile(kVertexShader, shaderc_glsl_vertex_shader, nxt::ShaderStage::Vertex);
+    std::unique_ptr<backend::null::ShaderProgram> fragmentShader =
+        Compile(kFragmentShader, shaderc_glsl_fragment_shader, nxt::ShaderStage::Fragment);
+    if (vertexShader == nullptr || fragmentShader == nullptr) {
+        return 1;
+    }
+
+    backend::null::RasterizerPipeline pipeline;
+    pipeline.vertex = vertexShader.get();
+    pipeline.fragment = fragmentShader.get();
+    pipeline.attributesSet.set(0);
+    pipeline.attributesSet.set(1);
+    pipeline.attributes[0] = {0, nxt::VertexFormat::FloatR32G32B32A32, 0};
+    pipeline.attributes[1] = {0, nxt::VertexFormat::FloatR32G32B32A32, 16};
+    pipeline.inputs[0] = {sizeof(Vertex), nxt::InputStepMode::Vertex};
+    pipeline.blends[0].blendEnabled = true;
+    pipeline.blends[0].colorBlend = {nxt::BlendOperation::Add, nxt::BlendFactor::SrcAlpha,
+                                     nxt::BlendFactor::OneMinusSrcAlpha};
+
+    std::vector<Vertex> mesh;
+    for (uint32_t y = 0; y < kGridSize; ++y) {
+        for (uint32_t x = 0; x < kGridSize; ++x) {
+            float x0 = 2.0f * x / kGridSize - 1.0f;
+            float y0 = 2.0f * y / kGridSize - 1.0f;
+            float x1 = 2.0f * (x + 1) / kGridSize - 1.0f;
+            float y1 = 2.0f * (y + 1) / kGridSize - 1.0f;
+            float r = static_cast<float>(x) / kGridSize;
+            for (auto corner : {std::make_pair(x0, y0), std::make_pair(x1, y0),
+                                std::make_pair(x0, y1), std::make_pair(x0, y1),
+                                std::make_pair(x1, y0), std::make_pair(x1, y1)}) {
+                mesh.push_back(MakeVertex(corner.first, corner.second, r));
+            }
+        }
+    }
+    uint32_t meshTriangles = static_cast<uint32_t>(mesh.size() / 3);
+
+    std::vector<Vertex> quads;
+    for (uint32_t i = 0; i < kQuadCount; ++i) {
+        float r = static_cast<float>(i) / kQuadCount;
+        for (auto corner : {std::make_pair(-1.0f, -1.0f), std::make_pair(1.0f, -1.0f),
+                            std::make_pair(-1.0f, 1.0f), std::make_pair(-1.0f, 1.0f),
+                            std::make_pair(1.0f, -1.0f), std::make_pair(1.0f, 1.0f)}) {
+            quads.push_back(MakeVertex(corner.first, corner.second, r));
+        }
+    }
+    double quadPixels = static_cast<double>(kQuadCount) * kSize * kSize;
+
+    std::vector<uint8_t> color(kSize * kSize * 4);
+    backend::null::RenderTargets targets;
+    targets.width = kSize;
+    targets.height = kSize;
+    targets.colors[0] = {color.data(), kSize * 4, nxt::TextureFormat::R8G8B8A8Unorm};
+
+    uint32_t maxThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t threadCount = 1; threadCount <= maxThreadCount; ++threadCount) {
+        ThreadPool pool(threadCount);
+        backend::null::Rasterizer rasterizer(&pool);
+        rasterizer.SetRenderTargets(targets);
+
+        double meshSeconds = TimeDraws(&rasterizer, pipeline, mesh, iterations);
+        double quadSeconds = TimeDraws(&rasterizer, pipeline, quads, iterations);
+        printf("%u threads: %.2f Mtri/s, %.2f Mpix/s\n", threadCount,
+               meshTriangles * iterations / meshSeconds / 1e6,
+               quadPixels * iterations / quadSeconds / 1e6);
+    }
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the backend submits made per frame and the CPU time per frame when a frame submits
+// many small command buffers, flushing the queue after each submit and batching the submits
+// until the end of the frame.
+
+#include "backend/null/NullBackend.h"
+
+#include <nxt/nxtcpp.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+    constexpr unsigned int kDefaultFrames = 1000;
+    constexpr uint32_t kSubmitsPerFrame = 32;
+    constexpr uint32_t kBufferSize = 256;
+
+    struct FrameStats {
+        double submitsPerFrame;
+        double microsecondsPerFrame;
+    };
+
+    template <typename F>
+    FrameStats MeasureFrames(backend::null::DeviceTimeline* timeline, unsigned int frames, F f) {
+        Serial startSerial = timeline->GetLastSubmittedSerial();
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < frames; ++i) {
+            f();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double us = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+        double submits = static_cast<double>(timeline->GetLastSubmittedSerial() - startSerial);
+        return {submits / frames, us / frames};
+    }
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+    unsigned int frames = kDefaultFrames;
+    if (argc > 1) {
+        frames = static_cast<unsigned int>(std::strtoul(argv[1], nullptr, 10));
+    }
+
+    nxtProcTable procs;
+    nxtDevice cDevice;
+    backend::null::Init(&procs, &cDevice);
+    nxtSetProcs(&procs);
+    backend::null::DeviceTimeline* timeline =
+        reinterpret_cast<backend::null::Device*>(cDevice)->GetTimeline();
+
+    {
+        nxt::Device device = nxt::Device::Acquire(cDevice);
+        nxt::Queue queue = device.CreateQueueBuilder().GetResult();
+        nxt::Buffer source = device.CreateBufferBuilder()
+                                 .SetAllowedUsage(nxt::BufferUsageBit::TransferSrc)
+                                 .SetInitialUsage(nxt::BufferUsageBit::TransferSrc)
+                                 .SetSize(kBufferSize)
+                                 .GetResult();
+        nxt::Buffer destination = device.CreateBufferBuilder()
+                                      .SetAllowedUsage(nxt::BufferUsageBit::TransferDst)
+                                      .SetInitialUsage(nxt::BufferUsageBit::TransferDst)
+                                      .SetSize(kBufferSize)
+                                      .GetResult();
+
+        // The command buffers are recorded once so that only the submits are measured.
+        std::vector<nxt::CommandBuffer> commands;
+        for (uint32_t i = 0; i < kSubmitsPerFrame; ++i) {
+            commands.push_back(device.CreateCommandBufferBuilder()
+                                   .TransitionBufferUsage(source,
+                                                          nxt::BufferUsageBit::TransferSrc)
+                                   .TransitionBufferUsage(destination,
+                                                          nxt::BufferUsageBit::TransferDst)
+                                   .CopyBufferToBuffer(source, 0, destination, 0, kBufferSize)
+                                   .GetResult());
+        }
+
+        FrameStats flushEachSubmit = MeasureFrames(timeline, frames, [&]() {
+            for (const nxt::CommandBuffer& commandBuffer : commands) {
+                queue.Submit(1, &commandBuffer);
+                queue.Flush();
+            }
+            device.Tick();
+        });
+
+        FrameStats batched = MeasureFrames(timeline, frames, [&]() {
+            for (const nxt::CommandBuffer& commandBuffer : commands) {
+                queue.Submit(1, &commandBuffer);
+            }
+            device.Tick();
+        });
+
+        printf("Flush after each submit: %.1f submits/frame, %.2f us/frame\n",
+               flushEachSubmit.submitsPerFrame, flushEachSubmit.microsecondsPerFrame);
+        printf("Batched submits: %.1f submits/frame, %.2f us/frame\n", batched.submitsPerFrame,
+               batched.microsecondsPerFrame);
+    }
+
+    nxtSetProcs(nullptr);
+    return 0;
+}
@@ -980,4 +980,4 @@ TEST_P(BlendStateTest, DefaultBlendColor) {
     }
 }
 
-NXT_INSTANTIATE_TEST(BlendStateTest, D3D12Backend, MetalBackend, OpenGLBackend, VulkanBackend)
+NXT_INSTANTIATE_TEST(BlendStateTest, D3D12Backend, MetalBackend, NullBackend, OpenGLBackend, VulkanBackend)
@@ -100,7 +100,7 @@ TEST_P(BufferMapReadTests, LargeRead) {
     buffer.Unmap();
 }
 
-NXT_INSTANTIATE_TEST(BufferMapReadTests, D3D12Backend, MetalBackend, OpenGLBackend, VulkanBackend)
+NXT_INSTANTIATE_TEST(BufferMapReadTests, D3D12Backend, MetalBackend, NullBackend, OpenGLBackend, VulkanBackend)
 
 class BufferSetSubDataTests : public NXTTest {
 };
@@ -183,5 +183,6 @@ TEST_P(BufferSetSubDataTests, LargeSetSubData) {
 NXT_INSTANTIATE_TEST(BufferSetSubDataTests,
                      D3D12Backend,
                      MetalBackend,
+                     NullBackend,
                      OpenGLBackend,
                      VulkanBackend)
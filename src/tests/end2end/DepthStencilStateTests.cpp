@@ -527,5 +527,6 @@ TEST_P(DepthStencilStateTest, StencilDepthPass) {
 NXT_INSTANTIATE_TEST(DepthStencilStateTest,
                      D3D12Backend,
                      MetalBackend,
+                     NullBackend,
                      OpenGLBackend,
                      VulkanBackend)
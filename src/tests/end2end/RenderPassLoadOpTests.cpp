@@ -231,4 +231,4 @@ TEST_P(RenderPassLoadOpTests, ClearsOnlyOnFirstUsePerRenderPass) {
     EXPECT_TEXTURE_RGBA8_EQ(expectBlue.data(), renderTarget, kRTSize / 2, 0, kRTSize / 2, kRTSize, 0);
 }
 
-NXT_INSTANTIATE_TEST(RenderPassLoadOpTests, D3D12Backend, MetalBackend, OpenGLBackend)
+NXT_INSTANTIATE_TEST(RenderPassLoadOpTests, D3D12Backend, MetalBackend, NullBackend, OpenGLBackend)
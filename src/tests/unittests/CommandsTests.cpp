@@ -0,0 +1,202 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "backend/Buffer.h"
+#include "backend/Commands.h"
+
+#include "nxt/nxtcpp.h"
+
+#include <new>
+#include <vector>
+
+namespace backend { namespace null {
+    void Init(nxtProcTable* procs, nxtDevice* device);
+}}  // namespace backend::null
+
+using namespace backend;
+
+namespace {
+
+    const CommandInfo& InfoOf(Command command) {
+        return kCommandInfos[static_cast<size_t>(command)];
+    }
+
+    // Records the draws and push constants, the other commands are skipped.
+    struct RecordingVisitor : CommandVisitor {
+        void OnDrawArrays(DrawArraysCmd* draw) {
+            vertexCounts.push_back(draw->vertexCount);
+        }
+        void OnSetPushConstants(SetPushConstantsCmd* cmd, uint32_t* values) {
+            pushConstants.insert(pushConstants.end(), values, values + cmd->count);
+        }
+
+        std::vector<uint32_t> vertexCounts;
+        std::vector<uint32_t> pushConstants;
+    };
+
+    void AllocateDraw(CommandAllocator* allocator, uint32_t vertexCount) {
+        DrawArraysCmd* draw = allocator->Allocate<DrawArraysCmd>(Command::DrawArrays);
+        draw->vertexCount = vertexCount;
+        draw->instanceCount = 1;
+        draw->firstVertex = 0;
+        draw->firstInstance = 0;
+    }
+
+    void AllocatePushConstants(CommandAllocator* allocator, uint32_t count, uint32_t firstValue) {
+        SetPushConstantsCmd* cmd =
+            allocator->Allocate<SetPushConstantsCmd>(Command::SetPushConstants);
+        cmd->stages = nxt::ShaderStageBit::Vertex;
+        cmd->offset = 0;
+        cmd->count = count;
+        uint32_t* values = allocator->AllocateData<uint32_t>(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            values[i] = firstValue + i;
+        }
+    }
+
+}  // anonymous namespace
+
+class CommandsTests : public testing::Test {
+    protected:
+        void SetUp() override {
+            nxtProcTable procs;
+            nxtDevice device;
+            backend::null::Init(&procs, &device);
+            nxtSetProcs(&procs);
+            mDevice = nxt::Device::Acquire(device);
+        }
+
+        void TearDown() override {
+            mDevice = nxt::Device();
+            nxtSetProcs(nullptr);
+        }
+
+        nxt::Device mDevice;
+};
+
+// Test the generated command infos match the commands
+TEST_F(CommandsTests, CommandInfos) {
+    EXPECT_EQ(InfoOf(Command::DrawArrays).size, sizeof(DrawArraysCmd));
+    EXPECT_EQ(InfoOf(Command::DrawArrays).alignment, alignof(DrawArraysCmd));
+    EXPECT_TRUE(InfoOf(Command::DrawArrays).triviallyDestructible);
+    EXPECT_FALSE(InfoOf(Command::DrawArrays).hasTrailingData);
+
+    EXPECT_TRUE(InfoOf(Command::SetPushConstants).triviallyDestructible);
+    EXPECT_TRUE(InfoOf(Command::SetPushConstants).hasTrailingData);
+
+    EXPECT_FALSE(InfoOf(Command::SetBindGroup).triviallyDestructible);
+    EXPECT_FALSE(InfoOf(Command::SetBindGroup).hasTrailingData);
+
+    EXPECT_FALSE(InfoOf(Command::SetVertexBuffers).triviallyDestructible);
+    EXPECT_TRUE(InfoOf(Command::SetVertexBuffers).hasTrailingData);
+}
+
+// Test SkipCommand skips the commands along with their trailing data
+TEST_F(CommandsTests, SkipCommand) {
+    CommandAllocator allocator;
+    AllocatePushConstants(&allocator, 5, 0);
+    AllocateDraw(&allocator, 3);
+    AllocatePushConstants(&allocator, 1, 0);
+
+    CommandIterator commands(std::move(allocator));
+    std::vector<Command> types;
+    Command type;
+    while (commands.NextCommandId(&type)) {
+        types.push_back(type);
+        SkipCommand(&commands, type);
+    }
+
+    ASSERT_EQ(types.size(), 3u);
+    EXPECT_EQ(types[0], Command::SetPushConstants);
+    EXPECT_EQ(types[1], Command::DrawArrays);
+    EXPECT_EQ(types[2], Command::SetPushConstants);
+
+    commands.Reset();
+    FreeCommands(&commands);
+}
+
+// Test VisitCommands gives the commands and their trailing data to the visitor
+TEST_F(CommandsTests, VisitCommands) {
+    CommandAllocator allocator;
+    AllocateDraw(&allocator, 3);
+    SetStencilReferenceCmd* stencil =
+        allocator.Allocate<SetStencilReferenceCmd>(Command::SetStencilReference);
+    stencil->reference = 1;
+    AllocatePushConstants(&allocator, 3, 10);
+    AllocateDraw(&allocator, 6);
+
+    CommandIterator commands(std::move(allocator));
+    RecordingVisitor visitor;
+    VisitCommands(&commands, &visitor);
+
+    EXPECT_EQ(visitor.vertexCounts, std::vector<uint32_t>({3, 6}));
+    EXPECT_EQ(visitor.pushConstants, std::vector<uint32_t>({10, 11, 12}));
+
+    commands.Reset();
+    FreeCommands(&commands);
+}
+
+// Test command buffers with only trivially destructible commands don't need destruction
+TEST_F(CommandsTests, TrivialCommandsDontNeedDestruction) {
+    CommandAllocator allocator;
+    AllocateDraw(&allocator, 3);
+    AllocatePushConstants(&allocator, 4, 0);
+
+    CommandIterator commands(std::move(allocator));
+    EXPECT_FALSE(commands.NeedsDestruction());
+
+    // Moving the iterator keeps the flag
+    CommandIterator moved(std::move(commands));
+    EXPECT_FALSE(moved.NeedsDestruction());
+    FreeCommands(&moved);
+}
+
+// Test FreeCommands releases the Refs of the commands and of their trailing data
+TEST_F(CommandsTests, FreeCommandsReleasesRefs) {
+    nxt::Buffer buffer = mDevice.CreateBufferBuilder()
+                             .SetAllowedUsage(nxt::BufferUsageBit::Vertex)
+                             .SetInitialUsage(nxt::BufferUsageBit::Vertex)
+                             .SetSize(4)
+                             .GetResult();
+    BufferBase* bufferBase = reinterpret_cast<BufferBase*>(buffer.Get());
+    uint32_t internalRefs = bufferBase->GetInternalRefs();
+
+    CommandAllocator allocator;
+    AllocateDraw(&allocator, 3);
+    SetIndexBufferCmd* setIndexBuffer =
+        allocator.Allocate<SetIndexBufferCmd>(Command::SetIndexBuffer);
+    new (setIndexBuffer) SetIndexBufferCmd;
+    setIndexBuffer->buffer = bufferBase;
+    setIndexBuffer->offset = 0;
+
+    SetVertexBuffersCmd* setVertexBuffers =
+        allocator.Allocate<SetVertexBuffersCmd>(Command::SetVertexBuffers);
+    new (setVertexBuffers) SetVertexBuffersCmd;
+    setVertexBuffers->startSlot = 0;
+    setVertexBuffers->count = 2;
+    Ref<BufferBase>* buffers = allocator.AllocateData<Ref<BufferBase>>(2);
+    uint32_t* offsets = allocator.AllocateData<uint32_t>(2);
+    for (uint32_t i = 0; i < 2; ++i) {
+        new (&buffers[i]) Ref<BufferBase>(bufferBase);
+        offsets[i] = 0;
+    }
+    EXPECT_EQ(bufferBase->GetInternalRefs(), internalRefs + 3);
+
+    CommandIterator commands(std::move(allocator));
+    EXPECT_TRUE(commands.NeedsDestruction());
+    FreeCommands(&commands);
+    EXPECT_EQ(bufferBase->GetInternalRefs(), internalRefs);
+}
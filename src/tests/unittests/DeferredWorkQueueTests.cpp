@@ -0,0 +1,124 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "backend/DeferredWorkQueue.h"
+
+#include <memory>
+#include <vector>
+
+using namespace backend;
+
+// Test the work runs once its serial is completed, in the order it was enqueued
+TEST(DeferredWorkQueue, RunsCompletedSerials) {
+    DeferredWorkQueue queue;
+    std::vector<int> ran;
+
+    ASSERT_TRUE(queue.Empty());
+    queue.Enqueue(1, [&ran]() { ran.push_back(1); });
+    queue.Enqueue(1, [&ran]() { ran.push_back(2); });
+    queue.Enqueue(2, [&ran]() { ran.push_back(3); });
+    ASSERT_EQ(3u, queue.GetPendingCount());
+
+    queue.Tick(0);
+    ASSERT_TRUE(ran.empty());
+
+    queue.Tick(1);
+    ASSERT_EQ((std::vector<int>{1, 2}), ran);
+    ASSERT_EQ(1u, queue.GetPendingCount());
+
+    queue.Tick(5);
+    ASSERT_EQ((std::vector<int>{1, 2, 3}), ran);
+    ASSERT_TRUE(queue.Empty());
+}
+
+// Test the completed work of a lane runs before the work of the next lanes, even for later
+// serials
+TEST(DeferredWorkQueue, LanesRetireInOrder) {
+    DeferredWorkQueue queue(2);
+    std::vector<int> ran;
+
+    queue.Enqueue(1, [&ran]() { ran.push_back(1); }, 1);
+    queue.Enqueue(2, [&ran]() { ran.push_back(2); }, 0);
+    queue.Enqueue(3, [&ran]() { ran.push_back(3); }, 0);
+
+    queue.Tick(2);
+    ASSERT_EQ((std::vector<int>{2, 1}), ran);
+    ASSERT_EQ(1u, queue.GetPendingCount());
+}
+
+// Test callbacks can enqueue work, which runs in the same tick when its serial is completed
+TEST(DeferredWorkQueue, EnqueueFromCallback) {
+    DeferredWorkQueue queue;
+    std::vector<int> ran;
+
+    queue.Enqueue(1, [&queue, &ran]() {
+        ran.push_back(1);
+        // Enough work to grow the ring while the callback runs.
+        for (int i = 0; i < 100; ++i) {
+            queue.Enqueue(1, [&ran]() { ran.push_back(2); });
+        }
+        queue.Enqueue(2, [&ran]() { ran.push_back(3); });
+    });
+
+    queue.Tick(1);
+    ASSERT_EQ(101u, ran.size());
+    ASSERT_EQ(1u, queue.GetPendingCount());
+
+    queue.Tick(2);
+    ASSERT_EQ(3, ran.back());
+}
+
+// Test the order is kept when the ring grows after wrapping around
+TEST(DeferredWorkQueue, GrowAfterWrapping) {
+    DeferredWorkQueue queue;
+    std::vector<int> ran;
+
+    int next = 0;
+    for (Serial serial = 1; serial <= 10; ++serial) {
+        for (int i = 0; i < 7; ++i) {
+            int value = next++;
+            queue.Enqueue(serial, [&ran, value]() { ran.push_back(value); });
+        }
+        queue.Tick(serial - 1);
+    }
+    queue.Tick(10);
+
+    ASSERT_EQ(static_cast<size_t>(next), ran.size());
+    for (int i = 0; i < next; ++i) {
+        ASSERT_EQ(i, ran[i]);
+    }
+}
+
+// Test the captures are destroyed after the work runs, and without running it when the queue
+// is destroyed
+TEST(DeferredWorkQueue, CapturesAreDestroyed) {
+    std::shared_ptr<int> value = std::make_shared<int>(0);
+
+    {
+        DeferredWorkQueue queue;
+        for (Serial serial = 1; serial <= 50; ++serial) {
+            queue.Enqueue(serial, [value]() { (*value)++; });
+        }
+        ASSERT_EQ(51, value.use_count());
+
+        queue.Tick(20);
+        ASSERT_EQ(20, *value);
+        ASSERT_EQ(31, value.use_count());
+    }
+
+    ASSERT_EQ(20, *value);
+    ASSERT_EQ(1, value.use_count());
+}
@@ -0,0 +1,184 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include "mock/mock_nxt.h"
+
+#include "dispatch/DispatchProcs.h"
+#include "wire/TerribleCommandBuffer.h"
+#include "wire/Wire.h"
+
+#include "nxt/nxtcpp.h"
+
+#include <thread>
+#include <vector>
+
+namespace backend { namespace null {
+    void Init(nxtProcTable* procs, nxtDevice* device);
+}}  // namespace backend::null
+
+using namespace testing;
+using namespace nxt::dispatch;
+
+class DispatchProcsTests : public Test {
+    protected:
+        void SetUp() override {
+            mDispatchProcs = GetDispatchProcs();
+            nxtSetProcs(&mDispatchProcs);
+        }
+
+        void TearDown() override {
+            nxtSetProcs(nullptr);
+        }
+
+        nxtProcTable mDispatchProcs;
+};
+
+// Test calls go to the procs of the device the object was created from, with the objects of the
+// device's procs as arguments.
+TEST_F(DispatchProcsTests, CallsGoToTheDevicesProcs) {
+    StrictMock<MockProcTable> mock1;
+    StrictMock<MockProcTable> mock2;
+    nxtProcTable procs1;
+    nxtProcTable procs2;
+    nxtDevice device1;
+    nxtDevice device2;
+    mock1.GetProcTableAndDevice(&procs1, &device1);
+    mock2.GetProcTableAndDevice(&procs2, &device2);
+
+    nxtDevice wrapped1 = WrapDevice(device1, procs1);
+    nxtDevice wrapped2 = WrapDevice(device2, procs2);
+
+    nxtQueueBuilder queueBuilder = mock2.GetNewQueueBuilder();
+    nxtQueue queue = mock2.GetNewQueue();
+    EXPECT_CALL(mock2, DeviceCreateQueueBuilder(device2)).WillOnce(Return(queueBuilder));
+    EXPECT_CALL(mock2, QueueBuilderGetResult(queueBuilder)).WillOnce(Return(queue));
+    EXPECT_CALL(mock2, QueueBuilderRelease(queueBuilder));
+
+    nxtQueueBuilder wrappedQueueBuilder = nxtDeviceCreateQueueBuilder(wrapped2);
+    nxtQueue wrappedQueue = nxtQueueBuilderGetResult(wrappedQueueBuilder);
+    nxtQueueBuilderRelease(wrappedQueueBuilder);
+
+    nxtCommandBufferBuilder builder = mock1.GetNewCommandBufferBuilder();
+    nxtCommandBuffer commandBuffer = mock1.GetNewCommandBuffer();
+    EXPECT_CALL(mock1, DeviceCreateCommandBufferBuilder(device1)).WillOnce(Return(builder));
+    EXPECT_CALL(mock1, CommandBufferBuilderGetResult(builder)).WillOnce(Return(commandBuffer));
+    EXPECT_CALL(mock1, CommandBufferBuilderRelease(builder));
+
+    nxtCommandBufferBuilder wrappedBuilder = nxtDeviceCreateCommandBufferBuilder(wrapped1);
+    nxtCommandBuffer wrappedCommandBuffer = nxtCommandBufferBuilderGetResult(wrappedBuilder);
+    nxtCommandBufferBuilderRelease(wrappedBuilder);
+
+    // The wrapped handles are different from the ones of the procs.
+    ASSERT_NE(queue, wrappedQueue);
+    ASSERT_NE(commandBuffer, wrappedCommandBuffer);
+
+    // Arrays of objects are unwrapped too.
+    EXPECT_CALL(mock2, QueueSubmit(queue, 1, Pointee(commandBuffer)));
+    nxtQueueSubmit(wrappedQueue, 1, &wrappedCommandBuffer);
+
+    EXPECT_CALL(mock1, CommandBufferRelease(commandBuffer));
+    EXPECT_CALL(mock2, QueueRelease(queue));
+    EXPECT_CALL(mock1, DeviceRelease(device1));
+    EXPECT_CALL(mock2, DeviceRelease(device2));
+    nxtCommandBufferRelease(wrappedCommandBuffer);
+    nxtQueueRelease(wrappedQueue);
+    nxtDeviceRelease(wrapped1);
+    nxtDeviceRelease(wrapped2);
+}
+
+// Test the handles stay valid until their last reference is released, even after their device.
+TEST_F(DispatchProcsTests, ReferenceAndRelease) {
+    StrictMock<MockProcTable> mock;
+    nxtProcTable procs;
+    nxtDevice device;
+    mock.GetProcTableAndDevice(&procs, &device);
+    nxtDevice wrappedDevice = WrapDevice(device, procs);
+
+    nxtBufferBuilder builder = mock.GetNewBufferBuilder();
+    EXPECT_CALL(mock, DeviceCreateBufferBuilder(device)).WillOnce(Return(builder));
+    nxtBufferBuilder wrappedBuilder = nxtDeviceCreateBufferBuilder(wrappedDevice);
+
+    EXPECT_CALL(mock, DeviceRelease(device));
+    nxtDeviceRelease(wrappedDevice);
+
+    EXPECT_CALL(mock, BufferBuilderReference(builder));
+    EXPECT_CALL(mock, BufferBuilderRelease(builder)).Times(2);
+    nxtBufferBuilderReference(wrappedBuilder);
+    nxtBufferBuilderRelease(wrappedBuilder);
+
+    EXPECT_CALL(mock, BufferBuilderSetSize(builder, 4));
+    nxtBufferBuilderSetSize(wrappedBuilder, 4);
+    nxtBufferBuilderRelease(wrappedBuilder);
+}
+
+// Test a null device and a wire client, each used by the C++ API on its own thread.
+TEST_F(DispatchProcsTests, DevicesOnDifferentThreads) {
+    nxtProcTable nullProcs;
+    nxtDevice nullDevice;
+    backend::null::Init(&nullProcs, &nullDevice);
+
+    nxtProcTable serverProcs;
+    nxtDevice serverDevice;
+    backend::null::Init(&serverProcs, &serverDevice);
+    nxt::wire::TerribleCommandBuffer* c2sBuf = new nxt::wire::TerribleCommandBuffer();
+    nxt::wire::TerribleCommandBuffer* s2cBuf = new nxt::wire::TerribleCommandBuffer();
+    nxt::wire::CommandHandler* server =
+        nxt::wire::NewServerCommandHandler(serverDevice, serverProcs, s2cBuf);
+    c2sBuf->SetHandler(server);
+    nxtProcTable clientProcs;
+    nxtDevice clientDevice;
+    nxt::wire::CommandHandler* client =
+        nxt::wire::NewClientDevice(&clientProcs, &clientDevice, c2sBuf);
+    s2cBuf->SetHandler(client);
+
+    auto DoWork = [](nxt::Device device, bool* success) {
+        nxt::Queue queue = device.CreateQueueBuilder().GetResult();
+        for (int i = 0; i < 1000; ++i) {
+            nxt::Buffer buffer = device.CreateBufferBuilder()
+                                     .SetAllowedUsage(nxt::BufferUsageBit::TransferDst)
+                                     .SetInitialUsage(nxt::BufferUsageBit::TransferDst)
+                                     .SetSize(4)
+                                     .GetResult();
+            uint32_t value = static_cast<uint32_t>(i);
+            buffer.SetSubData(0, 1, &value);
+            nxt::CommandBuffer commands = device.CreateCommandBufferBuilder().GetResult();
+            queue.Submit(1, &commands);
+        }
+        *success = true;
+    };
+
+    bool nullSuccess = false;
+    bool wireSuccess = false;
+    {
+        nxt::Device wrappedNullDevice = nxt::Device::Acquire(WrapDevice(nullDevice, nullProcs));
+        nxt::Device wrappedClientDevice =
+            nxt::Device::Acquire(WrapDevice(clientDevice, clientProcs));
+
+        std::thread nullThread(DoWork, wrappedNullDevice.Clone(), &nullSuccess);
+        std::thread wireThread(DoWork, wrappedClientDevice.Clone(), &wireSuccess);
+        nullThread.join();
+        wireThread.join();
+    }
+    c2sBuf->Flush();
+
+    ASSERT_TRUE(nullSuccess);
+    ASSERT_TRUE(wireSuccess);
+
+    delete client;
+    delete server;
+    delete s2cBuf;
+    delete c2sBuf;
+    serverProcs.deviceRelease(serverDevice);
+}
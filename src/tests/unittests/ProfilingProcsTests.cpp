@@ -0,0 +1,138 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include "mock/mock_nxt.h"
+
+#include "profiling/ProfilingProcs.h"
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace nxt::profiling;
+
+namespace {
+
+    const LatencyHistogram* FindHistogram(const char* name) {
+        for (size_t i = 0; i < GetEntryPointCount(); ++i) {
+            if (strcmp(GetEntryPointName(i), name) == 0) {
+                return GetEntryPointHistogram(i);
+            }
+        }
+        return nullptr;
+    }
+
+}  // anonymous namespace
+
+// Test latencies go in the bucket of their power of two.
+TEST(LatencyHistogramTests, Buckets) {
+    ASSERT_EQ(0u, LatencyHistogram::GetBucket(0));
+    ASSERT_EQ(1u, LatencyHistogram::GetBucket(1));
+    ASSERT_EQ(2u, LatencyHistogram::GetBucket(2));
+    ASSERT_EQ(2u, LatencyHistogram::GetBucket(3));
+    ASSERT_EQ(11u, LatencyHistogram::GetBucket(1024));
+    ASSERT_EQ(kLatencyBucketCount - 1, LatencyHistogram::GetBucket(uint64_t(1) << 40));
+
+    ASSERT_EQ(0u, LatencyHistogram::GetBucketUpperBoundNs(0));
+    ASSERT_EQ(3u, LatencyHistogram::GetBucketUpperBoundNs(2));
+    ASSERT_EQ(2047u, LatencyHistogram::GetBucketUpperBoundNs(11));
+}
+
+// Test counts, max and percentiles of a histogram.
+TEST(LatencyHistogramTests, Statistics) {
+    LatencyHistogram histogram;
+    ASSERT_EQ(0u, histogram.GetPercentileNs(50.0));
+
+    for (int i = 0; i < 98; ++i) {
+        histogram.Record(100);
+    }
+    histogram.Record(5000);
+    histogram.Record(100000);
+
+    ASSERT_EQ(100u, histogram.GetCount());
+    ASSERT_EQ(98u * 100u + 5000u + 100000u, histogram.GetTotalNs());
+    ASSERT_EQ(100000u, histogram.GetMaxNs());
+    ASSERT_EQ(98u, histogram.GetBucketCount(LatencyHistogram::GetBucket(100)));
+
+    // The bucket of 100ns is [64, 128).
+    ASSERT_EQ(127u, histogram.GetPercentileNs(50.0));
+    ASSERT_EQ(8191u, histogram.GetPercentileNs(99.0));
+    ASSERT_EQ(100000u, histogram.GetPercentileNs(100.0));
+
+    histogram.Reset();
+    ASSERT_EQ(0u, histogram.GetCount());
+    ASSERT_EQ(0u, histogram.GetMaxNs());
+}
+
+// Test recording from several threads doesn't lose records.
+TEST(LatencyHistogramTests, ConcurrentRecords) {
+    constexpr int kThreadCount = 4;
+    constexpr int kRecordCount = 10000;
+    LatencyHistogram histogram;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreadCount; ++i) {
+        threads.emplace_back([&histogram, i]() {
+            for (int j = 0; j < kRecordCount; ++j) {
+                histogram.Record(static_cast<uint64_t>(i * kRecordCount + j));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(uint64_t(kThreadCount * kRecordCount), histogram.GetCount());
+    ASSERT_EQ(uint64_t(kThreadCount * kRecordCount - 1), histogram.GetMaxNs());
+}
+
+// Test the profiling procs forward calls and record them.
+TEST(ProfilingProcsTests, ForwardsAndRecordsCalls) {
+    StrictMock<MockProcTable> api;
+    nxtProcTable mockProcs;
+    nxtDevice device;
+    api.GetProcTableAndDevice(&mockProcs, &device);
+
+    nxtProcTable procs = GetProfilingProcs(mockProcs);
+    ResetProfilingData();
+
+    nxtBufferBuilder apiBuilder = api.GetNewBufferBuilder();
+    EXPECT_CALL(api, DeviceCreateBufferBuilder(device)).Times(3).WillRepeatedly(Return(apiBuilder));
+    EXPECT_CALL(api, BufferBuilderSetSize(apiBuilder, 4)).Times(1);
+
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(apiBuilder, procs.deviceCreateBufferBuilder(device));
+    }
+    procs.bufferBuilderSetSize(apiBuilder, 4);
+
+    ASSERT_EQ(3u, FindHistogram("nxtDeviceCreateBufferBuilder")->GetCount());
+    ASSERT_EQ(1u, FindHistogram("nxtBufferBuilderSetSize")->GetCount());
+    ASSERT_EQ(0u, FindHistogram("nxtQueueSubmit")->GetCount());
+
+    // Only called entry points are dumped.
+    std::string text = DumpProfilingDataText();
+    ASSERT_NE(std::string::npos, text.find("nxtDeviceCreateBufferBuilder"));
+    ASSERT_EQ(std::string::npos, text.find("nxtQueueSubmit"));
+
+    std::string json = DumpProfilingDataJSON();
+    ASSERT_NE(std::string::npos, json.find("{\"name\": \"nxtDeviceCreateBufferBuilder\", \"count\": 3,"));
+    ASSERT_NE(std::string::npos, json.find("{\"name\": \"nxtBufferBuilderSetSize\", \"count\": 1,"));
+    ASSERT_EQ(std::string::npos, json.find("nxtQueueSubmit"));
+
+    ResetProfilingData();
+    ASSERT_EQ(0u, FindHistogram("nxtDeviceCreateBufferBuilder")->GetCount());
+}
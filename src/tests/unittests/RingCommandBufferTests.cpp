@@ -0,0 +1,168 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "wire/RingCommandBuffer.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace nxt::wire;
+
+namespace {
+
+    // Commands are sequences of uint32_t that the handler concatenates.
+    class RecordingHandler : public CommandHandler {
+      public:
+        const uint8_t* HandleCommands(const uint8_t* commands, size_t size) override {
+            EXPECT_EQ(0u, size % sizeof(uint32_t));
+            size_t oldSize = values.size();
+            values.resize(oldSize + size / sizeof(uint32_t));
+            memcpy(&values[oldSize], commands, size);
+            chunkCount++;
+            return commands + size;
+        }
+
+        std::vector<uint32_t> values;
+        size_t chunkCount = 0;
+    };
+
+    void WriteCommand(CommandRing* ring, uint32_t firstValue, uint32_t count) {
+        uint32_t* data = static_cast<uint32_t*>(ring->Allocate(count * sizeof(uint32_t)));
+        for (uint32_t i = 0; i < count; ++i) {
+            data[i] = firstValue + i;
+        }
+    }
+
+    void ExpectSequence(const std::vector<uint32_t>& values, uint32_t count) {
+        ASSERT_EQ(count, values.size());
+        for (uint32_t i = 0; i < count; ++i) {
+            ASSERT_EQ(i, values[i]);
+        }
+    }
+
+}  // anonymous namespace
+
+// Test commands are only seen after being published, and are batched in a single chunk.
+TEST(CommandRing, PublishMakesCommandsVisible) {
+    CommandRing ring(4096);
+    RecordingHandler handler;
+
+    WriteCommand(&ring, 0, 3);
+    WriteCommand(&ring, 3, 2);
+    ASSERT_TRUE(ring.HandlePublishedCommands(&handler));
+    ASSERT_TRUE(handler.values.empty());
+
+    ring.Publish();
+    ASSERT_TRUE(ring.WaitForPublishedCommands(std::chrono::microseconds(0)));
+    ASSERT_TRUE(ring.HandlePublishedCommands(&handler));
+    ExpectSequence(handler.values, 5);
+    ASSERT_EQ(1u, handler.chunkCount);
+
+    // Nothing new is published
+    ASSERT_FALSE(ring.WaitForPublishedCommands(std::chrono::microseconds(0)));
+}
+
+// Test commands stay contiguous when wrapping around the end of the ring.
+TEST(CommandRing, Wraparound) {
+    CommandRing ring(4096);
+    RecordingHandler handler;
+
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        uint32_t count = 1 + i % 37;
+        WriteCommand(&ring, value, count);
+        value += count;
+        ring.Publish();
+        ASSERT_TRUE(ring.HandlePublishedCommands(&handler));
+    }
+    ExpectSequence(handler.values, value);
+}
+
+// Test commands that don't fit in the ring are still transmitted.
+TEST(CommandRing, LargeCommand) {
+    CommandRing ring(4096);
+    RecordingHandler handler;
+
+    WriteCommand(&ring, 0, 10);
+    WriteCommand(&ring, 10, 10000);
+    WriteCommand(&ring, 10010, 10);
+    ring.Publish();
+
+    ASSERT_TRUE(ring.HandlePublishedCommands(&handler));
+    ExpectSequence(handler.values, 10020);
+}
+
+// Test the ring transmits commands between two threads, with the producer waiting when full.
+TEST(CommandRing, ProducerConsumerThreads) {
+    CommandRing ring(4096);
+    RecordingHandler handler;
+
+    constexpr uint32_t kCommandCount = 20000;
+    uint32_t totalCount = 0;
+    for (uint32_t i = 0; i < kCommandCount; ++i) {
+        totalCount += 1 + i % 61;
+    }
+
+    std::thread producer([&ring]() {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < kCommandCount; ++i) {
+            uint32_t count = 1 + i % 61;
+            WriteCommand(&ring, value, count);
+            value += count;
+            if (i % 7 == 0) {
+                ring.Publish();
+            }
+        }
+        ring.Publish();
+    });
+
+    while (handler.values.size() < totalCount) {
+        if (ring.WaitForPublishedCommands(std::chrono::milliseconds(10))) {
+            ASSERT_TRUE(ring.HandlePublishedCommands(&handler));
+        }
+    }
+    producer.join();
+
+    ExpectSequence(handler.values, totalCount);
+}
+
+// Test two threads that both fill the ring going to the other without draining theirs don't wait
+// forever: allocations time out and put the rings in error.
+TEST(CommandRing, FullInBothDirectionsTimesOut) {
+    CommandRing c2sRing(4096, std::chrono::milliseconds(10));
+    CommandRing s2cRing(4096, std::chrono::milliseconds(10));
+
+    auto fill = [](CommandRing* ring) {
+        for (uint32_t i = 0; i < 10000; ++i) {
+            WriteCommand(ring, 0, 16);
+        }
+        ring->Publish();
+    };
+
+    std::thread client(fill, &c2sRing);
+    std::thread server(fill, &s2cRing);
+    client.join();
+    server.join();
+
+    ASSERT_TRUE(c2sRing.HasError());
+    ASSERT_TRUE(s2cRing.HasError());
+
+    // The commands published before the error are still received.
+    RecordingHandler handler;
+    ASSERT_TRUE(c2sRing.HandlePublishedCommands(&handler));
+    ASSERT_FALSE(handler.values.empty());
+}
@@ -0,0 +1,98 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "common/ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+namespace {
+
+    // Runs a ParallelFor on the pool and checks each index was run exactly once on a valid thread.
+    void CheckParallelFor(ThreadPool* pool, uint32_t count) {
+        std::unique_ptr<std::atomic<uint32_t>[]> runs(new std::atomic<uint32_t>[count]);
+        for (uint32_t i = 0; i < count; ++i) {
+            runs[i] = 0;
+        }
+
+        std::atomic<bool> validThreadIndices(true);
+        pool->ParallelFor(count, [&](uint32_t index, uint32_t threadIndex) {
+            runs[index]++;
+            if (threadIndex >= pool->GetThreadCount()) {
+                validThreadIndices = false;
+            }
+        });
+
+        ASSERT_TRUE(validThreadIndices);
+        for (uint32_t i = 0; i < count; ++i) {
+            ASSERT_EQ(runs[i], 1u) << "index " << i;
+        }
+    }
+
+}  // anonymous namespace
+
+// Test each iteration is run exactly once.
+TEST(ThreadPoolTests, AllIterationsRunOnce) {
+    ThreadPool pool(4);
+    ASSERT_EQ(pool.GetThreadCount(), 4u);
+    CheckParallelFor(&pool, 1000);
+}
+
+// Test a pool with a single thread runs everything on the calling thread.
+TEST(ThreadPoolTests, SingleThread) {
+    ThreadPool pool(1);
+    ASSERT_EQ(pool.GetThreadCount(), 1u);
+    CheckParallelFor(&pool, 100);
+}
+
+// Test the default pool has at least one thread.
+TEST(ThreadPoolTests, DefaultThreadCount) {
+    ThreadPool pool;
+    ASSERT_GE(pool.GetThreadCount(), 1u);
+    CheckParallelFor(&pool, 100);
+}
+
+// Test loops with fewer iterations than threads, and with none.
+TEST(ThreadPoolTests, FewerIterationsThanThreads) {
+    ThreadPool pool(8);
+    CheckParallelFor(&pool, 3);
+    CheckParallelFor(&pool, 1);
+
+    bool ran = false;
+    pool.ParallelFor(0, [&](uint32_t, uint32_t) { ran = true; });
+    ASSERT_FALSE(ran);
+}
+
+// Test the pool can be reused for many loops, including ones with iterations of uneven length
+// that make threads steal work.
+TEST(ThreadPoolTests, RepeatedLoops) {
+    ThreadPool pool(3);
+    for (uint32_t i = 0; i < 50; ++i) {
+        CheckParallelFor(&pool, i * 7);
+    }
+
+    std::atomic<uint64_t> sum(0);
+    pool.ParallelFor(64, [&](uint32_t index, uint32_t) {
+        // The first iterations are much longer than the others.
+        uint64_t iterations = index < 8 ? 100000 : 10;
+        volatile uint64_t work = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            work = work + i;
+        }
+        sum += index;
+    });
+    ASSERT_EQ(sum, 64u * 63u / 2u);
+}
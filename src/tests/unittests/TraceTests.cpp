@@ -0,0 +1,174 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "common/Trace.h"
+#include "wire/TerribleCommandBuffer.h"
+#include "wire/Wire.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace backend { namespace null {
+    void Init(nxtProcTable* procs, nxtDevice* device);
+}}  // namespace backend::null
+
+using namespace testing;
+
+namespace {
+
+    size_t CountOccurrences(const std::string& str, const std::string& pattern) {
+        size_t count = 0;
+        for (size_t pos = str.find(pattern); pos != std::string::npos;
+             pos = str.find(pattern, pos + 1)) {
+            count++;
+        }
+        return count;
+    }
+
+    bool HasEvent(const std::string& json, const char* category, const char* name) {
+        std::string event = std::string("\"cat\": \"") + category + "\", \"name\": \"" + name + "\"";
+        return json.find(event) != std::string::npos;
+    }
+
+}  // anonymous namespace
+
+class TraceTests : public Test {
+    protected:
+        void SetUp() override {
+            backend::null::Init(&mProcs, &mDevice);
+            ClearTraceEvents();
+        }
+
+        void TearDown() override {
+            SetTracingEnabled(false);
+            ClearTraceEvents();
+            mProcs.deviceRelease(mDevice);
+        }
+
+        // Creates a buffer and submits a command buffer using it.
+        void DoWork(const nxtProcTable& procs, nxtDevice device) {
+            nxtQueueBuilder queueBuilder = procs.deviceCreateQueueBuilder(device);
+            nxtQueue queue = procs.queueBuilderGetResult(queueBuilder);
+            procs.queueBuilderRelease(queueBuilder);
+
+            nxtBufferBuilder bufferBuilder = procs.deviceCreateBufferBuilder(device);
+            procs.bufferBuilderSetSize(bufferBuilder, 4);
+            procs.bufferBuilderSetAllowedUsage(bufferBuilder, NXT_BUFFER_USAGE_BIT_TRANSFER_DST);
+            procs.bufferBuilderSetInitialUsage(bufferBuilder, NXT_BUFFER_USAGE_BIT_TRANSFER_DST);
+            nxtBuffer buffer = procs.bufferBuilderGetResult(bufferBuilder);
+            procs.bufferBuilderRelease(bufferBuilder);
+
+            nxtCommandBufferBuilder commandBufferBuilder =
+                procs.deviceCreateCommandBufferBuilder(device);
+            nxtCommandBuffer commandBuffer =
+                procs.commandBufferBuilderGetResult(commandBufferBuilder);
+            procs.commandBufferBuilderRelease(commandBufferBuilder);
+
+            procs.queueSubmit(queue, 1, &commandBuffer);
+            procs.deviceTick(device);
+
+            procs.commandBufferRelease(commandBuffer);
+            procs.bufferRelease(buffer);
+            procs.queueRelease(queue);
+        }
+
+        nxtProcTable mProcs;
+        nxtDevice mDevice;
+};
+
+// Test no events are recorded when tracing is off.
+TEST_F(TraceTests, NoEventsWhenDisabled) {
+    SetTracingEnabled(false);
+    DoWork(mProcs, mDevice);
+
+    ASSERT_EQ(0u, CountOccurrences(GetTraceEventsJSON(), "\"ph\""));
+}
+
+// Test the hot spots of the backend record events.
+TEST_F(TraceTests, BackendEvents) {
+    SetTracingEnabled(true);
+    DoWork(mProcs, mDevice);
+    SetTracingEnabled(false);
+
+    std::string json = GetTraceEventsJSON();
+    ASSERT_TRUE(HasEvent(json, "builder", "QueueBuilderGetResult"));
+    ASSERT_TRUE(HasEvent(json, "builder", "BufferBuilderGetResult"));
+    ASSERT_TRUE(HasEvent(json, "builder", "CommandBufferBuilderGetResult"));
+    ASSERT_TRUE(HasEvent(json, "backend", "CommandBufferBuilder::ValidateGetResult"));
+    ASSERT_TRUE(HasEvent(json, "backend", "QueueBase::Flush"));
+    ASSERT_TRUE(HasEvent(json, "null", "Queue::Submit"));
+    ASSERT_TRUE(HasEvent(json, "backend", "DeviceBase::Tick"));
+
+    // Events recorded after tracing is turned off are ignored, and events can be cleared.
+    DoWork(mProcs, mDevice);
+    ASSERT_EQ(json, GetTraceEventsJSON());
+    ClearTraceEvents();
+    ASSERT_EQ(0u, CountOccurrences(GetTraceEventsJSON(), "\"ph\""));
+}
+
+// Test the wire records events on both sides.
+TEST_F(TraceTests, WireEvents) {
+    nxt::wire::TerribleCommandBuffer* c2sBuf = new nxt::wire::TerribleCommandBuffer();
+    nxt::wire::TerribleCommandBuffer* s2cBuf = new nxt::wire::TerribleCommandBuffer();
+    nxt::wire::CommandHandler* server =
+        nxt::wire::NewServerCommandHandler(mDevice, mProcs, s2cBuf);
+    c2sBuf->SetHandler(server);
+
+    nxtProcTable clientProcs;
+    nxtDevice clientDevice;
+    nxt::wire::CommandHandler* client =
+        nxt::wire::NewClientDevice(&clientProcs, &clientDevice, c2sBuf);
+    s2cBuf->SetHandler(client);
+
+    SetTracingEnabled(true);
+    DoWork(clientProcs, clientDevice);
+    c2sBuf->Flush();
+    s2cBuf->Flush();
+    SetTracingEnabled(false);
+
+    std::string json = GetTraceEventsJSON();
+    ASSERT_TRUE(HasEvent(json, "wire", "Server::HandleCommands"));
+    ASSERT_TRUE(HasEvent(json, "wire", "Client::HandleCommands"));
+    ASSERT_TRUE(HasEvent(json, "null", "Queue::Submit"));
+
+    delete client;
+    delete server;
+    delete s2cBuf;
+    delete c2sBuf;
+}
+
+// Test each thread keeps its most recent events, even after it exits.
+TEST_F(TraceTests, PerThreadRingBuffers) {
+    SetTracingEnabled(true);
+
+    std::thread thread([]() {
+        for (size_t i = 0; i < kTraceRingBufferSize + 10; ++i) {
+            NXT_TRACE_EVENT("test", "ThreadEvent");
+        }
+    });
+    thread.join();
+
+    {
+        NXT_TRACE_EVENT_DETAIL("test", "MainThreadEvent", "some \"detail\"");
+    }
+    SetTracingEnabled(false);
+
+    std::string json = GetTraceEventsJSON();
+    ASSERT_EQ(kTraceRingBufferSize, CountOccurrences(json, "\"ThreadEvent\""));
+    ASSERT_EQ(1u, CountOccurrences(json, "\"MainThreadEvent\""));
+    ASSERT_NE(std::string::npos, json.find("\"args\": {\"detail\": \"some \\\"detail\\\"\"}"));
+}
@@ -0,0 +1,232 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "wire/Wire.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+namespace backend { namespace null {
+    void Init(nxtProcTable* procs, nxtDevice* device);
+}}  // namespace backend::null
+
+using namespace testing;
+using namespace nxt::wire;
+
+// The global allocation functions are replaced for the whole test binary, they only count
+// allocations while sCountAllocations is set.
+static std::atomic<bool> sCountAllocations(false);
+static std::atomic<uint64_t> sAllocationCount(0);
+
+void* operator new(size_t size) {
+    if (sCountAllocations) {
+        sAllocationCount++;
+    }
+    void* result = malloc(size == 0 ? 1 : size);
+    if (result == nullptr) {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+namespace {
+
+    // Keeps the commands of the client so that they can be replayed.
+    class RecordingSerializer : public CommandSerializer {
+      public:
+        void* GetCmdSpace(size_t size) override {
+            size_t offset = mCommands.size();
+            mCommands.resize(offset + size);
+            return &mCommands[offset];
+        }
+        void Flush() override {
+        }
+
+        std::vector<uint8_t> TakeCommands() {
+            std::vector<uint8_t> commands;
+            commands.swap(mCommands);
+            return commands;
+        }
+
+      private:
+        std::vector<uint8_t> mCommands;
+    };
+
+    // Drops the return commands, its storage is allocated upfront so that it doesn't count as
+    // allocations of the server.
+    class DiscardingSerializer : public CommandSerializer {
+      public:
+        DiscardingSerializer() : mBuffer(1 << 16) {
+        }
+
+        void* GetCmdSpace(size_t size) override {
+            if (size > mBuffer.size()) {
+                return nullptr;
+            }
+            if (mOffset + size > mBuffer.size()) {
+                mOffset = 0;
+            }
+            uint8_t* result = &mBuffer[mOffset];
+            mOffset += size;
+            return result;
+        }
+        void Flush() override {
+            mOffset = 0;
+        }
+
+      private:
+        std::vector<uint8_t> mBuffer;
+        size_t mOffset = 0;
+    };
+
+}  // anonymous namespace
+
+// Test the server doesn't allocate when decoding a frame it has seen before, including commands
+// with arrays of objects. The null backend doesn't allocate for these commands either.
+TEST(WireServerAllocationTests, NoAllocationInSteadyState) {
+    nxtProcTable backendProcs;
+    nxtDevice backendDevice;
+    backend::null::Init(&backendProcs, &backendDevice);
+
+    RecordingSerializer c2sBuf;
+    DiscardingSerializer s2cBuf;
+    CommandHandler* server = NewServerCommandHandler(backendDevice, backendProcs, &s2cBuf);
+
+    nxtProcTable procs;
+    nxtDevice device;
+    CommandHandler* client = NewClientDevice(&procs, &device, &c2sBuf);
+
+    // Objects used by the frame.
+    nxtQueueBuilder queueBuilder = procs.deviceCreateQueueBuilder(device);
+    nxtQueue queue = procs.queueBuilderGetResult(queueBuilder);
+    procs.queueBuilderRelease(queueBuilder);
+
+    nxtBufferBuilder bufferBuilder = procs.deviceCreateBufferBuilder(device);
+    procs.bufferBuilderSetSize(bufferBuilder, 256);
+    procs.bufferBuilderSetAllowedUsage(bufferBuilder, static_cast<nxtBufferUsageBit>(
+        NXT_BUFFER_USAGE_BIT_TRANSFER_DST | NXT_BUFFER_USAGE_BIT_UNIFORM));
+    procs.bufferBuilderSetInitialUsage(bufferBuilder, NXT_BUFFER_USAGE_BIT_TRANSFER_DST);
+    nxtBuffer buffer = procs.bufferBuilderGetResult(bufferBuilder);
+    procs.bufferBuilderRelease(bufferBuilder);
+
+    nxtCommandBuffer commandBuffers[4];
+    for (nxtCommandBuffer& commandBuffer : commandBuffers) {
+        nxtCommandBufferBuilder builder = procs.deviceCreateCommandBufferBuilder(device);
+        commandBuffer = procs.commandBufferBuilderGetResult(builder);
+        procs.commandBufferBuilderRelease(builder);
+    }
+
+    std::vector<uint8_t> setup = c2sBuf.TakeCommands();
+    ASSERT_NE(nullptr, server->HandleCommands(setup.data(), setup.size()));
+
+    // The frame.
+    uint32_t data[64] = {};
+    for (int i = 0; i < 10; ++i) {
+        procs.bufferTransitionUsage(buffer, NXT_BUFFER_USAGE_BIT_TRANSFER_DST);
+        procs.bufferSetSubData(buffer, 0, 64, data);
+        procs.bufferTransitionUsage(buffer, NXT_BUFFER_USAGE_BIT_UNIFORM);
+        procs.queueSubmit(queue, 4, commandBuffers);
+    }
+    std::vector<uint8_t> frame = c2sBuf.TakeCommands();
+
+    // The first frame warms up the storage of the server.
+    ASSERT_NE(nullptr, server->HandleCommands(frame.data(), frame.size()));
+
+    sAllocationCount = 0;
+    sCountAllocations = true;
+    bool success = true;
+    for (int i = 0; i < 100; ++i) {
+        success = success && server->HandleCommands(frame.data(), frame.size()) != nullptr;
+    }
+    sCountAllocations = false;
+
+    ASSERT_TRUE(success);
+    ASSERT_EQ(0u, sAllocationCount.load());
+
+    delete client;
+    delete server;
+    backendProcs.deviceRelease(backendDevice);
+}
+
+// Benchmark creating and releasing bind groups on the client, which shouldn't allocate once its
+// object slabs and free lists are warm.
+TEST(WireClientAllocationTests, CreateAndReleaseBindGroups) {
+    constexpr int kObjectCount = 1000;
+    constexpr int kIterationCount = 1000;
+
+    DiscardingSerializer c2sBuf;
+    nxtProcTable procs;
+    nxtDevice device;
+    CommandHandler* client = NewClientDevice(&procs, &device, &c2sBuf);
+
+    std::vector<nxtBindGroup> bindGroups(kObjectCount);
+    auto CreateAndReleaseBindGroups = [&]() {
+        for (nxtBindGroup& bindGroup : bindGroups) {
+            nxtBindGroupBuilder builder = procs.deviceCreateBindGroupBuilder(device);
+            bindGroup = procs.bindGroupBuilderGetResult(builder);
+            procs.bindGroupBuilderRelease(builder);
+        }
+        for (nxtBindGroup bindGroup : bindGroups) {
+            procs.bindGroupRelease(bindGroup);
+        }
+    };
+
+    // The first iteration creates the slabs.
+    CreateAndReleaseBindGroups();
+
+    sAllocationCount = 0;
+    sCountAllocations = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterationCount; ++i) {
+        CreateAndReleaseBindGroups();
+    }
+    auto end = std::chrono::steady_clock::now();
+    sCountAllocations = false;
+
+    ASSERT_EQ(0u, sAllocationCount.load());
+
+    double totalNs = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    std::cout << "[ PERF     ] " << kObjectCount * kIterationCount << " bind groups in "
+              << totalNs / 1000000.0 << " ms, " << totalNs / (kObjectCount * kIterationCount)
+              << " ns per bind group" << std::endl;
+
+    delete client;
+}
@@ -0,0 +1,286 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "wire/CompactCommandBuffer.h"
+#include "wire/CompactEncoding.h"
+#include "wire/Wire.h"
+#include "wire/WireCmd.h"
+
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace nxt::wire;
+
+namespace {
+
+    // A transport that drops everything, the commands of a client are only measured.
+    class DiscardingSerializer : public CommandSerializer {
+      public:
+        void* GetCmdSpace(size_t size) override {
+            mBuffer.resize(size);
+            return mBuffer.data();
+        }
+        void Flush() override {
+        }
+
+      private:
+        std::vector<uint8_t> mBuffer;
+    };
+
+    // Appends a command buffer builder recording of count DrawArrays calls to commands.
+    void AppendDrawRecording(std::vector<uint8_t>* commands, uint32_t self, uint32_t count) {
+        CommandBufferBuilderEncodedCmd recording;
+        recording.self = self;
+        recording.commandsSize =
+            static_cast<uint32_t>(count * sizeof(CommandBufferBuilderDrawArraysCmd));
+
+        size_t offset = commands->size();
+        commands->resize(offset + recording.GetRequiredSize());
+        memcpy(&(*commands)[offset], &recording, sizeof(recording));
+
+        auto* draws =
+            reinterpret_cast<CommandBufferBuilderDrawArraysCmd*>(&(*commands)[offset] + sizeof(recording));
+        for (uint32_t i = 0; i < count; ++i) {
+            CommandBufferBuilderDrawArraysCmd draw;
+            draw.self = self;
+            draw.vertexCount = 3 + i;
+            draw.instanceCount = 1;
+            draw.firstVertex = 0;
+            draw.firstInstance = 0;
+            memcpy(&draws[i], &draw, sizeof(draw));
+        }
+    }
+
+}  // anonymous namespace
+
+// Test integers are varints and round-trip, including their extreme values.
+TEST(WireCompactEncodingTests, IntegersRoundTrip) {
+    CompactWriter writer;
+    writer.Write(uint32_t(0));
+    writer.Write(uint32_t(127));
+    writer.Write(uint32_t(128));
+    writer.Write(std::numeric_limits<uint32_t>::max());
+    writer.Write(std::numeric_limits<uint64_t>::max());
+    writer.Write(true);
+    writer.Write(1.5f);
+    ASSERT_EQ(1u + 1u + 2u + 5u + 10u + 1u + 4u, writer.GetData().size());
+
+    CompactReader reader;
+    reader.Reset(writer.GetData().data(), writer.GetData().size());
+
+    uint32_t value32;
+    uint64_t value64;
+    bool boolean;
+    float number;
+    reader.Read(&value32);
+    ASSERT_EQ(0u, value32);
+    reader.Read(&value32);
+    ASSERT_EQ(127u, value32);
+    reader.Read(&value32);
+    ASSERT_EQ(128u, value32);
+    reader.Read(&value32);
+    ASSERT_EQ(std::numeric_limits<uint32_t>::max(), value32);
+    reader.Read(&value64);
+    ASSERT_EQ(std::numeric_limits<uint64_t>::max(), value64);
+    reader.Read(&boolean);
+    ASSERT_TRUE(boolean);
+    reader.Read(&number);
+    ASSERT_EQ(1.5f, number);
+
+    ASSERT_TRUE(reader.IsValid());
+    ASSERT_EQ(0u, reader.GetRemainingSize());
+}
+
+// Test IDs are delta-encoded across frames, including deltas going backwards.
+TEST(WireCompactEncodingTests, IdsAreDeltaEncoded) {
+    CompactWriter writer;
+    CompactReader reader;
+    std::vector<uint32_t> ids = {1000, 1001, 1001, 999, 0, std::numeric_limits<uint32_t>::max()};
+
+    for (uint32_t id : ids) {
+        writer.Clear();
+        writer.WriteId(id);
+        reader.Reset(writer.GetData().data(), writer.GetData().size());
+
+        uint32_t decoded;
+        reader.ReadId(&decoded);
+        ASSERT_TRUE(reader.IsValid());
+        ASSERT_EQ(id, decoded);
+    }
+
+    // Successive IDs take a single byte, also across frames since Clear() keeps the previous ID.
+    writer.Clear();
+    writer.WriteId(1000);
+    writer.Clear();
+    writer.WriteId(1001);
+    ASSERT_EQ(1u, writer.GetData().size());
+}
+
+// Test the commands of recordings get the compact encoding too, and round-trip.
+TEST(WireCompactEncodingTests, RecordedCommandsAreCompact) {
+    std::vector<uint8_t> native;
+    AppendDrawRecording(&native, 42, 100);
+
+    CompactWriter writer;
+    const uint8_t* commands = native.data();
+    size_t size = native.size();
+    ASSERT_TRUE(EncodeCompactCommand(&commands, &size, &writer));
+    ASSERT_EQ(0u, size);
+
+    // Each draw is its command ID, a zero ID delta and four small varints.
+    ASSERT_LT(writer.GetData().size(), 100u * 7u);
+
+    CompactReader reader;
+    reader.Reset(writer.GetData().data(), writer.GetData().size());
+    std::vector<uint8_t> decoded;
+    ASSERT_TRUE(DecodeCompactCommand(&reader, &decoded));
+    ASSERT_EQ(0u, reader.GetRemainingSize());
+    ASSERT_EQ(native, decoded);
+}
+
+// Test recordings inside recordings are rejected.
+TEST(WireCompactEncodingTests, NestedRecordingIsAnError) {
+    std::vector<uint8_t> inner;
+    AppendDrawRecording(&inner, 42, 1);
+
+    CommandBufferBuilderEncodedCmd recording;
+    recording.self = 42;
+    recording.commandsSize = static_cast<uint32_t>(inner.size());
+    std::vector<uint8_t> native(sizeof(recording));
+    memcpy(native.data(), &recording, sizeof(recording));
+    native.insert(native.end(), inner.begin(), inner.end());
+
+    CompactWriter writer;
+    const uint8_t* commands = native.data();
+    size_t size = native.size();
+    ASSERT_FALSE(EncodeCompactCommand(&commands, &size, &writer));
+}
+
+// Test reading truncated or malformed data puts the reader in an error state.
+TEST(WireCompactEncodingTests, MalformedDataIsAnError) {
+    uint8_t truncatedVarint[] = {0x80};
+    CompactReader reader;
+    uint32_t value;
+    reader.Reset(truncatedVarint, sizeof(truncatedVarint));
+    reader.Read(&value);
+    ASSERT_FALSE(reader.IsValid());
+
+    // 2^32 doesn't fit in an uint32_t
+    uint8_t tooLarge[] = {0x80, 0x80, 0x80, 0x80, 0x10};
+    reader.Reset(tooLarge, sizeof(tooLarge));
+    reader.Read(&value);
+    ASSERT_FALSE(reader.IsValid());
+
+    uint8_t notABool[] = {2};
+    bool boolean;
+    reader.Reset(notABool, sizeof(notABool));
+    reader.Read(&boolean);
+    ASSERT_FALSE(reader.IsValid());
+
+    uint8_t bytes[4];
+    reader.Reset(bytes, 2);
+    reader.ReadBytes(bytes, sizeof(bytes));
+    ASSERT_FALSE(reader.IsValid());
+}
+
+// Test compression round-trips for compressible and incompressible data.
+TEST(WireCompactEncodingTests, CompressionRoundTrip) {
+    std::mt19937 random(1234);
+    std::vector<std::vector<uint8_t>> inputs(4);
+    inputs[1].assign(3, 7);
+    inputs[2].assign(100000, 42);
+    for (size_t i = 0; i < 50000; ++i) {
+        inputs[3].push_back(static_cast<uint8_t>(random()));
+        inputs[3].push_back(static_cast<uint8_t>(i % 13));
+    }
+
+    for (const auto& input : inputs) {
+        std::vector<uint8_t> compressed;
+        CompressBlock(input.data(), input.size(), &compressed);
+
+        std::vector<uint8_t> decompressed(input.size());
+        ASSERT_TRUE(DecompressBlock(compressed.data(), compressed.size(), decompressed.data(),
+                                    decompressed.size()));
+        ASSERT_EQ(input, decompressed);
+    }
+}
+
+// Test the decompressor rejects data that doesn't produce exactly the expected size.
+TEST(WireCompactEncodingTests, CorruptCompressedDataIsAnError) {
+    std::vector<uint8_t> input(1000, 42);
+    std::vector<uint8_t> compressed;
+    CompressBlock(input.data(), input.size(), &compressed);
+
+    std::vector<uint8_t> decompressed(input.size() + 1);
+    ASSERT_FALSE(DecompressBlock(compressed.data(), compressed.size(), decompressed.data(),
+                                 input.size() + 1));
+    ASSERT_FALSE(DecompressBlock(compressed.data(), compressed.size() - 1, decompressed.data(),
+                                 input.size()));
+
+    // A match going back before the start of the output.
+    uint8_t badOffset[] = {0x10, 42, 0x10, 0x00, 0x00};
+    ASSERT_FALSE(DecompressBlock(badOffset, sizeof(badOffset), decompressed.data(), 100));
+}
+
+// Records frames of typical builder calls and reports how many bytes each encoding needs.
+TEST(WireCompactEncodingTests, BytesPerFrameReport) {
+    constexpr int kFrameCount = 100;
+    constexpr int kBuffersPerFrame = 20;
+
+    for (WireEncoding encoding : {WireEncoding::Compact, WireEncoding::CompactCompressed}) {
+        DiscardingSerializer transport;
+        CompactCommandSerializer serializer(&transport, encoding);
+
+        nxtProcTable procs;
+        nxtDevice device;
+        CommandHandler* client = NewClientDevice(&procs, &device, &serializer);
+
+        for (int frame = 0; frame < kFrameCount; ++frame) {
+            nxtCommandBufferBuilder commands = procs.deviceCreateCommandBufferBuilder(device);
+            for (int i = 0; i < kBuffersPerFrame; ++i) {
+                nxtBufferBuilder builder = procs.deviceCreateBufferBuilder(device);
+                procs.bufferBuilderSetSize(builder, 256);
+                procs.bufferBuilderSetAllowedUsage(builder, NXT_BUFFER_USAGE_BIT_TRANSFER_DST);
+                procs.bufferBuilderSetInitialUsage(builder, NXT_BUFFER_USAGE_BIT_TRANSFER_DST);
+                nxtBuffer buffer = procs.bufferBuilderGetResult(builder);
+                procs.bufferBuilderRelease(builder);
+
+                procs.commandBufferBuilderTransitionBufferUsage(commands, buffer,
+                                                                NXT_BUFFER_USAGE_BIT_TRANSFER_DST);
+                procs.bufferRelease(buffer);
+            }
+            nxtCommandBuffer commandBuffer = procs.commandBufferBuilderGetResult(commands);
+            procs.commandBufferBuilderRelease(commands);
+            procs.commandBufferRelease(commandBuffer);
+            serializer.Flush();
+        }
+
+        const CompactEncodingStats& stats = serializer.GetStats();
+        ASSERT_EQ(static_cast<uint64_t>(kFrameCount), stats.frameCount);
+        ASSERT_LT(stats.compactBytes, stats.nativeBytes);
+        ASSERT_LE(stats.sentBytes, stats.compactBytes + stats.frameCount * sizeof(CompactFrameHeader));
+
+        std::cout << "[ PERF     ] "
+                  << (encoding == WireEncoding::Compact ? "Compact" : "CompactCompressed")
+                  << std::endl;
+        PrintCompactEncodingReport(stats, std::cout);
+
+        delete client;
+    }
+}
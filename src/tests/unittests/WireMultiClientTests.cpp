@@ -0,0 +1,314 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "wire/MultiClientServer.h"
+#include "wire/Wire.h"
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace backend { namespace null {
+    void Init(nxtProcTable* procs, nxtDevice* device);
+}}  // namespace backend::null
+
+using namespace testing;
+using namespace nxt::wire;
+
+namespace {
+
+    // Gives the commands to the handler on Flush, or before running out of space.
+    class BufferedCommandSerializer : public CommandSerializer {
+      public:
+        BufferedCommandSerializer() : mBuffer(1 << 20) {
+        }
+
+        void SetHandler(CommandHandler* handler) {
+            mHandler = handler;
+        }
+
+        void* GetCmdSpace(size_t size) override {
+            if (mOffset + size > mBuffer.size()) {
+                Flush();
+                if (size > mBuffer.size()) {
+                    mBuffer.resize(size);
+                }
+            }
+
+            uint8_t* result = &mBuffer[mOffset];
+            mOffset += size;
+            return result;
+        }
+
+        void Flush() override {
+            if (mOffset != 0) {
+                mHandler->HandleCommands(mBuffer.data(), mOffset);
+            }
+            mOffset = 0;
+        }
+
+      private:
+        CommandHandler* mHandler = nullptr;
+        std::vector<uint8_t> mBuffer;
+        size_t mOffset = 0;
+    };
+
+    struct MapReadResult {
+        bool done = false;
+        nxtBufferMapReadStatus status;
+        uint32_t value = 0;
+    };
+
+    void StoreMapReadResult(nxtBufferMapReadStatus status,
+                            const void* ptr,
+                            nxtCallbackUserdata userdata) {
+        auto result = reinterpret_cast<MapReadResult*>(static_cast<uintptr_t>(userdata));
+        result->done = true;
+        result->status = status;
+        if (ptr != nullptr) {
+            result->value = *reinterpret_cast<const uint32_t*>(ptr);
+        }
+    }
+
+    // A wire client connected to the multi-client server. Clients live in the same process so
+    // they use their proc table directly instead of nxtSetProcs.
+    class TestClient {
+      public:
+        TestClient(MultiClientServer* server) : mServer(server) {
+            mServerHandler = server->AddClient(&mS2cBuf);
+            mC2sBuf.SetHandler(mServerHandler);
+            mWireClient = NewClientDevice(&procs, &device, &mC2sBuf);
+            mS2cBuf.SetHandler(mWireClient);
+
+            nxtQueueBuilder queueBuilder = procs.deviceCreateQueueBuilder(device);
+            queue = procs.queueBuilderGetResult(queueBuilder);
+            procs.queueBuilderRelease(queueBuilder);
+        }
+
+        ~TestClient() {
+            mServer->RemoveClient(mServerHandler);
+            delete mWireClient;
+        }
+
+        nxtBuffer CreateBuffer(uint32_t size) {
+            nxtBufferBuilder builder = procs.deviceCreateBufferBuilder(device);
+            procs.bufferBuilderSetSize(builder, size);
+            procs.bufferBuilderSetAllowedUsage(builder, static_cast<nxtBufferUsageBit>(
+                NXT_BUFFER_USAGE_BIT_MAP_READ | NXT_BUFFER_USAGE_BIT_TRANSFER_DST));
+            procs.bufferBuilderSetInitialUsage(builder, NXT_BUFFER_USAGE_BIT_TRANSFER_DST);
+            nxtBuffer buffer = procs.bufferBuilderGetResult(builder);
+            procs.bufferBuilderRelease(builder);
+            return buffer;
+        }
+
+        // Requests the content of the buffer, the null backend completes the map on Submit.
+        void MapRead(nxtBuffer buffer, MapReadResult* result) {
+            procs.bufferTransitionUsage(buffer, NXT_BUFFER_USAGE_BIT_MAP_READ);
+            auto userdata = static_cast<nxtCallbackUserdata>(reinterpret_cast<uintptr_t>(result));
+            procs.bufferMapReadAsync(buffer, 0, sizeof(uint32_t), StoreMapReadResult, userdata);
+            procs.queueSubmit(queue, 0, nullptr);
+        }
+
+        void Flush() {
+            mC2sBuf.Flush();
+        }
+
+        const WireClientCounters& GetCounters() const {
+            return mServer->GetCounters(mServerHandler);
+        }
+
+        CommandHandler* GetServerHandler() const {
+            return mServerHandler;
+        }
+
+        nxtProcTable procs;
+        nxtDevice device;
+        nxtQueue queue;
+
+      private:
+        MultiClientServer* mServer;
+        CommandHandler* mServerHandler = nullptr;
+        CommandHandler* mWireClient = nullptr;
+        BufferedCommandSerializer mC2sBuf;
+        BufferedCommandSerializer mS2cBuf;
+    };
+
+}  // anonymous namespace
+
+class WireMultiClientTests : public Test {
+    protected:
+        void SetUp() override {
+            backend::null::Init(&mBackendProcs, &mBackendDevice);
+        }
+
+        void TearDown() override {
+            mBackendProcs.deviceRelease(mBackendDevice);
+        }
+
+        MultiClientServer* CreateServer(size_t clientBudget = kDefaultClientBudget) {
+            return new MultiClientServer(mBackendDevice, mBackendProcs, clientBudget);
+        }
+
+    private:
+        nxtProcTable mBackendProcs;
+        nxtDevice mBackendDevice;
+};
+
+// Test clients using the same IDs for different objects don't see each other's objects.
+TEST_F(WireMultiClientTests, ClientsHaveSeparateIdSpaces) {
+    std::unique_ptr<MultiClientServer> server(CreateServer());
+    TestClient client1(server.get());
+    TestClient client2(server.get());
+
+    nxtBuffer buffer1 = client1.CreateBuffer(sizeof(uint32_t));
+    nxtBuffer buffer2 = client2.CreateBuffer(sizeof(uint32_t));
+
+    uint32_t value1 = 1111;
+    uint32_t value2 = 2222;
+    client1.procs.bufferSetSubData(buffer1, 0, 1, &value1);
+    client2.procs.bufferSetSubData(buffer2, 0, 1, &value2);
+
+    MapReadResult result1;
+    MapReadResult result2;
+    client1.MapRead(buffer1, &result1);
+    client2.MapRead(buffer2, &result2);
+    client1.Flush();
+    client2.Flush();
+
+    server->HandleAllQueuedCommands();
+
+    ASSERT_TRUE(result1.done);
+    ASSERT_TRUE(result2.done);
+    ASSERT_EQ(NXT_BUFFER_MAP_READ_STATUS_SUCCESS, result1.status);
+    ASSERT_EQ(NXT_BUFFER_MAP_READ_STATUS_SUCCESS, result2.status);
+    ASSERT_EQ(value1, result1.value);
+    ASSERT_EQ(value2, result2.value);
+
+    client1.procs.bufferRelease(buffer1);
+    client2.procs.bufferRelease(buffer2);
+}
+
+// Test a client with a lot of commands only gets its budget in a round, after which the other
+// clients have been handled.
+TEST_F(WireMultiClientTests, HeavyClientDoesntStarveOthers) {
+    constexpr size_t kBudget = 4096;
+    std::unique_ptr<MultiClientServer> server(CreateServer(kBudget));
+    TestClient heavyClient(server.get());
+    TestClient lightClient(server.get());
+
+    nxtBuffer heavyBuffer = heavyClient.CreateBuffer(sizeof(uint32_t));
+    uint32_t value = 0;
+    for (int i = 0; i < 10000; ++i) {
+        heavyClient.procs.bufferSetSubData(heavyBuffer, 0, 1, &value);
+    }
+    heavyClient.Flush();
+
+    nxtBuffer lightBuffer = lightClient.CreateBuffer(sizeof(uint32_t));
+    MapReadResult lightResult;
+    lightClient.MapRead(lightBuffer, &lightResult);
+    lightClient.Flush();
+
+    ASSERT_TRUE(server->HandleRound());
+    ASSERT_TRUE(lightResult.done);
+    ASSERT_LE(heavyClient.GetCounters().byteCount, kBudget);
+    ASSERT_EQ(1u, lightClient.GetCounters().batchCount);
+
+    server->HandleAllQueuedCommands();
+    // The commands creating the queue and the buffer come before the SetSubData.
+    ASSERT_EQ(3u + 6u + 10000u, heavyClient.GetCounters().commandCount);
+
+    heavyClient.procs.bufferRelease(heavyBuffer);
+    lightClient.procs.bufferRelease(lightBuffer);
+}
+
+// Test a client sending invalid commands is stopped without affecting the others.
+TEST_F(WireMultiClientTests, InvalidClientIsStopped) {
+    std::unique_ptr<MultiClientServer> server(CreateServer());
+    TestClient badClient(server.get());
+    TestClient goodClient(server.get());
+
+    uint32_t garbage[4] = {0xFFFFFFFF, 1, 2, 3};
+    ASSERT_NE(nullptr, badClient.GetServerHandler()->HandleCommands(
+                           reinterpret_cast<const uint8_t*>(garbage), sizeof(garbage)));
+
+    nxtBuffer buffer = goodClient.CreateBuffer(sizeof(uint32_t));
+    MapReadResult result;
+    goodClient.MapRead(buffer, &result);
+    goodClient.Flush();
+
+    server->HandleAllQueuedCommands();
+
+    ASSERT_TRUE(badClient.GetCounters().hasError);
+    ASSERT_EQ(nullptr, badClient.GetServerHandler()->HandleCommands(
+                           reinterpret_cast<const uint8_t*>(garbage), sizeof(garbage)));
+    ASSERT_FALSE(goodClient.GetCounters().hasError);
+    ASSERT_TRUE(result.done);
+
+    goodClient.procs.bufferRelease(buffer);
+}
+
+// Stress test with clients of different weights that come and go, and report their counters.
+TEST_F(WireMultiClientTests, Stress) {
+    constexpr int kClientCount = 8;
+    constexpr int kFrameCount = 50;
+    std::unique_ptr<MultiClientServer> server(CreateServer(16 * 1024));
+
+    std::vector<std::unique_ptr<TestClient>> clients;
+    for (int i = 0; i < kClientCount; ++i) {
+        clients.emplace_back(new TestClient(server.get()));
+    }
+
+    for (int frame = 0; frame < kFrameCount; ++frame) {
+        // Replace a client every few frames, its objects are released by the server.
+        if (frame % 10 == 9) {
+            clients[frame % kClientCount].reset(new TestClient(server.get()));
+        }
+
+        std::vector<nxtBuffer> buffers(kClientCount);
+        std::vector<MapReadResult> results(kClientCount);
+        for (int i = 0; i < kClientCount; ++i) {
+            TestClient* client = clients[i].get();
+            buffers[i] = client->CreateBuffer(sizeof(uint32_t));
+
+            // Client i does i times more work than client 0.
+            uint32_t value = static_cast<uint32_t>(frame * kClientCount + i);
+            for (int j = 0; j < 100 * (i + 1); ++j) {
+                client->procs.bufferSetSubData(buffers[i], 0, 1, &value);
+            }
+            client->MapRead(buffers[i], &results[i]);
+            client->Flush();
+        }
+
+        server->HandleAllQueuedCommands();
+
+        for (int i = 0; i < kClientCount; ++i) {
+            ASSERT_TRUE(results[i].done);
+            ASSERT_EQ(NXT_BUFFER_MAP_READ_STATUS_SUCCESS, results[i].status);
+            ASSERT_EQ(static_cast<uint32_t>(frame * kClientCount + i), results[i].value);
+            clients[i]->procs.bufferRelease(buffers[i]);
+        }
+    }
+
+    for (int i = 0; i < kClientCount; ++i) {
+        const WireClientCounters& counters = clients[i]->GetCounters();
+        ASSERT_FALSE(counters.hasError);
+        std::cout << "[ PERF     ] Client " << i << ": " << counters.commandCount
+                  << " commands, " << counters.byteCount << " bytes, "
+                  << counters.handlingTimeNs / 1000.0 << " us handling, average latency "
+                  << counters.totalLatencyNs / 1000.0 / counters.batchCount << " us, max "
+                  << counters.maxLatencyNs / 1000.0 << " us" << std::endl;
+    }
+}
@@ -0,0 +1,290 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "wire/SharedMemory.h"
+#include "wire/SocketCommandBuffer.h"
+#include "wire/Wire.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace backend { namespace null {
+    void Init(nxtProcTable* procs, nxtDevice* device);
+}}  // namespace backend::null
+
+using namespace testing;
+using namespace nxt::wire;
+
+namespace {
+
+    struct MapReadResult {
+        bool done = false;
+        nxtBufferMapReadStatus status;
+        uint32_t firstValue = 0;
+        const void* data = nullptr;
+    };
+
+    void StoreMapReadResult(nxtBufferMapReadStatus status,
+                            const void* ptr,
+                            nxtCallbackUserdata userdata) {
+        auto result = reinterpret_cast<MapReadResult*>(static_cast<uintptr_t>(userdata));
+        result->done = true;
+        result->status = status;
+        result->data = ptr;
+        if (ptr != nullptr) {
+            result->firstValue = *reinterpret_cast<const uint32_t*>(ptr);
+        }
+    }
+
+    enum class SharedMemoryMode {
+        // The client doesn't create shared memory.
+        None,
+        // The client creates shared memory the server can open.
+        Shared,
+        // The client creates shared memory but gives the server a name it can't open.
+        BadName,
+    };
+
+}  // anonymous namespace
+
+// Runs a wire server hosting the null backend in a child process and talks to it over a Unix
+// domain socket. The parameter controls whether readbacks and uploads go through shared
+// memory.
+class WireSocketTests : public TestWithParam<SharedMemoryMode> {
+    protected:
+        void SetUp() override {
+            mSocketPath = "/tmp/nxt_wire_socket_test_" + std::to_string(getpid());
+
+            // Listen before forking so the client can connect without racing with the server.
+            int listenFd = ListenOnUnixSocket(mSocketPath.c_str());
+            ASSERT_GE(listenFd, 0);
+
+            mServerPid = fork();
+            ASSERT_GE(mServerPid, 0);
+            if (mServerPid == 0) {
+                int fd = AcceptOnUnixSocket(listenFd);
+                if (fd >= 0) {
+                    nxtProcTable procs;
+                    nxtDevice serverDevice;
+                    backend::null::Init(&procs, &serverDevice);
+                    ServeSocketConnection(fd, serverDevice, procs);
+                }
+                _exit(0);
+            }
+            CloseSocket(listenFd);
+
+            mFd = ConnectToUnixSocket(mSocketPath.c_str());
+            ASSERT_GE(mFd, 0);
+
+            bool sharedMemoryOpened = false;
+            if (GetParam() != SharedMemoryMode::None) {
+                std::string name = "/nxt_wire_socket_test_" + std::to_string(getpid());
+                mSharedMemory = PosixSharedMemory::Create(name.c_str(), kSharedMemorySize);
+                ASSERT_NE(nullptr, mSharedMemory);
+
+                if (GetParam() == SharedMemoryMode::BadName) {
+                    name += "_missing";
+                }
+                ASSERT_TRUE(SendSocketHandshake(mFd, name.c_str(), kSharedMemorySize,
+                                                &sharedMemoryOpened));
+            } else {
+                ASSERT_TRUE(SendSocketHandshake(mFd, nullptr, 0, &sharedMemoryOpened));
+            }
+            ASSERT_EQ(GetParam() == SharedMemoryMode::Shared, sharedMemoryOpened);
+
+            mC2sBuf = new SocketCommandSerializer(mFd);
+
+            // Only use the shared memory if the server could open it, otherwise data is sent in
+            // the command stream.
+            nxtProcTable clientProcs;
+            mWireClient = NewClientDevice(&clientProcs, &device, mC2sBuf,
+                                          sharedMemoryOpened ? mSharedMemory : nullptr);
+            nxtSetProcs(&clientProcs);
+
+            mS2cBuf = new SocketCommandReceiver(mFd, mWireClient);
+
+            queue = nxtQueueBuilderGetResult(nxtDeviceCreateQueueBuilder(device));
+        }
+
+        void TearDown() override {
+            nxtQueueRelease(queue);
+            mC2sBuf->Flush();
+            nxtSetProcs(nullptr);
+
+            CloseSocket(mFd);
+            int status;
+            waitpid(mServerPid, &status, 0);
+            unlink(mSocketPath.c_str());
+
+            delete mS2cBuf;
+            delete mWireClient;
+            delete mC2sBuf;
+            delete mSharedMemory;
+        }
+
+        nxtBuffer CreateBuffer(uint32_t size) {
+            nxtBufferBuilder builder = nxtDeviceCreateBufferBuilder(device);
+            nxtBufferBuilderSetSize(builder, size);
+            nxtBufferBuilderSetAllowedUsage(builder, static_cast<nxtBufferUsageBit>(
+                NXT_BUFFER_USAGE_BIT_MAP_READ | NXT_BUFFER_USAGE_BIT_TRANSFER_DST));
+            nxtBufferBuilderSetInitialUsage(builder, NXT_BUFFER_USAGE_BIT_TRANSFER_DST);
+            nxtBuffer buffer = nxtBufferBuilderGetResult(builder);
+            nxtBufferBuilderRelease(builder);
+            return buffer;
+        }
+
+        // Does a full client -> server -> client round trip, MapReadAsync being the only command
+        // that is guaranteed to produce an answer. The null backend completes the map on Submit.
+        MapReadResult MapReadSynchronously(nxtBuffer buffer, uint32_t size = sizeof(uint32_t)) {
+            MapReadResult result;
+            auto userdata = static_cast<nxtCallbackUserdata>(reinterpret_cast<uintptr_t>(&result));
+            nxtBufferMapReadAsync(buffer, 0, size, StoreMapReadResult, userdata);
+            nxtQueueSubmit(queue, 0, nullptr);
+            mC2sBuf->Flush();
+
+            while (!result.done) {
+                if (!mS2cBuf->HandleNextFrame()) {
+                    ADD_FAILURE() << "Connection to the wire server lost";
+                    break;
+                }
+            }
+            return result;
+        }
+
+        bool IsInSharedMemory(const void* ptr) const {
+            if (mSharedMemory == nullptr) {
+                return false;
+            }
+            const uint8_t* data = mSharedMemory->GetData();
+            return ptr >= data && ptr < data + mSharedMemory->GetSize();
+        }
+
+        nxtDevice device;
+        nxtQueue queue;
+
+    private:
+        static constexpr size_t kSharedMemorySize = 4 << 20;
+
+        std::string mSocketPath;
+        pid_t mServerPid = -1;
+        int mFd = -1;
+
+        CommandHandler* mWireClient = nullptr;
+        SocketCommandSerializer* mC2sBuf = nullptr;
+        SocketCommandReceiver* mS2cBuf = nullptr;
+        PosixSharedMemory* mSharedMemory = nullptr;
+};
+
+// Test data makes it to the server process and back, and measure the round-trip latency.
+TEST_P(WireSocketTests, RoundTripLatency) {
+    nxtBuffer buffer = CreateBuffer(sizeof(uint32_t));
+    uint32_t value = 0x1234;
+    nxtBufferSetSubData(buffer, 0, 1, &value);
+    nxtBufferTransitionUsage(buffer, NXT_BUFFER_USAGE_BIT_MAP_READ);
+
+    constexpr int kIterations = 1000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        MapReadResult result = MapReadSynchronously(buffer);
+        ASSERT_TRUE(result.done);
+        ASSERT_EQ(NXT_BUFFER_MAP_READ_STATUS_SUCCESS, result.status);
+        ASSERT_EQ(value, result.firstValue);
+        nxtBufferUnmap(buffer);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double microseconds = std::chrono::duration<double, std::micro>(end - start).count();
+    std::cout << "[ PERF     ] Round trip latency: " << microseconds / kIterations << " us"
+              << std::endl;
+
+    nxtBufferRelease(buffer);
+}
+
+// Measure how fast SetSubData data can be streamed to the server process.
+TEST_P(WireSocketTests, UploadThroughput) {
+    constexpr uint32_t kUploadSize = 1 << 20;
+    constexpr int kIterations = 128;
+
+    nxtBuffer buffer = CreateBuffer(kUploadSize);
+    std::vector<uint32_t> data(kUploadSize / sizeof(uint32_t));
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        data[0] = static_cast<uint32_t>(i);
+        nxtBufferSetSubData(buffer, 0, static_cast<uint32_t>(data.size()), data.data());
+    }
+
+    // Reading back makes sure the server has processed all uploads.
+    nxtBufferTransitionUsage(buffer, NXT_BUFFER_USAGE_BIT_MAP_READ);
+    MapReadResult result = MapReadSynchronously(buffer);
+    auto end = std::chrono::steady_clock::now();
+
+    ASSERT_TRUE(result.done);
+    ASSERT_EQ(NXT_BUFFER_MAP_READ_STATUS_SUCCESS, result.status);
+    ASSERT_EQ(static_cast<uint32_t>(kIterations - 1), result.firstValue);
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double megabytes = static_cast<double>(kUploadSize) * kIterations / (1024.0 * 1024.0);
+    std::cout << "[ PERF     ] Upload throughput: " << megabytes / seconds << " MB/s" << std::endl;
+
+    nxtBufferUnmap(buffer);
+    nxtBufferRelease(buffer);
+}
+
+// Measure how fast large readbacks come back, and check they are written directly in the shared
+// memory when there is one.
+TEST_P(WireSocketTests, ReadbackThroughput) {
+    constexpr uint32_t kReadbackSize = 1 << 20;
+    constexpr int kIterations = 64;
+
+    nxtBuffer buffer = CreateBuffer(kReadbackSize);
+    std::vector<uint32_t> data(kReadbackSize / sizeof(uint32_t));
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint32_t>(i);
+    }
+    nxtBufferSetSubData(buffer, 0, static_cast<uint32_t>(data.size()), data.data());
+    nxtBufferTransitionUsage(buffer, NXT_BUFFER_USAGE_BIT_MAP_READ);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        MapReadResult result = MapReadSynchronously(buffer, kReadbackSize);
+        ASSERT_TRUE(result.done);
+        ASSERT_EQ(NXT_BUFFER_MAP_READ_STATUS_SUCCESS, result.status);
+        ASSERT_EQ(GetParam() == SharedMemoryMode::Shared, IsInSharedMemory(result.data));
+        ASSERT_EQ(0, memcmp(data.data(), result.data, kReadbackSize));
+        nxtBufferUnmap(buffer);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double megabytes = static_cast<double>(kReadbackSize) * kIterations / (1024.0 * 1024.0);
+    std::cout << "[ PERF     ] Readback throughput: " << megabytes / seconds << " MB/s"
+              << std::endl;
+
+    nxtBufferRelease(buffer);
+}
+
+INSTANTIATE_TEST_CASE_P(,
+                        WireSocketTests,
+                        Values(SharedMemoryMode::None,
+                               SharedMemoryMode::Shared,
+                               SharedMemoryMode::BadName));
@@ -15,9 +15,14 @@
 #include "gtest/gtest.h"
 #include "mock/mock_nxt.h"
 
+#include "wire/CompactCommandBuffer.h"
+#include "wire/SharedMemory.h"
 #include "wire/TerribleCommandBuffer.h"
+#include "wire/WireCmd.h"
 #include "wire/Wire.h"
 
+#include <memory>
+
 using namespace testing;
 using namespace nxt::wire;
 
@@ -52,16 +57,29 @@ static void ToMockBufferMapReadCallback(nxtBufferMapReadStatus status, const voi
     mockBufferMapReadCallback->Call(status, reinterpret_cast<const uint32_t*>(ptr), userdata);
 }
 
-class WireTestsBase : public Test {
+class MockFenceOnCompletionCallback {
+    public:
+        MOCK_METHOD2(Call, void(nxtFenceCompletionStatus status, nxtCallbackUserdata userdata));
+};
+
+static MockFenceOnCompletionCallback* mockFenceOnCompletionCallback = nullptr;
+static void ToMockFenceOnCompletionCallback(nxtFenceCompletionStatus status, nxtCallbackUserdata userdata) {
+    mockFenceOnCompletionCallback->Call(status, userdata);
+}
+
+// All the tests run with each encoding of the client to server command stream.
+class WireTestsBase : public TestWithParam<WireEncoding> {
     protected:
-        WireTestsBase(bool ignoreSetCallbackCalls)
-            : mIgnoreSetCallbackCalls(ignoreSetCallbackCalls) {
+        WireTestsBase(bool ignoreSetCallbackCalls, size_t sharedMemorySize = 0)
+            : mIgnoreSetCallbackCalls(ignoreSetCallbackCalls),
+              mSharedMemorySize(sharedMemorySize) {
         }
 
         void SetUp() override {
             mockDeviceErrorCallback = new MockDeviceErrorCallback;
             mockBuilderErrorCallback = new MockBuilderErrorCallback;
             mockBufferMapReadCallback = new MockBufferMapReadCallback;
+            mockFenceOnCompletionCallback = new MockFenceOnCompletionCallback;
 
             nxtProcTable mockProcs;
             nxtDevice mockDevice;
@@ -77,11 +95,23 @@ class WireTestsBase : public Test {
             mS2cBuf = new TerribleCommandBuffer();
             mC2sBuf = new TerribleCommandBuffer(mWireServer);
 
-            mWireServer = NewServerCommandHandler(mockDevice, mockProcs, mS2cBuf);
+            if (mSharedMemorySize != 0) {
+                sharedMemory = new InProcessSharedMemory(mSharedMemorySize);
+            }
+
+            mWireServer = NewServerCommandHandler(mockDevice, mockProcs, mS2cBuf, sharedMemory);
             mC2sBuf->SetHandler(mWireServer);
 
+            CommandSerializer* clientSerializer = mC2sBuf;
+            if (GetParam() != WireEncoding::Native) {
+                mCompactC2sBuf = new CompactCommandSerializer(mC2sBuf, GetParam());
+                mCompactServer = new CompactCommandHandler(mWireServer);
+                mC2sBuf->SetHandler(mCompactServer);
+                clientSerializer = mCompactC2sBuf;
+            }
+
             nxtProcTable clientProcs;
-            mWireClient = NewClientDevice(&clientProcs, &device, mC2sBuf);
+            mWireClient = NewClientDevice(&clientProcs, &device, clientSerializer, sharedMemory);
             nxtSetProcs(&clientProcs);
             mS2cBuf->SetHandler(mWireClient);
 
@@ -92,34 +122,55 @@ class WireTestsBase : public Test {
             nxtSetProcs(nullptr);
             delete mWireServer;
             delete mWireClient;
+            delete mCompactServer;
+            delete mCompactC2sBuf;
             delete mC2sBuf;
             delete mS2cBuf;
+            delete sharedMemory;
             delete mockDeviceErrorCallback;
             delete mockBuilderErrorCallback;
             delete mockBufferMapReadCallback;
+            delete mockFenceOnCompletionCallback;
         }
 
         void FlushClient() {
-            mC2sBuf->Flush();
+            if (mCompactC2sBuf != nullptr) {
+                mCompactC2sBuf->Flush();
+            } else {
+                mC2sBuf->Flush();
+            }
         }
 
         void FlushServer() {
             mS2cBuf->Flush();
         }
 
+        CommandHandler* GetWireClient() const {
+            return mWireClient;
+        }
+
         MockProcTable api;
         nxtDevice apiDevice;
         nxtDevice device;
+        SharedMemory* sharedMemory = nullptr;
 
     private:
         bool mIgnoreSetCallbackCalls = false;
+        size_t mSharedMemorySize = 0;
 
         CommandHandler* mWireServer = nullptr;
         CommandHandler* mWireClient = nullptr;
         TerribleCommandBuffer* mS2cBuf = nullptr;
         TerribleCommandBuffer* mC2sBuf = nullptr;
+        CompactCommandSerializer* mCompactC2sBuf = nullptr;
+        CompactCommandHandler* mCompactServer = nullptr;
 };
 
+#define INSTANTIATE_WIRE_TESTS(Fixture)                                                  \
+    INSTANTIATE_TEST_CASE_P(, Fixture,                                                   \
+                            Values(WireEncoding::Native, WireEncoding::Compact,          \
+                                   WireEncoding::CompactCompressed))
+
 class WireTests : public WireTestsBase {
     public:
         WireTests() : WireTestsBase(true) {
@@ -127,7 +178,7 @@ class WireTests : public WireTestsBase {
 };
 
 // One call gets forwarded correctly.
-TEST_F(WireTests, CallForwarded) {
+TEST_P(WireTests, CallForwarded) {
     nxtDeviceCreateCommandBufferBuilder(device);
 
     nxtCommandBufferBuilder apiCmdBufBuilder = api.GetNewCommandBufferBuilder();
@@ -138,7 +189,7 @@ TEST_F(WireTests, CallForwarded) {
 }
 
 // Test that calling methods on a new object works as expected.
-TEST_F(WireTests, CreateThenCall) {
+TEST_P(WireTests, CreateThenCall) {
     nxtCommandBufferBuilder builder = nxtDeviceCreateCommandBufferBuilder(device);
     nxtCommandBufferBuilderGetResult(builder);
 
@@ -154,7 +205,7 @@ TEST_F(WireTests, CreateThenCall) {
 }
 
 // Test that client reference/release do not call the backend API.
-TEST_F(WireTests, RefCountKeptInClient) {
+TEST_P(WireTests, RefCountKeptInClient) {
     nxtCommandBufferBuilder builder = nxtDeviceCreateCommandBufferBuilder(device);
 
     nxtCommandBufferBuilderReference(builder);
@@ -168,7 +219,7 @@ TEST_F(WireTests, RefCountKeptInClient) {
 }
 
 // Test that client reference/release do not call the backend API.
-TEST_F(WireTests, ReleaseCalledOnRefCount0) {
+TEST_P(WireTests, ReleaseCalledOnRefCount0) {
     nxtCommandBufferBuilder builder = nxtDeviceCreateCommandBufferBuilder(device);
 
     nxtCommandBufferBuilderRelease(builder);
@@ -183,7 +234,7 @@ TEST_F(WireTests, ReleaseCalledOnRefCount0) {
 }
 
 // Test that the wire is able to send numerical values
-TEST_F(WireTests, ValueArgument) {
+TEST_P(WireTests, ValueArgument) {
     nxtSamplerBuilder builder = nxtDeviceCreateSamplerBuilder(device);
     nxtSamplerBuilderSetFilterMode(builder, NXT_FILTER_MODE_LINEAR, NXT_FILTER_MODE_LINEAR, NXT_FILTER_MODE_NEAREST);
 
@@ -214,21 +265,24 @@ bool CheckPushConstantValues(const uint32_t* values) {
     return true;
 }
 
-TEST_F(WireTests, ValueArrayArgument) {
+TEST_P(WireTests, ValueArrayArgument) {
     nxtCommandBufferBuilder builder = nxtDeviceCreateCommandBufferBuilder(device);
     nxtCommandBufferBuilderSetPushConstants(builder, NXT_SHADER_STAGE_BIT_VERTEX, 0, 4, testPushConstantValues);
+    nxtCommandBufferBuilderGetResult(builder);
 
     nxtCommandBufferBuilder apiBuilder = api.GetNewCommandBufferBuilder();
     EXPECT_CALL(api, DeviceCreateCommandBufferBuilder(apiDevice))
         .WillOnce(Return(apiBuilder));
 
     EXPECT_CALL(api, CommandBufferBuilderSetPushConstants(apiBuilder, NXT_SHADER_STAGE_BIT_VERTEX, 0, 4, ResultOf(CheckPushConstantValues, Eq(true))));
+    EXPECT_CALL(api, CommandBufferBuilderGetResult(apiBuilder))
+        .WillOnce(Return(nullptr));
 
     FlushClient();
 }
 
 // Test that the wire is able to send C strings
-TEST_F(WireTests, CStringArgument) {
+TEST_P(WireTests, CStringArgument) {
     // Create shader module
     nxtShaderModuleBuilder shaderModuleBuilder = nxtDeviceCreateShaderModuleBuilder(device);
     nxtShaderModule shaderModule = nxtShaderModuleBuilderGetResult(shaderModuleBuilder);
@@ -255,7 +309,7 @@ TEST_F(WireTests, CStringArgument) {
 }
 
 // Test that the wire is able to send objects as value arguments
-TEST_F(WireTests, ObjectAsValueArgument) {
+TEST_P(WireTests, ObjectAsValueArgument) {
     // Create pipeline
     nxtRenderPipelineBuilder pipelineBuilder = nxtDeviceCreateRenderPipelineBuilder(device);
     nxtRenderPipeline pipeline = nxtRenderPipelineBuilderGetResult(pipelineBuilder);
@@ -271,13 +325,93 @@ TEST_F(WireTests, ObjectAsValueArgument) {
     // Create command buffer builder, setting pipeline
     nxtCommandBufferBuilder cmdBufBuilder = nxtDeviceCreateCommandBufferBuilder(device);
     nxtCommandBufferBuilderSetRenderPipeline(cmdBufBuilder, pipeline);
+    nxtCommandBufferBuilderGetResult(cmdBufBuilder);
 
     nxtCommandBufferBuilder apiCmdBufBuilder = api.GetNewCommandBufferBuilder();
     EXPECT_CALL(api, DeviceCreateCommandBufferBuilder(apiDevice))
         .WillOnce(Return(apiCmdBufBuilder));
 
     EXPECT_CALL(api, CommandBufferBuilderSetRenderPipeline(apiCmdBufBuilder, apiPipeline));
+    EXPECT_CALL(api, CommandBufferBuilderGetResult(apiCmdBufBuilder))
+        .WillOnce(Return(nullptr));
+
+    FlushClient();
+}
+
+// Test that command buffer builder calls are recorded and only sent before the next other command
+TEST_P(WireTests, RecordedCallsSentBeforeNextCommand) {
+    nxtCommandBufferBuilder cmdBufBuilder = nxtDeviceCreateCommandBufferBuilder(device);
+    nxtCommandBufferBuilder apiCmdBufBuilder = api.GetNewCommandBufferBuilder();
+    EXPECT_CALL(api, DeviceCreateCommandBufferBuilder(apiDevice))
+        .WillOnce(Return(apiCmdBufBuilder));
+    FlushClient();
+
+    nxtCommandBufferBuilderDrawArrays(cmdBufBuilder, 3, 1, 0, 0);
+    nxtCommandBufferBuilderDrawArrays(cmdBufBuilder, 6, 1, 0, 0);
+    EXPECT_CALL(api, CommandBufferBuilderDrawArrays(_, _, _, _, _)).Times(0);
+    FlushClient();
+    Mock::VerifyAndClearExpectations(&api);
+
+    nxtDeviceCreateBufferBuilder(device);
+    {
+        InSequence sequence;
+        EXPECT_CALL(api, CommandBufferBuilderDrawArrays(apiCmdBufBuilder, 3, 1, 0, 0));
+        EXPECT_CALL(api, CommandBufferBuilderDrawArrays(apiCmdBufBuilder, 6, 1, 0, 0));
+        EXPECT_CALL(api, DeviceCreateBufferBuilder(apiDevice))
+            .WillOnce(Return(api.GetNewBufferBuilder()));
+    }
+    FlushClient();
+}
+
+// Test ClientFlush sends the calls being recorded, which a Flush of the serializer doesn't
+TEST_P(WireTests, ClientFlushSendsRecordedCalls) {
+    nxtCommandBufferBuilder cmdBufBuilder = nxtDeviceCreateCommandBufferBuilder(device);
+    nxtCommandBufferBuilder apiCmdBufBuilder = api.GetNewCommandBufferBuilder();
+    EXPECT_CALL(api, DeviceCreateCommandBufferBuilder(apiDevice))
+        .WillOnce(Return(apiCmdBufBuilder));
+    FlushClient();
+
+    nxtCommandBufferBuilderDrawArrays(cmdBufBuilder, 3, 1, 0, 0);
+    EXPECT_CALL(api, CommandBufferBuilderDrawArrays(apiCmdBufBuilder, 3, 1, 0, 0));
+    ClientFlush(GetWireClient());
+    Mock::VerifyAndClearExpectations(&api);
+
+    // The builder can still be used after the flush.
+    nxtCommandBufferBuilderDrawArrays(cmdBufBuilder, 6, 1, 0, 0);
+    nxtCommandBufferBuilderGetResult(cmdBufBuilder);
+    {
+        InSequence sequence;
+        EXPECT_CALL(api, CommandBufferBuilderDrawArrays(apiCmdBufBuilder, 6, 1, 0, 0));
+        EXPECT_CALL(api, CommandBufferBuilderGetResult(apiCmdBufBuilder))
+            .WillOnce(Return(api.GetNewCommandBuffer()));
+    }
+    FlushClient();
+}
+
+// Test that releasing an object used by recorded calls doesn't destroy it before the calls
+TEST_P(WireTests, RecordedCallsSentBeforeRelease) {
+    nxtBufferBuilder bufferBuilder = nxtDeviceCreateBufferBuilder(device);
+    nxtBuffer buffer = nxtBufferBuilderGetResult(bufferBuilder);
+    nxtCommandBufferBuilder cmdBufBuilder = nxtDeviceCreateCommandBufferBuilder(device);
+
+    nxtBufferBuilder apiBufferBuilder = api.GetNewBufferBuilder();
+    EXPECT_CALL(api, DeviceCreateBufferBuilder(apiDevice))
+        .WillOnce(Return(apiBufferBuilder));
+    nxtBuffer apiBuffer = api.GetNewBuffer();
+    EXPECT_CALL(api, BufferBuilderGetResult(apiBufferBuilder))
+        .WillOnce(Return(apiBuffer));
+    nxtCommandBufferBuilder apiCmdBufBuilder = api.GetNewCommandBufferBuilder();
+    EXPECT_CALL(api, DeviceCreateCommandBufferBuilder(apiDevice))
+        .WillOnce(Return(apiCmdBufBuilder));
+    FlushClient();
 
+    nxtCommandBufferBuilderTransitionBufferUsage(cmdBufBuilder, buffer, NXT_BUFFER_USAGE_BIT_UNIFORM);
+    nxtBufferRelease(buffer);
+    {
+        InSequence sequence;
+        EXPECT_CALL(api, CommandBufferBuilderTransitionBufferUsage(apiCmdBufBuilder, apiBuffer, NXT_BUFFER_USAGE_BIT_UNIFORM));
+        EXPECT_CALL(api, BufferRelease(apiBuffer));
+    }
     FlushClient();
 }
 
@@ -292,7 +426,7 @@ struct AreAPICmdBufs {
 };
 
 // Test that the wire is able to send array of objects
-TEST_F(WireTests, ObjectsAsPointerArgument) {
+TEST_P(WireTests, ObjectsAsPointerArgument) {
     nxtCommandBuffer cmdBufs[2];
     nxtCommandBuffer apiCmdBufs[2];
 
@@ -339,7 +473,7 @@ TEST_F(WireTests, ObjectsAsPointerArgument) {
 
 // Test that the server doesn't forward calls to error objects or with error objects
 // Also test that when GetResult is called on an error builder, the error callback is fired
-TEST_F(WireTests, CallsSkippedAfterBuilderError) {
+TEST_P(WireTests, CallsSkippedAfterBuilderError) {
     nxtCommandBufferBuilder cmdBufBuilder = nxtDeviceCreateCommandBufferBuilder(device);
     nxtCommandBufferBuilderSetErrorCallback(cmdBufBuilder, ToMockBuilderErrorCallback, 1, 2);
 
@@ -379,8 +513,82 @@ TEST_F(WireTests, CallsSkippedAfterBuilderError) {
     FlushServer();
 }
 
+// Test that a shared device server releases the objects of its client when deleted, including
+// builders made invalid by an error and objects the client referenced several times.
+TEST_P(WireTests, SharedDeviceServerReleasesClientObjects) {
+    nxtProcTable sharedProcs;
+    nxtDevice sharedDevice;
+    api.GetProcTableAndDevice(&sharedProcs, &sharedDevice);
+
+    std::unique_ptr<TerribleCommandBuffer> c2sBuf(new TerribleCommandBuffer());
+    std::unique_ptr<TerribleCommandBuffer> s2cBuf(new TerribleCommandBuffer());
+
+    EXPECT_CALL(api, DeviceReference(sharedDevice));
+    SharedDeviceServer* server = NewSharedDeviceServer(sharedDevice, sharedProcs, s2cBuf.get());
+    c2sBuf->SetHandler(server);
+
+    nxtProcTable clientProcs;
+    nxtDevice clientDevice;
+    CommandHandler* client = NewClientDevice(&clientProcs, &clientDevice, c2sBuf.get());
+    s2cBuf->SetHandler(client);
+
+    // The command buffer builder becomes an error because it uses the error buffer.
+    nxtBufferBuilder bufferBuilder = clientProcs.deviceCreateBufferBuilder(clientDevice);
+    nxtBuffer errorBuffer = clientProcs.bufferBuilderGetResult(bufferBuilder);
+    nxtCommandBufferBuilder cmdBufBuilder =
+        clientProcs.deviceCreateCommandBufferBuilder(clientDevice);
+    clientProcs.commandBufferBuilderReference(cmdBufBuilder);
+    clientProcs.commandBufferBuilderTransitionBufferUsage(cmdBufBuilder, errorBuffer,
+                                                          NXT_BUFFER_USAGE_BIT_UNIFORM);
+    clientProcs.bufferRelease(errorBuffer);
+
+    nxtBufferBuilder apiBufferBuilder = api.GetNewBufferBuilder();
+    EXPECT_CALL(api, DeviceCreateBufferBuilder(sharedDevice))
+        .WillOnce(Return(apiBufferBuilder));
+    EXPECT_CALL(api, BufferBuilderGetResult(apiBufferBuilder))
+        .WillOnce(Return(nullptr));
+    nxtCommandBufferBuilder apiCmdBufBuilder = api.GetNewCommandBufferBuilder();
+    EXPECT_CALL(api, DeviceCreateCommandBufferBuilder(sharedDevice))
+        .WillOnce(Return(apiCmdBufBuilder));
+    EXPECT_CALL(api, CommandBufferBuilderTransitionBufferUsage(_, _, _)).Times(0);
+    EXPECT_CALL(api, BufferRelease(_)).Times(0);
+    c2sBuf->Flush();
+    Mock::VerifyAndClearExpectations(&api);
+
+    EXPECT_CALL(api, BufferBuilderRelease(apiBufferBuilder));
+    EXPECT_CALL(api, CommandBufferBuilderRelease(apiCmdBufBuilder));
+    EXPECT_CALL(api, DeviceRelease(sharedDevice));
+    delete server;
+    delete client;
+}
+
+// Test servers tick the device when given commands, unless asked not to.
+TEST_P(WireTests, ServerHandleCommandsWithoutTick) {
+    std::unique_ptr<TerribleCommandBuffer> s2cBuf(new TerribleCommandBuffer());
+    nxtProcTable procs;
+    nxtDevice mockDevice;
+    api.GetProcTableAndDevice(&procs, &mockDevice);
+    EXPECT_CALL(api, OnDeviceSetErrorCallback(mockDevice, _, _));
+    std::unique_ptr<CommandHandler> server(NewServerCommandHandler(mockDevice, procs, s2cBuf.get()));
+
+    DeviceCreateBufferBuilderCmd cmd;
+    cmd.self = 1;
+    cmd.resultId = 1;
+    cmd.resultSerial = 0;
+    const uint8_t* commands = reinterpret_cast<const uint8_t*>(&cmd);
+
+    EXPECT_CALL(api, DeviceTick(mockDevice)).Times(0);
+    EXPECT_CALL(api, DeviceCreateBufferBuilder(mockDevice))
+        .WillOnce(Return(api.GetNewBufferBuilder()));
+    ASSERT_NE(nullptr, ServerHandleCommandsWithoutTick(server.get(), commands, sizeof(cmd)));
+    Mock::VerifyAndClearExpectations(&api);
+
+    EXPECT_CALL(api, DeviceTick(mockDevice)).Times(1);
+    ASSERT_NE(nullptr, server->HandleCommands(commands, 0));
+}
+
 // Test that we get a success builder error status when no error happens
-TEST_F(WireTests, SuccessCallbackOnBuilderSuccess) {
+TEST_P(WireTests, SuccessCallbackOnBuilderSuccess) {
     nxtBufferBuilder bufferBuilder = nxtDeviceCreateBufferBuilder(device);
     nxtBufferBuilderSetErrorCallback(bufferBuilder, ToMockBuilderErrorCallback, 1, 2);
     nxtBufferBuilderGetResult(bufferBuilder);
@@ -405,7 +613,7 @@ TEST_F(WireTests, SuccessCallbackOnBuilderSuccess) {
 
 // Test that the client calls the builder callback with unknown when it HAS to fire the callback but can't
 // know the status yet.
-TEST_F(WireTests, UnknownBuilderErrorStatusCallback) {
+TEST_P(WireTests, UnknownBuilderErrorStatusCallback) {
     // The builder is destroyed before the object is built
     {
         nxtBufferBuilder bufferBuilder = nxtDeviceCreateBufferBuilder(device);
@@ -441,7 +649,7 @@ TEST_F(WireTests, UnknownBuilderErrorStatusCallback) {
 }
 
 // Test that a builder success status doesn't get forwarded to the device
-TEST_F(WireTests, SuccessCallbackNotForwardedToDevice) {
+TEST_P(WireTests, SuccessCallbackNotForwardedToDevice) {
     nxtDeviceSetErrorCallback(device, ToMockDeviceErrorCallback, 0);
 
     nxtBufferBuilder bufferBuilder = nxtDeviceCreateBufferBuilder(device);
@@ -463,7 +671,7 @@ TEST_F(WireTests, SuccessCallbackNotForwardedToDevice) {
 }
 
 // Test that a builder error status gets forwarded to the device
-TEST_F(WireTests, ErrorCallbackForwardedToDevice) {
+TEST_P(WireTests, ErrorCallbackForwardedToDevice) {
     uint64_t userdata = 30495;
     nxtDeviceSetErrorCallback(device, ToMockDeviceErrorCallback, userdata);
 
@@ -487,6 +695,8 @@ TEST_F(WireTests, ErrorCallbackForwardedToDevice) {
     FlushServer();
 }
 
+INSTANTIATE_WIRE_TESTS(WireTests);
+
 class WireSetCallbackTests : public WireTestsBase {
     public:
         WireSetCallbackTests() : WireTestsBase(false) {
@@ -494,7 +704,7 @@ class WireSetCallbackTests : public WireTestsBase {
 };
 
 // Test the return wire for device error callbacks
-TEST_F(WireSetCallbackTests, DeviceErrorCallback) {
+TEST_P(WireSetCallbackTests, DeviceErrorCallback) {
     uint64_t userdata = 3049785;
     nxtDeviceSetErrorCallback(device, ToMockDeviceErrorCallback, userdata);
 
@@ -511,7 +721,7 @@ TEST_F(WireSetCallbackTests, DeviceErrorCallback) {
 }
 
 // Test the return wire for device error callbacks
-TEST_F(WireSetCallbackTests, BuilderErrorCallback) {
+TEST_P(WireSetCallbackTests, BuilderErrorCallback) {
     uint64_t userdata1 = 982734;
     uint64_t userdata2 = 982734239028;
 
@@ -550,9 +760,12 @@ TEST_F(WireSetCallbackTests, BuilderErrorCallback) {
     FlushServer();
 }
 
+INSTANTIATE_WIRE_TESTS(WireSetCallbackTests);
+
 class WireBufferMappingTests : public WireTestsBase {
     public:
-        WireBufferMappingTests() : WireTestsBase(true) {
+        WireBufferMappingTests(size_t sharedMemorySize = 0)
+            : WireTestsBase(true, sharedMemorySize) {
         }
 
         void SetUp() override {
@@ -597,7 +810,7 @@ class WireBufferMappingTests : public WireTestsBase {
 };
 
 // Check mapping a succesfully created buffer
-TEST_F(WireBufferMappingTests, MappingSuccessBuffer) {
+TEST_P(WireBufferMappingTests, MappingSuccessBuffer) {
     nxtCallbackUserdata userdata = 8653;
     nxtBufferMapReadAsync(buffer, 40, sizeof(uint32_t), ToMockBufferMapReadCallback, userdata);
     
@@ -622,7 +835,7 @@ TEST_F(WireBufferMappingTests, MappingSuccessBuffer) {
 }
 
 // Check that things work correctly when a validation error happens when mapping the buffer
-TEST_F(WireBufferMappingTests, ErrorWhileMapping) {
+TEST_P(WireBufferMappingTests, ErrorWhileMapping) {
     nxtCallbackUserdata userdata = 8654;
     nxtBufferMapReadAsync(buffer, 40, sizeof(uint32_t), ToMockBufferMapReadCallback, userdata);
     
@@ -640,7 +853,7 @@ TEST_F(WireBufferMappingTests, ErrorWhileMapping) {
 }
 
 // Check mapping a buffer that didn't get created on the server side
-TEST_F(WireBufferMappingTests, MappingErrorBuffer) {
+TEST_P(WireBufferMappingTests, MappingErrorBuffer) {
     nxtCallbackUserdata userdata = 8655;
     nxtBufferMapReadAsync(errorBuffer, 40, sizeof(uint32_t), ToMockBufferMapReadCallback, userdata);
 
@@ -657,7 +870,7 @@ TEST_F(WireBufferMappingTests, MappingErrorBuffer) {
 }
 
 // Check that the callback is called with UNKNOWN when the buffer is destroyed before the request is finished
-TEST_F(WireBufferMappingTests, DestroyBeforeRequestEnd) {
+TEST_P(WireBufferMappingTests, DestroyBeforeRequestEnd) {
     nxtCallbackUserdata userdata = 8656;
     nxtBufferMapReadAsync(errorBuffer, 40, sizeof(uint32_t), ToMockBufferMapReadCallback, userdata);
 
@@ -668,7 +881,7 @@ TEST_F(WireBufferMappingTests, DestroyBeforeRequestEnd) {
 }
 
 // Check the callback is called with UNKNOWN when the map request would have worked, but Unmap was called
-TEST_F(WireBufferMappingTests, UnmapCalledTooEarly) {
+TEST_P(WireBufferMappingTests, UnmapCalledTooEarly) {
     nxtCallbackUserdata userdata = 8657;
     nxtBufferMapReadAsync(buffer, 40, sizeof(uint32_t), ToMockBufferMapReadCallback, userdata);
     
@@ -690,7 +903,7 @@ TEST_F(WireBufferMappingTests, UnmapCalledTooEarly) {
 }
 
 // Check that an error callback gets nullptr while a buffer is already mapped
-TEST_F(WireBufferMappingTests, MappingErrorWhileAlreadyMappedGetsNullptr) {
+TEST_P(WireBufferMappingTests, MappingErrorWhileAlreadyMappedGetsNullptr) {
     // Successful map
     nxtCallbackUserdata userdata = 34098;
     nxtBufferMapReadAsync(buffer, 40, sizeof(uint32_t), ToMockBufferMapReadCallback, userdata);
@@ -724,3 +937,306 @@ TEST_F(WireBufferMappingTests, MappingErrorWhileAlreadyMappedGetsNullptr) {
 
     FlushServer();
 }
+
+INSTANTIATE_WIRE_TESTS(WireBufferMappingTests);
+
+class WireSharedMemoryMappingTests : public WireBufferMappingTests {
+    public:
+        WireSharedMemoryMappingTests() : WireBufferMappingTests(1024) {
+        }
+};
+
+// Check the data of a successful mapping is given to the application directly in the shared memory
+TEST_P(WireSharedMemoryMappingTests, MappingUsesSharedMemory) {
+    nxtCallbackUserdata userdata = 8658;
+    nxtBufferMapReadAsync(buffer, 40, sizeof(uint32_t), ToMockBufferMapReadCallback, userdata);
+
+    uint32_t bufferContent = 31337;
+    EXPECT_CALL(api, OnBufferMapReadAsyncCallback(apiBuffer, 40, sizeof(uint32_t), _, _))
+        .WillOnce(InvokeWithoutArgs([&]() {
+            api.CallMapReadCallback(apiBuffer, NXT_BUFFER_MAP_READ_STATUS_SUCCESS, &bufferContent);
+        }));
+
+    FlushClient();
+
+    const uint32_t* sharedData = reinterpret_cast<const uint32_t*>(sharedMemory->GetData());
+    EXPECT_CALL(*mockBufferMapReadCallback, Call(NXT_BUFFER_MAP_READ_STATUS_SUCCESS, sharedData, userdata))
+        .Times(1);
+
+    FlushServer();
+    ASSERT_EQ(bufferContent, *sharedData);
+
+    nxtBufferUnmap(buffer);
+    EXPECT_CALL(api, BufferUnmap(apiBuffer))
+        .Times(1);
+
+    FlushClient();
+}
+
+// Check the shared memory of a request cancelled by Unmap is reused once the server answered
+TEST_P(WireSharedMemoryMappingTests, CancelledRequestSpaceIsReclaimed) {
+    nxtCallbackUserdata userdata = 8659;
+    nxtBufferMapReadAsync(buffer, 0, 1024, ToMockBufferMapReadCallback, userdata);
+
+    std::vector<uint32_t> bufferContent(256, 42);
+    EXPECT_CALL(api, OnBufferMapReadAsyncCallback(apiBuffer, 0, 1024, _, _))
+        .WillRepeatedly(InvokeWithoutArgs([&]() {
+            api.CallMapReadCallback(apiBuffer, NXT_BUFFER_MAP_READ_STATUS_SUCCESS, bufferContent.data());
+        }));
+
+    EXPECT_CALL(*mockBufferMapReadCallback, Call(NXT_BUFFER_MAP_READ_STATUS_UNKNOWN, nullptr, userdata))
+        .Times(1);
+    nxtBufferUnmap(buffer);
+    EXPECT_CALL(api, BufferUnmap(apiBuffer))
+        .Times(1);
+
+    FlushClient();
+    FlushServer();
+
+    // The whole shared memory is available again
+    userdata ++;
+    nxtBufferMapReadAsync(buffer, 0, 1024, ToMockBufferMapReadCallback, userdata);
+    FlushClient();
+
+    const uint32_t* sharedData = reinterpret_cast<const uint32_t*>(sharedMemory->GetData());
+    EXPECT_CALL(*mockBufferMapReadCallback, Call(NXT_BUFFER_MAP_READ_STATUS_SUCCESS, sharedData, userdata))
+        .Times(1);
+
+    FlushServer();
+}
+
+// Check readbacks that don't fit in the shared memory are still sent in the command stream
+TEST_P(WireSharedMemoryMappingTests, FallbackWhenSharedMemoryIsFull) {
+    nxtCallbackUserdata userdata = 8660;
+    nxtBufferMapReadAsync(buffer, 0, 2048, ToMockBufferMapReadCallback, userdata);
+
+    std::vector<uint32_t> bufferContent(512, 31337);
+    EXPECT_CALL(api, OnBufferMapReadAsyncCallback(apiBuffer, 0, 2048, _, _))
+        .WillOnce(InvokeWithoutArgs([&]() {
+            api.CallMapReadCallback(apiBuffer, NXT_BUFFER_MAP_READ_STATUS_SUCCESS, bufferContent.data());
+        }));
+
+    FlushClient();
+
+    EXPECT_CALL(*mockBufferMapReadCallback, Call(NXT_BUFFER_MAP_READ_STATUS_SUCCESS, Pointee(Eq(31337u)), userdata))
+        .Times(1);
+
+    FlushServer();
+}
+
+INSTANTIATE_WIRE_TESTS(WireSharedMemoryMappingTests);
+
+class WireBulkDataTests : public WireBufferMappingTests {
+    public:
+        WireBulkDataTests() : WireBufferMappingTests(kSharedMemorySize) {
+        }
+
+    protected:
+        static constexpr size_t kSharedMemorySize = 64 * 1024;
+        static constexpr uint32_t kSharedMemoryWords = kSharedMemorySize / sizeof(uint32_t);
+};
+
+// Check large SetSubData data is given to the backend directly from the shared memory, and that the
+// space is reclaimed once the server is done with it.
+TEST_P(WireBulkDataTests, LargeSetSubDataUsesSharedMemory) {
+    const uint32_t* sharedData = reinterpret_cast<const uint32_t*>(sharedMemory->GetData());
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        std::vector<uint32_t> data(kSharedMemoryWords, i);
+        nxtBufferSetSubData(buffer, 0, kSharedMemoryWords, data.data());
+
+        EXPECT_CALL(api, BufferSetSubData(apiBuffer, 0, kSharedMemoryWords, sharedData))
+            .WillOnce(InvokeWithoutArgs([&]() {
+                ASSERT_EQ(0, memcmp(data.data(), sharedData, kSharedMemorySize));
+            }));
+
+        FlushClient();
+        FlushServer();
+    }
+}
+
+// Check small SetSubData data stays in the command stream
+TEST_P(WireBulkDataTests, SmallSetSubDataIsInline) {
+    uint32_t data = 31337;
+    nxtBufferSetSubData(buffer, 0, 1, &data);
+
+    EXPECT_CALL(api, BufferSetSubData(apiBuffer, 0, 1, _))
+        .WillOnce(Invoke([&](nxtBuffer, uint32_t, uint32_t, const uint32_t* apiData) {
+            const uint8_t* sharedData = sharedMemory->GetData();
+            ASSERT_TRUE(reinterpret_cast<const uint8_t*>(apiData) < sharedData ||
+                        reinterpret_cast<const uint8_t*>(apiData) >= sharedData + kSharedMemorySize);
+            ASSERT_EQ(data, *apiData);
+        }));
+
+    FlushClient();
+}
+
+// Check the space of bulk data is also reclaimed when the command is skipped because of an error
+TEST_P(WireBulkDataTests, ErrorObjectReclaimsBulkData) {
+    std::vector<uint32_t> data(kSharedMemoryWords, 42);
+    nxtBufferSetSubData(errorBuffer, 0, kSharedMemoryWords, data.data());
+
+    FlushClient();
+    FlushServer();
+
+    nxtBufferSetSubData(buffer, 0, kSharedMemoryWords, data.data());
+    const uint32_t* sharedData = reinterpret_cast<const uint32_t*>(sharedMemory->GetData());
+    EXPECT_CALL(api, BufferSetSubData(apiBuffer, 0, kSharedMemoryWords, sharedData))
+        .Times(1);
+
+    FlushClient();
+}
+
+// Check bulk data falls back to the command stream when the shared memory is full
+TEST_P(WireBulkDataTests, FallbackWhenSharedMemoryIsFull) {
+    std::vector<uint32_t> data(kSharedMemoryWords, 42);
+    nxtBufferSetSubData(buffer, 0, kSharedMemoryWords, data.data());
+    nxtBufferSetSubData(buffer, 0, kSharedMemoryWords, data.data());
+
+    const uint32_t* sharedData = reinterpret_cast<const uint32_t*>(sharedMemory->GetData());
+    InSequence sequence;
+    EXPECT_CALL(api, BufferSetSubData(apiBuffer, 0, kSharedMemoryWords, sharedData))
+        .Times(1);
+    EXPECT_CALL(api, BufferSetSubData(apiBuffer, 0, kSharedMemoryWords, Ne(sharedData)))
+        .WillOnce(Invoke([&](nxtBuffer, uint32_t, uint32_t, const uint32_t* apiData) {
+            ASSERT_EQ(0, memcmp(data.data(), apiData, kSharedMemorySize));
+        }));
+
+    FlushClient();
+}
+
+INSTANTIATE_WIRE_TESTS(WireBulkDataTests);
+
+class WireFenceTests : public WireTestsBase {
+    public:
+        WireFenceTests() : WireTestsBase(true) {
+        }
+
+        void SetUp() override {
+            WireTestsBase::SetUp();
+
+            nxtQueueBuilder apiQueueBuilder = api.GetNewQueueBuilder();
+            nxtQueueBuilder queueBuilder = nxtDeviceCreateQueueBuilder(device);
+            EXPECT_CALL(api, DeviceCreateQueueBuilder(apiDevice))
+                .WillOnce(Return(apiQueueBuilder));
+
+            apiQueue = api.GetNewQueue();
+            queue = nxtQueueBuilderGetResult(queueBuilder);
+            EXPECT_CALL(api, QueueBuilderGetResult(apiQueueBuilder))
+                .WillOnce(Return(apiQueue));
+
+            fence = CreateFence(&apiFence);
+            errorFence = CreateFence(nullptr);
+        }
+
+    protected:
+        // Creates a fence that is an error on the server side when apiFence is nullptr.
+        nxtFence CreateFence(nxtFence* apiFence) {
+            nxtFenceBuilder apiFenceBuilder = api.GetNewFenceBuilder();
+            nxtFenceBuilder fenceBuilder = nxtDeviceCreateFenceBuilder(device);
+            EXPECT_CALL(api, DeviceCreateFenceBuilder(apiDevice))
+                .WillOnce(Return(apiFenceBuilder))
+                .RetiresOnSaturation();
+
+            nxtFence result = nxtFenceBuilderGetResult(fenceBuilder);
+            nxtFence apiResult = nullptr;
+            if (apiFence != nullptr) {
+                apiResult = api.GetNewFence();
+                *apiFence = apiResult;
+            }
+            EXPECT_CALL(api, FenceBuilderGetResult(apiFenceBuilder))
+                .WillOnce(Return(apiResult))
+                .RetiresOnSaturation();
+
+            // Flush so that the expectations of the next fence don't match these calls.
+            FlushClient();
+            return result;
+        }
+
+        // Signals the fence and makes the server ask the backend for the completion of the value.
+        void SignalAndFlush(uint64_t value) {
+            nxtQueueSignal(queue, fence, value);
+
+            EXPECT_CALL(api, QueueSignal(apiQueue, apiFence, value))
+                .Times(1);
+            EXPECT_CALL(api, OnFenceOnCompletionCallback(apiFence, value, _, _))
+                .Times(1);
+            FlushClient();
+        }
+
+        nxtQueue queue;
+        nxtQueue apiQueue;
+        nxtFence fence;
+        nxtFence apiFence;
+
+        // A fence that wasn't created on the server side
+        nxtFence errorFence;
+};
+
+// Check the completed value is sent back to the client and calls its callbacks
+TEST_P(WireFenceTests, CompletedValueSentToClient) {
+    SignalAndFlush(3);
+    ASSERT_EQ(0u, nxtFenceGetCompletedValue(fence));
+
+    nxtCallbackUserdata userdata = 4242;
+    nxtFenceOnCompletion(fence, 2, ToMockFenceOnCompletionCallback, userdata);
+    nxtFenceOnCompletion(fence, 3, ToMockFenceOnCompletionCallback, userdata + 1);
+
+    api.CallFenceOnCompletionCallback(apiFence, NXT_FENCE_COMPLETION_STATUS_SUCCESS);
+    EXPECT_CALL(*mockFenceOnCompletionCallback, Call(NXT_FENCE_COMPLETION_STATUS_SUCCESS, userdata))
+        .Times(1);
+    EXPECT_CALL(*mockFenceOnCompletionCallback, Call(NXT_FENCE_COMPLETION_STATUS_SUCCESS, userdata + 1))
+        .Times(1);
+    FlushServer();
+
+    ASSERT_EQ(3u, nxtFenceGetCompletedValue(fence));
+}
+
+// Check callbacks for values already completed are called right away
+TEST_P(WireFenceTests, OnCompletionOfCompletedValue) {
+    SignalAndFlush(1);
+    api.CallFenceOnCompletionCallback(apiFence, NXT_FENCE_COMPLETION_STATUS_SUCCESS);
+    FlushServer();
+
+    nxtCallbackUserdata userdata = 4243;
+    EXPECT_CALL(*mockFenceOnCompletionCallback, Call(NXT_FENCE_COMPLETION_STATUS_SUCCESS, userdata))
+        .Times(1);
+    nxtFenceOnCompletion(fence, 1, ToMockFenceOnCompletionCallback, userdata);
+}
+
+// Check waiting on a value the fence wasn't signaled with is an error on the client
+TEST_P(WireFenceTests, OnCompletionOfUnsignaledValue) {
+    SignalAndFlush(1);
+
+    nxtCallbackUserdata userdata = 4244;
+    EXPECT_CALL(*mockFenceOnCompletionCallback, Call(NXT_FENCE_COMPLETION_STATUS_ERROR, userdata))
+        .Times(1);
+    nxtFenceOnCompletion(fence, 2, ToMockFenceOnCompletionCallback, userdata);
+}
+
+// Check the callbacks are called with UNKNOWN when the fence is destroyed before completing
+TEST_P(WireFenceTests, DestroyBeforeCompletion) {
+    SignalAndFlush(1);
+
+    nxtCallbackUserdata userdata = 4245;
+    nxtFenceOnCompletion(fence, 1, ToMockFenceOnCompletionCallback, userdata);
+
+    EXPECT_CALL(*mockFenceOnCompletionCallback, Call(NXT_FENCE_COMPLETION_STATUS_UNKNOWN, userdata))
+        .Times(1);
+    nxtFenceRelease(fence);
+}
+
+// Check error fences and invalid signals don't ask the backend for completions
+TEST_P(WireFenceTests, NoCompletionForErrors) {
+    SignalAndFlush(2);
+
+    nxtQueueSignal(queue, fence, 1);
+    EXPECT_CALL(api, QueueSignal(apiQueue, apiFence, 1))
+        .Times(1);
+    nxtQueueSignal(queue, errorFence, 1);
+    EXPECT_CALL(api, OnFenceOnCompletionCallback(_, _, _, _))
+        .Times(0);
+    FlushClient();
+}
+
+INSTANTIATE_WIRE_TESTS(WireFenceTests);
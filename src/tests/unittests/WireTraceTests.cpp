@@ -0,0 +1,185 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include "mock/mock_nxt.h"
+
+#include "wire/WireCmd.h"
+#include "wire/WireTrace.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace testing;
+using namespace nxt::wire;
+
+namespace {
+
+    constexpr char kTracePath[] = "WireTraceTests.trace";
+
+    // Keeps the last command in memory, like a real transport would until the next Flush.
+    class DiscardingSerializer : public CommandSerializer {
+      public:
+        void* GetCmdSpace(size_t size) override {
+            mBuffers.emplace_back(size);
+            return mBuffers.back().data();
+        }
+        void Flush() override {
+            mBuffers.clear();
+        }
+
+      private:
+        std::vector<std::vector<uint8_t>> mBuffers;
+    };
+
+}  // anonymous namespace
+
+class WireTraceTests : public Test {
+    protected:
+        void TearDown() override {
+            remove(kTracePath);
+        }
+
+        // Captures two flushes of a client creating a buffer.
+        void CaptureTrace() {
+            DiscardingSerializer transport;
+            TracingCommandSerializer serializer(&transport, kTracePath);
+            ASSERT_FALSE(serializer.HasError());
+
+            nxtProcTable procs;
+            nxtDevice device;
+            CommandHandler* client = NewClientDevice(&procs, &device, &serializer);
+
+            nxtBufferBuilder builder = procs.deviceCreateBufferBuilder(device);
+            procs.bufferBuilderSetSize(builder, 4);
+            serializer.Flush();
+
+            procs.bufferBuilderGetResult(builder);
+            procs.bufferBuilderRelease(builder);
+            serializer.Flush();
+
+            // Flushes without commands don't create records.
+            serializer.Flush();
+            ASSERT_FALSE(serializer.HasError());
+
+            delete client;
+        }
+};
+
+// Test the records of a trace are the flushes of the client, made of whole commands.
+TEST_F(WireTraceTests, RecordsAreFlushes) {
+    CaptureTrace();
+
+    WireTraceReader reader(kTracePath);
+    ASSERT_FALSE(reader.HasError());
+
+    std::vector<std::vector<WireCmd>> records;
+    WireTraceRecord record;
+    uint64_t lastTimestampNs = 0;
+    while (reader.ReadRecord(&record)) {
+        ASSERT_GE(record.timestampNs, lastTimestampNs);
+        lastTimestampNs = record.timestampNs;
+
+        records.emplace_back();
+        const uint8_t* commands = record.commands.data();
+        size_t size = record.commands.size();
+        while (size > 0) {
+            size_t cmdSize = GetWireCmdSize(commands, size);
+            ASSERT_NE(0u, cmdSize);
+            records.back().push_back(*reinterpret_cast<const WireCmd*>(commands));
+            commands += cmdSize;
+            size -= cmdSize;
+        }
+    }
+    ASSERT_FALSE(reader.HasError());
+
+    std::vector<std::vector<WireCmd>> expected = {
+        {WireCmd::DeviceCreateBufferBuilder, WireCmd::BufferBuilderSetSize},
+        {WireCmd::BufferBuilderGetResult, WireCmd::BufferBuilderDestroy},
+    };
+    ASSERT_EQ(expected, records);
+}
+
+// Test replaying a trace in a server makes the captured calls.
+TEST_F(WireTraceTests, Replay) {
+    CaptureTrace();
+
+    MockProcTable api;
+    nxtProcTable mockProcs;
+    nxtDevice mockDevice;
+    api.GetProcTableAndDevice(&mockProcs, &mockDevice);
+
+    EXPECT_CALL(api, OnDeviceSetErrorCallback(_, _, _)).Times(1);
+    EXPECT_CALL(api, OnBuilderSetErrorCallback(_, _, _, _)).Times(AnyNumber());
+    EXPECT_CALL(api, DeviceTick(_)).Times(AnyNumber());
+
+    DiscardingSerializer returnSerializer;
+    CommandHandler* server = NewServerCommandHandler(mockDevice, mockProcs, &returnSerializer);
+
+    nxtBufferBuilder apiBuilder = api.GetNewBufferBuilder();
+    {
+        InSequence sequence;
+        EXPECT_CALL(api, DeviceCreateBufferBuilder(mockDevice)).WillOnce(Return(apiBuilder));
+        EXPECT_CALL(api, BufferBuilderSetSize(apiBuilder, 4));
+        EXPECT_CALL(api, BufferBuilderGetResult(apiBuilder)).WillOnce(Return(api.GetNewBuffer()));
+        EXPECT_CALL(api, BufferBuilderRelease(apiBuilder));
+    }
+
+    WireTraceReader reader(kTracePath);
+    WireTraceRecord record;
+    while (reader.ReadRecord(&record)) {
+        ASSERT_NE(nullptr, server->HandleCommands(record.commands.data(), record.commands.size()));
+    }
+    ASSERT_FALSE(reader.HasError());
+
+    delete server;
+}
+
+// Test truncated traces and files that aren't traces are errors.
+TEST_F(WireTraceTests, CorruptTraces) {
+    CaptureTrace();
+
+    FILE* file = fopen(kTracePath, "rb");
+    ASSERT_NE(nullptr, file);
+    std::vector<uint8_t> trace;
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        trace.push_back(static_cast<uint8_t>(c));
+    }
+    fclose(file);
+
+    auto readAll = [](const std::vector<uint8_t>& data) {
+        FILE* corruptFile = fopen(kTracePath, "wb");
+        fwrite(data.data(), 1, data.size(), corruptFile);
+        fclose(corruptFile);
+
+        WireTraceReader reader(kTracePath);
+        WireTraceRecord record;
+        while (reader.ReadRecord(&record)) {
+        }
+        return !reader.HasError();
+    };
+
+    ASSERT_TRUE(readAll(trace));
+
+    // Truncated in the middle of a record header and of the commands of a record.
+    std::vector<uint8_t> truncated(trace.begin(), trace.end() - 1);
+    ASSERT_FALSE(readAll(truncated));
+    truncated.assign(trace.begin(), trace.begin() + sizeof(WireTraceHeader) + 4);
+    ASSERT_FALSE(readAll(truncated));
+
+    std::vector<uint8_t> badMagic = trace;
+    badMagic[0] ^= 0xFF;
+    ASSERT_FALSE(readAll(badMagic));
+}
@@ -0,0 +1,186 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "backend/null/NullBackend.h"
+#include "common/Constants.h"
+
+#include <cstring>
+#include <vector>
+
+namespace backend { namespace null {
+    void Init(nxtProcTable* procs, nxtDevice* device);
+}}  // namespace backend::null
+
+using namespace backend::null;
+
+namespace {
+
+    constexpr uint32_t kTexelSize = 4;
+
+    const uint8_t* GetData(const nxt::Buffer& buffer) {
+        return reinterpret_cast<Buffer*>(buffer.Get())->GetBackingData();
+    }
+
+}  // anonymous namespace
+
+class CopyCommandsTests : public testing::Test {
+    protected:
+        void SetUp() override {
+            nxtProcTable procs;
+            nxtDevice device;
+            Init(&procs, &device);
+            nxtSetProcs(&procs);
+            mDevice = nxt::Device::Acquire(device);
+            mQueue = mDevice.CreateQueueBuilder().GetResult();
+        }
+
+        void TearDown() override {
+            mQueue = nxt::Queue();
+            mDevice = nxt::Device();
+            nxtSetProcs(nullptr);
+        }
+
+        nxt::Buffer CreateBuffer(const std::vector<uint8_t>& data) {
+            nxt::Buffer buffer =
+                mDevice.CreateBufferBuilder()
+                    .SetAllowedUsage(nxt::BufferUsageBit::TransferSrc |
+                                     nxt::BufferUsageBit::TransferDst)
+                    .SetInitialUsage(nxt::BufferUsageBit::TransferDst)
+                    .SetSize(static_cast<uint32_t>(data.size()))
+                    .GetResult();
+            buffer.SetSubData(0, static_cast<uint32_t>(data.size() / sizeof(uint32_t)),
+                              reinterpret_cast<const uint32_t*>(data.data()));
+            return buffer;
+        }
+
+        nxt::Texture CreateTexture(uint32_t width, uint32_t height, uint32_t levels) {
+            return mDevice.CreateTextureBuilder()
+                .SetDimension(nxt::TextureDimension::e2D)
+                .SetExtent(width, height, 1)
+                .SetFormat(nxt::TextureFormat::R8G8B8A8Unorm)
+                .SetMipLevels(levels)
+                .SetAllowedUsage(nxt::TextureUsageBit::TransferSrc |
+                                 nxt::TextureUsageBit::TransferDst)
+                .GetResult();
+        }
+
+        // The results are read directly from the backend so the submit is flushed right away.
+        void Submit(const nxt::CommandBuffer& commands) {
+            mQueue.Submit(1, &commands);
+            mQueue.Flush();
+        }
+
+        nxt::Device mDevice;
+        nxt::Queue mQueue;
+};
+
+// Test buffer to buffer copies honor the offsets and size
+TEST_F(CopyCommandsTests, BufferToBuffer) {
+    std::vector<uint8_t> sourceData(64);
+    for (size_t i = 0; i < sourceData.size(); ++i) {
+        sourceData[i] = static_cast<uint8_t>(i);
+    }
+    nxt::Buffer source = CreateBuffer(sourceData);
+    nxt::Buffer destination = CreateBuffer(std::vector<uint8_t>(64, 0xFF));
+
+    Submit(mDevice.CreateCommandBufferBuilder()
+               .TransitionBufferUsage(source, nxt::BufferUsageBit::TransferSrc)
+               .TransitionBufferUsage(destination, nxt::BufferUsageBit::TransferDst)
+               .CopyBufferToBuffer(source, 8, destination, 16, 32)
+               .GetResult());
+
+    const uint8_t* result = GetData(destination);
+    for (uint32_t i = 0; i < 64; ++i) {
+        if (i >= 16 && i < 48) {
+            ASSERT_EQ(result[i], i - 8);
+        } else {
+            ASSERT_EQ(result[i], 0xFF);
+        }
+    }
+}
+
+// Test a region of a mip level goes through buffer to texture and texture to buffer copies, with
+// row pitches larger than the rows.
+TEST_F(CopyCommandsTests, TextureRoundTrip) {
+    constexpr uint32_t kWidth = 40;
+    constexpr uint32_t kHeight = 20;
+    constexpr uint32_t kRowPitch = kTextureRowPitchAlignment;
+    constexpr uint32_t kBufferSize = kRowPitch * kHeight;
+    nxt::Texture texture = CreateTexture(kWidth * 2, kHeight * 2, 2);
+
+    std::vector<uint8_t> uploadData(kBufferSize);
+    for (size_t i = 0; i < uploadData.size(); ++i) {
+        uploadData[i] = static_cast<uint8_t>(i * 7);
+    }
+    nxt::Buffer upload = CreateBuffer(uploadData);
+    nxt::Buffer readback = CreateBuffer(std::vector<uint8_t>(kBufferSize, 0xFF));
+
+    // Upload the whole level 1 then read back a region of it at an offset in the buffer.
+    Submit(mDevice.CreateCommandBufferBuilder()
+               .TransitionBufferUsage(upload, nxt::BufferUsageBit::TransferSrc)
+               .TransitionTextureUsage(texture, nxt::TextureUsageBit::TransferDst)
+               .CopyBufferToTexture(upload, 0, kRowPitch, texture, 0, 0, 0, kWidth, kHeight, 1, 1)
+               .TransitionTextureUsage(texture, nxt::TextureUsageBit::TransferSrc)
+               .TransitionBufferUsage(readback, nxt::BufferUsageBit::TransferDst)
+               .CopyTextureToBuffer(texture, 3, 5, 0, 10, 4, 1, 1, readback, 4, kRowPitch)
+               .GetResult());
+
+    const uint8_t* result = GetData(readback);
+    for (uint32_t y = 0; y < 4; ++y) {
+        const uint8_t* row = result + 4 + y * kRowPitch;
+        const uint8_t* expected = uploadData.data() + (5 + y) * kRowPitch + 3 * kTexelSize;
+        ASSERT_EQ(memcmp(row, expected, 10 * kTexelSize), 0) << "row " << y;
+
+        // The padding at the end of the rows isn't touched.
+        const uint8_t* padding = row + 10 * kTexelSize;
+        ASSERT_EQ(padding[0], 0xFF);
+        ASSERT_EQ(padding[kRowPitch - 10 * kTexelSize - 1], 0xFF);
+    }
+}
+
+// Test copies of tightly packed rows, and that textures start zero-initialized
+TEST_F(CopyCommandsTests, TightlyPackedRows) {
+    constexpr uint32_t kWidth = kTextureRowPitchAlignment / kTexelSize;
+    constexpr uint32_t kHeight = 8;
+    constexpr uint32_t kBufferSize = kWidth * kHeight * kTexelSize;
+    nxt::Texture texture = CreateTexture(kWidth, kHeight, 1);
+
+    std::vector<uint8_t> uploadData(kBufferSize);
+    for (size_t i = 0; i < uploadData.size(); ++i) {
+        uploadData[i] = static_cast<uint8_t>(i * 3 + 1);
+    }
+    nxt::Buffer upload = CreateBuffer(uploadData);
+    nxt::Buffer initialContent = CreateBuffer(std::vector<uint8_t>(kBufferSize, 0xFF));
+    nxt::Buffer readback = CreateBuffer(std::vector<uint8_t>(kBufferSize, 0xFF));
+
+    Submit(mDevice.CreateCommandBufferBuilder()
+               .TransitionTextureUsage(texture, nxt::TextureUsageBit::TransferSrc)
+               .TransitionBufferUsage(initialContent, nxt::BufferUsageBit::TransferDst)
+               .CopyTextureToBuffer(texture, 0, 0, 0, kWidth, kHeight, 1, 0, initialContent, 0,
+                                    0)
+               .TransitionBufferUsage(upload, nxt::BufferUsageBit::TransferSrc)
+               .TransitionTextureUsage(texture, nxt::TextureUsageBit::TransferDst)
+               .CopyBufferToTexture(upload, 0, 0, texture, 0, 0, 0, kWidth, kHeight, 1, 0)
+               .TransitionTextureUsage(texture, nxt::TextureUsageBit::TransferSrc)
+               .TransitionBufferUsage(readback, nxt::BufferUsageBit::TransferDst)
+               .CopyTextureToBuffer(texture, 0, 0, 0, kWidth, kHeight, 1, 0, readback, 0, 0)
+               .GetResult());
+
+    ASSERT_EQ(memcmp(GetData(initialContent), std::vector<uint8_t>(kBufferSize, 0).data(),
+                     kBufferSize),
+              0);
+    ASSERT_EQ(memcmp(GetData(readback), uploadData.data(), kBufferSize), 0);
+}
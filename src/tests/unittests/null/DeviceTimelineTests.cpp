@@ -0,0 +1,345 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "backend/null/NullBackend.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace backend::null;
+
+namespace {
+
+    TimelineDescriptor ManualTimeline(uint64_t submitCost) {
+        TimelineDescriptor descriptor;
+        descriptor.clock = TimelineClock::Manual;
+        descriptor.costs.submit = submitCost;
+        return descriptor;
+    }
+
+    // Returns the times at which each of the submits completes, advancing time one nanosecond at
+    // a time.
+    std::vector<uint64_t> GetCompletionTimes(DeviceTimeline* timeline, uint32_t submitCount) {
+        for (uint32_t i = 0; i < submitCount; ++i) {
+            timeline->Submit(SubmitWorkload());
+        }
+
+        std::vector<uint64_t> times;
+        uint64_t time = 0;
+        while (times.size() < submitCount) {
+            timeline->AdvanceTime(1);
+            time++;
+            while (timeline->GetCompletedSerial() > times.size()) {
+                times.push_back(time);
+            }
+        }
+        return times;
+    }
+
+}  // anonymous namespace
+
+// Test the immediate timeline completes submits as they are made
+TEST(DeviceTimelineTests, ImmediateCompletesOnSubmit) {
+    DeviceTimeline timeline(TimelineDescriptor{});
+
+    ASSERT_EQ(timeline.Submit(SubmitWorkload()), 1u);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 1u);
+    ASSERT_EQ(timeline.Submit(SubmitWorkload()), 2u);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 2u);
+}
+
+// Test the duration of a submit is the sum of the costs of its commands
+TEST(DeviceTimelineTests, DurationFromCosts) {
+    TimelineDescriptor descriptor = ManualTimeline(100);
+    descriptor.costs.renderPass = 20;
+    descriptor.costs.draw = 10;
+    descriptor.costs.dispatch = 7;
+    descriptor.costs.workgroup = 1;
+    descriptor.costs.copy = 3;
+    descriptor.costs.copiedKilobyte = 4;
+    DeviceTimeline timeline(descriptor);
+
+    SubmitWorkload workload;
+    workload.renderPasses = 2;
+    workload.draws = 5;
+    workload.dispatches = 1;
+    workload.workgroups = 64;
+    workload.copies = 2;
+    workload.copiedBytes = 4096;
+    timeline.Submit(workload);
+
+    // 100 + 2 * 20 + 5 * 10 + 7 + 64 + 2 * 3 + 4 * 4 = 283
+    timeline.AdvanceTime(282);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 0u);
+    timeline.AdvanceTime(1);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 1u);
+}
+
+// Test submits run one after the other, and start when submitted if the GPU is idle
+TEST(DeviceTimelineTests, SubmitsCompleteInOrder) {
+    DeviceTimeline timeline(ManualTimeline(100));
+
+    timeline.Submit(SubmitWorkload());
+    timeline.Submit(SubmitWorkload());
+    timeline.AdvanceTime(150);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 1u);
+    timeline.AdvanceTime(50);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 2u);
+
+    timeline.AdvanceTime(1000);
+    timeline.Submit(SubmitWorkload());
+    timeline.AdvanceTime(99);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 2u);
+    timeline.AdvanceTime(1);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 3u);
+}
+
+// Test a signal completes with the previous submits, or right away when the GPU is idle
+TEST(DeviceTimelineTests, Signal) {
+    DeviceTimeline timeline(ManualTimeline(100));
+
+    timeline.Submit(SubmitWorkload());
+    ASSERT_EQ(timeline.Signal(), 2u);
+    timeline.AdvanceTime(100);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 2u);
+
+    ASSERT_EQ(timeline.Signal(), 3u);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 3u);
+}
+
+// Test submits to different queue types run concurrently on their engines
+TEST(DeviceTimelineTests, EnginesRunConcurrently) {
+    DeviceTimeline timeline(ManualTimeline(100));
+
+    timeline.Submit(SubmitWorkload(), nxt::QueueType::Graphics);
+    timeline.Submit(SubmitWorkload(), nxt::QueueType::Compute);
+    timeline.Submit(SubmitWorkload(), nxt::QueueType::Graphics);
+    timeline.AdvanceTime(100);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 2u);
+    timeline.AdvanceTime(100);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 3u);
+}
+
+// Test a wait makes the next submits of an engine start after the submits waited on
+TEST(DeviceTimelineTests, WaitDelaysEngine) {
+    DeviceTimeline timeline(ManualTimeline(100));
+
+    Serial graphicsSerial = timeline.Submit(SubmitWorkload(), nxt::QueueType::Graphics);
+    timeline.Wait(nxt::QueueType::Compute, graphicsSerial);
+    timeline.Submit(SubmitWorkload(), nxt::QueueType::Compute);
+    timeline.AdvanceTime(199);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 1u);
+    timeline.AdvanceTime(1);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 2u);
+
+    // Waiting on completed submits doesn't delay the engine.
+    timeline.Wait(nxt::QueueType::Compute, graphicsSerial);
+    timeline.Submit(SubmitWorkload(), nxt::QueueType::Compute);
+    timeline.AdvanceTime(100);
+    ASSERT_EQ(timeline.GetCompletedSerial(), 3u);
+}
+
+// Test jitter changes the durations in its range, the same way for the same seed
+TEST(DeviceTimelineTests, JitterIsDeterministic) {
+    constexpr uint32_t kSubmitCount = 16;
+    TimelineDescriptor descriptor = ManualTimeline(1000);
+    descriptor.jitter = 0.5f;
+    descriptor.seed = 1234;
+
+    DeviceTimeline timeline1(descriptor);
+    DeviceTimeline timeline2(descriptor);
+    std::vector<uint64_t> times1 = GetCompletionTimes(&timeline1, kSubmitCount);
+    std::vector<uint64_t> times2 = GetCompletionTimes(&timeline2, kSubmitCount);
+    ASSERT_EQ(times1, times2);
+
+    bool allExact = true;
+    uint64_t previous = 0;
+    for (uint64_t time : times1) {
+        uint64_t duration = time - previous;
+        ASSERT_GE(duration, 500u);
+        ASSERT_LE(duration, 1500u);
+        allExact = allExact && duration == 1000;
+        previous = time;
+    }
+    ASSERT_FALSE(allExact);
+}
+
+// Test the real time timeline completes submits on its thread
+TEST(DeviceTimelineTests, RealTimeCompletesInBackground) {
+    TimelineDescriptor descriptor;
+    descriptor.clock = TimelineClock::RealTime;
+    descriptor.costs.submit = 20 * 1000 * 1000;
+    DeviceTimeline timeline(descriptor);
+
+    auto start = std::chrono::steady_clock::now();
+    Serial serial = timeline.Submit(SubmitWorkload());
+    while (timeline.GetCompletedSerial() < serial) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+}
+
+class DeviceTimelineDeviceTests : public testing::Test {
+    protected:
+        void SetUp() override {
+            nxtProcTable procs;
+            nxtDevice device;
+            Init(&procs, &device, ManualTimeline(1000));
+            nxtSetProcs(&procs);
+            mDevice = nxt::Device::Acquire(device);
+            mQueue = mDevice.CreateQueueBuilder().GetResult();
+            mTimeline = reinterpret_cast<Device*>(device)->GetTimeline();
+        }
+
+        void TearDown() override {
+            mQueue = nxt::Queue();
+            mDevice = nxt::Device();
+            nxtSetProcs(nullptr);
+        }
+
+        nxt::Buffer CreateBuffer(nxt::BufferUsageBit usage) {
+            return mDevice.CreateBufferBuilder()
+                .SetAllowedUsage(usage)
+                .SetInitialUsage(usage)
+                .SetSize(4)
+                .GetResult();
+        }
+
+        static void OnMapRead(nxtBufferMapReadStatus status,
+                              const void*,
+                              nxtCallbackUserdata userdata) {
+            ASSERT_EQ(status, NXT_BUFFER_MAP_READ_STATUS_SUCCESS);
+            reinterpret_cast<DeviceTimelineDeviceTests*>(static_cast<uintptr_t>(userdata))
+                ->mMapReadCount++;
+        }
+
+        void MapRead(const nxt::Buffer& buffer) {
+            nxtCallbackUserdata userdata =
+                static_cast<nxtCallbackUserdata>(reinterpret_cast<uintptr_t>(this));
+            buffer.MapReadAsync(0, 4, OnMapRead, userdata);
+        }
+
+        nxt::Device mDevice;
+        nxt::Queue mQueue;
+        DeviceTimeline* mTimeline = nullptr;
+        uint32_t mMapReadCount = 0;
+};
+
+// Test map read callbacks are called by the first Submit or Tick after the next submit completes
+TEST_F(DeviceTimelineDeviceTests, MapReadWaitsForSubmit) {
+    nxt::Buffer buffer = CreateBuffer(nxt::BufferUsageBit::MapRead);
+    MapRead(buffer);
+
+    mQueue.Submit(0, nullptr);
+    mDevice.Tick();
+    ASSERT_EQ(mMapReadCount, 0u);
+
+    mTimeline->AdvanceTime(1000);
+    ASSERT_EQ(mMapReadCount, 0u);
+    mDevice.Tick();
+    ASSERT_EQ(mMapReadCount, 1u);
+}
+
+// Test map reads complete on Tick when the GPU is idle, without a submit
+TEST_F(DeviceTimelineDeviceTests, MapReadWhenIdle) {
+    nxt::Buffer buffer = CreateBuffer(nxt::BufferUsageBit::MapRead);
+    MapRead(buffer);
+
+    mDevice.Tick();
+    ASSERT_EQ(mMapReadCount, 1u);
+}
+
+// Test map reads made while the GPU is busy wait for it to be idle
+TEST_F(DeviceTimelineDeviceTests, MapReadWhileBusy) {
+    nxt::Buffer buffer = CreateBuffer(nxt::BufferUsageBit::MapRead);
+    mQueue.Submit(0, nullptr);
+    MapRead(buffer);
+
+    mDevice.Tick();
+    ASSERT_EQ(mMapReadCount, 0u);
+
+    mTimeline->AdvanceTime(1000);
+    mDevice.Tick();
+    ASSERT_EQ(mMapReadCount, 1u);
+}
+
+// Test submitted command buffers keep the objects they use alive until the submit completes
+TEST_F(DeviceTimelineDeviceTests, DeferredDestruction) {
+    nxt::Buffer source = CreateBuffer(nxt::BufferUsageBit::TransferSrc);
+    nxt::Buffer destination = CreateBuffer(nxt::BufferUsageBit::TransferDst);
+    source.FreezeUsage(nxt::BufferUsageBit::TransferSrc);
+    destination.FreezeUsage(nxt::BufferUsageBit::TransferDst);
+    Buffer* backendSource = reinterpret_cast<Buffer*>(source.Get());
+    uint32_t internalRefs = backendSource->GetInternalRefs();
+
+    {
+        nxt::CommandBuffer commands = mDevice.CreateCommandBufferBuilder()
+                                          .CopyBufferToBuffer(source, 0, destination, 0, 4)
+                                          .GetResult();
+        mQueue.Submit(1, &commands);
+        mQueue.Flush();
+    }
+    ASSERT_GT(backendSource->GetInternalRefs(), internalRefs);
+
+    mTimeline->AdvanceTime(999);
+    mDevice.Tick();
+    ASSERT_GT(backendSource->GetInternalRefs(), internalRefs);
+
+    mTimeline->AdvanceTime(1);
+    mDevice.Tick();
+    ASSERT_EQ(backendSource->GetInternalRefs(), internalRefs);
+}
+
+// Test fences reach the values signaled after a submit when that submit completes
+TEST_F(DeviceTimelineDeviceTests, FenceCompletesWithSubmits) {
+    nxt::Fence fence = mDevice.CreateFenceBuilder().GetResult();
+
+    mQueue.Submit(0, nullptr);
+    mQueue.Signal(fence, 1);
+    mQueue.Submit(0, nullptr);
+    mQueue.Signal(fence, 2);
+
+    mDevice.Tick();
+    ASSERT_EQ(fence.GetCompletedValue(), 0u);
+
+    mTimeline->AdvanceTime(1000);
+    mDevice.Tick();
+    ASSERT_EQ(fence.GetCompletedValue(), 1u);
+
+    mTimeline->AdvanceTime(1000);
+    mDevice.Tick();
+    ASSERT_EQ(fence.GetCompletedValue(), 2u);
+}
+
+// Test a compute queue waiting on a fence signaled by the graphics queue runs after it
+TEST_F(DeviceTimelineDeviceTests, QueueWaitsOnFence) {
+    nxt::Queue compute = mDevice.CreateQueueBuilder().SetType(nxt::QueueType::Compute).GetResult();
+    nxt::Fence fence = mDevice.CreateFenceBuilder().GetResult();
+
+    mQueue.Submit(0, nullptr);
+    mQueue.Signal(fence, 1);
+    compute.Wait(fence, 1);
+    compute.Submit(0, nullptr);
+    compute.Flush();
+
+    mTimeline->AdvanceTime(1000);
+    ASSERT_EQ(mTimeline->GetCompletedSerial(), 1u);
+    mTimeline->AdvanceTime(999);
+    ASSERT_EQ(mTimeline->GetCompletedSerial(), 1u);
+    mTimeline->AdvanceTime(1);
+    ASSERT_EQ(mTimeline->GetCompletedSerial(), 2u);
+}
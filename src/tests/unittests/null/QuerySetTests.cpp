@@ -0,0 +1,205 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "backend/null/NullBackend.h"
+#include "utils/PassTimings.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace backend::null;
+
+class QuerySetTests : public testing::Test {
+    protected:
+        static constexpr uint64_t kSubmitCost = 1000;
+        static constexpr uint64_t kCopyCost = 100;
+
+        void SetUp() override {
+            TimelineDescriptor timeline;
+            timeline.clock = TimelineClock::Manual;
+            timeline.costs.submit = kSubmitCost;
+            timeline.costs.copy = kCopyCost;
+
+            nxtProcTable procs;
+            nxtDevice device;
+            Init(&procs, &device, timeline);
+            nxtSetProcs(&procs);
+            mDevice = nxt::Device::Acquire(device);
+            mQueue = mDevice.CreateQueueBuilder().GetResult();
+            mTimeline = reinterpret_cast<Device*>(device)->GetTimeline();
+
+            mSource = CreateBuffer(nxt::BufferUsageBit::TransferSrc, 4);
+            mDestination = CreateBuffer(nxt::BufferUsageBit::TransferDst, 4);
+        }
+
+        void TearDown() override {
+            mSource = nxt::Buffer();
+            mDestination = nxt::Buffer();
+            mQueue = nxt::Queue();
+            mDevice = nxt::Device();
+            nxtSetProcs(nullptr);
+        }
+
+        nxt::Buffer CreateBuffer(nxt::BufferUsageBit usage, uint32_t size) {
+            nxt::Buffer buffer =
+                mDevice.CreateBufferBuilder().SetAllowedUsage(usage).SetSize(size).GetResult();
+            buffer.FreezeUsage(usage);
+            return buffer;
+        }
+
+        nxt::Buffer CreateResultBuffer(uint32_t count) {
+            return mDevice.CreateBufferBuilder()
+                .SetAllowedUsage(nxt::BufferUsageBit::TransferDst | nxt::BufferUsageBit::MapRead)
+                .SetInitialUsage(nxt::BufferUsageBit::MapRead)
+                .SetSize(count * sizeof(uint64_t))
+                .GetResult();
+        }
+
+        // Records the copies that make the workload of a pass.
+        void AddCopies(nxt::CommandBufferBuilder* builder, uint32_t count) {
+            for (uint32_t i = 0; i < count; ++i) {
+                builder->CopyBufferToBuffer(mSource, 0, mDestination, 0, 4);
+            }
+        }
+
+        // Resolves the queries to a buffer, waits for the submit and returns the results.
+        std::vector<uint64_t> ResolveAndRead(nxt::CommandBufferBuilder builder,
+                                             const nxt::QuerySet& querySet,
+                                             uint32_t queryCount,
+                                             uint32_t resultsPerQuery = 1) {
+            uint32_t resultCount = queryCount * resultsPerQuery;
+            nxt::Buffer results = CreateResultBuffer(resultCount);
+            nxt::CommandBuffer commands =
+                builder.TransitionBufferUsage(results, nxt::BufferUsageBit::TransferDst)
+                    .ResolveQuerySet(querySet, 0, queryCount, results, 0)
+                    .TransitionBufferUsage(results, nxt::BufferUsageBit::MapRead)
+                    .GetResult();
+            mQueue.Submit(1, &commands);
+
+            mResults.clear();
+            nxtCallbackUserdata userdata =
+                static_cast<nxtCallbackUserdata>(reinterpret_cast<uintptr_t>(this));
+            results.MapReadAsync(0, resultCount * sizeof(uint64_t), OnMapRead, userdata);
+            mResultCount = resultCount;
+            mTimeline->AdvanceTime(1000000);
+            mDevice.Tick();
+            EXPECT_EQ(mResults.size(), resultCount);
+            return mResults;
+        }
+
+        static void OnMapRead(nxtBufferMapReadStatus status,
+                              const void* data,
+                              nxtCallbackUserdata userdata) {
+            ASSERT_EQ(status, NXT_BUFFER_MAP_READ_STATUS_SUCCESS);
+            auto* self = reinterpret_cast<QuerySetTests*>(static_cast<uintptr_t>(userdata));
+            self->mResults.resize(self->mResultCount);
+            memcpy(self->mResults.data(), data, self->mResultCount * sizeof(uint64_t));
+        }
+
+        nxt::Device mDevice;
+        nxt::Queue mQueue;
+        DeviceTimeline* mTimeline = nullptr;
+        nxt::Buffer mSource;
+        nxt::Buffer mDestination;
+        std::vector<uint64_t> mResults;
+        uint32_t mResultCount = 0;
+};
+
+constexpr uint64_t QuerySetTests::kSubmitCost;
+constexpr uint64_t QuerySetTests::kCopyCost;
+
+// Test timestamps written between passes are the simulated time at which the GPU reaches them
+TEST_F(QuerySetTests, TimestampsFollowTheTimeline) {
+    nxt::QuerySet querySet =
+        mDevice.CreateQuerySetBuilder().SetType(nxt::QueryType::Timestamp).SetCount(3).GetResult();
+
+    nxt::CommandBufferBuilder builder = mDevice.CreateCommandBufferBuilder();
+    builder.WriteTimestamp(querySet, 0);
+    AddCopies(&builder, 1);
+    builder.WriteTimestamp(querySet, 1);
+    AddCopies(&builder, 2);
+    builder.WriteTimestamp(querySet, 2);
+
+    std::vector<uint64_t> timestamps = ResolveAndRead(std::move(builder), querySet, 3);
+    ASSERT_EQ(timestamps[0], 0u);
+    ASSERT_EQ(timestamps[1], kCopyCost);
+    ASSERT_EQ(timestamps[2], 3 * kCopyCost);
+}
+
+// Test the timestamps of a submit start when the engine is done with the previous submits
+TEST_F(QuerySetTests, TimestampsAfterPreviousSubmits) {
+    nxt::QuerySet querySet =
+        mDevice.CreateQuerySetBuilder().SetType(nxt::QueryType::Timestamp).SetCount(1).GetResult();
+
+    nxt::CommandBufferBuilder first = mDevice.CreateCommandBufferBuilder();
+    AddCopies(&first, 2);
+    nxt::CommandBuffer commands = first.GetResult();
+    mQueue.Submit(1, &commands);
+    mQueue.Flush();
+
+    nxt::CommandBufferBuilder builder = mDevice.CreateCommandBufferBuilder();
+    builder.WriteTimestamp(querySet, 0);
+    std::vector<uint64_t> timestamps = ResolveAndRead(std::move(builder), querySet, 1);
+    ASSERT_EQ(timestamps[0], kSubmitCost + 2 * kCopyCost);
+}
+
+// Test pipeline statistics queries only count the work between their begin and end
+TEST_F(QuerySetTests, PipelineStatisticsOfEmptyPasses) {
+    nxt::QuerySet querySet = mDevice.CreateQuerySetBuilder()
+                                 .SetType(nxt::QueryType::PipelineStatistics)
+                                 .SetCount(1)
+                                 .SetPipelineStatistics(
+                                     nxt::PipelineStatisticBit::Vertices |
+                                     nxt::PipelineStatisticBit::ComputeShaderInvocations)
+                                 .GetResult();
+
+    nxt::CommandBufferBuilder builder = mDevice.CreateCommandBufferBuilder();
+    builder.BeginPipelineStatisticsQuery(querySet, 0)
+        .BeginComputePass()
+        .EndComputePass()
+        .EndPipelineStatisticsQuery();
+    std::vector<uint64_t> statistics = ResolveAndRead(std::move(builder), querySet, 1, 2);
+    ASSERT_EQ(statistics[0], 0u);
+    ASSERT_EQ(statistics[1], 0u);
+}
+
+// Test the pass timings utility pairs passes with their boundary timestamps and formats them
+TEST_F(QuerySetTests, PassTimings) {
+    nxt::QuerySet querySet =
+        mDevice.CreateQuerySetBuilder().SetType(nxt::QueryType::Timestamp).SetCount(3).GetResult();
+
+    nxt::CommandBufferBuilder builder = mDevice.CreateCommandBufferBuilder();
+    builder.WriteTimestamp(querySet, 0);
+    AddCopies(&builder, 1);
+    builder.WriteTimestamp(querySet, 1);
+    AddCopies(&builder, 3);
+    builder.WriteTimestamp(querySet, 2);
+    std::vector<uint64_t> timestamps = ResolveAndRead(std::move(builder), querySet, 3);
+
+    std::vector<utils::PassTiming> timings =
+        utils::GetPassTimings({"upload", "postprocess"}, timestamps.data());
+    ASSERT_EQ(timings.size(), 2u);
+    ASSERT_EQ(timings[0].name, "upload");
+    ASSERT_EQ(timings[0].end - timings[0].start, kCopyCost);
+    ASSERT_EQ(timings[1].name, "postprocess");
+    ASSERT_EQ(timings[1].end - timings[1].start, 3 * kCopyCost);
+
+    ASSERT_EQ(utils::FormatPassTimings(timings, 10.0),
+              "Pass           Time (us)   Share\n"
+              "upload             1.000   25.0%\n"
+              "postprocess        3.000   75.0%\n"
+              "Total              4.000  100.0%\n");
+}
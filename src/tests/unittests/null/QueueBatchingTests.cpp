@@ -0,0 +1,149 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "backend/Queue.h"
+#include "backend/null/NullBackend.h"
+
+using namespace backend::null;
+
+class QueueBatchingTests : public testing::Test {
+    protected:
+        void SetUp() override {
+            nxtProcTable procs;
+            nxtDevice device;
+            Init(&procs, &device, TimelineDescriptor());
+            nxtSetProcs(&procs);
+            mDevice = nxt::Device::Acquire(device);
+            mQueue = CreateQueue(nxt::QueueType::Graphics);
+            mTimeline = reinterpret_cast<Device*>(device)->GetTimeline();
+        }
+
+        void TearDown() override {
+            mQueue = nxt::Queue();
+            mDevice = nxt::Device();
+            nxtSetProcs(nullptr);
+        }
+
+        nxt::Queue CreateQueue(nxt::QueueType type) {
+            return mDevice.CreateQueueBuilder().SetType(type).GetResult();
+        }
+
+        nxt::Buffer CreateBuffer() {
+            return mDevice.CreateBufferBuilder()
+                .SetAllowedUsage(nxt::BufferUsageBit::TransferDst | nxt::BufferUsageBit::Vertex)
+                .SetInitialUsage(nxt::BufferUsageBit::Vertex)
+                .SetSize(4)
+                .GetResult();
+        }
+
+        nxt::CommandBuffer TransitionBuffer(const nxt::Buffer& buffer, nxt::BufferUsageBit usage) {
+            return mDevice.CreateCommandBufferBuilder()
+                .TransitionBufferUsage(buffer, usage)
+                .GetResult();
+        }
+
+        // Each backend submit takes a serial.
+        Serial GetBackendSubmitCount() const {
+            return mTimeline->GetLastSubmittedSerial();
+        }
+
+        nxt::Device mDevice;
+        nxt::Queue mQueue;
+        DeviceTimeline* mTimeline = nullptr;
+};
+
+// Test submits are batched until the queue is flushed, into a single backend submit
+TEST_F(QueueBatchingTests, SubmitsBatchedUntilFlush) {
+    nxt::CommandBuffer commands = mDevice.CreateCommandBufferBuilder().GetResult();
+    mQueue.Submit(1, &commands);
+    mQueue.Submit(1, &commands);
+    mQueue.Submit(0, nullptr);
+    ASSERT_EQ(GetBackendSubmitCount(), 0u);
+
+    mQueue.Flush();
+    ASSERT_EQ(GetBackendSubmitCount(), 1u);
+
+    // Flushing without batched submits does nothing.
+    mQueue.Flush();
+    ASSERT_EQ(GetBackendSubmitCount(), 1u);
+}
+
+// Test the batch is flushed once it has the maximum number of command buffers
+TEST_F(QueueBatchingTests, FlushWhenBatchIsFull) {
+    nxt::CommandBuffer commands = mDevice.CreateCommandBufferBuilder().GetResult();
+    for (uint32_t i = 0; i < backend::kMaxBatchedCommandBuffers - 1; ++i) {
+        mQueue.Submit(1, &commands);
+    }
+    ASSERT_EQ(GetBackendSubmitCount(), 0u);
+
+    mQueue.Submit(1, &commands);
+    ASSERT_EQ(GetBackendSubmitCount(), 1u);
+}
+
+// Test the operations that depend on the submitted commands flush them first
+TEST_F(QueueBatchingTests, ImplicitFlushes) {
+    nxt::Buffer buffer = CreateBuffer();
+    nxt::Fence fence = mDevice.CreateFenceBuilder().GetResult();
+
+    // The buffer must be in the transfer dst usage set by the batched command buffer.
+    nxt::CommandBuffer toTransferDst = TransitionBuffer(buffer, nxt::BufferUsageBit::TransferDst);
+    mQueue.Submit(1, &toTransferDst);
+    uint32_t data = 0;
+    buffer.SetSubData(0, 1, &data);
+    ASSERT_EQ(GetBackendSubmitCount(), 1u);
+
+    mQueue.Submit(0, nullptr);
+    buffer.TransitionUsage(nxt::BufferUsageBit::Vertex);
+    ASSERT_EQ(GetBackendSubmitCount(), 2u);
+
+    mQueue.Submit(0, nullptr);
+    mQueue.Signal(fence, 1);
+    ASSERT_EQ(GetBackendSubmitCount(), 3u);
+
+    mQueue.Submit(0, nullptr);
+    mDevice.Tick();
+    ASSERT_EQ(GetBackendSubmitCount(), 4u);
+}
+
+// Test batched command buffers of queues of the same type are executed in the order of their
+// submits
+TEST_F(QueueBatchingTests, OrderBetweenQueues) {
+    nxt::Queue other = CreateQueue(nxt::QueueType::Graphics);
+    nxt::Buffer buffer = CreateBuffer();
+
+    nxt::CommandBuffer toTransferDst = TransitionBuffer(buffer, nxt::BufferUsageBit::TransferDst);
+    nxt::CommandBuffer toVertex = TransitionBuffer(buffer, nxt::BufferUsageBit::Vertex);
+    mQueue.Submit(1, &toTransferDst);
+    other.Submit(1, &toVertex);
+    ASSERT_EQ(GetBackendSubmitCount(), 1u);
+
+    other.Flush();
+    ASSERT_EQ(GetBackendSubmitCount(), 2u);
+    ASSERT_EQ(reinterpret_cast<Buffer*>(buffer.Get())->GetUsage(), nxt::BufferUsageBit::Vertex);
+}
+
+// Test the command buffers batched by a queue are submitted after the queue is released
+TEST_F(QueueBatchingTests, ReleasedQueueIsFlushed) {
+    {
+        nxt::Queue queue = CreateQueue(nxt::QueueType::Graphics);
+        nxt::CommandBuffer commands = mDevice.CreateCommandBufferBuilder().GetResult();
+        queue.Submit(1, &commands);
+    }
+    ASSERT_EQ(GetBackendSubmitCount(), 0u);
+
+    mDevice.Tick();
+    ASSERT_EQ(GetBackendSubmitCount(), 1u);
+}
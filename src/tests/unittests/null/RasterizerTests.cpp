@@ -0,0 +1,537 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "backend/null/Rasterizer.h"
+#include "common/ThreadPool.h"
+#include "tests/unittests/null/SpirvModule.h"
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace backend::null;
+
+namespace {
+
+    enum : uint32_t {
+        kMain = 1,
+        kVoid,
+        kMainType,
+        kFloat,
+        kVec4,
+        kInputVec4Pointer,
+        kOutputVec4Pointer,
+        kInPosition,
+        kInColor,
+        kOutPosition,
+        kOutColor,
+        kEntry,
+        kPosition,
+        kColor,
+    };
+
+    void AddTypes(SpirvModule* module) {
+        module->Add(spv::OpTypeVoid, {kVoid});
+        module->Add(spv::OpTypeFunction, {kMainType, kVoid});
+        module->Add(spv::OpTypeFloat, {kFloat, 32});
+        module->Add(spv::OpTypeVector, {kVec4, kFloat, 4});
+        module->Add(spv::OpTypePointer, {kInputVec4Pointer, spv::StorageClassInput, kVec4});
+        module->Add(spv::OpTypePointer, {kOutputVec4Pointer, spv::StorageClassOutput, kVec4});
+    }
+
+    // A vertex shader passing its position at location 0 and color at location 1 through.
+    std::unique_ptr<ShaderProgram> CreateVertexShader() {
+        SpirvModule module;
+        module.Add(spv::OpCapability, {spv::CapabilityShader});
+        module.Add(spv::OpMemoryModel, {spv::AddressingModelLogical, spv::MemoryModelGLSL450});
+        module.AddWithString(spv::OpEntryPoint, {spv::ExecutionModelVertex, kMain}, "main",
+                             {kInPosition, kInColor, kOutPosition, kOutColor});
+        module.Add(spv::OpDecorate, {kInPosition, spv::DecorationLocation, 0});
+        module.Add(spv::OpDecorate, {kInColor, spv::DecorationLocation, 1});
+        module.Add(spv::OpDecorate, {kOutPosition, spv::DecorationBuiltIn, spv::BuiltInPosition});
+        module.Add(spv::OpDecorate, {kOutColor, spv::DecorationLocation, 0});
+        AddTypes(&module);
+        module.Add(spv::OpVariable, {kInputVec4Pointer, kInPosition, spv::StorageClassInput});
+        module.Add(spv::OpVariable, {kInputVec4Pointer, kInColor, spv::StorageClassInput});
+        module.Add(spv::OpVariable, {kOutputVec4Pointer, kOutPosition, spv::StorageClassOutput});
+        module.Add(spv::OpVariable, {kOutputVec4Pointer, kOutColor, spv::StorageClassOutput});
+
+        module.Add(spv::OpFunction, {kVoid, kMain, spv::FunctionControlMaskNone, kMainType});
+        module.Add(spv::OpLabel, {kEntry});
+        module.Add(spv::OpLoad, {kVec4, kPosition, kInPosition});
+        module.Add(spv::OpStore, {kOutPosition, kPosition});
+        module.Add(spv::OpLoad, {kVec4, kColor, kInColor});
+        module.Add(spv::OpStore, {kOutColor, kColor});
+        module.Add(spv::OpReturn, {});
+        module.Add(spv::OpFunctionEnd, {});
+
+        std::string error;
+        std::unique_ptr<ShaderProgram> program =
+            ShaderProgram::Create(module.GetWords(), nxt::ShaderStage::Vertex, "main", &error);
+        EXPECT_NE(program, nullptr) << error;
+        return program;
+    }
+
+    // A fragment shader writing its color input at location 0 to the output at location 0.
+    std::unique_ptr<ShaderProgram> CreateFragmentShader(bool flat) {
+        SpirvModule module;
+        module.Add(spv::OpCapability, {spv::CapabilityShader});
+        module.Add(spv::OpMemoryModel, {spv::AddressingModelLogical, spv::MemoryModelGLSL450});
+        module.AddWithString(spv::OpEntryPoint, {spv::ExecutionModelFragment, kMain}, "main",
+                             {kInColor, kOutColor});
+        module.Add(spv::OpExecutionMode, {kMain, spv::ExecutionModeOriginUpperLeft});
+        module.Add(spv::OpDecorate, {kInColor, spv::DecorationLocation, 0});
+        if (flat) {
+            module.Add(spv::OpDecorate, {kInColor, spv::DecorationFlat});
+        }
+        module.Add(spv::OpDecorate, {kOutColor, spv::DecorationLocation, 0});
+        AddTypes(&module);
+        module.Add(spv::OpVariable, {kInputVec4Pointer, kInColor, spv::StorageClassInput});
+        module.Add(spv::OpVariable, {kOutputVec4Pointer, kOutColor, spv::StorageClassOutput});
+
+        module.Add(spv::OpFunction, {kVoid, kMain, spv::FunctionControlMaskNone, kMainType});
+        module.Add(spv::OpLabel, {kEntry});
+        module.Add(spv::OpLoad, {kVec4, kColor, kInColor});
+        module.Add(spv::OpStore, {kOutColor, kColor});
+        module.Add(spv::OpReturn, {});
+        module.Add(spv::OpFunctionEnd, {});
+
+        std::string error;
+        std::unique_ptr<ShaderProgram> program =
+            ShaderProgram::Create(module.GetWords(), nxt::ShaderStage::Fragment, "main", &error);
+        EXPECT_NE(program, nullptr) << error;
+        return program;
+    }
+
+    struct Vertex {
+        float position[4];
+        float color[4];
+    };
+
+    Vertex MakeVertex(float x, float y, float z, float w, float r, float g, float b, float a) {
+        return {{x * w, y * w, z * w, w}, {r, g, b, a}};
+    }
+
+    class RasterizerTests : public testing::Test {
+      protected:
+        static constexpr uint32_t kWidth = 100;
+        static constexpr uint32_t kHeight = 70;
+
+        RasterizerTests()
+            : mPool(4),
+              mRasterizer(&mPool),
+              mVertexShader(CreateVertexShader()),
+              mFlatFragmentShader(CreateFragmentShader(true)),
+              mFragmentShader(CreateFragmentShader(false)),
+              mColor(kWidth * kHeight * 4),
+              mDepthStencil(kWidth * kHeight * 8) {
+            RenderTargets targets;
+            targets.width = kWidth;
+            targets.height = kHeight;
+            targets.colors[0].data = mColor.data();
+            targets.colors[0].rowPitch = kWidth * 4;
+            targets.colors[0].format = nxt::TextureFormat::R8G8B8A8Unorm;
+            targets.depthStencil.data = mDepthStencil.data();
+            targets.depthStencil.rowPitch = kWidth * 8;
+            targets.depthStencil.format = nxt::TextureFormat::D32FloatS8Uint;
+            mRasterizer.SetRenderTargets(targets);
+            mRasterizer.ClearColor(0, {{0.0f, 0.0f, 0.0f, 0.0f}});
+            mRasterizer.ClearDepthStencil(true, 1.0f, true, 0);
+        }
+
+        RasterizerPipeline MakePipeline(nxt::PrimitiveTopology topology) {
+            RasterizerPipeline pipeline;
+            pipeline.vertex = mVertexShader.get();
+            pipeline.fragment = mFragmentShader.get();
+            pipeline.topology = topology;
+            pipeline.attributesSet.set(0);
+            pipeline.attributesSet.set(1);
+            pipeline.attributes[0] = {0, nxt::VertexFormat::FloatR32G32B32A32, 0};
+            pipeline.attributes[1] = {0, nxt::VertexFormat::FloatR32G32B32A32, 16};
+            pipeline.inputs[0] = {sizeof(Vertex), nxt::InputStepMode::Vertex};
+            return pipeline;
+        }
+
+        DrawStatistics Draw(const RasterizerPipeline& pipeline,
+                            const std::vector<Vertex>& vertices,
+                            uint32_t stencilReference = 0) {
+            DrawBindings bindings = MakeBindings(vertices);
+            bindings.stencilReference = stencilReference;
+            DrawCall draw;
+            draw.count = static_cast<uint32_t>(vertices.size());
+            return mRasterizer.Draw(pipeline, bindings, draw);
+        }
+
+        DrawBindings MakeBindings(const std::vector<Vertex>& vertices) {
+            DrawBindings bindings;
+            bindings.vertex = &mShaderBindings;
+            bindings.fragment = &mShaderBindings;
+            bindings.vertexBuffers[0].data = reinterpret_cast<const uint8_t*>(vertices.data());
+            bindings.vertexBuffers[0].size =
+                static_cast<uint32_t>(vertices.size() * sizeof(Vertex));
+            return bindings;
+        }
+
+        // The two triangles of a quad covering [x0, x1] x [y0, y1] in normalized device
+        // coordinates.
+        static std::vector<Vertex> Quad(float x0, float y0, float x1, float y1, float z,
+                                        const std::array<float, 4>& color) {
+            std::vector<Vertex> vertices;
+            for (auto corner : {std::make_pair(x0, y0), std::make_pair(x1, y0),
+                                std::make_pair(x0, y1), std::make_pair(x0, y1),
+                                std::make_pair(x1, y0), std::make_pair(x1, y1)}) {
+                vertices.push_back(MakeVertex(corner.first, corner.second, z, 1.0f, color[0],
+                                              color[1], color[2], color[3]));
+            }
+            return vertices;
+        }
+
+        const uint8_t* Texel(uint32_t x, uint32_t y) const {
+            return &mColor[(y * kWidth + x) * 4];
+        }
+        float Depth(uint32_t x, uint32_t y) const {
+            float depth;
+            memcpy(&depth, &mDepthStencil[(y * kWidth + x) * 8], sizeof(depth));
+            return depth;
+        }
+        uint8_t Stencil(uint32_t x, uint32_t y) const {
+            return mDepthStencil[(y * kWidth + x) * 8 + 4];
+        }
+
+        ThreadPool mPool;
+        Rasterizer mRasterizer;
+        std::unique_ptr<ShaderProgram> mVertexShader;
+        std::unique_ptr<ShaderProgram> mFlatFragmentShader;
+        std::unique_ptr<ShaderProgram> mFragmentShader;
+        std::array<uint32_t, kMaxPushConstants> mPushConstants = {};
+        ShaderBindings mShaderBindings;
+        std::vector<uint8_t> mColor;
+        std::vector<uint8_t> mDepthStencil;
+
+      private:
+        void SetUp() override {
+            ASSERT_NE(mVertexShader, nullptr);
+            ASSERT_NE(mFragmentShader, nullptr);
+            ASSERT_NE(mFlatFragmentShader, nullptr);
+            mShaderBindings.pushConstants = mPushConstants.data();
+        }
+    };
+
+    constexpr uint32_t RasterizerTests::kWidth;
+    constexpr uint32_t RasterizerTests::kHeight;
+
+}  // anonymous namespace
+
+// Test a mesh of triangles with shared edges in arbitrary positions, spanning several tiles,
+// covers each pixel exactly once, using additive blending to count the coverage.
+TEST_F(RasterizerTests, MeshCoversEachPixelOnce) {
+    RasterizerPipeline pipeline = MakePipeline(nxt::PrimitiveTopology::TriangleList);
+    pipeline.blends[0].blendEnabled = true;
+    pipeline.blends[0].colorBlend = {nxt::BlendOperation::Add, nxt::BlendFactor::One,
+                                     nxt::BlendFactor::One};
+    pipeline.blends[0].alphaBlend = pipeline.blends[0].colorBlend;
+
+    // A grid whose inner vertices are moved off the pixel grid, and whose outer vertices are
+    // outside of the render target.
+    constexpr uint32_t kColumns = 7;
+    constexpr uint32_t kRows = 5;
+    std::array<std::array<std::pair<float, float>, kColumns + 1>, kRows + 1> grid;
+    for (uint32_t row = 0; row <= kRows; ++row) {
+        for (uint32_t column = 0; column <= kColumns; ++column) {
+            float x = -1.3f + 2.6f * column / kColumns;
+            float y = -1.2f + 2.4f * row / kRows;
+            if (row != 0 && row != kRows && column != 0 && column != kColumns) {
+                x += 0.07f * std::sin(static_cast<float>(row * 3 + column));
+                y += 0.05f * std::cos(static_cast<float>(row + column * 5));
+            }
+            grid[row][column] = std::make_pair(x, y);
+        }
+    }
+
+    std::vector<Vertex> vertices;
+    for (uint32_t row = 0; row < kRows; ++row) {
+        for (uint32_t column = 0; column < kColumns; ++column) {
+            auto a = grid[row][column];
+            auto b = grid[row][column + 1];
+            auto c = grid[row + 1][column];
+            auto d = grid[row + 1][column + 1];
+            // Alternate the diagonal and the winding of the triangles.
+            std::array<std::pair<float, float>, 6> corners = {{a, b, d, a, d, c}};
+            if ((row + column) % 2 == 1) {
+                corners = {{a, c, b, b, c, d}};
+            }
+            for (auto corner : corners) {
+                vertices.push_back(
+                    MakeVertex(corner.first, corner.second, 0.5f, 1.0f, 0.2f, 0.0f, 0.0f, 0.2f));
+            }
+        }
+    }
+    Draw(pipeline, vertices);
+
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            ASSERT_EQ(Texel(x, y)[0], 51u) << "pixel " << x << ", " << y;
+        }
+    }
+}
+
+// Test the inputs of the fragment shader are interpolated with perspective correction.
+TEST_F(RasterizerTests, PerspectiveCorrectInterpolation) {
+    RasterizerPipeline pipeline = MakePipeline(nxt::PrimitiveTopology::TriangleList);
+
+    // The left edge has a w of 1 and the right edge a w of 3.
+    std::vector<Vertex> vertices = {
+        MakeVertex(-1.0f, -1.0f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+        MakeVertex(1.0f, -1.0f, 0.5f, 3.0f, 1.0f, 0.0f, 0.0f, 1.0f),
+        MakeVertex(-1.0f, 1.0f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+        MakeVertex(-1.0f, 1.0f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+        MakeVertex(1.0f, -1.0f, 0.5f, 3.0f, 1.0f, 0.0f, 0.0f, 1.0f),
+        MakeVertex(1.0f, 1.0f, 0.5f, 3.0f, 1.0f, 0.0f, 0.0f, 1.0f),
+    };
+    Draw(pipeline, vertices);
+
+    for (uint32_t x = 0; x < kWidth; ++x) {
+        float s = (x + 0.5f) / kWidth;
+        float expected = (s / 3.0f) / ((1.0f - s) + s / 3.0f);
+        ASSERT_NEAR(Texel(x, kHeight / 2)[0], expected * 255.0f, 1.0f) << "pixel " << x;
+    }
+}
+
+// Test flat inputs take the value of the first vertex of each primitive.
+TEST_F(RasterizerTests, FlatInterpolation) {
+    RasterizerPipeline pipeline = MakePipeline(nxt::PrimitiveTopology::TriangleList);
+    pipeline.fragment = mFlatFragmentShader.get();
+
+    std::vector<Vertex> vertices = {
+        MakeVertex(-1.0f, -1.0f, 0.5f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f),
+        MakeVertex(3.0f, -1.0f, 0.5f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f),
+        MakeVertex(-1.0f, 3.0f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f),
+    };
+    Draw(pipeline, vertices);
+
+    for (uint32_t y = 0; y < kHeight; y += 7) {
+        for (uint32_t x = 0; x < kWidth; x += 7) {
+            ASSERT_EQ(Texel(x, y)[0], 0u);
+            ASSERT_EQ(Texel(x, y)[1], 255u);
+            ASSERT_EQ(Texel(x, y)[2], 0u);
+        }
+    }
+}
+
+// Test the depth test keeps the closest fragments and writes their depth.
+TEST_F(RasterizerTests, DepthTest) {
+    RasterizerPipeline pipeline = MakePipeline(nxt::PrimitiveTopology::TriangleList);
+    pipeline.depth.compareFunction = nxt::CompareFunction::Less;
+    pipeline.depth.depthWriteEnabled = true;
+
+    Draw(pipeline, Quad(-1.0f, -1.0f, 1.0f, 1.0f, 0.5f, {{0.0f, 1.0f, 0.0f, 1.0f}}));
+    Draw(pipeline, Quad(-1.0f, -1.0f, 1.0f, 1.0f, 0.7f, {{1.0f, 0.0f, 0.0f, 1.0f}}));
+    Draw(pipeline, Quad(-1.0f, -1.0f, 0.0f, 1.0f, 0.3f, {{0.0f, 0.0f, 1.0f, 1.0f}}));
+
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            bool left = x < kWidth / 2;
+            ASSERT_EQ(Texel(x, y)[0], 0u);
+            ASSERT_EQ(Texel(x, y)[1], left ? 0u : 255u);
+            ASSERT_EQ(Texel(x, y)[2], left ? 255u : 0u);
+            ASSERT_FLOAT_EQ(Depth(x, y), left ? 0.3f : 0.5f);
+        }
+    }
+}
+
+// Test the statistics of draws count the primitives and the fragments that pass the early tests.
+TEST_F(RasterizerTests, DrawStatistics) {
+    RasterizerPipeline pipeline = MakePipeline(nxt::PrimitiveTopology::TriangleList);
+    pipeline.depth.compareFunction = nxt::CompareFunction::Less;
+    pipeline.depth.depthWriteEnabled = true;
+
+    DrawStatistics statistics =
+        Draw(pipeline, Quad(-1.0f, -1.0f, 1.0f, 1.0f, 0.5f, {{0.0f, 1.0f, 0.0f, 1.0f}}));
+    ASSERT_EQ(statistics.primitives, 2u);
+    ASSERT_EQ(statistics.fragmentInvocations, kWidth * kHeight);
+
+    statistics = Draw(pipeline, Quad(-1.0f, -1.0f, 1.0f, 1.0f, 0.7f, {{1.0f, 0.0f, 0.0f, 1.0f}}));
+    ASSERT_EQ(statistics.primitives, 2u);
+    ASSERT_EQ(statistics.fragmentInvocations, 0u);
+
+    statistics = Draw(pipeline, Quad(-1.0f, -1.0f, 0.0f, 1.0f, 0.3f, {{0.0f, 0.0f, 1.0f, 1.0f}}));
+    ASSERT_EQ(statistics.primitives, 2u);
+    ASSERT_EQ(statistics.fragmentInvocations, kWidth * kHeight / 2);
+}
+
+// Test writing the stencil with a draw then using it to mask another draw.
+TEST_F(RasterizerTests, StencilTest) {
+    RasterizerPipeline writePipeline = MakePipeline(nxt::PrimitiveTopology::TriangleList);
+    writePipeline.blends[0].colorWriteMask = nxt::ColorWriteMask::None;
+    writePipeline.stencil.front.depthStencilPass = nxt::StencilOperation::Replace;
+    writePipeline.stencil.back.depthStencilPass = nxt::StencilOperation::Replace;
+    Draw(writePipeline, Quad(-1.0f, -1.0f, 0.0f, 1.0f, 0.5f, {{1.0f, 1.0f, 1.0f, 1.0f}}), 3);
+
+    RasterizerPipeline testPipeline = MakePipeline(nxt::PrimitiveTopology::TriangleList);
+    testPipeline.stencil.front.compareFunction = nxt::CompareFunction::Equal;
+    testPipeline.stencil.back.compareFunction = nxt::CompareFunction::Equal;
+    testPipeline.stencil.front.stencilFail = nxt::StencilOperation::IncrementClamp;
+    testPipeline.stencil.back.stencilFail = nxt::StencilOperation::IncrementClamp;
+    Draw(testPipeline, Quad(-1.0f, -1.0f, 1.0f, 1.0f, 0.5f, {{1.0f, 0.0f, 0.0f, 1.0f}}), 3);
+
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            bool left = x < kWidth / 2;
+            ASSERT_EQ(Texel(x, y)[0], left ? 255u : 0u);
+            ASSERT_EQ(Stencil(x, y), left ? 3u : 1u);
+        }
+    }
+}
+
+// Test alpha blending, the blend color and the swizzle of BGRA render targets.
+TEST_F(RasterizerTests, Blending) {
+    std::vector<uint8_t> bgra(kWidth * kHeight * 4);
+    RenderTargets targets;
+    targets.width = kWidth;
+    targets.height = kHeight;
+    targets.colors[0] = {bgra.data(), kWidth * 4, nxt::TextureFormat::B8G8R8A8Unorm};
+    mRasterizer.SetRenderTargets(targets);
+    mRasterizer.ClearColor(0, {{0.0f, 0.0f, 1.0f, 1.0f}});
+
+    RasterizerPipeline pipeline = MakePipeline(nxt::PrimitiveTopology::TriangleList);
+    pipeline.blends[0].blendEnabled = true;
+    pipeline.blends[0].colorBlend = {nxt::BlendOperation::Add, nxt::BlendFactor::SrcAlpha,
+                                     nxt::BlendFactor::OneMinusSrcAlpha};
+    pipeline.blends[0].alphaBlend = {nxt::BlendOperation::Add, nxt::BlendFactor::BlendColor,
+                                     nxt::BlendFactor::Zero};
+
+    std::vector<Vertex> vertices =
+        Quad(-1.0f, -1.0f, 1.0f, 1.0f, 0.5f, {{1.0f, 0.0f, 0.0f, 0.25f}});
+    DrawBindings bindings = MakeBindings(vertices);
+    bindings.blendColor = {{0.0f, 0.0f, 0.0f, 0.5f}};
+    DrawCall draw;
+    draw.count = static_cast<uint32_t>(vertices.size());
+    mRasterizer.Draw(pipeline, bindings, draw);
+
+    // B, G, R, A
+    const uint8_t* texel = &bgra[(10 * kWidth + 10) * 4];
+    ASSERT_EQ(texel[0], 191u);
+    ASSERT_EQ(texel[1], 0u);
+    ASSERT_EQ(texel[2], 64u);
+    ASSERT_EQ(texel[3], 32u);
+}
+
+// Test indexed draws with 16-bit indices, and instanced draws with per-instance attributes.
+TEST_F(RasterizerTests, IndexedInstancedDraw) {
+    RasterizerPipeline pipeline = MakePipeline(nxt::PrimitiveTopology::TriangleList);
+    pipeline.indexFormat = nxt::IndexFormat::Uint16;
+    pipeline.attributes[1] = {1, nxt::VertexFormat::FloatR32G32B32, 0};
+    pipeline.inputs[1] = {3 * sizeof(float), nxt::InputStepMode::Instance};
+    pipeline.blends[0].blendEnabled = true;
+    pipeline.blends[0].colorBlend = {nxt::BlendOperation::Add, nxt::BlendFactor::One,
+                                     nxt::BlendFactor::One};
+    pipeline.blends[0].alphaBlend = pipeline.blends[0].colorBlend;
+
+    std::vector<Vertex> vertices = {
+        MakeVertex(-1.0f, -1.0f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f),
+        MakeVertex(0.0f, -1.0f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f),
+        MakeVertex(-1.0f, 0.0f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f),
+        MakeVertex(0.0f, 0.0f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f),
+    };
+    std::vector<uint16_t> indices = {0, 1, 2, 2, 1, 3};
+    // Instance 0 isn't drawn, and the alpha of the three component format defaults to 1.
+    std::vector<float> colors = {0.0f, 0.0f, 1.0f, 0.2f, 0.0f, 0.0f, 0.0f, 0.4f, 0.0f};
+
+    DrawBindings bindings = MakeBindings(vertices);
+    bindings.vertexBuffers[1].data = reinterpret_cast<const uint8_t*>(colors.data());
+    bindings.vertexBuffers[1].size = static_cast<uint32_t>(colors.size() * sizeof(float));
+    bindings.indexBuffer.data = reinterpret_cast<const uint8_t*>(indices.data());
+    bindings.indexBuffer.size = static_cast<uint32_t>(indices.size() * sizeof(uint16_t));
+
+    DrawCall draw;
+    draw.indexed = true;
+    draw.count = 6;
+    draw.instanceCount = 2;
+    draw.firstInstance = 1;
+    mRasterizer.Draw(pipeline, bindings, draw);
+
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            bool inside = x < kWidth / 2 && y < kHeight / 2;
+            ASSERT_EQ(Texel(x, y)[0], inside ? 51u : 0u);
+            ASSERT_EQ(Texel(x, y)[1], inside ? 102u : 0u);
+            ASSERT_EQ(Texel(x, y)[2], 0u);
+            ASSERT_EQ(Texel(x, y)[3], inside ? 255u : 0u);
+        }
+    }
+}
+
+// Test triangles crossing the near plane are clipped to the part in front of it.
+TEST_F(RasterizerTests, NearPlaneClipping) {
+    RasterizerPipeline pipeline = MakePipeline(nxt::PrimitiveTopology::TriangleList);
+
+    // The depth goes from 0.5 on the first row to -1 on the last, crossing 0 at a third of the
+    // height.
+    std::vector<Vertex> vertices = {
+        MakeVertex(-1.0f, -1.0f, 0.5f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f),
+        MakeVertex(3.0f, -1.0f, 0.5f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f),
+        MakeVertex(-1.0f, 3.0f, -2.5f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f),
+    };
+    Draw(pipeline, vertices);
+
+    uint32_t clipRow = kHeight / 3;
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        if (y == clipRow) {
+            continue;
+        }
+        ASSERT_EQ(Texel(0, y)[0], y < clipRow ? 255u : 0u) << "row " << y;
+    }
+}
+
+// Test lines cover one pixel per column of their major axis and points a single pixel.
+TEST_F(RasterizerTests, LinesAndPoints) {
+    auto PixelCenter = [](uint32_t x, uint32_t y) {
+        return std::make_pair(2.0f * (x + 0.5f) / kWidth - 1.0f,
+                              2.0f * (y + 0.5f) / kHeight - 1.0f);
+    };
+
+    RasterizerPipeline lines = MakePipeline(nxt::PrimitiveTopology::LineStrip);
+    auto a = PixelCenter(10, 20);
+    auto b = PixelCenter(30, 20);
+    auto c = PixelCenter(30, 40);
+    Draw(lines, {MakeVertex(a.first, a.second, 0.5f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f),
+                 MakeVertex(b.first, b.second, 0.5f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f),
+                 MakeVertex(c.first, c.second, 0.5f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f)});
+
+    RasterizerPipeline points = MakePipeline(nxt::PrimitiveTopology::PointList);
+    auto p = PixelCenter(50, 60);
+    Draw(points, {MakeVertex(p.first, p.second, 0.5f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f),
+                  MakeVertex(2.0f, 0.0f, 0.5f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f)});
+
+    uint32_t redCount = 0;
+    uint32_t greenCount = 0;
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            redCount += Texel(x, y)[0] == 255u;
+            greenCount += Texel(x, y)[1] == 255u;
+        }
+    }
+    for (uint32_t x = 10; x < 30; ++x) {
+        ASSERT_EQ(Texel(x, 20)[0], 255u);
+    }
+    for (uint32_t y = 20; y < 40; ++y) {
+        ASSERT_EQ(Texel(30, y)[0], 255u);
+    }
+    ASSERT_EQ(redCount, 40u);
+    ASSERT_EQ(Texel(50, 60)[1], 255u);
+    ASSERT_EQ(greenCount, 1u);
+}
@@ -0,0 +1,428 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "backend/null/ShaderProgram.h"
+#include "common/ThreadPool.h"
+#include "tests/unittests/null/SpirvModule.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace backend::null;
+
+namespace {
+
+    // The ids of the declarations shared by all the test shaders.
+    enum : uint32_t {
+        kGlslImport = 1,
+        kMain,
+        kVoid,
+        kMainType,
+        kUint,
+        kInt,
+        kFloat,
+        kBool,
+        kUvec3,
+        kInputUvec3Pointer,
+        kInputUintPointer,
+        kGlobalId,
+        kLocalId,
+        kUintArray,
+        kBufferStruct,
+        kBufferPointer,
+        kBufferUintPointer,
+        kBuffer,
+        kUint0,
+        kUint1,
+        kInt0,
+        kFirstTestId,
+    };
+
+    // Adds the declarations shared by the test shaders: the built-in invocation ids and a buffer
+    // of uints at set 0, binding 0.
+    void AddCommonDeclarations(SpirvModule* module, uint32_t localSize) {
+        module->Add(spv::OpCapability, {spv::CapabilityShader});
+        module->AddWithString(spv::OpExtInstImport, {kGlslImport}, "GLSL.std.450", {});
+        module->Add(spv::OpMemoryModel, {spv::AddressingModelLogical, spv::MemoryModelGLSL450});
+        module->AddWithString(spv::OpEntryPoint, {spv::ExecutionModelGLCompute, kMain}, "main",
+                              {kGlobalId, kLocalId});
+        module->Add(spv::OpExecutionMode, {kMain, spv::ExecutionModeLocalSize, localSize, 1, 1});
+
+        module->Add(spv::OpDecorate,
+                    {kGlobalId, spv::DecorationBuiltIn, spv::BuiltInGlobalInvocationId});
+        module->Add(spv::OpDecorate,
+                    {kLocalId, spv::DecorationBuiltIn, spv::BuiltInLocalInvocationId});
+        module->Add(spv::OpDecorate, {kUintArray, spv::DecorationArrayStride, 4});
+        module->Add(spv::OpMemberDecorate, {kBufferStruct, 0, spv::DecorationOffset, 0});
+        module->Add(spv::OpDecorate, {kBufferStruct, spv::DecorationBufferBlock});
+        module->Add(spv::OpDecorate, {kBuffer, spv::DecorationDescriptorSet, 0});
+        module->Add(spv::OpDecorate, {kBuffer, spv::DecorationBinding, 0});
+
+        module->Add(spv::OpTypeVoid, {kVoid});
+        module->Add(spv::OpTypeFunction, {kMainType, kVoid});
+        module->Add(spv::OpTypeInt, {kUint, 32, 0});
+        module->Add(spv::OpTypeInt, {kInt, 32, 1});
+        module->Add(spv::OpTypeFloat, {kFloat, 32});
+        module->Add(spv::OpTypeBool, {kBool});
+        module->Add(spv::OpTypeVector, {kUvec3, kUint, 3});
+        module->Add(spv::OpTypePointer, {kInputUvec3Pointer, spv::StorageClassInput, kUvec3});
+        module->Add(spv::OpTypePointer, {kInputUintPointer, spv::StorageClassInput, kUint});
+        module->Add(spv::OpTypeRuntimeArray, {kUintArray, kUint});
+        module->Add(spv::OpTypeStruct, {kBufferStruct, kUintArray});
+        module->Add(spv::OpTypePointer, {kBufferPointer, spv::StorageClassUniform, kBufferStruct});
+        module->Add(spv::OpTypePointer, {kBufferUintPointer, spv::StorageClassUniform, kUint});
+
+        module->Add(spv::OpConstant, {kUint, kUint0, 0});
+        module->Add(spv::OpConstant, {kUint, kUint1, 1});
+        module->Add(spv::OpConstant, {kInt, kInt0, 0});
+
+        module->Add(spv::OpVariable, {kInputUvec3Pointer, kGlobalId, spv::StorageClassInput});
+        module->Add(spv::OpVariable, {kInputUvec3Pointer, kLocalId, spv::StorageClassInput});
+        module->Add(spv::OpVariable, {kBufferPointer, kBuffer, spv::StorageClassUniform});
+    }
+
+    // Loads the x component of a built-in id into result.
+    void LoadIdX(SpirvModule* module, uint32_t builtIn, uint32_t pointer, uint32_t result) {
+        module->Add(spv::OpAccessChain, {kInputUintPointer, pointer, builtIn, kUint0});
+        module->Add(spv::OpLoad, {kUint, result, pointer});
+    }
+
+    std::unique_ptr<ShaderProgram> CreateProgram(const SpirvModule& module) {
+        std::string error;
+        std::unique_ptr<ShaderProgram> program =
+            ShaderProgram::Create(module.GetWords(), nxt::ShaderStage::Compute, "main", &error);
+        EXPECT_NE(program, nullptr) << error;
+        return program;
+    }
+
+    // Returns whether the module can be run, and checks there is an error message otherwise.
+    bool Translates(const SpirvModule& module, nxt::ShaderStage stage, const char* entryPoint) {
+        std::string error;
+        bool translated =
+            ShaderProgram::Create(module.GetWords(), stage, entryPoint, &error) != nullptr;
+        EXPECT_EQ(translated, error.empty());
+        return translated;
+    }
+
+    void Dispatch(const ShaderProgram* program,
+                  std::vector<uint32_t>* buffer,
+                  uint32_t bufferSize,
+                  uint32_t workgroupCount,
+                  ThreadPool* pool) {
+        std::array<uint32_t, kMaxPushConstants> pushConstants = {};
+        ShaderBindings bindings;
+        bindings.buffers[0][0].data = reinterpret_cast<uint8_t*>(buffer->data());
+        bindings.buffers[0][0].size = bufferSize * sizeof(uint32_t);
+        bindings.pushConstants = pushConstants.data();
+        program->Dispatch(bindings, workgroupCount, 1, 1, pool);
+    }
+
+}  // anonymous namespace
+
+// Test buffer accesses indexed by the global invocation id, with a bounds check on the length of
+// the runtime array and float arithmetic.
+TEST(ShaderProgramTests, StorageBufferMultiplyAdd) {
+    enum : uint32_t {
+        kFloat2_5 = kFirstTestId,
+        kEntry,
+        kBody,
+        kEnd,
+        kIdPointer,
+        kId,
+        kLength,
+        kInRange,
+        kElement,
+        kValue,
+        kFloatValue,
+        kProduct,
+        kProductUint,
+        kResult,
+    };
+
+    SpirvModule module;
+    AddCommonDeclarations(&module, 4);
+    module.Add(spv::OpConstant, {kFloat, kFloat2_5, FloatBits(2.5f)});
+
+    module.Add(spv::OpFunction, {kVoid, kMain, spv::FunctionControlMaskNone, kMainType});
+    module.Add(spv::OpLabel, {kEntry});
+    LoadIdX(&module, kGlobalId, kIdPointer, kId);
+    module.Add(spv::OpArrayLength, {kUint, kLength, kBuffer, 0});
+    module.Add(spv::OpULessThan, {kBool, kInRange, kId, kLength});
+    module.Add(spv::OpSelectionMerge, {kEnd, spv::SelectionControlMaskNone});
+    module.Add(spv::OpBranchConditional, {kInRange, kBody, kEnd});
+
+    module.Add(spv::OpLabel, {kBody});
+    module.Add(spv::OpAccessChain, {kBufferUintPointer, kElement, kBuffer, kInt0, kId});
+    module.Add(spv::OpLoad, {kUint, kValue, kElement});
+    module.Add(spv::OpConvertUToF, {kFloat, kFloatValue, kValue});
+    module.Add(spv::OpFMul, {kFloat, kProduct, kFloatValue, kFloat2_5});
+    module.Add(spv::OpConvertFToU, {kUint, kProductUint, kProduct});
+    module.Add(spv::OpIAdd, {kUint, kResult, kProductUint, kUint1});
+    module.Add(spv::OpStore, {kElement, kResult});
+    module.Add(spv::OpBranch, {kEnd});
+
+    module.Add(spv::OpLabel, {kEnd});
+    module.Add(spv::OpReturn, {});
+    module.Add(spv::OpFunctionEnd, {});
+
+    std::unique_ptr<ShaderProgram> program = CreateProgram(module);
+    ASSERT_NE(program, nullptr);
+    ASSERT_EQ(program->GetLocalSize()[0], 4u);
+
+    // Only 30 elements are bound, the invocations past them must not touch the rest.
+    constexpr uint32_t kElementCount = 30;
+    std::vector<uint32_t> buffer(kElementCount + 2, 0xFFFFFFFF);
+    for (uint32_t i = 0; i < kElementCount; ++i) {
+        buffer[i] = 2 * i;
+    }
+
+    ThreadPool pool(4);
+    Dispatch(program.get(), &buffer, kElementCount, 8, &pool);
+
+    for (uint32_t i = 0; i < kElementCount; ++i) {
+        ASSERT_EQ(buffer[i], 5 * i + 1) << "element " << i;
+    }
+    ASSERT_EQ(buffer[kElementCount], 0xFFFFFFFF);
+    ASSERT_EQ(buffer[kElementCount + 1], 0xFFFFFFFF);
+}
+
+// Test a loop with phis in a function called by the entry point.
+TEST(ShaderProgramTests, LoopWithPhisInCalledFunction) {
+    enum : uint32_t {
+        kSum = kFirstTestId,
+        kSumType,
+        kN,
+        kEntry,
+        kIdPointer,
+        kId,
+        kCallResult,
+        kElement,
+        kSumEntry,
+        kHeader,
+        kBody,
+        kContinue,
+        kMerge,
+        kI,
+        kAccumulator,
+        kInRange,
+        kNextAccumulator,
+        kNextI,
+    };
+
+    SpirvModule module;
+    AddCommonDeclarations(&module, 4);
+    module.Add(spv::OpTypeFunction, {kSumType, kUint, kUint});
+
+    // The entry point is before the function it calls.
+    module.Add(spv::OpFunction, {kVoid, kMain, spv::FunctionControlMaskNone, kMainType});
+    module.Add(spv::OpLabel, {kEntry});
+    LoadIdX(&module, kGlobalId, kIdPointer, kId);
+    module.Add(spv::OpFunctionCall, {kUint, kCallResult, kSum, kId});
+    module.Add(spv::OpAccessChain, {kBufferUintPointer, kElement, kBuffer, kInt0, kId});
+    module.Add(spv::OpStore, {kElement, kCallResult});
+    module.Add(spv::OpReturn, {});
+    module.Add(spv::OpFunctionEnd, {});
+
+    // uint Sum(uint n) returns the sum of the integers in [0, n).
+    module.Add(spv::OpFunction, {kUint, kSum, spv::FunctionControlMaskNone, kSumType});
+    module.Add(spv::OpFunctionParameter, {kUint, kN});
+    module.Add(spv::OpLabel, {kSumEntry});
+    module.Add(spv::OpBranch, {kHeader});
+
+    module.Add(spv::OpLabel, {kHeader});
+    module.Add(spv::OpPhi, {kUint, kI, kUint0, kSumEntry, kNextI, kContinue});
+    module.Add(spv::OpPhi, {kUint, kAccumulator, kUint0, kSumEntry, kNextAccumulator, kContinue});
+    module.Add(spv::OpLoopMerge, {kMerge, kContinue, spv::LoopControlMaskNone});
+    module.Add(spv::OpULessThan, {kBool, kInRange, kI, kN});
+    module.Add(spv::OpBranchConditional, {kInRange, kBody, kMerge});
+
+    module.Add(spv::OpLabel, {kBody});
+    module.Add(spv::OpIAdd, {kUint, kNextAccumulator, kAccumulator, kI});
+    module.Add(spv::OpBranch, {kContinue});
+
+    module.Add(spv::OpLabel, {kContinue});
+    module.Add(spv::OpIAdd, {kUint, kNextI, kI, kUint1});
+    module.Add(spv::OpBranch, {kHeader});
+
+    module.Add(spv::OpLabel, {kMerge});
+    module.Add(spv::OpReturnValue, {kAccumulator});
+    module.Add(spv::OpFunctionEnd, {});
+
+    std::unique_ptr<ShaderProgram> program = CreateProgram(module);
+    ASSERT_NE(program, nullptr);
+
+    std::vector<uint32_t> buffer(16, 0xFFFFFFFF);
+    ThreadPool pool(2);
+    Dispatch(program.get(), &buffer, static_cast<uint32_t>(buffer.size()), 4, &pool);
+
+    for (uint32_t i = 0; i < buffer.size(); ++i) {
+        ASSERT_EQ(buffer[i], i * (i - 1) / 2) << "element " << i;
+    }
+}
+
+// Test invocations see the workgroup memory written by the other invocations of their workgroup
+// before a barrier.
+TEST(ShaderProgramTests, WorkgroupMemoryAndBarrier) {
+    enum : uint32_t {
+        kUint4 = kFirstTestId,
+        kSharedArray,
+        kSharedArrayPointer,
+        kSharedUintPointer,
+        kShared,
+        kEntry,
+        kLocalIdPointer,
+        kLocal,
+        kGlobalIdPointer,
+        kGlobal,
+        kSlot,
+        kValue,
+        kNext,
+        kNeighbor,
+        kNeighborSlot,
+        kNeighborValue,
+        kElement,
+    };
+
+    SpirvModule module;
+    AddCommonDeclarations(&module, 4);
+    module.Add(spv::OpConstant, {kUint, kUint4, 4});
+    module.Add(spv::OpTypeArray, {kSharedArray, kUint, kUint4});
+    module.Add(spv::OpTypePointer, {kSharedArrayPointer, spv::StorageClassWorkgroup, kSharedArray});
+    module.Add(spv::OpTypePointer, {kSharedUintPointer, spv::StorageClassWorkgroup, kUint});
+    module.Add(spv::OpVariable, {kSharedArrayPointer, kShared, spv::StorageClassWorkgroup});
+
+    module.Add(spv::OpFunction, {kVoid, kMain, spv::FunctionControlMaskNone, kMainType});
+    module.Add(spv::OpLabel, {kEntry});
+    LoadIdX(&module, kLocalId, kLocalIdPointer, kLocal);
+    LoadIdX(&module, kGlobalId, kGlobalIdPointer, kGlobal);
+
+    // shared[local] = global + 1
+    module.Add(spv::OpAccessChain, {kSharedUintPointer, kSlot, kShared, kLocal});
+    module.Add(spv::OpIAdd, {kUint, kValue, kGlobal, kUint1});
+    module.Add(spv::OpStore, {kSlot, kValue});
+
+    module.Add(spv::OpControlBarrier,
+               {spv::ScopeWorkgroup, spv::ScopeWorkgroup,
+                spv::MemorySemanticsAcquireReleaseMask | spv::MemorySemanticsWorkgroupMemoryMask});
+
+    // buffer[global] = shared[(local + 1) % 4]
+    module.Add(spv::OpIAdd, {kUint, kNext, kLocal, kUint1});
+    module.Add(spv::OpUMod, {kUint, kNeighbor, kNext, kUint4});
+    module.Add(spv::OpAccessChain, {kSharedUintPointer, kNeighborSlot, kShared, kNeighbor});
+    module.Add(spv::OpLoad, {kUint, kNeighborValue, kNeighborSlot});
+    module.Add(spv::OpAccessChain, {kBufferUintPointer, kElement, kBuffer, kInt0, kGlobal});
+    module.Add(spv::OpStore, {kElement, kNeighborValue});
+    module.Add(spv::OpReturn, {});
+    module.Add(spv::OpFunctionEnd, {});
+
+    std::unique_ptr<ShaderProgram> program = CreateProgram(module);
+    ASSERT_NE(program, nullptr);
+
+    std::vector<uint32_t> buffer(12, 0);
+    ThreadPool pool(3);
+    Dispatch(program.get(), &buffer, static_cast<uint32_t>(buffer.size()), 3, &pool);
+
+    for (uint32_t i = 0; i < buffer.size(); ++i) {
+        uint32_t local = i % 4;
+        uint32_t neighbor = i - local + (local + 1) % 4;
+        ASSERT_EQ(buffer[i], neighbor + 1) << "element " << i;
+    }
+}
+
+// Test atomics are atomic across the threads running workgroups.
+TEST(ShaderProgramTests, AtomicCounter) {
+    enum : uint32_t {
+        kEntry = kFirstTestId,
+        kIdPointer,
+        kId,
+        kCounter,
+        kOriginal,
+        kIndex,
+        kElement,
+        kScope,
+        kSemantics,
+    };
+
+    SpirvModule module;
+    AddCommonDeclarations(&module, 4);
+    module.Add(spv::OpConstant, {kUint, kScope, spv::ScopeDevice});
+    module.Add(spv::OpConstant, {kUint, kSemantics, spv::MemorySemanticsMaskNone});
+
+    // buffer[1 + atomicAdd(buffer[0], 1)] = id
+    module.Add(spv::OpFunction, {kVoid, kMain, spv::FunctionControlMaskNone, kMainType});
+    module.Add(spv::OpLabel, {kEntry});
+    LoadIdX(&module, kGlobalId, kIdPointer, kId);
+    module.Add(spv::OpAccessChain, {kBufferUintPointer, kCounter, kBuffer, kInt0, kUint0});
+    module.Add(spv::OpAtomicIIncrement, {kUint, kOriginal, kCounter, kScope, kSemantics});
+    module.Add(spv::OpIAdd, {kUint, kIndex, kOriginal, kUint1});
+    module.Add(spv::OpAccessChain, {kBufferUintPointer, kElement, kBuffer, kInt0, kIndex});
+    module.Add(spv::OpStore, {kElement, kId});
+    module.Add(spv::OpReturn, {});
+    module.Add(spv::OpFunctionEnd, {});
+
+    std::unique_ptr<ShaderProgram> program = CreateProgram(module);
+    ASSERT_NE(program, nullptr);
+
+    constexpr uint32_t kWorkgroupCount = 64;
+    constexpr uint32_t kInvocationCount = kWorkgroupCount * 4;
+    std::vector<uint32_t> buffer(1 + kInvocationCount, 0);
+    ThreadPool pool(4);
+    Dispatch(program.get(), &buffer, static_cast<uint32_t>(buffer.size()), kWorkgroupCount,
+             &pool);
+
+    // Each invocation got a different counter value so all the ids are written once.
+    ASSERT_EQ(buffer[0], kInvocationCount);
+    std::vector<uint32_t> ids(buffer.begin() + 1, buffer.end());
+    std::sort(ids.begin(), ids.end());
+    for (uint32_t i = 0; i < kInvocationCount; ++i) {
+        ASSERT_EQ(ids[i], i);
+    }
+}
+
+// Test modules that can't be run fail to translate with an error.
+TEST(ShaderProgramTests, UnsupportedModules) {
+    enum : uint32_t {
+        kImage = kFirstTestId,
+        kImagePointer,
+        kImageVariable,
+        kEntry,
+    };
+
+    SpirvModule module;
+    AddCommonDeclarations(&module, 1);
+    module.Add(spv::OpTypeImage, {kImage, kFloat, spv::Dim2D, 0, 0, 0, 1, spv::ImageFormatUnknown});
+    module.Add(spv::OpTypePointer, {kImagePointer, spv::StorageClassUniformConstant, kImage});
+    module.Add(spv::OpVariable, {kImagePointer, kImageVariable, spv::StorageClassUniformConstant});
+    module.Add(spv::OpFunction, {kVoid, kMain, spv::FunctionControlMaskNone, kMainType});
+    module.Add(spv::OpLabel, {kEntry});
+    module.Add(spv::OpReturn, {});
+    module.Add(spv::OpFunctionEnd, {});
+
+    ASSERT_FALSE(Translates(module, nxt::ShaderStage::Compute, "main"));
+    ASSERT_FALSE(Translates(SpirvModule(), nxt::ShaderStage::Compute, "main"));
+
+    // A valid module without the requested entry point, or with the entry point for another
+    // stage.
+    SpirvModule valid;
+    AddCommonDeclarations(&valid, 1);
+    valid.Add(spv::OpFunction, {kVoid, kMain, spv::FunctionControlMaskNone, kMainType});
+    valid.Add(spv::OpLabel, {kEntry});
+    valid.Add(spv::OpReturn, {});
+    valid.Add(spv::OpFunctionEnd, {});
+    ASSERT_TRUE(Translates(valid, nxt::ShaderStage::Compute, "main"));
+    ASSERT_FALSE(Translates(valid, nxt::ShaderStage::Compute, "other"));
+    ASSERT_FALSE(Translates(valid, nxt::ShaderStage::Vertex, "main"));
+}
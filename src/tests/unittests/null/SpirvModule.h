@@ -0,0 +1,68 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TESTS_UNITTESTS_NULL_SPIRVMODULE_H_
+#define TESTS_UNITTESTS_NULL_SPIRVMODULE_H_
+
+#include <spirv-cross/spirv.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+// Assembles SPIR-V one instruction at a time, for the tests of the CPU shader execution of the
+// null backend that can't depend on a GLSL compiler.
+class SpirvModule {
+  public:
+    explicit SpirvModule(uint32_t bound = 100)
+        : mWords({spv::MagicNumber, 0x00010000, 0, bound, 0}) {
+    }
+
+    void Add(spv::Op op, std::initializer_list<uint32_t> operands) {
+        AddWithString(op, operands, nullptr, {});
+    }
+
+    // Adds an instruction with a literal string between two lists of operands.
+    void AddWithString(spv::Op op,
+                       std::initializer_list<uint32_t> before,
+                       const char* string,
+                       std::initializer_list<uint32_t> after) {
+        std::vector<uint32_t> operands(before);
+        if (string != nullptr) {
+            std::vector<uint32_t> stringWords(strlen(string) / sizeof(uint32_t) + 1, 0);
+            memcpy(stringWords.data(), string, strlen(string));
+            operands.insert(operands.end(), stringWords.begin(), stringWords.end());
+        }
+        operands.insert(operands.end(), after);
+
+        mWords.push_back(static_cast<uint32_t>(operands.size() + 1) << spv::WordCountShift | op);
+        mWords.insert(mWords.end(), operands.begin(), operands.end());
+    }
+
+    const std::vector<uint32_t>& GetWords() const {
+        return mWords;
+    }
+
+  private:
+    std::vector<uint32_t> mWords;
+};
+
+inline uint32_t FloatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+#endif  // TESTS_UNITTESTS_NULL_SPIRVMODULE_H_
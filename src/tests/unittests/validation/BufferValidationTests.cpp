@@ -187,6 +187,7 @@ TEST_F(BufferValidationTest, MapReadSuccess) {
     EXPECT_CALL(*mockBufferMapReadCallback, Call(NXT_BUFFER_MAP_READ_STATUS_SUCCESS, Ne(nullptr), userdata))
         .Times(1);
     queue.Submit(0, nullptr);
+    queue.Flush();
 
     buf.Unmap();
 }
@@ -232,6 +233,7 @@ TEST_F(BufferValidationTest, MapReadAlreadyMapped) {
     ASSERT_DEVICE_ERROR(buf.MapReadAsync(0, 4, ToMockBufferMapReadCallback, userdata2));
 
     queue.Submit(0, nullptr);
+    queue.Flush();
 }
 
 // Test unmapping before having the result gives UNKNOWN
@@ -245,9 +247,10 @@ TEST_F(BufferValidationTest, MapReadUnmapBeforeResult) {
         .Times(1);
     buf.Unmap();
 
-    // Submitting the queue makes the null backend process map request, but the callback shouldn't
+    // Flushing a submit makes the null backend process map request, but the callback shouldn't
     // be called again
     queue.Submit(0, nullptr);
+    queue.Flush();
 }
 
 // Test destroying the buffer before having the result gives UNKNOWN
@@ -264,9 +267,10 @@ TEST_F(BufferValidationTest, DISABLED_MapReadDestroyBeforeResult) {
             .Times(1);
     }
 
-    // Submitting the queue makes the null backend process map request, but the callback shouldn't
+    // Flushing a submit makes the null backend process map request, but the callback shouldn't
     // be called again
     queue.Submit(0, nullptr);
+    queue.Flush();
 }
 
 // When a request is cancelled with Unmap it might still be in flight, test doing a new request
@@ -288,6 +292,7 @@ TEST_F(BufferValidationTest, MapReadUnmapBeforeResultThenMapAgain) {
     EXPECT_CALL(*mockBufferMapReadCallback, Call(NXT_BUFFER_MAP_READ_STATUS_SUCCESS, Ne(nullptr), userdata))
         .Times(1);
     queue.Submit(0, nullptr);
+    queue.Flush();
 }
 
 // Test the success case for Buffer::SetSubData
@@ -0,0 +1,109 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/unittests/validation/ValidationTest.h"
+
+#include <gmock/gmock.h>
+
+using namespace testing;
+
+class MockFenceOnCompletionCallback {
+    public:
+        MOCK_METHOD2(Call, void(nxtFenceCompletionStatus status, nxtCallbackUserdata userdata));
+};
+
+static MockFenceOnCompletionCallback* mockFenceOnCompletionCallback = nullptr;
+static void ToMockFenceOnCompletionCallback(nxtFenceCompletionStatus status, nxtCallbackUserdata userdata) {
+    mockFenceOnCompletionCallback->Call(status, userdata);
+}
+
+class FenceValidationTest : public ValidationTest {
+    protected:
+        nxt::Fence CreateFence() {
+            return AssertWillBeSuccess(device.CreateFenceBuilder()).GetResult();
+        }
+
+        nxt::Queue queue;
+
+    private:
+        void SetUp() override {
+            ValidationTest::SetUp();
+
+            mockFenceOnCompletionCallback = new MockFenceOnCompletionCallback;
+            queue = device.CreateQueueBuilder().GetResult();
+        }
+
+        void TearDown() override {
+            delete mockFenceOnCompletionCallback;
+
+            ValidationTest::TearDown();
+        }
+};
+
+// Test the creation of a fence, it starts with a completed value of 0
+TEST_F(FenceValidationTest, Creation) {
+    nxt::Fence fence = CreateFence();
+    ASSERT_EQ(fence.GetCompletedValue(), 0u);
+}
+
+// Test signaling a fence must be done with increasing values
+TEST_F(FenceValidationTest, SignalIncreasingValues) {
+    nxt::Fence fence = CreateFence();
+
+    queue.Signal(fence, 1);
+    queue.Signal(fence, 3);
+    ASSERT_DEVICE_ERROR(queue.Signal(fence, 3));
+    ASSERT_DEVICE_ERROR(queue.Signal(fence, 2));
+    queue.Signal(fence, 4);
+}
+
+// Test the fence reaches the signaled values on Tick, once the previous submits are finished
+TEST_F(FenceValidationTest, CompletionOnTick) {
+    nxt::Fence fence = CreateFence();
+
+    queue.Submit(0, nullptr);
+    queue.Signal(fence, 2);
+    nxtCallbackUserdata userdata = 1234;
+    fence.OnCompletion(2, ToMockFenceOnCompletionCallback, userdata);
+    ASSERT_EQ(fence.GetCompletedValue(), 0u);
+
+    EXPECT_CALL(*mockFenceOnCompletionCallback, Call(NXT_FENCE_COMPLETION_STATUS_SUCCESS, userdata))
+        .Times(1);
+    device.Tick();
+    ASSERT_EQ(fence.GetCompletedValue(), 2u);
+}
+
+// Test OnCompletion for an already completed value calls the callback right away
+TEST_F(FenceValidationTest, OnCompletionOfCompletedValue) {
+    nxt::Fence fence = CreateFence();
+    queue.Signal(fence, 2);
+    device.Tick();
+
+    nxtCallbackUserdata userdata = 1235;
+    EXPECT_CALL(*mockFenceOnCompletionCallback, Call(NXT_FENCE_COMPLETION_STATUS_SUCCESS, userdata))
+        .Times(2);
+    fence.OnCompletion(1, ToMockFenceOnCompletionCallback, userdata);
+    fence.OnCompletion(2, ToMockFenceOnCompletionCallback, userdata);
+}
+
+// Test OnCompletion for a value greater than the signaled value is an error
+TEST_F(FenceValidationTest, OnCompletionOfUnsignaledValue) {
+    nxt::Fence fence = CreateFence();
+    queue.Signal(fence, 1);
+
+    nxtCallbackUserdata userdata = 1236;
+    EXPECT_CALL(*mockFenceOnCompletionCallback, Call(NXT_FENCE_COMPLETION_STATUS_ERROR, userdata))
+        .Times(1);
+    ASSERT_DEVICE_ERROR(fence.OnCompletion(2, ToMockFenceOnCompletionCallback, userdata));
+}
@@ -0,0 +1,277 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/unittests/validation/ValidationTest.h"
+
+class QuerySetValidationTest : public ValidationTest {
+    protected:
+        nxt::QuerySet CreateTimestampSet(uint32_t count) {
+            return AssertWillBeSuccess(device.CreateQuerySetBuilder())
+                .SetType(nxt::QueryType::Timestamp)
+                .SetCount(count)
+                .GetResult();
+        }
+
+        nxt::QuerySet CreateStatisticsSet(uint32_t count) {
+            return AssertWillBeSuccess(device.CreateQuerySetBuilder())
+                .SetType(nxt::QueryType::PipelineStatistics)
+                .SetCount(count)
+                .SetPipelineStatistics(nxt::PipelineStatisticBit::Vertices |
+                                       nxt::PipelineStatisticBit::ComputeShaderInvocations)
+                .GetResult();
+        }
+
+        nxt::Buffer CreateResultBuffer(uint32_t size) {
+            nxt::Buffer buffer = AssertWillBeSuccess(device.CreateBufferBuilder())
+                .SetSize(size)
+                .SetAllowedUsage(nxt::BufferUsageBit::TransferDst)
+                .GetResult();
+            buffer.FreezeUsage(nxt::BufferUsageBit::TransferDst);
+            return buffer;
+        }
+};
+
+// Test the validation of the query set builder
+TEST_F(QuerySetValidationTest, Creation) {
+    // Success
+    CreateTimestampSet(4);
+    CreateStatisticsSet(4);
+
+    // Type and count are required
+    AssertWillBeError(device.CreateQuerySetBuilder()).SetCount(1).GetResult();
+    AssertWillBeError(device.CreateQuerySetBuilder())
+        .SetType(nxt::QueryType::Timestamp)
+        .GetResult();
+
+    // Count can't be 0
+    AssertWillBeError(device.CreateQuerySetBuilder())
+        .SetType(nxt::QueryType::Timestamp)
+        .SetCount(0)
+        .GetResult();
+
+    // Pipeline statistics are required for pipeline statistics sets
+    AssertWillBeError(device.CreateQuerySetBuilder())
+        .SetType(nxt::QueryType::PipelineStatistics)
+        .SetCount(1)
+        .GetResult();
+
+    // Pipeline statistics can't be set on timestamp sets
+    AssertWillBeError(device.CreateQuerySetBuilder())
+        .SetType(nxt::QueryType::Timestamp)
+        .SetCount(1)
+        .SetPipelineStatistics(nxt::PipelineStatisticBit::Vertices)
+        .GetResult();
+
+    // Properties can't be set twice
+    AssertWillBeError(device.CreateQuerySetBuilder())
+        .SetType(nxt::QueryType::Timestamp)
+        .SetType(nxt::QueryType::Timestamp)
+        .SetCount(1)
+        .GetResult();
+}
+
+// Test timestamps can be written between passes but not inside them
+TEST_F(QuerySetValidationTest, TimestampOutsideOfPasses) {
+    nxt::QuerySet querySet = CreateTimestampSet(2);
+    DummyRenderPass renderPass = CreateDummyRenderPass();
+
+    // Success
+    AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .WriteTimestamp(querySet, 0)
+        .BeginComputePass()
+        .EndComputePass()
+        .WriteTimestamp(querySet, 1)
+        .GetResult();
+
+    // Inside a compute pass
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .BeginComputePass()
+        .WriteTimestamp(querySet, 0)
+        .EndComputePass()
+        .GetResult();
+
+    // Inside a render pass
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .BeginRenderPass(renderPass.renderPass, renderPass.framebuffer)
+        .WriteTimestamp(querySet, 0)
+        .BeginRenderSubpass()
+        .EndRenderSubpass()
+        .EndRenderPass()
+        .GetResult();
+}
+
+// Test the query index and type of the query commands are validated
+TEST_F(QuerySetValidationTest, IndexAndType) {
+    nxt::QuerySet timestamps = CreateTimestampSet(2);
+    nxt::QuerySet statistics = CreateStatisticsSet(2);
+
+    // Index out of range
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .WriteTimestamp(timestamps, 2)
+        .GetResult();
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .BeginPipelineStatisticsQuery(statistics, 2)
+        .EndPipelineStatisticsQuery()
+        .GetResult();
+
+    // Wrong query set type
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .WriteTimestamp(statistics, 0)
+        .GetResult();
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .BeginPipelineStatisticsQuery(timestamps, 0)
+        .EndPipelineStatisticsQuery()
+        .GetResult();
+}
+
+// Test pipeline statistics queries must be begun and ended in pairs, one at a time
+TEST_F(QuerySetValidationTest, StatisticsQueryNesting) {
+    nxt::QuerySet querySet = CreateStatisticsSet(2);
+
+    // Success
+    AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .BeginPipelineStatisticsQuery(querySet, 0)
+        .BeginComputePass()
+        .EndComputePass()
+        .EndPipelineStatisticsQuery()
+        .BeginPipelineStatisticsQuery(querySet, 1)
+        .EndPipelineStatisticsQuery()
+        .GetResult();
+
+    // Two active queries
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .BeginPipelineStatisticsQuery(querySet, 0)
+        .BeginPipelineStatisticsQuery(querySet, 1)
+        .EndPipelineStatisticsQuery()
+        .EndPipelineStatisticsQuery()
+        .GetResult();
+
+    // End without begin
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .EndPipelineStatisticsQuery()
+        .GetResult();
+
+    // Still active at the end of the command buffer
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .BeginPipelineStatisticsQuery(querySet, 0)
+        .GetResult();
+
+    // Ended inside a pass
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .BeginPipelineStatisticsQuery(querySet, 0)
+        .BeginComputePass()
+        .EndPipelineStatisticsQuery()
+        .EndComputePass()
+        .GetResult();
+}
+
+// Test pipeline statistics queries can't be submitted to transfer queues, unlike timestamps
+TEST_F(QuerySetValidationTest, StatisticsNotOnTransferQueues) {
+    nxt::Queue transfer = AssertWillBeSuccess(device.CreateQueueBuilder())
+        .SetType(nxt::QueueType::Transfer)
+        .GetResult();
+
+    nxt::CommandBuffer timestamps = AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .WriteTimestamp(CreateTimestampSet(1), 0)
+        .GetResult();
+    transfer.Submit(1, &timestamps);
+
+    nxt::CommandBuffer statistics = AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .BeginPipelineStatisticsQuery(CreateStatisticsSet(1), 0)
+        .EndPipelineStatisticsQuery()
+        .GetResult();
+    ASSERT_DEVICE_ERROR(transfer.Submit(1, &statistics));
+}
+
+// Test only the queries written in the command buffer can be resolved
+TEST_F(QuerySetValidationTest, ResolveWrittenQueries) {
+    nxt::QuerySet querySet = CreateTimestampSet(4);
+    nxt::Buffer buffer = CreateResultBuffer(32);
+
+    // Success
+    AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .WriteTimestamp(querySet, 1)
+        .WriteTimestamp(querySet, 2)
+        .ResolveQuerySet(querySet, 1, 2, buffer, 0)
+        .GetResult();
+
+    // A query isn't written
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .WriteTimestamp(querySet, 1)
+        .ResolveQuerySet(querySet, 1, 2, buffer, 0)
+        .GetResult();
+
+    // The queries are written after the resolve
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .ResolveQuerySet(querySet, 0, 1, buffer, 0)
+        .WriteTimestamp(querySet, 0)
+        .GetResult();
+
+    // Out of the query set
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .WriteTimestamp(querySet, 3)
+        .ResolveQuerySet(querySet, 3, 2, buffer, 0)
+        .GetResult();
+}
+
+// Test the validation of the destination of resolves
+TEST_F(QuerySetValidationTest, ResolveDestination) {
+    nxt::QuerySet timestamps = CreateTimestampSet(2);
+    nxt::QuerySet statistics = CreateStatisticsSet(1);
+    nxt::Buffer buffer = CreateResultBuffer(16);
+
+    // Success
+    AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .WriteTimestamp(timestamps, 0)
+        .WriteTimestamp(timestamps, 1)
+        .ResolveQuerySet(timestamps, 0, 2, buffer, 0)
+        .ResolveQuerySet(timestamps, 1, 1, buffer, 8)
+        .GetResult();
+
+    // Offset not a multiple of 8
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .WriteTimestamp(timestamps, 0)
+        .ResolveQuerySet(timestamps, 0, 1, buffer, 4)
+        .GetResult();
+
+    // Overflows the buffer
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .WriteTimestamp(timestamps, 0)
+        .WriteTimestamp(timestamps, 1)
+        .ResolveQuerySet(timestamps, 0, 2, buffer, 8)
+        .GetResult();
+
+    // Pipeline statistics queries have one result per statistic
+    AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .BeginPipelineStatisticsQuery(statistics, 0)
+        .EndPipelineStatisticsQuery()
+        .ResolveQuerySet(statistics, 0, 1, buffer, 0)
+        .GetResult();
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .BeginPipelineStatisticsQuery(statistics, 0)
+        .EndPipelineStatisticsQuery()
+        .ResolveQuerySet(statistics, 0, 1, buffer, 8)
+        .GetResult();
+
+    // The buffer isn't transitioned to the TransferDst usage
+    nxt::Buffer mapBuffer = AssertWillBeSuccess(device.CreateBufferBuilder())
+        .SetSize(16)
+        .SetAllowedUsage(nxt::BufferUsageBit::TransferDst | nxt::BufferUsageBit::MapRead)
+        .SetInitialUsage(nxt::BufferUsageBit::MapRead)
+        .GetResult();
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .WriteTimestamp(timestamps, 0)
+        .ResolveQuerySet(timestamps, 0, 1, mapBuffer, 0)
+        .GetResult();
+}
@@ -0,0 +1,146 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/unittests/validation/ValidationTest.h"
+
+class QueueValidationTest : public ValidationTest {
+    protected:
+        nxt::Queue CreateQueue(nxt::QueueType type) {
+            return AssertWillBeSuccess(device.CreateQueueBuilder()).SetType(type).GetResult();
+        }
+
+        nxt::Buffer CreateTransitionableBuffer() {
+            return AssertWillBeSuccess(device.CreateBufferBuilder())
+                .SetSize(4)
+                .SetAllowedUsage(nxt::BufferUsageBit::TransferDst | nxt::BufferUsageBit::Vertex)
+                .SetInitialUsage(nxt::BufferUsageBit::Vertex)
+                .GetResult();
+        }
+
+        nxt::CommandBuffer TransitionBuffer(const nxt::Buffer& buffer, nxt::BufferUsageBit usage) {
+            return AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+                .TransitionBufferUsage(buffer, usage)
+                .GetResult();
+        }
+};
+
+// Test the default queue type is graphics and accepts render and compute passes
+TEST_F(QueueValidationTest, DefaultIsGraphics) {
+    nxt::Queue queue = AssertWillBeSuccess(device.CreateQueueBuilder()).GetResult();
+
+    DummyRenderPass renderPass = CreateDummyRenderPass();
+    nxt::CommandBuffer commands = AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .BeginRenderPass(renderPass.renderPass, renderPass.framebuffer)
+        .BeginRenderSubpass()
+        .EndRenderSubpass()
+        .EndRenderPass()
+        .BeginComputePass()
+        .EndComputePass()
+        .GetResult();
+    queue.Submit(1, &commands);
+}
+
+// Test render passes can only be submitted to graphics queues
+TEST_F(QueueValidationTest, RenderPassOnlyOnGraphics) {
+    nxt::Queue compute = CreateQueue(nxt::QueueType::Compute);
+    nxt::Queue transfer = CreateQueue(nxt::QueueType::Transfer);
+
+    DummyRenderPass renderPass = CreateDummyRenderPass();
+    nxt::CommandBuffer commands = AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .BeginRenderPass(renderPass.renderPass, renderPass.framebuffer)
+        .BeginRenderSubpass()
+        .EndRenderSubpass()
+        .EndRenderPass()
+        .GetResult();
+    ASSERT_DEVICE_ERROR(compute.Submit(1, &commands));
+    ASSERT_DEVICE_ERROR(transfer.Submit(1, &commands));
+}
+
+// Test compute passes can be submitted to compute queues but not transfer queues
+TEST_F(QueueValidationTest, ComputePassNotOnTransfer) {
+    nxt::Queue compute = CreateQueue(nxt::QueueType::Compute);
+    nxt::Queue transfer = CreateQueue(nxt::QueueType::Transfer);
+
+    nxt::CommandBuffer commands = AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .BeginComputePass()
+        .EndComputePass()
+        .GetResult();
+    compute.Submit(1, &commands);
+    ASSERT_DEVICE_ERROR(transfer.Submit(1, &commands));
+}
+
+// Test a resource transitioned on a queue type can't be used by another type until it waits on
+// a fence signaled after the transition.
+TEST_F(QueueValidationTest, OwnershipNeedsWait) {
+    nxt::Queue graphics = CreateQueue(nxt::QueueType::Graphics);
+    nxt::Queue transfer = CreateQueue(nxt::QueueType::Transfer);
+    nxt::Fence fence = AssertWillBeSuccess(device.CreateFenceBuilder()).GetResult();
+    nxt::Buffer buffer = CreateTransitionableBuffer();
+
+    nxt::CommandBuffer toTransferDst = TransitionBuffer(buffer, nxt::BufferUsageBit::TransferDst);
+    nxt::CommandBuffer toVertex = TransitionBuffer(buffer, nxt::BufferUsageBit::Vertex);
+
+    transfer.Submit(1, &toTransferDst);
+    ASSERT_DEVICE_ERROR(graphics.Submit(1, &toVertex));
+
+    transfer.Signal(fence, 1);
+    ASSERT_DEVICE_ERROR(graphics.Submit(1, &toVertex));
+
+    graphics.Wait(fence, 1);
+    graphics.Submit(1, &toVertex);
+}
+
+// Test waiting on a fence signaled before the transition doesn't give ownership
+TEST_F(QueueValidationTest, WaitOnEarlierSignal) {
+    nxt::Queue graphics = CreateQueue(nxt::QueueType::Graphics);
+    nxt::Queue transfer = CreateQueue(nxt::QueueType::Transfer);
+    nxt::Fence fence = AssertWillBeSuccess(device.CreateFenceBuilder()).GetResult();
+    nxt::Buffer buffer = CreateTransitionableBuffer();
+
+    nxt::CommandBuffer toTransferDst = TransitionBuffer(buffer, nxt::BufferUsageBit::TransferDst);
+    nxt::CommandBuffer toVertex = TransitionBuffer(buffer, nxt::BufferUsageBit::Vertex);
+
+    transfer.Signal(fence, 1);
+    transfer.Submit(1, &toTransferDst);
+    transfer.Signal(fence, 2);
+
+    graphics.Wait(fence, 1);
+    ASSERT_DEVICE_ERROR(graphics.Submit(1, &toVertex));
+    graphics.Wait(fence, 2);
+    graphics.Submit(1, &toVertex);
+}
+
+// Test queues of the same type share the resources without waiting
+TEST_F(QueueValidationTest, SameTypeNeedsNoWait) {
+    nxt::Queue transfer1 = CreateQueue(nxt::QueueType::Transfer);
+    nxt::Queue transfer2 = CreateQueue(nxt::QueueType::Transfer);
+    nxt::Buffer buffer = CreateTransitionableBuffer();
+
+    nxt::CommandBuffer toTransferDst = TransitionBuffer(buffer, nxt::BufferUsageBit::TransferDst);
+    nxt::CommandBuffer toVertex = TransitionBuffer(buffer, nxt::BufferUsageBit::Vertex);
+
+    transfer1.Submit(1, &toTransferDst);
+    transfer2.Submit(1, &toVertex);
+}
+
+// Test waiting on a fence value that isn't signaled is an error
+TEST_F(QueueValidationTest, WaitOnUnsignaledValue) {
+    nxt::Queue graphics = CreateQueue(nxt::QueueType::Graphics);
+    nxt::Queue compute = CreateQueue(nxt::QueueType::Compute);
+    nxt::Fence fence = AssertWillBeSuccess(device.CreateFenceBuilder()).GetResult();
+
+    compute.Signal(fence, 1);
+    graphics.Wait(fence, 1);
+    ASSERT_DEVICE_ERROR(graphics.Wait(fence, 2));
+}
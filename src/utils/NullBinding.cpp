@@ -14,12 +14,44 @@
 
 #include "utils/BackendBinding.h"
 
+#include "common/SwapChainUtils.h"
+#include "nxt/nxt_wsi.h"
+
 namespace backend { namespace null {
     void Init(nxtProcTable* procs, nxtDevice* device);
 }}  // namespace backend::null
 
 namespace utils {
 
+    // The null backend allocates the swap chain textures itself and there is nothing to present
+    // to, so the binding doesn't need a window and can be used headless.
+    class SwapChainImplNull {
+      public:
+        using WSIContext = nxtWSIContextNull;
+
+        void Init(nxtWSIContextNull*) {
+        }
+
+        nxtSwapChainError Configure(nxtTextureFormat format,
+                                    nxtTextureUsageBit,
+                                    uint32_t,
+                                    uint32_t) {
+            if (format != NXT_TEXTURE_FORMAT_R8_G8_B8_A8_UNORM) {
+                return "unsupported format";
+            }
+            return NXT_SWAP_CHAIN_NO_ERROR;
+        }
+
+        nxtSwapChainError GetNextTexture(nxtSwapChainNextTexture* nextTexture) {
+            nextTexture->texture.ptr = nullptr;
+            return NXT_SWAP_CHAIN_NO_ERROR;
+        }
+
+        nxtSwapChainError Present() {
+            return NXT_SWAP_CHAIN_NO_ERROR;
+        }
+    };
+
     class NullBinding : public BackendBinding {
       public:
         void SetupGLFWWindowHints() override {
@@ -28,11 +60,17 @@ namespace utils {
             backend::null::Init(procs, device);
         }
         uint64_t GetSwapChainImplementation() override {
-            return 0;
+            if (mSwapchainImpl.userData == nullptr) {
+                mSwapchainImpl = CreateSwapChainImplementation(new SwapChainImplNull);
+            }
+            return reinterpret_cast<uint64_t>(&mSwapchainImpl);
         }
         nxtTextureFormat GetPreferredSwapChainTextureFormat() override {
             return NXT_TEXTURE_FORMAT_R8_G8_B8_A8_UNORM;
         }
+
+      private:
+        nxtSwapChainImplementation mSwapchainImpl = {};
     };
 
     BackendBinding* CreateNullBinding() {
@@ -0,0 +1,62 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "utils/PassTimings.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace utils {
+
+    std::vector<PassTiming> GetPassTimings(const std::vector<std::string>& passNames,
+                                           const uint64_t* timestamps) {
+        std::vector<PassTiming> timings(passNames.size());
+        for (size_t i = 0; i < passNames.size(); ++i) {
+            timings[i].name = passNames[i];
+            timings[i].start = timestamps[i];
+            timings[i].end = timestamps[i + 1];
+        }
+        return timings;
+    }
+
+    std::string FormatPassTimings(const std::vector<PassTiming>& timings,
+                                  double nanosecondsPerTick) {
+        int nameWidth = 5;
+        uint64_t total = 0;
+        for (const PassTiming& timing : timings) {
+            nameWidth = std::max(nameWidth, static_cast<int>(timing.name.size()));
+            // Timestamps of different engines aren't ordered, don't let them wrap around.
+            total += timing.end > timing.start ? timing.end - timing.start : 0;
+        }
+
+        std::string table;
+        char line[256];
+        auto AddRow = [&](const char* name, uint64_t ticks) {
+            double microseconds = static_cast<double>(ticks) * nanosecondsPerTick / 1000.0;
+            double share = total == 0 ? 0.0 : 100.0 * static_cast<double>(ticks) / total;
+            snprintf(line, sizeof(line), "%-*.*s %12.3f %6.1f%%\n", nameWidth, nameWidth, name,
+                     microseconds, share);
+            table += line;
+        };
+
+        snprintf(line, sizeof(line), "%-*s %12s %7s\n", nameWidth, "Pass", "Time (us)", "Share");
+        table += line;
+        for (const PassTiming& timing : timings) {
+            AddRow(timing.name.c_str(), timing.end > timing.start ? timing.end - timing.start : 0);
+        }
+        AddRow("Total", total);
+        return table;
+    }
+
+}  // namespace utils
@@ -0,0 +1,44 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UTILS_PASSTIMINGS_H_
+#define UTILS_PASSTIMINGS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+    struct PassTiming {
+        std::string name;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    // Pairs the passes with the resolved results of a timestamp query set written at their
+    // boundaries: pass i runs between timestamps[i] and timestamps[i + 1], so there is one more
+    // timestamp than there are passes.
+    std::vector<PassTiming> GetPassTimings(const std::vector<std::string>& passNames,
+                                           const uint64_t* timestamps);
+
+    // Returns a table with the duration of each pass in microseconds and its share of the total.
+    // Timestamps are in ticks of the GPU counter, nanosecondsPerTick converts them for backends
+    // whose ticks aren't nanoseconds.
+    std::string FormatPassTimings(const std::vector<PassTiming>& timings,
+                                  double nanosecondsPerTick = 1.0);
+
+}  // namespace utils
+
+#endif  // UTILS_PASSTIMINGS_H_
@@ -0,0 +1,187 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wire/CompactCommandBuffer.h"
+
+#include "common/Assert.h"
+
+#include <cstring>
+
+namespace nxt { namespace wire {
+
+    namespace {
+
+        // Large enough for compression to find repetitions between frames of small commands.
+        constexpr size_t kStagingSize = 256 * 1024;
+
+        // LZ4 can't expand data more than this, anything larger is a corrupt frame.
+        constexpr uint64_t kMaxCompressionRatio = 255;
+
+    }  // anonymous namespace
+
+    void PrintCompactEncodingReport(const CompactEncodingStats& stats, std::ostream& stream) {
+        if (stats.frameCount == 0) {
+            stream << "No frames were sent" << std::endl;
+            return;
+        }
+
+        double frames = static_cast<double>(stats.frameCount);
+        stream << "Frames: " << stats.frameCount << std::endl;
+        stream << "Bytes per frame: native " << stats.nativeBytes / frames << ", compact "
+               << stats.compactBytes / frames << ", sent " << stats.sentBytes / frames
+               << std::endl;
+        if (stats.sentBytes != 0) {
+            stream << "Ratio: " << static_cast<double>(stats.nativeBytes) / stats.sentBytes
+                   << "x" << std::endl;
+        }
+    }
+
+    // CompactCommandSerializer
+
+    CompactCommandSerializer::CompactCommandSerializer(CommandSerializer* serializer,
+                                                       WireEncoding encoding)
+        : mSerializer(serializer),
+          mCompress(encoding == WireEncoding::CompactCompressed),
+          mStaging(kStagingSize) {
+        ASSERT(encoding != WireEncoding::Native);
+    }
+
+    void* CompactCommandSerializer::GetCmdSpace(size_t size) {
+        if (mStagingSize + size > mStaging.size()) {
+            EncodeStagedCommands();
+            if (size > mStaging.size()) {
+                mStaging.resize(size);
+            }
+        }
+
+        uint8_t* result = &mStaging[mStagingSize];
+        mStagingSize += size;
+        return result;
+    }
+
+    void CompactCommandSerializer::Flush() {
+        EncodeStagedCommands();
+        mSerializer->Flush();
+    }
+
+    const CompactEncodingStats& CompactCommandSerializer::GetStats() const {
+        return mStats;
+    }
+
+    void CompactCommandSerializer::EncodeStagedCommands() {
+        if (mStagingSize == 0) {
+            return;
+        }
+
+        mWriter.Clear();
+        const uint8_t* commands = mStaging.data();
+        size_t size = mStagingSize;
+        while (size > 0) {
+            bool encoded = EncodeCompactCommand(&commands, &size, &mWriter);
+            ASSERT(encoded);
+            if (!encoded) {
+                break;
+            }
+        }
+        const std::vector<uint8_t>& compact = mWriter.GetData();
+
+        // Only use the compressed data if it is actually smaller.
+        CompactFrameHeader header;
+        header.decodedSize = static_cast<uint32_t>(compact.size());
+        header.isCompressed = 0;
+        const uint8_t* payload = compact.data();
+        header.size = header.decodedSize;
+
+        if (mCompress) {
+            mCompressed.clear();
+            CompressBlock(compact.data(), compact.size(), &mCompressed);
+            if (mCompressed.size() < compact.size()) {
+                header.isCompressed = 1;
+                payload = mCompressed.data();
+                header.size = static_cast<uint32_t>(mCompressed.size());
+            }
+        }
+
+        uint8_t* frame =
+            static_cast<uint8_t*>(mSerializer->GetCmdSpace(sizeof(header) + header.size));
+        memcpy(frame, &header, sizeof(header));
+        memcpy(frame + sizeof(header), payload, header.size);
+
+        mStats.frameCount++;
+        mStats.nativeBytes += mStagingSize;
+        mStats.compactBytes += compact.size();
+        mStats.sentBytes += sizeof(header) + header.size;
+
+        mStagingSize = 0;
+    }
+
+    // CompactCommandHandler
+
+    CompactCommandHandler::CompactCommandHandler(CommandHandler* handler) : mHandler(handler) {
+    }
+
+    const uint8_t* CompactCommandHandler::HandleCommands(const uint8_t* commands, size_t size) {
+        while (size > 0) {
+            if (size < sizeof(CompactFrameHeader)) {
+                return nullptr;
+            }
+
+            const auto* header = reinterpret_cast<const CompactFrameHeader*>(commands);
+            if (size - sizeof(CompactFrameHeader) < header->size) {
+                return nullptr;
+            }
+
+            if (!HandleFrame(header, commands + sizeof(CompactFrameHeader))) {
+                return nullptr;
+            }
+
+            commands += sizeof(CompactFrameHeader) + header->size;
+            size -= sizeof(CompactFrameHeader) + header->size;
+        }
+
+        return commands;
+    }
+
+    bool CompactCommandHandler::HandleFrame(const CompactFrameHeader* header,
+                                            const uint8_t* data) {
+        const uint8_t* compact = data;
+        if (header->isCompressed != 0) {
+            if (header->decodedSize > uint64_t(header->size) * kMaxCompressionRatio) {
+                return false;
+            }
+
+            mDecompressed.resize(header->decodedSize);
+            if (!DecompressBlock(data, header->size, mDecompressed.data(), header->decodedSize)) {
+                return false;
+            }
+            compact = mDecompressed.data();
+        } else if (header->decodedSize != header->size) {
+            return false;
+        }
+
+        mDecoded.clear();
+        mReader.Reset(compact, header->decodedSize);
+        while (mReader.GetRemainingSize() > 0) {
+            if (!DecodeCompactCommand(&mReader, &mDecoded)) {
+                return false;
+            }
+        }
+
+        if (mDecoded.empty()) {
+            return true;
+        }
+        return mHandler->HandleCommands(mDecoded.data(), mDecoded.size()) != nullptr;
+    }
+
+}}  // namespace nxt::wire
@@ -0,0 +1,91 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef WIRE_COMPACT_COMMAND_BUFFER_H_
+#define WIRE_COMPACT_COMMAND_BUFFER_H_
+
+#include "wire/CompactEncoding.h"
+#include "wire/Wire.h"
+
+#include <ostream>
+#include <vector>
+
+namespace nxt { namespace wire {
+
+    // Commands in the compact encoding are sent in frames, each made of this header followed by
+    // frame.size bytes of compact commands, compressed if frame.isCompressed is set. A frame is
+    // always written with a single GetCmdSpace so that transports never split it.
+    struct CompactFrameHeader {
+        uint32_t size;
+        uint32_t decodedSize;
+        uint32_t isCompressed;
+    };
+
+    struct CompactEncodingStats {
+        uint64_t frameCount = 0;
+        // The size of the commands in the native encoding, after the compact encoding, and of the
+        // frames that were sent including their headers.
+        uint64_t nativeBytes = 0;
+        uint64_t compactBytes = 0;
+        uint64_t sentBytes = 0;
+    };
+
+    // Prints the average bytes per frame of each step of the encoding.
+    void PrintCompactEncodingReport(const CompactEncodingStats& stats, std::ostream& stream);
+
+    // Used on the client side in front of a transport's serializer: commands are gathered in
+    // native form then encoded in a frame on Flush, or when the staging buffer is full.
+    class CompactCommandSerializer : public CommandSerializer {
+      public:
+        CompactCommandSerializer(CommandSerializer* serializer, WireEncoding encoding);
+
+        void* GetCmdSpace(size_t size) override;
+        void Flush() override;
+
+        const CompactEncodingStats& GetStats() const;
+
+      private:
+        void EncodeStagedCommands();
+
+        CommandSerializer* mSerializer;
+        bool mCompress;
+
+        std::vector<uint8_t> mStaging;
+        size_t mStagingSize = 0;
+        CompactWriter mWriter;
+        std::vector<uint8_t> mCompressed;
+
+        CompactEncodingStats mStats;
+    };
+
+    // Used on the server side in front of the wire server: decodes the frames and gives the
+    // commands in native form to the handler.
+    class CompactCommandHandler : public CommandHandler {
+      public:
+        CompactCommandHandler(CommandHandler* handler);
+
+        const uint8_t* HandleCommands(const uint8_t* commands, size_t size) override;
+
+      private:
+        bool HandleFrame(const CompactFrameHeader* header, const uint8_t* data);
+
+        CommandHandler* mHandler;
+        CompactReader mReader;
+        std::vector<uint8_t> mDecompressed;
+        std::vector<uint8_t> mDecoded;
+    };
+
+}}  // namespace nxt::wire
+
+#endif  // WIRE_COMPACT_COMMAND_BUFFER_H_
@@ -0,0 +1,332 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wire/CompactEncoding.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace nxt { namespace wire {
+
+    // CompactWriter
+
+    void CompactWriter::Write(uint32_t value) {
+        Write(static_cast<uint64_t>(value));
+    }
+
+    void CompactWriter::Write(uint64_t value) {
+        while (value >= 0x80) {
+            mData.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        mData.push_back(static_cast<uint8_t>(value));
+    }
+
+    void CompactWriter::Write(bool value) {
+        mData.push_back(value ? 1 : 0);
+    }
+
+    void CompactWriter::Write(float value) {
+        WriteBytes(&value, sizeof(value));
+    }
+
+    void CompactWriter::WriteSize(size_t value) {
+        Write(static_cast<uint64_t>(value));
+    }
+
+    void CompactWriter::WriteId(uint32_t id) {
+        // Zigzag encoding makes small negative deltas small varints too.
+        int32_t delta = static_cast<int32_t>(id - mLastId);
+        uint32_t zigzag = (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+        Write(zigzag);
+        mLastId = id;
+    }
+
+    void CompactWriter::WriteBytes(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        mData.insert(mData.end(), bytes, bytes + size);
+    }
+
+    const std::vector<uint8_t>& CompactWriter::GetData() const {
+        return mData;
+    }
+
+    void CompactWriter::Clear() {
+        mData.clear();
+    }
+
+    // CompactReader
+
+    void CompactReader::Read(uint32_t* value) {
+        *value = static_cast<uint32_t>(ReadVarint(32));
+    }
+
+    void CompactReader::Read(uint64_t* value) {
+        *value = ReadVarint(64);
+    }
+
+    void CompactReader::Read(bool* value) {
+        uint8_t byte = 0;
+        ReadBytes(&byte, sizeof(byte));
+        if (byte > 1) {
+            mValid = false;
+            mRemainingSize = 0;
+        }
+        *value = byte == 1;
+    }
+
+    void CompactReader::Read(float* value) {
+        *value = 0.0f;
+        ReadBytes(value, sizeof(*value));
+    }
+
+    void CompactReader::ReadSize(size_t* value) {
+        uint64_t size = ReadVarint(64);
+        if (size > std::numeric_limits<size_t>::max()) {
+            mValid = false;
+            mRemainingSize = 0;
+            size = 0;
+        }
+        *value = static_cast<size_t>(size);
+    }
+
+    void CompactReader::ReadId(uint32_t* id) {
+        uint32_t zigzag = static_cast<uint32_t>(ReadVarint(32));
+        uint32_t delta = (zigzag >> 1) ^ (0u - (zigzag & 1));
+        mLastId += delta;
+        *id = mLastId;
+    }
+
+    void CompactReader::ReadBytes(void* data, size_t size) {
+        if (size > mRemainingSize) {
+            mValid = false;
+            mRemainingSize = 0;
+            memset(data, 0, size);
+            return;
+        }
+
+        memcpy(data, mData, size);
+        mData += size;
+        mRemainingSize -= size;
+    }
+
+    void CompactReader::Reset(const uint8_t* data, size_t size) {
+        mData = data;
+        mRemainingSize = size;
+        mValid = true;
+    }
+
+    size_t CompactReader::GetRemainingSize() const {
+        return mRemainingSize;
+    }
+
+    bool CompactReader::IsValid() const {
+        return mValid;
+    }
+
+    uint64_t CompactReader::ReadVarint(unsigned int maxBits) {
+        uint64_t result = 0;
+        for (unsigned int shift = 0; shift < maxBits; shift += 7) {
+            if (mRemainingSize == 0) {
+                break;
+            }
+
+            uint8_t byte = *mData++;
+            mRemainingSize--;
+            result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+            if ((byte & 0x80) == 0) {
+                if (maxBits < 64 && (result >> maxBits) != 0) {
+                    break;
+                }
+                return result;
+            }
+        }
+
+        // Truncated data, or a varint too large for its type.
+        mValid = false;
+        mRemainingSize = 0;
+        return 0;
+    }
+
+    // Block compression
+
+    namespace {
+
+        constexpr size_t kMinMatchLength = 4;
+        constexpr size_t kMaxMatchOffset = 65535;
+        constexpr unsigned int kHashBits = 14;
+
+        // Like in LZ4 the last bytes are always literals, which keeps the decoder simple.
+        constexpr size_t kLastLiterals = 5;
+        constexpr size_t kMatchStartLimit = 12;
+
+        uint32_t Read32(const uint8_t* data) {
+            uint32_t value;
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        uint32_t HashSequence(uint32_t sequence) {
+            return (sequence * 2654435761u) >> (32 - kHashBits);
+        }
+
+        // Lengths that don't fit in the 4 bits of the token continue in bytes of 255 until a
+        // byte smaller than 255.
+        void WriteExtraLength(std::vector<uint8_t>* compressed, size_t length) {
+            while (length >= 255) {
+                compressed->push_back(255);
+                length -= 255;
+            }
+            compressed->push_back(static_cast<uint8_t>(length));
+        }
+
+        bool ReadExtraLength(const uint8_t* compressed,
+                             size_t compressedSize,
+                             size_t* offset,
+                             size_t* length) {
+            uint8_t byte;
+            do {
+                if (*offset >= compressedSize) {
+                    return false;
+                }
+                byte = compressed[(*offset)++];
+                *length += byte;
+            } while (byte == 255);
+            return true;
+        }
+
+        // A sequence is a token, literals, and a match described by its offset and length. The
+        // last sequence of a block has no match, which is denoted by a matchLength of 0.
+        void WriteSequence(std::vector<uint8_t>* compressed,
+                           const uint8_t* literals,
+                           size_t literalCount,
+                           size_t matchOffset,
+                           size_t matchLength) {
+            size_t tokenIndex = compressed->size();
+            compressed->push_back(0);
+
+            uint8_t token = static_cast<uint8_t>(std::min(literalCount, size_t(15)) << 4);
+            if (literalCount >= 15) {
+                WriteExtraLength(compressed, literalCount - 15);
+            }
+            compressed->insert(compressed->end(), literals, literals + literalCount);
+
+            if (matchLength != 0) {
+                compressed->push_back(static_cast<uint8_t>(matchOffset & 0xFF));
+                compressed->push_back(static_cast<uint8_t>(matchOffset >> 8));
+
+                size_t length = matchLength - kMinMatchLength;
+                token |= static_cast<uint8_t>(std::min(length, size_t(15)));
+                if (length >= 15) {
+                    WriteExtraLength(compressed, length - 15);
+                }
+            }
+
+            (*compressed)[tokenIndex] = token;
+        }
+
+    }  // anonymous namespace
+
+    void CompressBlock(const uint8_t* data, size_t size, std::vector<uint8_t>* compressed) {
+        // Maps the hash of 4 bytes to the last position they were seen at.
+        std::vector<uint32_t> lastPositions(size_t(1) << kHashBits, 0);
+
+        size_t anchor = 0;
+        size_t position = 0;
+        while (position + kMatchStartLimit < size) {
+            uint32_t sequence = Read32(&data[position]);
+            uint32_t hash = HashSequence(sequence);
+            size_t candidate = lastPositions[hash];
+            lastPositions[hash] = static_cast<uint32_t>(position);
+
+            if (candidate >= position || position - candidate > kMaxMatchOffset ||
+                Read32(&data[candidate]) != sequence) {
+                position++;
+                continue;
+            }
+
+            size_t matchLength = kMinMatchLength;
+            size_t maxMatchLength = size - kLastLiterals - position;
+            while (matchLength < maxMatchLength &&
+                   data[candidate + matchLength] == data[position + matchLength]) {
+                matchLength++;
+            }
+
+            WriteSequence(compressed, &data[anchor], position - anchor, position - candidate,
+                          matchLength);
+            position += matchLength;
+            anchor = position;
+        }
+
+        WriteSequence(compressed, &data[anchor], size - anchor, 0, 0);
+    }
+
+    bool DecompressBlock(const uint8_t* compressed,
+                         size_t compressedSize,
+                         uint8_t* decompressed,
+                         size_t decompressedSize) {
+        size_t in = 0;
+        size_t out = 0;
+
+        while (in < compressedSize) {
+            uint8_t token = compressed[in++];
+
+            size_t literalCount = token >> 4;
+            if (literalCount == 15 &&
+                !ReadExtraLength(compressed, compressedSize, &in, &literalCount)) {
+                return false;
+            }
+            if (literalCount > compressedSize - in || literalCount > decompressedSize - out) {
+                return false;
+            }
+            memcpy(&decompressed[out], &compressed[in], literalCount);
+            in += literalCount;
+            out += literalCount;
+
+            // Only the last sequence has no match.
+            if (in == compressedSize) {
+                break;
+            }
+
+            if (compressedSize - in < 2) {
+                return false;
+            }
+            size_t matchOffset = compressed[in] | (size_t(compressed[in + 1]) << 8);
+            in += 2;
+            if (matchOffset == 0 || matchOffset > out) {
+                return false;
+            }
+
+            size_t matchLength = token & 0xF;
+            if (matchLength == 15 &&
+                !ReadExtraLength(compressed, compressedSize, &in, &matchLength)) {
+                return false;
+            }
+            matchLength += kMinMatchLength;
+            if (matchLength > decompressedSize - out) {
+                return false;
+            }
+
+            // Matches can overlap with the data they produce so copy byte by byte.
+            for (size_t i = 0; i < matchLength; ++i) {
+                decompressed[out + i] = decompressed[out - matchOffset + i];
+            }
+            out += matchLength;
+        }
+
+        return out == decompressedSize;
+    }
+
+}}  // namespace nxt::wire
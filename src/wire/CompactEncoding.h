@@ -0,0 +1,160 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef WIRE_COMPACTENCODING_H_
+#define WIRE_COMPACTENCODING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace nxt { namespace wire {
+
+    // The encodings of the client to server command stream that can be negotiated.
+    enum class WireEncoding : uint32_t {
+        // Commands are the structures of WireCmd.h, copied as is.
+        Native = 0,
+        // Integers, enums and IDs are varints, and IDs are delta-encoded.
+        Compact = 1,
+        // Compact, with each batch of commands compressed with an LZ4-style compressor.
+        CompactCompressed = 2,
+    };
+
+    // Writes the members of commands in the compact encoding. Integers are LEB128 varints and
+    // object IDs are zigzag varints of the difference with the previous ID as most commands refer
+    // to objects created just before them. The previous ID is kept across Clear() so that the
+    // whole stream is delta-encoded.
+    class CompactWriter {
+      public:
+        void Write(uint32_t value);
+        void Write(uint64_t value);
+        void Write(bool value);
+        void Write(float value);
+        void WriteSize(size_t value);
+        void WriteId(uint32_t id);
+        void WriteBytes(const void* data, size_t size);
+
+        template <typename T>
+        void WriteEnum(T value) {
+            Write(static_cast<uint32_t>(value));
+        }
+
+        const std::vector<uint8_t>& GetData() const;
+        void Clear();
+
+      private:
+        std::vector<uint8_t> mData;
+        uint32_t mLastId = 0;
+    };
+
+    // Reads what CompactWriter wrote. Reading past the end of the data or a malformed varint
+    // puts the reader in an error state after which it only returns zeroes.
+    class CompactReader {
+      public:
+        void Read(uint32_t* value);
+        void Read(uint64_t* value);
+        void Read(bool* value);
+        void Read(float* value);
+        void ReadSize(size_t* value);
+        void ReadId(uint32_t* id);
+        void ReadBytes(void* data, size_t size);
+
+        template <typename T>
+        void ReadEnum(T* value) {
+            uint32_t underlying = 0;
+            Read(&underlying);
+            *value = static_cast<T>(underlying);
+        }
+
+        // Starts reading a new frame, the previous ID is kept.
+        void Reset(const uint8_t* data, size_t size);
+        size_t GetRemainingSize() const;
+        bool IsValid() const;
+
+      private:
+        uint64_t ReadVarint(unsigned int maxBits);
+
+        const uint8_t* mData = nullptr;
+        size_t mRemainingSize = 0;
+        uint32_t mLastId = 0;
+        bool mValid = true;
+    };
+
+    // Generated in WireCmd_autogen.cpp. Encodes the native command at the start of commands and
+    // skips over it, returns false if it isn't a valid command.
+    bool EncodeCompactCommand(const uint8_t** commands, size_t* size, CompactWriter* writer);
+    // Generated in WireCmd_autogen.cpp. Decodes the next command and appends its native form to
+    // commands, returns false if the data is invalid.
+    bool DecodeCompactCommand(CompactReader* reader, std::vector<uint8_t>* commands);
+
+    // The compact form of a command is its ID, its members in the compact encoding, and the
+    // non-value parameters that follow the structure, copied as is. Recordings, like those of
+    // command buffer builders, are instead their ID, the recorded object and the number of
+    // recorded commands, followed by the compact form of each recorded command.
+    //
+    // Repeated commands aren't deduplicated: they are left to the compression of
+    // CompactCompressed, which already turns them into short back-references.
+    template <typename T>
+    bool EncodeCompactCmd(const uint8_t** commands, size_t* size, CompactWriter* writer) {
+        if (*size < sizeof(T)) {
+            return false;
+        }
+
+        const T* cmd = reinterpret_cast<const T*>(*commands);
+        size_t cmdSize = cmd->GetRequiredSize();
+        if (*size < cmdSize) {
+            return false;
+        }
+
+        writer->WriteEnum(cmd->commandId);
+        cmd->Encode(writer);
+        writer->WriteBytes(cmd + 1, cmdSize - sizeof(T));
+
+        *commands += cmdSize;
+        *size -= cmdSize;
+        return true;
+    }
+
+    template <typename T>
+    bool DecodeCompactCmd(CompactReader* reader, std::vector<uint8_t>* commands) {
+        T cmd;
+        cmd.Decode(reader);
+        if (!reader->IsValid()) {
+            return false;
+        }
+
+        size_t extraSize = cmd.GetRequiredSize() - sizeof(T);
+        if (extraSize > reader->GetRemainingSize()) {
+            return false;
+        }
+
+        size_t offset = commands->size();
+        commands->resize(offset + sizeof(T) + extraSize);
+        memcpy(&(*commands)[offset], &cmd, sizeof(T));
+        reader->ReadBytes(&(*commands)[offset + sizeof(T)], extraSize);
+        return reader->IsValid();
+    }
+
+    // A byte-oriented LZ77 compressor using the LZ4 block format. Compress appends to compressed
+    // and Decompress returns false unless it produces exactly decompressedSize bytes.
+    void CompressBlock(const uint8_t* data, size_t size, std::vector<uint8_t>* compressed);
+    bool DecompressBlock(const uint8_t* compressed,
+                         size_t compressedSize,
+                         uint8_t* decompressed,
+                         size_t decompressedSize);
+
+}}  // namespace nxt::wire
+
+#endif  // WIRE_COMPACTENCODING_H_
@@ -0,0 +1,236 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wire/MultiClientServer.h"
+
+#include "common/Assert.h"
+#include "wire/WireCmd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+
+namespace nxt { namespace wire {
+
+    namespace {
+
+        uint64_t NanosecondsBetween(std::chrono::steady_clock::time_point start,
+                                    std::chrono::steady_clock::time_point end) {
+            return static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+
+    }  // anonymous namespace
+
+    // The handler given to the transport of a client, it queues the commands until the client's
+    // turn in a round.
+    class MultiClientServer::Client : public CommandHandler {
+      public:
+        Client(SharedDeviceServer* server, CommandSerializer* returnSerializer)
+            : mServer(server), mReturnSerializer(returnSerializer) {
+        }
+
+        ~Client() {
+            delete mServer;
+        }
+
+        const uint8_t* HandleCommands(const uint8_t* commands, size_t size) override {
+            if (mCounters.hasError) {
+                return nullptr;
+            }
+
+            if (size != 0) {
+                mBatches.emplace_back();
+                Batch& batch = mBatches.back();
+                batch.commands.assign(commands, commands + size);
+                batch.receiveTime = std::chrono::steady_clock::now();
+                mCounters.batchCount++;
+            }
+            return commands + size;
+        }
+
+        bool HasQueuedCommands() const {
+            return !mBatches.empty();
+        }
+
+        // Handles whole commands until they would go over the budget, but always at least one
+        // so that commands larger than the budget make progress.
+        void HandleTurn(size_t budget) {
+            size_t handledSize = 0;
+            while (!mBatches.empty()) {
+                Batch& batch = mBatches.front();
+                const uint8_t* commands = batch.commands.data() + batch.offset;
+                size_t remainingSize = batch.commands.size() - batch.offset;
+
+                size_t sliceSize = 0;
+                uint64_t commandCount = 0;
+                while (sliceSize < remainingSize) {
+                    size_t cmdSize =
+                        GetWireCmdSize(commands + sliceSize, remainingSize - sliceSize);
+                    if (cmdSize == 0) {
+                        SetError();
+                        return;
+                    }
+                    if (handledSize + sliceSize + cmdSize > budget &&
+                        handledSize + sliceSize != 0) {
+                        break;
+                    }
+                    sliceSize += cmdSize;
+                    commandCount++;
+                }
+
+                if (sliceSize == 0) {
+                    return;
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                bool success = mServer->HandleCommands(commands, sliceSize) != nullptr;
+                auto end = std::chrono::steady_clock::now();
+
+                mCounters.handlingTimeNs += NanosecondsBetween(start, end);
+                mCounters.commandCount += commandCount;
+                mCounters.byteCount += sliceSize;
+
+                if (!success) {
+                    SetError();
+                    return;
+                }
+
+                handledSize += sliceSize;
+                batch.offset += sliceSize;
+                if (batch.offset == batch.commands.size()) {
+                    uint64_t latencyNs = NanosecondsBetween(batch.receiveTime, end);
+                    mCounters.totalLatencyNs += latencyNs;
+                    mCounters.maxLatencyNs = std::max(mCounters.maxLatencyNs, latencyNs);
+                    mBatches.pop_front();
+                }
+            }
+        }
+
+        void OnDeviceError(const char* message) {
+            mServer->OnDeviceError(message);
+        }
+
+        void FlushReturnCommands() {
+            mReturnSerializer->Flush();
+        }
+
+        const WireClientCounters& GetCounters() const {
+            return mCounters;
+        }
+
+      private:
+        struct Batch {
+            std::vector<uint8_t> commands;
+            size_t offset = 0;
+            std::chrono::steady_clock::time_point receiveTime;
+        };
+
+        void SetError() {
+            mCounters.hasError = true;
+            mBatches.clear();
+        }
+
+        SharedDeviceServer* mServer;
+        CommandSerializer* mReturnSerializer;
+        std::deque<Batch> mBatches;
+        WireClientCounters mCounters;
+    };
+
+    // MultiClientServer
+
+    MultiClientServer::MultiClientServer(nxtDevice device,
+                                         const nxtProcTable& procs,
+                                         size_t clientBudget)
+        : mDevice(device), mProcs(procs), mClientBudget(clientBudget) {
+        auto userdata = static_cast<nxtCallbackUserdata>(reinterpret_cast<uintptr_t>(this));
+        mProcs.deviceSetErrorCallback(mDevice, ForwardDeviceError, userdata);
+    }
+
+    MultiClientServer::~MultiClientServer() {
+        for (Client* client : mClients) {
+            delete client;
+        }
+    }
+
+    CommandHandler* MultiClientServer::AddClient(CommandSerializer* returnSerializer,
+                                                 SharedMemory* sharedMemory) {
+        SharedDeviceServer* server =
+            NewSharedDeviceServer(mDevice, mProcs, returnSerializer, sharedMemory);
+        Client* client = new Client(server, returnSerializer);
+        mClients.push_back(client);
+        return client;
+    }
+
+    void MultiClientServer::RemoveClient(CommandHandler* client) {
+        size_t index = FindClient(client);
+        mClients.erase(mClients.begin() + index);
+        delete static_cast<Client*>(client);
+    }
+
+    bool MultiClientServer::HandleRound() {
+        size_t clientCount = mClients.size();
+        size_t firstClient = clientCount == 0 ? 0 : mNextFirstClient % clientCount;
+
+        for (size_t i = 0; i < clientCount; ++i) {
+            Client* client = mClients[(firstClient + i) % clientCount];
+            if (client->HasQueuedCommands()) {
+                mCurrentClient = client;
+                client->HandleTurn(mClientBudget);
+            }
+        }
+        mCurrentClient = nullptr;
+        mNextFirstClient = firstClient + 1;
+
+        // Clients waiting on MapReadAsync might not send commands that would tick the device.
+        mProcs.deviceTick(mDevice);
+
+        bool hasQueuedCommands = false;
+        for (Client* client : mClients) {
+            client->FlushReturnCommands();
+            hasQueuedCommands = hasQueuedCommands || client->HasQueuedCommands();
+        }
+        return hasQueuedCommands;
+    }
+
+    void MultiClientServer::HandleAllQueuedCommands() {
+        while (HandleRound()) {
+        }
+    }
+
+    const WireClientCounters& MultiClientServer::GetCounters(CommandHandler* client) const {
+        return mClients[FindClient(client)]->GetCounters();
+    }
+
+    void MultiClientServer::ForwardDeviceError(const char* message,
+                                               nxtCallbackUserdata userdata) {
+        auto* self = reinterpret_cast<MultiClientServer*>(static_cast<uintptr_t>(userdata));
+
+        // Errors outside of the turn of a client can't be attributed, all clients get them.
+        if (self->mCurrentClient != nullptr) {
+            self->mCurrentClient->OnDeviceError(message);
+            return;
+        }
+        for (Client* client : self->mClients) {
+            client->OnDeviceError(message);
+        }
+    }
+
+    size_t MultiClientServer::FindClient(CommandHandler* client) const {
+        auto it = std::find(mClients.begin(), mClients.end(), client);
+        ASSERT(it != mClients.end());
+        return static_cast<size_t>(it - mClients.begin());
+    }
+
+}}  // namespace nxt::wire
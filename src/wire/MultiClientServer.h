@@ -0,0 +1,86 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef WIRE_MULTI_CLIENT_SERVER_H_
+#define WIRE_MULTI_CLIENT_SERVER_H_
+
+#include "wire/Wire.h"
+
+#include <vector>
+
+namespace nxt { namespace wire {
+
+    static constexpr size_t kDefaultClientBudget = 64 * 1024;
+
+    struct WireClientCounters {
+        // Batches are what the client's transport gives at once, usually a Flush.
+        uint64_t batchCount = 0;
+        uint64_t commandCount = 0;
+        uint64_t byteCount = 0;
+        // Time spent in the client's server, and between receiving batches and finishing them.
+        uint64_t handlingTimeNs = 0;
+        uint64_t totalLatencyNs = 0;
+        uint64_t maxLatencyNs = 0;
+        // Set when the client sent an invalid command, after which its commands are dropped.
+        bool hasError = false;
+    };
+
+    // Serves several clients with a single device, each client having its own server and thus
+    // its own object ID space. The transports of clients give their commands to the handler
+    // returned by AddClient, which queues them, and HandleRound then handles the queued commands
+    // round-robin, each client being handled at most its budget of bytes per round so that a
+    // heavy client can't starve the others. Device errors go to the client being handled.
+    //
+    // Clients using the compact encoding should be wrapped in a CompactCommandHandler in front of
+    // their handler since budgets are counted in whole native commands.
+    class MultiClientServer {
+      public:
+        MultiClientServer(nxtDevice device,
+                          const nxtProcTable& procs,
+                          size_t clientBudget = kDefaultClientBudget);
+        ~MultiClientServer();
+
+        // The return serializer and shared memory must stay alive until RemoveClient.
+        CommandHandler* AddClient(CommandSerializer* returnSerializer,
+                                  SharedMemory* sharedMemory = nullptr);
+        // Releases all the objects of the client, its queued commands are dropped.
+        void RemoveClient(CommandHandler* client);
+
+        // Gives each client with queued commands a turn, starting after the client the previous
+        // round started with, and flushes the return serializers. Returns true if commands are
+        // still queued.
+        bool HandleRound();
+        // Handles rounds until no commands are queued.
+        void HandleAllQueuedCommands();
+
+        const WireClientCounters& GetCounters(CommandHandler* client) const;
+
+      private:
+        class Client;
+
+        static void ForwardDeviceError(const char* message, nxtCallbackUserdata userdata);
+        size_t FindClient(CommandHandler* client) const;
+
+        nxtDevice mDevice;
+        nxtProcTable mProcs;
+        size_t mClientBudget;
+
+        std::vector<Client*> mClients;
+        size_t mNextFirstClient = 0;
+        Client* mCurrentClient = nullptr;
+    };
+
+}}  // namespace nxt::wire
+
+#endif  // WIRE_MULTI_CLIENT_SERVER_H_
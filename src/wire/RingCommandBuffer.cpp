@@ -0,0 +1,303 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wire/RingCommandBuffer.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace nxt { namespace wire {
+
+    // Chunks start with a header, followed by the commands unless they are stored externally.
+    // A chunk with size kWrapMarker, or the lack of space for a header, means the next chunk is
+    // at the start of the ring.
+    struct CommandRing::ChunkHeader {
+        uint64_t size;
+        uint8_t* external;
+    };
+
+    namespace {
+
+        constexpr uint64_t kWrapMarker = std::numeric_limits<uint64_t>::max();
+        constexpr uint64_t kChunkAlignment = 8;
+        constexpr size_t kMinRingSize = 4096;
+
+        uint64_t AlignOffset(uint64_t offset) {
+            return (offset + kChunkAlignment - 1) & ~(kChunkAlignment - 1);
+        }
+
+    }  // anonymous namespace
+
+    // CommandRing
+
+    CommandRing::CommandRing(size_t capacity, std::chrono::milliseconds producerTimeout)
+        : mProducerTimeout(producerTimeout),
+          mPublishedOffset(0),
+          mConsumedOffset(0),
+          mConsumerSleeping(false),
+          mError(false) {
+        mCapacity = static_cast<size_t>(AlignOffset(std::max(capacity, kMinRingSize)));
+        mMaxInlineSize = mCapacity / 4;
+        mBuffer.reset(new uint8_t[mCapacity]);
+    }
+
+    CommandRing::~CommandRing() {
+        // Free the external storage of chunks that weren't consumed.
+        CloseChunk();
+        while (mReadOffset < mWriteOffset) {
+            size_t position = static_cast<size_t>(mReadOffset % mCapacity);
+            ChunkHeader* chunk = reinterpret_cast<ChunkHeader*>(&mBuffer[position]);
+            if (mCapacity - position < sizeof(ChunkHeader) || chunk->size == kWrapMarker) {
+                mReadOffset += mCapacity - position;
+            } else if (chunk->external != nullptr) {
+                delete[] chunk->external;
+                mReadOffset += sizeof(ChunkHeader);
+            } else {
+                mReadOffset = AlignOffset(mReadOffset + sizeof(ChunkHeader) + chunk->size);
+            }
+        }
+    }
+
+    void* CommandRing::Allocate(size_t size) {
+        if (mError.load(std::memory_order_relaxed)) {
+            if (mDiscardBuffer.size() < size) {
+                mDiscardBuffer.resize(size);
+            }
+            return mDiscardBuffer.data();
+        }
+
+        bool external = size > mMaxInlineSize;
+        size_t inlineSize = external ? 0 : size;
+
+        while (true) {
+            // The open chunk can only be extended if the commands stay contiguous. A position of
+            // 0 means the open chunk ends exactly at the end of the ring.
+            size_t position = static_cast<size_t>(mWriteOffset % mCapacity);
+            bool extendChunk = !external && mOpenChunk != nullptr &&
+                               mOpenChunk->external == nullptr && position != 0 &&
+                               position + size <= mCapacity;
+            if (!extendChunk) {
+                CloseChunk();
+                position = static_cast<size_t>(mWriteOffset % mCapacity);
+            }
+
+            size_t needed = extendChunk ? size : sizeof(ChunkHeader) + inlineSize;
+            size_t padding = position + needed > mCapacity ? mCapacity - position : 0;
+
+            // Wait for the consumer if the ring is full, then look again at where the commands
+            // go as the wait closes the open chunk.
+            uint64_t endOffset = mWriteOffset + padding + needed;
+            if (endOffset - GetConsumedOffset() > mCapacity) {
+                if (!WaitForSpace(endOffset)) {
+                    return Allocate(size);
+                }
+                continue;
+            }
+
+            if (extendChunk) {
+                uint8_t* result = &mBuffer[position];
+                mOpenChunk->size += size;
+                mWriteOffset += size;
+                return result;
+            }
+
+            if (padding != 0) {
+                if (padding >= sizeof(ChunkHeader)) {
+                    ChunkHeader* wrap = reinterpret_cast<ChunkHeader*>(&mBuffer[position]);
+                    wrap->size = kWrapMarker;
+                    wrap->external = nullptr;
+                }
+                mWriteOffset += padding;
+                position = 0;
+            }
+
+            mOpenChunk = reinterpret_cast<ChunkHeader*>(&mBuffer[position]);
+            mOpenChunk->size = size;
+            mOpenChunk->external = nullptr;
+            mWriteOffset += needed;
+
+            if (external) {
+                mOpenChunk->external = new uint8_t[size];
+                return mOpenChunk->external;
+            }
+            return mOpenChunk + 1;
+        }
+    }
+
+    bool CommandRing::WaitForSpace(uint64_t endOffset) {
+        // The pending commands are published first, otherwise the consumer could be waiting
+        // for us.
+        Publish();
+
+        auto deadline = std::chrono::steady_clock::now() + mProducerTimeout;
+        while (endOffset - GetConsumedOffset() > mCapacity) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                mError.store(true);
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    void CommandRing::Publish() {
+        CloseChunk();
+        if (mPublishedOffset.load(std::memory_order_relaxed) == mWriteOffset) {
+            return;
+        }
+
+        mPublishedOffset.store(mWriteOffset);
+        if (mConsumerSleeping.load()) {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            mSleepCondition.notify_one();
+        }
+    }
+
+    bool CommandRing::HasError() const {
+        return mError.load();
+    }
+
+    bool CommandRing::HandlePublishedCommands(CommandHandler* handler) {
+        uint64_t publishedOffset = mPublishedOffset.load(std::memory_order_acquire);
+
+        bool success = true;
+        while (mReadOffset < publishedOffset) {
+            size_t position = static_cast<size_t>(mReadOffset % mCapacity);
+            ChunkHeader* chunk = reinterpret_cast<ChunkHeader*>(&mBuffer[position]);
+
+            if (mCapacity - position < sizeof(ChunkHeader) || chunk->size == kWrapMarker) {
+                mReadOffset += mCapacity - position;
+                continue;
+            }
+
+            size_t size = static_cast<size_t>(chunk->size);
+            if (chunk->external != nullptr) {
+                success &= handler->HandleCommands(chunk->external, size) != nullptr;
+                delete[] chunk->external;
+                mReadOffset += sizeof(ChunkHeader);
+            } else {
+                const uint8_t* commands = reinterpret_cast<const uint8_t*>(chunk + 1);
+                success &= handler->HandleCommands(commands, size) != nullptr;
+                mReadOffset = AlignOffset(mReadOffset + sizeof(ChunkHeader) + size);
+            }
+
+            // Give the space back to the producer as soon as possible.
+            mConsumedOffset.store(mReadOffset, std::memory_order_release);
+        }
+
+        return success;
+    }
+
+    bool CommandRing::WaitForPublishedCommands(std::chrono::microseconds timeout) {
+        if (mPublishedOffset.load(std::memory_order_acquire) != mReadOffset) {
+            return true;
+        }
+
+        // Setting mConsumerSleeping before checking the published offset again guarantees that
+        // either we see the new offset, or the producer sees that we sleep and wakes us up.
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mConsumerSleeping.store(true);
+        if (mPublishedOffset.load() == mReadOffset) {
+            mSleepCondition.wait_for(lock, timeout);
+        }
+        mConsumerSleeping.store(false);
+
+        return mPublishedOffset.load(std::memory_order_acquire) != mReadOffset;
+    }
+
+    void CommandRing::Notify() {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mSleepCondition.notify_one();
+    }
+
+    void CommandRing::CloseChunk() {
+        if (mOpenChunk == nullptr) {
+            return;
+        }
+        mOpenChunk = nullptr;
+        mWriteOffset = AlignOffset(mWriteOffset);
+    }
+
+    uint64_t CommandRing::GetConsumedOffset() {
+        return mConsumedOffset.load(std::memory_order_acquire);
+    }
+
+    // RingCommandSerializer
+
+    RingCommandSerializer::RingCommandSerializer(CommandRing* ring) : mRing(ring) {
+    }
+
+    void* RingCommandSerializer::GetCmdSpace(size_t size) {
+        return mRing->Allocate(size);
+    }
+
+    void RingCommandSerializer::Flush() {
+        mRing->Publish();
+    }
+
+    // ThreadedServer
+
+    ThreadedServer::ThreadedServer(nxtDevice device,
+                                   const nxtProcTable& procs,
+                                   SharedMemory* sharedMemory,
+                                   size_t ringSize)
+        : mDevice(device),
+          mProcs(procs),
+          mC2sRing(ringSize),
+          mS2cRing(ringSize),
+          mC2sSerializer(&mC2sRing),
+          mS2cSerializer(&mS2cRing),
+          mServer(NewServerCommandHandler(device, procs, &mS2cSerializer, sharedMemory)),
+          mStopping(false) {
+        mThread = std::thread(&ThreadedServer::ServerLoop, this);
+    }
+
+    ThreadedServer::~ThreadedServer() {
+        // Let the server handle the last commands of the client, like object releases.
+        mC2sSerializer.Flush();
+        mStopping.store(true);
+        mC2sRing.Notify();
+        mThread.join();
+    }
+
+    CommandSerializer* ThreadedServer::GetClientSerializer() {
+        return &mC2sSerializer;
+    }
+
+    bool ThreadedServer::HandleReturnCommands(CommandHandler* client) {
+        bool success = mS2cRing.HandlePublishedCommands(client);
+        return success && !mC2sRing.HasError() && !mS2cRing.HasError();
+    }
+
+    void ThreadedServer::ServerLoop() {
+        while (true) {
+            // Commands published before the destructor set mStopping are handled below.
+            bool stopping = mStopping.load();
+
+            if (mC2sRing.WaitForPublishedCommands(std::chrono::milliseconds(1))) {
+                mC2sRing.HandlePublishedCommands(mServer.get());
+            } else if (!stopping) {
+                // Tick the device while the client is idle so that asynchronous operations like
+                // MapReadAsync still complete.
+                mProcs.deviceTick(mDevice);
+            }
+            mS2cSerializer.Flush();
+
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+}}  // namespace nxt::wire
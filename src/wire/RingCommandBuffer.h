@@ -0,0 +1,141 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef WIRE_RING_COMMAND_BUFFER_H_
+#define WIRE_RING_COMMAND_BUFFER_H_
+
+#include "wire/Wire.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nxt { namespace wire {
+
+    // CommandRing is a single-producer single-consumer ring buffer of commands. The producer
+    // serializes commands directly in the ring and publishes them, after which the consumer sees
+    // them as chunks that it gives to a CommandHandler. Commands never straddle the end of the
+    // ring, and commands too large for the ring are stored in a separate heap allocation that is
+    // referenced from the ring.
+    //
+    // Only the offsets of published / consumed data are shared between the threads, using
+    // acquire / release atomics. A mutex is only used to put the consumer to sleep when the ring
+    // is empty.
+    //
+    // A producer that waits for space longer than the producer timeout gives up, as the consumer
+    // may itself be blocked producing in a full ring going the other way. The ring is then in
+    // error and all commands are dropped, like on a closed socket.
+    class CommandRing {
+      public:
+        CommandRing(size_t capacity,
+                    std::chrono::milliseconds producerTimeout = std::chrono::seconds(10));
+        ~CommandRing();
+
+        // Producer side. Allocate blocks while the ring is full, up to the producer timeout.
+        void* Allocate(size_t size);
+        void Publish();
+        bool HasError() const;
+
+        // Consumer side. HandlePublishedCommands returns false if the handler rejected any of
+        // the chunks. WaitForPublishedCommands returns false if there is nothing to consume after
+        // the timeout, or after a call to Notify.
+        bool HandlePublishedCommands(CommandHandler* handler);
+        bool WaitForPublishedCommands(std::chrono::microseconds timeout);
+        void Notify();
+
+      private:
+        struct ChunkHeader;
+
+        void CloseChunk();
+        uint64_t GetConsumedOffset();
+
+        bool WaitForSpace(uint64_t endOffset);
+
+        size_t mCapacity;
+        size_t mMaxInlineSize;
+        std::chrono::milliseconds mProducerTimeout;
+        std::unique_ptr<uint8_t[]> mBuffer;
+
+        // Owned by the producer. Commands written after an error go to the discard buffer.
+        uint64_t mWriteOffset = 0;
+        ChunkHeader* mOpenChunk = nullptr;
+        std::vector<uint8_t> mDiscardBuffer;
+
+        // Owned by the consumer.
+        uint64_t mReadOffset = 0;
+
+        // Shared between the producer and the consumer.
+        std::atomic<uint64_t> mPublishedOffset;
+        std::atomic<uint64_t> mConsumedOffset;
+        std::atomic<bool> mConsumerSleeping;
+        std::atomic<bool> mError;
+        std::mutex mSleepMutex;
+        std::condition_variable mSleepCondition;
+    };
+
+    class RingCommandSerializer : public CommandSerializer {
+      public:
+        RingCommandSerializer(CommandRing* ring);
+
+        void* GetCmdSpace(size_t size) override;
+        void Flush() override;
+
+      private:
+        CommandRing* mRing;
+    };
+
+    static constexpr size_t kDefaultCommandRingSize = 16 << 20;
+
+    // Runs the wire server for a device on its own thread. The client serializes commands in
+    // a ring that the server thread consumes, and the server answers in a second ring that must
+    // be drained regularly on the client thread with HandleReturnCommands.
+    class ThreadedServer {
+      public:
+        ThreadedServer(nxtDevice device,
+                       const nxtProcTable& procs,
+                       SharedMemory* sharedMemory = nullptr,
+                       size_t ringSize = kDefaultCommandRingSize);
+        ~ThreadedServer();
+
+        // The serializer to give to NewClientDevice, along with the same shared memory.
+        CommandSerializer* GetClientSerializer();
+
+        // Handles the return commands received so far, calling the client's callbacks. Returns
+        // false if a handler failed, or if one of the rings timed out waiting for space in which
+        // case commands were dropped.
+        bool HandleReturnCommands(CommandHandler* client);
+
+      private:
+        void ServerLoop();
+
+        nxtDevice mDevice;
+        nxtProcTable mProcs;
+
+        CommandRing mC2sRing;
+        CommandRing mS2cRing;
+        RingCommandSerializer mC2sSerializer;
+        RingCommandSerializer mS2cSerializer;
+        std::unique_ptr<CommandHandler> mServer;
+
+        std::atomic<bool> mStopping;
+        std::thread mThread;
+    };
+
+}}  // namespace nxt::wire
+
+#endif  // WIRE_RING_COMMAND_BUFFER_H_
@@ -0,0 +1,188 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wire/SharedMemory.h"
+
+#include "common/Assert.h"
+#include "wire/WireCmd.h"
+
+#include <algorithm>
+#include <iterator>
+
+#if defined(NXT_PLATFORM_POSIX)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace nxt { namespace wire {
+
+    // InProcessSharedMemory
+
+    InProcessSharedMemory::InProcessSharedMemory(size_t size)
+        : mData(new uint8_t[size]), mSize(size) {
+    }
+
+    uint8_t* InProcessSharedMemory::GetData() {
+        return mData.get();
+    }
+
+    size_t InProcessSharedMemory::GetSize() const {
+        return mSize;
+    }
+
+#if defined(NXT_PLATFORM_POSIX)
+    // PosixSharedMemory
+
+    // static
+    PosixSharedMemory* PosixSharedMemory::Create(const char* name, size_t size) {
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(fd);
+            shm_unlink(name);
+            return nullptr;
+        }
+
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            shm_unlink(name);
+            return nullptr;
+        }
+
+        return new PosixSharedMemory(name, static_cast<uint8_t*>(data), size, true);
+    }
+
+    // static
+    PosixSharedMemory* PosixSharedMemory::Open(const char* name, size_t size) {
+        int fd = shm_open(name, O_RDWR, 0);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        // Don't trust the size we are told, mapping past the end of the object would crash.
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < size) {
+            close(fd);
+            return nullptr;
+        }
+
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            return nullptr;
+        }
+
+        return new PosixSharedMemory(name, static_cast<uint8_t*>(data), size, false);
+    }
+
+    PosixSharedMemory::PosixSharedMemory(const char* name,
+                                         uint8_t* data,
+                                         size_t size,
+                                         bool isOwner)
+        : mName(name), mData(data), mSize(size), mIsOwner(isOwner) {
+    }
+
+    PosixSharedMemory::~PosixSharedMemory() {
+        munmap(mData, mSize);
+        if (mIsOwner) {
+            shm_unlink(mName.c_str());
+        }
+    }
+
+    uint8_t* PosixSharedMemory::GetData() {
+        return mData;
+    }
+
+    size_t PosixSharedMemory::GetSize() const {
+        return mSize;
+    }
+#endif  // defined(NXT_PLATFORM_POSIX)
+
+    // SharedMemoryAllocator
+
+    namespace {
+
+        constexpr uint32_t kAllocationAlignment = 16;
+
+    }  // anonymous namespace
+
+    SharedMemoryAllocator::SharedMemoryAllocator(size_t size) {
+        // Offsets are 32bit with the last value reserved for kNoSharedMemoryOffset.
+        size = std::min(size, static_cast<size_t>(kNoSharedMemoryOffset - 1));
+        uint32_t usableSize = static_cast<uint32_t>(size) & ~(kAllocationAlignment - 1);
+        if (usableSize != 0) {
+            mFreeRanges[0] = usableSize;
+        }
+    }
+
+    uint32_t SharedMemoryAllocator::Allocate(uint32_t size) {
+        if (size == 0 || size > kNoSharedMemoryOffset - kAllocationAlignment) {
+            return kNoSharedMemoryOffset;
+        }
+        size = (size + kAllocationAlignment - 1) & ~(kAllocationAlignment - 1);
+
+        // First-fit is enough as only a handful of readbacks and uploads are in flight at a time.
+        for (auto it = mFreeRanges.begin(); it != mFreeRanges.end(); ++it) {
+            if (it->second < size) {
+                continue;
+            }
+
+            uint32_t offset = it->first;
+            uint32_t remaining = it->second - size;
+            mFreeRanges.erase(it);
+            if (remaining != 0) {
+                mFreeRanges[offset + size] = remaining;
+            }
+
+            mAllocations[offset] = size;
+            return offset;
+        }
+
+        return kNoSharedMemoryOffset;
+    }
+
+    void SharedMemoryAllocator::Free(uint32_t offset) {
+        auto allocation = mAllocations.find(offset);
+        ASSERT(allocation != mAllocations.end());
+        uint32_t size = allocation->second;
+        mAllocations.erase(allocation);
+
+        // Merge with the free ranges directly after and before this one.
+        auto next = mFreeRanges.find(offset + size);
+        if (next != mFreeRanges.end()) {
+            size += next->second;
+            mFreeRanges.erase(next);
+        }
+
+        auto inserted = mFreeRanges.emplace(offset, size).first;
+        if (inserted != mFreeRanges.begin()) {
+            auto previous = std::prev(inserted);
+            if (previous->first + previous->second == offset) {
+                previous->second += size;
+                mFreeRanges.erase(inserted);
+            }
+        }
+    }
+
+    bool SharedMemoryAllocator::IsAllocated(uint32_t offset) const {
+        return mAllocations.count(offset) != 0;
+    }
+
+}}  // namespace nxt::wire
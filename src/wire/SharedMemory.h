@@ -0,0 +1,81 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef WIRE_SHAREDMEMORY_H_
+#define WIRE_SHAREDMEMORY_H_
+
+#include "common/Platform.h"
+#include "wire/Wire.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace nxt { namespace wire {
+
+    // Shared memory for a client and server living in the same process.
+    class InProcessSharedMemory : public SharedMemory {
+      public:
+        InProcessSharedMemory(size_t size);
+
+        uint8_t* GetData() override;
+        size_t GetSize() const override;
+
+      private:
+        std::unique_ptr<uint8_t[]> mData;
+        size_t mSize;
+    };
+
+#if defined(NXT_PLATFORM_POSIX)
+    // A named POSIX shared memory object. The process that creates it removes the name when it
+    // is destroyed. Both functions return nullptr on failure.
+    class PosixSharedMemory : public SharedMemory {
+      public:
+        static PosixSharedMemory* Create(const char* name, size_t size);
+        static PosixSharedMemory* Open(const char* name, size_t size);
+        ~PosixSharedMemory();
+
+        uint8_t* GetData() override;
+        size_t GetSize() const override;
+
+      private:
+        PosixSharedMemory(const char* name, uint8_t* data, size_t size, bool isOwner);
+
+        std::string mName;
+        uint8_t* mData;
+        size_t mSize;
+        bool mIsOwner;
+    };
+#endif  // defined(NXT_PLATFORM_POSIX)
+
+    // Sub-allocates ranges of a shared memory region, used by the client to choose where the
+    // server writes each readback and where it puts bulk uploads.
+    class SharedMemoryAllocator {
+      public:
+        SharedMemoryAllocator(size_t size);
+
+        // Returns kNoSharedMemoryOffset when there isn't enough contiguous space.
+        uint32_t Allocate(uint32_t size);
+        void Free(uint32_t offset);
+        bool IsAllocated(uint32_t offset) const;
+
+      private:
+        // Both map the offset of ranges to their size.
+        std::map<uint32_t, uint32_t> mFreeRanges;
+        std::map<uint32_t, uint32_t> mAllocations;
+    };
+
+}}  // namespace nxt::wire
+
+#endif  // WIRE_SHAREDMEMORY_H_
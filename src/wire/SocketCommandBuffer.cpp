@@ -0,0 +1,316 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wire/SocketCommandBuffer.h"
+
+#include "wire/CompactCommandBuffer.h"
+#include "wire/SharedMemory.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+
+namespace nxt { namespace wire {
+
+    namespace {
+
+#if defined(MSG_NOSIGNAL)
+        constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+        constexpr int kSendFlags = 0;
+#endif
+
+        bool WriteAll(int fd, const uint8_t* data, size_t size) {
+            while (size > 0) {
+                ssize_t written = send(fd, data, size, kSendFlags);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data += written;
+                size -= static_cast<size_t>(written);
+            }
+            return true;
+        }
+
+        bool ReadAll(int fd, uint8_t* data, size_t size) {
+            while (size > 0) {
+                ssize_t result = recv(fd, data, size, 0);
+                if (result < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (result <= 0) {
+                    return false;
+                }
+                data += result;
+                size -= static_cast<size_t>(result);
+            }
+            return true;
+        }
+
+        bool MakeUnixAddress(const char* path, sockaddr_un* address) {
+            memset(address, 0, sizeof(*address));
+            address->sun_family = AF_UNIX;
+            if (strlen(path) >= sizeof(address->sun_path)) {
+                return false;
+            }
+            strncpy(address->sun_path, path, sizeof(address->sun_path) - 1);
+            return true;
+        }
+
+    }  // anonymous namespace
+
+    // SocketCommandSerializer
+
+    SocketCommandSerializer::SocketCommandSerializer(int fd, size_t batchSize)
+        : mFd(fd), mBuffer(batchSize) {
+    }
+
+    void* SocketCommandSerializer::GetCmdSpace(size_t size) {
+        if (size > kMaxSocketFrameSize) {
+            return nullptr;
+        }
+
+        // Commands are never split between frames: send what we have and start a new batch.
+        // Growing the buffer is only done when it is empty so no pointer into it is invalidated.
+        if (mOffset + size > mBuffer.size()) {
+            Flush();
+            if (size > mBuffer.size()) {
+                mBuffer.resize(size);
+            }
+        }
+
+        uint8_t* result = &mBuffer[mOffset];
+        mOffset += size;
+        return result;
+    }
+
+    void SocketCommandSerializer::Flush() {
+        if (mOffset == 0) {
+            return;
+        }
+
+        if (!mError) {
+            SocketFrameHeader header;
+            header.size = static_cast<uint32_t>(mOffset);
+
+            mError = !WriteAll(mFd, reinterpret_cast<const uint8_t*>(&header), sizeof(header)) ||
+                     !WriteAll(mFd, mBuffer.data(), mOffset);
+        }
+        mOffset = 0;
+    }
+
+    bool SocketCommandSerializer::HasError() const {
+        return mError;
+    }
+
+    // SocketCommandReceiver
+
+    SocketCommandReceiver::SocketCommandReceiver(int fd, CommandHandler* handler)
+        : mFd(fd), mHandler(handler) {
+    }
+
+    bool SocketCommandReceiver::HandleNextFrame() {
+        SocketFrameHeader header;
+        if (!ReadAll(mFd, reinterpret_cast<uint8_t*>(&header), sizeof(header))) {
+            return false;
+        }
+
+        if (header.size > kMaxSocketFrameSize) {
+            return false;
+        }
+
+        // The frame storage is reused between frames so that steady state doesn't allocate.
+        if (mFrame.size() < header.size) {
+            mFrame.resize(header.size);
+        }
+        if (!ReadAll(mFd, mFrame.data(), header.size)) {
+            return false;
+        }
+
+        return mHandler->HandleCommands(mFrame.data(), header.size) != nullptr;
+    }
+
+    bool SocketCommandReceiver::HandleAvailableFrames() {
+        while (WaitForData(0)) {
+            if (!HandleNextFrame()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SocketCommandReceiver::WaitForData(int timeoutMs) {
+        pollfd pfd;
+        pfd.fd = mFd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int result;
+        do {
+            result = poll(&pfd, 1, timeoutMs);
+        } while (result < 0 && errno == EINTR);
+
+        // A hang-up is reported as readable so that the next read notices the disconnection.
+        return result > 0 && (pfd.revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+    }
+
+    // Unix-domain socket helpers
+
+    int ListenOnUnixSocket(const char* path) {
+        sockaddr_un address;
+        if (!MakeUnixAddress(path, &address)) {
+            return -1;
+        }
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+
+        unlink(path);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(fd, 1) != 0) {
+            close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+
+    int AcceptOnUnixSocket(int listenFd) {
+        int fd;
+        do {
+            fd = accept(listenFd, nullptr, nullptr);
+        } while (fd < 0 && errno == EINTR);
+        return fd;
+    }
+
+    int ConnectToUnixSocket(const char* path) {
+        sockaddr_un address;
+        if (!MakeUnixAddress(path, &address)) {
+            return -1;
+        }
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+
+    void CloseSocket(int fd) {
+        close(fd);
+    }
+
+    bool SendSocketHandshake(int fd,
+                             const char* sharedMemoryName,
+                             size_t sharedMemorySize,
+                             bool* sharedMemoryOpened,
+                             WireEncoding wireEncoding) {
+        SocketHandshake handshake;
+        memset(&handshake, 0, sizeof(handshake));
+        handshake.wireEncoding = wireEncoding;
+        if (sharedMemoryName != nullptr) {
+            if (strlen(sharedMemoryName) >= sizeof(handshake.sharedMemoryName)) {
+                return false;
+            }
+            strncpy(handshake.sharedMemoryName, sharedMemoryName,
+                    sizeof(handshake.sharedMemoryName) - 1);
+            handshake.sharedMemorySize = sharedMemorySize;
+        }
+
+        SocketHandshakeReply reply;
+        if (!WriteAll(fd, reinterpret_cast<const uint8_t*>(&handshake), sizeof(handshake)) ||
+            !ReadAll(fd, reinterpret_cast<uint8_t*>(&reply), sizeof(reply))) {
+            return false;
+        }
+
+        *sharedMemoryOpened = reply.sharedMemoryOpened != 0;
+        return true;
+    }
+
+    void ServeSocketConnection(int fd, nxtDevice device, const nxtProcTable& procs) {
+        SocketHandshake handshake;
+        if (!ReadAll(fd, reinterpret_cast<uint8_t*>(&handshake), sizeof(handshake))) {
+            return;
+        }
+        handshake.sharedMemoryName[sizeof(handshake.sharedMemoryName) - 1] = '\0';
+
+        // Tell the client whether the shared memory could be opened, so that it falls back to
+        // sending all data in the command stream if it couldn't.
+        std::unique_ptr<SharedMemory> sharedMemory;
+        if (handshake.sharedMemoryName[0] != '\0') {
+            sharedMemory.reset(PosixSharedMemory::Open(
+                handshake.sharedMemoryName, static_cast<size_t>(handshake.sharedMemorySize)));
+        }
+
+        SocketHandshakeReply reply;
+        reply.sharedMemoryOpened = sharedMemory != nullptr ? 1 : 0;
+        if (!WriteAll(fd, reinterpret_cast<const uint8_t*>(&reply), sizeof(reply))) {
+            return;
+        }
+
+        SocketCommandSerializer s2cBuf(fd);
+        std::unique_ptr<CommandHandler> server(
+            NewServerCommandHandler(device, procs, &s2cBuf, sharedMemory.get()));
+
+        // Only the client to server stream uses the compact encoding, return commands are rare.
+        std::unique_ptr<CommandHandler> decoder;
+        CommandHandler* handler = server.get();
+        switch (handshake.wireEncoding) {
+            case WireEncoding::Native:
+                break;
+            case WireEncoding::Compact:
+            case WireEncoding::CompactCompressed:
+                decoder.reset(new CompactCommandHandler(server.get()));
+                handler = decoder.get();
+                break;
+            default:
+                return;
+        }
+        SocketCommandReceiver c2sBuf(fd, handler);
+
+        while (!s2cBuf.HasError()) {
+            // When the client is idle, still tick the device so that asynchronous operations
+            // like MapReadAsync get a chance to complete and send their results back.
+            if (!c2sBuf.WaitForData(1)) {
+                procs.deviceTick(device);
+                s2cBuf.Flush();
+                continue;
+            }
+
+            // Handle everything that's queued before answering, so that replies get batched too.
+            bool connected = c2sBuf.HandleNextFrame() && c2sBuf.HandleAvailableFrames();
+            s2cBuf.Flush();
+            if (!connected) {
+                return;
+            }
+        }
+    }
+
+}}  // namespace nxt::wire
@@ -0,0 +1,110 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef WIRE_SOCKET_COMMAND_BUFFER_H_
+#define WIRE_SOCKET_COMMAND_BUFFER_H_
+
+#include <vector>
+
+#include "wire/CompactEncoding.h"
+#include "wire/Wire.h"
+
+namespace nxt { namespace wire {
+
+    // Commands going over a socket are batched in frames, each of which is made of a header
+    // followed by frame.size bytes of commands. A frame is sent on each Flush, or when the batch
+    // would grow past its capacity. Writes to the socket are blocking so a sender that outpaces
+    // the receiver is throttled by the kernel's socket buffer: this is the backpressure mechanism.
+    struct SocketFrameHeader {
+        uint32_t size;
+    };
+
+    // The first message of a connection, sent by the client to negotiate the shared memory used
+    // for readbacks and uploads, and the encoding of the commands it sends. An empty name means
+    // all data is sent in the command stream.
+    struct SocketHandshake {
+        char sharedMemoryName[64];
+        uint64_t sharedMemorySize;
+        WireEncoding wireEncoding;
+    };
+
+    // The answer of the server to the handshake. The client must only use its shared memory if
+    // the server could open it, otherwise it puts all data in the command stream.
+    struct SocketHandshakeReply {
+        uint32_t sharedMemoryOpened;
+    };
+
+    static constexpr size_t kDefaultSocketBatchSize = 1 << 20;
+    static constexpr size_t kMaxSocketFrameSize = 256 << 20;
+
+    class SocketCommandSerializer : public CommandSerializer {
+      public:
+        SocketCommandSerializer(int fd, size_t batchSize = kDefaultSocketBatchSize);
+
+        void* GetCmdSpace(size_t size) override;
+        void Flush() override;
+
+        // Set when the connection was closed or a write failed, after which all commands are
+        // dropped.
+        bool HasError() const;
+
+      private:
+        int mFd;
+        bool mError = false;
+        size_t mOffset = 0;
+        std::vector<uint8_t> mBuffer;
+    };
+
+    class SocketCommandReceiver {
+      public:
+        SocketCommandReceiver(int fd, CommandHandler* handler);
+
+        // Blocks until a frame is received and hands it to the handler. Returns false if the
+        // connection was closed or the handler rejected the commands.
+        bool HandleNextFrame();
+
+        // Handles all the frames that can be read without blocking. Returns false on errors
+        // like HandleNextFrame.
+        bool HandleAvailableFrames();
+
+        // Waits at most timeoutMs for data to become readable.
+        bool WaitForData(int timeoutMs);
+
+      private:
+        int mFd;
+        CommandHandler* mHandler;
+        std::vector<uint8_t> mFrame;
+    };
+
+    // Helpers to create local Unix-domain socket connections, return -1 on failure.
+    int ListenOnUnixSocket(const char* path);
+    int AcceptOnUnixSocket(int listenFd);
+    int ConnectToUnixSocket(const char* path);
+    void CloseSocket(int fd);
+
+    // Sends the handshake and waits for the reply of the server. The client must then give the
+    // shared memory to NewClientDevice only if sharedMemoryOpened is set to true, and wrap its
+    // serializer in a CompactCommandSerializer unless the encoding is Native.
+    bool SendSocketHandshake(int fd,
+                             const char* sharedMemoryName,
+                             size_t sharedMemorySize,
+                             bool* sharedMemoryOpened,
+                             WireEncoding wireEncoding = WireEncoding::Native);
+
+    // Runs a wire server for device on the connection until the client disconnects.
+    void ServeSocketConnection(int fd, nxtDevice device, const nxtProcTable& procs);
+
+}}  // namespace nxt::wire
+
+#endif  // WIRE_SOCKET_COMMAND_BUFFER_H_
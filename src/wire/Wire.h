@@ -15,6 +15,7 @@
 #ifndef WIRE_WIRE_H_
 #define WIRE_WIRE_H_
 
+#include <cstddef>
 #include <cstdint>
 
 #include "nxt/nxt.h"
@@ -34,12 +35,52 @@ namespace nxt { namespace wire {
         virtual const uint8_t* HandleCommands(const uint8_t* commands, size_t size) = 0;
     };
 
+    // Memory mapped in both the client and the server. When both sides are given one, the
+    // server writes the data of successful MapReadAsync directly in it instead of sending it
+    // in the command stream, and the client gives the application a pointer inside it. The
+    // client also puts large arrays marked as "bulk" in next.json there, like SetSubData data.
+    class SharedMemory {
+      public:
+        virtual ~SharedMemory() = default;
+        virtual uint8_t* GetData() = 0;
+        virtual size_t GetSize() const = 0;
+    };
+
     CommandHandler* NewClientDevice(nxtProcTable* procs,
                                     nxtDevice* device,
-                                    CommandSerializer* serializer);
+                                    CommandSerializer* serializer,
+                                    SharedMemory* sharedMemory = nullptr);
+
+    // Calls to recorded objects, like command buffer builders, are kept by the client returned by
+    // NewClientDevice until its next command that isn't recorded. ClientFlush serializes them
+    // and then flushes the client's serializer, so that all the calls made so far are sent.
+    void ClientFlush(CommandHandler* client);
+
     CommandHandler* NewServerCommandHandler(nxtDevice device,
                                             const nxtProcTable& procs,
-                                            CommandSerializer* serializer);
+                                            CommandSerializer* serializer,
+                                            SharedMemory* sharedMemory = nullptr);
+
+    // Servers Tick their device each time they are given commands. This handles the commands
+    // of a server returned by NewServerCommandHandler or NewSharedDeviceServer without that Tick,
+    // for callers that choose when the device is ticked, like nxt_replay.
+    const uint8_t* ServerHandleCommandsWithoutTick(CommandHandler* server,
+                                                   const uint8_t* commands,
+                                                   size_t size);
+
+    // A server for one of the clients of a device shared with other servers, see
+    // MultiClientServer.h. It holds a reference to the device and releases the objects of its
+    // client when deleted. The device error callback is left to the owner of the device, which
+    // gives the errors to the right server with OnDeviceError.
+    class SharedDeviceServer : public CommandHandler {
+      public:
+        virtual void OnDeviceError(const char* message) = 0;
+    };
+
+    SharedDeviceServer* NewSharedDeviceServer(nxtDevice device,
+                                              const nxtProcTable& procs,
+                                              CommandSerializer* serializer,
+                                              SharedMemory* sharedMemory = nullptr);
 
 }}  // namespace nxt::wire
 
@@ -14,6 +14,8 @@
 
 #include "wire/WireCmd.h"
 
+#include "wire/CompactEncoding.h"
+
 namespace nxt { namespace wire {
 
     size_t ReturnDeviceErrorCallbackCmd::GetRequiredSize() const {
@@ -32,6 +34,22 @@ namespace nxt { namespace wire {
         return sizeof(*this);
     }
 
+    void BufferMapReadAsyncCmd::Encode(CompactWriter* writer) const {
+        writer->WriteId(bufferId);
+        writer->Write(requestSerial);
+        writer->Write(start);
+        writer->Write(size);
+        writer->Write(sharedMemoryOffset);
+    }
+
+    void BufferMapReadAsyncCmd::Decode(CompactReader* reader) {
+        reader->ReadId(&bufferId);
+        reader->Read(&requestSerial);
+        reader->Read(&start);
+        reader->Read(&size);
+        reader->Read(&sharedMemoryOffset);
+    }
+
     size_t ReturnBufferMapReadAsyncCallbackCmd::GetRequiredSize() const {
         return sizeof(*this) + dataLength;
     }
@@ -44,4 +62,26 @@ namespace nxt { namespace wire {
         return this + 1;
     }
 
+    size_t ReturnBulkDataConsumedCmd::GetRequiredSize() const {
+        return sizeof(*this);
+    }
+
+    size_t FenceOnCompletionCmd::GetRequiredSize() const {
+        return sizeof(*this);
+    }
+
+    void FenceOnCompletionCmd::Encode(CompactWriter* writer) const {
+        writer->WriteId(fenceId);
+        writer->Write(value);
+    }
+
+    void FenceOnCompletionCmd::Decode(CompactReader* reader) {
+        reader->ReadId(&fenceId);
+        reader->Read(&value);
+    }
+
+    size_t ReturnFenceUpdateCompletedValueCmd::GetRequiredSize() const {
+        return sizeof(*this);
+    }
+
 }}  // namespace nxt::wire
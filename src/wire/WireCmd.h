@@ -17,8 +17,12 @@
 
 #include "wire/WireCmd_autogen.h"
 
+#include <limits>
+
 namespace nxt { namespace wire {
 
+    static constexpr uint32_t kNoSharedMemoryOffset = std::numeric_limits<uint32_t>::max();
+
     struct ReturnDeviceErrorCallbackCmd {
         wire::ReturnWireCmd commandId = ReturnWireCmd::DeviceErrorCallback;
 
@@ -37,7 +41,12 @@ namespace nxt { namespace wire {
         uint32_t start;
         uint32_t size;
 
+        // Where the server should write the data in the shared memory, if any.
+        uint32_t sharedMemoryOffset;
+
         size_t GetRequiredSize() const;
+        void Encode(CompactWriter* writer) const;
+        void Decode(CompactReader* reader);
     };
 
     struct ReturnBufferMapReadAsyncCallbackCmd {
@@ -49,11 +58,48 @@ namespace nxt { namespace wire {
         uint32_t status;
         uint32_t dataLength;
 
+        // The offset of the request is always echoed so that the client can reclaim the space.
+        // When isDataInSharedMemory is set, the data is there instead of after the command.
+        uint32_t sharedMemoryOffset;
+        bool isDataInSharedMemory;
+
         size_t GetRequiredSize() const;
         void* GetData();
         const void* GetData() const;
     };
 
+    // Asks the server to tell the client when the fence reaches the value, sent after each
+    // QueueSignal so that the client can track the completed value of its fences.
+    struct FenceOnCompletionCmd {
+        wire::WireCmd commandId = WireCmd::FenceOnCompletion;
+
+        uint32_t fenceId;
+        uint64_t value;
+
+        size_t GetRequiredSize() const;
+        void Encode(CompactWriter* writer) const;
+        void Decode(CompactReader* reader);
+    };
+
+    struct ReturnFenceUpdateCompletedValueCmd {
+        wire::ReturnWireCmd commandId = ReturnWireCmd::FenceUpdateCompletedValue;
+
+        uint32_t fenceId;
+        uint32_t fenceSerial;
+        uint64_t value;
+
+        size_t GetRequiredSize() const;
+    };
+
+    // Tells the client that the server is done with bulk data it put in the shared memory.
+    struct ReturnBulkDataConsumedCmd {
+        wire::ReturnWireCmd commandId = ReturnWireCmd::BulkDataConsumed;
+
+        uint32_t sharedMemoryOffset;
+
+        size_t GetRequiredSize() const;
+    };
+
 }}  // namespace nxt::wire
 
 #endif  // WIRE_WIRECMD_H_
@@ -0,0 +1,313 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// nxt_replay feeds a wire trace captured with TracingCommandSerializer to a wire server on any
+// backend and reports how much CPU time the server spent on each record and command type. The
+// records, one per Flush of the client, are what is called a frame in the report.
+
+#include "utils/BackendBinding.h"
+#include "utils/SystemUtils.h"
+#include "wire/WireCmd.h"
+#include "wire/WireTrace.h"
+
+#include <nxt/nxt.h>
+#include "GLFW/glfw3.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+    // The return commands of the server aren't needed for the replay.
+    class DiscardingSerializer : public nxt::wire::CommandSerializer {
+      public:
+        void* GetCmdSpace(size_t size) override {
+            if (mBuffer.size() < size) {
+                mBuffer.resize(size);
+            }
+            return mBuffer.data();
+        }
+        void Flush() override {
+        }
+
+      private:
+        std::vector<uint8_t> mBuffer;
+    };
+
+    struct CommandCost {
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+    };
+
+    uint64_t NanosecondsSince(std::chrono::steady_clock::time_point start) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    // Swapchain implementations are pointers in the capturing process, use the one of the
+    // replay's binding instead.
+    void PatchSwapChainImplementations(uint8_t* commands,
+                                       size_t size,
+                                       uint64_t swapChainImplementation) {
+        while (size > 0) {
+            size_t cmdSize = nxt::wire::GetWireCmdSize(commands, size);
+            if (cmdSize == 0) {
+                return;
+            }
+
+            auto cmdId = *reinterpret_cast<nxt::wire::WireCmd*>(commands);
+            if (cmdId == nxt::wire::WireCmd::SwapChainBuilderSetImplementation) {
+                auto* cmd =
+                    reinterpret_cast<nxt::wire::SwapChainBuilderSetImplementationCmd*>(commands);
+                cmd->implementation = swapChainImplementation;
+            }
+
+            commands += cmdSize;
+            size -= cmdSize;
+        }
+    }
+
+    void PrintUsage(FILE* file, const char* program) {
+        fprintf(file, "Usage: %s [-b BACKEND] [--original-pacing] [--print-frames] TRACE\n",
+                program);
+        fprintf(file, "  BACKEND is one of: d3d12, metal, null, opengl, vulkan\n");
+        fprintf(file, "  --original-pacing waits for the capture's time between frames\n");
+        fprintf(file, "  --print-frames prints the CPU time of each frame\n");
+    }
+
+    void PrintFrameReport(std::vector<uint64_t> frameTimesNs) {
+        if (frameTimesNs.empty()) {
+            printf("No frames were replayed\n");
+            return;
+        }
+
+        uint64_t totalNs = 0;
+        for (uint64_t frameTimeNs : frameTimesNs) {
+            totalNs += frameTimeNs;
+        }
+        std::sort(frameTimesNs.begin(), frameTimesNs.end());
+
+        auto percentile = [&frameTimesNs](size_t percent) {
+            size_t index = (frameTimesNs.size() - 1) * percent / 100;
+            return frameTimesNs[index] / 1000.0;
+        };
+
+        printf("Frames: %zu, total CPU time %.3f ms\n", frameTimesNs.size(), totalNs / 1e6);
+        printf("Frame CPU time (us): average %.1f, median %.1f, p90 %.1f, p99 %.1f, max %.1f\n",
+               totalNs / 1000.0 / frameTimesNs.size(), percentile(50), percentile(90),
+               percentile(99), frameTimesNs.back() / 1000.0);
+    }
+
+    void PrintCommandReport(const std::map<nxt::wire::WireCmd, CommandCost>& costs) {
+        std::vector<std::pair<nxt::wire::WireCmd, CommandCost>> sortedCosts(costs.begin(),
+                                                                           costs.end());
+        std::sort(sortedCosts.begin(), sortedCosts.end(), [](const auto& a, const auto& b) {
+            return a.second.totalNs > b.second.totalNs;
+        });
+
+        printf("%-50s %10s %12s %10s\n", "Command", "Count", "Total (us)", "Avg (ns)");
+        for (const auto& cost : sortedCosts) {
+            printf("%-50s %10llu %12.1f %10llu\n", nxt::wire::GetWireCmdName(cost.first),
+                   static_cast<unsigned long long>(cost.second.count),
+                   cost.second.totalNs / 1000.0,
+                   static_cast<unsigned long long>(cost.second.totalNs / cost.second.count));
+        }
+    }
+
+}  // anonymous namespace
+
+int main(int argc, const char** argv) {
+    utils::BackendType backendType = utils::BackendType::Null;
+    const char* tracePath = nullptr;
+    bool originalPacing = false;
+    bool printFrames = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::string("-b") == argv[i] || std::string("--backend") == argv[i]) {
+            i++;
+            if (i < argc && std::string("d3d12") == argv[i]) {
+                backendType = utils::BackendType::D3D12;
+                continue;
+            }
+            if (i < argc && std::string("metal") == argv[i]) {
+                backendType = utils::BackendType::Metal;
+                continue;
+            }
+            if (i < argc && std::string("null") == argv[i]) {
+                backendType = utils::BackendType::Null;
+                continue;
+            }
+            if (i < argc && std::string("opengl") == argv[i]) {
+                backendType = utils::BackendType::OpenGL;
+                continue;
+            }
+            if (i < argc && std::string("vulkan") == argv[i]) {
+                backendType = utils::BackendType::Vulkan;
+                continue;
+            }
+            fprintf(stderr,
+                    "--backend expects a backend name (opengl, metal, d3d12, null, vulkan)\n");
+            return 1;
+        }
+        if (std::string("--original-pacing") == argv[i]) {
+            originalPacing = true;
+            continue;
+        }
+        if (std::string("--print-frames") == argv[i]) {
+            printFrames = true;
+            continue;
+        }
+        if (std::string("-h") == argv[i] || std::string("--help") == argv[i]) {
+            PrintUsage(stdout, argv[0]);
+            return 0;
+        }
+        // Misspelled options would otherwise be taken for the trace path.
+        if (argv[i][0] == '-' || tracePath != nullptr) {
+            fprintf(stderr, "Unexpected argument %s\n", argv[i]);
+            PrintUsage(stderr, argv[0]);
+            return 1;
+        }
+        tracePath = argv[i];
+    }
+
+    if (tracePath == nullptr) {
+        fprintf(stderr, "Expected the path of a trace, see --help\n");
+        return 1;
+    }
+
+    nxt::wire::WireTraceReader reader(tracePath);
+    if (reader.HasError()) {
+        fprintf(stderr, "Failed to open the trace %s\n", tracePath);
+        return 1;
+    }
+
+    utils::BackendBinding* binding = utils::CreateBinding(backendType);
+    if (binding == nullptr) {
+        fprintf(stderr, "Backend isn't available in this build\n");
+        return 1;
+    }
+
+    // Backends other than null need a window for their swapchains, it is never shown.
+    GLFWwindow* window = nullptr;
+    if (backendType != utils::BackendType::Null) {
+        if (!glfwInit()) {
+            fprintf(stderr, "Failed to initialize GLFW\n");
+            return 1;
+        }
+        binding->SetupGLFWWindowHints();
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window = glfwCreateWindow(640, 480, "nxt_replay", nullptr, nullptr);
+        if (window == nullptr) {
+            fprintf(stderr, "Failed to create a window\n");
+            return 1;
+        }
+        binding->SetWindow(window);
+    }
+
+    nxtDevice device;
+    nxtProcTable procs;
+    binding->GetProcAndDevice(&procs, &device);
+
+    DiscardingSerializer returnSerializer;
+    nxt::wire::CommandHandler* server =
+        nxt::wire::NewServerCommandHandler(device, procs, &returnSerializer);
+
+    std::vector<uint64_t> frameTimesNs;
+    std::map<nxt::wire::WireCmd, CommandCost> commandCosts;
+    uint64_t swapChainImplementation = binding->GetSwapChainImplementation();
+    bool valid = true;
+
+    auto replayStart = std::chrono::steady_clock::now();
+    nxt::wire::WireTraceRecord record;
+    while (valid && reader.ReadRecord(&record)) {
+        if (originalPacing) {
+            uint64_t nowNs = NanosecondsSince(replayStart);
+            if (record.timestampNs > nowNs) {
+                utils::USleep(static_cast<unsigned int>((record.timestampNs - nowNs) / 1000));
+            }
+        }
+
+        PatchSwapChainImplementations(record.commands.data(), record.commands.size(),
+                                      swapChainImplementation);
+
+        // Commands are handed to the server one at a time to know the cost of each type, without
+        // the Tick the server does for each call so that the device is ticked once per record.
+        const uint8_t* commands = record.commands.data();
+        size_t size = record.commands.size();
+        uint64_t frameTimeNs = 0;
+        while (size > 0) {
+            size_t cmdSize = nxt::wire::GetWireCmdSize(commands, size);
+            if (cmdSize == 0) {
+                valid = false;
+                break;
+            }
+
+            auto commandStart = std::chrono::steady_clock::now();
+            bool handled =
+                nxt::wire::ServerHandleCommandsWithoutTick(server, commands, cmdSize) != nullptr;
+            uint64_t commandTimeNs = NanosecondsSince(commandStart);
+
+            auto cmdId = *reinterpret_cast<const nxt::wire::WireCmd*>(commands);
+            CommandCost& cost = commandCosts[cmdId];
+            cost.count++;
+            cost.totalNs += commandTimeNs;
+            frameTimeNs += commandTimeNs;
+
+            if (!handled) {
+                valid = false;
+                break;
+            }
+            commands += cmdSize;
+            size -= cmdSize;
+        }
+
+        // Tick like the live servers do so that batched submits are flushed, the backends retire
+        // their work and deferred deletes run. Its cost is part of the frame.
+        if (valid) {
+            auto tickStart = std::chrono::steady_clock::now();
+            procs.deviceTick(device);
+            frameTimeNs += NanosecondsSince(tickStart);
+        }
+
+        if (printFrames) {
+            printf("Frame %zu: %.1f us\n", frameTimesNs.size(), frameTimeNs / 1000.0);
+        }
+        frameTimesNs.push_back(frameTimeNs);
+    }
+
+    if (!valid) {
+        fprintf(stderr, "The trace contains an invalid command in frame %zu\n",
+                frameTimesNs.size());
+    } else if (reader.HasError()) {
+        fprintf(stderr, "The trace is corrupt after frame %zu\n", frameTimesNs.size());
+    }
+
+    PrintFrameReport(frameTimesNs);
+    PrintCommandReport(commandCosts);
+
+    delete server;
+    procs.deviceRelease(device);
+    delete binding;
+    if (window != nullptr) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+
+    return valid && !reader.HasError() ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// nxt_wire_server hosts an NXT backend in its own process and serves wire clients connecting to
+// it over a local Unix-domain socket. Only headless backends are useful here as there is no
+// window to present to.
+
+#include "utils/BackendBinding.h"
+#include "wire/SocketCommandBuffer.h"
+
+#include <nxt/nxt.h>
+
+#include <cstdio>
+#include <string>
+
+namespace {
+
+    void PrintUsage(FILE* file, const char* program) {
+        fprintf(file, "Usage: %s [-b BACKEND] [-s SOCKET_PATH] [--once]\n", program);
+        fprintf(file, "  BACKEND is one of: null\n");
+        fprintf(file, "  --once exits after the first client disconnects\n");
+    }
+
+}  // anonymous namespace
+
+int main(int argc, const char** argv) {
+    utils::BackendType backendType = utils::BackendType::Null;
+    std::string socketPath = "/tmp/nxt_wire_server";
+    bool serveOnce = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::string("-b") == argv[i] || std::string("--backend") == argv[i]) {
+            i++;
+            if (i < argc && std::string("null") == argv[i]) {
+                backendType = utils::BackendType::Null;
+                continue;
+            }
+            fprintf(stderr, "--backend expects a headless backend name (null)\n");
+            return 1;
+        }
+        if (std::string("-s") == argv[i] || std::string("--socket") == argv[i]) {
+            i++;
+            if (i < argc) {
+                socketPath = argv[i];
+                continue;
+            }
+            fprintf(stderr, "--socket expects a path\n");
+            return 1;
+        }
+        if (std::string("--once") == argv[i]) {
+            serveOnce = true;
+            continue;
+        }
+        if (std::string("-h") == argv[i] || std::string("--help") == argv[i]) {
+            PrintUsage(stdout, argv[0]);
+            return 0;
+        }
+        fprintf(stderr, "Unexpected argument %s\n", argv[i]);
+        PrintUsage(stderr, argv[0]);
+        return 1;
+    }
+
+    int listenFd = nxt::wire::ListenOnUnixSocket(socketPath.c_str());
+    if (listenFd < 0) {
+        fprintf(stderr, "Failed to listen on %s\n", socketPath.c_str());
+        return 1;
+    }
+
+    do {
+        int fd = nxt::wire::AcceptOnUnixSocket(listenFd);
+        if (fd < 0) {
+            break;
+        }
+
+        // Each client gets a fresh device so that they can't observe each other's objects.
+        utils::BackendBinding* binding = utils::CreateBinding(backendType);
+        if (binding == nullptr) {
+            fprintf(stderr, "Backend isn't available in this build\n");
+            nxt::wire::CloseSocket(fd);
+            break;
+        }
+
+        nxtDevice device;
+        nxtProcTable procs;
+        binding->GetProcAndDevice(&procs, &device);
+
+        nxt::wire::ServeSocketConnection(fd, device, procs);
+
+        procs.deviceRelease(device);
+        delete binding;
+        nxt::wire::CloseSocket(fd);
+    } while (!serveOnce);
+
+    nxt::wire::CloseSocket(listenFd);
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wire/WireTrace.h"
+
+namespace nxt { namespace wire {
+
+    namespace {
+
+        // Protects the reader from allocating absurd amounts of memory for corrupt traces.
+        constexpr uint64_t kMaxWireTraceRecordSize = 256 << 20;
+
+    }  // anonymous namespace
+
+    // TracingCommandSerializer
+
+    TracingCommandSerializer::TracingCommandSerializer(CommandSerializer* serializer,
+                                                       const char* path)
+        : mSerializer(serializer), mStartTime(std::chrono::steady_clock::now()) {
+        mFile = fopen(path, "wb");
+        if (mFile == nullptr) {
+            mError = true;
+            return;
+        }
+
+        WireTraceHeader header;
+        header.magic = kWireTraceMagic;
+        header.version = kWireTraceVersion;
+        mError = fwrite(&header, sizeof(header), 1, mFile) != 1;
+    }
+
+    TracingCommandSerializer::~TracingCommandSerializer() {
+        if (mFile != nullptr) {
+            fclose(mFile);
+        }
+    }
+
+    void* TracingCommandSerializer::GetCmdSpace(size_t size) {
+        CapturePendingCommand();
+
+        void* result = mSerializer->GetCmdSpace(size);
+        if (result != nullptr) {
+            mPendingCommand = static_cast<const uint8_t*>(result);
+            mPendingSize = size;
+        }
+        return result;
+    }
+
+    void TracingCommandSerializer::Flush() {
+        CapturePendingCommand();
+
+        if (!mRecord.empty() && !mError) {
+            auto elapsed = std::chrono::steady_clock::now() - mStartTime;
+
+            WireTraceRecordHeader header;
+            header.timestampNs = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            header.size = mRecord.size();
+
+            mError = fwrite(&header, sizeof(header), 1, mFile) != 1 ||
+                     fwrite(mRecord.data(), mRecord.size(), 1, mFile) != 1 ||
+                     fflush(mFile) != 0;
+        }
+        mRecord.clear();
+
+        mSerializer->Flush();
+    }
+
+    bool TracingCommandSerializer::HasError() const {
+        return mError;
+    }
+
+    void TracingCommandSerializer::CapturePendingCommand() {
+        if (mPendingCommand == nullptr) {
+            return;
+        }
+
+        mRecord.insert(mRecord.end(), mPendingCommand, mPendingCommand + mPendingSize);
+        mPendingCommand = nullptr;
+        mPendingSize = 0;
+    }
+
+    // WireTraceReader
+
+    WireTraceReader::WireTraceReader(const char* path) {
+        mFile = fopen(path, "rb");
+        if (mFile == nullptr) {
+            mError = true;
+            return;
+        }
+
+        WireTraceHeader header;
+        mError = fread(&header, sizeof(header), 1, mFile) != 1 ||
+                 header.magic != kWireTraceMagic || header.version != kWireTraceVersion;
+    }
+
+    WireTraceReader::~WireTraceReader() {
+        if (mFile != nullptr) {
+            fclose(mFile);
+        }
+    }
+
+    bool WireTraceReader::ReadRecord(WireTraceRecord* record) {
+        if (mError) {
+            return false;
+        }
+
+        WireTraceRecordHeader header;
+        size_t headerSize = fread(&header, 1, sizeof(header), mFile);
+        if (headerSize != sizeof(header)) {
+            // Ending exactly on a record boundary is the normal end of the trace.
+            mError = headerSize != 0 || !feof(mFile);
+            return false;
+        }
+
+        if (header.size > kMaxWireTraceRecordSize) {
+            mError = true;
+            return false;
+        }
+
+        record->timestampNs = header.timestampNs;
+        record->commands.resize(static_cast<size_t>(header.size));
+        if (header.size != 0 &&
+            fread(record->commands.data(), record->commands.size(), 1, mFile) != 1) {
+            mError = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool WireTraceReader::HasError() const {
+        return mError;
+    }
+
+}}  // namespace nxt::wire
@@ -0,0 +1,97 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef WIRE_WIRETRACE_H_
+#define WIRE_WIRETRACE_H_
+
+#include "wire/Wire.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace nxt { namespace wire {
+
+    // A wire trace is the client to server command stream in the native encoding. The file
+    // starts with a WireTraceHeader followed by one record per Flush of the client, each made
+    // of a WireTraceRecordHeader and record.size bytes of commands.
+    //
+    // Data the client put in shared memory isn't part of the stream, so traces should be
+    // captured from clients that don't use shared memory.
+    static constexpr uint32_t kWireTraceMagic = 0x5754584E;  // "NXTW"
+    static constexpr uint32_t kWireTraceVersion = 1;
+
+    struct WireTraceHeader {
+        uint32_t magic;
+        uint32_t version;
+    };
+
+    struct WireTraceRecordHeader {
+        // The time of the Flush, relative to the creation of the serializer.
+        uint64_t timestampNs;
+        uint64_t size;
+    };
+
+    // A decorator in front of a client's serializer that copies the commands to a trace file.
+    // Commands are copied when the next command is requested or on Flush, when the client is
+    // done writing them, and the record is written to the file on Flush.
+    class TracingCommandSerializer : public CommandSerializer {
+      public:
+        TracingCommandSerializer(CommandSerializer* serializer, const char* path);
+        ~TracingCommandSerializer();
+
+        void* GetCmdSpace(size_t size) override;
+        void Flush() override;
+
+        // Set when the trace file couldn't be opened or written to, commands are still
+        // forwarded to the serializer.
+        bool HasError() const;
+
+      private:
+        void CapturePendingCommand();
+
+        CommandSerializer* mSerializer;
+        FILE* mFile = nullptr;
+        bool mError = false;
+        std::chrono::steady_clock::time_point mStartTime;
+
+        const uint8_t* mPendingCommand = nullptr;
+        size_t mPendingSize = 0;
+        std::vector<uint8_t> mRecord;
+    };
+
+    struct WireTraceRecord {
+        uint64_t timestampNs = 0;
+        std::vector<uint8_t> commands;
+    };
+
+    class WireTraceReader {
+      public:
+        WireTraceReader(const char* path);
+        ~WireTraceReader();
+
+        // Reads the next record, returns false at the end of the trace or on errors.
+        bool ReadRecord(WireTraceRecord* record);
+
+        // Set when the file couldn't be opened, isn't a trace or is truncated.
+        bool HasError() const;
+
+      private:
+        FILE* mFile = nullptr;
+        bool mError = false;
+    };
+
+}}  // namespace nxt::wire
+
+#endif  // WIRE_WIRETRACE_H_